@@ -24,12 +24,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
 #include <signal.h>
+#include <sched.h>
+#include <limits.h>
+#include <time.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
 #include <malloc.h>
 
 #include "liblfds710.h"
@@ -38,6 +45,8 @@
 #include "assertions.h"
 #include "intertask_interface.h"
 #include "intertask_interface_dump.h"
+#include "intertask_interface_trace.h"
+#include "intertask_interface_latency.h"
 
 #include "memory_pools.h"
 
@@ -81,6 +90,7 @@ typedef enum task_state_s {
 
 /* This list acts as a FIFO of messages received by tasks (RRC, NAS, ...) */
 typedef struct message_list_s {
+  struct message_list_s                  *next; ///< Next message in the overflow list of the task
   MessageDef                             *msg;  ///< Pointer to the message
 
   message_number_t                        message_number;       ///< Unique message number
@@ -135,6 +145,24 @@ typedef struct thread_desc_s {
    */
   unsigned                                messages_pending;
   //#endif
+
+  /*
+   * Placement of the thread, see itti_set_task_placement ()
+   */
+  bool                                    cpu_set_configured;
+  cpu_set_t                               cpu_set;
+  int                                     numa_node;
+  volatile itti_wait_mode_t               wait_mode;
+  volatile uint32_t                       spin_us;
+
+  /*
+   * Kernel thread id, scheduler counters of the previous itti_print_thread_stats () call
+   */
+  pid_t                                   tid;
+  uint64_t                                previous_cpu_ns;
+  uint64_t                                previous_run_queue_ns;
+  uint64_t                                previous_timeslices;
+  uint64_t                                previous_stats_ns;
 } thread_desc_t;
 
 typedef struct task_desc_s {
@@ -144,8 +172,44 @@ typedef struct task_desc_s {
   struct lfds710_queue_bmm_state         message_queue
           __attribute__ ((aligned (LFDS710_PAL_ATOMIC_ISOLATION_IN_BYTES)));
   struct lfds710_queue_bmm_element      *qbmme;
+
+  /*
+   * Messages that could not be dropped while the queue was full, received after the queue (see itti_queue_msg ())
+   */
+  pthread_mutex_t                         overflow_lock;
+  message_list_t                         *overflow_head;
+  message_list_t                         *overflow_tail;
+  uint32_t                                overflow_count;
+
+  /*
+   * Queue statistics, updated with relaxed atomics by senders and receiver
+   */
+  uint64_t                                enqueued
+          __attribute__ ((aligned (LFDS710_PAL_ATOMIC_ISOLATION_IN_BYTES)));
+  uint64_t                                dequeued;
+  uint64_t                                dropped;
+  uint64_t                                overflowed;
+  uint32_t                                high_watermark;
+  uint32_t                                outstanding;
 } task_desc_t;
 
+/*
+ * Per message id statistics, residence (enqueue to dequeue) and service (dequeue to next receive by the task)
+ * times are only measured on sampled messages.
+ */
+typedef struct message_stats_s {
+  uint64_t                                sent;
+  uint64_t                                residence_samples;
+  uint64_t                                residence_sum_ns;
+  uint64_t                                residence_max_ns;
+  uint64_t                                service_samples;
+  uint64_t                                service_sum_ns;
+  uint64_t                                service_max_ns;
+} message_stats_t;
+
+/* one message out of (ITTI_STATS_SAMPLING_MASK + 1) is timed */
+#define ITTI_STATS_SAMPLING_MASK         0x0F
+
 typedef struct itti_desc_s {
   thread_desc_t                          *threads;
   task_desc_t                            *tasks;
@@ -164,6 +228,20 @@ typedef struct itti_desc_s {
 
   const task_info_t                      *tasks_info;
   const message_info_t                   *messages_info;
+  message_stats_t                        *messages_stats;
+
+  /*
+   * Message ids that can be dropped on a full queue, and how their content is freed then
+   */
+  bool                                   *messages_sheddable;
+  void                                  (*free_msg_content) (MessageDef * const message_p);
+
+  /*
+   * Snapshots of the previous itti_print_stats() call, only accessed by the caller
+   */
+  task_desc_t                            *tasks_previous_stats;
+  message_stats_t                        *messages_previous_stats;
+  uint64_t                                previous_stats_ns;
 
   itti_lte_time_t                         lte_time;
 
@@ -182,6 +260,83 @@ typedef struct itti_desc_s {
 
 static itti_desc_t                      itti_desc;
 
+/* Nodes addressable by itti_set_task_placement () */
+#define ITTI_NUMA_NODEMASK_LONGS         4
+
+#if defined(__x86_64__) || defined(__i386__)
+#  define ITTI_CPU_RELAX()               __builtin_ia32_pause ()
+#else
+#  define ITTI_CPU_RELAX()               __asm__ __volatile__ ("" ::: "memory")
+#endif
+
+static const char * const               itti_wait_mode_names[] = {"block", "adaptive spin", "busy poll"};
+
+//------------------------------------------------------------------------------
+// Size of the queue elements of a task, rounded up to whole pages.
+static inline size_t itti_queue_elements_size (const task_id_t task_id)
+{
+  const size_t                            page_size = sysconf (_SC_PAGESIZE);
+  const size_t                            size = itti_desc.tasks_info[task_id].queue_size * sizeof (struct lfds710_queue_bmm_element);
+
+  return ((size + page_size - 1) / page_size) * page_size;
+}
+
+static __thread MessagesIds             itti_service_message_id = 0;
+static __thread uint64_t                itti_service_start_ns = 0;
+
+//------------------------------------------------------------------------------
+static inline void itti_stats_update_max (uint64_t * const max_p, const uint64_t value)
+{
+  uint64_t                                max = __atomic_load_n (max_p, __ATOMIC_RELAXED);
+
+  while ((value > max) && (!__atomic_compare_exchange_n (max_p, &max, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)));
+}
+
+//------------------------------------------------------------------------------
+static inline void itti_stats_enqueued (const task_id_t task_id)
+{
+  task_desc_t * const                     task = &itti_desc.tasks[task_id];
+  const uint64_t                          enqueued = __atomic_add_fetch (&task->enqueued, 1, __ATOMIC_RELAXED);
+  const uint64_t                          dequeued = __atomic_load_n (&task->dequeued, __ATOMIC_RELAXED);
+  const uint32_t                          depth = (enqueued > dequeued) ? (uint32_t)(enqueued - dequeued):0;
+  uint32_t                                high_watermark = __atomic_load_n (&task->high_watermark, __ATOMIC_RELAXED);
+
+  while ((depth > high_watermark) &&
+      (!__atomic_compare_exchange_n (&task->high_watermark, &high_watermark, depth, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)));
+}
+
+//------------------------------------------------------------------------------
+static inline void itti_stats_service_end (void)
+{
+  if (itti_service_start_ns) {
+    message_stats_t * const               stats = &itti_desc.messages_stats[itti_service_message_id];
+    const uint64_t                        service_ns = itti_latency_now_ns () - itti_service_start_ns;
+
+    __atomic_add_fetch (&stats->service_samples, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch (&stats->service_sum_ns, service_ns, __ATOMIC_RELAXED);
+    itti_stats_update_max (&stats->service_max_ns, service_ns);
+    itti_service_start_ns = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+static inline void itti_stats_dequeued (const task_id_t task_id, const MessageDef * const message_p)
+{
+  __atomic_add_fetch (&itti_desc.tasks[task_id].dequeued, 1, __ATOMIC_RELAXED);
+  if (message_p->ittiMsgHeader.enqueue_ns) {
+    const MessagesIds                     message_id = message_p->ittiMsgHeader.messageId;
+    message_stats_t * const               stats = &itti_desc.messages_stats[message_id];
+    const uint64_t                        now_ns = itti_latency_now_ns ();
+    const uint64_t                        residence_ns = (now_ns > message_p->ittiMsgHeader.enqueue_ns) ? now_ns - message_p->ittiMsgHeader.enqueue_ns:0;
+
+    __atomic_add_fetch (&stats->residence_samples, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch (&stats->residence_sum_ns, residence_ns, __ATOMIC_RELAXED);
+    itti_stats_update_max (&stats->residence_max_ns, residence_ns);
+    itti_service_message_id = message_id;
+    itti_service_start_ns   = now_ns;
+  }
+}
+
 void                                   *
 itti_malloc (
   task_id_t origin_task_id,
@@ -284,6 +439,21 @@ itti_get_message_name (
   return (itti_desc.messages_info[message_id].name);
 }
 
+void
+itti_set_message_sheddable (
+  MessagesIds message_id)
+{
+  AssertFatal (message_id < itti_desc.messages_id_max, "Message id (%d) is out of range (%d)!\n", message_id, itti_desc.messages_id_max);
+  itti_desc.messages_sheddable[message_id] = true;
+}
+
+void
+itti_set_free_msg_content (
+  void (*free_msg_content) (MessageDef * const message_p))
+{
+  itti_desc.free_msg_content = free_msg_content;
+}
+
 const char                             *
 itti_get_task_name (
   task_id_t task_id)
@@ -363,7 +533,10 @@ itti_send_broadcast_message (
         AssertFatal (new_message_p != NULL, "New message allocation failed!\n");
         memcpy (new_message_p, message_p, size);
         result = itti_send_msg_to_task (destination_task_id, INSTANCE_DEFAULT, new_message_p);
-        AssertFatal (result >= 0, "Failed to send message %d to thread %d (task %d)!\n", message_p->ittiMsgHeader.messageId, thread_id, destination_task_id);
+        if (result < 0) {
+          // destination queue full, already logged
+          ret = -1;
+        }
       }
     }
   }
@@ -399,6 +572,7 @@ itti_alloc_new_message_sized (
   temp->ittiMsgHeader.messageId = message_id;
   temp->ittiMsgHeader.originTaskId = origin_task_id;
   temp->ittiMsgHeader.ittiMsgSize = size;
+  itti_latency_stamp_message (temp);
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_ALLOC_MSG, 0);
   return temp;
 }
@@ -411,11 +585,84 @@ itti_alloc_new_message (
   return itti_alloc_new_message_sized (origin_task_id, message_id, itti_desc.messages_info[message_id].size);
 }
 
-int
-itti_send_msg_to_task (
+/*
+ * Queue a message in the queue of a task. When the queue is full, the messages that are not sheddable are appended
+ * to the overflow list of the task, received once the queue is empty; the following messages go there too until the
+ * list is drained, so that the messages of a sender stay in order. Returns false if a sheddable message was not queued.
+ */
+static bool
+itti_queue_msg (
+  task_id_t task_id,
+  message_list_t * new,
+  const bool sheddable)
+{
+  task_desc_t * const                     task = &itti_desc.tasks[task_id];
+  uint64_t                                overflowed = 0;
+
+  if ((!__atomic_load_n (&task->overflow_count, __ATOMIC_ACQUIRE)) && (lfds710_queue_bmm_enqueue (&task->message_queue, NULL, new))) {
+    return true;
+  }
+  if (sheddable) {
+    return false;
+  }
+  new->next = NULL;
+  pthread_mutex_lock (&task->overflow_lock);
+  if (task->overflow_tail) {
+    task->overflow_tail->next = new;
+  } else {
+    task->overflow_head = new;
+  }
+  task->overflow_tail = new;
+  __atomic_add_fetch (&task->overflow_count, 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock (&task->overflow_lock);
+  overflowed = __atomic_add_fetch (&task->overflowed, 1, __ATOMIC_RELAXED);
+  if (!((overflowed - 1) & 0x3FF)) {
+    OAILOG_WARNING (LOG_ITTI, "Queue of task %s full (%u messages), message %s kept in overflow list (%"PRIu64" so far)\n",
+        itti_get_task_name (task_id), itti_desc.tasks_info[task_id].queue_size,
+        itti_desc.messages_info[new->msg->ittiMsgHeader.messageId].name, overflowed);
+  }
+  return true;
+}
+
+/*
+ * Take the next message of a task, from its queue then from its overflow list.
+ */
+static bool
+itti_dequeue_msg (
+  task_id_t task_id,
+  message_list_t ** message)
+{
+  task_desc_t * const                     task = &itti_desc.tasks[task_id];
+
+  if (lfds710_queue_bmm_dequeue (&task->message_queue, NULL, (void **)message)) {
+    return true;
+  }
+  if (!__atomic_load_n (&task->overflow_count, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+  pthread_mutex_lock (&task->overflow_lock);
+  *message = task->overflow_head;
+  if (*message) {
+    task->overflow_head = (*message)->next;
+    if (!task->overflow_head) {
+      task->overflow_tail = NULL;
+    }
+    __atomic_sub_fetch (&task->overflow_count, 1, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock (&task->overflow_lock);
+  return (*message != NULL);
+}
+
+/*
+ * Enqueue a message, the destination thread is woken up only if wakeup is set.
+ * Returns -1 if the message was dropped, 0 if it was not queued (freed), 1 if it was queued.
+ */
+static int
+itti_enqueue_msg (
   task_id_t destination_task_id,
   instance_t instance,
-  MessageDef * message)
+  MessageDef * message,
+  const bool wakeup)
 {
   thread_id_t                             destination_thread_id;
   task_id_t                               origin_task_id;
@@ -440,6 +687,10 @@ itti_send_msg_to_task (
    * Increment the global message number
    */
   message_number = itti_increment_message_number ();
+  itti_trace_message (message_number, message);
+  message->ittiMsgHeader.enqueue_ns = (message_number & ITTI_STATS_SAMPLING_MASK) ? 0:itti_latency_now_ns ();
+  itti_latency_on_send (message);
+  __atomic_add_fetch (&itti_desc.messages_stats[message_id].sent, 1, __ATOMIC_RELAXED);
 
   if (destination_task_id != TASK_UNKNOWN) {
     VCD_SIGNAL_DUMPER_DUMP_FUNCTION_BY_NAME (VCD_SIGNAL_DUMPER_FUNCTIONS_ITTI_ENQUEUE_MESSAGE, VCD_FUNCTION_IN);
@@ -469,13 +720,33 @@ itti_send_msg_to_task (
       /*
        * Enqueue message in destination task queue
        */
-      lfds710_queue_bmm_enqueue (&itti_desc.tasks[destination_task_id].message_queue, NULL, new);
+      if (!itti_queue_msg (destination_task_id, new, itti_desc.messages_sheddable[message_id])) {
+        /*
+         * Queue full and sheddable message: it is dropped with its content, the sender is told so.
+         */
+        const uint64_t                        dropped = __atomic_add_fetch (&itti_desc.tasks[destination_task_id].dropped, 1, __ATOMIC_RELAXED);
+
+        VCD_SIGNAL_DUMPER_DUMP_FUNCTION_BY_NAME (VCD_SIGNAL_DUMPER_FUNCTIONS_ITTI_ENQUEUE_MESSAGE, VCD_FUNCTION_OUT);
+        if (!((dropped - 1) & 0x3FF)) {
+          OAILOG_ERROR (LOG_ITTI, "Queue of task %s full (%u messages), dropped message %s from %s (%"PRIu64" dropped)\n",
+              itti_get_task_name (destination_task_id), itti_desc.tasks_info[destination_task_id].queue_size,
+              itti_desc.messages_info[message_id].name, itti_get_task_name (origin_task_id), dropped);
+        }
+        itti_free (origin_task_id, new);
+        if (itti_desc.free_msg_content) {
+          itti_desc.free_msg_content (message);
+        }
+        itti_free (origin_task_id, message);
+        VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_SEND_MSG, __sync_and_and_fetch (&itti_desc.vcd_send_msg, ~(1L << destination_task_id)));
+        return -1;
+      }
+      itti_stats_enqueued (destination_task_id);
       VCD_SIGNAL_DUMPER_DUMP_FUNCTION_BY_NAME (VCD_SIGNAL_DUMPER_FUNCTIONS_ITTI_ENQUEUE_MESSAGE, VCD_FUNCTION_OUT);
       {
         /*
          * Only use event fd for tasks, subtasks will pool the queue
          */
-        if (TASK_GET_PARENT_TASK_ID (destination_task_id) == TASK_UNKNOWN) {
+        if ((wakeup) && (TASK_GET_PARENT_TASK_ID (destination_task_id) == TASK_UNKNOWN)) {
           ssize_t                                 write_ret;
           eventfd_t                               sem_counter = 1;
 
@@ -489,6 +760,8 @@ itti_send_msg_to_task (
 
       ITTI_DEBUG (ITTI_DEBUG_SEND, " Message %s, number %lu with priority %d successfully sent from %s to queue (%u:%s)\n",
                   itti_desc.messages_info[message_id].name, message_number, priority, itti_get_task_name (origin_task_id), destination_task_id, itti_get_task_name (destination_task_id));
+      VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_SEND_MSG, __sync_and_and_fetch (&itti_desc.vcd_send_msg, ~(1L << destination_task_id)));
+      return 1;
     }
   } else {
     /*
@@ -503,6 +776,160 @@ itti_send_msg_to_task (
   return 0;
 }
 
+int
+itti_send_msg_to_task (
+  task_id_t destination_task_id,
+  instance_t instance,
+  MessageDef * message)
+{
+  return (itti_enqueue_msg (destination_task_id, instance, message, true) < 0) ? -1:0;
+}
+
+int
+itti_send_msg_to_task_batch (
+  task_id_t destination_task_id,
+  instance_t instance,
+  MessageDef ** messages,
+  const int nb_messages)
+{
+  eventfd_t                               sem_counter = 0;
+  int                                     nb_dropped = 0;
+
+  for (int i = 0; i < nb_messages; i++) {
+    const int                             rc = itti_enqueue_msg (destination_task_id, instance, messages[i], false);
+
+    if (rc > 0) {
+      sem_counter++;
+    } else if (rc < 0) {
+      nb_dropped++;
+    }
+  }
+  /*
+   * A single write wakes the destination thread for all the messages (the event fd is a semaphore)
+   */
+  if ((sem_counter) && (TASK_GET_PARENT_TASK_ID (destination_task_id) == TASK_UNKNOWN)) {
+    const thread_id_t                     destination_thread_id = TASK_GET_THREAD_ID (destination_task_id);
+    ssize_t                               write_ret = write (itti_desc.threads[destination_thread_id].task_event_fd, &sem_counter, sizeof (sem_counter));
+
+    AssertFatal (write_ret == sizeof (sem_counter), "Write to task message FD (%d) failed (%d/%d)\n", destination_thread_id, (int)write_ret, (int)sizeof (sem_counter));
+  }
+  return nb_dropped;
+}
+
+uint32_t
+itti_get_queue_depth (
+  task_id_t task_id)
+{
+  uint64_t                                dequeued = 0;
+  uint64_t                                enqueued = 0;
+
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  dequeued = __atomic_load_n (&itti_desc.tasks[task_id].dequeued, __ATOMIC_RELAXED);
+  enqueued = __atomic_load_n (&itti_desc.tasks[task_id].enqueued, __ATOMIC_RELAXED);
+  return (enqueued > dequeued) ? (uint32_t)(enqueued - dequeued):0;
+}
+
+void
+itti_get_task_stats (
+  task_id_t task_id,
+  itti_task_stats_t * const stats)
+{
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  stats->dequeued       = __atomic_load_n (&itti_desc.tasks[task_id].dequeued, __ATOMIC_RELAXED);
+  stats->enqueued       = __atomic_load_n (&itti_desc.tasks[task_id].enqueued, __ATOMIC_RELAXED);
+  stats->dropped        = __atomic_load_n (&itti_desc.tasks[task_id].dropped, __ATOMIC_RELAXED);
+  stats->overflowed     = __atomic_load_n (&itti_desc.tasks[task_id].overflowed, __ATOMIC_RELAXED);
+  stats->high_watermark = __atomic_load_n (&itti_desc.tasks[task_id].high_watermark, __ATOMIC_RELAXED);
+  stats->depth          = (stats->enqueued > stats->dequeued) ? (uint32_t)(stats->enqueued - stats->dequeued):0;
+  stats->queue_size     = itti_desc.tasks_info[task_id].queue_size;
+  stats->outstanding    = __atomic_load_n (&itti_desc.tasks[task_id].outstanding, __ATOMIC_RELAXED);
+}
+
+void
+itti_transaction_start (
+  task_id_t task_id)
+{
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  __atomic_add_fetch (&itti_desc.tasks[task_id].outstanding, 1, __ATOMIC_RELAXED);
+}
+
+void
+itti_transaction_end (
+  task_id_t task_id)
+{
+  uint32_t                                outstanding = 0;
+
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  outstanding = __atomic_load_n (&itti_desc.tasks[task_id].outstanding, __ATOMIC_RELAXED);
+  // do not wrap on an unexpected answer
+  while ((outstanding) &&
+      (!__atomic_compare_exchange_n (&itti_desc.tasks[task_id].outstanding, &outstanding, outstanding - 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)));
+}
+
+void
+itti_transaction_set (
+  task_id_t task_id,
+  const uint32_t outstanding)
+{
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  __atomic_store_n (&itti_desc.tasks[task_id].outstanding, outstanding, __ATOMIC_RELAXED);
+}
+
+void
+itti_print_stats (
+  void)
+{
+  const uint64_t                          now_ns = itti_latency_now_ns ();
+  const double                            period_s = (now_ns > itti_desc.previous_stats_ns) ? (now_ns - itti_desc.previous_stats_ns) / 1000000000.0:1.0;
+  task_id_t                               task_id;
+  MessagesIds                             message_id;
+
+  OAILOG_INFO (LOG_ITTI, "ITTI queues over the last %.1f s:\n", period_s);
+  for (task_id = TASK_FIRST; task_id < itti_desc.task_max; task_id++) {
+    itti_task_stats_t                     stats = {0};
+    task_desc_t * const                   previous = &itti_desc.tasks_previous_stats[task_id];
+
+    itti_get_task_stats (task_id, &stats);
+    if ((stats.enqueued == previous->enqueued) && (stats.dequeued == previous->dequeued) && (!stats.depth) && (!stats.outstanding)) {
+      continue;
+    }
+    OAILOG_INFO (LOG_ITTI, "  %-24s enqueue %9.1f/s dequeue %9.1f/s depth %6u high watermark %6u/%u dropped %"PRIu64" overflowed %"PRIu64" outstanding %u\n",
+        itti_get_task_name (task_id), (stats.enqueued - previous->enqueued) / period_s, (stats.dequeued - previous->dequeued) / period_s,
+        stats.depth, stats.high_watermark, stats.queue_size, stats.dropped - previous->dropped, stats.overflowed - previous->overflowed, stats.outstanding);
+    previous->enqueued   = stats.enqueued;
+    previous->dequeued   = stats.dequeued;
+    previous->dropped    = stats.dropped;
+    previous->overflowed = stats.overflowed;
+  }
+  for (message_id = 0; message_id < itti_desc.messages_id_max; message_id++) {
+    message_stats_t * const               stats = &itti_desc.messages_stats[message_id];
+    message_stats_t * const               previous = &itti_desc.messages_previous_stats[message_id];
+    const uint64_t                        sent = __atomic_load_n (&stats->sent, __ATOMIC_RELAXED);
+    const uint64_t                        residence_samples = __atomic_load_n (&stats->residence_samples, __ATOMIC_RELAXED) - previous->residence_samples;
+    const uint64_t                        residence_sum_ns = __atomic_load_n (&stats->residence_sum_ns, __ATOMIC_RELAXED) - previous->residence_sum_ns;
+    const uint64_t                        service_samples = __atomic_load_n (&stats->service_samples, __ATOMIC_RELAXED) - previous->service_samples;
+    const uint64_t                        service_sum_ns = __atomic_load_n (&stats->service_sum_ns, __ATOMIC_RELAXED) - previous->service_sum_ns;
+    // max are reset at each period
+    const uint64_t                        residence_max_ns = __atomic_exchange_n (&stats->residence_max_ns, 0, __ATOMIC_RELAXED);
+    const uint64_t                        service_max_ns = __atomic_exchange_n (&stats->service_max_ns, 0, __ATOMIC_RELAXED);
+
+    if (sent == previous->sent) {
+      continue;
+    }
+    OAILOG_INFO (LOG_ITTI, "  %-48s %9.1f/s residence mean %9.1f max %9.1f us, service mean %9.1f max %9.1f us\n",
+        itti_desc.messages_info[message_id].name, (sent - previous->sent) / period_s,
+        residence_samples ? residence_sum_ns / (1000.0 * residence_samples):0.0, residence_max_ns / 1000.0,
+        service_samples ? service_sum_ns / (1000.0 * service_samples):0.0, service_max_ns / 1000.0);
+    previous->sent              = sent;
+    previous->residence_samples += residence_samples;
+    previous->residence_sum_ns  += residence_sum_ns;
+    previous->service_samples   += service_samples;
+    previous->service_sum_ns    += service_sum_ns;
+  }
+  itti_desc.previous_stats_ns = now_ns;
+  itti_print_thread_stats ();
+}
+
 void
 itti_subscribe_event_fd (
   task_id_t task_id,
@@ -573,6 +1000,28 @@ itti_get_events (
   return itti_desc.threads[thread_id].epoll_nb_events;
 }
 
+//------------------------------------------------------------------------------
+// Poll the fds of the thread without sleeping, for spin_us in adaptive spin mode, until an event in busy poll mode.
+// Returns the number of events, 0 if the caller has to block.
+static int
+itti_spin_wait (
+  const thread_id_t thread_id)
+{
+  thread_desc_t * const                   thread = &itti_desc.threads[thread_id];
+  const uint64_t                          deadline_ns = itti_latency_now_ns () + 1000 * (uint64_t)thread->spin_us;
+  int                                     epoll_ret = 0;
+
+  do {
+    epoll_ret = epoll_wait (thread->epoll_fd, thread->events, thread->nb_events, 0);
+    if (epoll_ret) {
+      break;
+    }
+    ITTI_CPU_RELAX ();
+  } while ((ITTI_WAIT_MODE_BUSY_POLL == thread->wait_mode) || (itti_latency_now_ns () < deadline_ns));
+  // on error (EINTR) fall back to the blocking wait
+  return (epoll_ret > 0) ? epoll_ret:0;
+}
+
 static inline void
 itti_receive_msg_internal_event_fd (
   task_id_t task_id,
@@ -602,9 +1051,15 @@ itti_receive_msg_internal_event_fd (
     epoll_timeout = -1;
   }
 
-  do {
-    epoll_ret = epoll_wait (itti_desc.threads[thread_id].epoll_fd, itti_desc.threads[thread_id].events, itti_desc.threads[thread_id].nb_events, epoll_timeout);
-  } while (epoll_ret < 0 && errno == EINTR);
+  if ((!polling) && (ITTI_WAIT_MODE_BLOCK != itti_desc.threads[thread_id].wait_mode)) {
+    epoll_ret = itti_spin_wait (thread_id);
+  }
+
+  if (0 == epoll_ret) {
+    do {
+      epoll_ret = epoll_wait (itti_desc.threads[thread_id].epoll_fd, itti_desc.threads[thread_id].events, itti_desc.threads[thread_id].nb_events, epoll_timeout);
+    } while (epoll_ret < 0 && errno == EINTR);
+  }
 
   if (epoll_ret < 0) {
     AssertFatal (0, "epoll_wait failed for task %s: %s!\n", itti_get_task_name (task_id), strerror (errno));
@@ -635,7 +1090,7 @@ itti_receive_msg_internal_event_fd (
       read_ret = read (itti_desc.threads[thread_id].task_event_fd, &sem_counter, sizeof (sem_counter));
       AssertFatal (read_ret == sizeof (sem_counter), "Read from task message FD (%d) failed (%d/%d)!\n", thread_id, (int)read_ret, (int)sizeof (sem_counter));
 
-      if (lfds710_queue_bmm_dequeue (&itti_desc.tasks[task_id].message_queue, NULL, (void **)&message) == 0) {
+      if (!itti_dequeue_msg (task_id, &message)) {
         /*
          * No element in list -> this should not happen
          */
@@ -644,6 +1099,8 @@ itti_receive_msg_internal_event_fd (
 
       AssertFatal (message != NULL, "Message from message queue is NULL!\n");
       *received_msg = message->msg;
+      itti_stats_dequeued (task_id, message->msg);
+      itti_latency_on_receive (task_id, message->msg);
       result = itti_free (ITTI_MSG_ORIGIN_ID (message->msg), message);
       AssertFatal (result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
       /*
@@ -661,6 +1118,8 @@ itti_receive_msg (
   MessageDef ** received_msg)
 {
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_and_and_fetch (&itti_desc.vcd_receive_msg, ~(1L << task_id)));
+  itti_stats_service_end ();
+  itti_latency_on_receive_entry ();
   itti_receive_msg_internal_event_fd (task_id, 0, received_msg);
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_or_and_fetch (&itti_desc.vcd_receive_msg, 1L << task_id));
 }
@@ -673,13 +1132,17 @@ itti_poll_msg (
   AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
   *received_msg = NULL;
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_POLL_MSG, __sync_or_and_fetch (&itti_desc.vcd_poll_msg, 1L << task_id));
+  itti_stats_service_end ();
+  itti_latency_on_receive_entry ();
   {
     struct message_list_s                  *message;
 
-    if (lfds710_queue_bmm_dequeue (&itti_desc.tasks[task_id].message_queue, NULL, (void **)&message) == 1) {
+    if (itti_dequeue_msg (task_id, &message)) {
       int                                     result;
 
       *received_msg = message->msg;
+      itti_stats_dequeued (task_id, message->msg);
+      itti_latency_on_receive (task_id, message->msg);
       result = itti_free (ITTI_MSG_ORIGIN_ID (*received_msg), message);
       AssertFatal (result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
     }
@@ -705,19 +1168,32 @@ itti_create_task (
   AssertFatal (itti_desc.threads[thread_id].task_state == TASK_STATE_NOT_CONFIGURED, "Task %d, thread %d state is not correct (%d)!\n", task_id, thread_id, itti_desc.threads[thread_id].task_state);
   itti_desc.threads[thread_id].task_state = TASK_STATE_STARTING;
   ITTI_DEBUG (ITTI_DEBUG_INIT, " Creating thread for task %s ...\n", itti_get_task_name (task_id));
+  pthread_attr_t                          attr;
+  pthread_attr_t                         *attr_p = NULL;
+
 #if ITTI_TASK_STACK_SIZE
-  pthread_attr_t                          attr = {.__align = 0};
-  result = pthread_attr_init(&attr);
+  result = pthread_attr_init (&attr);
   AssertFatal (result == 0, "Thread attributes for task %d, thread %d init failed (%d)!\n", task_id, thread_id, result);
-  result = pthread_attr_setstacksize(&attr, ITTI_TASK_STACK_SIZE);
-  result = pthread_create (&itti_desc.threads[thread_id].task_thread, NULL, start_routine, args_p);
-  AssertFatal (result >= 0, "Thread creation for task %d, thread %d failed (%d)!\n", task_id, thread_id, result);
-  result = pthread_attr_destroy(&attr);
-  AssertFatal (result == 0, "Thread attributes for task %d, thread %d destroy failed (%d)!\n", task_id, thread_id, result);
-#else
-  result = pthread_create (&itti_desc.threads[thread_id].task_thread, NULL, start_routine, args_p);
-  AssertFatal (result >= 0, "Thread creation for task %d, thread %d failed (%d)!\n", task_id, thread_id, result);
+  result = pthread_attr_setstacksize (&attr, ITTI_TASK_STACK_SIZE);
+  AssertFatal (result == 0, "Thread stack size for task %d, thread %d failed (%d)!\n", task_id, thread_id, result);
+  attr_p = &attr;
 #endif
+  if (itti_desc.threads[thread_id].cpu_set_configured) {
+    // start the thread on its CPUs so that the memory it touches first is local to them
+    if (!attr_p) {
+      result = pthread_attr_init (&attr);
+      AssertFatal (result == 0, "Thread attributes for task %d, thread %d init failed (%d)!\n", task_id, thread_id, result);
+      attr_p = &attr;
+    }
+    result = pthread_attr_setaffinity_np (attr_p, sizeof (cpu_set_t), &itti_desc.threads[thread_id].cpu_set);
+    AssertFatal (result == 0, "Thread affinity for task %d, thread %d failed (%d)!\n", task_id, thread_id, result);
+  }
+  result = pthread_create (&itti_desc.threads[thread_id].task_thread, attr_p, start_routine, args_p);
+  AssertFatal (result >= 0, "Thread creation for task %d, thread %d failed (%d)!\n", task_id, thread_id, result);
+  if (attr_p) {
+    result = pthread_attr_destroy (attr_p);
+    AssertFatal (result == 0, "Thread attributes for task %d, thread %d destroy failed (%d)!\n", task_id, thread_id, result);
+  }
   char                                    name[16];
 
   snprintf (name, sizeof (name), "ITTI %d", thread_id);
@@ -753,6 +1229,156 @@ itti_wait_ready (
   AssertFatal (itti_desc.created_tasks == itti_desc.ready_tasks, "Number of created tasks (%d) does not match ready tasks (%d), wait task %d!\n", itti_desc.created_tasks, itti_desc.ready_tasks, itti_desc.wait_tasks);
 }
 
+//------------------------------------------------------------------------------
+// Parse a CPU list in the taskset format, ex: "2-3,8".
+static int
+itti_parse_cpu_list (
+  const char * const cpu_list,
+  cpu_set_t * const cpu_set)
+{
+  const char                             *p = cpu_list;
+
+  CPU_ZERO (cpu_set);
+  while (*p) {
+    char                                   *end = NULL;
+    long                                    first = strtol (p, &end, 10);
+    long                                    last = first;
+
+    if ((end == p) || (0 > first)) {
+      return -1;
+    }
+    p = end;
+    if ('-' == *p) {
+      p++;
+      last = strtol (p, &end, 10);
+      if ((end == p) || (last < first)) {
+        return -1;
+      }
+      p = end;
+    }
+    if (CPU_SETSIZE <= last) {
+      return -1;
+    }
+    for (long cpu = first; cpu <= last; cpu++) {
+      CPU_SET (cpu, cpu_set);
+    }
+    if (',' == *p) {
+      p++;
+    } else if (*p) {
+      return -1;
+    }
+  }
+  return (CPU_COUNT (cpu_set)) ? 0:-1;
+}
+
+//------------------------------------------------------------------------------
+// Move the queue elements of a task to a NUMA node, they are page aligned and padded (see itti_init ()).
+static void
+itti_place_task_queue (
+  const task_id_t task_id,
+  const int numa_node)
+{
+  unsigned long                           nodemask[ITTI_NUMA_NODEMASK_LONGS] = {0};
+
+  nodemask[numa_node / (sizeof (unsigned long) * CHAR_BIT)] |= 1UL << (numa_node % (sizeof (unsigned long) * CHAR_BIT));
+  if (syscall (SYS_mbind, itti_desc.tasks[task_id].qbmme, itti_queue_elements_size (task_id), MPOL_PREFERRED,
+        nodemask, sizeof (nodemask) * CHAR_BIT, MPOL_MF_MOVE)) {
+    OAILOG_WARNING (LOG_ITTI, "Could not move the queue of task %s to NUMA node %d: %s\n", itti_get_task_name (task_id), numa_node, strerror (errno));
+  }
+}
+
+int
+itti_set_task_placement (
+  const char * const task_name,
+  const char * const cpu_list,
+  const int numa_node,
+  const itti_wait_mode_t wait_mode,
+  const uint32_t spin_us)
+{
+  task_id_t                               task_id;
+  thread_desc_t                          *thread = NULL;
+  cpu_set_t                               cpu_set;
+  const bool                              pin = (cpu_list) && (cpu_list[0]);
+
+  for (task_id = TASK_FIRST; task_id < itti_desc.task_max; task_id++) {
+    if (!strcmp (task_name, itti_desc.tasks_info[task_id].name)) {
+      break;
+    }
+  }
+  if ((task_id >= itti_desc.task_max) || (numa_node >= (int)(ITTI_NUMA_NODEMASK_LONGS * sizeof (unsigned long) * CHAR_BIT)) ||
+      (wait_mode > ITTI_WAIT_MODE_BUSY_POLL) || ((pin) && (itti_parse_cpu_list (cpu_list, &cpu_set)))) {
+    return -1;
+  }
+  thread = &itti_desc.threads[TASK_GET_THREAD_ID (task_id)];
+  if (pin) {
+    thread->cpu_set = cpu_set;
+    thread->cpu_set_configured = true;
+    // threads already running are moved now, the others are started on their CPUs
+    if (TASK_STATE_NOT_CONFIGURED != thread->task_state) {
+      int                                     result = pthread_setaffinity_np (thread->task_thread, sizeof (cpu_set_t), &thread->cpu_set);
+
+      if (result) {
+        OAILOG_WARNING (LOG_ITTI, "Could not pin task %s on CPUs %s: %s\n", task_name, cpu_list, strerror (result));
+      }
+    }
+  }
+  thread->numa_node = numa_node;
+  if (0 <= numa_node) {
+    itti_place_task_queue (task_id, numa_node);
+  }
+  thread->spin_us   = spin_us;
+  thread->wait_mode = wait_mode;
+  OAILOG_INFO (LOG_ITTI, "Task %s placement: CPUs %s, NUMA node %d, wait mode %s (spin %u us)\n",
+      task_name, (pin) ? cpu_list:"any", numa_node, itti_wait_mode_names[wait_mode], spin_us);
+  return 0;
+}
+
+void
+itti_print_thread_stats (
+  void)
+{
+  const uint64_t                          now_ns = itti_latency_now_ns ();
+  task_id_t                               task_id;
+
+  OAILOG_INFO (LOG_ITTI, "ITTI threads:\n");
+  for (task_id = TASK_FIRST; task_id < itti_desc.task_max; task_id++) {
+    thread_desc_t * const                 thread = &itti_desc.threads[TASK_GET_THREAD_ID (task_id)];
+    char                                  path[64];
+    FILE                                 *fp = NULL;
+    uint64_t                              cpu_ns = 0;
+    uint64_t                              run_queue_ns = 0;
+    uint64_t                              timeslices = 0;
+    int                                   fields = 0;
+
+    if ((TASK_UNKNOWN != itti_desc.tasks_info[task_id].parent_task) || (!thread->tid)) {
+      continue;
+    }
+    // time on CPU, time waiting on a run queue, number of time slices
+    snprintf (path, sizeof (path), "/proc/self/task/%d/schedstat", (int)thread->tid);
+    if (!(fp = fopen (path, "r"))) {
+      continue;
+    }
+    fields = fscanf (fp, "%"SCNu64" %"SCNu64" %"SCNu64, &cpu_ns, &run_queue_ns, &timeslices);
+    fclose (fp);
+    if (3 != fields) {
+      continue;
+    }
+
+    const double                          period_ns = (now_ns > thread->previous_stats_ns) ? (double)(now_ns - thread->previous_stats_ns):1.0;
+    const uint64_t                        slices = timeslices - thread->previous_timeslices;
+    const uint64_t                        run_queue_delta_ns = run_queue_ns - thread->previous_run_queue_ns;
+
+    OAILOG_INFO (LOG_ITTI, "  %-24s tid %6d cpu %5.1f%% run queue delay %9.1f us/s %7.1f us/slice, %s, %s\n",
+        itti_get_task_name (task_id), (int)thread->tid, (100.0 * (cpu_ns - thread->previous_cpu_ns)) / period_ns,
+        (1000000.0 * run_queue_delta_ns) / period_ns, (slices) ? run_queue_delta_ns / (1000.0 * slices):0.0,
+        (thread->cpu_set_configured) ? "pinned":"not pinned", itti_wait_mode_names[thread->wait_mode]);
+    thread->previous_cpu_ns       = cpu_ns;
+    thread->previous_run_queue_ns = run_queue_ns;
+    thread->previous_timeslices   = timeslices;
+    thread->previous_stats_ns     = now_ns;
+  }
+}
+
 void
 itti_mark_task_ready (
   task_id_t task_id)
@@ -765,6 +1391,8 @@ itti_mark_task_ready (
    * Mark the thread as using LFDS queue
    */
   LFDS710_MISC_MAKE_VALID_ON_CURRENT_LOGICAL_CORE_INITS_COMPLETED_BEFORE_NOW_ON_ANY_OTHER_LOGICAL_CORE;
+  itti_desc.threads[thread_id].tid = syscall (SYS_gettid);
+  itti_desc.threads[thread_id].previous_stats_ns = itti_latency_now_ns ();
   itti_desc.threads[thread_id].task_state = TASK_STATE_READY;
   itti_desc.ready_tasks++;
 
@@ -827,6 +1455,11 @@ itti_init (
   itti_desc.thread_handling_signals = false;
   itti_desc.tasks_info = tasks_info;
   itti_desc.messages_info = messages_info;
+  itti_desc.messages_stats = calloc (messages_id_max, sizeof (message_stats_t));
+  itti_desc.messages_sheddable = calloc (messages_id_max, sizeof (bool));
+  itti_desc.messages_previous_stats = calloc (messages_id_max, sizeof (message_stats_t));
+  itti_desc.tasks_previous_stats = calloc (task_max, sizeof (task_desc_t));
+  itti_desc.previous_stats_ns = itti_latency_now_ns ();
   /*
    * Allocates memory for tasks info
    */
@@ -848,8 +1481,11 @@ itti_init (
     ITTI_DEBUG (ITTI_DEBUG_INIT, " Creating queue of message of size %u\n", itti_desc.tasks_info[task_id].queue_size);
     printf (" Creating queue of message of size %u\n", itti_desc.tasks_info[task_id].queue_size);
 
-    itti_desc.tasks[task_id].qbmme = calloc(itti_desc.tasks_info[task_id].queue_size, sizeof(struct lfds710_queue_bmm_element));
+    itti_desc.tasks[task_id].qbmme = memalign(sysconf (_SC_PAGESIZE), itti_queue_elements_size (task_id));
+    AssertFatal (itti_desc.tasks[task_id].qbmme != NULL, "Queue allocation for task %d failed!\n", task_id);
+    memset(itti_desc.tasks[task_id].qbmme, 0, itti_queue_elements_size (task_id));
     lfds710_queue_bmm_init_valid_on_current_logical_core( &itti_desc.tasks[task_id].message_queue, itti_desc.tasks[task_id].qbmme, itti_desc.tasks_info[task_id].queue_size, NULL );
+    pthread_mutex_init (&itti_desc.tasks[task_id].overflow_lock, NULL);
   }
 
   /*
@@ -857,6 +1493,8 @@ itti_init (
    */
   for (thread_id = THREAD_FIRST; thread_id < itti_desc.thread_max; thread_id++) {
     itti_desc.threads[thread_id].task_state = TASK_STATE_NOT_CONFIGURED;
+    itti_desc.threads[thread_id].numa_node = -1;
+    itti_desc.threads[thread_id].wait_mode = ITTI_WAIT_MODE_BLOCK;
     itti_desc.threads[thread_id].epoll_fd = epoll_create1 (0);
 
     if (itti_desc.threads[thread_id].epoll_fd == -1) {
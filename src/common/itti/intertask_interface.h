@@ -79,6 +79,24 @@ typedef enum task_priorities_e {
   TASK_PRIORITY_MIN       = 10,
 } task_priorities_t;
 
+/* How a task thread waits for messages */
+typedef enum itti_wait_mode_e {
+  ITTI_WAIT_MODE_BLOCK = 0,    ///< sleep in epoll_wait
+  ITTI_WAIT_MODE_ADAPTIVE_SPIN,///< poll for spin_us, then sleep
+  ITTI_WAIT_MODE_BUSY_POLL,    ///< never sleep, the thread keeps its CPU
+} itti_wait_mode_t;
+
+typedef struct itti_task_stats_s {
+  uint64_t enqueued;           ///< messages queued since start
+  uint64_t dequeued;           ///< messages received since start
+  uint64_t dropped;            ///< sheddable messages dropped because the queue was full
+  uint64_t overflowed;         ///< messages kept in the overflow list because the queue was full
+  uint32_t depth;              ///< messages currently in the queue
+  uint32_t high_watermark;     ///< max depth since start
+  uint32_t queue_size;
+  uint32_t outstanding;        ///< requests sent by the task to an external peer and not answered yet
+} itti_task_stats_t;
+
 typedef struct task_info_s {
   thread_id_t thread;
   task_id_t   parent_task;
@@ -102,13 +120,64 @@ void itti_update_lte_time (__time_t    seconds,__suseconds_t useconds);
 int itti_send_broadcast_message(MessageDef *message_p);
 
 /** \brief Send a message to a task (could be itself)
+ * When the queue of the task is full, a sheddable message is dropped with its content, other messages are kept in an
+ * overflow list of the task and received in order after the queue.
  \param task_id Task ID
  \param instance Instance of the task used for virtualization
  \param message Pointer to the message to send
- @returns -1 on failure, 0 otherwise
+ @returns -1 if the message was dropped, 0 otherwise
  **/
 int itti_send_msg_to_task(task_id_t task_id, instance_t instance, MessageDef *message);
 
+/** \brief Send several messages to a task, the destination thread is woken up once
+ \param task_id Task ID
+ \param instance Instance of the task used for virtualization
+ \param messages Messages to send, owned by ITTI after the call
+ \param nb_messages Number of messages
+ @returns the number of messages dropped because the queue was full
+ **/
+int itti_send_msg_to_task_batch(task_id_t task_id, instance_t instance, MessageDef **messages, const int nb_messages);
+
+/** \brief Allow the messages of an id to be dropped when the queue of the destination task is full, for the ingress
+ * of new procedures. Messages are not sheddable by default.
+ \param message_id Message ID
+ **/
+void itti_set_message_sheddable(MessagesIds message_id);
+
+/** \brief Set the function freeing the content of dropped messages (itti_free_msg_content ()).
+ **/
+void itti_set_free_msg_content(void (*free_msg_content)(MessageDef * const message_p));
+
+/** \brief Number of messages waiting in the queue of a task (lock-free, approximate under concurrency).
+ \param task_id Task ID
+ **/
+uint32_t itti_get_queue_depth(task_id_t task_id);
+
+/** \brief Queue statistics of a task.
+ \param task_id Task ID
+ \param stats Filled with counters since start
+ **/
+void itti_get_task_stats(task_id_t task_id, itti_task_stats_t * const stats);
+
+/** \brief Account a request sent by a task to an external peer (S6a, S11, ...), for load estimation.
+ * Must be followed by itti_transaction_end () on answer or timeout.
+ \param task_id Task ID
+ **/
+void itti_transaction_start(task_id_t task_id);
+void itti_transaction_end(task_id_t task_id);
+
+/** \brief Set the requests of a task waiting for an answer from an external peer, for tasks that keep a table of
+ * their transactions: the gauge follows the table on every teardown path.
+ \param task_id Task ID
+ \param outstanding Number of transactions in the table
+ **/
+void itti_transaction_set(task_id_t task_id, const uint32_t outstanding);
+
+/** \brief Log per task enqueue/dequeue rates, depth, high watermark and drops, and per message id rates, residence
+ * and handler service times (sampled), since the previous call. Must not be called concurrently.
+ **/
+void itti_print_stats(void);
+
 /** \brief Add a new fd to monitor.
  * NOTE: it is up to the user to read data associated with the fd
  *  \param task_id Task ID of the receiving task
@@ -159,6 +228,21 @@ int itti_create_task(task_id_t task_id,
 void itti_set_task_real_time(task_id_t task_id);
 //#endif
 
+/** \brief Set the CPUs, NUMA node and wait mode of the thread of a task.
+ * Can be called before or after the creation of the task, a running thread is moved immediately.
+ * \param task_name name of the task, ex: "TASK_S1AP"
+ * \param cpu_list CPUs the thread may run on, ex: "2-3,8", NULL or empty to leave the affinity unchanged
+ * \param numa_node node where the message queue of the task is moved, -1 to leave it where it is
+ * \param wait_mode how the thread waits for messages
+ * \param spin_us polling duration in ITTI_WAIT_MODE_ADAPTIVE_SPIN mode
+ * @returns -1 if the task is unknown or the CPU list is invalid, 0 otherwise
+ **/
+int itti_set_task_placement(const char *task_name, const char *cpu_list, int numa_node, itti_wait_mode_t wait_mode, uint32_t spin_us);
+
+/** \brief Log the CPU time and run queue delay of the task threads since the previous call
+ **/
+void itti_print_thread_stats(void);
+
 /** \brief Indicates to ITTI if newly created tasks should wait for all tasks to be ready
  * \param wait_tasks non 0 to make new created tasks to wait, 0 to let created tasks to run
  **/
@@ -0,0 +1,308 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file intertask_interface_latency.c
+   \brief Procedure latency tracing across ITTI tasks.
+   \date 2018
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "assertions.h"
+#include "intertask_interface.h"
+#include "intertask_interface_latency.h"
+#include "log.h"
+
+/*
+ * Log-linear histogram (HDR like): values below 2^SUB_BUCKET_BITS ns have their own bucket, above the relative
+ * error is bounded by 2^-(SUB_BUCKET_BITS-1). Values above 2^MAX_BITS ns (~68 s) are clamped in the last bucket.
+ */
+#define ITTI_LATENCY_SUB_BUCKET_BITS     6
+#define ITTI_LATENCY_SUB_BUCKETS         (1 << ITTI_LATENCY_SUB_BUCKET_BITS)
+#define ITTI_LATENCY_HALF_SUB_BUCKETS    (ITTI_LATENCY_SUB_BUCKETS >> 1)
+#define ITTI_LATENCY_MAX_BITS            36
+#define ITTI_LATENCY_BUCKETS             (ITTI_LATENCY_SUB_BUCKETS + (ITTI_LATENCY_MAX_BITS - ITTI_LATENCY_SUB_BUCKET_BITS) * ITTI_LATENCY_HALF_SUB_BUCKETS)
+
+typedef struct itti_latency_histogram_s {
+  uint64_t   count;
+  uint64_t   sum_ns;
+  uint64_t   max_ns;
+  uint64_t   buckets[ITTI_LATENCY_BUCKETS];
+} itti_latency_histogram_t;
+
+typedef struct itti_latency_desc_s {
+  itti_latency_histogram_t  queueing[TASK_MAX];                        // enqueue to dequeue
+  itti_latency_histogram_t  service[TASK_MAX];                         // dequeue to next receive by the task
+  itti_latency_histogram_t  hop[ITTI_LATENCY_PROC_MAX][TASK_MAX];      // procedure start to dequeue by the task
+  itti_latency_histogram_t  procedure[ITTI_LATENCY_PROC_MAX];          // procedure start to last activity
+  uint64_t                  start_ns;
+} itti_latency_desc_t;
+
+static const char * const itti_latency_procedure_names[ITTI_LATENCY_PROC_MAX] = {
+  "NONE",
+  "ATTACH",
+  "DETACH",
+  "TAU",
+  "SERVICE_REQUEST",
+  "UE_CONTEXT_RELEASE",
+  "PAGING",
+  "OTHER",
+};
+
+volatile bool                           itti_latency_enabled = false;
+__thread itti_trace_context_t           itti_latency_current_trace = {0};
+
+static __thread task_id_t               itti_latency_current_task = TASK_UNKNOWN;
+static __thread uint64_t                itti_latency_dequeue_ns = 0;
+
+static itti_latency_desc_t             *itti_latency_desc = NULL;
+static bstring                          itti_latency_file_name = NULL;
+static uint32_t                         itti_latency_trace_id = 0;
+
+//------------------------------------------------------------------------------
+static inline int itti_latency_bucket_index (const uint64_t value_ns)
+{
+  if (value_ns < ITTI_LATENCY_SUB_BUCKETS) {
+    return (int)value_ns;
+  }
+  const int       msb = 63 - __builtin_clzll (value_ns);
+  const int       exponent = msb - ITTI_LATENCY_SUB_BUCKET_BITS + 1;
+
+  if (exponent > (ITTI_LATENCY_MAX_BITS - ITTI_LATENCY_SUB_BUCKET_BITS)) {
+    return ITTI_LATENCY_BUCKETS - 1;
+  }
+  return ITTI_LATENCY_SUB_BUCKETS + (exponent - 1) * ITTI_LATENCY_HALF_SUB_BUCKETS +
+      (int)((value_ns >> exponent) - ITTI_LATENCY_HALF_SUB_BUCKETS);
+}
+
+//------------------------------------------------------------------------------
+static uint64_t itti_latency_bucket_upper_bound (const int index)
+{
+  if (index < ITTI_LATENCY_SUB_BUCKETS) {
+    return (uint64_t)index;
+  }
+  const int       exponent = ((index - ITTI_LATENCY_SUB_BUCKETS) / ITTI_LATENCY_HALF_SUB_BUCKETS) + 1;
+  const uint64_t  mantissa = ((index - ITTI_LATENCY_SUB_BUCKETS) % ITTI_LATENCY_HALF_SUB_BUCKETS) + ITTI_LATENCY_HALF_SUB_BUCKETS;
+
+  return ((mantissa + 1) << exponent) - 1;
+}
+
+//------------------------------------------------------------------------------
+static inline void itti_latency_record (itti_latency_histogram_t * const histogram, const uint64_t value_ns)
+{
+  uint64_t        max_ns = __atomic_load_n (&histogram->max_ns, __ATOMIC_RELAXED);
+
+  __atomic_fetch_add (&histogram->buckets[itti_latency_bucket_index (value_ns)], 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add (&histogram->sum_ns, value_ns, __ATOMIC_RELAXED);
+  __atomic_fetch_add (&histogram->count, 1, __ATOMIC_RELAXED);
+  while ((value_ns > max_ns) &&
+      (!__atomic_compare_exchange_n (&histogram->max_ns, &max_ns, value_ns, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)));
+}
+
+//------------------------------------------------------------------------------
+static inline uint64_t itti_latency_elapsed (const uint64_t from_ns, const uint64_t to_ns)
+{
+  return (to_ns > from_ns) ? (to_ns - from_ns):0;
+}
+
+//------------------------------------------------------------------------------
+int itti_latency_init (const char * const file_name)
+{
+  AssertFatal (file_name != NULL, "No latency file name");
+  itti_latency_desc = calloc (1, sizeof (itti_latency_desc_t));
+  if (!itti_latency_desc) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to allocate latency histograms: %s\n", strerror (errno));
+    return -1;
+  }
+  itti_latency_file_name = bfromcstr (file_name);
+  itti_latency_desc->start_ns = itti_latency_now_ns ();
+  __atomic_store_n (&itti_latency_enabled, true, __ATOMIC_RELEASE);
+  OAILOG_INFO (LOG_ITTI, "ITTI procedure latency measurement enabled, dumped in %s\n", file_name);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+void itti_latency_exit (void)
+{
+  if (itti_latency_desc) {
+    itti_latency_dump ();
+    itti_latency_enabled = false;
+    /*
+     * Tasks may still be running when exiting, histograms are left allocated.
+     */
+  }
+  bdestroy (itti_latency_file_name);
+  itti_latency_file_name = NULL;
+}
+
+//------------------------------------------------------------------------------
+void itti_latency_on_send_internal (MessageDef * const message_p)
+{
+  message_p->ittiMsgHeader.enqueue_ns = itti_latency_now_ns ();
+}
+
+//------------------------------------------------------------------------------
+void itti_latency_on_receive_entry_internal (void)
+{
+  /*
+   * The task comes back to ITTI: the previous message has been handled.
+   */
+  if (itti_latency_dequeue_ns) {
+    itti_latency_record (&itti_latency_desc->service[itti_latency_current_task],
+        itti_latency_elapsed (itti_latency_dequeue_ns, itti_latency_now_ns ()));
+    itti_latency_dequeue_ns = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+void itti_latency_on_receive_internal (const task_id_t task_id, const MessageDef * const message_p)
+{
+  const itti_trace_context_t         trace = message_p->ittiMsgHeader.trace;
+  const uint64_t                     now_ns = itti_latency_now_ns ();
+
+  itti_latency_current_task  = task_id;
+  itti_latency_current_trace = trace;
+  itti_latency_dequeue_ns    = now_ns;
+  // messages sent before measurement was enabled
+  if (message_p->ittiMsgHeader.enqueue_ns) {
+    itti_latency_record (&itti_latency_desc->queueing[task_id], itti_latency_elapsed (message_p->ittiMsgHeader.enqueue_ns, now_ns));
+  }
+  if ((trace.trace_id) && (trace.procedure < ITTI_LATENCY_PROC_MAX)) {
+    itti_latency_record (&itti_latency_desc->hop[trace.procedure][task_id], itti_latency_elapsed (trace.start_ns, now_ns));
+  }
+}
+
+//------------------------------------------------------------------------------
+void itti_latency_procedure_start_internal (itti_trace_context_t * const trace, const itti_latency_procedure_t procedure)
+{
+  uint32_t        trace_id = __atomic_add_fetch (&itti_latency_trace_id, 1, __ATOMIC_RELAXED);
+
+  if (!trace_id) {
+    trace_id = __atomic_add_fetch (&itti_latency_trace_id, 1, __ATOMIC_RELAXED);
+  }
+  itti_latency_current_trace.trace_id  = trace_id;
+  itti_latency_current_trace.procedure = procedure;
+  itti_latency_current_trace.start_ns  = itti_latency_now_ns ();
+  if (trace) {
+    *trace = itti_latency_current_trace;
+  }
+}
+
+//------------------------------------------------------------------------------
+void itti_latency_procedure_end_internal (itti_trace_context_t * const trace, const uint64_t last_activity_ns)
+{
+  if ((trace->trace_id) && (trace->procedure < ITTI_LATENCY_PROC_MAX)) {
+    itti_latency_record (&itti_latency_desc->procedure[trace->procedure], itti_latency_elapsed (trace->start_ns, last_activity_ns));
+  }
+  if (itti_latency_current_trace.trace_id == trace->trace_id) {
+    memset (&itti_latency_current_trace, 0, sizeof (itti_latency_current_trace));
+  }
+  memset (trace, 0, sizeof (*trace));
+}
+
+//------------------------------------------------------------------------------
+static uint64_t itti_latency_percentile (const itti_latency_histogram_t * const histogram, const uint64_t * const buckets,
+    const uint64_t count, const double percentile)
+{
+  const uint64_t  rank = (uint64_t)((percentile * count) / 100.0 + 0.5);
+  uint64_t        cumulated = 0;
+  uint64_t        max_ns = __atomic_load_n (&histogram->max_ns, __ATOMIC_RELAXED);
+
+  for (int i = 0; i < ITTI_LATENCY_BUCKETS; i++) {
+    cumulated += buckets[i];
+    if ((cumulated >= rank) && (cumulated)) {
+      uint64_t    upper = itti_latency_bucket_upper_bound (i);
+      return (upper < max_ns) ? upper:max_ns;
+    }
+  }
+  return max_ns;
+}
+
+//------------------------------------------------------------------------------
+static void itti_latency_dump_histogram (FILE * const fp, const char * const procedure, const char * const name,
+    const itti_latency_histogram_t * const histogram)
+{
+  uint64_t        buckets[ITTI_LATENCY_BUCKETS];
+  uint64_t        count = 0;
+
+  // snapshot, the histogram may be updated while dumped
+  for (int i = 0; i < ITTI_LATENCY_BUCKETS; i++) {
+    buckets[i] = __atomic_load_n (&histogram->buckets[i], __ATOMIC_RELAXED);
+    count += buckets[i];
+  }
+  if (!count) {
+    return;
+  }
+  fprintf (fp, "%-20s %-26s %12lu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", procedure, name, (unsigned long)count,
+      ((double)__atomic_load_n (&histogram->sum_ns, __ATOMIC_RELAXED)) / count / 1000.0,
+      itti_latency_percentile (histogram, buckets, count, 50.0) / 1000.0,
+      itti_latency_percentile (histogram, buckets, count, 90.0) / 1000.0,
+      itti_latency_percentile (histogram, buckets, count, 99.0) / 1000.0,
+      itti_latency_percentile (histogram, buckets, count, 99.9) / 1000.0,
+      __atomic_load_n (&histogram->max_ns, __ATOMIC_RELAXED) / 1000.0);
+}
+
+//------------------------------------------------------------------------------
+void itti_latency_dump (void)
+{
+  FILE                                   *fp = NULL;
+  bstring                                 tmp_file_name = NULL;
+
+  if ((!itti_latency_enabled) || (!itti_latency_desc)) {
+    return;
+  }
+  tmp_file_name = bformat ("%s.tmp", bdata (itti_latency_file_name));
+  fp = fopen (bdata (tmp_file_name), "w");
+  if (!fp) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to open %s: %s\n", bdata (tmp_file_name), strerror (errno));
+    bdestroy (tmp_file_name);
+    return;
+  }
+  fprintf (fp, "# ITTI latency, cumulated over %.1f s, values in microseconds\n",
+      itti_latency_elapsed (itti_latency_desc->start_ns, itti_latency_now_ns ()) / 1000000000.0);
+  fprintf (fp, "%-20s %-26s %12s %10s %10s %10s %10s %10s %10s\n", "#procedure", "hop", "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+  for (int t = TASK_FIRST; t < TASK_MAX; t++) {
+    char        name[64];
+
+    snprintf (name, sizeof (name), "queue:%s", itti_get_task_name (t));
+    itti_latency_dump_histogram (fp, "*", name, &itti_latency_desc->queueing[t]);
+    snprintf (name, sizeof (name), "service:%s", itti_get_task_name (t));
+    itti_latency_dump_histogram (fp, "*", name, &itti_latency_desc->service[t]);
+  }
+  for (int p = ITTI_LATENCY_PROC_NONE + 1; p < ITTI_LATENCY_PROC_MAX; p++) {
+    itti_latency_dump_histogram (fp, itti_latency_procedure_names[p], "total", &itti_latency_desc->procedure[p]);
+    for (int t = TASK_FIRST; t < TASK_MAX; t++) {
+      itti_latency_dump_histogram (fp, itti_latency_procedure_names[p], itti_get_task_name (t), &itti_latency_desc->hop[p][t]);
+    }
+  }
+  fclose (fp);
+  if (rename (bdata (tmp_file_name), bdata (itti_latency_file_name))) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to rename %s: %s\n", bdata (tmp_file_name), strerror (errno));
+  }
+  bdestroy (tmp_file_name);
+}
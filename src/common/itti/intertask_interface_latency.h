@@ -0,0 +1,144 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file intertask_interface_latency.h
+   \brief Procedure latency tracing across ITTI tasks.
+   \ A procedure (attach, service request, ...) is given a trace id at S1AP ingress, the trace context is copied in
+   \ the header of every message allocated while a task handles a message of this procedure.
+   \ On each hop the queueing delay, the service time of the task and the elapsed time since the start of the
+   \ procedure are recorded in lock-free log-linear histograms, dumped periodically in a text file.
+   \date 2018
+*/
+
+#ifndef FILE_INTERTASK_INTERFACE_LATENCY_SEEN
+#define FILE_INTERTASK_INTERFACE_LATENCY_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+typedef enum itti_latency_procedure_e {
+  ITTI_LATENCY_PROC_NONE = 0,
+  ITTI_LATENCY_PROC_ATTACH,
+  ITTI_LATENCY_PROC_DETACH,
+  ITTI_LATENCY_PROC_TAU,
+  ITTI_LATENCY_PROC_SERVICE_REQUEST,
+  ITTI_LATENCY_PROC_UE_CONTEXT_RELEASE,
+  ITTI_LATENCY_PROC_PAGING,
+  ITTI_LATENCY_PROC_OTHER,
+  ITTI_LATENCY_PROC_MAX
+} itti_latency_procedure_t;
+
+extern volatile bool itti_latency_enabled;
+
+/* Trace context of the message being handled by the calling thread */
+extern __thread itti_trace_context_t itti_latency_current_trace;
+
+/** \brief Allocate the histograms and start measuring.
+ \param file_name Text file rewritten by itti_latency_dump ()
+ @returns -1 on failure, 0 otherwise
+ **/
+int  itti_latency_init (const char * const file_name);
+void itti_latency_exit (void);
+
+/** \brief Write the histograms (cumulated since start) in the file given at init, the file is replaced atomically. **/
+void itti_latency_dump (void);
+
+/* Called by ITTI only */
+void itti_latency_on_send_internal (MessageDef * const message_p);
+void itti_latency_on_receive_entry_internal (void);
+void itti_latency_on_receive_internal (const task_id_t task_id, const MessageDef * const message_p);
+void itti_latency_procedure_end_internal (itti_trace_context_t * const trace, const uint64_t last_activity_ns);
+
+//------------------------------------------------------------------------------
+static inline uint64_t itti_latency_now_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+static inline void itti_latency_stamp_message (MessageDef * const message_p)
+{
+  if (__builtin_expect(itti_latency_enabled, 0)) {
+    message_p->ittiMsgHeader.trace = itti_latency_current_trace;
+  }
+}
+
+//------------------------------------------------------------------------------
+static inline void itti_latency_on_send (MessageDef * const message_p)
+{
+  if (__builtin_expect(itti_latency_enabled, 0)) {
+    itti_latency_on_send_internal (message_p);
+  }
+}
+
+//------------------------------------------------------------------------------
+static inline void itti_latency_on_receive_entry (void)
+{
+  if (__builtin_expect(itti_latency_enabled, 0)) {
+    itti_latency_on_receive_entry_internal ();
+  }
+}
+
+//------------------------------------------------------------------------------
+static inline void itti_latency_on_receive (const task_id_t task_id, const MessageDef * const message_p)
+{
+  if (__builtin_expect(itti_latency_enabled, 0)) {
+    itti_latency_on_receive_internal (task_id, message_p);
+  }
+}
+
+/** \brief Start a new procedure, it becomes the trace context of the calling thread.
+ \param trace Where the procedure context is kept by the caller (UE context), may be NULL
+ **/
+void itti_latency_procedure_start_internal (itti_trace_context_t * const trace, const itti_latency_procedure_t procedure);
+
+static inline void itti_latency_procedure_start (itti_trace_context_t * const trace, const itti_latency_procedure_t procedure)
+{
+  if (__builtin_expect(itti_latency_enabled, 0)) {
+    itti_latency_procedure_start_internal (trace, procedure);
+  }
+}
+
+/** \brief Account the total duration of the procedure (start to last activity) and clear the context. **/
+static inline void itti_latency_procedure_end (itti_trace_context_t * const trace, const uint64_t last_activity_ns)
+{
+  if (__builtin_expect(itti_latency_enabled, 0)) {
+    itti_latency_procedure_end_internal (trace, last_activity_ns);
+  }
+}
+
+/** \brief Re-attach the calling thread to a procedure, if it is not already handling a traced message
+ * (chains started by answers of external peers are not traced).
+ **/
+static inline void itti_latency_procedure_resume (const itti_trace_context_t * const trace)
+{
+  if (__builtin_expect(itti_latency_enabled, 0)) {
+    if ((!itti_latency_current_trace.trace_id) && (trace->trace_id)) {
+      itti_latency_current_trace = *trace;
+    }
+  }
+}
+
+#endif /* FILE_INTERTASK_INTERFACE_LATENCY_SEEN */
@@ -0,0 +1,199 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file intertask_interface_trace.c
+   \brief Binary trace of ITTI messages in a memory mapped file ring.
+   \date 2018
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "assertions.h"
+#include "intertask_interface.h"
+#include "intertask_interface_trace.h"
+#include "itti_trace_format.h"
+
+volatile bool                           itti_trace_enabled = false;
+
+static itti_trace_file_header_t        *itti_trace_header = NULL;
+static uint8_t                         *itti_trace_ring   = NULL;
+static size_t                           itti_trace_map_size = 0;
+static int                              itti_trace_fd = -1;
+static bool                             itti_trace_task_selected[TASK_MAX];
+static bool                             itti_trace_message_selected[MESSAGES_ID_MAX];
+static bool                             itti_trace_task_filter_set = false;
+static bool                             itti_trace_message_filter_set = false;
+
+//------------------------------------------------------------------------------
+static inline void itti_trace_copy_to_ring (uint64_t offset, const void * const src, size_t length)
+{
+  const uint64_t  mask = itti_trace_header->ring_size - 1;
+  const uint64_t  pos  = offset & mask;
+  const size_t    first = ((pos + length) <= itti_trace_header->ring_size) ? length:(size_t)(itti_trace_header->ring_size - pos);
+
+  memcpy (&itti_trace_ring[pos], src, first);
+  if (first < length) {
+    memcpy (itti_trace_ring, ((const uint8_t *)src) + first, length - first);
+  }
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_message_internal (const message_number_t message_number, const MessageDef * const message_p)
+{
+  const task_id_t     origin_task_id      = ITTI_MSG_ORIGIN_ID (message_p);
+  const task_id_t     destination_task_id = ITTI_MSG_DESTINATION_ID (message_p);
+  const MessagesIds   message_id          = ITTI_MSG_ID (message_p);
+  itti_trace_record_t record;
+  struct timespec     ts;
+
+  if ((itti_trace_task_filter_set) &&
+      (!itti_trace_task_selected[origin_task_id]) && (!itti_trace_task_selected[destination_task_id])) {
+    return;
+  }
+  if ((itti_trace_message_filter_set) && (!itti_trace_message_selected[message_id])) {
+    return;
+  }
+  clock_gettime (CLOCK_REALTIME, &ts);
+  record.payload_size        = sizeof (MessageHeader) + message_p->ittiMsgHeader.ittiMsgSize;
+  record.size                = ITTI_TRACE_ALIGN (sizeof (itti_trace_record_t) + record.payload_size);
+  record.message_number      = message_number;
+  record.timestamp_ns        = ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+  record.origin_task_id      = origin_task_id;
+  record.destination_task_id = destination_task_id;
+  record.message_id          = message_id;
+  record.reserved            = 0;
+  if (record.size > (itti_trace_header->ring_size / 4)) {
+    __atomic_add_fetch (&itti_trace_header->dropped, 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  const uint64_t offset = __atomic_fetch_add (&itti_trace_header->head, record.size, __ATOMIC_RELAXED);
+  // the offset field is 8 bytes aligned and never split at the end of the ring
+  volatile uint64_t * const offset_field = (volatile uint64_t *)&itti_trace_ring[offset & (itti_trace_header->ring_size - 1)];
+
+  __atomic_store_n (offset_field, ITTI_TRACE_RECORD_IN_PROGRESS, __ATOMIC_RELAXED);
+  __atomic_thread_fence (__ATOMIC_RELEASE);
+  itti_trace_copy_to_ring (offset + sizeof (record.offset), ((const uint8_t *)&record) + sizeof (record.offset), sizeof (record) - sizeof (record.offset));
+  itti_trace_copy_to_ring (offset + sizeof (record), message_p, record.payload_size);
+  __atomic_store_n (offset_field, offset, __ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+int itti_trace_init (const char * const file_name, const uint64_t ring_size)
+{
+  const long      page_size = sysconf (_SC_PAGESIZE);
+  uint64_t        size = 4096;
+  uint64_t        ring_offset = sizeof (itti_trace_file_header_t) + (TASK_MAX + MESSAGES_ID_MAX) * ITTI_TRACE_NAME_LENGTH;
+
+  while (size < ring_size) size <<= 1;
+  ring_offset = ((ring_offset + page_size - 1) / page_size) * page_size;
+
+  itti_trace_fd = open (file_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (0 > itti_trace_fd) {
+    fprintf (stderr, "[ITTI_TRACE][E] can not open trace file \"%s\" (%d:%s)\n", file_name, errno, strerror (errno));
+    return -1;
+  }
+  itti_trace_map_size = ring_offset + size;
+  if (ftruncate (itti_trace_fd, itti_trace_map_size)) {
+    fprintf (stderr, "[ITTI_TRACE][E] can not size trace file \"%s\" (%d:%s)\n", file_name, errno, strerror (errno));
+    close (itti_trace_fd);
+    itti_trace_fd = -1;
+    return -1;
+  }
+  void * map = mmap (NULL, itti_trace_map_size, PROT_READ | PROT_WRITE, MAP_SHARED, itti_trace_fd, 0);
+  if (MAP_FAILED == map) {
+    fprintf (stderr, "[ITTI_TRACE][E] can not map trace file \"%s\" (%d:%s)\n", file_name, errno, strerror (errno));
+    close (itti_trace_fd);
+    itti_trace_fd = -1;
+    return -1;
+  }
+  itti_trace_header = (itti_trace_file_header_t *)map;
+  itti_trace_ring   = ((uint8_t *)map) + ring_offset;
+
+  char * names = (char *)&itti_trace_header[1];
+  for (int i = 0; i < TASK_MAX; i++, names += ITTI_TRACE_NAME_LENGTH) {
+    strncpy (names, itti_get_task_name (i), ITTI_TRACE_NAME_LENGTH - 1);
+  }
+  for (int i = 0; i < MESSAGES_ID_MAX; i++, names += ITTI_TRACE_NAME_LENGTH) {
+    strncpy (names, itti_get_message_name (i), ITTI_TRACE_NAME_LENGTH - 1);
+  }
+  itti_trace_header->num_tasks    = TASK_MAX;
+  itti_trace_header->num_messages = MESSAGES_ID_MAX;
+  itti_trace_header->ring_offset  = ring_offset;
+  itti_trace_header->ring_size    = size;
+  itti_trace_header->dropped      = 0;
+  itti_trace_header->head         = 0;
+  itti_trace_header->version      = ITTI_TRACE_VERSION;
+  __atomic_store_n (&itti_trace_header->magic, ITTI_TRACE_MAGIC, __ATOMIC_RELEASE);
+  itti_trace_enabled = true;
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_exit (void)
+{
+  if (itti_trace_header) {
+    itti_trace_enabled = false;
+    msync (itti_trace_header, itti_trace_map_size, MS_ASYNC);
+    munmap (itti_trace_header, itti_trace_map_size);
+    itti_trace_header = NULL;
+    itti_trace_ring   = NULL;
+    close (itti_trace_fd);
+    itti_trace_fd = -1;
+  }
+}
+
+//------------------------------------------------------------------------------
+int itti_trace_select_task (const char * const task_name)
+{
+  for (int i = TASK_FIRST; i < TASK_MAX; i++) {
+    if (!strcmp (task_name, itti_get_task_name (i))) {
+      itti_trace_task_selected[i] = true;
+      itti_trace_task_filter_set  = true;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+int itti_trace_select_message (const char * const message_name)
+{
+  for (int i = 0; i < MESSAGES_ID_MAX; i++) {
+    if (!strcmp (message_name, itti_get_message_name (i))) {
+      itti_trace_message_selected[i] = true;
+      itti_trace_message_filter_set  = true;
+      return 0;
+    }
+  }
+  return -1;
+}
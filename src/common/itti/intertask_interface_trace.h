@@ -0,0 +1,58 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file intertask_interface_trace.h
+   \brief Binary trace of ITTI messages in a memory mapped file ring (see itti_trace_format.h),
+   \ can be read while the process is running or offline with itti_trace_reader.
+   \date 2018
+*/
+
+#ifndef FILE_INTERTASK_INTERFACE_TRACE_SEEN
+#define FILE_INTERTASK_INTERFACE_TRACE_SEEN
+
+#include <stdbool.h>
+
+extern volatile bool itti_trace_enabled;
+
+/** \brief Create (truncate) the trace file and map it, tracing starts immediately with all tasks and messages selected.
+ \param file_name Trace file path
+ \param ring_size Size of the ring in bytes, rounded up to a power of 2
+ @returns -1 on failure, 0 otherwise
+ **/
+int  itti_trace_init (const char * const file_name, const uint64_t ring_size);
+void itti_trace_exit (void);
+
+/** \brief Restrict the trace to messages sent or received by the selected tasks / with the selected ids.
+ * The first call for a kind of filter deselects every other task (message id).
+ **/
+int  itti_trace_select_task (const char * const task_name);
+int  itti_trace_select_message (const char * const message_name);
+
+void itti_trace_message_internal (const message_number_t message_number, const MessageDef * const message_p);
+
+static inline void itti_trace_message (const message_number_t message_number, const MessageDef * const message_p)
+{
+  if (__builtin_expect(itti_trace_enabled, 0)) {
+    itti_trace_message_internal (message_number, message_p);
+  }
+}
+
+#endif /* FILE_INTERTASK_INTERFACE_TRACE_SEEN */
@@ -113,6 +113,17 @@ typedef struct itti_lte_time_s {
   struct timeval time;
 } itti_lte_time_t;
 
+/** @struct itti_trace_context_t
+ *  @brief Procedure latency trace context (see intertask_interface_latency.h).
+ *  Stamped in every message allocated while a task handles a traced message, so that it follows
+ *  the causal chain of messages of a procedure across tasks.
+ */
+typedef struct itti_trace_context_s {
+  uint32_t  trace_id;             /**< 0 if the message is not traced */
+  uint8_t   procedure;            /**< itti_latency_procedure_t */
+  uint64_t  start_ns;             /**< Procedure start time (CLOCK_MONOTONIC) */
+} itti_trace_context_t;
+
 /** @struct MessageHeader
  *  @brief Message Header structure for inter-task communication.
  */
@@ -126,6 +137,9 @@ typedef struct MessageHeader_s {
   MessageHeaderSize ittiMsgSize;         /**< Message size (not including header size) */
 
   itti_lte_time_t lte_time;       /**< Reference LTE time */
+
+  itti_trace_context_t trace;     /**< Procedure latency trace context */
+  uint64_t   enqueue_ns;          /**< Time the message was queued, only set if latency measurement is enabled */
 } MessageHeader;
 
 /** @struct MessageDef
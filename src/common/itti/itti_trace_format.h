@@ -0,0 +1,68 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file itti_trace_format.h
+   \brief Layout of the memory mapped ITTI trace file, shared by the ITTI tracer and the offline reader.
+   \ The file starts with a header followed by the task and message names tables, then by a ring of records.
+   \ Writers reserve room in the ring by atomically incrementing head (absolute byte offset, never wraps),
+   \ a record may be split at the end of the ring. The first 8 bytes of a record hold its absolute offset,
+   \ written last, so that readers can both detect a completed record and resynchronize on a record boundary.
+   \date 2018
+*/
+
+#ifndef FILE_ITTI_TRACE_FORMAT_SEEN
+#define FILE_ITTI_TRACE_FORMAT_SEEN
+
+#include <stdint.h>
+
+#define ITTI_TRACE_MAGIC                0x52545449  // "ITTR"
+#define ITTI_TRACE_VERSION              1
+#define ITTI_TRACE_NAME_LENGTH          48
+#define ITTI_TRACE_RECORD_ALIGN         8
+#define ITTI_TRACE_RECORD_IN_PROGRESS   UINT64_MAX
+
+#define ITTI_TRACE_ALIGN(sIZE)          (((sIZE) + ITTI_TRACE_RECORD_ALIGN - 1) & ~((uint64_t)ITTI_TRACE_RECORD_ALIGN - 1))
+
+typedef struct itti_trace_file_header_s {
+  uint32_t          magic;
+  uint32_t          version;
+  uint32_t          num_tasks;
+  uint32_t          num_messages;
+  uint64_t          ring_offset;         ///< file offset of the ring, page aligned
+  uint64_t          ring_size;           ///< power of 2
+  uint64_t          dropped;             ///< records not written because larger than the ring
+  volatile uint64_t head __attribute__ ((aligned (64))); ///< bytes reserved in the ring since the start of the trace
+} itti_trace_file_header_t;
+// followed by char task_names[num_tasks][ITTI_TRACE_NAME_LENGTH], char message_names[num_messages][ITTI_TRACE_NAME_LENGTH]
+
+typedef struct itti_trace_record_s {
+  volatile uint64_t offset;              ///< absolute offset of this record in the ring, ITTI_TRACE_RECORD_IN_PROGRESS while written
+  uint32_t          size;                ///< record size including this header, multiple of ITTI_TRACE_RECORD_ALIGN
+  uint32_t          payload_size;        ///< MessageDef (header + payload) size
+  uint64_t          message_number;
+  uint64_t          timestamp_ns;        ///< CLOCK_REALTIME
+  uint16_t          origin_task_id;
+  uint16_t          destination_task_id;
+  uint16_t          message_id;
+  uint16_t          reserved;
+} itti_trace_record_t;
+
+#endif /* FILE_ITTI_TRACE_FORMAT_SEEN */
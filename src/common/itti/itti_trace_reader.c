@@ -0,0 +1,315 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file itti_trace_reader.c
+   \brief Offline (or live with -f) reader of the ITTI binary trace file written by intertask_interface_trace.c.
+   \ Decodes the records to text, or converts them to a pcap file (link type USER0, one packet per record:
+   \ itti_trace_record_t followed by the MessageDef).
+   \date 2018
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "itti_trace_format.h"
+
+#define ITTI_TRACE_READER_MAX_FILTERS   64
+#define PCAP_MAGIC_NANOSECONDS          0xa1b23c4d
+#define PCAP_LINKTYPE_USER0             147
+
+typedef struct pcap_file_header_s {
+  uint32_t magic;
+  uint16_t version_major;
+  uint16_t version_minor;
+  int32_t  thiszone;
+  uint32_t sigfigs;
+  uint32_t snaplen;
+  uint32_t linktype;
+} pcap_file_header_t;
+
+typedef struct pcap_record_header_s {
+  uint32_t ts_sec;
+  uint32_t ts_nsec;
+  uint32_t incl_len;
+  uint32_t orig_len;
+} pcap_record_header_t;
+
+static const itti_trace_file_header_t *header = NULL;
+static const uint8_t                  *ring = NULL;
+static const char                     *task_names = NULL;
+static const char                     *message_names = NULL;
+static bool                            task_selected[UINT16_MAX + 1];
+static bool                            message_selected[UINT16_MAX + 1];
+static bool                            task_filter_set = false;
+static bool                            message_filter_set = false;
+
+//------------------------------------------------------------------------------
+static const char * task_name (const uint16_t task_id)
+{
+  return (task_id < header->num_tasks) ? &task_names[task_id * ITTI_TRACE_NAME_LENGTH]:"?";
+}
+
+//------------------------------------------------------------------------------
+static const char * message_name (const uint16_t message_id)
+{
+  return (message_id < header->num_messages) ? &message_names[message_id * ITTI_TRACE_NAME_LENGTH]:"?";
+}
+
+//------------------------------------------------------------------------------
+static void copy_from_ring (const uint64_t offset, void * const dst, const size_t length)
+{
+  const uint64_t  pos   = offset & (header->ring_size - 1);
+  const size_t    first = ((pos + length) <= header->ring_size) ? length:(size_t)(header->ring_size - pos);
+
+  memcpy (dst, &ring[pos], first);
+  if (first < length) {
+    memcpy (((uint8_t *)dst) + first, ring, length - first);
+  }
+}
+
+//------------------------------------------------------------------------------
+static inline uint64_t load_offset_field (const uint64_t offset)
+{
+  return __atomic_load_n ((const volatile uint64_t *)&ring[offset & (header->ring_size - 1)], __ATOMIC_ACQUIRE);
+}
+
+//------------------------------------------------------------------------------
+static bool is_record_header_valid (const itti_trace_record_t * const record)
+{
+  return ((sizeof (itti_trace_record_t) <= record->size) && (record->size <= (header->ring_size / 4)) &&
+          (0 == (record->size % ITTI_TRACE_RECORD_ALIGN)) && ((record->payload_size + sizeof (itti_trace_record_t)) <= record->size));
+}
+
+//------------------------------------------------------------------------------
+// Find the first record boundary at or after offset: the first 8 bytes of a completed record hold its own offset.
+static uint64_t resync (uint64_t offset)
+{
+  const uint64_t head = __atomic_load_n (&header->head, __ATOMIC_ACQUIRE);
+  itti_trace_record_t record;
+
+  if ((head > header->ring_size) && (offset < (head - header->ring_size))) {
+    offset = head - header->ring_size;
+  }
+  for (offset = ITTI_TRACE_ALIGN (offset); offset < head; offset += ITTI_TRACE_RECORD_ALIGN) {
+    if (load_offset_field (offset) == offset) {
+      copy_from_ring (offset, &record, sizeof (record));
+      if (is_record_header_valid (&record)) {
+        return offset;
+      }
+    }
+  }
+  return head;
+}
+
+//------------------------------------------------------------------------------
+static void output_text (const itti_trace_record_t * const record, const uint8_t * const payload, const bool hexdump)
+{
+  fprintf (stdout, "%" PRIu64 ".%09" PRIu64 " #%-8" PRIu64 " %-20s -> %-20s %s (%u bytes)\n",
+      record->timestamp_ns / 1000000000, record->timestamp_ns % 1000000000, record->message_number,
+      task_name (record->origin_task_id), task_name (record->destination_task_id), message_name (record->message_id), record->payload_size);
+  if (hexdump) {
+    for (uint32_t i = 0; i < record->payload_size; i++) {
+      fprintf (stdout, "%s%02x", (0 == (i % 16)) ? "    ":" ", payload[i]);
+      if ((15 == (i % 16)) || ((i + 1) == record->payload_size)) fputc ('\n', stdout);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void output_pcap (FILE * const pcap, const itti_trace_record_t * const record, const uint8_t * const payload)
+{
+  pcap_record_header_t  pcap_record;
+
+  pcap_record.ts_sec   = (uint32_t)(record->timestamp_ns / 1000000000);
+  pcap_record.ts_nsec  = (uint32_t)(record->timestamp_ns % 1000000000);
+  pcap_record.incl_len = sizeof (itti_trace_record_t) + record->payload_size;
+  pcap_record.orig_len = pcap_record.incl_len;
+  fwrite (&pcap_record, sizeof (pcap_record), 1, pcap);
+  fwrite (record, sizeof (itti_trace_record_t), 1, pcap);
+  fwrite (payload, record->payload_size, 1, pcap);
+}
+
+//------------------------------------------------------------------------------
+static int select_by_name (const char * const names, const uint32_t num_names, const char * const name, bool * const selected)
+{
+  for (uint32_t i = 0; i < num_names; i++) {
+    if (!strcmp (name, &names[i * ITTI_TRACE_NAME_LENGTH])) {
+      selected[i] = true;
+      return 0;
+    }
+  }
+  fprintf (stderr, "Unknown name %s\n", name);
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+static void usage (const char * const exe)
+{
+  fprintf (stderr, "Usage: %s [-f] [-x] [-t task_name]... [-m message_name]... [-p out.pcap] trace_file\n"
+      "  -f  follow the trace (tail) instead of exiting at its end\n"
+      "  -x  hexdump the messages\n"
+      "  -t  only messages sent or received by this task (TASK_S1AP, ...)\n"
+      "  -m  only messages with this id (S11_CREATE_SESSION_REQUEST, ...)\n"
+      "  -p  write the selected records in a pcap file (link type USER0) instead of text\n", exe);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  const char  *tasks[ITTI_TRACE_READER_MAX_FILTERS];
+  const char  *messages[ITTI_TRACE_READER_MAX_FILTERS];
+  int          num_tasks = 0, num_messages = 0;
+  bool         follow = false, hexdump = false;
+  FILE        *pcap = NULL;
+  int          c;
+
+  while ((c = getopt (argc, argv, "fxt:m:p:h")) != -1) {
+    switch (c) {
+    case 'f': follow  = true; break;
+    case 'x': hexdump = true; break;
+    case 't': if (num_tasks < ITTI_TRACE_READER_MAX_FILTERS) tasks[num_tasks++] = optarg; break;
+    case 'm': if (num_messages < ITTI_TRACE_READER_MAX_FILTERS) messages[num_messages++] = optarg; break;
+    case 'p':
+      pcap = fopen (optarg, "wb");
+      if (!pcap) {
+        fprintf (stderr, "Cannot open %s: %s\n", optarg, strerror (errno));
+        return EXIT_FAILURE;
+      }
+      break;
+    default: usage (argv[0]); return EXIT_FAILURE;
+    }
+  }
+  if (optind >= argc) {
+    usage (argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int fd = open (argv[optind], O_RDONLY);
+  struct stat st;
+  if ((0 > fd) || fstat (fd, &st) || (st.st_size < (off_t)sizeof (itti_trace_file_header_t))) {
+    fprintf (stderr, "Cannot open trace file %s\n", argv[optind]);
+    return EXIT_FAILURE;
+  }
+  const uint8_t * map = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (MAP_FAILED == map) {
+    fprintf (stderr, "Cannot map trace file %s: %s\n", argv[optind], strerror (errno));
+    return EXIT_FAILURE;
+  }
+  header = (const itti_trace_file_header_t *)map;
+  if ((ITTI_TRACE_MAGIC != header->magic) || (ITTI_TRACE_VERSION != header->version) ||
+      ((header->ring_offset + header->ring_size) > (uint64_t)st.st_size) || (header->ring_size & (header->ring_size - 1))) {
+    fprintf (stderr, "%s is not an ITTI trace file\n", argv[optind]);
+    return EXIT_FAILURE;
+  }
+  ring          = map + header->ring_offset;
+  task_names    = (const char *)&header[1];
+  message_names = task_names + header->num_tasks * ITTI_TRACE_NAME_LENGTH;
+  for (int i = 0; i < num_tasks; i++) {
+    if (select_by_name (task_names, header->num_tasks, tasks[i], task_selected)) return EXIT_FAILURE;
+    task_filter_set = true;
+  }
+  for (int i = 0; i < num_messages; i++) {
+    if (select_by_name (message_names, header->num_messages, messages[i], message_selected)) return EXIT_FAILURE;
+    message_filter_set = true;
+  }
+  if (pcap) {
+    pcap_file_header_t pcap_header = {PCAP_MAGIC_NANOSECONDS, 2, 4, 0, 0, header->ring_size / 4, PCAP_LINKTYPE_USER0};
+    fwrite (&pcap_header, sizeof (pcap_header), 1, pcap);
+  }
+
+  uint8_t            *payload = malloc (header->ring_size / 4);
+  itti_trace_record_t record;
+  uint64_t            offset = resync (0);
+  uint64_t            lost = 0;
+
+  while (payload) {
+    const uint64_t head = __atomic_load_n (&header->head, __ATOMIC_ACQUIRE);
+    if (offset >= head) {
+      if (!follow) break;
+      if (pcap) fflush (pcap);
+      fflush (stdout);
+      usleep (10000);
+      continue;
+    }
+    if ((head - offset) > header->ring_size) {
+      // overwritten before read
+      const uint64_t next = resync (offset);
+      lost += next - offset;
+      offset = next;
+      continue;
+    }
+    if (load_offset_field (offset) != offset) {
+      if (follow) {
+        // record being written
+        usleep (100);
+        continue;
+      }
+      // writer stopped in the middle of the record
+      const uint64_t next = resync (offset + ITTI_TRACE_RECORD_ALIGN);
+      lost += next - offset;
+      offset = next;
+      continue;
+    }
+    copy_from_ring (offset, &record, sizeof (record));
+    if (is_record_header_valid (&record)) {
+      copy_from_ring (offset + sizeof (record), payload, record.payload_size);
+    }
+    __atomic_thread_fence (__ATOMIC_ACQUIRE);
+    if ((!is_record_header_valid (&record)) || (load_offset_field (offset) != offset) ||
+        (__atomic_load_n (&header->head, __ATOMIC_ACQUIRE) > (offset + header->ring_size))) {
+      // overwritten while read
+      const uint64_t next = resync (offset + ITTI_TRACE_RECORD_ALIGN);
+      lost += next - offset;
+      offset = next;
+      continue;
+    }
+    offset += record.size;
+    if ((task_filter_set) && (!task_selected[record.origin_task_id]) && (!task_selected[record.destination_task_id])) continue;
+    if ((message_filter_set) && (!message_selected[record.message_id])) continue;
+    if (pcap) {
+      output_pcap (pcap, &record, payload);
+    } else {
+      output_text (&record, payload, hexdump);
+    }
+  }
+  if (lost) {
+    fprintf (stderr, "%" PRIu64 " bytes of trace overwritten before being read\n", lost);
+  }
+  if (header->dropped) {
+    fprintf (stderr, "%" PRIu64 " messages too large for the ring were not traced\n", header->dropped);
+  }
+  if (pcap) fclose (pcap);
+  free (payload);
+  munmap ((void *)map, st.st_size);
+  close (fd);
+  return EXIT_SUCCESS;
+}
@@ -373,6 +373,7 @@ void itti_free_msg_content (MessageDef * const message_p)
   case SCTP_DATA_REQ:
     bdestroy_wrapper (&message_p->ittiMsg.sctp_data_req.payload);
     AssertFatal(NULL == message_p->ittiMsg.sctp_data_req.payload, "TODO clean pointer");
+    shared_buffer_unref (&message_p->ittiMsg.sctp_data_req.shared_payload);
     break;
 
   case SCTP_DATA_IND:
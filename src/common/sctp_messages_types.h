@@ -29,6 +29,8 @@
 #ifndef FILE_SCTP_MESSAGES_TYPES_SEEN
 #define FILE_SCTP_MESSAGES_TYPES_SEEN
 
+#include "shared_buffer.h"
+
 #define SCTP_DATA_IND(mSGpTR)           (mSGpTR)->ittiMsg.sctp_data_ind
 #define SCTP_DATA_REQ(mSGpTR)           (mSGpTR)->ittiMsg.sctp_data_req
 #define SCTP_DATA_CNF(mSGpTR)           (mSGpTR)->ittiMsg.sctp_data_cnf
@@ -52,6 +54,7 @@ typedef struct sctp_data_cnf_s {
 
 typedef struct sctp_data_req_s {
   bstring          payload;
+  shared_buffer_t *shared_payload; // if not NULL, sent instead of payload (one reference owned by the message)
   sctp_assoc_id_t  assoc_id;
   sctp_stream_id_t stream;
   uint32_t         mme_ue_s1ap_id; // for helping data_rej
@@ -35,6 +35,7 @@
 #include "bstrlib.h"
 
 #include "log.h"
+#include "async_system.h"
 #include "common_defs.h"
 #include "gtp_mod_kernel.h"
 #include "common_types.h"
@@ -107,7 +108,7 @@ int gtp_mod_kernel_init(int *fd0, int *fd1u, struct in_addr *ue_net, int mask, i
   OAILOG_NOTICE (LOG_GTPV1U, "Using the GTP kernel mode (genl ID is %d)\n", gtp_nl.genl_id);
 
   bstring system_cmd = bformat ("ip link set dev %s mtu %u", GTP_DEVNAME, gtp_dev_mtu);
-  int ret = system ((const char *)system_cmd->data);
+  int ret = async_system_exec (bdata(system_cmd));
   if (ret) {
     OAILOG_ERROR (LOG_GTPV1U, "ERROR in system command %s: %d at %s:%u\n", bdata(system_cmd), ret, __FILE__, __LINE__);
     bdestroy_wrapper (&system_cmd);
@@ -118,7 +119,7 @@ int gtp_mod_kernel_init(int *fd0, int *fd1u, struct in_addr *ue_net, int mask, i
   struct in_addr ue_gw;
   ue_gw.s_addr = ue_net->s_addr | htonl(1);
   system_cmd = bformat ("ip addr add %s/%u dev %s", inet_ntoa(ue_gw), mask, GTP_DEVNAME);
-  ret = system ((const char *)system_cmd->data);
+  ret = async_system_exec (bdata(system_cmd));
   if (ret) {
     OAILOG_ERROR (LOG_GTPV1U, "ERROR in system command %s: %d at %s:%u\n", bdata(system_cmd), ret, __FILE__, __LINE__);
     bdestroy_wrapper (&system_cmd);
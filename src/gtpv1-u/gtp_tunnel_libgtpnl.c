@@ -32,6 +32,7 @@
 #include <errno.h>
 
 #include "log.h"
+#include "async_system.h"
 #include "common_defs.h"
 #include "gtpv1u.h"
 #include "gtpv1u_sgw_defs.h"
@@ -101,7 +102,7 @@ int libgtpnl_init(struct in_addr *ue_net, struct in_addr *ue_netmask, int mtu, i
   OAILOG_NOTICE (LOG_GTPV1U, "Using the GTP kernel mode (genl ID is %d)\n", gtp_nl.genl_id);
 
   bstring system_cmd = bformat ("ip link set dev %s mtu %u", GTP_DEVNAME, mtu);
-  int ret = system ((const char *)system_cmd->data);
+  int ret = async_system_exec (bdata(system_cmd));
   if (ret) {
     OAILOG_ERROR (LOG_GTPV1U, "ERROR in system command %s: %d at %s:%u\n", bdata(system_cmd), ret, __FILE__, __LINE__);
     bdestroy(system_cmd);
@@ -112,7 +113,7 @@ int libgtpnl_init(struct in_addr *ue_net, struct in_addr *ue_netmask, int mtu, i
   struct in_addr ue_gw;
   ue_gw.s_addr = ue_net->s_addr | htonl(1);
   system_cmd = bformat ("ip addr add %s/%u dev %s", inet_ntoa(ue_gw), mask, GTP_DEVNAME);
-  ret = system ((const char *)system_cmd->data);
+  ret = async_system_exec (bdata(system_cmd));
   if (ret) {
     OAILOG_ERROR (LOG_GTPV1U, "ERROR in system command %s: %d at %s:%u\n", bdata(system_cmd), ret, __FILE__, __LINE__);
     bdestroy(system_cmd);
@@ -144,8 +145,8 @@ int libgtpnl_uninit(void)
 int libgtpnl_reset(void)
 {
   int rv = 0;
-  rv = system ("rmmod gtp");
-  rv = system ("modprobe gtp");
+  rv = async_system_exec ("rmmod gtp");
+  rv = async_system_exec ("modprobe gtp");
   return rv;
 }
 
@@ -0,0 +1,406 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file gtp_tunnel_libgtpnl_batch.c
+  \brief Asynchronous programming of the kernel GTP tunnels, see gtp_tunnel_libgtpnl_batch.h.
+*/
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <linux/genetlink.h>
+#include <linux/gtp.h>
+
+#include <libgtpnl/gtp.h>
+#include <libgtpnl/gtpnl.h>
+#include <libmnl/libmnl.h>
+
+#include "log.h"
+#include "common_defs.h"
+#include "gtp_tunnel_libgtpnl_batch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// GTPA_BEARER_ID of the kernel patched for dedicated bearers (build/tools/libgtpnl.LTE_dedicated_bearer.v0.patch),
+// the upstream headers do not know it
+#define GTPNL_BATCH_GTPA_BEARER_ID   (GTPA_O_TEI + 1)
+// netlink header + genetlink header + at most 7 u32 attributes
+#define GTPNL_BATCH_MAX_MSG_SIZE     128
+#define GTPNL_BATCH_ACK_TIMEOUT_SEC  2
+
+static struct {
+  pthread_mutex_t        lock;
+  pthread_cond_t         cond;              ///< jobs queued, or terminate
+  pthread_cond_t         cond_done;         ///< a batch completed
+  gtpnl_batch_job_t      queue[GTPNL_BATCH_QUEUE_SIZE];
+  uint32_t               head;
+  uint32_t               num_queued;
+  uint64_t               num_submitted;     ///< jobs queued since init
+  uint64_t               num_completed;     ///< jobs completed since init
+  uint64_t               num_rejected;      ///< jobs refused on a full queue since init
+  bool                   is_running;
+  bool                   terminate;
+  pthread_t              thread;
+
+  // owned by the batch thread
+  struct mnl_socket     *nl;
+  int                    genl_id;
+  uint32_t               ifindex;
+  uint32_t               seq;
+  gtpnl_batch_done_cb_t  done_cb;
+  void                  *done_cb_arg;
+  char                   tx_buf[GTPNL_BATCH_MAX_JOBS * GTPNL_BATCH_MAX_MSG_SIZE];
+  char                   rx_buf[MNL_SOCKET_BUFFER_SIZE];
+} gtpnl_batch = {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER, .cond_done = PTHREAD_COND_INITIALIZER};
+
+//------------------------------------------------------------------------------
+static void gtpnl_batch_build_msg (char * const buf, const gtpnl_batch_job_t * const job, const uint32_t seq, const bool ack)
+{
+  struct nlmsghdr *nlh = NULL;
+  uint16_t         flags = (ack) ? NLM_F_ACK : 0;
+
+  if (GTPNL_BATCH_ADD_TUNNEL == job->op) {
+    nlh = genl_nlmsg_build_hdr (buf, gtpnl_batch.genl_id, flags | NLM_F_EXCL, seq, GTP_CMD_NEWPDP);
+  } else {
+    nlh = genl_nlmsg_build_hdr (buf, gtpnl_batch.genl_id, flags, seq, GTP_CMD_DELPDP);
+  }
+  // same attributes as gtp_add_tunnel()/gtp_del_tunnel() of libgtpnl
+  mnl_attr_put_u32 (nlh, GTPA_VERSION, GTP_V1);
+  mnl_attr_put_u32 (nlh, GTPA_LINK, gtpnl_batch.ifindex);
+  if (job->enb.s_addr) {
+    mnl_attr_put_u32 (nlh, GTPA_SGSN_ADDRESS, job->enb.s_addr);
+  }
+  if (job->ue.s_addr) {
+    mnl_attr_put_u32 (nlh, GTPA_MS_ADDRESS, job->ue.s_addr);
+  }
+  mnl_attr_put_u32 (nlh, GTPA_I_TEI, job->i_tei);
+  mnl_attr_put_u32 (nlh, GTPA_O_TEI, job->o_tei);
+  if (GTPNL_BATCH_ADD_TUNNEL == job->op) {
+    mnl_attr_put_u32 (nlh, GTPNL_BATCH_GTPA_BEARER_ID, job->bearer_id);
+  }
+}
+
+//------------------------------------------------------------------------------
+static int gtpnl_batch_get_o_tei_cb (const struct nlattr *attr, void *data)
+{
+  if (GTPA_O_TEI == mnl_attr_get_type (attr)) {
+    *(uint32_t *)data = mnl_attr_get_u32 (attr);
+  }
+  return MNL_CB_OK;
+}
+
+//------------------------------------------------------------------------------
+// Looks the tunnel of a job up in the kernel by its incoming TEID: returns 0 and its outgoing TEID if it exists,
+// -ENOENT if it does not, another -errno if the kernel could not be asked.
+static int gtpnl_batch_get_tunnel (const gtpnl_batch_job_t * const job, uint32_t * const o_tei)
+{
+  const uint32_t   seq = gtpnl_batch.seq++;
+  struct nlmsghdr *nlh = genl_nlmsg_build_hdr (gtpnl_batch.tx_buf, gtpnl_batch.genl_id, 0, seq, GTP_CMD_GETPDP);
+
+  mnl_attr_put_u32 (nlh, GTPA_VERSION, GTP_V1);
+  mnl_attr_put_u32 (nlh, GTPA_LINK, gtpnl_batch.ifindex);
+  mnl_attr_put_u32 (nlh, GTPA_I_TEI, job->i_tei);
+  if (mnl_socket_sendto (gtpnl_batch.nl, nlh, nlh->nlmsg_len) < 0) {
+    return -errno;
+  }
+  while (true) {
+    int rx_length = mnl_socket_recvfrom (gtpnl_batch.nl, gtpnl_batch.rx_buf, sizeof (gtpnl_batch.rx_buf));
+
+    if (rx_length < 0) {
+      if ((EINTR == errno) || (ENOBUFS == errno)) {
+        continue;
+      }
+      return -errno;
+    }
+    for (nlh = (struct nlmsghdr *)gtpnl_batch.rx_buf; mnl_nlmsg_ok (nlh, rx_length); nlh = mnl_nlmsg_next (nlh, &rx_length)) {
+      // late ACKs of the batch
+      if (seq != nlh->nlmsg_seq) {
+        continue;
+      }
+      if (NLMSG_ERROR == nlh->nlmsg_type) {
+        return ((const struct nlmsgerr *)mnl_nlmsg_get_payload (nlh))->error;
+      }
+      *o_tei = 0;
+      mnl_attr_parse (nlh, sizeof (struct genlmsghdr), gtpnl_batch_get_o_tei_cb, o_tei);
+      return 0;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Some ACKs of the batch were lost (receive buffer overrun or timeout): the status of the jobs that were not
+// acknowledged is read back from the kernel. The kernel state only tells the outcome of the last job of a TEID in
+// the batch, the earlier jobs of the same TEID, and the jobs that cannot be checked, are failed.
+static void gtpnl_batch_requery (gtpnl_batch_job_t * const jobs, const int num_jobs, const bool * const is_acked)
+{
+  int num_failed = 0;
+
+  for (int i = 0; i < num_jobs; i++) {
+    uint32_t o_tei = 0;
+    int      rc = 0;
+    bool     is_overridden = false;
+
+    if (is_acked[i]) {
+      continue;
+    }
+    for (int j = i + 1; (j < num_jobs) && (!is_overridden); j++) {
+      is_overridden = (jobs[j].i_tei == jobs[i].i_tei);
+    }
+    if (is_overridden) {
+      jobs[i].status = -ENOBUFS;
+    } else if (GTPNL_BATCH_ADD_TUNNEL == jobs[i].op) {
+      rc = gtpnl_batch_get_tunnel (&jobs[i], &o_tei);
+      jobs[i].status = ((!rc) && (o_tei == jobs[i].o_tei)) ? 0 : -ENOBUFS;
+    } else {
+      rc = gtpnl_batch_get_tunnel (&jobs[i], &o_tei);
+      jobs[i].status = (-ENOENT == rc) ? 0 : -ENOBUFS;
+    }
+    num_failed += (jobs[i].status) ? 1 : 0;
+  }
+  OAILOG_WARNING (LOG_GTPV1U, "GTP tunnel ACKs lost, %d of %d requests re-queried as failed\n", num_failed, num_jobs);
+}
+
+//------------------------------------------------------------------------------
+// The kernel processes the messages of a datagram in order and always acknowledges the failed ones, so only the
+// last message asks for an ACK: once it is received, every job without an error ACK succeeded, unless some ACKs
+// were lost on the way.
+static void gtpnl_batch_run (gtpnl_batch_job_t * const jobs, const int num_jobs)
+{
+  const uint32_t  seq = gtpnl_batch.seq;
+  size_t          length = 0;
+  bool            is_last_acked = false;
+  bool            are_acks_lost = false;
+  bool            is_acked[GTPNL_BATCH_MAX_JOBS] = {false};
+
+  gtpnl_batch.seq += num_jobs;
+  for (int i = 0; i < num_jobs; i++) {
+    struct nlmsghdr *nlh = (struct nlmsghdr *)&gtpnl_batch.tx_buf[length];
+
+    gtpnl_batch_build_msg ((char *)nlh, &jobs[i], seq + i, (num_jobs - 1) == i);
+    length += NLMSG_ALIGN (nlh->nlmsg_len);
+    jobs[i].status = 0;
+  }
+
+  if (mnl_socket_sendto (gtpnl_batch.nl, gtpnl_batch.tx_buf, length) < 0) {
+    const int error = -errno;
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot send %d GTP tunnel requests: %s\n", num_jobs, strerror (errno));
+    for (int i = 0; i < num_jobs; i++) {
+      jobs[i].status = error;
+    }
+    return;
+  }
+
+  while (!is_last_acked) {
+    int rx_length = mnl_socket_recvfrom (gtpnl_batch.nl, gtpnl_batch.rx_buf, sizeof (gtpnl_batch.rx_buf));
+
+    if (rx_length < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      if (ENOBUFS == errno) {
+        // error ACKs were dropped, the jobs without an ACK are checked once the batch is over
+        are_acks_lost = true;
+        continue;
+      }
+      OAILOG_ERROR (LOG_GTPV1U, "No ACK for %d GTP tunnel requests: %s\n", num_jobs, strerror (errno));
+      are_acks_lost = true;
+      break;
+    }
+    for (const struct nlmsghdr *nlh = (const struct nlmsghdr *)gtpnl_batch.rx_buf; mnl_nlmsg_ok (nlh, rx_length);
+         nlh = mnl_nlmsg_next (nlh, &rx_length)) {
+      const uint32_t         index = nlh->nlmsg_seq - seq;
+      const struct nlmsgerr *err = (const struct nlmsgerr *)mnl_nlmsg_get_payload (nlh);
+
+      // stale ACK of a batch that timed out
+      if ((NLMSG_ERROR != nlh->nlmsg_type) || (index >= (uint32_t)num_jobs)) {
+        continue;
+      }
+      jobs[index].status = err->error;
+      is_acked[index] = true;
+      if ((num_jobs - 1) == index) {
+        is_last_acked = true;
+      }
+    }
+  }
+  if (are_acks_lost) {
+    gtpnl_batch_requery (jobs, num_jobs, is_acked);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void *gtpnl_batch_thread (__attribute__ ((unused)) void *args_p)
+{
+  gtpnl_batch_job_t jobs[GTPNL_BATCH_MAX_JOBS];
+
+  while (true) {
+    int num_jobs = 0;
+
+    // take the jobs that were queued while the previous batch was running
+    pthread_mutex_lock (&gtpnl_batch.lock);
+    while ((!gtpnl_batch.num_queued) && (!gtpnl_batch.terminate)) {
+      pthread_cond_wait (&gtpnl_batch.cond, &gtpnl_batch.lock);
+    }
+    if (!gtpnl_batch.num_queued) {
+      pthread_mutex_unlock (&gtpnl_batch.lock);
+      break;
+    }
+    while ((gtpnl_batch.num_queued) && (GTPNL_BATCH_MAX_JOBS > num_jobs)) {
+      jobs[num_jobs++] = gtpnl_batch.queue[gtpnl_batch.head];
+      gtpnl_batch.head = (gtpnl_batch.head + 1) % GTPNL_BATCH_QUEUE_SIZE;
+      gtpnl_batch.num_queued -= 1;
+    }
+    pthread_mutex_unlock (&gtpnl_batch.lock);
+
+    gtpnl_batch_run (jobs, num_jobs);
+    if (gtpnl_batch.done_cb) {
+      gtpnl_batch.done_cb (jobs, num_jobs, gtpnl_batch.done_cb_arg);
+    }
+
+    pthread_mutex_lock (&gtpnl_batch.lock);
+    gtpnl_batch.num_completed += num_jobs;
+    pthread_cond_broadcast (&gtpnl_batch.cond_done);
+    pthread_mutex_unlock (&gtpnl_batch.lock);
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+// Never blocks the caller (the SPGW application task): a job that does not fit in the queue is refused.
+static int gtpnl_batch_submit (const gtpnl_batch_job_t * const job)
+{
+  pthread_mutex_lock (&gtpnl_batch.lock);
+  if ((!gtpnl_batch.is_running) || (gtpnl_batch.terminate)) {
+    pthread_mutex_unlock (&gtpnl_batch.lock);
+    return RETURNerror;
+  }
+  if (GTPNL_BATCH_QUEUE_SIZE == gtpnl_batch.num_queued) {
+    const uint64_t num_rejected = ++gtpnl_batch.num_rejected;
+
+    pthread_mutex_unlock (&gtpnl_batch.lock);
+    OAILOG_WARNING (LOG_GTPV1U, "GTP tunnel batch queue full, request refused (%" PRIu64 " refused since init)\n", num_rejected);
+    return RETURNerror;
+  }
+  gtpnl_batch.queue[(gtpnl_batch.head + gtpnl_batch.num_queued) % GTPNL_BATCH_QUEUE_SIZE] = *job;
+  gtpnl_batch.num_queued += 1;
+  gtpnl_batch.num_submitted += 1;
+  pthread_cond_signal (&gtpnl_batch.cond);
+  pthread_mutex_unlock (&gtpnl_batch.lock);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int gtpnl_batch_add_tunnel (struct in_addr ue, struct in_addr enb, uint32_t i_tei, uint32_t o_tei, uint8_t bearer_id)
+{
+  gtpnl_batch_job_t job = {.op = GTPNL_BATCH_ADD_TUNNEL, .ue = ue, .enb = enb, .i_tei = i_tei, .o_tei = o_tei, .bearer_id = bearer_id};
+
+  return gtpnl_batch_submit (&job);
+}
+
+//------------------------------------------------------------------------------
+int gtpnl_batch_del_tunnel (struct in_addr ue, uint32_t i_tei, uint32_t o_tei)
+{
+  // looking at kernel/drivers/net/gtp.c: the UE address is not needed to delete a tunnel
+  gtpnl_batch_job_t job = {.op = GTPNL_BATCH_DEL_TUNNEL, .i_tei = i_tei, .o_tei = o_tei};
+
+  return gtpnl_batch_submit (&job);
+}
+
+//------------------------------------------------------------------------------
+void gtpnl_batch_wait_idle (void)
+{
+  pthread_mutex_lock (&gtpnl_batch.lock);
+  const uint64_t num_submitted = gtpnl_batch.num_submitted;
+  while ((gtpnl_batch.is_running) && (gtpnl_batch.num_completed < num_submitted)) {
+    pthread_cond_wait (&gtpnl_batch.cond_done, &gtpnl_batch.lock);
+  }
+  pthread_mutex_unlock (&gtpnl_batch.lock);
+}
+
+//------------------------------------------------------------------------------
+int gtpnl_batch_init (const int genl_id, const uint32_t ifindex, gtpnl_batch_done_cb_t done_cb, void *arg)
+{
+  struct timeval timeout = {.tv_sec = GTPNL_BATCH_ACK_TIMEOUT_SEC, .tv_usec = 0};
+
+  gtpnl_batch.nl = genl_socket_open ();
+  if (!gtpnl_batch.nl) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot create genetlink socket for GTP tunnel batches\n");
+    return RETURNerror;
+  }
+  // a lost ACK must not block the tunnel programming forever
+  setsockopt (mnl_socket_get_fd (gtpnl_batch.nl), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+
+  gtpnl_batch.genl_id       = genl_id;
+  gtpnl_batch.ifindex       = ifindex;
+  gtpnl_batch.seq           = time (NULL);
+  gtpnl_batch.done_cb       = done_cb;
+  gtpnl_batch.done_cb_arg   = arg;
+  gtpnl_batch.head          = 0;
+  gtpnl_batch.num_queued    = 0;
+  gtpnl_batch.terminate     = false;
+
+  if (pthread_create (&gtpnl_batch.thread, NULL, gtpnl_batch_thread, NULL)) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot create GTP tunnel batch thread\n");
+    mnl_socket_close (gtpnl_batch.nl);
+    gtpnl_batch.nl = NULL;
+    return RETURNerror;
+  }
+  pthread_mutex_lock (&gtpnl_batch.lock);
+  gtpnl_batch.is_running = true;
+  pthread_mutex_unlock (&gtpnl_batch.lock);
+  OAILOG_DEBUG (LOG_GTPV1U, "GTP tunnel batch thread started (genl ID %d, ifindex %u)\n", genl_id, ifindex);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void gtpnl_batch_exit (void)
+{
+  pthread_mutex_lock (&gtpnl_batch.lock);
+  if (!gtpnl_batch.is_running) {
+    pthread_mutex_unlock (&gtpnl_batch.lock);
+    return;
+  }
+  gtpnl_batch.terminate = true;
+  pthread_cond_signal (&gtpnl_batch.cond);
+  pthread_mutex_unlock (&gtpnl_batch.lock);
+
+  pthread_join (gtpnl_batch.thread, NULL);
+
+  pthread_mutex_lock (&gtpnl_batch.lock);
+  gtpnl_batch.is_running = false;
+  pthread_cond_broadcast (&gtpnl_batch.cond_done);
+  pthread_mutex_unlock (&gtpnl_batch.lock);
+  mnl_socket_close (gtpnl_batch.nl);
+  gtpnl_batch.nl = NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
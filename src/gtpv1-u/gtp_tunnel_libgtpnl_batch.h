@@ -0,0 +1,76 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file gtp_tunnel_libgtpnl_batch.h
+  \brief Asynchronous programming of the kernel GTP tunnels.
+  \ A dedicated thread owns its own genetlink socket. The tunnel additions and deletions queued while the previous
+  \ batch was in flight are packed into a single netlink datagram, executed by the kernel in queuing order, and
+  \ handed back in one completion call per batch. Only the failures and the last request of a batch are acknowledged
+  \ by the kernel, the ACKs are matched to the requests by sequence number. When ACKs are lost, the requests that
+  \ were not acknowledged are checked against the kernel state.
+*/
+#ifndef FILE_GTP_TUNNEL_LIBGTPNL_BATCH_SEEN
+#define FILE_GTP_TUNNEL_LIBGTPNL_BATCH_SEEN
+
+#include <stdint.h>
+#include <netinet/in.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GTPNL_BATCH_MAX_JOBS     128     ///< requests per netlink datagram
+#define GTPNL_BATCH_QUEUE_SIZE   8192    ///< requests waiting for the thread, the requests are refused beyond
+
+typedef enum {
+  GTPNL_BATCH_ADD_TUNNEL = 1,
+  GTPNL_BATCH_DEL_TUNNEL,
+} gtpnl_batch_op_t;
+
+typedef struct gtpnl_batch_job_s {
+  gtpnl_batch_op_t   op;
+  struct in_addr     ue;
+  struct in_addr     enb;
+  uint32_t           i_tei;
+  uint32_t           o_tei;
+  uint8_t            bearer_id;
+  int                status;        ///< set on completion: 0 or -errno returned by the kernel
+} gtpnl_batch_job_t;
+
+/* Called on the batch thread once the kernel processed a batch, the jobs are in queuing order */
+typedef void (*gtpnl_batch_done_cb_t)(const gtpnl_batch_job_t * const jobs, const int num_jobs, void *arg);
+
+int  gtpnl_batch_init (const int genl_id, const uint32_t ifindex, gtpnl_batch_done_cb_t done_cb, void *arg);
+/* Executes the jobs still queued, then stops the thread */
+void gtpnl_batch_exit (void);
+
+/* Queue a request, return RETURNerror without blocking if the queue is full */
+int  gtpnl_batch_add_tunnel (struct in_addr ue, struct in_addr enb, uint32_t i_tei, uint32_t o_tei, uint8_t bearer_id);
+int  gtpnl_batch_del_tunnel (struct in_addr ue, uint32_t i_tei, uint32_t o_tei);
+
+/* Returns once every job queued before the call has been completed */
+void gtpnl_batch_wait_idle (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FILE_GTP_TUNNEL_LIBGTPNL_BATCH_SEEN */
@@ -23,8 +23,11 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/types.h>
+#include <time.h>
 #include <arpa/inet.h>
 #include <net/if.h>
+#include <linux/genetlink.h>
+#include <linux/gtp.h>
 
 #include <libgtpnl/gtp.h>
 #include <libgtpnl/gtpnl.h>
@@ -32,9 +35,14 @@
 #include <errno.h>
 
 #include "log.h"
+#include "assertions.h"
+#include "intertask_interface.h"
+#include "async_system.h"
 #include "common_defs.h"
 #include "gtpv1u.h"
 #include "gtpv1u_sgw_defs.h"
+#include "gtpv1_u_messages_types.h"
+#include "gtp_tunnel_libgtpnl_batch.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -51,6 +59,39 @@ static struct {
 
 #define GTP_DEVNAME "gtp0"
 
+//------------------------------------------------------------------------------
+// Tunnel additions are reported to the SPGW application (buffered downlink packets are delivered once the kernel
+// path exists), deletions only when they failed
+static void libgtpnl_batch_done(const gtpnl_batch_job_t * const jobs, const int num_jobs, __attribute__ ((unused)) void *arg)
+{
+  MessageDef               *message_p = NULL;
+  Gtpv1uTunnelBatchResult  *batch_result = NULL;
+
+  AssertFatal(GTPV1U_TUNNEL_BATCH_MAX_RESULTS >= GTPNL_BATCH_MAX_JOBS, "Tunnel batch result too small");
+  for (int i = 0; i < num_jobs; i++) {
+    if ((GTPNL_BATCH_DEL_TUNNEL == jobs[i].op) && (!jobs[i].status))
+      continue;
+    if (!message_p) {
+      message_p = itti_alloc_new_message_sized (TASK_GTPV1_U, GTPV1U_TUNNEL_BATCH_RESULT, sizeof (Gtpv1uTunnelBatchResult));
+      if (!message_p)
+        return;
+      batch_result = GTPV1U_TUNNEL_BATCH_RESULT(message_p);
+      batch_result->num_results = 0;
+    }
+    gtpv1u_tunnel_result_t *result = &batch_result->results[batch_result->num_results++];
+    result->is_add        = (GTPNL_BATCH_ADD_TUNNEL == jobs[i].op);
+    result->eps_bearer_id = jobs[i].bearer_id;
+    result->ue_ip         = jobs[i].ue;
+    result->enb_ip        = jobs[i].enb;
+    result->sgw_S1u_teid  = jobs[i].i_tei;
+    result->enb_S1u_teid  = jobs[i].o_tei;
+    result->status        = jobs[i].status;
+  }
+  if (message_p) {
+    itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+  }
+}
+
 int libgtpnl_init(struct in_addr *ue_net, struct in_addr *ue_netmask, int mtu, int *fd0, int *fd1u)
 {
   // we don't need GTP v0, but interface with kernel requires 2 file descriptors
@@ -100,8 +141,13 @@ int libgtpnl_init(struct in_addr *ue_net, struct in_addr *ue_netmask, int mtu, i
   }
   OAILOG_NOTICE (LOG_GTPV1U, "Using the GTP kernel mode (genl ID is %d)\n", gtp_nl.genl_id);
 
+  // tunnels are programmed by batches on a dedicated thread, off the SPGW application
+  if (gtpnl_batch_init(gtp_nl.genl_id, if_nametoindex(GTP_DEVNAME), libgtpnl_batch_done, NULL) < 0) {
+    return RETURNerror;
+  }
+
   bstring system_cmd = bformat ("ip link set dev %s mtu %u", GTP_DEVNAME, mtu);
-  int ret = system ((const char *)system_cmd->data);
+  int ret = async_system_exec (bdata(system_cmd));
   if (ret) {
     OAILOG_ERROR (LOG_GTPV1U, "ERROR in system command %s: %d at %s:%u\n", bdata(system_cmd), ret, __FILE__, __LINE__);
     bdestroy(system_cmd);
@@ -112,7 +158,7 @@ int libgtpnl_init(struct in_addr *ue_net, struct in_addr *ue_netmask, int mtu, i
   struct in_addr ue_gw;
   ue_gw.s_addr = ue_net->s_addr | htonl(1);
   system_cmd = bformat ("ip addr add %s/%u dev %s", inet_ntoa(ue_gw), mask, GTP_DEVNAME);
-  ret = system ((const char *)system_cmd->data);
+  ret = async_system_exec (bdata(system_cmd));
   if (ret) {
     OAILOG_ERROR (LOG_GTPV1U, "ERROR in system command %s: %d at %s:%u\n", bdata(system_cmd), ret, __FILE__, __LINE__);
     bdestroy(system_cmd);
@@ -138,66 +184,99 @@ int libgtpnl_uninit(void)
   if (!gtp_nl.is_enabled)
     return -1;
 
+  gtpnl_batch_exit();
   return gtp_dev_destroy(GTP_DEVNAME);
 }
 
 int libgtpnl_reset(void)
 {
   int rv = 0;
-  rv = system ("modprobe --remove gtp");
-  rv = system ("modprobe gtp");
+  // No module reload: it would flush every GTP device of the host, only our device is recreated.
+  rv = async_system_exec ("modprobe gtp");
+  // A device left by a previous run lost its UDP sockets with the process, it cannot carry traffic anymore.
+  if (if_nametoindex(GTP_DEVNAME)) {
+    if (gtp_dev_destroy(GTP_DEVNAME) < 0) {
+      OAILOG_WARNING (LOG_GTPV1U, "Cannot remove stale GTP tunnel device %s: %s\n", GTP_DEVNAME, strerror(errno));
+    } else {
+      OAILOG_NOTICE (LOG_GTPV1U, "Removed stale GTP tunnel device %s\n", GTP_DEVNAME);
+    }
+  }
   return rv;
 }
 
+// Queued, the result is reported by a GTPV1U_TUNNEL_BATCH_RESULT
 int libgtpnl_add_tunnel(struct in_addr ue, struct in_addr enb, uint32_t i_tei, uint32_t o_tei, uint8_t bearer_id){
-  struct gtp_tunnel *t;
-  int ret;
+  if (!gtp_nl.is_enabled)
+    return RETURNok;
+
+  return gtpnl_batch_add_tunnel(ue, enb, i_tei, o_tei, bearer_id);
+}
 
+int libgtpnl_del_tunnel(struct in_addr ue, uint32_t i_tei, uint32_t o_tei)
+{
   if (!gtp_nl.is_enabled)
     return RETURNok;
 
-  t = gtp_tunnel_alloc();
-  if (t == NULL)
-    return RETURNerror;
+  return gtpnl_batch_del_tunnel(ue, i_tei, o_tei);
+}
 
+typedef struct libgtpnl_dump_s {
+  gtp_tunnel_cb_t     cb;
+  void               *arg;
+  uint32_t            ifindex;
+} libgtpnl_dump_t;
 
-  gtp_tunnel_set_ifidx(t, if_nametoindex(GTP_DEVNAME));
-  gtp_tunnel_set_version(t, 1);
-  gtp_tunnel_set_ms_ip4(t, &ue);
-  gtp_tunnel_set_sgsn_ip4(t, &enb);
-  gtp_tunnel_set_i_tei(t, i_tei);
-  gtp_tunnel_set_o_tei(t, o_tei);
-  gtp_tunnel_set_bearer_id(t, bearer_id);
+static int libgtpnl_dump_attr_cb(const struct nlattr *attr, void *data)
+{
+  const struct nlattr **tb = data;
 
-  ret = gtp_add_tunnel(gtp_nl.genl_id, gtp_nl.nl, t);
-  gtp_tunnel_free(t);
+  if (mnl_attr_type_valid(attr, GTPA_MAX) < 0)
+    return MNL_CB_OK;
+  tb[mnl_attr_get_type(attr)] = attr;
+  return MNL_CB_OK;
+}
 
-  return ret;
+static int libgtpnl_dump_cb(const struct nlmsghdr *nlh, void *data)
+{
+  libgtpnl_dump_t    *dump = (libgtpnl_dump_t *)data;
+  struct nlattr      *tb[GTPA_MAX + 1] = {NULL};
+  struct in_addr      ue = {.s_addr = 0};
+  struct in_addr      enb = {.s_addr = 0};
+
+  mnl_attr_parse(nlh, sizeof(struct genlmsghdr), libgtpnl_dump_attr_cb, tb);
+
+  // other GTP devices of the host, and GTPv0 PDP contexts
+  if ((tb[GTPA_LINK]) && (mnl_attr_get_u32(tb[GTPA_LINK]) != dump->ifindex))
+    return MNL_CB_OK;
+  if ((!tb[GTPA_I_TEI]) || (!tb[GTPA_O_TEI]))
+    return MNL_CB_OK;
+
+  if (tb[GTPA_MS_ADDRESS])
+    ue.s_addr = mnl_attr_get_u32(tb[GTPA_MS_ADDRESS]);
+  if (tb[GTPA_SGSN_ADDRESS])
+    enb.s_addr = mnl_attr_get_u32(tb[GTPA_SGSN_ADDRESS]);
+  dump->cb(ue, enb, mnl_attr_get_u32(tb[GTPA_I_TEI]), mnl_attr_get_u32(tb[GTPA_O_TEI]), dump->arg);
+  return MNL_CB_OK;
 }
 
-int libgtpnl_del_tunnel(struct in_addr ue, uint32_t i_tei, uint32_t o_tei)
+int libgtpnl_list_tunnels(gtp_tunnel_cb_t cb, void *arg)
 {
-  struct gtp_tunnel *t;
-  int ret;
+  char                buf[MNL_SOCKET_BUFFER_SIZE];
+  struct nlmsghdr    *nlh;
+  uint32_t            seq = time(NULL);
+  libgtpnl_dump_t     dump = {.cb = cb, .arg = arg, .ifindex = if_nametoindex(GTP_DEVNAME)};
 
   if (!gtp_nl.is_enabled)
     return RETURNok;
 
-  t = gtp_tunnel_alloc();
-  if (t == NULL)
+  // the dump must reflect the tunnels already requested
+  gtpnl_batch_wait_idle();
+  nlh = genl_nlmsg_build_hdr(buf, gtp_nl.genl_id, NLM_F_DUMP, seq, GTP_CMD_GETPDP);
+  if (genl_socket_talk(gtp_nl.nl, nlh, seq, libgtpnl_dump_cb, &dump) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot dump GTP tunnels of %s: %s\n", GTP_DEVNAME, strerror(errno));
     return RETURNerror;
-
-  gtp_tunnel_set_ifidx(t, if_nametoindex(GTP_DEVNAME));
-  gtp_tunnel_set_version(t, 1);
-  // looking at kernel/drivers/net/gtp.c: not needed gtp_tunnel_set_ms_ip4(t, &ue);
-  // looking at kernel/drivers/net/gtp.c: not needed gtp_tunnel_set_sgsn_ip4(t, &enb);
-  gtp_tunnel_set_i_tei(t, i_tei);
-  gtp_tunnel_set_o_tei(t, o_tei);
-
-  ret = gtp_del_tunnel(gtp_nl.genl_id, gtp_nl.nl, t);
-  gtp_tunnel_free(t);
-
-  return ret;
+  }
+  return RETURNok;
 }
 
 static const struct gtp_tunnel_ops libgtpnl_ops = {
@@ -206,6 +285,7 @@ static const struct gtp_tunnel_ops libgtpnl_ops = {
   .reset        = libgtpnl_reset,
   .add_tunnel   = libgtpnl_add_tunnel,
   .del_tunnel   = libgtpnl_del_tunnel,
+  .list_tunnels = libgtpnl_list_tunnels,
 };
 
 const struct gtp_tunnel_ops *gtp_tunnel_ops_init(void) {
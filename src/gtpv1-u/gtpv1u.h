@@ -70,13 +70,23 @@ extern "C" {
  *         @i_tei: RX GTP Tunnel ID
  *         @o_tei: TX GTP Tunnel ID.
  *         @imsi: UE IMSI
+ *     The kernel backend only queues the request, its result is reported
+ *     to TASK_SPGW_APP by a GTPV1U_TUNNEL_BATCH_RESULT.
  *
  * int (*del_tunnel)(uint32_t i_tei, uint32_t o_tei);
  *     Delete a gtp tunnel.
  *         @ue: UE IP address
  *         @i_tei: RX GTP Tunnel ID
  *         @o_tei: TX GTP Tunnel ID.
+ *
+ * int (*list_tunnels)(gtp_tunnel_cb_t cb, void *arg);
+ *     Dump the gtp tunnels currently programmed in the data plane, cb is
+ *     called once per tunnel. Used to resynchronize the data plane with the
+ *     sessions restored at startup, a null hook means the data plane content
+ *     is unknown and all the tunnels of the restored sessions are (re)added.
  */
+typedef void (*gtp_tunnel_cb_t)(struct in_addr ue, struct in_addr enb, uint32_t i_tei, uint32_t o_tei, void *arg);
+
 struct gtp_tunnel_ops {
   int  (*init)(struct in_addr *ue_net, struct in_addr *ue_netmask, int mtu, int *fd0, int *fd1u);
   int  (*uninit)(void);
@@ -93,6 +103,7 @@ struct gtp_tunnel_ops {
   int  (*add_tunnel)(struct in_addr ue, struct in_addr enb, uint32_t i_tei, uint32_t o_tei, imsi_t imsi);
   int  (*del_tunnel)(struct in_addr ue, uint32_t i_tei, uint32_t o_tei);
 #endif
+  int  (*list_tunnels)(gtp_tunnel_cb_t cb, void *arg);
 };
 
 uint32_t gtpv1u_new_teid(void);
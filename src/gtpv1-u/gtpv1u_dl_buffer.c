@@ -0,0 +1,661 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file gtpv1u_dl_buffer.c
+  \brief Downlink packet buffering for UEs in ECM-IDLE.
+  \date 2018
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#include "bstrlib.h"
+#include "queue.h"
+
+#include "dynamic_memory_check.h"
+#include "log.h"
+#include "assertions.h"
+#include "conversions.h"
+#include "hashtable.h"
+#include "common_types.h"
+#include "common_defs.h"
+#include "intertask_interface.h"
+#include "gtpv1_u_messages_types.h"
+#include "timer.h"
+#include "gtpv1u_sgw_defs.h"
+#include "pgw_pcef_classifier.h"
+#include "pgw_pcef_emulation.h"
+#include "gtpv1u_dl_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Mandatory part of the GTPv1-U header, no sequence number nor extension */
+#define GTPV1U_HEADER_LENGTH          8
+#define GTPV1U_FLAGS_V1_GTP           0x30
+#define GTPV1U_MSG_TYPE_G_PDU         0xFF
+
+/* ((priority level << 1) | vulnerable), the higher the class the sooner its packets are evicted */
+#define GTPV1U_DL_BUFFER_ARP_CLASSES  32
+
+typedef struct gtpv1u_dl_packet_s {
+  STAILQ_ENTRY(gtpv1u_dl_packet_s) entries;
+  uint64_t                         arrival_ms;
+  uint32_t                         length;    ///< IP packet length
+  uint8_t                          data[];    ///< GTPV1U_HEADER_LENGTH bytes of headroom then the IP packet
+} gtpv1u_dl_packet_t;
+
+typedef struct gtpv1u_dl_buffer_bearer_s {
+  struct in_addr                   ue;
+  ebi_t                            ebi;
+  int                              arp_class;
+  bool                             forwarding;  ///< tunnel restored, late punted packets go straight to the eNB
+  struct in_addr                   enb;
+  teid_t                           enb_teid;
+  uint64_t                         notified_ms; ///< last downlink data notification of this buffering period, 0 if none
+  uint32_t                         nb_packets;
+  uint32_t                         nb_bytes;
+  STAILQ_HEAD(gtpv1u_dl_packets_s, gtpv1u_dl_packet_s) packets;
+  TAILQ_ENTRY(gtpv1u_dl_buffer_bearer_s) arp_entries; ///< linked in arp_classes while packets are queued
+} gtpv1u_dl_buffer_bearer_t;
+
+typedef struct gtpv1u_dl_buffer_s {
+  pthread_mutex_t                  mutex;
+  bool                             enabled;
+  int                              tun_fd;
+  int                              fd1u;
+  bstring                          if_name;
+  int                              if_index;
+  int                              nl_fd;       ///< rtnetlink socket programming the UE routes, mutex held
+  uint32_t                         nl_seq;
+  uint32_t                         max_packets_per_bearer;
+  uint64_t                         max_bytes;
+  uint32_t                         packet_ttl_ms;
+  uint64_t                         nb_bytes;
+  long                             timer_id;
+  hash_table_t                    *bearers;
+  TAILQ_HEAD(gtpv1u_dl_buffer_arp_class_s, gtpv1u_dl_buffer_bearer_s) arp_classes[GTPV1U_DL_BUFFER_ARP_CLASSES];
+  uint64_t                         nb_evicted;
+  uint64_t                         nb_expired;
+  uint64_t                         nb_flushed;
+} gtpv1u_dl_buffer_t;
+
+static gtpv1u_dl_buffer_t  dl_buffer = {.mutex = PTHREAD_MUTEX_INITIALIZER, .enabled = false, .tun_fd = -1, .fd1u = -1, .nl_fd = -1};
+
+/* Only read by the GTPV1U task */
+static uint8_t             tun_read_buffer[GTPV1U_HEADER_LENGTH + GTPV1U_DL_BUFFER_MAX_PACKET_SIZE];
+
+//------------------------------------------------------------------------------
+static uint64_t gtpv1u_dl_buffer_now_ms (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+//------------------------------------------------------------------------------
+static inline int gtpv1u_dl_buffer_arp_class (const bearer_qos_t * const qos)
+{
+  return ((qos->pl & 0x0F) << 1) | (PRE_EMPTION_VULNERABILITY_ENABLED == qos->pvi ? 1 : 0);
+}
+
+//------------------------------------------------------------------------------
+static void gtpv1u_dl_buffer_drop_head (gtpv1u_dl_buffer_bearer_t * const bearer)
+{
+  gtpv1u_dl_packet_t *packet = STAILQ_FIRST (&bearer->packets);
+
+  if (packet) {
+    STAILQ_REMOVE_HEAD (&bearer->packets, entries);
+    bearer->nb_packets -= 1;
+    bearer->nb_bytes   -= packet->length;
+    dl_buffer.nb_bytes -= packet->length;
+    free_wrapper ((void**)&packet);
+    if (!bearer->nb_packets) {
+      TAILQ_REMOVE (&dl_buffer.arp_classes[bearer->arp_class], bearer, arp_entries);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void gtpv1u_dl_buffer_purge (gtpv1u_dl_buffer_bearer_t * const bearer)
+{
+  while (bearer->nb_packets) {
+    gtpv1u_dl_buffer_drop_head (bearer);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void gtpv1u_dl_buffer_free_bearer (void **bearer)
+{
+  if (bearer && *bearer) {
+    gtpv1u_dl_buffer_purge ((gtpv1u_dl_buffer_bearer_t *)*bearer);
+    free_wrapper (bearer);
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Evict packets from the bearers with the lowest ARP until length bytes fit under the memory cap. A bearer never
+ * pre-empts a bearer of a higher ARP, in that case the incoming packet is the one dropped.
+ */
+static bool gtpv1u_dl_buffer_make_room (const gtpv1u_dl_buffer_bearer_t * const bearer, const uint32_t length)
+{
+  while ((dl_buffer.nb_bytes + length) > dl_buffer.max_bytes) {
+    int arp_class = GTPV1U_DL_BUFFER_ARP_CLASSES - 1;
+
+    while ((arp_class >= bearer->arp_class) && TAILQ_EMPTY (&dl_buffer.arp_classes[arp_class])) {
+      arp_class--;
+    }
+    if (arp_class < bearer->arp_class) {
+      return false;
+    }
+
+    gtpv1u_dl_buffer_bearer_t *victim = TAILQ_FIRST (&dl_buffer.arp_classes[arp_class]);
+
+    gtpv1u_dl_buffer_drop_head (victim);
+    dl_buffer.nb_evicted += 1;
+    // spread the evictions over the bearers of the same class
+    if (victim->nb_packets) {
+      TAILQ_REMOVE (&dl_buffer.arp_classes[arp_class], victim, arp_entries);
+      TAILQ_INSERT_TAIL (&dl_buffer.arp_classes[arp_class], victim, arp_entries);
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static int gtpv1u_dl_buffer_send (const gtpv1u_dl_buffer_bearer_t * const bearer, uint8_t * const gtpu, const uint32_t length)
+{
+  struct sockaddr_in  peer = {0};
+
+  gtpu[0] = GTPV1U_FLAGS_V1_GTP;
+  gtpu[1] = GTPV1U_MSG_TYPE_G_PDU;
+  gtpu[2] = (uint8_t)(length >> 8);
+  gtpu[3] = (uint8_t)length;
+  gtpu[4] = (uint8_t)(bearer->enb_teid >> 24);
+  gtpu[5] = (uint8_t)(bearer->enb_teid >> 16);
+  gtpu[6] = (uint8_t)(bearer->enb_teid >> 8);
+  gtpu[7] = (uint8_t)bearer->enb_teid;
+
+  peer.sin_family = AF_INET;
+  peer.sin_port   = htons (GTPV1U_UDP_PORT);
+  peer.sin_addr   = bearer->enb;
+
+  if (sendto (dl_buffer.fd1u, gtpu, GTPV1U_HEADER_LENGTH + length, 0, (struct sockaddr *)&peer, sizeof (peer)) < 0) {
+    OAILOG_WARNING (LOG_GTPV1U, "Failed to send buffered packet to eNB " IN_ADDR_FMT " teid " TEID_FMT ": %s\n",
+        PRI_IN_ADDR (bearer->enb), bearer->enb_teid, strerror (errno));
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void gtpv1u_dl_buffer_notify (const struct in_addr ue, const ebi_t ebi, const sdf_id_t sdf_id)
+{
+  MessageDef *message_p = itti_alloc_new_message_sized (TASK_GTPV1_U, GTPV1U_DOWNLINK_DATA_NOTIFICATION, sizeof (Gtpv1uDownlinkDataNotification));
+
+  if (message_p) {
+    GTPV1U_DOWNLINK_DATA_NOTIFICATION (message_p)->ue_ip = ue;
+    GTPV1U_DOWNLINK_DATA_NOTIFICATION (message_p)->eps_bearer_id = ebi;
+    GTPV1U_DOWNLINK_DATA_NOTIFICATION (message_p)->sdf_id = sdf_id;
+    itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Add (RTM_NEWROUTE) or remove (RTM_DELROUTE) the /32 route of a UE on the TUN device, as "ip route replace|del" would,
+ * and wait for the kernel acknowledgement: the route changes of a UE are applied in the order of the calls. Mutex held.
+ */
+static int gtpv1u_dl_buffer_route (const uint16_t type, const struct in_addr ue)
+{
+  struct {
+    struct nlmsghdr  nlh;
+    struct rtmsg     rtm;
+    char             attrs[RTA_SPACE (sizeof (uint32_t)) + RTA_SPACE (sizeof (int))];
+  } req;
+  char               ack[512] __attribute__ ((aligned (NLMSG_ALIGNTO)));
+  struct rtattr     *rta = NULL;
+
+  memset (&req, 0, sizeof (req));
+  req.nlh.nlmsg_len    = NLMSG_LENGTH (sizeof (struct rtmsg));
+  req.nlh.nlmsg_type   = type;
+  req.nlh.nlmsg_flags  = NLM_F_REQUEST | NLM_F_ACK;
+  req.nlh.nlmsg_seq    = ++dl_buffer.nl_seq;
+  req.rtm.rtm_family   = AF_INET;
+  req.rtm.rtm_dst_len  = 32;
+  req.rtm.rtm_table    = RT_TABLE_MAIN;
+  if (RTM_NEWROUTE == type) {
+    req.nlh.nlmsg_flags |= NLM_F_CREATE | NLM_F_REPLACE;
+    req.rtm.rtm_protocol = RTPROT_BOOT;
+    req.rtm.rtm_scope    = RT_SCOPE_LINK;
+    req.rtm.rtm_type     = RTN_UNICAST;
+  } else {
+    req.rtm.rtm_scope    = RT_SCOPE_NOWHERE;
+  }
+  rta = (struct rtattr *)(((char *)&req) + NLMSG_ALIGN (req.nlh.nlmsg_len));
+  rta->rta_type = RTA_DST;
+  rta->rta_len  = RTA_LENGTH (sizeof (uint32_t));
+  memcpy (RTA_DATA (rta), &ue.s_addr, sizeof (uint32_t));
+  req.nlh.nlmsg_len = NLMSG_ALIGN (req.nlh.nlmsg_len) + RTA_ALIGN (rta->rta_len);
+  rta = (struct rtattr *)(((char *)&req) + req.nlh.nlmsg_len);
+  rta->rta_type = RTA_OIF;
+  rta->rta_len  = RTA_LENGTH (sizeof (int));
+  memcpy (RTA_DATA (rta), &dl_buffer.if_index, sizeof (int));
+  req.nlh.nlmsg_len += RTA_ALIGN (rta->rta_len);
+
+  if (send (dl_buffer.nl_fd, &req, req.nlh.nlmsg_len, 0) < 0) {
+    OAILOG_WARNING (LOG_GTPV1U, "Failed to send route %s for UE " IN_ADDR_FMT ": %s\n",
+        (RTM_NEWROUTE == type) ? "replace":"del", PRI_IN_ADDR (ue), strerror (errno));
+    return RETURNerror;
+  }
+  for (;;) {
+    ssize_t          length = recv (dl_buffer.nl_fd, ack, sizeof (ack), 0);
+    struct nlmsghdr *nlh = (struct nlmsghdr *)ack;
+
+    if (0 > length) {
+      if (EINTR == errno) {
+        continue;
+      }
+      OAILOG_WARNING (LOG_GTPV1U, "No acknowledgement of route %s for UE " IN_ADDR_FMT ": %s\n",
+          (RTM_NEWROUTE == type) ? "replace":"del", PRI_IN_ADDR (ue), strerror (errno));
+      return RETURNerror;
+    }
+    for (; NLMSG_OK (nlh, length); nlh = NLMSG_NEXT (nlh, length)) {
+      if ((NLMSG_ERROR != nlh->nlmsg_type) || (nlh->nlmsg_seq != req.nlh.nlmsg_seq)) {
+        // acknowledgement of a request that timed out
+        continue;
+      }
+      const int error = -((struct nlmsgerr *)NLMSG_DATA (nlh))->error;
+
+      // route already removed
+      if ((error) && (!((RTM_DELROUTE == type) && ((ESRCH == error) || (ENOENT == error))))) {
+        OAILOG_WARNING (LOG_GTPV1U, "Failed to %s route of UE " IN_ADDR_FMT " on %s: %s\n",
+            (RTM_NEWROUTE == type) ? "replace":"del", PRI_IN_ADDR (ue), bdata (dl_buffer.if_name), strerror (error));
+        return RETURNerror;
+      }
+      return RETURNok;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Set the MTU of the TUN device and bring it up before any UE route is added on it.
+static int gtpv1u_dl_buffer_link_up (struct ifreq * const ifr, const int mtu)
+{
+  int sock = socket (AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  int rc = RETURNerror;
+
+  if (0 > sock) {
+    OAILOG_ERROR (LOG_GTPV1U, "Failed to open a socket to configure %s: %s\n", ifr->ifr_name, strerror (errno));
+    return RETURNerror;
+  }
+  ifr->ifr_mtu = mtu;
+  if (ioctl (sock, SIOCSIFMTU, ifr) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Failed to set MTU %d on %s: %s\n", mtu, ifr->ifr_name, strerror (errno));
+  } else if (ioctl (sock, SIOCGIFFLAGS, ifr) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Failed to get flags of %s: %s\n", ifr->ifr_name, strerror (errno));
+  } else {
+    ifr->ifr_flags |= IFF_UP;
+    if (ioctl (sock, SIOCSIFFLAGS, ifr) < 0) {
+      OAILOG_ERROR (LOG_GTPV1U, "Failed to bring %s up: %s\n", ifr->ifr_name, strerror (errno));
+    } else {
+      rc = RETURNok;
+    }
+  }
+  close (sock);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+int gtpv1u_dl_buffer_init (const spgw_config_t * const spgw_config, const int fd1u)
+{
+  struct ifreq  ifr = {0};
+
+  if (!spgw_config->sgw_config.dl_buffering.enabled) {
+    OAILOG_INFO (LOG_GTPV1U, "Downlink buffering disabled\n");
+    return RETURNok;
+  }
+  if (0 >= fd1u) {
+    OAILOG_WARNING (LOG_GTPV1U, "Downlink buffering needs the GTP-U kernel socket, disabled\n");
+    return RETURNok;
+  }
+
+  dl_buffer.tun_fd = open ("/dev/net/tun", O_RDWR | O_NONBLOCK);
+  if (0 > dl_buffer.tun_fd) {
+    OAILOG_ERROR (LOG_GTPV1U, "Failed to open /dev/net/tun: %s\n", strerror (errno));
+    return RETURNerror;
+  }
+  ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+  strncpy (ifr.ifr_name, bdata (spgw_config->sgw_config.dl_buffering.if_name), IFNAMSIZ - 1);
+  if (ioctl (dl_buffer.tun_fd, TUNSETIFF, &ifr) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Failed to create TUN device %s: %s\n", ifr.ifr_name, strerror (errno));
+    close (dl_buffer.tun_fd);
+    dl_buffer.tun_fd = -1;
+    return RETURNerror;
+  }
+
+  dl_buffer.if_index = if_nametoindex (ifr.ifr_name);
+  dl_buffer.nl_fd    = socket (AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+  if ((!dl_buffer.if_index) || (0 > dl_buffer.nl_fd) || (RETURNok != gtpv1u_dl_buffer_link_up (&ifr, spgw_config->pgw_config.ipv4.mtu_SGI))) {
+    OAILOG_ERROR (LOG_GTPV1U, "Failed to set up the routing to TUN device %s: %s\n", ifr.ifr_name, strerror (errno));
+    if (0 <= dl_buffer.nl_fd) {
+      close (dl_buffer.nl_fd);
+      dl_buffer.nl_fd = -1;
+    }
+    close (dl_buffer.tun_fd);
+    dl_buffer.tun_fd = -1;
+    return RETURNerror;
+  }
+  struct timeval tv = {.tv_sec = 1, .tv_usec = 0};
+  setsockopt (dl_buffer.nl_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof (tv));
+
+  dl_buffer.fd1u                   = fd1u;
+  dl_buffer.if_name                = bfromcstr (ifr.ifr_name);
+  dl_buffer.max_packets_per_bearer = spgw_config->sgw_config.dl_buffering.max_packets_per_bearer;
+  dl_buffer.max_bytes              = (uint64_t)spgw_config->sgw_config.dl_buffering.max_kbytes * 1024;
+  dl_buffer.packet_ttl_ms          = spgw_config->sgw_config.dl_buffering.packet_ttl_ms;
+  dl_buffer.nb_bytes               = 0;
+  for (int i = 0; i < GTPV1U_DL_BUFFER_ARP_CLASSES; i++) {
+    TAILQ_INIT (&dl_buffer.arp_classes[i]);
+  }
+  bstring b = bfromcstr ("gtpv1u_dl_buffer_bearers");
+  dl_buffer.bearers = hashtable_create (1024, NULL, gtpv1u_dl_buffer_free_bearer, b);
+  bdestroy_wrapper (&b);
+
+  if (timer_setup (0, GTPV1U_DL_BUFFER_TICK_MS * 1000, TASK_GTPV1_U, INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &dl_buffer.timer_id) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Failed to start the downlink buffering timer\n");
+    dl_buffer.timer_id = 0;
+  }
+
+  dl_buffer.enabled = true;
+  OAILOG_INFO (LOG_GTPV1U, "Downlink buffering on %s, %u packets per bearer, %u KB, TTL %u ms\n",
+      ifr.ifr_name, dl_buffer.max_packets_per_bearer, spgw_config->sgw_config.dl_buffering.max_kbytes, dl_buffer.packet_ttl_ms);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void gtpv1u_dl_buffer_exit (void)
+{
+  if (!dl_buffer.enabled) {
+    return;
+  }
+  if (dl_buffer.timer_id) {
+    timer_remove (dl_buffer.timer_id, NULL);
+    dl_buffer.timer_id = 0;
+  }
+  pthread_mutex_lock (&dl_buffer.mutex);
+  dl_buffer.enabled = false;
+  hashtable_destroy (dl_buffer.bearers);
+  dl_buffer.bearers = NULL;
+  close (dl_buffer.tun_fd);
+  dl_buffer.tun_fd = -1;
+  close (dl_buffer.nl_fd);
+  dl_buffer.nl_fd = -1;
+  bdestroy_wrapper (&dl_buffer.if_name);
+  pthread_mutex_unlock (&dl_buffer.mutex);
+}
+
+//------------------------------------------------------------------------------
+int gtpv1u_dl_buffer_fd (void)
+{
+  return dl_buffer.enabled ? dl_buffer.tun_fd : -1;
+}
+
+//------------------------------------------------------------------------------
+static void gtpv1u_dl_buffer_enqueue (uint8_t * const gtpu, const uint32_t length)
+{
+  gtpv1u_dl_buffer_bearer_t *bearer = NULL;
+  const uint8_t             *ip = &gtpu[GTPV1U_HEADER_LENGTH];
+  struct in_addr             ue = {.s_addr = 0};
+  bool                       notify = false;
+
+  if ((20 > length) || (4 != (ip[0] >> 4))) {
+    OAILOG_TRACE (LOG_GTPV1U, "Dropping non IPv4 downlink packet of %u bytes\n", length);
+    return;
+  }
+  memcpy (&ue.s_addr, &ip[16], sizeof (ue.s_addr));
+
+  pthread_mutex_lock (&dl_buffer.mutex);
+  if (HASH_TABLE_OK != hashtable_get (dl_buffer.bearers, (hash_key_t)ue.s_addr, (void **)&bearer)) {
+    pthread_mutex_unlock (&dl_buffer.mutex);
+    OAILOG_TRACE (LOG_GTPV1U, "Dropping downlink packet for UE " IN_ADDR_FMT ", not buffering\n", PRI_IN_ADDR (ue));
+    return;
+  }
+
+  if (bearer->forwarding) {
+    // route not yet removed after the tunnel was restored
+    gtpv1u_dl_buffer_send (bearer, gtpu, length);
+    pthread_mutex_unlock (&dl_buffer.mutex);
+    return;
+  }
+
+  if (bearer->nb_packets >= dl_buffer.max_packets_per_bearer) {
+    gtpv1u_dl_buffer_drop_head (bearer);
+    dl_buffer.nb_evicted += 1;
+  }
+  if (!gtpv1u_dl_buffer_make_room (bearer, length)) {
+    dl_buffer.nb_evicted += 1;
+    pthread_mutex_unlock (&dl_buffer.mutex);
+    OAILOG_DEBUG (LOG_GTPV1U, "Downlink buffer full, dropping packet for UE " IN_ADDR_FMT "\n", PRI_IN_ADDR (ue));
+    return;
+  }
+
+  gtpv1u_dl_packet_t *packet = malloc (sizeof (*packet) + GTPV1U_HEADER_LENGTH + length);
+
+  if (packet) {
+    packet->arrival_ms = gtpv1u_dl_buffer_now_ms ();
+    packet->length     = length;
+    memcpy (&packet->data[GTPV1U_HEADER_LENGTH], ip, length);
+    if (!bearer->nb_packets) {
+      TAILQ_INSERT_TAIL (&dl_buffer.arp_classes[bearer->arp_class], bearer, arp_entries);
+    }
+    STAILQ_INSERT_TAIL (&bearer->packets, packet, entries);
+    bearer->nb_packets += 1;
+    bearer->nb_bytes   += length;
+    dl_buffer.nb_bytes += length;
+    if (!bearer->notified_ms) {
+      bearer->notified_ms = packet->arrival_ms;
+      notify = true;
+    }
+  }
+  ebi_t ebi = bearer->ebi;
+  pthread_mutex_unlock (&dl_buffer.mutex);
+
+  if (notify) {
+    pcef_flow_key_t flow_key;
+    sdf_id_t        sdf_id = (sdf_id_t)PCEF_CLASSIFIER_NO_MATCH;
+
+    // the SPGW application notifies on the bearer carrying the SDF of the packet
+    if (RETURNok == pcef_classifier_ipv4_packet_2_flow_key (ip, length, TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY, &flow_key)) {
+      sdf_id = pgw_pcef_emulation_classify (TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY, &flow_key);
+    }
+    OAILOG_DEBUG (LOG_GTPV1U, "First downlink packet buffered for UE " IN_ADDR_FMT " ebi %u sdf %u\n", PRI_IN_ADDR (ue), ebi, sdf_id);
+    gtpv1u_dl_buffer_notify (ue, ebi, sdf_id);
+  }
+}
+
+//------------------------------------------------------------------------------
+void gtpv1u_dl_buffer_read (void)
+{
+  ssize_t length = 0;
+
+  if (!dl_buffer.enabled) {
+    return;
+  }
+  while ((length = read (dl_buffer.tun_fd, &tun_read_buffer[GTPV1U_HEADER_LENGTH], GTPV1U_DL_BUFFER_MAX_PACKET_SIZE)) > 0) {
+    gtpv1u_dl_buffer_enqueue (tun_read_buffer, (uint32_t)length);
+  }
+  if ((0 > length) && (EAGAIN != errno) && (EWOULDBLOCK != errno)) {
+    OAILOG_ERROR (LOG_GTPV1U, "Failed to read from %s: %s\n", bdata (dl_buffer.if_name), strerror (errno));
+  }
+}
+
+//------------------------------------------------------------------------------
+bool gtpv1u_dl_buffer_handle_timer_expiry (const long timer_id)
+{
+  if (!dl_buffer.enabled || (timer_id != dl_buffer.timer_id)) {
+    return false;
+  }
+
+  const uint64_t now_ms = gtpv1u_dl_buffer_now_ms ();
+
+  pthread_mutex_lock (&dl_buffer.mutex);
+  // only bearers holding packets are linked in the ARP classes
+  for (int arp_class = 0; arp_class < GTPV1U_DL_BUFFER_ARP_CLASSES; arp_class++) {
+    gtpv1u_dl_buffer_bearer_t *bearer = TAILQ_FIRST (&dl_buffer.arp_classes[arp_class]);
+
+    while (bearer) {
+      gtpv1u_dl_buffer_bearer_t *next = TAILQ_NEXT (bearer, arp_entries);
+      gtpv1u_dl_packet_t        *packet = NULL;
+
+      while ((packet = STAILQ_FIRST (&bearer->packets)) && ((now_ms - packet->arrival_ms) >= dl_buffer.packet_ttl_ms)) {
+        gtpv1u_dl_buffer_drop_head (bearer);
+        dl_buffer.nb_expired += 1;
+      }
+      if (!bearer->nb_packets) {
+        // nothing left to deliver, a new packet starts a new notification
+        bearer->notified_ms = 0;
+      } else if ((now_ms - bearer->notified_ms) >= GTPV1U_DL_BUFFER_RENOTIFY_MS) {
+        // still waiting for the UE, the SPGW app coalesces or retries the S11 notification
+        bearer->notified_ms = now_ms;
+        gtpv1u_dl_buffer_notify (bearer->ue, bearer->ebi, (sdf_id_t)PCEF_CLASSIFIER_NO_MATCH);
+      }
+      bearer = next;
+    }
+  }
+  pthread_mutex_unlock (&dl_buffer.mutex);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+int gtpv1u_dl_buffer_start (const struct in_addr ue, const ebi_t ebi, const bearer_qos_t * const qos)
+{
+  gtpv1u_dl_buffer_bearer_t *bearer = NULL;
+
+  if (!dl_buffer.enabled) {
+    return RETURNok;
+  }
+
+  pthread_mutex_lock (&dl_buffer.mutex);
+  if (HASH_TABLE_OK != hashtable_get (dl_buffer.bearers, (hash_key_t)ue.s_addr, (void **)&bearer)) {
+    bearer = calloc (1, sizeof (*bearer));
+    if (!bearer) {
+      pthread_mutex_unlock (&dl_buffer.mutex);
+      return RETURNerror;
+    }
+    bearer->ue = ue;
+    STAILQ_INIT (&bearer->packets);
+    hashtable_insert (dl_buffer.bearers, (hash_key_t)ue.s_addr, bearer);
+  }
+  if (bearer->nb_packets) {
+    TAILQ_REMOVE (&dl_buffer.arp_classes[bearer->arp_class], bearer, arp_entries);
+  }
+  bearer->ebi         = ebi;
+  bearer->arp_class   = gtpv1u_dl_buffer_arp_class (qos);
+  bearer->forwarding  = false;
+  bearer->notified_ms = 0;
+  bearer->enb.s_addr  = 0;
+  bearer->enb_teid    = INVALID_TEID;
+  if (bearer->nb_packets) {
+    TAILQ_INSERT_TAIL (&dl_buffer.arp_classes[bearer->arp_class], bearer, arp_entries);
+  }
+  // more specific than the UE pool route on the GTP device
+  gtpv1u_dl_buffer_route (RTM_NEWROUTE, ue);
+  pthread_mutex_unlock (&dl_buffer.mutex);
+
+  OAILOG_DEBUG (LOG_GTPV1U, "Start buffering downlink packets for UE " IN_ADDR_FMT " ebi %u\n", PRI_IN_ADDR (ue), ebi);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int gtpv1u_dl_buffer_flush (const struct in_addr ue, const struct in_addr enb, const teid_t enb_teid)
+{
+  gtpv1u_dl_buffer_bearer_t *bearer = NULL;
+  uint32_t                   nb_packets = 0;
+
+  if (!dl_buffer.enabled) {
+    return RETURNok;
+  }
+
+  pthread_mutex_lock (&dl_buffer.mutex);
+  if ((HASH_TABLE_OK != hashtable_get (dl_buffer.bearers, (hash_key_t)ue.s_addr, (void **)&bearer)) || (bearer->forwarding)) {
+    pthread_mutex_unlock (&dl_buffer.mutex);
+    return RETURNok;
+  }
+  bearer->forwarding = true;
+  bearer->enb        = enb;
+  bearer->enb_teid   = enb_teid;
+
+  // sent under the lock so that packets still punted before the route is removed stay in order
+  gtpv1u_dl_packet_t *packet = NULL;
+  while ((packet = STAILQ_FIRST (&bearer->packets))) {
+    gtpv1u_dl_buffer_send (bearer, packet->data, packet->length);
+    gtpv1u_dl_buffer_drop_head (bearer);
+    nb_packets += 1;
+  }
+  bearer->notified_ms = 0;
+  dl_buffer.nb_flushed += nb_packets;
+  gtpv1u_dl_buffer_route (RTM_DELROUTE, ue);
+  pthread_mutex_unlock (&dl_buffer.mutex);
+
+  OAILOG_DEBUG (LOG_GTPV1U, "Flushed %u buffered downlink packets for UE " IN_ADDR_FMT " to eNB " IN_ADDR_FMT " teid " TEID_FMT "\n",
+      nb_packets, PRI_IN_ADDR (ue), PRI_IN_ADDR (enb), enb_teid);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void gtpv1u_dl_buffer_stop (const struct in_addr ue)
+{
+  gtpv1u_dl_buffer_bearer_t *bearer = NULL;
+
+  if (!dl_buffer.enabled) {
+    return;
+  }
+
+  pthread_mutex_lock (&dl_buffer.mutex);
+  if (HASH_TABLE_OK == hashtable_remove (dl_buffer.bearers, (hash_key_t)ue.s_addr, (void **)&bearer)) {
+    if (!bearer->forwarding) {
+      gtpv1u_dl_buffer_route (RTM_DELROUTE, ue);
+    }
+    gtpv1u_dl_buffer_free_bearer ((void **)&bearer);
+  }
+  pthread_mutex_unlock (&dl_buffer.mutex);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,68 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file gtpv1u_dl_buffer.h
+  \brief Downlink packet buffering for UEs in ECM-IDLE.
+  \ When the S1-U tunnels of a UE are released, a /32 route for the UE address is pointed at a TUN device owned by the
+  \ GTPV1U task, so downlink packets that the kernel GTP device would otherwise drop are punted to user space. They
+  \ are queued per bearer (one S1-U tunnel per UE address on the kernel datapath) under a global memory cap, evicted
+  \ by ARP when the cap is reached and aged out after a TTL. The first packet of a buffering period triggers a
+  \ GTPV1U_DOWNLINK_DATA_NOTIFICATION, and on Modify Bearer Request the queue is encapsulated in GTP-U and sent to the
+  \ new eNB F-TEID before the route is removed.
+  \date 2018
+*/
+
+#ifndef FILE_GTPV1U_DL_BUFFER_SEEN
+#define FILE_GTPV1U_DL_BUFFER_SEEN
+
+#include <stdbool.h>
+#include <netinet/in.h>
+#include "3gpp_24.007.h"
+#include "3gpp_29.274.h"
+#include "common_types.h"
+#include "spgw_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GTPV1U_DL_BUFFER_TICK_MS          100
+#define GTPV1U_DL_BUFFER_RENOTIFY_MS      1000   ///< period of the notifications while packets wait for the UE
+#define GTPV1U_DL_BUFFER_MAX_PACKET_SIZE  9216
+
+int  gtpv1u_dl_buffer_init (const spgw_config_t * const spgw_config, const int fd1u);
+void gtpv1u_dl_buffer_exit (void);
+
+/* TUN file descriptor to be watched by the GTPV1U task, -1 if buffering is disabled */
+int  gtpv1u_dl_buffer_fd (void);
+void gtpv1u_dl_buffer_read (void);
+bool gtpv1u_dl_buffer_handle_timer_expiry (const long timer_id);
+
+/* Called by the SPGW application on Release Access Bearers, Modify Bearer and Delete Session */
+int  gtpv1u_dl_buffer_start (const struct in_addr ue, const ebi_t ebi, const bearer_qos_t * const qos);
+int  gtpv1u_dl_buffer_flush (const struct in_addr ue, const struct in_addr enb, const teid_t enb_teid);
+void gtpv1u_dl_buffer_stop (const struct in_addr ue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FILE_GTPV1U_DL_BUFFER_SEEN */
@@ -30,6 +30,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <sys/epoll.h>
 
 #include "bstrlib.h"
 #include "queue.h"
@@ -50,11 +51,13 @@
 #include "common_types.h"
 #include "common_defs.h"
 #include "intertask_interface.h"
+#include "timer_messages_types.h"
 #include "gtpv1u.h"
 #include "sgw_config.h"
 #include "pgw_config.h"
 #include "spgw_config.h"
 #include "gtpv1u_sgw_defs.h"
+#include "gtpv1u_dl_buffer.h"
 #include "ControllerMain.h"
 #include "async_system.h"
 #include "sgw.h"
@@ -69,35 +72,60 @@ const struct gtp_tunnel_ops *gtp_tunnel_ops;
 
 static void  *gtpv1u_thread (void *args)
 {
+  int                                     nb_events = 0;
+  struct epoll_event                     *events = NULL;
+
   itti_mark_task_ready (TASK_GTPV1_U);
 
   gtpv1u_data_t * gtpv1u_data = (gtpv1u_data_t*)args;
 
+  // Downlink packets of idle UEs are read from the buffering TUN device in this task.
+  if (gtpv1u_dl_buffer_fd () >= 0) {
+    itti_subscribe_event_fd (TASK_GTPV1_U, gtpv1u_dl_buffer_fd ());
+  }
+
   while (1) {
     /*
      * Trying to fetch a message from the message queue.
      * * * * If the queue is empty, this function will block till a
-     * * * * message is sent to the task.
+     * * * * message is sent to the task or an event occurs on a subscribed fd.
      */
     MessageDef                             *received_message_p = NULL;
 
     itti_receive_msg (TASK_GTPV1_U, &received_message_p);
-    DevAssert (received_message_p != NULL);
 
-    switch (ITTI_MSG_ID (received_message_p)) {
+    if (received_message_p != NULL) {
+      switch (ITTI_MSG_ID (received_message_p)) {
 
-    case TERMINATE_MESSAGE:
-      gtpv1u_exit (gtpv1u_data);
-      break;
+      case TERMINATE_MESSAGE:
+        gtpv1u_exit (gtpv1u_data);
+        break;
 
-    default:{
-        OAILOG_ERROR (LOG_GTPV1U , "Unkwnon message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+      case TIMER_HAS_EXPIRED:
+        if (!gtpv1u_dl_buffer_handle_timer_expiry (TIMER_HAS_EXPIRED (received_message_p)->timer_id)) {
+          OAILOG_WARNING (LOG_GTPV1U , "Unknown timer %ld expired\n", TIMER_HAS_EXPIRED (received_message_p)->timer_id);
+        }
+        break;
+
+      default:{
+          OAILOG_ERROR (LOG_GTPV1U , "Unkwnon message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+        }
+        break;
       }
-      break;
+
+      itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+      received_message_p = NULL;
     }
 
-    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
-    received_message_p = NULL;
+    nb_events = itti_get_events (TASK_GTPV1_U, &events);
+
+    if ((nb_events > 0) && (events != NULL)) {
+      for (int event = 0; event < nb_events; event++) {
+        if ((events[event].events != 0) && (events[event].data.fd == gtpv1u_dl_buffer_fd ())) {
+          gtpv1u_dl_buffer_read ();
+        }
+      }
+    }
   }
 
   return NULL;
@@ -138,8 +166,14 @@ int gtpv1u_init (spgw_config_t *spgw_config)
 
   // END-GTP quick integration only for evaluation purpose
 
+  // Needs the S1-U socket of the kernel datapath, done before the task subscribes to the TUN fd.
+  if (gtpv1u_dl_buffer_init (spgw_config, sgw_app.gtpv1u_data.fd1u) != RETURNok) {
+    OAILOG_WARNING (LOG_GTPV1U , "Downlink buffering for idle UEs not available\n");
+  }
+
   if (itti_create_task (TASK_GTPV1_U, &gtpv1u_thread, &sgw_app.gtpv1u_data) < 0) {
     OAILOG_ERROR (LOG_GTPV1U , "gtpv1u phtread_create: %s", strerror (errno));
+    gtpv1u_dl_buffer_exit ();
     gtp_tunnel_ops->uninit();
     return -1;
   }
@@ -173,6 +207,7 @@ void gtpv1u_exit (gtpv1u_data_t * const gtpv1u_data)
 //    OAILOG_ERROR (LOG_GTPV1U , "gtp_decaps1u thread wasn't canceled\n");
 //  }
 
+  gtpv1u_dl_buffer_exit ();
   gtp_tunnel_ops->uninit();
   // END-GTP quick integration only for evaluation purpose
   itti_exit_task ();
@@ -316,6 +316,7 @@ typedef struct nw_gtpv2c_rsp_failure_ind_info_s {
   NW_IN    uint8_t                           trx_flags;
 
   NW_IN    uint32_t                          teidLocal;
+  NW_IN    struct in_addr                    peerIp;      /**< Peer the request was sent to */
 } nw_gtpv2c_rsp_failure_ind_info_t;
 
 /**
@@ -119,6 +119,7 @@ extern                                  "C" {
       ulpApi.u_api_info.rspFailureInfo.msgType  = thiz->pMsg ? thiz->pMsg->msgType: 0;
       ulpApi.u_api_info.rspFailureInfo.hUlpTunnel = ((thiz->hTunnel) ? ((nw_gtpv2c_tunnel_t *) (thiz->hTunnel))->hUlpTunnel : 0);
       ulpApi.u_api_info.rspFailureInfo.teidLocal  = (thiz->hTunnel) ? ((nw_gtpv2c_tunnel_t*)(thiz->hTunnel))->teid: 0;
+      ulpApi.u_api_info.rspFailureInfo.peerIp     = thiz->peerIp;
       /** Set the flags. */
       ulpApi.u_api_info.rspFailureInfo.trx_flags  = thiz->trx_flags;
       OAILOG_ERROR (LOG_GTPV2C, "N3 retries expired for transaction %p\n", thiz);
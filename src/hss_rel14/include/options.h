@@ -58,6 +58,7 @@ public:
    static const unsigned &getcassmaxconnections()        { return m_cassmaxconnections; }
    static const unsigned &getcassioqueuesize()           { return m_cassioqueuesize; }
    static const unsigned &getcassiothreads()             { return m_cassiothreads; }
+   static const unsigned &getsubtemplatecache()          { return m_subtemplatecache; }
 
    static bool               getrandvector()             { return m_randvector; }
    static bool               getroamallow()              { return m_roamallow; }
@@ -142,6 +143,7 @@ private:
    static unsigned    m_cassmaxconnections;
    static unsigned    m_cassioqueuesize;
    static unsigned    m_cassiothreads;
+   static unsigned    m_subtemplatecache;
    static bool        m_randvector;
    static bool        m_roamallow;
    static std::string m_optkey;
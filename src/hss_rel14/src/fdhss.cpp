@@ -26,6 +26,7 @@
 #include "s6as6d_impl.h"
 #include "s6c_impl.h"
 #include "dataaccess.h"
+#include "fdjson.h"
 #include "common_def.h"
 #include "msg_event.h"
 
@@ -244,6 +245,8 @@ void FDHss::shutdown()
       m_ossendpoint = NULL;
    }
 
+   /* the compiled templates reference dictionary objects */
+   fdJsonTemplateFlush();
    m_diameter.uninit( false );
 
    if ( StatsHss::singleton().isRunning() ){
@@ -36,6 +36,7 @@
 #include "fdhss.h"
 #include "options.h"
 #include "logger.h"
+#include "fdjson.h"
 #include "resthandler.h"
 
 extern "C" {
@@ -155,12 +156,15 @@ int main(int argc, char **argv)
    std::cout << "Options::resthost              : " << Options::getrestport()              << std::endl;
    std::cout << "Options::synchimsi             : " << Options::getsynchimsi()             << std::endl;
    std::cout << "Options::synchauts             : " << Options::getsynchauts()             << std::endl;
+   std::cout << "Options::subtemplatecache      : " << Options::getsubtemplatecache()      << std::endl;
 
    /////////////////////////////////////////////////////////////////////////////
    /////////////////////////////////////////////////////////////////////////////
 
    initHandler();
 
+   fdJsonTemplateCacheSetSize( Options::getsubtemplatecache() );
+
    //Fill the hss_config to be used by c sec
    memset (&hss_config, 0, sizeof (hss_config_t));
    Options::fillhssconfig(&hss_config);
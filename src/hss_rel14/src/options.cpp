@@ -27,6 +27,7 @@
 #include "rapidjson/document.h"
 
 #include "options.h"
+#include "fdjson.h"
 
 const int Options::JSONFILEBUFFER = 1024;
 
@@ -57,6 +58,7 @@ unsigned    Options::m_casscoreconnections = 1;
 unsigned    Options::m_cassmaxconnections = 2;
 unsigned    Options::m_cassioqueuesize = 8192;
 unsigned    Options::m_cassiothreads = 1;
+unsigned    Options::m_subtemplatecache = FDJSON_TEMPLATE_CACHE_SIZE;
 bool        Options::m_randvector;
 bool        Options::m_roamallow;
 std::string Options::m_optkey;
@@ -183,6 +185,10 @@ bool Options::parseJson(){
          if(!hssSection["cassiothreads"].IsInt()) { std::cout << "Error parsing json value: [cassiothreads]" << std::endl; return false; }
          m_cassiothreads = hssSection["cassiothreads"].GetUint();
       }
+      if(hssSection.HasMember("subtemplatecache")){
+         if(!hssSection["subtemplatecache"].IsUint()) { std::cout << "Error parsing json value: [subtemplatecache]" << std::endl; return false; }
+         m_subtemplatecache = hssSection["subtemplatecache"].GetUint();
+      }
       if(!(options & randvector) && hssSection.HasMember("randv")){
          if(!hssSection["randv"].IsBool()) { std::cout << "Error parsing json value: [randv]" << std::endl; return false; }
          m_randvector = hssSection["randv"].GetBool();
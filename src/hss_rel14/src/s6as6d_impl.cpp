@@ -646,7 +646,7 @@ INSDRreq *Application::createINSDRreq(s6t::MonitoringEventConfigurationExtractor
       printf("Subscription data: %s \n", imsi_info.subscription_data.c_str());
 
       //2.add the subscription data to the message
-      fdJsonAddAvps( imsi_info.subscription_data.c_str() , s->getMsg(), NULL );
+      fdJsonAddAvpsCached( imsi_info.subscription_data.c_str() , s->getMsg(), NULL );
       //3.create a extractor to get to the subscription data avp
       InsertSubscriberDataRequestExtractor idr( *s, getDict() );
       //4. Get the pointer to the subscription data
@@ -1694,7 +1694,7 @@ void ULRProcessor::phase2()
    {
       ULR_TIMER_SET(ulr4, m_perf_timer);
 
-      if(fdJsonAddAvps(m_orig_info.subscription_data.c_str(), m_ans.getMsg(), &s6as6d::display_error_message) != 0)
+      if(fdJsonAddAvpsCached(m_orig_info.subscription_data.c_str(), m_ans.getMsg(), &s6as6d::display_error_message) != 0)
       {
          FDAvp er ( m_dict.avpExperimentalResult() );
          er.add( m_dict.avpVendorId(),  VENDOR_3GPP);
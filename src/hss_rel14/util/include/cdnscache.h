@@ -17,6 +17,11 @@
 #ifndef __CDNSCACHE_H
 #define __CDNSCACHE_H
 
+#include <stdint.h>
+#include <time.h>
+
+#include <memory>
+
 #include "cdnsquery.h"
 #include "ssync.h"
 
@@ -25,10 +30,27 @@ namespace CachedDNS
    extern "C" typedef void(*CachedDNSQueryCallback)(Query *q, bool cacheHit, void *data);
 
    class QueryProcessor;
-   
+   class RefreshThread;
+   class CacheShard;
+   class InFlightQuery;
+
+   struct CacheStatistics
+   {
+      uint64_t hits;             // answered from the cache
+      uint64_t negativeHits;     // answered by a cached failure
+      uint64_t misses;           // sent to the name servers
+      uint64_t coalesced;        // waited for an identical query already sent
+      uint64_t refreshes;        // refreshed in the background before expiring
+      uint64_t failures;         // errors and empty answers from the name servers
+      uint64_t latencyTotalUs;   // round trips to the name servers
+      uint64_t latencyMaxUs;
+      uint64_t entries;
+   };
+
    class Cache
    {
       friend QueryProcessor;
+      friend RefreshThread;
 
    public:
       static Cache& getInstance();
@@ -36,6 +58,18 @@ namespace CachedDNS
       Query* query( ns_type rtype, const std::string &domain, bool &cacheHit );
       void query( ns_type rtype, const std::string &domain, CachedDNSQueryCallback cb, void *data=NULL );
 
+      // failed queries and empty answers are cached for this many seconds, 0 to disable
+      void setNegativeTTL( int ttl ) { m_negativettl = ttl; }
+      // entries hit when less than this percentage of their TTL remains are refreshed in the background, 0 to disable
+      void setRefreshAhead( int percent ) { m_refreshahead = percent; }
+      // replaced entries are deleted after this many seconds, a Query returned by query() stays valid at least as long
+      void setRetireDelay( int seconds ) { m_retiredelay = seconds; }
+      // name servers used instead of the ones of resolv.conf, ex: "127.0.0.1:5353", empty for the system ones
+      void setNameServers( const std::string &servers );
+
+      void getStatistics( CacheStatistics &stats );
+      void resetStatistics();
+
    protected:
       Query* processQuery( ns_type rtype, const std::string &domain );
 
@@ -43,13 +77,19 @@ namespace CachedDNS
       Cache();
       ~Cache();
 
+      CacheShard &getShard( ns_type rtype, const std::string &domain );
       Query* lookupQuery( ns_type rtype, const std::string &domain );
-      bool processQuery( ns_type rtype, const std::string &domain, CachedDNSQueryCallback cb);
-
-      static void ares_callback(void *arg, int status, int timeouts, unsigned char *abuf, int alen);
+      Query* resolveQuery( CacheShard &shard, ns_type rtype, const std::string &domain, std::shared_ptr<InFlightQuery> &inflight, bool refresh );
+      void purgeRetired( CacheShard &shard, time_t now );
+      void purgeRetired();
 
-      QueryCache m_cache;
-      SMutex m_cachemutex;
+      CacheShard *m_shards;
+      RefreshThread *m_refresher;
+      int m_negativettl;
+      int m_refreshahead;
+      int m_retiredelay;
+      std::string m_nameservers;
+      SMutex m_configmutex;
    };
 }
 
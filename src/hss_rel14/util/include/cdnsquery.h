@@ -32,7 +32,9 @@ namespace CachedDNS
       Query( ns_type rtype, const std::string &domain )
          : m_type( rtype ),
            m_domain( domain ),
-           m_expires( 0 )
+           m_created( time(NULL) ),
+           m_expires( 0 ),
+           m_negative( false )
       {
       }
 
@@ -109,6 +111,12 @@ namespace CachedDNS
       const std::string &getDomain() { return m_domain; }
 
       bool isExpired() { return time(NULL) >= m_expires; }
+      time_t getCreated() { return m_created; }
+      time_t getExpires() { return m_expires; }
+
+      // failed query or empty answer, cached for ttl seconds
+      bool isNegative() { return m_negative; }
+      void setNegative( int ttl ) { m_negative = true; m_expires = time(NULL) + ttl; }
 
       const std::list<Question*> &getQuestions() { return m_question; }
       const ResourceRecordList &getAnswers() { return m_answer; }
@@ -158,7 +166,9 @@ namespace CachedDNS
       ResourceRecordList m_answer;
       ResourceRecordList m_authority;
       ResourceRecordList m_additional;
+      time_t m_created;
       time_t m_expires;
+      bool m_negative;
    };
 
    class QueryCacheKey
@@ -29,12 +29,18 @@ extern "C" {
 #endif
 
 int fdJsonAddAvps( const char *json, msg_or_avp *msg, void (*errfunc)(const char *) );
+/* same as fdJsonAddAvps(), reusing the AVPs compiled from an identical json string */
+int fdJsonAddAvpsCached( const char *json, msg_or_avp *msg, void (*errfunc)(const char *) );
+void fdJsonTemplateCacheSetSize( size_t size );
+void fdJsonTemplateFlush( void );
 const char *fdJsonGetJSON( msg_or_avp *msg, void (*errfunc)(const char *) );
 
 #define FDJSON_SUCCESS             0
 #define FDJSON_JSON_PARSING_ERROR  1
 #define FDJSON_EXCEPTION           2
 
+#define FDJSON_TEMPLATE_CACHE_SIZE 1024
+
 #ifdef __cplusplus
 };
 #endif
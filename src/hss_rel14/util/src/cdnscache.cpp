@@ -18,10 +18,13 @@
 #include <stdio.h>
 #include <memory.h>
 #include <poll.h>
+#include <time.h>
 #include <ares.h>
 
 #include <iostream>
 #include <list>
+#include <map>
+#include <functional>
 
 #include "serror.h"
 #include "sthread.h"
@@ -72,8 +75,9 @@ namespace CachedDNS
    class QueryProcessor
    {
    public:
-      QueryProcessor( Query *q )
-         : m_query( q )
+      QueryProcessor( Query *q, const std::string &nameservers )
+         : m_nameservers( nameservers ),
+           m_query( q )
       {
          m_status = ARES_SUCCESS;
          m_channel = NULL;
@@ -89,17 +93,18 @@ namespace CachedDNS
 
       void execute()
       {
-         if ( (m_status = ares_init(&m_channel)) == ARES_SUCCESS )
+         struct ares_options opt;
+         opt.timeout = 1000;
+         opt.ndots = 0;
+         opt.flags = ARES_FLAG_EDNS;
+         opt.ednspsz = 8192;
+
+         if ( (m_status = ares_init_options(&m_channel, &opt, ARES_OPT_TIMEOUTMS | ARES_OPT_NDOTS | ARES_OPT_EDNSPSZ | ARES_OPT_FLAGS)) == ARES_SUCCESS &&
+              (m_nameservers.empty() || (m_status = ares_set_servers_ports_csv(m_channel, m_nameservers.c_str())) == ARES_SUCCESS) )
          {
-            struct ares_options opt;
-            opt.timeout = 1000;
-            opt.ndots = 0;
-            opt.flags = ARES_FLAG_EDNS;
-            opt.ednspsz = 8192;
-            ares_init_options( &m_channel, &opt, ARES_OPT_TIMEOUTMS | ARES_OPT_NDOTS | ARES_OPT_EDNSPSZ | ARES_OPT_FLAGS );
-    
             ares_query( m_channel, m_query->getDomain().c_str(), ns_c_in, m_query->getType(), ares_callback, this );
 
+            // m_status is updated by ares_callback
             wait_for_completion();
          }
 
@@ -167,6 +172,10 @@ namespace CachedDNS
 
       void process( int status, int timeouts, unsigned char *abuf, int alen )
       {
+         m_status = status;
+         if ( status != ARES_SUCCESS )
+            return;
+
          try
          {
             Parser p( m_query, abuf, alen );
@@ -181,9 +190,61 @@ namespace CachedDNS
       int m_status;
       ares_channel m_channel;
       SEvent m_event;
+      std::string m_nameservers;
+      Query *m_query;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   ////////////////////////////////////////////////////////////////////////////////
+
+   // A query sent to the name servers, identical queries wait for its result instead of being sent again
+   class InFlightQuery
+   {
+   public:
+      InFlightQuery()
+         : m_query( NULL )
+      {
+      }
+
+      void complete( Query *q )
+      {
+         m_query = q;
+         m_event.set();
+      }
+
+      Query* wait()
+      {
+         m_event.wait();
+         return m_query;
+      }
+
+   private:
       Query *m_query;
+      SEvent m_event;
+   };
+
+   typedef std::map<QueryCacheKey, std::shared_ptr<InFlightQuery> > InFlightQueries;
+
+   // Replaced entries, deleted once they are older than the retire delay
+   typedef std::list<std::pair<time_t, Query*> > RetiredQueries;
+
+   class CacheShard
+   {
+   public:
+      CacheShard()
+      {
+         memset( &m_stats, 0, sizeof(m_stats) );
+      }
+
+      SMutex m_mutex;
+      QueryCache m_cache;
+      InFlightQueries m_inflight;
+      RetiredQueries m_retired;
+      CacheStatistics m_stats;
    };
 
+   #define CACHE_SHARDS 16
+
    ////////////////////////////////////////////////////////////////////////////////
    ////////////////////////////////////////////////////////////////////////////////
 
@@ -217,12 +278,112 @@ namespace CachedDNS
       CachedDNSQueryCallback m_cb;
       void *m_data;
    };
+
+   ////////////////////////////////////////////////////////////////////////////////
+   ////////////////////////////////////////////////////////////////////////////////
+
+   #define CACHE_REFRESH_QUEUE_MAX 1024
+   #define CACHE_PURGE_INTERVAL_MS 1000
+
+   // Refreshes the hot entries before their TTL expires, one at a time, the entries keep being served meanwhile.
+   // Also deletes the retired entries of the shards that do not resolve anything anymore.
+   class RefreshThread : public SThread
+   {
+   public:
+      RefreshThread( Cache &cache )
+         : SThread( false ),
+           m_cache( cache ),
+           m_quit( false )
+      {
+      }
+
+      // false when too many refreshes are pending, the entry is then resolved again once expired
+      bool post( CacheShard &shard, ns_type rtype, const std::string &domain, std::shared_ptr<InFlightQuery> &inflight )
+      {
+         {
+            SMutexLock l( m_mutex );
+            if ( m_requests.size() >= CACHE_REFRESH_QUEUE_MAX )
+               return false;
+            m_requests.push_back( Request( shard, rtype, domain, inflight ) );
+         }
+         m_event.set();
+         return true;
+      }
+
+      void quit()
+      {
+         {
+            SMutexLock l( m_mutex );
+            m_quit = true;
+         }
+         m_event.set();
+      }
+
+      virtual unsigned long threadProc(void *arg)
+      {
+         while ( true )
+         {
+            m_event.wait( CACHE_PURGE_INTERVAL_MS );
+            m_event.reset();
+
+            while ( true )
+            {
+               std::list<Request> request;
+               {
+                  SMutexLock l( m_mutex );
+                  if ( m_quit )
+                     return 0;
+                  if ( m_requests.empty() )
+                     break;
+                  request.splice( request.begin(), m_requests, m_requests.begin() );
+               }
+               Request &r = request.front();
+               m_cache.resolveQuery( *r.m_shard, r.m_type, r.m_domain, r.m_inflight, true );
+            }
+
+            m_cache.purgeRetired();
+         }
+      }
+
+   private:
+      struct Request
+      {
+         Request( CacheShard &shard, ns_type rtype, const std::string &domain, std::shared_ptr<InFlightQuery> &inflight )
+            : m_shard( &shard ),
+              m_type( rtype ),
+              m_domain( domain ),
+              m_inflight( inflight )
+         {
+         }
+
+         CacheShard *m_shard;
+         ns_type m_type;
+         std::string m_domain;
+         std::shared_ptr<InFlightQuery> m_inflight;
+      };
+
+      Cache &m_cache;
+      bool m_quit;
+      SMutex m_mutex;
+      SEvent m_event;
+      std::list<Request> m_requests;
+   };
 } // namespace CachedDNS
 
+static uint64_t now_us()
+{
+   struct timespec ts;
+   clock_gettime( CLOCK_MONOTONIC, &ts );
+   return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
 Cache::Cache()
+   : m_negativettl( 10 ),
+     m_refreshahead( 10 ),
+     m_retiredelay( 300 )
 {
    int status = ares_library_init( ARES_LIB_INIT_ALL );
    if ( status != ARES_SUCCESS )
@@ -230,19 +391,41 @@ Cache::Cache()
       std::string msg( string_format("Cache::Cache() - ares_library_init() failed status = %d", status) );
       SError::throwRuntimeException( msg );
    }
+
+   m_shards = new CacheShard[ CACHE_SHARDS ];
+
+   m_refresher = new RefreshThread( *this );
+   m_refresher->init( NULL );
 }
 
 Cache::~Cache()
 {
-   QueryCache::iterator it;
+   m_refresher->quit();
+   m_refresher->join();
+   delete m_refresher;
 
-   while ((it = m_cache.begin()) != m_cache.end())
+   for ( int i = 0; i < CACHE_SHARDS; i++ )
    {
-      Query *q = it->second;
-      m_cache.erase( it );
-      delete q;
+      QueryCache &cache = m_shards[i].m_cache;
+      QueryCache::iterator it;
+
+      while ((it = cache.begin()) != cache.end())
+      {
+         Query *q = it->second;
+         cache.erase( it );
+         delete q;
+      }
+
+      RetiredQueries &retired = m_shards[i].m_retired;
+      while ( !retired.empty() )
+      {
+         delete retired.front().second;
+         retired.pop_front();
+      }
    }
 
+   delete [] m_shards;
+
    ares_library_cleanup();
 }
 
@@ -256,7 +439,7 @@ Query* Cache::query( ns_type rtype, const std::string & domain, bool &cacheHit )
 {
    Query *q = lookupQuery( rtype, domain );
 
-   cacheHit = !( !q || q->isExpired() );
+   cacheHit = q != NULL;
 
    if ( !cacheHit ) // query not found or expired
       q = processQuery( rtype, domain );
@@ -268,11 +451,9 @@ void Cache::query( ns_type rtype, const std::string &domain, CachedDNSQueryCallb
 {
    Query *q = lookupQuery( rtype, domain );
 
-   bool cacheHit = !( !q || q ->isExpired() );
-
-   if ( cacheHit )
+   if ( q )
    {
-      cb( q, cacheHit, data );
+      cb( q, true, data );
    }
    else
    {
@@ -282,58 +463,213 @@ void Cache::query( ns_type rtype, const std::string &domain, CachedDNSQueryCallb
    }
 }
 
+void Cache::setNameServers( const std::string &servers )
+{
+   SMutexLock l( m_configmutex );
+   m_nameservers = servers;
+}
+
+void Cache::getStatistics( CacheStatistics &stats )
+{
+   memset( &stats, 0, sizeof(stats) );
+
+   for ( int i = 0; i < CACHE_SHARDS; i++ )
+   {
+      SMutexLock l( m_shards[i].m_mutex );
+      const CacheStatistics &s = m_shards[i].m_stats;
+
+      stats.hits += s.hits;
+      stats.negativeHits += s.negativeHits;
+      stats.misses += s.misses;
+      stats.coalesced += s.coalesced;
+      stats.refreshes += s.refreshes;
+      stats.failures += s.failures;
+      stats.latencyTotalUs += s.latencyTotalUs;
+      if ( s.latencyMaxUs > stats.latencyMaxUs )
+         stats.latencyMaxUs = s.latencyMaxUs;
+      stats.entries += m_shards[i].m_cache.size();
+   }
+}
+
+void Cache::resetStatistics()
+{
+   for ( int i = 0; i < CACHE_SHARDS; i++ )
+   {
+      SMutexLock l( m_shards[i].m_mutex );
+      memset( &m_shards[i].m_stats, 0, sizeof(m_shards[i].m_stats) );
+   }
+}
+
+CacheShard &Cache::getShard( ns_type rtype, const std::string &domain )
+{
+   size_t h = std::hash<std::string>()( domain ) ^ (size_t)rtype;
+   return m_shards[ h % CACHE_SHARDS ];
+}
+
+// Returns the cached query if it has not expired, NULL otherwise.
+// A hit on an entry close to its expiration starts its refresh.
 Query* Cache::lookupQuery( ns_type rtype, const std::string &domain )
 {
-   SMutexLock l( m_cachemutex );
-   QueryCacheKey qck( rtype, domain );
-   QueryCache::const_iterator it = m_cache.find( qck );
-   return it != m_cache.end() ? it->second : NULL;
+   CacheShard &shard = getShard( rtype, domain );
+   Query *q = NULL;
+
+   {
+      SMutexLock l( shard.m_mutex );
+      QueryCacheKey qck( rtype, domain );
+      QueryCache::const_iterator it = shard.m_cache.find( qck );
+
+      if ( it == shard.m_cache.end() || it->second->isExpired() )
+         return NULL;
+
+      q = it->second;
+      if ( q->isNegative() )
+      {
+         shard.m_stats.negativeHits++;
+         return q;
+      }
+      shard.m_stats.hits++;
+
+      time_t ttl = q->getExpires() - q->getCreated();
+      if ( m_refreshahead > 0 && (q->getExpires() - time(NULL)) * 100 < ttl * m_refreshahead &&
+           shard.m_inflight.find( qck ) == shard.m_inflight.end() )
+      {
+         std::shared_ptr<InFlightQuery> inflight = std::make_shared<InFlightQuery>();
+
+         if ( m_refresher->post( shard, rtype, domain, inflight ) )
+         {
+            shard.m_inflight[qck] = inflight;
+            shard.m_stats.refreshes++;
+         }
+      }
+   }
+
+   return q;
 }
 
+// Sends the query to the name servers, or waits for the result of an identical query already sent.
 Query* Cache::processQuery( ns_type rtype, const std::string &domain )
 {
+   CacheShard &shard = getShard( rtype, domain );
+   std::shared_ptr<InFlightQuery> inflight;
+   bool owner = false;
+
+   {
+      SMutexLock l( shard.m_mutex );
+      QueryCacheKey qck( rtype, domain );
+
+      // another thread may have cached it after lookupQuery()
+      QueryCache::const_iterator it = shard.m_cache.find( qck );
+      if ( it != shard.m_cache.end() && !it->second->isExpired() )
+         return it->second;
+
+      InFlightQueries::iterator ifit = shard.m_inflight.find( qck );
+      if ( ifit != shard.m_inflight.end() )
+      {
+         inflight = ifit->second;
+         shard.m_stats.coalesced++;
+      }
+      else
+      {
+         inflight = std::make_shared<InFlightQuery>();
+         shard.m_inflight[qck] = inflight;
+         shard.m_stats.misses++;
+         owner = true;
+      }
+   }
+
+   if ( owner )
+      return resolveQuery( shard, rtype, domain, inflight, false );
+
+   return inflight->wait();
+}
+
+Query* Cache::resolveQuery( CacheShard &shard, ns_type rtype, const std::string &domain, std::shared_ptr<InFlightQuery> &inflight, bool refresh )
+{
+   std::string nameservers;
+   {
+      SMutexLock l( m_configmutex );
+      nameservers = m_nameservers;
+   }
+
    Query* q = new Query( rtype, domain );
-   QueryProcessor qp( q );
+   QueryProcessor qp( q, nameservers );
+   uint64_t start = now_us();
    qp.execute();
+   uint64_t latency = now_us() - start;
 
-   if ( qp.getStatus() == ARES_SUCCESS )
-   {
-      Query *oldQuery = NULL;
+   bool failed = qp.getStatus() != ARES_SUCCESS || q->getExpires() == 0;
 
+   if ( failed )
+   {
+      // a failed refresh keeps the current entry until it expires
+      if ( refresh || m_negativettl <= 0 )
+      {
+         delete q;
+         q = NULL;
+      }
+      else
       {
-         SMutexLock l( m_cachemutex );
-         QueryCacheKey qck( rtype, domain );
+         q->setNegative( m_negativettl );
+      }
+   }
+
+   {
+      SMutexLock l( shard.m_mutex );
+      QueryCacheKey qck( rtype, domain );
+      time_t now = time( NULL );
+
+      shard.m_stats.latencyTotalUs += latency;
+      if ( latency > shard.m_stats.latencyMaxUs )
+         shard.m_stats.latencyMaxUs = latency;
+      if ( failed )
+         shard.m_stats.failures++;
 
-         // lookup the query in the cache
-         QueryCache::iterator it = m_cache.find( qck );
-         if ( it != m_cache.end() ) // found the entry
+      purgeRetired( shard, now );
+
+      QueryCache::iterator it = shard.m_cache.find( qck );
+      if ( q )
+      {
+         if ( it != shard.m_cache.end() ) // found the entry
          {
-            // save the query* to be deleted
-            oldQuery = it->second;
-            // update the cache with the new query results
+            // the replaced query may still be used by the callers it was returned to
+            shard.m_retired.push_back( std::make_pair(now, it->second) );
             it->second = q;
          }
          else
          {
-            // add the entry since it was not found
-            m_cache[qck] = q;
+            shard.m_cache[qck] = q;
          }
       }
+      else if ( refresh && it != shard.m_cache.end() )
+      {
+         q = it->second;
+      }
 
-      if ( oldQuery )
-         delete oldQuery;
-   }
-   else
-   {
-      // delete the query object since it failed
-      delete q;
-      q = NULL;
+      shard.m_inflight.erase( qck );
    }
 
+   inflight->complete( q );
+
    return q;
 }
 
-void Cache::ares_callback( void *arg, int status, int timeouts, unsigned char *abuf, int alen )
+// Deletes the retired entries older than the retire delay, the shard mutex must be held.
+void Cache::purgeRetired( CacheShard &shard, time_t now )
 {
+   while ( !shard.m_retired.empty() && shard.m_retired.front().first + m_retiredelay <= now )
+   {
+      delete shard.m_retired.front().second;
+      shard.m_retired.pop_front();
+   }
 }
 
+void Cache::purgeRetired()
+{
+   time_t now = time( NULL );
+
+   for ( int i = 0; i < CACHE_SHARDS; i++ )
+   {
+      SMutexLock l( m_shards[i].m_mutex );
+      purgeRetired( m_shards[i], now );
+   }
+}
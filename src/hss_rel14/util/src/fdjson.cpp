@@ -48,6 +48,8 @@
 #include <iostream>
 #include <iomanip>
 #include <unordered_map>
+#include <list>
+#include <memory>
 
 #include "freeDiameter/freeDiameter-host.h"
 #include "freeDiameter/libfdcore.h"
@@ -271,60 +273,84 @@ private:
 static SMutex dictEntriesMutex;
 static std::unordered_map<std::string,AvpDictionaryEntry*> dictEntries;
 
-class AVP
+/*
+ * AvpTemplate is the compiled form of a JSON element: the dictionary entry
+ * is resolved and the value converted once, so the template can be added to
+ * any number of messages without touching the JSON or the dictionary again.
+ */
+class AvpTemplate
 {
 public:
-   AVP( const char *avp_name ) { _init(avp_name); }
-   AVP( const char *avp_name, int32_t v ) { _init(avp_name); set(v); }
-   AVP( const char *avp_name, int64_t v ) { _init(avp_name); set(v); }
-   AVP( const char *avp_name, uint32_t v ) { _init(avp_name); set(v); }
-   AVP( const char *avp_name, uint64_t v ) { _init(avp_name); set(v); }
-   AVP( const char *avp_name, float v ) { _init(avp_name); set(v); }
-   AVP( const char *avp_name, double v ) { _init(avp_name); set(v); }
-   AVP( const char *avp_name, const int8_t *v ) { _init(avp_name); set(v); }
-   AVP( const char *avp_name, const int8_t *v, size_t len ) { _init(avp_name); set(v, len); }
-   AVP( const char *avp_name, const uint8_t *v ) { _init(avp_name); set(v); }
-   AVP( const char *avp_name, const uint8_t *v, size_t len ) { _init(avp_name); set(v, len); }
-
-   ~AVP()
+   AvpTemplate( const char *avp_name ) { _init(avp_name); }
+
+   AvpTemplate &set( int32_t v ) { mValue.i32 = v; return *this; }
+   AvpTemplate &set( int64_t v ) { mValue.i64 = v; return *this; }
+   AvpTemplate &set( uint32_t v ) { mValue.u32 = v; return *this; }
+   AvpTemplate &set( uint64_t v ) { mValue.u64 = v; return *this; }
+   AvpTemplate &set( float v ) { mValue.f32 = v; return *this; }
+   AvpTemplate &set( double v ) { mValue.f64 = v; return *this; }
+   AvpTemplate &set( const uint8_t *v, size_t len ) { mOctets.assign( (const char *)v, len ); return *this; }
+
+   std::list<AvpTemplate> &getChildren() { return mChildren; }
+
+   dict_avp_basetype getBaseType() { return mBaseType; }
+   AvpDataType getType() { return mType; }
+
+   void addTo( msg_or_avp *reference ) const
    {
-      if (mBuf)
-         delete mBuf;
-   }
+      int ret;
+      struct avp *avp = NULL;
 
-   AVP &set( int32_t v ) { mValue.i32 = v; return *this; }
-   AVP &set( int64_t v ) { mValue.i64 = v; return *this; }
-   AVP &set( uint32_t v ) { mValue.u32 = v; return *this; }
-   AVP &set( uint64_t v ) { mValue.u64 = v; return *this; }
-   AVP &set( float v ) { mValue.f32 = v; return *this; }
-   AVP &set( double v ) { mValue.f64 = v; return *this; }
-   AVP &set( const int8_t *v ) { return set(v, strlen((const char *)v)); }
-   AVP &set( const int8_t *v, size_t len ) { mValue.os.data = (uint8_t*)v; mValue.os.len = len; return *this; }
-   AVP &set( const uint8_t *v ) { return set(v, strlen((const char *)v)); }
-   AVP &set( const uint8_t *v, size_t len ) { mValue.os.data = (uint8_t*)v; mValue.os.len = len; return *this; }
+      if ((ret = fd_msg_avp_new(mBaseEntry,0,&avp)) != 0)
+         throw runtimeError(
+            string_format("%s:%d - ERROR - Error [%d] creating [%s] AVP",
+            __FILE__, __LINE__, ret, mName.c_str())
+         );
 
-   void addTo( msg_or_avp *reference ) { _addTo(reference); }
-   void addTo( AVP &reference ) { _addTo(reference.mAvp); }
+      try
+      {
+         if ( mBaseType != AVP_TYPE_GROUPED )
+         {
+            union avp_value value = mValue;
+
+            if ( mBaseType == AVP_TYPE_OCTETSTRING )
+            {
+               /* fd_msg_avp_setvalue() copies the octets into the AVP */
+               value.os.data = (uint8_t*)mOctets.data();
+               value.os.len = mOctets.size();
+            }
 
-   struct avp *getAvp() { return mAvp; }
+            if ((ret = fd_msg_avp_setvalue(avp,&value)) != 0)
+               throw runtimeError(
+                  string_format("%s:%d - ERROR - Error [%d] setting AVP value for [%s]",
+                  __FILE__, __LINE__, ret, mName.c_str())
+               );
+         }
 
-   void allocBuffer(size_t len) { mBuf = new Buffer<uint8_t>(len); }
-   Buffer<uint8_t> &getBuffer() { return *mBuf; }
+         if ((ret = fd_msg_avp_add(reference,MSG_BRW_LAST_CHILD,avp)) != 0)
+            throw runtimeError(
+               string_format("%s:%d - ERROR - Error [%d] adding [%s] AVP",
+               __FILE__, __LINE__, ret, mName.c_str())
+            );
+      }
+      catch (...)
+      {
+         fd_msg_free( avp );
+         throw;
+      }
 
-   dict_avp_basetype getBaseType() { return mBaseData.avp_basetype; }
-   AvpDataType getType() { return mType; }
+      for (std::list<AvpTemplate>::const_iterator it = mChildren.begin(); it != mChildren.end(); ++it)
+         it->addTo( avp );
+   }
 
 private:
 
    void _init( const char *avp_name )
    {
-
       mName = avp_name;
       mBaseEntry = NULL;
-      memset( &mBaseData, 0, sizeof(mBaseData) );
+      mBaseType = AVP_TYPE_GROUPED;
       mType = ADTUnknown;
-      mBuf = NULL;
-      mAvp = NULL;
       memset( &mValue, 0, sizeof(mValue) );
 
       /* check if an entry exists in dictEntries */
@@ -355,54 +381,121 @@ private:
       }
 
       mBaseEntry = it->second->getBaseEntry();
-      memcpy( &mBaseData, &it->second->getBaseData(), sizeof(mBaseData));
+      mBaseType = it->second->getBaseData().avp_basetype;
       mType = it->second->getType();
    }
 
-   void _addTo( msg_or_avp *reference )
+   std::string mName;
+   struct dict_object *mBaseEntry;
+   dict_avp_basetype mBaseType;
+   AvpDataType mType;
+   union avp_value mValue;
+   std::string mOctets;
+   std::list<AvpTemplate> mChildren;
+};
+
+/*
+ * FDJsonTemplate holds the compiled AVPs of one JSON document together with
+ * the document text, which is compared on lookup to rule out hash collisions.
+ */
+class FDJsonTemplate
+{
+public:
+   FDJsonTemplate( const std::string &json ) : mJson( json ) {}
+
+   const std::string &getJson() const { return mJson; }
+   std::list<AvpTemplate> &getAvps() { return mAvps; }
+
+   void addTo( msg_or_avp *msg ) const
    {
-      int ret;
+      for (std::list<AvpTemplate>::const_iterator it = mAvps.begin(); it != mAvps.end(); ++it)
+         it->addTo( msg );
+   }
 
-      if ((ret = fd_msg_avp_new(mBaseEntry,0,&mAvp)) != 0)
-         throw runtimeError(
-            string_format("%s:%d - ERROR - Error [%d] creating [%s] AVP",
-            __FILE__, __LINE__, ret, mName)
-         );
+private:
+   std::string mJson;
+   std::list<AvpTemplate> mAvps;
+};
 
-      try
-      {
-         if ( mBaseData.avp_basetype != AVP_TYPE_GROUPED )
-         {
-            if ((ret = fd_msg_avp_setvalue(mAvp,&mValue)) != 0)
-               throw runtimeError(
-                  string_format("%s:%d - ERROR - Error [%d] setting AVP value for [%s]",
-                  __FILE__, __LINE__, ret, mName)
-               );
-         }
+typedef std::shared_ptr<FDJsonTemplate> FDJsonTemplatePtr;
 
-         if ((ret = fd_msg_avp_add(reference,MSG_BRW_LAST_CHILD,mAvp)) != 0)
-            throw runtimeError(
-               string_format("%s:%d - ERROR - Error [%d] adding [%s] AVP",
-               __FILE__, __LINE__, ret, mName)
-            );
+/*
+ * Bounded LRU of compiled templates keyed by the hash of the JSON text.
+ * Subscribers sharing a profile share a template, and since the key is the
+ * text itself a modified subscriber row can never be served a stale one.
+ */
+class FDJsonTemplateCache
+{
+public:
+   FDJsonTemplateCache() : mMaxSize( FDJSON_TEMPLATE_CACHE_SIZE ) {}
+
+   FDJsonTemplatePtr lookup( size_t key, const std::string &json )
+   {
+      SMutexLock l( mMutex );
+
+      auto it = mIndex.find( key );
+      if ( it == mIndex.end() || (*it->second)->getJson() != json )
+         return FDJsonTemplatePtr();
+
+      mLru.splice( mLru.begin(), mLru, it->second );
+      return *it->second;
+   }
+
+   void insert( size_t key, const FDJsonTemplatePtr &tpl )
+   {
+      SMutexLock l( mMutex );
+
+      if ( mMaxSize == 0 )
+         return;
+
+      auto it = mIndex.find( key );
+      if ( it != mIndex.end() )
+      {
+         mLru.erase( it->second );
+         mIndex.erase( it );
       }
-      catch (...)
+
+      mLru.push_front( tpl );
+      mIndex[key] = mLru.begin();
+
+      _trim();
+   }
+
+   void flush()
+   {
+      SMutexLock l( mMutex );
+
+      mIndex.clear();
+      mLru.clear();
+   }
+
+   void setSize( size_t size )
+   {
+      SMutexLock l( mMutex );
+
+      mMaxSize = size;
+      _trim();
+   }
+
+private:
+   void _trim()
+   {
+      /* a template being added to a message by another thread lives on through its shared_ptr */
+      while ( mLru.size() > mMaxSize )
       {
-         fd_msg_free( mAvp );
-         mAvp = NULL;
-         throw;
+         mIndex.erase( std::hash<std::string>()( mLru.back()->getJson() ) );
+         mLru.pop_back();
       }
    }
 
-   const char * mName;
-   struct dict_object *mBaseEntry;
-   struct dict_avp_data mBaseData;
-   AvpDataType mType;
-   Buffer<uint8_t> *mBuf;
-   struct avp *mAvp;
-   union avp_value mValue;
+   SMutex mMutex;
+   size_t mMaxSize;
+   std::list<FDJsonTemplatePtr> mLru;
+   std::unordered_map<size_t,std::list<FDJsonTemplatePtr>::iterator> mIndex;
 };
 
+static FDJsonTemplateCache templateCache;
+
 #define THROW_DATATYPE_MISMATCH() \
 { \
    throw runtimeInfo( string_format("%s:%d - INFO - Datatype mismatch for [%s] - expected datatype compatible with %s, JSON data type was %s", \
@@ -482,12 +575,11 @@ static bool isHexString( const char *s, int len )
    return true;
 }
 
-static void fdJsonAddAvps( AVP &avp, const RAPIDJSON_NAMESPACE::Value &element, void (*errfunc)(const char*) );
-static void fdJsonAddAvps( msg_or_avp *reference, const RAPIDJSON_NAMESPACE::Value &element, void (*errfunc)(const char*) );
+static void fdJsonCompileAvps( std::list<AvpTemplate> &avps, const RAPIDJSON_NAMESPACE::Value &element, void (*errfunc)(const char*) );
 
-static void fdJsonAddAvp( msg_or_avp *reference, const char *name, const RAPIDJSON_NAMESPACE::Value &value, void (*errfunc)(const char*) )
+static void fdJsonCompileAvp( std::list<AvpTemplate> &avps, const char *name, const RAPIDJSON_NAMESPACE::Value &value, void (*errfunc)(const char*) )
 {
-   AVP avp( name );
+   AvpTemplate avp( name );
 
    switch (value.GetType())
    {
@@ -542,7 +634,7 @@ static void fdJsonAddAvp( msg_or_avp *reference, const char *name, const RAPIDJS
             }
          }
 
-         avp.addTo( reference );
+         avps.push_back( std::move(avp) );
 
          break;
       }
@@ -611,7 +703,7 @@ static void fdJsonAddAvp( msg_or_avp *reference, const char *name, const RAPIDJS
                /*
                 * allocate space for the binary string
                 */
-               avp.allocBuffer( binlen - 1 );
+               Buffer<uint8_t> bin( binlen - 1 );
 
                /*
                 * grab a pointer to the hex character buffer
@@ -624,12 +716,12 @@ static void fdJsonAddAvp( msg_or_avp *reference, const char *name, const RAPIDJS
                 * to start at the first hex digit
                 */
                for (uint32_t i = 1; i < binlen; i++)
-                  avp.getBuffer().get()[i-1] = (HEX2BIN(p[i * 2] ) << 4) + HEX2BIN(p[i * 2 + 1]);
+                  bin.get()[i-1] = (HEX2BIN(p[i * 2] ) << 4) + HEX2BIN(p[i * 2 + 1]);
 
                /*
                 * assign the string to the avp
                 */
-               avp.set( avp.getBuffer().get(), binlen - 1 );
+               avp.set( bin.get(), binlen - 1 );
             }
             else
             {
@@ -642,25 +734,25 @@ static void fdJsonAddAvp( msg_or_avp *reference, const char *name, const RAPIDJS
          }
 
          /* add to the message/grouped avp */
-         avp.addTo( reference );
+         avps.push_back( std::move(avp) );
 
          break;
       }
       case RAPIDJSON_NAMESPACE::kArrayType:
       {
-         /* iterate through array elements adding them to reference */
+         /* iterate through array elements adding them to avps */
          for (RAPIDJSON_NAMESPACE::Value::ConstValueIterator it = value.Begin();
               it != value.End();
               ++it)
          {
-            fdJsonAddAvp( reference, name, *it, errfunc );
+            fdJsonCompileAvp( avps, name, *it, errfunc );
          }
          break;
       }
       case RAPIDJSON_NAMESPACE::kObjectType:
       {
-         avp.addTo( reference );
-         fdJsonAddAvps( avp, value, errfunc );
+         fdJsonCompileAvps( avp.getChildren(), value, errfunc );
+         avps.push_back( std::move(avp) );
          break;
       }
       default:
@@ -674,21 +766,16 @@ static void fdJsonAddAvp( msg_or_avp *reference, const char *name, const RAPIDJS
    }
 }
 
-static void fdJsonAddAvps( AVP &avp, const RAPIDJSON_NAMESPACE::Value &element, void (*errfunc)(const char*) )
-{
-   fdJsonAddAvps( avp.getAvp(), element, errfunc );
-}
-
-static void fdJsonAddAvps( msg_or_avp *reference, const RAPIDJSON_NAMESPACE::Value &element, void (*errfunc)(const char*) )
+static void fdJsonCompileAvps( std::list<AvpTemplate> &avps, const RAPIDJSON_NAMESPACE::Value &element, void (*errfunc)(const char*) )
 {
-   /* iterate through each of the child elements adding them to the reference */
+   /* iterate through each of the child elements compiling them into avps */
    for (RAPIDJSON_NAMESPACE::Value::ConstMemberIterator it = element.MemberBegin();
         it != element.MemberEnd();
         ++it)
    {
       try
       {
-         fdJsonAddAvp( reference, it->name.GetString(), it->value, errfunc );
+         fdJsonCompileAvp( avps, it->name.GetString(), it->value, errfunc );
       }
       catch (runtimeInfo &exi)
       {
@@ -697,29 +784,78 @@ static void fdJsonAddAvps( msg_or_avp *reference, const RAPIDJSON_NAMESPACE::Val
    }
 }
 
+static int fdJsonCompile( const char *json, FDJsonTemplate &tpl, void (*errfunc)(const char*) )
+{
+   RAPIDJSON_NAMESPACE::Document doc;
+
+   if (doc.Parse<RAPIDJSON_NAMESPACE::kParseNoFlags>(json).HasParseError()) {
+      errfunc( string_format("%s:%d - ERROR - Error parsing JSON string", __FILE__, __LINE__).c_str() );
+      return FDJSON_JSON_PARSING_ERROR;
+   }
+
+   for (RAPIDJSON_NAMESPACE::Value::ConstMemberIterator it = doc.MemberBegin();
+        it != doc.MemberEnd();
+        ++it)
+   {
+      fdJsonCompileAvp( tpl.getAvps(), it->name.GetString(), it->value, errfunc );
+   }
+
+   return FDJSON_SUCCESS;
+}
+
 int fdJsonAddAvps( const char *json, msg_or_avp *msg, void (*errfunc)(const char*) )
 {
    int ret = FDJSON_SUCCESS;
-   RAPIDJSON_NAMESPACE::Document doc;
+   FDJsonTemplate tpl( "" );
 
    if (!json) {
       errfunc( string_format("%s:%d - ERROR - Error parsing JSON string", __FILE__, __LINE__).c_str() );
       return FDJSON_JSON_PARSING_ERROR;
    }
 
-   if (doc.Parse<RAPIDJSON_NAMESPACE::kParseNoFlags>(json).HasParseError()) {
+   try
+   {
+      ret = fdJsonCompile( json, tpl, errfunc );
+      if (ret == FDJSON_SUCCESS)
+         tpl.addTo( msg );
+   }
+   catch (runtimeError &ex)
+   {
+      errfunc( ex.what() );
+      ret = FDJSON_EXCEPTION;
+   }
+
+   return ret;
+}
+
+int fdJsonAddAvpsCached( const char *json, msg_or_avp *msg, void (*errfunc)(const char*) )
+{
+   int ret = FDJSON_SUCCESS;
+
+   if (!json) {
       errfunc( string_format("%s:%d - ERROR - Error parsing JSON string", __FILE__, __LINE__).c_str() );
       return FDJSON_JSON_PARSING_ERROR;
    }
 
+   std::string text( json );
+   size_t key = std::hash<std::string>()( text );
+
    try
    {
-      for (RAPIDJSON_NAMESPACE::Value::ConstMemberIterator it = doc.MemberBegin();
-           it != doc.MemberEnd();
-           ++it)
+      FDJsonTemplatePtr tpl = templateCache.lookup( key, text );
+
+      if ( !tpl )
       {
-         fdJsonAddAvp( msg, it->name.GetString(), it->value, errfunc );
+         tpl.reset( new FDJsonTemplate( text ) );
+
+         ret = fdJsonCompile( json, *tpl, errfunc );
+         if (ret != FDJSON_SUCCESS)
+            return ret;
+
+         templateCache.insert( key, tpl );
       }
+
+      tpl->addTo( msg );
    }
    catch (runtimeError &ex)
    {
@@ -730,6 +866,16 @@ int fdJsonAddAvps( const char *json, msg_or_avp *msg, void (*errfunc)(const char
    return ret;
 }
 
+void fdJsonTemplateCacheSetSize( size_t size )
+{
+   templateCache.setSize( size );
+}
+
+void fdJsonTemplateFlush( void )
+{
+   templateCache.flush();
+}
+
 std::string fdJsonBinaryToHex( const unsigned char *buffer, size_t len )
 {
    static const char *hexDigits = "0123456789ABCDEF";
@@ -0,0 +1,187 @@
+/*
+* Copyright (c) 2017 Sprint
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+// Exercises the DNS cache against a stub name server listening on the loopback:
+// coalescing of identical queries, negative caching and refresh-ahead.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cdnscache.h"
+
+#define STUB_DELAY_US      100000   // answers are late enough for identical queries to overlap
+#define STUB_TTL           2
+#define COALESCED_QUERIES  10
+
+static std::atomic<int> stubQueries( 0 );
+static int failures = 0;
+
+#define CHECK(cond) \
+   do { if ( !(cond) ) { fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); failures++; } } while (0)
+
+// Answers an A record for any name, NXDOMAIN for the names containing "missing"
+static void stubServer( int fd )
+{
+   unsigned char req[512];
+   unsigned char rsp[512];
+
+   while ( true )
+   {
+      struct sockaddr_in from;
+      socklen_t fromlen = sizeof(from);
+      int len = recvfrom( fd, req, sizeof(req), 0, (struct sockaddr*)&from, &fromlen );
+
+      if ( len <= 12 )
+         continue;
+      stubQueries++;
+      usleep( STUB_DELAY_US );
+
+      // header, then the question: labels, type and class
+      int qend = 12;
+      while ( qend < len && req[qend] )
+         qend += req[qend] + 1;
+      qend += 5;
+      if ( qend > len )
+         continue;
+
+      bool nxdomain = memmem( req + 12, qend - 12, "missing", 7 ) != NULL;
+      int rsplen = qend;
+
+      memcpy( rsp, req, qend );
+      rsp[2] = 0x81;                        // response, recursion desired
+      rsp[3] = nxdomain ? 0x83 : 0x80;      // recursion available, NXDOMAIN
+      rsp[6] = 0;
+      rsp[7] = nxdomain ? 0 : 1;            // answers
+      rsp[8] = rsp[9] = rsp[10] = rsp[11] = 0;
+      if ( !nxdomain )
+      {
+         const unsigned char answer[] = { 0xc0, 0x0c, 0, 1, 0, 1, 0, 0, 0, STUB_TTL, 0, 4, 127, 0, 0, 2 };
+         memcpy( rsp + rsplen, answer, sizeof(answer) );
+         rsplen += sizeof(answer);
+      }
+      sendto( fd, rsp, rsplen, 0, (struct sockaddr*)&from, fromlen );
+   }
+}
+
+static void testCoalescing( CachedDNS::Cache &cache )
+{
+   std::vector<std::thread> threads;
+   std::atomic<int> answered( 0 );
+   int sent = stubQueries;
+
+   for ( int i = 0; i < COALESCED_QUERIES; i++ )
+   {
+      threads.emplace_back( [&]
+      {
+         bool cacheHit = false;
+         CachedDNS::Query *q = cache.query( ns_t_a, "a.test", cacheHit );
+         if ( q && q->getAnswers().size() == 1 )
+            answered++;
+      } );
+   }
+   for ( auto &t : threads )
+      t.join();
+
+   CHECK( answered == COALESCED_QUERIES );
+   CHECK( stubQueries - sent == 1 );
+}
+
+static void testNegativeCaching( CachedDNS::Cache &cache )
+{
+   bool cacheHit = false;
+   int sent = stubQueries;
+
+   CachedDNS::Query *q = cache.query( ns_t_a, "missing.test", cacheHit );
+   CHECK( q != NULL && q->isNegative() );
+   CHECK( !cacheHit );
+
+   q = cache.query( ns_t_a, "missing.test", cacheHit );
+   CHECK( q != NULL && q->isNegative() );
+   CHECK( cacheHit );
+   CHECK( stubQueries - sent == 1 );
+}
+
+static void testRefreshAhead( CachedDNS::Cache &cache )
+{
+   bool cacheHit = false;
+   int sent = stubQueries;
+   CachedDNS::Query *first = cache.query( ns_t_a, "a.test", cacheHit );
+
+   // hit the entry until it enters the refresh window, it is served from the cache all along
+   for ( int i = 0; i < STUB_TTL * 10 && stubQueries == sent; i++ )
+   {
+      CachedDNS::Query *q = cache.query( ns_t_a, "a.test", cacheHit );
+      CHECK( q != NULL && cacheHit );
+      usleep( 100000 );
+   }
+   CHECK( stubQueries - sent == 1 );
+
+   // the refreshed entry replaces the first answer, without being refreshed again
+   cache.setRefreshAhead( 0 );
+   usleep( 3 * STUB_DELAY_US );
+   CachedDNS::Query *q = cache.query( ns_t_a, "a.test", cacheHit );
+   CHECK( q != NULL && cacheHit && q != first && !q->isExpired() );
+   CHECK( stubQueries - sent == 1 );
+}
+
+int main( int argc, char *argv[] )
+{
+   int fd = socket( AF_INET, SOCK_DGRAM, 0 );
+   struct sockaddr_in addr;
+   socklen_t addrlen = sizeof(addr);
+
+   memset( &addr, 0, sizeof(addr) );
+   addr.sin_family = AF_INET;
+   addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+   if ( fd < 0 || bind( fd, (struct sockaddr*)&addr, sizeof(addr) ) < 0 ||
+        getsockname( fd, (struct sockaddr*)&addr, &addrlen ) < 0 )
+   {
+      perror( "stub name server" );
+      return EXIT_FAILURE;
+   }
+   std::thread( stubServer, fd ).detach();
+
+   CachedDNS::Cache &cache = CachedDNS::Cache::getInstance();
+   char servers[32];
+   snprintf( servers, sizeof(servers), "127.0.0.1:%u", ntohs(addr.sin_port) );
+   cache.setNameServers( servers );
+   cache.setNegativeTTL( 10 );
+   cache.setRefreshAhead( 60 );
+
+   testCoalescing( cache );
+   testNegativeCaching( cache );
+   testRefreshAhead( cache );
+
+   CachedDNS::CacheStatistics stats;
+   cache.getStatistics( stats );
+   CHECK( stats.coalesced == COALESCED_QUERIES - 1 );
+   CHECK( stats.refreshes == 1 );
+   CHECK( stats.negativeHits == 1 );
+
+   printf( "%d failures\n", failures );
+   fflush( stdout );
+   // the stub server thread never returns
+   _exit( failures ? EXIT_FAILURE : EXIT_SUCCESS );
+}
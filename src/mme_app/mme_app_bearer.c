@@ -982,6 +982,7 @@ mme_app_handle_create_sess_resp (
   mme_ue_s1ap_id_t                         mme_ue_s1ap_id;
 
   DevAssert (create_sess_resp_pP );
+  mme_app_wrr_transaction_end(create_sess_resp_pP->peer_ip, S11_SGW_GTP_C);
   ue_context = mme_ue_context_exists_s11_teid (&mme_app_desc.mme_ue_contexts, create_sess_resp_pP->teid);
   if (ue_context == NULL) {
     MSC_LOG_RX_DISCARDED_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 CREATE_SESSION_RESPONSE local S11 teid " TEID_FMT " ", create_sess_resp_pP->teid);
@@ -61,6 +61,7 @@
 #include "s1ap_mme.h"
 #include "common_defs.h"
 #include "esm_ebr.h"
+#include "mme_app_snapshot.h"
 
 // todo: think about locking the MME_APP context or EMM context, which one to lock, why to lock at all? lock seperately?
 ////------------------------------------------------------------------------------
@@ -796,6 +797,8 @@ void mme_remove_ue_context (
   DevAssert (mme_ue_context_p);
   DevAssert (ue_context);
 
+  mme_app_snapshot_ue_remove (ue_context);
+
   // IMSI
   if (ue_context->imsi) {
     hash_rc = hashtable_uint64_ts_remove (mme_ue_context_p->imsi_ue_context_htbl, (const hash_key_t)ue_context->imsi);
@@ -1699,6 +1702,7 @@ void mme_ue_context_update_ue_sig_connection_state (
       // Update Stats
       update_mme_app_stats_connected_ue_sub();
     }
+    mme_app_snapshot_ue_checkpoint (ue_context);
 
   }else if ((ue_context->ecm_state == ECM_IDLE) && (new_ecm_state == ECM_CONNECTED))
   {
@@ -1811,13 +1815,245 @@ mme_app_handle_s1ap_ue_context_release_req (
 //}
 
 
+/*
+ * Bulk UE release (S1 Reset, SCTP association loss).
+ * The UEs of the eNB are copied into a job and released by bounded time slices driven by a one shot timer, so that the
+ * MME_APP task keeps on serving the other eNBs between two slices. Release Access Bearers Requests are paced per SGW
+ * with a token bucket.
+ */
+//------------------------------------------------------------------------------
+static uint64_t _mme_app_bulk_release_now_us (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000) + ((uint64_t)ts.tv_nsec / 1000);
+}
+
+//------------------------------------------------------------------------------
+static void _mme_app_bulk_release_schedule (const uint32_t usec)
+{
+  if (MME_APP_TIMER_INACTIVE_ID != mme_app_desc.bulk_release.timer_id) {
+    return;
+  }
+  if (timer_setup (usec / 1000000, usec % 1000000, TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, NULL, &mme_app_desc.bulk_release.timer_id) < 0) {
+    OAILOG_ERROR (LOG_MME_APP, "Failed to start the bulk UE release timer, releasing the pending UEs on the next eNB event\n");
+    mme_app_desc.bulk_release.timer_id = MME_APP_TIMER_INACTIVE_ID;
+  }
+}
+
+//------------------------------------------------------------------------------
+static mme_app_bulk_release_sgw_t * _mme_app_bulk_release_get_sgw (const struct in_addr sgw_ip, const uint64_t now_us)
+{
+  mme_app_bulk_release_sgw_t             *sgw = NULL;
+
+  for (int i = 0; i < mme_app_desc.bulk_release.nb_sgws; i++) {
+    if (mme_app_desc.bulk_release.sgws[i].sgw_ip.s_addr == sgw_ip.s_addr) {
+      sgw = &mme_app_desc.bulk_release.sgws[i];
+      break;
+    }
+  }
+  if (!sgw) {
+    if (MME_APP_BULK_RELEASE_MAX_SGW > mme_app_desc.bulk_release.nb_sgws) {
+      sgw = &mme_app_desc.bulk_release.sgws[mme_app_desc.bulk_release.nb_sgws++];
+    } else {
+      // Recycle the least recently used bucket
+      sgw = &mme_app_desc.bulk_release.sgws[0];
+      for (int i = 1; i < MME_APP_BULK_RELEASE_MAX_SGW; i++) {
+        if (mme_app_desc.bulk_release.sgws[i].last_refill_us < sgw->last_refill_us) {
+          sgw = &mme_app_desc.bulk_release.sgws[i];
+        }
+      }
+    }
+    sgw->sgw_ip = sgw_ip;
+    sgw->tokens = MME_APP_BULK_RELEASE_SGW_RAB_BURST;
+    sgw->last_refill_us = now_us;
+    return sgw;
+  }
+  uint64_t refill = ((now_us - sgw->last_refill_us) * MME_APP_BULK_RELEASE_SGW_RAB_PER_SEC) / 1000000;
+  if (refill) {
+    sgw->tokens = (sgw->tokens + refill > MME_APP_BULK_RELEASE_SGW_RAB_BURST) ? MME_APP_BULK_RELEASE_SGW_RAB_BURST : sgw->tokens + refill;
+    sgw->last_refill_us += (refill * 1000000) / MME_APP_BULK_RELEASE_SGW_RAB_PER_SEC;
+  }
+  return sgw;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Returns 0 if the UE may be released now, else the number of microseconds to wait for a Release Access Bearers Request
+ * token of its SGW.
+ */
+static uint32_t _mme_app_bulk_release_take_token (const mme_app_bulk_release_ue_t * const ue, const uint64_t now_us)
+{
+  struct ue_context_s                    *ue_context = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, ue->mme_ue_s1ap_id);
+
+  // Only REGISTERED and connected UEs trigger a Release Access Bearers Request
+  if ((!ue_context) || (UE_REGISTERED != ue_context->mm_state) || (ECM_IDLE == ue_context->ecm_state)) {
+    return 0;
+  }
+  pdn_context_t                          *pdn_context = RB_MIN(PdnContexts, &ue_context->pdn_contexts);
+  if (!pdn_context) {
+    return 0;
+  }
+  mme_app_bulk_release_sgw_t             *sgw = _mme_app_bulk_release_get_sgw (pdn_context->s_gw_address_s11_s4.address.ipv4_address, now_us);
+  if (!sgw->tokens) {
+    return (uint32_t)((sgw->last_refill_us + (1000000 / MME_APP_BULK_RELEASE_SGW_RAB_PER_SEC)) - now_us);
+  }
+  sgw->tokens--;
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Returns false if the UE context is no longer bound to the S1 connection of the job entry (the UE reconnected through
+ * the same or another eNB while the job was paced), the new connection must not be released then.
+ */
+static bool _mme_app_bulk_release_ue_is_bound (const mme_app_bulk_release_ue_t * const ue, const struct ue_context_s * const ue_context)
+{
+  // no context for the MME UE S1AP id: the release looks the UE up by its eNB key
+  return (!ue_context) || (ue_context->enb_s1ap_id_key == ue->enb_s1ap_id_key);
+}
+
+//------------------------------------------------------------------------------
+// enb_ue_s1ap_id may be NULL (partial reset by MME UE S1AP id only), the current S1 connection of the UE is kept then.
+static void _mme_app_bulk_release_add_ue (mme_app_bulk_release_job_t * const job, const mme_ue_s1ap_id_t mme_ue_s1ap_id, const enb_ue_s1ap_id_t * const enb_ue_s1ap_id)
+{
+  mme_app_bulk_release_ue_t              *ue = &job->ues[job->nb_ues++];
+
+  ue->mme_ue_s1ap_id = mme_ue_s1ap_id;
+  ue->enb_ue_s1ap_id = (enb_ue_s1ap_id) ? *enb_ue_s1ap_id : 0;
+  if (enb_ue_s1ap_id) {
+    MME_APP_ENB_S1AP_ID_KEY(ue->enb_s1ap_id_key, job->enb_id, *enb_ue_s1ap_id);
+  } else {
+    struct ue_context_s                  *ue_context = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, mme_ue_s1ap_id);
+
+    ue->enb_s1ap_id_key = (ue_context) ? ue_context->enb_s1ap_id_key : INVALID_ENB_UE_S1AP_ID_KEY;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void _mme_app_bulk_release_run_slice (void)
+{
+  mme_app_bulk_release_job_t             *job = NULL;
+  uint64_t                                start_us = _mme_app_bulk_release_now_us ();
+  uint64_t                                now_us = start_us;
+  uint32_t                                wait_us = 0;
+  int                                     nb_released = 0;
+
+  OAILOG_FUNC_IN (LOG_MME_APP);
+  while ((job = STAILQ_FIRST (&mme_app_desc.bulk_release.jobs))) {
+    while (job->next_ue < job->nb_ues) {
+      if ((MME_APP_BULK_RELEASE_SLICE_UES <= nb_released) || (MME_APP_BULK_RELEASE_SLICE_USEC <= now_us - start_us)) {
+        _mme_app_bulk_release_schedule (MME_APP_BULK_RELEASE_YIELD_USEC);
+        OAILOG_FUNC_OUT (LOG_MME_APP);
+      }
+      mme_app_bulk_release_ue_t          *ue = &job->ues[job->next_ue];
+      if (!_mme_app_bulk_release_ue_is_bound (ue, mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, ue->mme_ue_s1ap_id))) {
+        OAILOG_DEBUG (LOG_MME_APP, "Bulk release of eNB %u: UE " MME_UE_S1AP_ID_FMT " reconnected since, not released\n", job->enb_id, ue->mme_ue_s1ap_id);
+        job->next_ue++;
+        continue;
+      }
+      if ((wait_us = _mme_app_bulk_release_take_token (ue, now_us))) {
+        /*
+         * The SGW of the next UE is saturated: keep the release order and wait for its bucket to refill.
+         * The remaining UEs of the job (possibly of other SGWs) wait behind it.
+         */
+        OAILOG_DEBUG (LOG_MME_APP, "Bulk release of eNB %u: SGW pacing, resuming in %u us (%u/%u UEs released)\n",
+            job->enb_id, wait_us, job->next_ue, job->nb_ues);
+        _mme_app_bulk_release_schedule ((MME_APP_BULK_RELEASE_YIELD_USEC > wait_us) ? MME_APP_BULK_RELEASE_YIELD_USEC : wait_us);
+        OAILOG_FUNC_OUT (LOG_MME_APP);
+      }
+      if (job->nas_signalling_rel_ind) {
+        mme_app_send_nas_signalling_connection_rel_ind (ue->mme_ue_s1ap_id); /**< If any procedures were ongoing, kill them. */
+      }
+      _mme_app_handle_s1ap_ue_context_release (ue->mme_ue_s1ap_id, ue->enb_ue_s1ap_id, job->enb_id, job->cause);
+      job->next_ue++;
+      nb_released++;
+      now_us = _mme_app_bulk_release_now_us ();
+    }
+    OAILOG_INFO (LOG_MME_APP, "Bulk release of the %u UEs of eNB %u done\n", job->nb_ues, job->enb_id);
+    STAILQ_REMOVE_HEAD (&mme_app_desc.bulk_release.jobs, entries);
+    free_wrapper ((void **) &job);
+  }
+  OAILOG_FUNC_OUT (LOG_MME_APP);
+}
+
+//------------------------------------------------------------------------------
+static mme_app_bulk_release_job_t * _mme_app_bulk_release_new_job (const uint32_t enb_id, const uint32_t nb_ues, const enum s1cause cause, const bool nas_signalling_rel_ind)
+{
+  mme_app_bulk_release_job_t             *job = calloc (1, sizeof (mme_app_bulk_release_job_t) + nb_ues * sizeof (mme_app_bulk_release_ue_t));
+
+  if (job) {
+    job->enb_id = enb_id;
+    job->cause = cause;
+    job->nas_signalling_rel_ind = nas_signalling_rel_ind;
+  } else {
+    OAILOG_ERROR (LOG_MME_APP, "Failed to allocate the bulk release job of the %u UEs of eNB %u\n", nb_ues, enb_id);
+  }
+  return job;
+}
+
+//------------------------------------------------------------------------------
+static void _mme_app_bulk_release_start_job (mme_app_bulk_release_job_t * const job)
+{
+  if (!job->nb_ues) {
+    free_wrapper ((void **) &job);
+    return;
+  }
+  OAILOG_INFO (LOG_MME_APP, "Starting the bulk release of the %u UEs of eNB %u\n", job->nb_ues, job->enb_id);
+  STAILQ_INSERT_TAIL (&mme_app_desc.bulk_release.jobs, job, entries);
+  if (MME_APP_TIMER_INACTIVE_ID == mme_app_desc.bulk_release.timer_id) {
+    // First slice right away, the rest is paced
+    _mme_app_bulk_release_run_slice ();
+  }
+}
+
+//------------------------------------------------------------------------------
+void mme_app_bulk_release_init (void)
+{
+  STAILQ_INIT (&mme_app_desc.bulk_release.jobs);
+  mme_app_desc.bulk_release.timer_id = MME_APP_TIMER_INACTIVE_ID;
+  mme_app_desc.bulk_release.nb_sgws = 0;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_bulk_release_exit (void)
+{
+  mme_app_bulk_release_job_t             *job = NULL;
+
+  if (MME_APP_TIMER_INACTIVE_ID != mme_app_desc.bulk_release.timer_id) {
+    timer_remove (mme_app_desc.bulk_release.timer_id, NULL);
+    mme_app_desc.bulk_release.timer_id = MME_APP_TIMER_INACTIVE_ID;
+  }
+  while ((job = STAILQ_FIRST (&mme_app_desc.bulk_release.jobs))) {
+    STAILQ_REMOVE_HEAD (&mme_app_desc.bulk_release.jobs, entries);
+    free_wrapper ((void **) &job);
+  }
+}
+
+//------------------------------------------------------------------------------
+bool mme_app_bulk_release_handle_timer_expiry (const long timer_id)
+{
+  if ((MME_APP_TIMER_INACTIVE_ID == mme_app_desc.bulk_release.timer_id) || (timer_id != mme_app_desc.bulk_release.timer_id)) {
+    return false;
+  }
+  mme_app_desc.bulk_release.timer_id = MME_APP_TIMER_INACTIVE_ID;
+  _mme_app_bulk_release_run_slice ();
+  return true;
+}
+
 //------------------------------------------------------------------------------
 void mme_app_handle_s1ap_enb_deregistered_ind (const itti_s1ap_eNB_deregistered_ind_t * const enb_dereg_ind)
 {
+  mme_app_bulk_release_job_t             *job = _mme_app_bulk_release_new_job (enb_dereg_ind->enb_id, enb_dereg_ind->nb_ue_to_deregister, S1AP_SCTP_SHUTDOWN_OR_RESET, true);
+
+  if (!job) {
+    return;
+  }
   for (int ue_idx = 0; ue_idx < enb_dereg_ind->nb_ue_to_deregister; ue_idx++) {
-      mme_app_send_nas_signalling_connection_rel_ind(enb_dereg_ind->mme_ue_s1ap_id[ue_idx]); /**< If any procedures were ongoing, kill them. */
-      _mme_app_handle_s1ap_ue_context_release(enb_dereg_ind->mme_ue_s1ap_id[ue_idx], enb_dereg_ind->enb_ue_s1ap_id[ue_idx], enb_dereg_ind->enb_id, S1AP_SCTP_SHUTDOWN_OR_RESET);
+    _mme_app_bulk_release_add_ue (job, enb_dereg_ind->mme_ue_s1ap_id[ue_idx], &enb_dereg_ind->enb_ue_s1ap_id[ue_idx]);
   }
+  _mme_app_bulk_release_start_job (job);
 }
 
 //------------------------------------------------------------------------------
@@ -1826,29 +2062,21 @@ mme_app_handle_enb_reset_req (const itti_s1ap_enb_initiated_reset_req_t * const
 {
 
   MessageDef *message_p;
+  mme_app_bulk_release_job_t             *job = NULL;
   OAILOG_DEBUG (LOG_MME_APP, " eNB Reset request received. eNB id = %d, reset_type  %d \n ", enb_reset_req->enb_id, enb_reset_req->s1ap_reset_type);
   DevAssert (enb_reset_req->ue_to_reset_list != NULL);
-  if (enb_reset_req->s1ap_reset_type == RESET_ALL) {
-  // Full Reset. Trigger UE Context release release for all the connected UEs.
-    for (int i = 0; i < enb_reset_req->num_ue; i++) {
-      _mme_app_handle_s1ap_ue_context_release(*(enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id),
-                                            *(enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id),
-                                            enb_reset_req->enb_id,
-                                            S1AP_SCTP_SHUTDOWN_OR_RESET);
-    }
-
-  } else { // Partial Reset
-    for (int i = 0; i < enb_reset_req->num_ue; i++) {
-      if (enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id == NULL &&
-                          enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id == NULL)
-        continue;
-      else
-        _mme_app_handle_s1ap_ue_context_release(*(enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id),
-                                            *(enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id),
-                                            enb_reset_req->enb_id,
-                                            S1AP_SCTP_SHUTDOWN_OR_RESET);
-    }
-
+  /*
+   * Copy the UEs to release (full reset: all the connected UEs, partial reset: the listed ones) before handing the
+   * list over to S1AP, the releases themselves are paced after the Reset Ack.
+   */
+  job = _mme_app_bulk_release_new_job (enb_reset_req->enb_id, enb_reset_req->num_ue, S1AP_SCTP_SHUTDOWN_OR_RESET, false);
+  for (int i = 0; (job) && (i < enb_reset_req->num_ue); i++) {
+    if (enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id == NULL &&
+                        enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id == NULL)
+      continue;
+    _mme_app_bulk_release_add_ue (job,
+        (enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id) ? *(enb_reset_req->ue_to_reset_list[i].mme_ue_s1ap_id) : INVALID_MME_UE_S1AP_ID,
+        enb_reset_req->ue_to_reset_list[i].enb_ue_s1ap_id);
   }
   // Send Reset Ack to S1AP module
 
@@ -1867,6 +2095,9 @@ mme_app_handle_enb_reset_req (const itti_s1ap_enb_initiated_reset_req_t * const
   S1AP_ENB_INITIATED_RESET_ACK (message_p).ue_to_reset_list = enb_reset_req->ue_to_reset_list;
   itti_send_msg_to_task (TASK_S1AP, INSTANCE_DEFAULT, message_p);
   OAILOG_DEBUG (LOG_MME_APP, " Reset Ack sent to S1AP. eNB id = %d, reset_type  %d \n ", enb_reset_req->enb_id, enb_reset_req->s1ap_reset_type);
+  if (job) {
+    _mme_app_bulk_release_start_job (job);
+  }
   OAILOG_FUNC_OUT (LOG_MME_APP);
 }
 
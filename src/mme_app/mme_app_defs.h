@@ -37,6 +37,37 @@
 #include "intertask_interface.h"
 #include "mme_app_ue_context.h"
 
+/* Bulk release of the UEs of an eNB (S1 Reset, SCTP association loss) */
+#define MME_APP_BULK_RELEASE_SLICE_UES         64     ///< max UEs released per time slice
+#define MME_APP_BULK_RELEASE_SLICE_USEC        2000   ///< max duration of a time slice
+#define MME_APP_BULK_RELEASE_YIELD_USEC        1000   ///< pause between two slices, other MME_APP messages are served meanwhile
+#define MME_APP_BULK_RELEASE_SGW_RAB_PER_SEC   1000   ///< Release Access Bearers Requests per second towards one SGW
+#define MME_APP_BULK_RELEASE_SGW_RAB_BURST     64
+#define MME_APP_BULK_RELEASE_MAX_SGW           16
+
+typedef struct mme_app_bulk_release_ue_s {
+  mme_ue_s1ap_id_t  mme_ue_s1ap_id;
+  enb_ue_s1ap_id_t  enb_ue_s1ap_id;
+  enb_s1ap_id_key_t enb_s1ap_id_key;  ///< S1 connection to release, the UE may have reconnected while the job was paced
+} mme_app_bulk_release_ue_t;
+
+typedef struct mme_app_bulk_release_job_s {
+  STAILQ_ENTRY(mme_app_bulk_release_job_s) entries;
+  uint32_t                   enb_id;
+  enum s1cause               cause;
+  bool                       nas_signalling_rel_ind;  ///< abort the running NAS procedures first (SCTP association loss)
+  uint32_t                   nb_ues;
+  uint32_t                   next_ue;
+  mme_app_bulk_release_ue_t  ues[];
+} mme_app_bulk_release_job_t;
+
+/* Token bucket pacing the Release Access Bearers Requests of a bulk release towards one SGW */
+typedef struct mme_app_bulk_release_sgw_s {
+  struct in_addr             sgw_ip;
+  uint32_t                   tokens;
+  uint64_t                   last_refill_us;
+} mme_app_bulk_release_sgw_t;
+
 typedef struct mme_app_desc_s {
   /* UE contexts + some statistics variables */
   mme_ue_context_t mme_ue_contexts;
@@ -44,6 +75,14 @@ typedef struct mme_app_desc_s {
   long statistic_timer_id;
   uint32_t statistic_timer_period;
 
+  /* Bulk UE releases, only accessed by the MME_APP task */
+  struct {
+    STAILQ_HEAD(mme_app_bulk_release_jobs_s, mme_app_bulk_release_job_s) jobs;
+    long                        timer_id;
+    mme_app_bulk_release_sgw_t  sgws[MME_APP_BULK_RELEASE_MAX_SGW];
+    int                         nb_sgws;
+  } bulk_release;
+
 
   uint32_t mme_mobility_management_timer_period;
 
@@ -81,6 +120,12 @@ extern mme_app_desc_t mme_app_desc;
 
 void mme_app_handle_s1ap_enb_deregistered_ind (const itti_s1ap_eNB_deregistered_ind_t * const enb_dereg_ind);
 
+void mme_app_bulk_release_init (void);
+
+void mme_app_bulk_release_exit (void);
+
+bool mme_app_bulk_release_handle_timer_expiry (const long timer_id);
+
 int mme_app_handle_s1ap_ue_capabilities_ind  (const itti_s1ap_ue_cap_ind_t * const s1ap_ue_cap_ind_pP);
 
 void mme_app_handle_s1ap_ue_context_release_complete (const itti_s1ap_ue_context_release_complete_t * const s1ap_ue_context_release_complete);
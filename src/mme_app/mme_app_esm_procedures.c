@@ -46,6 +46,7 @@
 #include "mme_app_extern.h"
 #include "mme_app_defs.h"
 #include "common_defs.h"
+#include "mem_arena.h"
 #include "mme_app_esm_procedures.h"
 
 /*---------------------------------------------------------------------------
@@ -80,6 +81,32 @@
 static void mme_app_nas_esm_free_bearer_context_proc(nas_esm_proc_bearer_context_t **esm_proc_bearer_context);
 static void mme_app_nas_esm_free_pdn_connectivity_proc(nas_esm_proc_pdn_connectivity_t **esm_proc_pdn_connectivity);
 
+//------------------------------------------------------------------------------
+// The procedure is the first allocation of its own arena.
+static void *mme_app_nas_esm_alloc_proc(const size_t proc_size)
+{
+  mem_arena_t    *arena = mem_arena_create();
+  nas_esm_proc_t *esm_base_proc = NULL;
+
+  if (arena) {
+    esm_base_proc = mem_arena_alloc(arena, proc_size);
+    if (esm_base_proc) {
+      esm_base_proc->arena = arena;
+    } else {
+      mem_arena_destroy(&arena);
+    }
+  }
+  return esm_base_proc;
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_nas_esm_release_proc(nas_esm_proc_t ** esm_base_proc)
+{
+  mem_arena_t    *arena = (*esm_base_proc)->arena;
+  *esm_base_proc = NULL;
+  mem_arena_destroy(&arena);
+}
+
 //------------------------------------------------------------------------------
 void mme_app_nas_esm_free_pdn_connectivity_procedures(ue_context_t * const ue_context)
 {
@@ -122,7 +149,10 @@ nas_esm_proc_pdn_connectivity_t* mme_app_nas_esm_create_pdn_connectivity_procedu
   }
 
   // TODO: LOCK_UE_CONTEXT
-  esm_proc_pdn_connectivity = calloc(1, sizeof(nas_esm_proc_pdn_connectivity_t));
+  esm_proc_pdn_connectivity = mme_app_nas_esm_alloc_proc(sizeof(nas_esm_proc_pdn_connectivity_t));
+  if (!esm_proc_pdn_connectivity) {
+    OAILOG_FUNC_RETURN(LOG_MME_APP, NULL);
+  }
   esm_proc_pdn_connectivity->esm_base_proc.pti  = pti;
   esm_proc_pdn_connectivity->esm_base_proc.type = ESM_PROC_PDN_CONTEXT;
   esm_proc_pdn_connectivity->esm_base_proc.ue_id = ue_id;
@@ -165,7 +195,10 @@ nas_esm_proc_bearer_context_t* mme_app_nas_esm_create_bearer_context_procedure(m
   }
 
   // TODO: LOCK_UE_CONTEXT
-  esm_proc_bearer_context = calloc(1, sizeof(nas_esm_proc_bearer_context_t));
+  esm_proc_bearer_context = mme_app_nas_esm_alloc_proc(sizeof(nas_esm_proc_bearer_context_t));
+  if (!esm_proc_bearer_context) {
+    OAILOG_FUNC_RETURN(LOG_MME_APP, NULL);
+  }
   esm_proc_bearer_context->esm_base_proc.ue_id = ue_id;
   esm_proc_bearer_context->esm_base_proc.pti   = pti;
   esm_proc_bearer_context->esm_base_proc.type  = ESM_PROC_EPS_BEARER_CONTEXT;
@@ -230,15 +263,12 @@ static void mme_app_nas_esm_free_pdn_connectivity_proc(nas_esm_proc_pdn_connecti
   nas_stop_esm_timer((*esm_proc_pdn_connectivity)->esm_base_proc.ue_id,
       &((*esm_proc_pdn_connectivity)->esm_base_proc.esm_proc_timer));
   /**
-   * Free components of the PDN connectivity procedure.
+   * Free components of the PDN connectivity procedure, the subscribed APN lives in the procedure arena.
    */
-  if((*esm_proc_pdn_connectivity)->subscribed_apn)
-    bdestroy_wrapper(&((*esm_proc_pdn_connectivity)->subscribed_apn));
-
   /** Clear the protocol configuration options. */
   clear_protocol_configuration_options(&((*esm_proc_pdn_connectivity)->pco));
 
-  free_wrapper((void**)esm_proc_pdn_connectivity);
+  mme_app_nas_esm_release_proc((nas_esm_proc_t**)esm_proc_pdn_connectivity);
 }
 
 
@@ -314,6 +344,6 @@ static void mme_app_nas_esm_free_bearer_context_proc(nas_esm_proc_bearer_context
   if((*esm_proc_bearer_context)->tft){
     free_traffic_flow_template(&((*esm_proc_bearer_context)->tft));
   }
-  free_wrapper((void**)esm_proc_bearer_context);
+  mme_app_nas_esm_release_proc((nas_esm_proc_t**)esm_proc_bearer_context);
   // todo: UNLOCK_UE_CONTEXT
 }
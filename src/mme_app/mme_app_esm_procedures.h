@@ -71,6 +71,7 @@ typedef struct nas_esm_proc_s {
   nas_timer_t                  esm_proc_timer;
   uint8_t                      retx_count;
   pti_t                        pti;
+  struct mem_arena_s          *arena;        /**< Owns the procedure and what is scoped to it (subscribed APN). */
 } nas_esm_proc_t;
 
 /*
@@ -84,7 +85,7 @@ typedef struct nas_esm_proc_pdn_connectivity_s {
   esm_proc_pdn_request_t       request_type;
   imsi_t                       imsi;
   /** Additional elements requested from the UE and set with time.. */
-  bstring                      subscribed_apn; /**< Should be copied with bstrcpy(). */
+  bstring                      subscribed_apn; /**< Should be copied with mem_arena_bstrcpy() into the procedure arena. */
   tai_t                        visited_tai;
   pdn_cid_t                    pdn_cid;
   ebi_t                        default_ebi;
@@ -354,6 +354,8 @@ mme_app_send_s11_create_session_req (
     mme_app_select_service(serving_tai, &session_request_p->peer_ip, S11_SGW_GTP_C);
 //    session_request_p->peer_ip.in_addr = mme_config.ipv4.
   }
+  /** Accounted until the CSResp (or its transaction failure) is received. */
+  mme_app_wrr_transaction_start(session_request_p->peer_ip, S11_SGW_GTP_C);
 
   session_request_p->serving_network.mcc[0] = serving_tai->plmn.mcc_digit1;
   session_request_p->serving_network.mcc[1] = serving_tai->plmn.mcc_digit2;
@@ -39,6 +39,7 @@
 #include "log.h"
 #include "assertions.h"
 #include "intertask_interface.h"
+#include "intertask_interface_latency.h"
 #include "itti_free_defined_msg.h"
 #include "mme_config.h"
 #include "timer.h"
@@ -48,7 +49,9 @@
 #include "mme_app_statistics.h"
 #include "common_defs.h"
 #include "mme_app_edns_emulation.h"
+#include "mme_app_wrr_selection.h"
 #include "mme_app_procedures.h"
+#include "mme_app_snapshot.h"
 
 //mme_app_desc_t                          mme_app_desc;
 mme_app_desc_t                          mme_app_desc = {.rw_lock = PTHREAD_RWLOCK_INITIALIZER, 0} ;
@@ -446,8 +449,14 @@ void *mme_app_thread (void *args)
          */
         if (received_message_p->ittiMsg.timer_has_expired.timer_id == mme_app_desc.statistic_timer_id) {
           mme_app_statistics_display ();
+          itti_print_stats ();
+          itti_latency_dump ();
           /** Display the ITTI buffer. */
           itti_print_DEBUG ();
+        } else if (mme_app_bulk_release_handle_timer_expiry (received_message_p->ittiMsg.timer_has_expired.timer_id)) {
+          // next slice of an eNB bulk UE release done
+        } else if (mme_app_snapshot_handle_timer_expiry (received_message_p->ittiMsg.timer_has_expired.timer_id)) {
+          // connected UEs checkpointed
         } else if (received_message_p->ittiMsg.timer_has_expired.arg != NULL) {
           mme_ue_s1ap_id_t mme_ue_s1ap_id = *((mme_ue_s1ap_id_t *)(received_message_p->ittiMsg.timer_has_expired.arg));
           ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, mme_ue_s1ap_id);
@@ -527,9 +536,21 @@ int mme_app_init (const mme_config_t * mme_config_p)
   mme_app_desc.mme_ue_contexts.imsi_subscription_profile_htbl = hashtable_ts_create (mme_config.max_ues, NULL, NULL, b);
   bdestroy_wrapper (&b);
 
+  mme_app_bulk_release_init ();
+
+  /*
+   * Restore the UE contexts of the previous run before any message is processed.
+   */
+  if (mme_app_snapshot_init(mme_config_p)) {
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+
   if (mme_app_edns_init(mme_config_p)) {
     OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
   }
+  if (mme_app_wrr_selection_init(mme_config_p)) {
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
   /*
    * Create the thread associated with MME applicative layer
    */
@@ -559,6 +580,9 @@ void mme_app_exit (void)
 {
   // todo: also check other timers!
   timer_remove(mme_app_desc.statistic_timer_id, NULL);
+  mme_app_snapshot_exit ();
+  mme_app_bulk_release_exit ();
+  mme_app_wrr_selection_exit();
   mme_app_edns_exit();
   hashtable_uint64_ts_destroy (mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl);
   hashtable_uint64_ts_destroy (mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl);
@@ -63,6 +63,15 @@ static void mme_app_free_pdn_context (pdn_context_t ** const pdn_context);
 
 static teid_t                           mme_app_teid_generator = 0x00000001;
 
+//------------------------------------------------------------------------------
+void mme_app_reserve_s11_teid (const teid_t teid)
+{
+  teid_t current = mme_app_teid_generator;
+  while ((current <= teid) && (!__sync_bool_compare_and_swap (&mme_app_teid_generator, current, teid + 1))) {
+    current = mme_app_teid_generator;
+  }
+}
+
 //------------------------------------------------------------------------------
 void mme_app_get_pdn_context (mme_ue_s1ap_id_t ue_id, pdn_cid_t const context_id, ebi_t const default_ebi, bstring const apn_subscribed, pdn_context_t **pdn_ctx)
 {
@@ -41,6 +41,9 @@ void mme_app_esm_delete_pdn_context(mme_ue_s1ap_id_t ue_id, bstring apn, pdn_cid
 
 void mme_app_esm_detach (mme_ue_s1ap_id_t ue_id);
 
+/** Makes sure the S11 TEIDs up to teid (restored UE contexts) are not allocated again. */
+void mme_app_reserve_s11_teid (const teid_t teid);
+
 int
 mme_app_esm_update_ebr_state(const mme_ue_s1ap_id_t ue_id, const bstring apn_subscribed, const pdn_cid_t pdn_cid, const ebi_t linked_ebi, const ebi_t bearer_ebi, esm_ebr_state ebr_state);
 
@@ -0,0 +1,1077 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_app_snapshot.c
+  \brief Checkpoint of the registered UE contexts in a memory mapped log, restored at MME startup.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "assertions.h"
+#include "log.h"
+#include "common_types.h"
+#include "intertask_interface.h"
+#include "mme_config.h"
+#include "timer.h"
+#include "mme_app_ue_context.h"
+#include "mme_app_bearer_context.h"
+#include "mme_app_pdn_context.h"
+#include "mme_app_defs.h"
+#include "mme_app_statistics.h"
+#include "mme_app_snapshot.h"
+#include "common_defs.h"
+#include "emm_data.h"
+#include "s11_mme.h"
+
+#ifndef PACKAGE_VERSION
+#  define PACKAGE_VERSION "UNKNOWN-EXPERIMENTAL"
+#endif
+
+/*
+ * Record payload: snapshot_ue_t, the subscription data if any, snapshot_emm_t, then for each PDN
+ * a snapshot_pdn_t followed by its APN strings and by a snapshot_bearer_t per session bearer.
+ * Only the members listed below are kept, the EMM context itself is never copied as is. The layout
+ * fingerprint of the header covers the offset and size of each of them and the MME build.
+ */
+typedef struct snapshot_ue_s {
+  imsi64_t               imsi;
+  teid_t                 mme_teid_s11;
+  teid_t                 s_gw_teid_s11_s4;
+  bool                   is_guti_set;
+  guti_t                 guti;
+  ecgi_t                 e_utran_cgi;
+  me_identity_t          me_identity;
+  ambr_t                 subscribed_ue_ambr;
+  ard_t                  access_restriction_data;
+  rau_tau_timer_t        rau_tau_timer;
+  network_access_mode_t  access_mode;
+  network_access_mode_t  network_access_mode;
+  subscriber_status_t    sub_status;
+  subscriber_status_t    subscriber_status;
+  ebi_t                  next_def_ebi_offset;
+  uint8_t                msisdn_length;
+  char                   msisdn[MSISDN_LENGTH + 1];
+  bool                   has_subscription;
+  uint8_t                nb_pdns;
+} snapshot_ue_t;
+
+typedef struct snapshot_pdn_s {
+  context_identifier_t   context_identifier;
+  pdn_type_t             pdn_type;
+  ebi_t                  default_ebi;
+  ambr_t                 subscribed_apn_ambr;
+  ip_address_t           p_gw_address_s5_s8_cp;
+  teid_t                 p_gw_teid_s5_s8_cp;
+  ip_address_t           s_gw_address_s11_s4;
+  teid_t                 s_gw_teid_s11_s4;
+  bool                   has_paa;
+  paa_t                  paa;
+  uint16_t               apn_in_use_length;
+  uint16_t               apn_subscribed_length;
+  uint16_t               apn_oi_replacement_length;
+  uint8_t                nb_bearers;
+} snapshot_pdn_t;
+
+typedef struct snapshot_bearer_s {
+  ebi_t                  ebi;
+  ebi_t                  linked_ebi;
+  pdn_cid_t              pdn_cx_id;
+  fteid_t                s_gw_fteid_s1u;
+  fteid_t                p_gw_fteid_s5_s8_up;
+  bearer_qos_t           bearer_level_qos;
+  esm_ebr_state          esm_ebr_status;
+  bool                   has_tft;
+  traffic_flow_template_t tft;               ///< packet filters only, the parameters list is not kept
+} snapshot_bearer_t;
+
+typedef struct snapshot_security_s {
+  emm_sc_type_t          sc_type;
+  ksi_t                  eksi;
+  int32_t                vector_index;
+  uint8_t                knas_enc[AUTH_KNAS_ENC_SIZE];
+  uint8_t                knas_int[AUTH_KNAS_INT_SIZE];
+  uint8_t                ncc;
+  uint8_t                nh_conj[AUTH_NH_SIZE];
+  uint32_t               dl_count;           ///< (overflow << 8) | seq_num
+  uint32_t               ul_count;
+  uint8_t                eps_encryption;
+  uint8_t                eps_integrity;
+  uint8_t                umts_encryption;
+  uint8_t                umts_integrity;
+  uint8_t                gprs_encryption;
+  bool                   umts_present;
+  bool                   gprs_present;
+  uint8_t                selected_encryption;
+  uint8_t                selected_integrity;
+  uint8_t                activated;
+  uint8_t                direction_encode;
+  uint8_t                direction_decode;
+} snapshot_security_t;
+
+typedef struct snapshot_emm_s {
+  mme_ue_s1ap_id_t       ue_id;
+  bool                   is_emergency;
+  bool                   is_has_been_attached;
+  bool                   is_initial_identity_imsi;
+  bool                   is_guti_based_attach;
+  uint8_t                attach_type;
+  additional_update_type_t additional_update_type;
+  uint32_t               member_present_mask;
+  uint32_t               member_valid_mask;
+  imsi_t                 imsi;
+  imsi64_t               imsi64;
+  imei_t                 imei;
+  imeisv_t               imeisv;
+  guti_t                 guti;
+  tai_list_t             tai_list;
+  tai_t                  lvr_tai;
+  tai_t                  originating_tai;
+  ksi_t                  ksi;
+  ue_network_capability_t ue_network_capability;
+  ms_network_capability_t ms_network_capability;
+  drx_parameter_t        drx_parameter;
+  drx_parameter_t        current_drx_parameter;
+  auth_vector_t          vector;             ///< of the current security context, the others are fetched again from the HSS
+  snapshot_security_t    security;
+  snapshot_security_t    non_current_security;
+} snapshot_emm_t;
+
+static struct {
+  int                     fd;
+  uint8_t                *map;
+  uint64_t                map_size;
+  uint64_t                live_bytes;        ///< bytes of the records still referenced by the index
+  hash_table_uint64_ts_t *index;             ///< imsi64 -> offset of the latest record of the UE
+  long                    timer_id;
+  uint32_t                period_sec;
+  bool                    restoring;
+  bstring                 path;
+  bstring                 payload;
+} mme_app_snapshot = {.fd = -1, .timer_id = MME_APP_TIMER_INACTIVE_ID};
+
+#define SNAPSHOT_HEADER   ((mme_app_snapshot_header_t *)mme_app_snapshot.map)
+#define SNAPSHOT_RECORD_AT(oFfSeT) ((mme_app_snapshot_record_t *)(mme_app_snapshot.map + (oFfSeT)))
+
+//------------------------------------------------------------------------------
+#define SNAPSHOT_FNV1A_BASIS 2166136261u
+
+//------------------------------------------------------------------------------
+static uint32_t _mme_app_snapshot_fnv1a (uint32_t hash, const uint8_t * data, const size_t length)
+{
+  for (size_t i = 0; i < length; i++) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+//------------------------------------------------------------------------------
+#define SNAPSHOT_MEMBER(tYpE, mEmBeR) (uint32_t)offsetof (tYpE, mEmBeR), (uint32_t)sizeof (((tYpE *)0)->mEmBeR)
+
+/*
+ * Offset and size of every member written to the records, then the MME build: the nested 3GPP types are still copied
+ * as is, a snapshot is only restored by the build that wrote it.
+ */
+static uint32_t _mme_app_snapshot_layout (void)
+{
+  const uint32_t members[] = {
+    sizeof (mme_app_snapshot_record_t),
+    SNAPSHOT_MEMBER(mme_app_snapshot_record_t, length), SNAPSHOT_MEMBER(mme_app_snapshot_record_t, type),
+    SNAPSHOT_MEMBER(mme_app_snapshot_record_t, checksum), SNAPSHOT_MEMBER(mme_app_snapshot_record_t, mme_ue_s1ap_id),
+    SNAPSHOT_MEMBER(mme_app_snapshot_record_t, imsi64),
+    sizeof (snapshot_ue_t),
+    SNAPSHOT_MEMBER(snapshot_ue_t, imsi), SNAPSHOT_MEMBER(snapshot_ue_t, mme_teid_s11), SNAPSHOT_MEMBER(snapshot_ue_t, s_gw_teid_s11_s4),
+    SNAPSHOT_MEMBER(snapshot_ue_t, is_guti_set), SNAPSHOT_MEMBER(snapshot_ue_t, guti), SNAPSHOT_MEMBER(snapshot_ue_t, e_utran_cgi),
+    SNAPSHOT_MEMBER(snapshot_ue_t, me_identity), SNAPSHOT_MEMBER(snapshot_ue_t, subscribed_ue_ambr),
+    SNAPSHOT_MEMBER(snapshot_ue_t, access_restriction_data), SNAPSHOT_MEMBER(snapshot_ue_t, rau_tau_timer),
+    SNAPSHOT_MEMBER(snapshot_ue_t, access_mode), SNAPSHOT_MEMBER(snapshot_ue_t, network_access_mode),
+    SNAPSHOT_MEMBER(snapshot_ue_t, sub_status), SNAPSHOT_MEMBER(snapshot_ue_t, subscriber_status),
+    SNAPSHOT_MEMBER(snapshot_ue_t, next_def_ebi_offset), SNAPSHOT_MEMBER(snapshot_ue_t, msisdn_length),
+    SNAPSHOT_MEMBER(snapshot_ue_t, msisdn), SNAPSHOT_MEMBER(snapshot_ue_t, has_subscription), SNAPSHOT_MEMBER(snapshot_ue_t, nb_pdns),
+    sizeof (subscription_data_t),
+    SNAPSHOT_MEMBER(subscription_data_t, subscriber_status), SNAPSHOT_MEMBER(subscription_data_t, msisdn),
+    SNAPSHOT_MEMBER(subscription_data_t, msisdn_length), SNAPSHOT_MEMBER(subscription_data_t, access_mode),
+    SNAPSHOT_MEMBER(subscription_data_t, access_restriction), SNAPSHOT_MEMBER(subscription_data_t, subscribed_ambr),
+    SNAPSHOT_MEMBER(subscription_data_t, apn_config_profile), SNAPSHOT_MEMBER(subscription_data_t, rau_tau_timer),
+    sizeof (snapshot_emm_t),
+    SNAPSHOT_MEMBER(snapshot_emm_t, ue_id), SNAPSHOT_MEMBER(snapshot_emm_t, is_emergency), SNAPSHOT_MEMBER(snapshot_emm_t, is_has_been_attached),
+    SNAPSHOT_MEMBER(snapshot_emm_t, is_initial_identity_imsi), SNAPSHOT_MEMBER(snapshot_emm_t, is_guti_based_attach),
+    SNAPSHOT_MEMBER(snapshot_emm_t, attach_type), SNAPSHOT_MEMBER(snapshot_emm_t, additional_update_type),
+    SNAPSHOT_MEMBER(snapshot_emm_t, member_present_mask), SNAPSHOT_MEMBER(snapshot_emm_t, member_valid_mask),
+    SNAPSHOT_MEMBER(snapshot_emm_t, imsi), SNAPSHOT_MEMBER(snapshot_emm_t, imsi64), SNAPSHOT_MEMBER(snapshot_emm_t, imei),
+    SNAPSHOT_MEMBER(snapshot_emm_t, imeisv), SNAPSHOT_MEMBER(snapshot_emm_t, guti), SNAPSHOT_MEMBER(snapshot_emm_t, tai_list),
+    SNAPSHOT_MEMBER(snapshot_emm_t, lvr_tai), SNAPSHOT_MEMBER(snapshot_emm_t, originating_tai), SNAPSHOT_MEMBER(snapshot_emm_t, ksi),
+    SNAPSHOT_MEMBER(snapshot_emm_t, ue_network_capability), SNAPSHOT_MEMBER(snapshot_emm_t, ms_network_capability),
+    SNAPSHOT_MEMBER(snapshot_emm_t, drx_parameter), SNAPSHOT_MEMBER(snapshot_emm_t, current_drx_parameter),
+    SNAPSHOT_MEMBER(snapshot_emm_t, vector), SNAPSHOT_MEMBER(snapshot_emm_t, security), SNAPSHOT_MEMBER(snapshot_emm_t, non_current_security),
+    sizeof (snapshot_security_t),
+    SNAPSHOT_MEMBER(snapshot_security_t, sc_type), SNAPSHOT_MEMBER(snapshot_security_t, eksi), SNAPSHOT_MEMBER(snapshot_security_t, vector_index),
+    SNAPSHOT_MEMBER(snapshot_security_t, knas_enc), SNAPSHOT_MEMBER(snapshot_security_t, knas_int), SNAPSHOT_MEMBER(snapshot_security_t, ncc),
+    SNAPSHOT_MEMBER(snapshot_security_t, nh_conj), SNAPSHOT_MEMBER(snapshot_security_t, dl_count), SNAPSHOT_MEMBER(snapshot_security_t, ul_count),
+    SNAPSHOT_MEMBER(snapshot_security_t, eps_encryption), SNAPSHOT_MEMBER(snapshot_security_t, eps_integrity),
+    SNAPSHOT_MEMBER(snapshot_security_t, umts_encryption), SNAPSHOT_MEMBER(snapshot_security_t, umts_integrity),
+    SNAPSHOT_MEMBER(snapshot_security_t, gprs_encryption), SNAPSHOT_MEMBER(snapshot_security_t, umts_present),
+    SNAPSHOT_MEMBER(snapshot_security_t, gprs_present), SNAPSHOT_MEMBER(snapshot_security_t, selected_encryption),
+    SNAPSHOT_MEMBER(snapshot_security_t, selected_integrity), SNAPSHOT_MEMBER(snapshot_security_t, activated),
+    SNAPSHOT_MEMBER(snapshot_security_t, direction_encode), SNAPSHOT_MEMBER(snapshot_security_t, direction_decode),
+    sizeof (snapshot_pdn_t),
+    SNAPSHOT_MEMBER(snapshot_pdn_t, context_identifier), SNAPSHOT_MEMBER(snapshot_pdn_t, pdn_type), SNAPSHOT_MEMBER(snapshot_pdn_t, default_ebi),
+    SNAPSHOT_MEMBER(snapshot_pdn_t, subscribed_apn_ambr), SNAPSHOT_MEMBER(snapshot_pdn_t, p_gw_address_s5_s8_cp),
+    SNAPSHOT_MEMBER(snapshot_pdn_t, p_gw_teid_s5_s8_cp), SNAPSHOT_MEMBER(snapshot_pdn_t, s_gw_address_s11_s4),
+    SNAPSHOT_MEMBER(snapshot_pdn_t, s_gw_teid_s11_s4), SNAPSHOT_MEMBER(snapshot_pdn_t, has_paa), SNAPSHOT_MEMBER(snapshot_pdn_t, paa),
+    SNAPSHOT_MEMBER(snapshot_pdn_t, apn_in_use_length), SNAPSHOT_MEMBER(snapshot_pdn_t, apn_subscribed_length),
+    SNAPSHOT_MEMBER(snapshot_pdn_t, apn_oi_replacement_length), SNAPSHOT_MEMBER(snapshot_pdn_t, nb_bearers),
+    sizeof (snapshot_bearer_t),
+    SNAPSHOT_MEMBER(snapshot_bearer_t, ebi), SNAPSHOT_MEMBER(snapshot_bearer_t, linked_ebi), SNAPSHOT_MEMBER(snapshot_bearer_t, pdn_cx_id),
+    SNAPSHOT_MEMBER(snapshot_bearer_t, s_gw_fteid_s1u), SNAPSHOT_MEMBER(snapshot_bearer_t, p_gw_fteid_s5_s8_up),
+    SNAPSHOT_MEMBER(snapshot_bearer_t, bearer_level_qos), SNAPSHOT_MEMBER(snapshot_bearer_t, esm_ebr_status),
+    SNAPSHOT_MEMBER(snapshot_bearer_t, has_tft), SNAPSHOT_MEMBER(snapshot_bearer_t, tft),
+  };
+  const char     build[] = PACKAGE_VERSION " " __VERSION__;
+  uint32_t       hash = _mme_app_snapshot_fnv1a (SNAPSHOT_FNV1A_BASIS, (const uint8_t *)members, sizeof (members));
+
+  return _mme_app_snapshot_fnv1a (hash, (const uint8_t *)build, sizeof (build) - 1);
+}
+
+//------------------------------------------------------------------------------
+static void _mme_app_snapshot_header_init (mme_app_snapshot_header_t * const header, const uint64_t nb_compactions)
+{
+  memset (header, 0, sizeof (*header));
+  memcpy (header->magic, MME_APP_SNAPSHOT_MAGIC, sizeof (header->magic));
+  header->version = MME_APP_SNAPSHOT_VERSION;
+  header->layout = _mme_app_snapshot_layout ();
+  header->tail = sizeof (*header);
+  header->nb_compactions = nb_compactions;
+}
+
+//------------------------------------------------------------------------------
+static int _mme_app_snapshot_map (const int fd, const uint64_t size, uint8_t ** map)
+{
+  if (ftruncate (fd, (off_t)size)) {
+    OAILOG_ERROR (LOG_MME_APP, "Snapshot: cannot resize %s to %" PRIu64 " bytes: %s\n", bdata(mme_app_snapshot.path), size, strerror(errno));
+    return RETURNerror;
+  }
+  void *addr = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (MAP_FAILED == addr) {
+    OAILOG_ERROR (LOG_MME_APP, "Snapshot: cannot map %s: %s\n", bdata(mme_app_snapshot.path), strerror(errno));
+    return RETURNerror;
+  }
+  *map = addr;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int _mme_app_snapshot_grow (const uint64_t needed)
+{
+  uint64_t size = mme_app_snapshot.map_size;
+  uint8_t *map  = NULL;
+
+  while (size < needed) {
+    size <<= 1;
+  }
+  munmap (mme_app_snapshot.map, mme_app_snapshot.map_size);
+  mme_app_snapshot.map = NULL;
+  if (RETURNok != _mme_app_snapshot_map (mme_app_snapshot.fd, size, &map)) {
+    return RETURNerror;
+  }
+  mme_app_snapshot.map      = map;
+  mme_app_snapshot.map_size = size;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int _mme_app_snapshot_append (const uint16_t type, const mme_ue_s1ap_id_t ue_id, const imsi64_t imsi64, const_bstring payload)
+{
+  const uint32_t payload_length = (payload) ? blength(payload) : 0;
+  const uint32_t length = (sizeof (mme_app_snapshot_record_t) + payload_length + 7) & ~7u;
+  uint64_t       tail   = SNAPSHOT_HEADER->tail;
+  uint64_t       previous = 0;
+
+  if (MME_APP_SNAPSHOT_MAX_RECORD_SIZE < length) {
+    OAILOG_WARNING (LOG_MME_APP, "Snapshot: record of %u bytes for IMSI " IMSI_64_FMT " too large\n", length, imsi64);
+    return RETURNerror;
+  }
+  if ((tail + length > mme_app_snapshot.map_size) && (RETURNok != _mme_app_snapshot_grow (tail + length))) {
+    return RETURNerror;
+  }
+  mme_app_snapshot_record_t *record = SNAPSHOT_RECORD_AT(tail);
+  uint8_t                   *data   = (uint8_t *)(record + 1);
+  memset (record, 0, length);
+  if (payload_length) {
+    memcpy (data, payload->data, payload_length);
+  }
+  record->length         = length;
+  record->type           = type;
+  record->mme_ue_s1ap_id = ue_id;
+  record->imsi64         = imsi64;
+  record->checksum       = _mme_app_snapshot_fnv1a (SNAPSHOT_FNV1A_BASIS, data, length - sizeof (*record));
+  /** The record is taken into account once the tail covers it. */
+  __atomic_store_n (&SNAPSHOT_HEADER->tail, tail + length, __ATOMIC_RELEASE);
+
+  if (HASH_TABLE_OK == hashtable_uint64_ts_get (mme_app_snapshot.index, (const hash_key_t)imsi64, &previous)) {
+    mme_app_snapshot.live_bytes -= SNAPSHOT_RECORD_AT(previous)->length;
+  }
+  if (MME_APP_SNAPSHOT_RECORD_UE == type) {
+    hashtable_uint64_ts_insert (mme_app_snapshot.index, (const hash_key_t)imsi64, tail);
+    mme_app_snapshot.live_bytes += length;
+  } else {
+    hashtable_uint64_ts_remove (mme_app_snapshot.index, (const hash_key_t)imsi64);
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void _mme_app_snapshot_encode_pdn (bstring payload, const pdn_context_t * const pdn_context)
+{
+  snapshot_pdn_t     pdn = {0};
+  bearer_context_t  *bearer_context = NULL;
+
+  pdn.context_identifier        = pdn_context->context_identifier;
+  pdn.pdn_type                  = pdn_context->pdn_type;
+  pdn.default_ebi               = pdn_context->default_ebi;
+  pdn.subscribed_apn_ambr       = pdn_context->subscribed_apn_ambr;
+  pdn.p_gw_address_s5_s8_cp     = pdn_context->p_gw_address_s5_s8_cp;
+  pdn.p_gw_teid_s5_s8_cp        = pdn_context->p_gw_teid_s5_s8_cp;
+  pdn.s_gw_address_s11_s4       = pdn_context->s_gw_address_s11_s4;
+  pdn.s_gw_teid_s11_s4          = pdn_context->s_gw_teid_s11_s4;
+  if (pdn_context->paa) {
+    pdn.has_paa = true;
+    pdn.paa     = *pdn_context->paa;
+  }
+  pdn.apn_in_use_length         = (pdn_context->apn_in_use) ? blength(pdn_context->apn_in_use) : 0;
+  pdn.apn_subscribed_length     = (pdn_context->apn_subscribed) ? blength(pdn_context->apn_subscribed) : 0;
+  pdn.apn_oi_replacement_length = (pdn_context->apn_oi_replacement) ? blength(pdn_context->apn_oi_replacement) : 0;
+  RB_FOREACH (bearer_context, SessionBearers, (struct SessionBearers *)&pdn_context->session_bearers) {
+    pdn.nb_bearers++;
+  }
+  bcatblk (payload, &pdn, sizeof (pdn));
+  if (pdn.apn_in_use_length)         bconcat (payload, pdn_context->apn_in_use);
+  if (pdn.apn_subscribed_length)     bconcat (payload, pdn_context->apn_subscribed);
+  if (pdn.apn_oi_replacement_length) bconcat (payload, pdn_context->apn_oi_replacement);
+
+  RB_FOREACH (bearer_context, SessionBearers, (struct SessionBearers *)&pdn_context->session_bearers) {
+    snapshot_bearer_t  bearer = {0};
+    bearer.ebi                 = bearer_context->ebi;
+    bearer.linked_ebi          = bearer_context->linked_ebi;
+    bearer.pdn_cx_id           = bearer_context->pdn_cx_id;
+    bearer.s_gw_fteid_s1u      = bearer_context->s_gw_fteid_s1u;
+    bearer.p_gw_fteid_s5_s8_up = bearer_context->p_gw_fteid_s5_s8_up;
+    bearer.bearer_level_qos    = bearer_context->bearer_level_qos;
+    bearer.esm_ebr_status      = bearer_context->esm_ebr_context.status;
+    if (bearer_context->esm_ebr_context.tft) {
+      bearer.has_tft = true;
+      bearer.tft     = *bearer_context->esm_ebr_context.tft;
+      memset (&bearer.tft.parameterslist, 0, sizeof (bearer.tft.parameterslist));
+    }
+    bcatblk (payload, &bearer, sizeof (bearer));
+  }
+}
+
+//------------------------------------------------------------------------------
+static void _mme_app_snapshot_encode_security (snapshot_security_t * const security, const emm_security_context_t * const context)
+{
+  security->sc_type             = context->sc_type;
+  security->eksi                = context->eksi;
+  security->vector_index        = context->vector_index;
+  memcpy (security->knas_enc, context->knas_enc, sizeof (security->knas_enc));
+  memcpy (security->knas_int, context->knas_int, sizeof (security->knas_int));
+  security->ncc                 = context->ncc;
+  memcpy (security->nh_conj, context->nh_conj, sizeof (security->nh_conj));
+  security->dl_count            = ((uint32_t)context->dl_count.overflow << 8) | context->dl_count.seq_num;
+  security->ul_count            = ((uint32_t)context->ul_count.overflow << 8) | context->ul_count.seq_num;
+  security->eps_encryption      = context->capability.eps_encryption;
+  security->eps_integrity       = context->capability.eps_integrity;
+  security->umts_encryption     = context->capability.umts_encryption;
+  security->umts_integrity      = context->capability.umts_integrity;
+  security->gprs_encryption     = context->capability.gprs_encryption;
+  security->umts_present        = context->capability.umts_present;
+  security->gprs_present        = context->capability.gprs_present;
+  security->selected_encryption = context->selected_algorithms.encryption;
+  security->selected_integrity  = context->selected_algorithms.integrity;
+  security->activated           = context->activated;
+  security->direction_encode    = context->direction_encode;
+  security->direction_decode    = context->direction_decode;
+}
+
+//------------------------------------------------------------------------------
+/* Derived state (EIA2 key schedule, SERVICE REQUEST replay cache) is left cleared, it is rebuilt on first use. */
+static void _mme_app_snapshot_decode_security (emm_security_context_t * const context, const snapshot_security_t * const security)
+{
+  context->sc_type                        = security->sc_type;
+  context->eksi                           = security->eksi;
+  context->vector_index                   = security->vector_index;
+  memcpy (context->knas_enc, security->knas_enc, sizeof (context->knas_enc));
+  memcpy (context->knas_int, security->knas_int, sizeof (context->knas_int));
+  context->ncc                            = security->ncc;
+  memcpy (context->nh_conj, security->nh_conj, sizeof (context->nh_conj));
+  context->dl_count.overflow              = (security->dl_count >> 8) & 0xFFFF;
+  context->dl_count.seq_num               = security->dl_count & 0xFF;
+  context->ul_count.overflow              = (security->ul_count >> 8) & 0xFFFF;
+  context->ul_count.seq_num               = security->ul_count & 0xFF;
+  context->capability.eps_encryption      = security->eps_encryption;
+  context->capability.eps_integrity       = security->eps_integrity;
+  context->capability.umts_encryption     = security->umts_encryption;
+  context->capability.umts_integrity      = security->umts_integrity;
+  context->capability.gprs_encryption     = security->gprs_encryption;
+  context->capability.umts_present        = security->umts_present;
+  context->capability.gprs_present        = security->gprs_present;
+  context->selected_algorithms.encryption = security->selected_encryption;
+  context->selected_algorithms.integrity  = security->selected_integrity;
+  context->activated                      = security->activated;
+  context->direction_encode               = security->direction_encode;
+  context->direction_decode               = security->direction_decode;
+}
+
+//------------------------------------------------------------------------------
+static int _mme_app_snapshot_encode_ue (bstring payload, const ue_context_t * const ue_context, const emm_data_context_t * const emm_context)
+{
+  snapshot_ue_t         ue = {0};
+  snapshot_emm_t        emm = {0};
+  const int             vector_index = emm_context->_security.vector_index;
+  uint32_t              dropped_members = EMM_CTXT_MEMBER_OLD_GUTI;
+  subscription_data_t  *subscription_data = mme_ue_subscription_data_exists_imsi (&mme_app_desc.mme_ue_contexts, ue_context->imsi);
+  pdn_context_t        *pdn_context = NULL;
+
+  ue.imsi                    = ue_context->imsi;
+  ue.mme_teid_s11            = ue_context->mme_teid_s11;
+  ue.s_gw_teid_s11_s4        = ue_context->s_gw_teid_s11_s4;
+  ue.is_guti_set             = ue_context->is_guti_set;
+  ue.guti                    = ue_context->guti;
+  ue.e_utran_cgi             = ue_context->e_utran_cgi;
+  ue.me_identity             = ue_context->me_identity;
+  ue.subscribed_ue_ambr      = ue_context->subscribed_ue_ambr;
+  ue.access_restriction_data = ue_context->access_restriction_data;
+  ue.rau_tau_timer           = ue_context->rau_tau_timer;
+  ue.access_mode             = ue_context->access_mode;
+  ue.network_access_mode     = ue_context->network_access_mode;
+  ue.sub_status              = ue_context->sub_status;
+  ue.subscriber_status       = ue_context->subscriber_status;
+  ue.next_def_ebi_offset     = ue_context->next_def_ebi_offset;
+  if (ue_context->msisdn) {
+    ue.msisdn_length = (uint8_t)((blength(ue_context->msisdn) > MSISDN_LENGTH) ? MSISDN_LENGTH : blength(ue_context->msisdn));
+    memcpy (ue.msisdn, ue_context->msisdn->data, ue.msisdn_length);
+  }
+  ue.has_subscription        = (subscription_data != NULL);
+  RB_FOREACH (pdn_context, PdnContexts, (struct PdnContexts *)&ue_context->pdn_contexts) {
+    ue.nb_pdns++;
+  }
+
+  /*
+   * Only the current security context and its vector survive, the unused vectors are fetched again from the HSS.
+   */
+  if ((0 > vector_index) || (MAX_EPS_AUTH_VECTORS <= vector_index)) {
+    return RETURNerror;
+  }
+  for (int i = 0; i < MAX_EPS_AUTH_VECTORS; i++) {
+    if (i != vector_index) {
+      dropped_members |= (EMM_CTXT_MEMBER_AUTH_VECTOR0 << i);
+    }
+  }
+  emm.ue_id                    = emm_context->ue_id;
+  emm.is_emergency             = emm_context->is_emergency;
+  emm.is_has_been_attached     = emm_context->is_has_been_attached;
+  emm.is_initial_identity_imsi = emm_context->is_initial_identity_imsi;
+  emm.is_guti_based_attach     = emm_context->is_guti_based_attach;
+  emm.attach_type              = emm_context->attach_type;
+  emm.additional_update_type   = emm_context->additional_update_type;
+  emm.member_present_mask      = emm_context->member_present_mask & ~dropped_members;
+  emm.member_valid_mask        = emm_context->member_valid_mask & ~dropped_members;
+  emm.imsi                     = emm_context->_imsi;
+  emm.imsi64                   = emm_context->_imsi64;
+  emm.imei                     = emm_context->_imei;
+  emm.imeisv                   = emm_context->_imeisv;
+  emm.guti                     = emm_context->_guti;
+  emm.tai_list                 = emm_context->_tai_list;
+  emm.lvr_tai                  = emm_context->_lvr_tai;
+  emm.originating_tai          = emm_context->originating_tai;
+  emm.ksi                      = emm_context->ksi;
+  emm.ue_network_capability    = emm_context->_ue_network_capability;
+  emm.ms_network_capability    = emm_context->_ms_network_capability;
+  emm.drx_parameter            = emm_context->_drx_parameter;
+  emm.current_drx_parameter    = emm_context->_current_drx_parameter;
+  emm.vector                   = emm_context->_vector[vector_index];
+  _mme_app_snapshot_encode_security (&emm.security, &emm_context->_security);
+  _mme_app_snapshot_encode_security (&emm.non_current_security, &emm_context->_non_current_security);
+
+  btrunc (payload, 0);
+  bcatblk (payload, &ue, sizeof (ue));
+  if (subscription_data) {
+    bcatblk (payload, subscription_data, sizeof (*subscription_data));
+  }
+  bcatblk (payload, &emm, sizeof (emm));
+  RB_FOREACH (pdn_context, PdnContexts, (struct PdnContexts *)&ue_context->pdn_contexts) {
+    _mme_app_snapshot_encode_pdn (payload, pdn_context);
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_snapshot_ue_remove (const struct ue_context_s * const ue_context)
+{
+  uint64_t offset = 0;
+
+  if ((!mme_app_snapshot.map) || (mme_app_snapshot.restoring) || (!ue_context->imsi)) {
+    return;
+  }
+  if (HASH_TABLE_OK != hashtable_uint64_ts_get (mme_app_snapshot.index, (const hash_key_t)ue_context->imsi, &offset)) {
+    return;
+  }
+  /** Another context may have taken over the IMSI, keep its record. */
+  if (SNAPSHOT_RECORD_AT(offset)->mme_ue_s1ap_id != ue_context->mme_ue_s1ap_id) {
+    return;
+  }
+  _mme_app_snapshot_append (MME_APP_SNAPSHOT_RECORD_UE_REMOVED, ue_context->mme_ue_s1ap_id, ue_context->imsi, NULL);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_snapshot_ue_checkpoint (const struct ue_context_s * const ue_context)
+{
+  emm_data_context_t *emm_context = NULL;
+
+  if ((!mme_app_snapshot.map) || (mme_app_snapshot.restoring) || (!ue_context->imsi)) {
+    return;
+  }
+  if (UE_REGISTERED == ue_context->mm_state) {
+    emm_context = emm_data_context_get (&_emm_data, ue_context->mme_ue_s1ap_id);
+  }
+  if ((!emm_context) || (!IS_EMM_CTXT_VALID_SECURITY(emm_context))
+      || (RETURNok != _mme_app_snapshot_encode_ue (mme_app_snapshot.payload, ue_context, emm_context))
+      || (RETURNok != _mme_app_snapshot_append (MME_APP_SNAPSHOT_RECORD_UE, ue_context->mme_ue_s1ap_id, ue_context->imsi, mme_app_snapshot.payload))) {
+    mme_app_snapshot_ue_remove (ue_context);
+  }
+}
+
+//------------------------------------------------------------------------------
+static bool _mme_app_snapshot_get (const uint8_t ** cursor, uint32_t * remaining, void * dst, const uint32_t length)
+{
+  if (*remaining < length) {
+    return false;
+  }
+  if (dst) {
+    memcpy (dst, *cursor, length);
+  }
+  *cursor    += length;
+  *remaining -= length;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static bstring _mme_app_snapshot_get_bstring (const uint8_t ** cursor, uint32_t * remaining, const uint16_t length)
+{
+  const uint8_t *data = *cursor;
+
+  if ((!length) || (!_mme_app_snapshot_get (cursor, remaining, NULL, length))) {
+    return NULL;
+  }
+  return blk2bstr (data, length);
+}
+
+//------------------------------------------------------------------------------
+static void _mme_app_snapshot_free_pdns (ue_context_t * const ue_context)
+{
+  pdn_context_t     *pdn_context = NULL;
+  bearer_context_t  *bearer_context = NULL;
+
+  while ((pdn_context = RB_MIN (PdnContexts, &ue_context->pdn_contexts))) {
+    RB_REMOVE (PdnContexts, &ue_context->pdn_contexts, pdn_context);
+    while ((bearer_context = RB_MIN (SessionBearers, &pdn_context->session_bearers))) {
+      RB_REMOVE (SessionBearers, &pdn_context->session_bearers, bearer_context);
+      if (bearer_context->esm_ebr_context.tft) {
+        free_traffic_flow_template (&bearer_context->esm_ebr_context.tft);
+      }
+      RB_INSERT (BearerPool, &ue_context->bearer_pool, bearer_context);
+    }
+    bdestroy_wrapper (&pdn_context->apn_in_use);
+    bdestroy_wrapper (&pdn_context->apn_subscribed);
+    bdestroy_wrapper (&pdn_context->apn_oi_replacement);
+    free_wrapper ((void**)&pdn_context->paa);
+    free_wrapper ((void**)&pdn_context);
+  }
+}
+
+//------------------------------------------------------------------------------
+static int _mme_app_snapshot_decode_pdn (ue_context_t * const ue_context, const uint8_t ** cursor, uint32_t * remaining)
+{
+  snapshot_pdn_t     pdn = {0};
+  pdn_context_t     *pdn_context = NULL;
+
+  if (!_mme_app_snapshot_get (cursor, remaining, &pdn, sizeof (pdn))) {
+    return RETURNerror;
+  }
+  pdn_context = calloc (1, sizeof (*pdn_context));
+  RB_INIT (&pdn_context->session_bearers);
+  pdn_context->context_identifier    = pdn.context_identifier;
+  pdn_context->pdn_type              = pdn.pdn_type;
+  pdn_context->default_ebi           = pdn.default_ebi;
+  pdn_context->subscribed_apn_ambr   = pdn.subscribed_apn_ambr;
+  pdn_context->p_gw_address_s5_s8_cp = pdn.p_gw_address_s5_s8_cp;
+  pdn_context->p_gw_teid_s5_s8_cp    = pdn.p_gw_teid_s5_s8_cp;
+  pdn_context->s_gw_address_s11_s4   = pdn.s_gw_address_s11_s4;
+  pdn_context->s_gw_teid_s11_s4      = pdn.s_gw_teid_s11_s4;
+  if (pdn.has_paa) {
+    pdn_context->paa = calloc (1, sizeof (paa_t));
+    *pdn_context->paa = pdn.paa;
+  }
+  pdn_context->apn_in_use            = _mme_app_snapshot_get_bstring (cursor, remaining, pdn.apn_in_use_length);
+  pdn_context->apn_subscribed        = _mme_app_snapshot_get_bstring (cursor, remaining, pdn.apn_subscribed_length);
+  pdn_context->apn_oi_replacement    = _mme_app_snapshot_get_bstring (cursor, remaining, pdn.apn_oi_replacement_length);
+  /** Inserted first, so that the caller releases it on error. */
+  if (RB_INSERT (PdnContexts, &ue_context->pdn_contexts, pdn_context)) {
+    bdestroy_wrapper (&pdn_context->apn_in_use);
+    bdestroy_wrapper (&pdn_context->apn_subscribed);
+    bdestroy_wrapper (&pdn_context->apn_oi_replacement);
+    free_wrapper ((void**)&pdn_context->paa);
+    free_wrapper ((void**)&pdn_context);
+    return RETURNerror;
+  }
+  if ((pdn.apn_in_use_length && !pdn_context->apn_in_use) || (pdn.apn_subscribed_length && !pdn_context->apn_subscribed)
+      || (pdn.apn_oi_replacement_length && !pdn_context->apn_oi_replacement)) {
+    return RETURNerror;
+  }
+
+  for (int i = 0; i < pdn.nb_bearers; i++) {
+    snapshot_bearer_t  bearer = {0};
+    bearer_context_t  *bearer_context = NULL;
+
+    if (!_mme_app_snapshot_get (cursor, remaining, &bearer, sizeof (bearer))) {
+      return RETURNerror;
+    }
+    mme_app_get_free_bearer_context (ue_context, bearer.ebi, &bearer_context);
+    if (!bearer_context) {
+      return RETURNerror;
+    }
+    RB_REMOVE (BearerPool, &ue_context->bearer_pool, bearer_context);
+    bearer_context->linked_ebi             = bearer.linked_ebi;
+    bearer_context->pdn_cx_id              = bearer.pdn_cx_id;
+    bearer_context->s_gw_fteid_s1u         = bearer.s_gw_fteid_s1u;
+    bearer_context->p_gw_fteid_s5_s8_up    = bearer.p_gw_fteid_s5_s8_up;
+    bearer_context->bearer_level_qos       = bearer.bearer_level_qos;
+    bearer_context->esm_ebr_context.status = bearer.esm_ebr_status;
+    if (bearer.has_tft) {
+      bearer_context->esm_ebr_context.tft  = calloc (1, sizeof (traffic_flow_template_t));
+      *bearer_context->esm_ebr_context.tft = bearer.tft;
+    }
+    /** Restored as released towards the eNB, like after an S1 UE context release. */
+    mme_app_bearer_context_s1_release_enb_informations (bearer_context);
+    bearer_context->bearer_state |= (BEARER_STATE_SGW_CREATED | BEARER_STATE_MME_CREATED);
+    RB_INSERT (SessionBearers, &pdn_context->session_bearers, bearer_context);
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int _mme_app_snapshot_restore_ue (const mme_app_snapshot_record_t * const record, mme_ue_s1ap_id_t * const max_ue_id, teid_t * const max_teid)
+{
+  const uint8_t        *cursor = (const uint8_t *)(record + 1);
+  uint32_t              remaining = record->length - sizeof (*record);
+  snapshot_ue_t         ue = {0};
+  snapshot_emm_t        emm = {0};
+  subscription_data_t  *subscription_data = NULL;
+  emm_data_context_t   *emm_context = NULL;
+  ue_context_t         *ue_context = NULL;
+
+  if (!_mme_app_snapshot_get (&cursor, &remaining, &ue, sizeof (ue)) || (ue.imsi != record->imsi64)) {
+    return RETURNerror;
+  }
+  if (ue.has_subscription) {
+    subscription_data = calloc (1, sizeof (*subscription_data));
+    if (!_mme_app_snapshot_get (&cursor, &remaining, subscription_data, sizeof (*subscription_data))) {
+      free_wrapper ((void**)&subscription_data);
+      return RETURNerror;
+    }
+  }
+  if ((!_mme_app_snapshot_get (&cursor, &remaining, &emm, sizeof (emm)))
+      || (emm.ue_id != record->mme_ue_s1ap_id)
+      || (0 > emm.security.vector_index) || (MAX_EPS_AUTH_VECTORS <= emm.security.vector_index)
+      || (!(ue_context = mme_create_new_ue_context ()))) {
+    free_wrapper ((void**)&subscription_data);
+    return RETURNerror;
+  }
+  emm_context = calloc (1, sizeof (*emm_context));
+  emm_context->ue_id                    = emm.ue_id;
+  emm_context->is_emergency             = emm.is_emergency;
+  emm_context->is_has_been_attached     = emm.is_has_been_attached;
+  emm_context->is_initial_identity_imsi = emm.is_initial_identity_imsi;
+  emm_context->is_guti_based_attach     = emm.is_guti_based_attach;
+  emm_context->attach_type              = emm.attach_type;
+  emm_context->additional_update_type   = emm.additional_update_type;
+  emm_context->member_present_mask      = emm.member_present_mask;
+  emm_context->member_valid_mask        = emm.member_valid_mask;
+  emm_context->_imsi                    = emm.imsi;
+  emm_context->_imsi64                  = emm.imsi64;
+  emm_context->_imei                    = emm.imei;
+  emm_context->_imeisv                  = emm.imeisv;
+  emm_context->_guti                    = emm.guti;
+  emm_context->_tai_list                = emm.tai_list;
+  emm_context->_lvr_tai                 = emm.lvr_tai;
+  emm_context->originating_tai          = emm.originating_tai;
+  emm_context->ksi                      = emm.ksi;
+  emm_context->_ue_network_capability   = emm.ue_network_capability;
+  emm_context->_ms_network_capability   = emm.ms_network_capability;
+  emm_context->_drx_parameter           = emm.drx_parameter;
+  emm_context->_current_drx_parameter   = emm.current_drx_parameter;
+  _mme_app_snapshot_decode_security (&emm_context->_security, &emm.security);
+  _mme_app_snapshot_decode_security (&emm_context->_non_current_security, &emm.non_current_security);
+  emm_context->_vector[emm.security.vector_index] = emm.vector;
+
+  ue_context->mme_ue_s1ap_id          = record->mme_ue_s1ap_id;
+  ue_context->imsi                    = ue.imsi;
+  ue_context->mme_teid_s11            = ue.mme_teid_s11;
+  ue_context->s_gw_teid_s11_s4        = ue.s_gw_teid_s11_s4;
+  ue_context->is_guti_set             = ue.is_guti_set;
+  ue_context->guti                    = ue.guti;
+  ue_context->e_utran_cgi             = ue.e_utran_cgi;
+  ue_context->me_identity             = ue.me_identity;
+  ue_context->subscribed_ue_ambr      = ue.subscribed_ue_ambr;
+  ue_context->access_restriction_data = ue.access_restriction_data;
+  ue_context->rau_tau_timer           = ue.rau_tau_timer;
+  ue_context->access_mode             = ue.access_mode;
+  ue_context->network_access_mode     = ue.network_access_mode;
+  ue_context->sub_status              = ue.sub_status;
+  ue_context->subscriber_status       = ue.subscriber_status;
+  ue_context->next_def_ebi_offset     = ue.next_def_ebi_offset;
+  if (ue.msisdn_length) {
+    ue_context->msisdn = blk2bstr (ue.msisdn, ue.msisdn_length);
+  }
+  ue_context->ecm_state               = ECM_IDLE;
+  ue_context->mm_state                = UE_REGISTERED;
+  ue_context->mobile_reachability_timer.sec = ((mme_config.nas_config.t3412_min) + MME_APP_DELTA_T3412_REACHABILITY_TIMER) * 60;
+  ue_context->implicit_detach_timer.sec = (ue_context->mobile_reachability_timer.sec) + MME_APP_DELTA_REACHABILITY_IMPLICIT_DETACH_TIMER * 60;
+
+  for (int i = 0; i < ue.nb_pdns; i++) {
+    if (RETURNok != _mme_app_snapshot_decode_pdn (ue_context, &cursor, &remaining)) {
+      _mme_app_snapshot_free_pdns (ue_context);
+      mme_app_ue_context_free_content (ue_context);
+      free_wrapper ((void**)&ue_context);
+      free_wrapper ((void**)&subscription_data);
+      free_wrapper ((void**)&emm_context);
+      return RETURNerror;
+    }
+  }
+
+  if (RETURNok != mme_insert_ue_context (&mme_app_desc.mme_ue_contexts, ue_context)) {
+    _mme_app_snapshot_free_pdns (ue_context);
+    mme_remove_ue_context (&mme_app_desc.mme_ue_contexts, ue_context);
+    free_wrapper ((void**)&subscription_data);
+    free_wrapper ((void**)&emm_context);
+    return RETURNerror;
+  }
+  if ((subscription_data) && (RETURNok != mme_insert_subscription_profile (&mme_app_desc.mme_ue_contexts, ue.imsi, subscription_data))) {
+    free_wrapper ((void**)&subscription_data);
+  }
+
+  /*
+   * The UE may have received NAS messages after its last checkpoint: jump the downlink COUNT so that none is reused.
+   */
+  emm_context->is_dynamic      = true;
+  emm_context->emm_procedures  = NULL;
+  emm_context->_emm_fsm_state  = EMM_REGISTERED;
+  uint32_t dl_count = ((uint32_t)emm_context->_security.dl_count.overflow << 8) | emm_context->_security.dl_count.seq_num;
+  dl_count += MME_APP_SNAPSHOT_NAS_DL_COUNT_GUARD;
+  emm_context->_security.dl_count.overflow = (dl_count >> 8) & 0xFFFF;
+  emm_context->_security.dl_count.seq_num  = dl_count & 0xFF;
+  if (RETURNok != emm_data_context_add (&_emm_data, emm_context)) {
+    emm_data_context_remove (&_emm_data, emm_context, false);
+    free_wrapper ((void**)&emm_context);
+    _mme_app_snapshot_free_pdns (ue_context);
+    subscription_data = mme_remove_subscription_profile (&mme_app_desc.mme_ue_contexts, ue.imsi);
+    free_wrapper ((void**)&subscription_data);
+    mme_remove_ue_context (&mme_app_desc.mme_ue_contexts, ue_context);
+    return RETURNerror;
+  }
+
+  update_mme_app_stats_attached_ue_add ();
+  pdn_context_t *pdn_context = RB_MIN (PdnContexts, &ue_context->pdn_contexts);
+  if ((ue_context->mme_teid_s11) && (pdn_context) && (pdn_context->s_gw_address_s11_s4.address.ipv4_address.s_addr)) {
+    s11_mme_restore_tunnel (ue_context->mme_teid_s11, pdn_context->s_gw_address_s11_s4.address.ipv4_address);
+  }
+  if (mme_config.nas_config.t3412_min > 0) {
+    if (timer_setup (ue_context->mobile_reachability_timer.sec, 0, TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)&(ue_context->mme_ue_s1ap_id), &(ue_context->mobile_reachability_timer.id)) < 0) {
+      OAILOG_ERROR (LOG_MME_APP, "Failed to start Mobile Reachability timer for UE id  %d \n", ue_context->mme_ue_s1ap_id);
+      ue_context->mobile_reachability_timer.id = MME_APP_TIMER_INACTIVE_ID;
+    }
+  }
+  if (*max_ue_id < ue_context->mme_ue_s1ap_id) {
+    *max_ue_id = ue_context->mme_ue_s1ap_id;
+  }
+  if (*max_teid < ue_context->mme_teid_s11) {
+    *max_teid = ue_context->mme_teid_s11;
+  }
+  OAILOG_DEBUG (LOG_MME_APP, "Snapshot: restored UE " MME_UE_S1AP_ID_FMT " IMSI " IMSI_64_FMT " with %u PDN context(s)\n",
+      ue_context->mme_ue_s1ap_id, ue_context->imsi, ue.nb_pdns);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static bool _mme_app_snapshot_record_valid (const uint64_t offset, const uint64_t tail)
+{
+  const mme_app_snapshot_record_t *record = SNAPSHOT_RECORD_AT(offset);
+
+  if ((offset + sizeof (*record) > tail) || (record->length < sizeof (*record)) || (record->length & 7)
+      || (record->length > MME_APP_SNAPSHOT_MAX_RECORD_SIZE) || (offset + record->length > tail)) {
+    return false;
+  }
+  if ((MME_APP_SNAPSHOT_RECORD_UE != record->type) && (MME_APP_SNAPSHOT_RECORD_UE_REMOVED != record->type)) {
+    return false;
+  }
+  return (record->checksum == _mme_app_snapshot_fnv1a (SNAPSHOT_FNV1A_BASIS, (const uint8_t *)(record + 1), record->length - sizeof (*record)));
+}
+
+//------------------------------------------------------------------------------
+static void _mme_app_snapshot_restore (void)
+{
+  uint64_t          tail = __atomic_load_n (&SNAPSHOT_HEADER->tail, __ATOMIC_ACQUIRE);
+  uint64_t          offset = sizeof (mme_app_snapshot_header_t);
+  uint64_t          latest = 0;
+  mme_ue_s1ap_id_t  max_ue_id = 0;
+  teid_t            max_teid = 0;
+  int               nb_restored = 0;
+  int               nb_failed = 0;
+
+  /** Index the latest record of each IMSI, up to the first damaged record. */
+  while ((offset < tail) && (_mme_app_snapshot_record_valid (offset, tail))) {
+    const mme_app_snapshot_record_t *record = SNAPSHOT_RECORD_AT(offset);
+    if (MME_APP_SNAPSHOT_RECORD_UE == record->type) {
+      hashtable_uint64_ts_insert (mme_app_snapshot.index, (const hash_key_t)record->imsi64, offset);
+    } else if ((HASH_TABLE_OK == hashtable_uint64_ts_get (mme_app_snapshot.index, (const hash_key_t)record->imsi64, &latest))
+        && (SNAPSHOT_RECORD_AT(latest)->mme_ue_s1ap_id == record->mme_ue_s1ap_id)) {
+      hashtable_uint64_ts_remove (mme_app_snapshot.index, (const hash_key_t)record->imsi64);
+    }
+    offset += record->length;
+  }
+  if (offset != tail) {
+    OAILOG_WARNING (LOG_MME_APP, "Snapshot: %s damaged after %" PRIu64 " bytes, %" PRIu64 " bytes dropped\n",
+        bdata(mme_app_snapshot.path), offset, tail - offset);
+    SNAPSHOT_HEADER->tail = offset;
+    tail = offset;
+  }
+
+  mme_app_snapshot.restoring = true;
+  for (offset = sizeof (mme_app_snapshot_header_t); offset < tail; offset += SNAPSHOT_RECORD_AT(offset)->length) {
+    const mme_app_snapshot_record_t *record = SNAPSHOT_RECORD_AT(offset);
+    if ((MME_APP_SNAPSHOT_RECORD_UE != record->type)
+        || (HASH_TABLE_OK != hashtable_uint64_ts_get (mme_app_snapshot.index, (const hash_key_t)record->imsi64, &latest))
+        || (latest != offset)) {
+      continue;
+    }
+    if (RETURNok == _mme_app_snapshot_restore_ue (record, &max_ue_id, &max_teid)) {
+      mme_app_snapshot.live_bytes += record->length;
+      nb_restored++;
+    } else {
+      OAILOG_WARNING (LOG_MME_APP, "Snapshot: could not restore UE " MME_UE_S1AP_ID_FMT " IMSI " IMSI_64_FMT "\n",
+          record->mme_ue_s1ap_id, record->imsi64);
+      hashtable_uint64_ts_remove (mme_app_snapshot.index, (const hash_key_t)record->imsi64);
+      nb_failed++;
+    }
+  }
+  mme_app_snapshot.restoring = false;
+
+  /** Identifiers of the restored contexts are not allocated again. */
+  if (max_ue_id) {
+    mme_app_ctx_reserve_ue_id (max_ue_id);
+  }
+  if (max_teid) {
+    mme_app_reserve_s11_teid (max_teid);
+  }
+  OAILOG_INFO (LOG_MME_APP, "Snapshot: restored %d UE context(s) as ECM-IDLE from %s (%d failed)\n",
+      nb_restored, bdata(mme_app_snapshot.path), nb_failed);
+}
+
+//------------------------------------------------------------------------------
+static int _mme_app_snapshot_compact (void)
+{
+  const uint64_t tail = SNAPSHOT_HEADER->tail;
+  uint64_t       size = MME_APP_SNAPSHOT_MIN_FILE_SIZE;
+  uint64_t       new_tail = sizeof (mme_app_snapshot_header_t);
+  uint64_t       latest = 0;
+  uint8_t       *map = NULL;
+  bstring        tmp_path = bformat ("%s.tmp", bdata(mme_app_snapshot.path));
+  int            fd = open ((const char *)tmp_path->data, O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+  if (0 > fd) {
+    OAILOG_ERROR (LOG_MME_APP, "Snapshot: cannot create %s: %s\n", bdata(tmp_path), strerror(errno));
+    bdestroy_wrapper (&tmp_path);
+    return RETURNerror;
+  }
+  while (size < 2 * (sizeof (mme_app_snapshot_header_t) + mme_app_snapshot.live_bytes)) {
+    size <<= 1;
+  }
+  if (RETURNok != _mme_app_snapshot_map (fd, size, &map)) {
+    close (fd);
+    unlink ((const char *)tmp_path->data);
+    bdestroy_wrapper (&tmp_path);
+    return RETURNerror;
+  }
+
+  /*
+   * Offsets only decrease, the index can be updated in place: a later record of the same IMSI never lands on the new offset.
+   */
+  for (uint64_t offset = sizeof (mme_app_snapshot_header_t); offset < tail; offset += SNAPSHOT_RECORD_AT(offset)->length) {
+    const mme_app_snapshot_record_t *record = SNAPSHOT_RECORD_AT(offset);
+    if ((MME_APP_SNAPSHOT_RECORD_UE != record->type)
+        || (HASH_TABLE_OK != hashtable_uint64_ts_get (mme_app_snapshot.index, (const hash_key_t)record->imsi64, &latest))
+        || (latest != offset)) {
+      continue;
+    }
+    memcpy (map + new_tail, record, record->length);
+    hashtable_uint64_ts_insert (mme_app_snapshot.index, (const hash_key_t)record->imsi64, new_tail);
+    new_tail += record->length;
+  }
+  _mme_app_snapshot_header_init ((mme_app_snapshot_header_t *)map, SNAPSHOT_HEADER->nb_compactions + 1);
+  ((mme_app_snapshot_header_t *)map)->tail = new_tail;
+
+  if ((msync (map, new_tail, MS_SYNC)) || (rename ((const char *)tmp_path->data, (const char *)mme_app_snapshot.path->data))) {
+    /** Not fatal, the index now refers to the new file: keep using it. */
+    OAILOG_ERROR (LOG_MME_APP, "Snapshot: cannot replace %s: %s\n", bdata(mme_app_snapshot.path), strerror(errno));
+  }
+  munmap (mme_app_snapshot.map, mme_app_snapshot.map_size);
+  close (mme_app_snapshot.fd);
+  mme_app_snapshot.fd       = fd;
+  mme_app_snapshot.map      = map;
+  mme_app_snapshot.map_size = size;
+  mme_app_snapshot.live_bytes = new_tail - sizeof (mme_app_snapshot_header_t);
+  OAILOG_INFO (LOG_MME_APP, "Snapshot: compacted %s from %" PRIu64 " to %" PRIu64 " bytes\n", bdata(mme_app_snapshot.path), tail, new_tail);
+  bdestroy_wrapper (&tmp_path);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static bool _mme_app_snapshot_checkpoint_connected (const hash_key_t keyP, void * const ue_context_pP, void * parameterP, void ** resultP)
+{
+  const ue_context_t * const ue_context = (const ue_context_t *)ue_context_pP;
+
+  /** Idle UEs have been checkpointed when they entered ECM-IDLE. */
+  if ((ue_context) && (ECM_CONNECTED == ue_context->ecm_state) && (UE_REGISTERED == ue_context->mm_state)) {
+    mme_app_snapshot_ue_checkpoint (ue_context);
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+bool mme_app_snapshot_handle_timer_expiry (const long timer_id)
+{
+  uint64_t used = 0;
+
+  if ((!mme_app_snapshot.map) || (timer_id != mme_app_snapshot.timer_id)) {
+    return false;
+  }
+  hashtable_ts_apply_callback_on_elements (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl,
+      _mme_app_snapshot_checkpoint_connected, NULL, NULL);
+  used = SNAPSHOT_HEADER->tail - sizeof (mme_app_snapshot_header_t);
+  msync (mme_app_snapshot.map, SNAPSHOT_HEADER->tail, MS_ASYNC);
+  if ((used > MME_APP_SNAPSHOT_MIN_FILE_SIZE) && (2 * mme_app_snapshot.live_bytes < used)) {
+    _mme_app_snapshot_compact ();
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+int mme_app_snapshot_init (const mme_config_t * mme_config_p)
+{
+  struct stat                             st = {0};
+  const mme_app_snapshot_header_t        *header = NULL;
+  bool                                    restore = false;
+
+  OAILOG_FUNC_IN (LOG_MME_APP);
+  if (!mme_config_p->snapshot_config.file) {
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNok);
+  }
+  mme_app_snapshot.path       = bstrcpy (mme_config_p->snapshot_config.file);
+  mme_app_snapshot.period_sec = mme_config_p->snapshot_config.period_sec;
+  mme_app_snapshot.payload    = bfromcstralloc (4096, "");
+  bstring b = bfromcstr ("mme_app_snapshot_index");
+  mme_app_snapshot.index = hashtable_uint64_ts_create (mme_config_p->max_ues, NULL, b);
+  bdestroy_wrapper (&b);
+
+  mme_app_snapshot.fd = open ((const char *)mme_app_snapshot.path->data, O_RDWR | O_CREAT, 0600);
+  if ((0 > mme_app_snapshot.fd) || (fstat (mme_app_snapshot.fd, &st))) {
+    OAILOG_ERROR (LOG_MME_APP, "Snapshot: cannot open %s: %s\n", bdata(mme_app_snapshot.path), strerror(errno));
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+  mme_app_snapshot.map_size = (st.st_size < MME_APP_SNAPSHOT_MIN_FILE_SIZE) ? MME_APP_SNAPSHOT_MIN_FILE_SIZE : (uint64_t)st.st_size;
+  if (RETURNok != _mme_app_snapshot_map (mme_app_snapshot.fd, mme_app_snapshot.map_size, &mme_app_snapshot.map)) {
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+
+  header = SNAPSHOT_HEADER;
+  if ((st.st_size >= (off_t)sizeof (*header)) && (!memcmp (header->magic, MME_APP_SNAPSHOT_MAGIC, sizeof (header->magic)))) {
+    if ((MME_APP_SNAPSHOT_VERSION != header->version) || (_mme_app_snapshot_layout () != header->layout)
+        || (header->tail < sizeof (*header)) || (header->tail > (uint64_t)st.st_size)) {
+      OAILOG_WARNING (LOG_MME_APP, "Snapshot: %s does not match this MME version, discarded\n", bdata(mme_app_snapshot.path));
+    } else {
+      restore = true;
+    }
+  }
+  if (restore) {
+    _mme_app_snapshot_restore ();
+    _mme_app_snapshot_compact ();
+  } else {
+    _mme_app_snapshot_header_init (SNAPSHOT_HEADER, 0);
+    msync (mme_app_snapshot.map, sizeof (mme_app_snapshot_header_t), MS_SYNC);
+  }
+
+  if (mme_app_snapshot.period_sec) {
+    if (timer_setup (mme_app_snapshot.period_sec, 0, TASK_MME_APP, INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &mme_app_snapshot.timer_id) < 0) {
+      OAILOG_ERROR (LOG_MME_APP, "Snapshot: failed to request the checkpoint timer\n");
+      mme_app_snapshot.timer_id = MME_APP_TIMER_INACTIVE_ID;
+    }
+  }
+  OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNok);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_snapshot_exit (void)
+{
+  if (MME_APP_TIMER_INACTIVE_ID != mme_app_snapshot.timer_id) {
+    timer_remove (mme_app_snapshot.timer_id, NULL);
+    mme_app_snapshot.timer_id = MME_APP_TIMER_INACTIVE_ID;
+  }
+  if (mme_app_snapshot.map) {
+    msync (mme_app_snapshot.map, SNAPSHOT_HEADER->tail, MS_SYNC);
+    munmap (mme_app_snapshot.map, mme_app_snapshot.map_size);
+    mme_app_snapshot.map = NULL;
+  }
+  if (0 <= mme_app_snapshot.fd) {
+    close (mme_app_snapshot.fd);
+    mme_app_snapshot.fd = -1;
+  }
+  if (mme_app_snapshot.index) {
+    hashtable_uint64_ts_destroy (mme_app_snapshot.index);
+    mme_app_snapshot.index = NULL;
+  }
+  bdestroy_wrapper (&mme_app_snapshot.path);
+  bdestroy_wrapper (&mme_app_snapshot.payload);
+}
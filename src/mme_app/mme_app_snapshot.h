@@ -0,0 +1,74 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+#ifndef FILE_MME_APP_SNAPSHOT_SEEN
+#define FILE_MME_APP_SNAPSHOT_SEEN
+
+/*! \file mme_app_snapshot.h
+  \brief Checkpoint of the registered UE contexts in a memory mapped log, restored at MME startup.
+*/
+
+#define MME_APP_SNAPSHOT_MAGIC             "OAIMMESN"
+#define MME_APP_SNAPSHOT_VERSION           2
+#define MME_APP_SNAPSHOT_MIN_FILE_SIZE     (1 << 20)
+#define MME_APP_SNAPSHOT_MAX_RECORD_SIZE   (64 * 1024)
+/* NAS downlink COUNT jump applied to restored UEs, covers the messages sent after their last checkpoint */
+#define MME_APP_SNAPSHOT_NAS_DL_COUNT_GUARD 64
+
+#define MME_APP_SNAPSHOT_RECORD_UE          1   ///< latest state of a registered UE
+#define MME_APP_SNAPSHOT_RECORD_UE_REMOVED  2   ///< UE detached or context removed
+
+/*
+ * File layout: header, then records appended up to header.tail.
+ * A record is only taken into account once the tail covers it, and if its checksum matches.
+ */
+typedef struct mme_app_snapshot_header_s {
+  char              magic[8];
+  uint32_t          version;
+  uint32_t          layout;          ///< fingerprint of the record members and of the MME build, mismatching snapshots are discarded
+  uint64_t          tail;            ///< end of the last complete record
+  uint64_t          nb_compactions;
+} mme_app_snapshot_header_t;
+
+typedef struct mme_app_snapshot_record_s {
+  uint32_t          length;          ///< header included, multiple of 8 bytes
+  uint16_t          type;
+  uint16_t          spare;
+  uint32_t          checksum;        ///< FNV-1a of the payload
+  mme_ue_s1ap_id_t  mme_ue_s1ap_id;
+  imsi64_t          imsi64;
+} mme_app_snapshot_record_t;
+
+struct mme_config_s;
+struct ue_context_s;
+
+/* Restores the UE contexts found in the snapshot file as ECM-IDLE, to be called before the MME_APP task is started. */
+int  mme_app_snapshot_init (const struct mme_config_s * mme_config_p);
+void mme_app_snapshot_exit (void);
+
+/* Checkpoint a UE (removed from the snapshot if it is not registered), called when it enters ECM-IDLE */
+void mme_app_snapshot_ue_checkpoint (const struct ue_context_s * const ue_context);
+void mme_app_snapshot_ue_remove (const struct ue_context_s * const ue_context);
+
+bool mme_app_snapshot_handle_timer_expiry (const long timer_id);
+
+#endif
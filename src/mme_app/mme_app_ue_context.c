@@ -302,6 +302,15 @@ mme_ue_s1ap_id_t mme_app_ctx_get_new_ue_id(void)
   return tmp;
 }
 
+//------------------------------------------------------------------------------
+void mme_app_ctx_reserve_ue_id(const mme_ue_s1ap_id_t ue_id)
+{
+  mme_ue_s1ap_id_t current = mme_app_ue_s1ap_id_generator;
+  while ((current <= ue_id) && (!__sync_bool_compare_and_swap (&mme_app_ue_s1ap_id_generator, current, ue_id + 1))) {
+    current = mme_app_ue_s1ap_id_generator;
+  }
+}
+
 /*
  * Generate the functions to operate inside the bearer pool.
  */
@@ -86,6 +86,8 @@ uint64_t mme_app_imsi_to_u64 (mme_app_imsi_t imsi_src);
 void mme_app_ue_context_uint_to_imsi(uint64_t imsi_src, mme_app_imsi_t *imsi_dst);
 void mme_app_convert_imsi_to_imsi_mme (mme_app_imsi_t * imsi_dst, const imsi_t *imsi_src);
 // todo: mme_ue_s1ap_id_t mme_app_ctx_get_new_ue_id(void);
+/* Makes sure the identifiers up to ue_id (restored contexts) are not allocated again */
+void mme_app_ctx_reserve_ue_id(const mme_ue_s1ap_id_t ue_id);
 
 
 /*
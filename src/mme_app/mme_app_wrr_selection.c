@@ -20,7 +20,7 @@
  */
 
 /*! \file mme_app_wrr_selection.c
-  \brief
+  \brief Selection of SGW/MME peers per TAI with smooth weighted round robin.
   \author Lionel Gauthier
   \company Eurecom
   \email: lionel.gauthier@eurecom.fr
@@ -31,6 +31,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <netinet/in.h>
 
 #include "bstrlib.h"
@@ -39,11 +40,202 @@
 #include "common_defs.h"
 #include "common_types.h"
 #include "dynamic_memory_check.h"
+#include "hashtable.h"
 #include "TrackingAreaIdentity.h"
 #include "mme_config.h"
 #include "mme_app_edns_emulation.h"
 #include "mme_app_wrr_selection.h"
 
+/*
+ * Effective weight with load feedback:
+ *   weight * SCALE / (SCALE + outstanding transactions * TRANSACTION_COST)
+ */
+#define MME_APP_WRR_LOAD_SCALE             16
+#define MME_APP_WRR_TRANSACTION_COST        4
+#define MME_APP_WRR_PEER_HTBL_SIZE         64
+
+typedef struct wrr_peer_s {
+  struct in_addr       addr;
+  interface_type_t     interface_type;
+  volatile uint32_t    outstanding_transactions;
+} wrr_peer_t;
+
+typedef struct wrr_candidate_s {
+  wrr_peer_t          *peer;
+  int32_t              weight;
+  int32_t              current_weight;
+} wrr_candidate_t;
+
+typedef struct wrr_service_s {
+  pthread_mutex_t      lock;
+  int                  num_candidates;
+  wrr_candidate_t      candidates[MME_APP_WRR_MAX_CANDIDATES];
+} wrr_service_t;
+
+static hash_table_ts_t * wrr_services = NULL;
+static hash_table_ts_t * wrr_peers    = NULL;
+static bool              wrr_load_feedback = false;
+
+//------------------------------------------------------------------------------
+static inline hash_key_t mme_app_wrr_service_key(const interface_type_t interface_type, const uint16_t mcc, const uint16_t mnc, const uint16_t tac)
+{
+  return ((hash_key_t)(interface_type & 0xFF) << 56) | ((hash_key_t)mcc << 32) | ((hash_key_t)mnc << 16) | (hash_key_t)tac;
+}
+
+//------------------------------------------------------------------------------
+static inline hash_key_t mme_app_wrr_peer_key(const struct in_addr peer, const interface_type_t interface_type)
+{
+  return ((hash_key_t)(interface_type & 0xFF) << 32) | (hash_key_t)peer.s_addr;
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_wrr_free_service(void ** service)
+{
+  if (service && *service) {
+    pthread_mutex_destroy(&((wrr_service_t*)*service)->lock);
+    free_wrapper(service);
+  }
+}
+
+//------------------------------------------------------------------------------
+static wrr_peer_t * mme_app_wrr_get_peer(const struct in_addr peer, const interface_type_t interface_type)
+{
+  wrr_peer_t * wrr_peer = NULL;
+  if (wrr_peers) {
+    hashtable_ts_get (wrr_peers, mme_app_wrr_peer_key(peer, interface_type), (void **)&wrr_peer);
+  }
+  return wrr_peer;
+}
+
+//------------------------------------------------------------------------------
+static int32_t mme_app_wrr_effective_weight(const wrr_candidate_t * const candidate)
+{
+  if (!wrr_load_feedback) {
+    return candidate->weight;
+  }
+  const uint32_t load = __atomic_load_n(&candidate->peer->outstanding_transactions, __ATOMIC_RELAXED) * MME_APP_WRR_TRANSACTION_COST;
+  const int32_t weight = (int32_t)(((int64_t)candidate->weight * MME_APP_WRR_LOAD_SCALE) / (MME_APP_WRR_LOAD_SCALE + load));
+  // never starve a peer completely, an idle peer must be able to recover
+  return (weight > 0) ? weight:1;
+}
+
+//------------------------------------------------------------------------------
+static int mme_app_wrr_add_service(const bstring id, const struct in_addr in_addr, const interface_type_t interface_type, const uint16_t weight)
+{
+  unsigned int tac_lb = 0, tac_hb = 0, mnc = 0, mcc = 0;
+
+  if (INADDR_ANY == in_addr.s_addr) {
+    // Do not halt the config process
+    return RETURNok;
+  }
+  if (4 != sscanf(bdata(id), "tac-lb%2x.tac-hb%2x.tac.epc.mnc%3u.mcc%3u.3gppnetwork.org", &tac_lb, &tac_hb, &mnc, &mcc)) {
+    // Not TAI based, only reachable through the E-DNS emulation
+    OAILOG_WARNING (LOG_MME_APP, "Service %s is not a TAI FQDN, not added to WRR selection\n", bdata(id));
+    return RETURNok;
+  }
+
+  const hash_key_t peer_key = mme_app_wrr_peer_key(in_addr, interface_type);
+  wrr_peer_t * peer = NULL;
+  if (HASH_TABLE_OK != hashtable_ts_get (wrr_peers, peer_key, (void **)&peer)) {
+    peer = calloc(1, sizeof(wrr_peer_t));
+    if (!peer) return RETURNerror;
+    peer->addr.s_addr   = in_addr.s_addr;
+    peer->interface_type = interface_type;
+    if (HASH_TABLE_OK != hashtable_ts_insert (wrr_peers, peer_key, peer)) {
+      free_wrapper((void**)&peer);
+      return RETURNerror;
+    }
+  }
+
+  const hash_key_t service_key = mme_app_wrr_service_key(interface_type, mcc, mnc, (tac_hb << 8) | tac_lb);
+  wrr_service_t * service = NULL;
+  if (HASH_TABLE_OK != hashtable_ts_get (wrr_services, service_key, (void **)&service)) {
+    service = calloc(1, sizeof(wrr_service_t));
+    if (!service) return RETURNerror;
+    pthread_mutex_init(&service->lock, NULL);
+    if (HASH_TABLE_OK != hashtable_ts_insert (wrr_services, service_key, service)) {
+      mme_app_wrr_free_service((void**)&service);
+      return RETURNerror;
+    }
+  }
+  for (int i = 0; i < service->num_candidates; i++) {
+    if (service->candidates[i].peer == peer) {
+      // same peer listed twice for the same TAI, cumulate weights
+      service->candidates[i].weight += weight;
+      return RETURNok;
+    }
+  }
+  if (MME_APP_WRR_MAX_CANDIDATES <= service->num_candidates) {
+    OAILOG_ERROR (LOG_MME_APP, "Too many candidates for service %s (max %d)\n", bdata(id), MME_APP_WRR_MAX_CANDIDATES);
+    return RETURNerror;
+  }
+  service->candidates[service->num_candidates].peer   = peer;
+  service->candidates[service->num_candidates].weight = weight;
+  service->candidates[service->num_candidates].current_weight = 0;
+  service->num_candidates += 1;
+  OAILOG_INFO (LOG_MME_APP, "WRR service %s candidate %d %s weight %u\n", bdata(id), service->num_candidates, inet_ntoa(in_addr), weight);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int  mme_app_wrr_selection_init (const mme_config_t * mme_config_p)
+{
+  int rc = RETURNok;
+  bstring b = bfromcstr("mme_app_wrr_services_htbl");
+  wrr_services = hashtable_ts_create (min(64, MME_CONFIG_MAX_SERVICE), NULL, mme_app_wrr_free_service, b);
+  btrunc(b, 0);
+  bassigncstr(b, "mme_app_wrr_peers_htbl");
+  wrr_peers = hashtable_ts_create (MME_APP_WRR_PEER_HTBL_SIZE, NULL, hash_free_func, b);
+  bdestroy_wrapper (&b);
+  if (!wrr_services || !wrr_peers) {
+    return RETURNerror;
+  }
+  wrr_load_feedback = mme_config_p->e_dns_emulation.load_feedback;
+  for (int i = 0; i < mme_config_p->e_dns_emulation.nb_service_entries; i++) {
+    rc |= mme_app_wrr_add_service(mme_config_p->e_dns_emulation.service_id[i], mme_config_p->e_dns_emulation.service_ip_addr[i],
+        mme_config_p->e_dns_emulation.interface_type[i], mme_config_p->e_dns_emulation.weight[i]);
+  }
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+void  mme_app_wrr_selection_exit (void)
+{
+  hashtable_ts_destroy (wrr_services);
+  wrr_services = NULL;
+  hashtable_ts_destroy (wrr_peers);
+  wrr_peers = NULL;
+}
+
+//------------------------------------------------------------------------------
+static bool mme_app_wrr_select_candidate(const hash_key_t service_key, struct in_addr * const service_in_addr)
+{
+  wrr_service_t * service = NULL;
+
+  if (!wrr_services || (HASH_TABLE_OK != hashtable_ts_get (wrr_services, service_key, (void **)&service))) {
+    return false;
+  }
+  // smooth weighted round robin: every candidate gains its effective weight, the best one pays back the total
+  wrr_candidate_t * best = NULL;
+  int32_t           total = 0;
+  pthread_mutex_lock(&service->lock);
+  for (int i = 0; i < service->num_candidates; i++) {
+    wrr_candidate_t * candidate = &service->candidates[i];
+    const int32_t weight = mme_app_wrr_effective_weight(candidate);
+    candidate->current_weight += weight;
+    total += weight;
+    if ((!best) || (candidate->current_weight > best->current_weight)) {
+      best = candidate;
+    }
+  }
+  if (best) {
+    best->current_weight -= total;
+    service_in_addr->s_addr = best->peer->addr.s_addr;
+  }
+  pthread_mutex_unlock(&service->lock);
+  return (best != NULL);
+}
+
 //------------------------------------------------------------------------------
 void mme_app_select_service(const tai_t * const tai, struct in_addr * const service_in_addr, const interface_type_t interface_type)
 {
@@ -52,15 +244,24 @@ void mme_app_select_service(const tai_t * const tai, struct in_addr * const serv
   // 5.2 Procedures for Discovering and Selecting an MME or SGW (service: ="x-3gpp-mme:x-s10/s11" )
   // ....
 
-  // do it the simplest way for now
-  //
+  uint16_t mnc = (tai->plmn.mnc_digit1 *10) + tai->plmn.mnc_digit2;
+  if (10 > tai->plmn.mnc_digit3) {
+    mnc = (mnc *10) + tai->plmn.mnc_digit3;
+  }
+  const uint16_t mcc = (tai->plmn.mcc_digit1 * 100) + (tai->plmn.mcc_digit2 * 10) + tai->plmn.mcc_digit3;
+
+  if (mme_app_wrr_select_candidate(mme_app_wrr_service_key(interface_type, mcc, mnc, tai->tac), service_in_addr)) {
+    OAILOG_DEBUG (LOG_MME_APP, "Service lookup for TAI " TAI_FMT " returned %s\n", TAI_ARG(tai), inet_ntoa (*service_in_addr));
+    return;
+  }
+
+  // Not in the selection cache, fall back on the E-DNS emulation
   char tmp[8];
   bstring application_unique_string = bfromcstr("tac-lb");
   if (0 < snprintf(tmp, 8, "%02x", tai->tac & 0x00FF)) {
     bcatcstr(application_unique_string, tmp);
   } else {
-    service_in_addr->s_addr = 0;
-    return;
+    goto lookup_error;
   }
   bcatcstr(application_unique_string, ".tac-hb");
   if (0 < snprintf(tmp, 8, "%02x", tai->tac >> 8)) {
@@ -69,10 +270,6 @@ void mme_app_select_service(const tai_t * const tai, struct in_addr * const serv
     goto lookup_error;
   }
   bcatcstr(application_unique_string, ".tac.epc.mnc");
-  uint16_t mnc = (tai->plmn.mnc_digit1 *10) + tai->plmn.mnc_digit2;
-  if (10 > tai->plmn.mnc_digit3) {
-    mnc = (mnc *10) + tai->plmn.mnc_digit3;
-  }
   if (0 < snprintf(tmp, 8, "%03u",mnc)) {
     bcatcstr(application_unique_string, tmp);
   } else {
@@ -104,3 +301,24 @@ lookup_error:
   bdestroy_wrapper(&application_unique_string);
   return;
 }
+
+//------------------------------------------------------------------------------
+void mme_app_wrr_transaction_start (const struct in_addr peer, const interface_type_t interface_type)
+{
+  wrr_peer_t * wrr_peer = mme_app_wrr_get_peer(peer, interface_type);
+  if (wrr_peer) {
+    __atomic_add_fetch(&wrr_peer->outstanding_transactions, 1, __ATOMIC_RELAXED);
+  }
+}
+
+//------------------------------------------------------------------------------
+void mme_app_wrr_transaction_end (const struct in_addr peer, const interface_type_t interface_type)
+{
+  wrr_peer_t * wrr_peer = mme_app_wrr_get_peer(peer, interface_type);
+  if (wrr_peer) {
+    uint32_t outstanding = __atomic_load_n(&wrr_peer->outstanding_transactions, __ATOMIC_RELAXED);
+    // do not wrap if a response is received for a transaction started before a restart of the counters
+    while (outstanding &&
+        !__atomic_compare_exchange_n(&wrr_peer->outstanding_transactions, &outstanding, outstanding - 1, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+  }
+}
@@ -30,6 +30,20 @@
   \email: lionel.gauthier@eurecom.fr
 */
 
+#define MME_APP_WRR_MAX_CANDIDATES 16
+
+struct mme_config_s;
+
+int  mme_app_wrr_selection_init (const struct mme_config_s * mme_config_p);
+void mme_app_wrr_selection_exit (void);
+
 void mme_app_select_service(const tai_t * const tai, struct in_addr * const mme_in_addr, const interface_type_t interface_type);
 
+/*
+ * Load feedback, only taken into account if WRR_LOAD_FEEDBACK is enabled in the configuration.
+ * A transaction start must be followed by a transaction end for the same peer (response or timeout).
+ */
+void mme_app_wrr_transaction_start (const struct in_addr peer, const interface_type_t interface_type);
+void mme_app_wrr_transaction_end (const struct in_addr peer, const interface_type_t interface_type);
+
 #endif
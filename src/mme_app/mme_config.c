@@ -210,12 +210,24 @@ static void mme_config_init (mme_config_t * config_pP)
   config_pP->ipv4.s10.s_addr = INADDR_ANY;
   config_pP->ipv4.port_s10 = 2123;
   config_pP->s6a_config.conf_file = bfromcstr(S6A_CONF_FILE);
+  config_pP->s6a_config.auth_vector_cache.size = 0;
+  config_pP->s6a_config.auth_vector_cache.nb_vectors = 3;
+  config_pP->s6a_config.auth_vector_cache.max_age_sec = 3600;
+  config_pP->s6a_config.auth_vector_cache.prefetch = false;
+  config_pP->s6a_config.max_in_flight = 4096;
+  config_pP->s6a_config.backlog = 16384;
+  config_pP->s6a_config.request_timeout_ms = 5000;
   config_pP->itti_config.queue_size = ITTI_QUEUE_MAX_ELEMENTS;
   config_pP->itti_config.log_file = NULL;
+  config_pP->itti_config.trace_file = NULL;
+  config_pP->itti_config.trace_file_size = 64;
+  config_pP->itti_config.latency_file = NULL;
   config_pP->sctp_config.in_streams = SCTP_IN_STREAMS;
   config_pP->sctp_config.out_streams = SCTP_OUT_STREAMS;
   config_pP->relative_capacity = RELATIVE_CAPACITY;
   config_pP->mme_statistic_timer = MME_STATISTIC_TIMER_S;
+  config_pP->snapshot_config.file = NULL;
+  config_pP->snapshot_config.period_sec = 60;
 
   // todo: sgw address?
 //  config_pP->ipv4.sgw_s11 = 0;
@@ -263,6 +275,15 @@ static void mme_config_init (mme_config_t * config_pP)
   config_pP->served_tai.plmn_mnc_len[0] = PLMN_MNC_LEN;
   config_pP->served_tai.tac[0] = PLMN_TAC;
   config_pP->s1ap_config.outcome_drop_timer_sec = S1AP_OUTCOME_TIMER_DEFAULT;
+  config_pP->s1ap_config.admission_queue_high = 0;
+  config_pP->s1ap_config.admission_queue_low = 0;
+  config_pP->s1ap_config.overload.period_ms = 1000;
+  config_pP->s1ap_config.overload.queue_threshold = 0;
+  config_pP->s1ap_config.overload.s6a_threshold = 0;
+  config_pP->s1ap_config.overload.s11_threshold = 0;
+  config_pP->s1ap_config.overload.cpu_threshold = 0;
+  config_pP->s1ap_config.overload.stop_hysteresis = 10;
+  config_pP->s1ap_config.overload.nb_levels = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -280,7 +301,20 @@ void mme_config_exit (void)
   bdestroy_wrapper(&mme_config.ipv4.if_name_s11);
   bdestroy_wrapper(&mme_config.s6a_config.conf_file);
   bdestroy_wrapper(&mme_config.s6a_config.hss_host_name);
+  bdestroy_wrapper(&mme_config.snapshot_config.file);
   bdestroy_wrapper(&mme_config.itti_config.log_file);
+  bdestroy_wrapper(&mme_config.itti_config.trace_file);
+  bdestroy_wrapper(&mme_config.itti_config.latency_file);
+  for (int i = 0; i < mme_config.itti_config.nb_trace_tasks; i++) {
+    bdestroy_wrapper(&mme_config.itti_config.trace_tasks[i]);
+  }
+  for (int i = 0; i < mme_config.itti_config.nb_trace_messages; i++) {
+    bdestroy_wrapper(&mme_config.itti_config.trace_messages[i]);
+  }
+  for (int i = 0; i < mme_config.itti_config.nb_thread_placements; i++) {
+    bdestroy_wrapper(&mme_config.itti_config.thread_placement[i].task);
+    bdestroy_wrapper(&mme_config.itti_config.thread_placement[i].cpus);
+  }
 
   free_wrapper((void**)&mme_config.served_tai.plmn_mcc);
   free_wrapper((void**)&mme_config.served_tai.plmn_mnc);
@@ -295,6 +329,82 @@ void mme_config_exit (void)
   bdestroy_wrapper(&mme_config.scenario_player_config.scenario_file);
 #endif
 }
+static const char * const overload_action_str[OVERLOAD_ACTION_MAX] = {
+  "REJECT_NON_EMERGENCY_MO_DT",
+  "REJECT_RRC_CR_SIGNALLING",
+  "PERMIT_EMERGENCY_SESSIONS_AND_MOBILE_TERMINATED_SERVICES_ONLY",
+  "PERMIT_HIGH_PRIORITY_SESSIONS_AND_MOBILE_TERMINATED_SERVICES_ONLY",
+  "REJECT_DELAY_TOLERANT_ACCESS"
+};
+
+//------------------------------------------------------------------------------
+static void mme_config_parse_overload (config_setting_t * const setting, mme_config_t * config_pP)
+{
+  config_setting_t                       *levels = NULL;
+  config_setting_t                       *level = NULL;
+  const char                             *astring = NULL;
+  int                                     aint = 0;
+  int                                     num = 0;
+
+  if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_OVERLOAD_PERIOD_MS, &aint))) {
+    AssertFatal(0 < aint, "Bad %s value %d", MME_CONFIG_STRING_OVERLOAD_PERIOD_MS, aint);
+    config_pP->s1ap_config.overload.period_ms = (uint32_t) aint;
+  }
+  if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_OVERLOAD_QUEUE_THRESHOLD, &aint))) {
+    AssertFatal(0 <= aint, "Bad %s value %d", MME_CONFIG_STRING_OVERLOAD_QUEUE_THRESHOLD, aint);
+    config_pP->s1ap_config.overload.queue_threshold = (uint32_t) aint;
+  }
+  if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_OVERLOAD_S6A_THRESHOLD, &aint))) {
+    AssertFatal(0 <= aint, "Bad %s value %d", MME_CONFIG_STRING_OVERLOAD_S6A_THRESHOLD, aint);
+    config_pP->s1ap_config.overload.s6a_threshold = (uint32_t) aint;
+  }
+  if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_OVERLOAD_S11_THRESHOLD, &aint))) {
+    AssertFatal(0 <= aint, "Bad %s value %d", MME_CONFIG_STRING_OVERLOAD_S11_THRESHOLD, aint);
+    config_pP->s1ap_config.overload.s11_threshold = (uint32_t) aint;
+  }
+  if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_OVERLOAD_CPU_THRESHOLD, &aint))) {
+    AssertFatal((0 <= aint) && (aint <= 100), "Bad %s value %d", MME_CONFIG_STRING_OVERLOAD_CPU_THRESHOLD, aint);
+    config_pP->s1ap_config.overload.cpu_threshold = (uint32_t) aint;
+  }
+  if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_OVERLOAD_STOP_HYSTERESIS, &aint))) {
+    AssertFatal(0 <= aint, "Bad %s value %d", MME_CONFIG_STRING_OVERLOAD_STOP_HYSTERESIS, aint);
+    config_pP->s1ap_config.overload.stop_hysteresis = (uint32_t) aint;
+  }
+
+  levels = config_setting_get_member (setting, MME_CONFIG_STRING_OVERLOAD_LEVELS);
+  if (levels != NULL) {
+    num = config_setting_length (levels);
+    AssertFatal(num <= MME_CONFIG_MAX_OVERLOAD_LEVELS, "Too many %s defined (%d>%d)", MME_CONFIG_STRING_OVERLOAD_LEVELS, num, MME_CONFIG_MAX_OVERLOAD_LEVELS);
+
+    for (int i = 0; i < num; i++) {
+      level = config_setting_get_elem (levels, i);
+      AssertFatal(level != NULL, "Bad %s item %d", MME_CONFIG_STRING_OVERLOAD_LEVELS, i);
+
+      AssertFatal(config_setting_lookup_int (level, MME_CONFIG_STRING_OVERLOAD_LOAD, &aint), "Missing %s in %s item %d",
+          MME_CONFIG_STRING_OVERLOAD_LOAD, MME_CONFIG_STRING_OVERLOAD_LEVELS, i);
+      AssertFatal((0 < aint) && ((0 == i) || ((uint32_t)aint > config_pP->s1ap_config.overload.level[i-1].load)),
+          "Bad %s value %d in %s item %d (must be > 0 and increasing)", MME_CONFIG_STRING_OVERLOAD_LOAD, aint, MME_CONFIG_STRING_OVERLOAD_LEVELS, i);
+      config_pP->s1ap_config.overload.level[i].load = (uint32_t) aint;
+
+      AssertFatal(config_setting_lookup_string (level, MME_CONFIG_STRING_OVERLOAD_ACTION, &astring), "Missing %s in %s item %d",
+          MME_CONFIG_STRING_OVERLOAD_ACTION, MME_CONFIG_STRING_OVERLOAD_LEVELS, i);
+      int action = 0;
+      for (action = 0; action < OVERLOAD_ACTION_MAX; action++) {
+        if (0 == strcasecmp (astring, overload_action_str[action])) break;
+      }
+      AssertFatal(action < OVERLOAD_ACTION_MAX, "Bad %s value %s in %s item %d", MME_CONFIG_STRING_OVERLOAD_ACTION, astring, MME_CONFIG_STRING_OVERLOAD_LEVELS, i);
+      config_pP->s1ap_config.overload.level[i].action = (overload_action_t) action;
+
+      config_pP->s1ap_config.overload.level[i].traffic_load_reduction = 0;
+      if ((config_setting_lookup_int (level, MME_CONFIG_STRING_OVERLOAD_TRAFFIC_LOAD_REDUCTION, &aint))) {
+        AssertFatal((0 <= aint) && (aint <= 99), "Bad %s value %d in %s item %d", MME_CONFIG_STRING_OVERLOAD_TRAFFIC_LOAD_REDUCTION, aint, MME_CONFIG_STRING_OVERLOAD_LEVELS, i);
+        config_pP->s1ap_config.overload.level[i].traffic_load_reduction = (uint8_t) aint;
+      }
+    }
+    config_pP->s1ap_config.overload.nb_levels = num;
+  }
+}
+
 //------------------------------------------------------------------------------
 static int mme_config_parse_file (mme_config_t * config_pP)
 {
@@ -477,6 +587,17 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       config_pP->mme_statistic_timer = (uint32_t) aint;
     }
 
+    if ((config_setting_lookup_string (setting_mme, MME_CONFIG_STRING_SNAPSHOT_FILE, (const char **)&astring))) {
+      if ((astring) && (strlen(astring))) {
+        config_pP->snapshot_config.file = bfromcstr(astring);
+      }
+    }
+
+    if ((config_setting_lookup_int (setting_mme, MME_CONFIG_STRING_SNAPSHOT_PERIOD, &aint))) {
+      AssertFatal(0 < aint, "Bad %s value %d", MME_CONFIG_STRING_SNAPSHOT_PERIOD, aint);
+      config_pP->snapshot_config.period_sec = (uint32_t) aint;
+    }
+
     if ((config_setting_lookup_int (setting_mme, MME_CONFIG_STRING_MME_MOBILITY_COMPLETION_TIMER, &aint))) {
       config_pP->mme_mobility_completion_timer = (uint32_t) aint;
     }
@@ -531,6 +652,81 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_QUEUE_SIZE, &aint))) {
         config_pP->itti_config.queue_size = (uint32_t) aint;
       }
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_ITTI_TRACE_FILE, (const char **)&astring))) {
+        if ((astring) && (strlen(astring))) {
+          config_pP->itti_config.trace_file = bfromcstr(astring);
+        }
+      }
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_ITTI_LATENCY_FILE, (const char **)&astring))) {
+        if ((astring) && (strlen(astring))) {
+          config_pP->itti_config.latency_file = bfromcstr(astring);
+        }
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_ITTI_TRACE_FILE_SIZE, &aint))) {
+        AssertFatal(0 < aint, "Bad %s value %d", MME_CONFIG_STRING_ITTI_TRACE_FILE_SIZE, aint);
+        config_pP->itti_config.trace_file_size = (uint32_t) aint;
+      }
+      subsetting = config_setting_get_member (setting, MME_CONFIG_STRING_ITTI_TRACE_TASKS);
+      if (subsetting != NULL) {
+        num = config_setting_length (subsetting);
+        AssertFatal(num <= MME_CONFIG_MAX_ITTI_TRACE_FILTERS, "Too many %s (max %d)", MME_CONFIG_STRING_ITTI_TRACE_TASKS, MME_CONFIG_MAX_ITTI_TRACE_FILTERS);
+        for (i = 0; i < num; i++) {
+          astring = config_setting_get_string_elem (subsetting, i);
+          if (astring) {
+            config_pP->itti_config.trace_tasks[config_pP->itti_config.nb_trace_tasks++] = bfromcstr(astring);
+          }
+        }
+      }
+      subsetting = config_setting_get_member (setting, MME_CONFIG_STRING_ITTI_TRACE_MESSAGES);
+      if (subsetting != NULL) {
+        num = config_setting_length (subsetting);
+        AssertFatal(num <= MME_CONFIG_MAX_ITTI_TRACE_FILTERS, "Too many %s (max %d)", MME_CONFIG_STRING_ITTI_TRACE_MESSAGES, MME_CONFIG_MAX_ITTI_TRACE_FILTERS);
+        for (i = 0; i < num; i++) {
+          astring = config_setting_get_string_elem (subsetting, i);
+          if (astring) {
+            config_pP->itti_config.trace_messages[config_pP->itti_config.nb_trace_messages++] = bfromcstr(astring);
+          }
+        }
+      }
+      subsetting = config_setting_get_member (setting, MME_CONFIG_STRING_ITTI_THREAD_PLACEMENT);
+      if (subsetting != NULL) {
+        num = config_setting_length (subsetting);
+        AssertFatal(num <= MME_CONFIG_MAX_ITTI_THREAD_PLACEMENTS, "Too many %s (max %d)", MME_CONFIG_STRING_ITTI_THREAD_PLACEMENT, MME_CONFIG_MAX_ITTI_THREAD_PLACEMENTS);
+        for (i = 0; i < num; i++) {
+          config_setting_t *placement_setting = config_setting_get_elem (subsetting, i);
+          const int         p = config_pP->itti_config.nb_thread_placements;
+
+          AssertFatal (config_setting_lookup_string (placement_setting, MME_CONFIG_STRING_ITTI_PLACEMENT_TASK, (const char **)&astring),
+              "Missing %s in %s", MME_CONFIG_STRING_ITTI_PLACEMENT_TASK, MME_CONFIG_STRING_ITTI_THREAD_PLACEMENT);
+          config_pP->itti_config.thread_placement[p].task = bfromcstr(astring);
+          config_pP->itti_config.thread_placement[p].cpus = NULL;
+          if ((config_setting_lookup_string (placement_setting, MME_CONFIG_STRING_ITTI_PLACEMENT_CPUS, (const char **)&astring))) {
+            if ((astring) && (strlen(astring))) {
+              config_pP->itti_config.thread_placement[p].cpus = bfromcstr(astring);
+            }
+          }
+          config_pP->itti_config.thread_placement[p].numa_node = -1;
+          if ((config_setting_lookup_int (placement_setting, MME_CONFIG_STRING_ITTI_PLACEMENT_NUMA_NODE, &aint))) {
+            config_pP->itti_config.thread_placement[p].numa_node = (int) aint;
+          }
+          config_pP->itti_config.thread_placement[p].wait_mode = ITTI_WAIT_MODE_BLOCK;
+          if ((config_setting_lookup_string (placement_setting, MME_CONFIG_STRING_ITTI_PLACEMENT_WAIT_MODE, (const char **)&astring))) {
+            if (strcasecmp (astring, "ADAPTIVE_SPIN") == 0) {
+              config_pP->itti_config.thread_placement[p].wait_mode = ITTI_WAIT_MODE_ADAPTIVE_SPIN;
+            } else if (strcasecmp (astring, "BUSY_POLL") == 0) {
+              config_pP->itti_config.thread_placement[p].wait_mode = ITTI_WAIT_MODE_BUSY_POLL;
+            } else {
+              AssertFatal (strcasecmp (astring, "BLOCK") == 0, "Bad %s value %s", MME_CONFIG_STRING_ITTI_PLACEMENT_WAIT_MODE, astring);
+            }
+          }
+          config_pP->itti_config.thread_placement[p].spin_us = 50;
+          if ((config_setting_lookup_int (placement_setting, MME_CONFIG_STRING_ITTI_PLACEMENT_SPIN_US, &aint))) {
+            AssertFatal(0 <= aint, "Bad %s value %d", MME_CONFIG_STRING_ITTI_PLACEMENT_SPIN_US, aint);
+            config_pP->itti_config.thread_placement[p].spin_us = (uint32_t) aint;
+          }
+          config_pP->itti_config.nb_thread_placements++;
+        }
+      }
     }
     // S6A SETTING
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_S6A_CONFIG);
@@ -568,6 +764,39 @@ static int mme_config_parse_file (mme_config_t * config_pP)
         } else
           AssertFatal (1 == 0, "You have to provide a valid MME hostname %s=...\n", MME_CONFIG_STRING_S6A_MME_HOSTNAME);
       }
+
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S6A_MAX_IN_FLIGHT, &aint))) {
+        AssertFatal(0 < aint, "Bad %s value %d", MME_CONFIG_STRING_S6A_MAX_IN_FLIGHT, aint);
+        config_pP->s6a_config.max_in_flight = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S6A_BACKLOG, &aint))) {
+        AssertFatal(0 <= aint, "Bad %s value %d", MME_CONFIG_STRING_S6A_BACKLOG, aint);
+        config_pP->s6a_config.backlog = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S6A_REQUEST_TIMEOUT, &aint))) {
+        AssertFatal(0 < aint, "Bad %s value %d", MME_CONFIG_STRING_S6A_REQUEST_TIMEOUT, aint);
+        config_pP->s6a_config.request_timeout_ms = (uint32_t) aint;
+      }
+
+      subsetting = config_setting_get_member (setting, MME_CONFIG_STRING_S6A_AUTH_VECTOR_CACHE);
+      if (subsetting != NULL) {
+        if ((config_setting_lookup_int (subsetting, MME_CONFIG_STRING_AUTH_VECTOR_CACHE_SIZE, &aint))) {
+          AssertFatal(0 <= aint, "Bad %s value %d", MME_CONFIG_STRING_AUTH_VECTOR_CACHE_SIZE, aint);
+          config_pP->s6a_config.auth_vector_cache.size = (uint32_t) aint;
+        }
+        if ((config_setting_lookup_int (subsetting, MME_CONFIG_STRING_AUTH_VECTOR_CACHE_VECTORS, &aint))) {
+          // Number-Of-Requested-Vectors, the HSS does not return more than 5 E-UTRAN vectors
+          AssertFatal((1 <= aint) && (5 >= aint), "Bad %s value %d (1..5)", MME_CONFIG_STRING_AUTH_VECTOR_CACHE_VECTORS, aint);
+          config_pP->s6a_config.auth_vector_cache.nb_vectors = (uint32_t) aint;
+        }
+        if ((config_setting_lookup_int (subsetting, MME_CONFIG_STRING_AUTH_VECTOR_CACHE_MAX_AGE, &aint))) {
+          AssertFatal(0 < aint, "Bad %s value %d", MME_CONFIG_STRING_AUTH_VECTOR_CACHE_MAX_AGE, aint);
+          config_pP->s6a_config.auth_vector_cache.max_age_sec = (uint32_t) aint;
+        }
+        if ((config_setting_lookup_string (subsetting, MME_CONFIG_STRING_AUTH_VECTOR_CACHE_PREFETCH, (const char **)&astring))) {
+          config_pP->s6a_config.auth_vector_cache.prefetch = (strcasecmp (astring, "yes") == 0);
+        }
+      }
     }
     // SCTP SETTING
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_SCTP_CONFIG);
@@ -592,6 +821,23 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S1AP_PORT, &aint))) {
         config_pP->s1ap_config.port_number = (uint16_t) aint;
       }
+
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S1AP_ADMISSION_QUEUE_HIGH, &aint))) {
+        AssertFatal(0 <= aint, "Bad %s value %d", MME_CONFIG_STRING_S1AP_ADMISSION_QUEUE_HIGH, aint);
+        config_pP->s1ap_config.admission_queue_high = (uint32_t) aint;
+        config_pP->s1ap_config.admission_queue_low = (uint32_t) aint / 2;
+      }
+
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S1AP_ADMISSION_QUEUE_LOW, &aint))) {
+        AssertFatal((0 <= aint) && ((uint32_t)aint <= config_pP->s1ap_config.admission_queue_high),
+            "Bad %s value %d (must be <= %s)", MME_CONFIG_STRING_S1AP_ADMISSION_QUEUE_LOW, aint, MME_CONFIG_STRING_S1AP_ADMISSION_QUEUE_HIGH);
+        config_pP->s1ap_config.admission_queue_low = (uint32_t) aint;
+      }
+
+      subsetting = config_setting_get_member (setting, MME_CONFIG_STRING_S1AP_OVERLOAD);
+      if (subsetting != NULL) {
+        mme_config_parse_overload (subsetting, config_pP);
+      }
     }
     // TAI list setting
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_TAI_LIST);
@@ -926,6 +1172,10 @@ static int mme_config_parse_file (mme_config_t * config_pP)
     }
   }
 
+  if ((config_setting_lookup_string (setting_mme, MME_CONFIG_STRING_WRR_LOAD_FEEDBACK, (const char **)&astring))) {
+    config_pP->e_dns_emulation.load_feedback = (strcasecmp (astring, "yes") == 0);
+  }
+
   // todo: selection instead of config!
   setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_WRR_LIST_SELECTION);
   if (setting != NULL) {
@@ -944,6 +1194,11 @@ static int mme_config_parse_file (mme_config_t * config_pP)
           break;
         }
         config_pP->e_dns_emulation.service_id[i] = bfromcstr(id);
+        int weight = 1;
+        if (config_setting_lookup_int (sub2setting, MME_CONFIG_STRING_WEIGHT, &weight)) {
+          AssertFatal((0 < weight) && (weight <= UINT16_MAX), "Bad %s value %d for service %s", MME_CONFIG_STRING_WEIGHT, weight, id);
+        }
+        config_pP->e_dns_emulation.weight[i] = (uint16_t)weight;
 
         /** Check S11 Endpoint (service="x-3gpp-sgw:x-s11"). */
         if ((config_setting_lookup_string (sub2setting, SGW_CONFIG_STRING_SGW_IPV4_ADDRESS_FOR_S11, (const char **)&sgw_ip_address_for_s11)
@@ -1041,9 +1296,29 @@ static void mme_config_display (mme_config_t * config_pP)
   OAILOG_INFO (LOG_CONFIG, "- Extended service request .............: %s\n", config_pP->eps_network_feature_support.extended_service_request == 0 ? "false" : "true");
   OAILOG_INFO (LOG_CONFIG, "- Unauth IMSI support ..................: %s\n", config_pP->unauthenticated_imsi_supported == 0 ? "false" : "true");
   OAILOG_INFO (LOG_CONFIG, "- Relative capa ........................: %u\n", config_pP->relative_capacity);
-  OAILOG_INFO (LOG_CONFIG, "- Statistics timer .....................: %u (seconds)\n\n", config_pP->mme_statistic_timer);
+  OAILOG_INFO (LOG_CONFIG, "- Statistics timer .....................: %u (seconds)\n", config_pP->mme_statistic_timer);
+  if (config_pP->snapshot_config.file) {
+    OAILOG_INFO (LOG_CONFIG, "- UE context snapshot ..................: %s (every %u seconds)\n", bdata(config_pP->snapshot_config.file), config_pP->snapshot_config.period_sec);
+  }
+  OAILOG_INFO (LOG_CONFIG, "\n");
   OAILOG_INFO (LOG_CONFIG, "- S1-MME:\n");
   OAILOG_INFO (LOG_CONFIG, "    port number ......: %d\n", config_pP->s1ap_config.port_number);
+  if (config_pP->s1ap_config.admission_queue_high) {
+    OAILOG_INFO (LOG_CONFIG, "    admission ........: shed above %u, admit below %u queued messages\n",
+        config_pP->s1ap_config.admission_queue_high, config_pP->s1ap_config.admission_queue_low);
+  }
+  if (config_pP->s1ap_config.overload.nb_levels) {
+    OAILOG_INFO (LOG_CONFIG, "    overload .........: sampled every %u ms, 100%% load at queue %u, S6a %u, S11 %u, CPU %u%%, stop hysteresis %u\n",
+        config_pP->s1ap_config.overload.period_ms, config_pP->s1ap_config.overload.queue_threshold,
+        config_pP->s1ap_config.overload.s6a_threshold, config_pP->s1ap_config.overload.s11_threshold,
+        config_pP->s1ap_config.overload.cpu_threshold, config_pP->s1ap_config.overload.stop_hysteresis);
+    for (int j = 0; j < config_pP->s1ap_config.overload.nb_levels; j++) {
+      OAILOG_INFO (LOG_CONFIG, "      load >= %3u%% .: %s, traffic load reduction %u%%\n",
+          config_pP->s1ap_config.overload.level[j].load,
+          overload_action_str[config_pP->s1ap_config.overload.level[j].action],
+          config_pP->s1ap_config.overload.level[j].traffic_load_reduction);
+    }
+  }
   OAILOG_INFO (LOG_CONFIG, "- IP:\n");
   OAILOG_INFO (LOG_CONFIG, "    s1-MME iface .....: %s\n", bdata(config_pP->ipv4.if_name_s1_mme));
   OAILOG_INFO (LOG_CONFIG, "    s1-MME ip ........: %s\n", inet_ntoa (*((struct in_addr *)&config_pP->ipv4.s1_mme)));
@@ -1056,6 +1331,18 @@ static void mme_config_display (mme_config_t * config_pP)
   OAILOG_INFO (LOG_CONFIG, "- ITTI:\n");
   OAILOG_INFO (LOG_CONFIG, "    queue size .......: %u (bytes)\n", config_pP->itti_config.queue_size);
   OAILOG_INFO (LOG_CONFIG, "    log file .........: %s\n", bdata(config_pP->itti_config.log_file));
+  if (config_pP->itti_config.trace_file) {
+    OAILOG_INFO (LOG_CONFIG, "    trace file .......: %s (%u MBytes, %d task filters, %d message filters)\n", bdata(config_pP->itti_config.trace_file),
+        config_pP->itti_config.trace_file_size, config_pP->itti_config.nb_trace_tasks, config_pP->itti_config.nb_trace_messages);
+  }
+  if (config_pP->itti_config.latency_file) {
+    OAILOG_INFO (LOG_CONFIG, "    latency file .....: %s (every %u s)\n", bdata(config_pP->itti_config.latency_file), config_pP->mme_statistic_timer);
+  }
+  for (int i = 0; i < config_pP->itti_config.nb_thread_placements; i++) {
+    OAILOG_INFO (LOG_CONFIG, "    %-16s .: CPUs %s, NUMA node %d, wait mode %d, spin %u us\n", bdata(config_pP->itti_config.thread_placement[i].task),
+        (config_pP->itti_config.thread_placement[i].cpus) ? bdata(config_pP->itti_config.thread_placement[i].cpus):"any",
+        config_pP->itti_config.thread_placement[i].numa_node, config_pP->itti_config.thread_placement[i].wait_mode, config_pP->itti_config.thread_placement[i].spin_us);
+  }
   OAILOG_INFO (LOG_CONFIG, "- SCTP:\n");
   OAILOG_INFO (LOG_CONFIG, "    in streams .......: %u\n", config_pP->sctp_config.in_streams);
   OAILOG_INFO (LOG_CONFIG, "    out streams ......: %u\n", config_pP->sctp_config.out_streams);
@@ -1116,6 +1403,15 @@ static void mme_config_display (mme_config_t * config_pP)
 
   OAILOG_INFO (LOG_CONFIG, "- S6A:\n");
   OAILOG_INFO (LOG_CONFIG, "    conf file ........: %s\n", bdata(config_pP->s6a_config.conf_file));
+  OAILOG_INFO (LOG_CONFIG, "    in flight ........: %u requests, backlog %u, timeout %u ms\n",
+      config_pP->s6a_config.max_in_flight, config_pP->s6a_config.backlog, config_pP->s6a_config.request_timeout_ms);
+  if (config_pP->s6a_config.auth_vector_cache.size) {
+    OAILOG_INFO (LOG_CONFIG, "    vector cache .....: %u IMSIs, %u vectors per AIR, max age %u sec, prefetch %s\n",
+        config_pP->s6a_config.auth_vector_cache.size, config_pP->s6a_config.auth_vector_cache.nb_vectors,
+        config_pP->s6a_config.auth_vector_cache.max_age_sec, (config_pP->s6a_config.auth_vector_cache.prefetch) ? "true":"false");
+  } else {
+    OAILOG_INFO (LOG_CONFIG, "    vector cache .....: disabled\n");
+  }
   OAILOG_INFO (LOG_CONFIG, "- Logging:\n");
   OAILOG_INFO (LOG_CONFIG, "    Output ..............: %s\n", bdata(config_pP->log_config.output));
   OAILOG_INFO (LOG_CONFIG, "    Output thread safe ..: %s\n", (config_pP->log_config.is_output_thread_safe) ? "true":"false");
@@ -53,6 +53,8 @@
 #define MME_CONFIG_STRING_MAXUE                          "MAXUE"
 #define MME_CONFIG_STRING_RELATIVE_CAPACITY              "RELATIVE_CAPACITY"
 #define MME_CONFIG_STRING_STATISTIC_TIMER                "MME_STATISTIC_TIMER"
+#define MME_CONFIG_STRING_SNAPSHOT_FILE                  "SNAPSHOT_FILE"
+#define MME_CONFIG_STRING_SNAPSHOT_PERIOD                "SNAPSHOT_PERIOD"
 #define MME_CONFIG_STRING_MME_MOBILITY_COMPLETION_TIMER  "MME_MOBILITY_COMPLETION_TIMER"
 #define MME_CONFIG_STRING_MME_S10_HANDOVER_COMPLETION_TIMER  "MME_S10_HANDOVER_COMPLETION_TIMER"
 
@@ -68,11 +70,33 @@
 
 #define MME_CONFIG_STRING_INTERTASK_INTERFACE_CONFIG     "INTERTASK_INTERFACE"
 #define MME_CONFIG_STRING_INTERTASK_INTERFACE_QUEUE_SIZE "ITTI_QUEUE_SIZE"
+#define MME_CONFIG_STRING_ITTI_TRACE_FILE                "TRACE_FILE"
+#define MME_CONFIG_STRING_ITTI_TRACE_FILE_SIZE           "TRACE_FILE_SIZE"
+#define MME_CONFIG_STRING_ITTI_TRACE_TASKS               "TRACE_TASKS"
+#define MME_CONFIG_STRING_ITTI_TRACE_MESSAGES            "TRACE_MESSAGES"
+#define MME_CONFIG_MAX_ITTI_TRACE_FILTERS                64
+#define MME_CONFIG_MAX_OVERLOAD_LEVELS                   8
+#define MME_CONFIG_STRING_ITTI_LATENCY_FILE              "LATENCY_FILE"
+#define MME_CONFIG_STRING_ITTI_THREAD_PLACEMENT          "THREAD_PLACEMENT"
+#define MME_CONFIG_STRING_ITTI_PLACEMENT_TASK            "TASK"
+#define MME_CONFIG_STRING_ITTI_PLACEMENT_CPUS            "CPUS"
+#define MME_CONFIG_STRING_ITTI_PLACEMENT_NUMA_NODE       "NUMA_NODE"
+#define MME_CONFIG_STRING_ITTI_PLACEMENT_WAIT_MODE       "WAIT_MODE"
+#define MME_CONFIG_STRING_ITTI_PLACEMENT_SPIN_US         "SPIN_US"
+#define MME_CONFIG_MAX_ITTI_THREAD_PLACEMENTS            32
 
 #define MME_CONFIG_STRING_S6A_CONFIG                     "S6A"
 #define MME_CONFIG_STRING_S6A_CONF_FILE_PATH             "S6A_CONF"
 #define MME_CONFIG_STRING_S6A_HSS_HOSTNAME               "HSS_HOSTNAME"
 #define MME_CONFIG_STRING_S6A_MME_HOSTNAME               "MME_HOSTNAME"
+#define MME_CONFIG_STRING_S6A_AUTH_VECTOR_CACHE          "AUTH_VECTOR_CACHE"
+#define MME_CONFIG_STRING_AUTH_VECTOR_CACHE_SIZE         "CACHE_SIZE"
+#define MME_CONFIG_STRING_AUTH_VECTOR_CACHE_VECTORS      "VECTORS_PER_REQUEST"
+#define MME_CONFIG_STRING_AUTH_VECTOR_CACHE_MAX_AGE      "MAX_AGE"
+#define MME_CONFIG_STRING_AUTH_VECTOR_CACHE_PREFETCH     "PREFETCH"
+#define MME_CONFIG_STRING_S6A_MAX_IN_FLIGHT              "MAX_IN_FLIGHT"
+#define MME_CONFIG_STRING_S6A_BACKLOG                    "BACKLOG"
+#define MME_CONFIG_STRING_S6A_REQUEST_TIMEOUT            "REQUEST_TIMEOUT"
 
 #define MME_CONFIG_STRING_SCTP_CONFIG                    "SCTP"
 #define MME_CONFIG_STRING_SCTP_INSTREAMS                 "SCTP_INSTREAMS"
@@ -82,6 +106,19 @@
 #define MME_CONFIG_STRING_S1AP_CONFIG                    "S1AP"
 #define MME_CONFIG_STRING_S1AP_OUTCOME_TIMER             "S1AP_OUTCOME_TIMER"
 #define MME_CONFIG_STRING_S1AP_PORT                      "S1AP_PORT"
+#define MME_CONFIG_STRING_S1AP_ADMISSION_QUEUE_HIGH      "ADMISSION_QUEUE_HIGH_THRESHOLD"
+#define MME_CONFIG_STRING_S1AP_ADMISSION_QUEUE_LOW       "ADMISSION_QUEUE_LOW_THRESHOLD"
+#define MME_CONFIG_STRING_S1AP_OVERLOAD                  "OVERLOAD"
+#define MME_CONFIG_STRING_OVERLOAD_PERIOD_MS             "PERIOD_MS"
+#define MME_CONFIG_STRING_OVERLOAD_QUEUE_THRESHOLD       "QUEUE_THRESHOLD"
+#define MME_CONFIG_STRING_OVERLOAD_S6A_THRESHOLD         "S6A_THRESHOLD"
+#define MME_CONFIG_STRING_OVERLOAD_S11_THRESHOLD         "S11_THRESHOLD"
+#define MME_CONFIG_STRING_OVERLOAD_CPU_THRESHOLD         "CPU_THRESHOLD"
+#define MME_CONFIG_STRING_OVERLOAD_STOP_HYSTERESIS       "STOP_HYSTERESIS"
+#define MME_CONFIG_STRING_OVERLOAD_LEVELS                "LEVELS"
+#define MME_CONFIG_STRING_OVERLOAD_LOAD                  "LOAD"
+#define MME_CONFIG_STRING_OVERLOAD_ACTION                "ACTION"
+#define MME_CONFIG_STRING_OVERLOAD_TRAFFIC_LOAD_REDUCTION "TRAFFIC_LOAD_REDUCTION"
 
 #define MME_CONFIG_STRING_GUMMEI_LIST                    "GUMMEI_LIST"
 #define MME_CONFIG_STRING_MME_CODE                       "MME_CODE"
@@ -137,6 +174,8 @@
 //#define MME_CONFIG_STRING_MME_LIST_SELECTION             "MME_LIST_SELECTION"
 
 #define MME_CONFIG_STRING_ID                             "ID"
+#define MME_CONFIG_STRING_WEIGHT                         "WEIGHT"
+#define MME_CONFIG_STRING_WRR_LOAD_FEEDBACK              "WRR_LOAD_FEEDBACK"
 
 typedef enum {
    RUN_MODE_BASIC,
@@ -149,6 +188,16 @@ typedef enum {
 //  RUN_MODE_OTHER
 //} run_mode_t;
 
+/* Values of OverloadAction, 3GPP TS 36.413 */
+typedef enum {
+   OVERLOAD_ACTION_REJECT_NON_EMERGENCY_MO_DT = 0,
+   OVERLOAD_ACTION_REJECT_RRC_CR_SIGNALLING,
+   OVERLOAD_ACTION_PERMIT_EMERGENCY_SESSIONS_AND_MOBILE_TERMINATED_SERVICES_ONLY,
+   OVERLOAD_ACTION_PERMIT_HIGH_PRIORITY_SESSIONS_AND_MOBILE_TERMINATED_SERVICES_ONLY,
+   OVERLOAD_ACTION_REJECT_DELAY_TOLERANT_ACCESS,
+   OVERLOAD_ACTION_MAX
+} overload_action_t;
+
 typedef struct mme_config_s {
   /* Reader/writer lock for this configuration */
   pthread_rwlock_t rw_lock;
@@ -166,6 +215,11 @@ typedef struct mme_config_s {
   uint8_t relative_capacity;
 
   uint32_t mme_statistic_timer;
+
+  struct {
+    bstring  file;          ///< UE context snapshot log restored at startup (hot restart), disabled if NULL
+    uint32_t period_sec;    ///< periodic checkpoint of the connected UEs, flush and compaction check
+  } snapshot_config;
   uint32_t mme_mobility_completion_timer;
   uint32_t mme_s10_handover_completion_timer;
 
@@ -205,6 +259,22 @@ typedef struct mme_config_s {
   struct {
     uint16_t port_number;
     uint8_t  outcome_drop_timer_sec;
+    uint32_t admission_queue_high;  ///< new INITIAL UE MESSAGEs are dropped when MME_APP or NAS EMM queue depth reaches it, 0 disables
+    uint32_t admission_queue_low;   ///< and admitted again when it falls back to this value
+    struct {
+      uint32_t period_ms;           ///< load sampling period
+      uint32_t queue_threshold;     ///< ITTI queue depth of MME_APP, NAS, S6A or S11 tasks counted as 100% load, 0 ignores it
+      uint32_t s6a_threshold;       ///< outstanding S6a requests counted as 100% load, 0 ignores it
+      uint32_t s11_threshold;       ///< outstanding S11 requests counted as 100% load, 0 ignores it
+      uint32_t cpu_threshold;       ///< process CPU usage (% of all cores) counted as 100% load, 0 ignores it
+      uint32_t stop_hysteresis;     ///< a level is left when the load falls this many points below its LOAD
+      int      nb_levels;           ///< overload control disabled if 0
+      struct {
+        uint32_t          load;     ///< load (%) entering this level, levels are sorted by increasing load
+        overload_action_t action;
+        uint8_t           traffic_load_reduction; ///< % of traffic the eNBs should shed, 0 means not signalled
+      } level[MME_CONFIG_MAX_OVERLOAD_LEVELS];
+    } overload;
   } s1ap_config;
 
   struct {
@@ -231,11 +301,35 @@ typedef struct mme_config_s {
     bstring conf_file;
     bstring hss_host_name;
     bstring mme_host_name;
+    struct {
+      uint32_t size;               ///< IMSIs whose unused vectors are kept, 0 disables the cache
+      uint32_t nb_vectors;         ///< vectors requested per AIR when the cache is enabled
+      uint32_t max_age_sec;        ///< cached vectors older than this are dropped
+      bool     prefetch;           ///< fetch vectors of implicitly detached UEs in advance
+    } auth_vector_cache;
+    uint32_t max_in_flight;        ///< AIR and ULR sent to the HSS and not answered yet
+    uint32_t backlog;              ///< requests waiting for room in the in-flight window, further ones are rejected
+    uint32_t request_timeout_ms;   ///< an unanswered request fails after this delay
   } s6a_config;
 
   struct {
     uint32_t  queue_size;
     bstring   log_file;
+    bstring   trace_file;                ///< memory mapped binary trace of messages, disabled if NULL
+    uint32_t  trace_file_size;           ///< size of the trace ring in MBytes
+    int       nb_trace_tasks;
+    bstring   trace_tasks[MME_CONFIG_MAX_ITTI_TRACE_FILTERS];
+    int       nb_trace_messages;
+    bstring   trace_messages[MME_CONFIG_MAX_ITTI_TRACE_FILTERS];
+    bstring   latency_file;              ///< procedure latency histograms, rewritten every MME_STATISTIC_TIMER, disabled if NULL
+    int       nb_thread_placements;
+    struct {
+      bstring   task;
+      bstring   cpus;                    ///< CPU list, ex: "2-3,8", NULL if the affinity is not set
+      int       numa_node;               ///< node of the task queue, -1 if not set
+      int       wait_mode;               ///< itti_wait_mode_t
+      uint32_t  spin_us;
+    } thread_placement[MME_CONFIG_MAX_ITTI_THREAD_PLACEMENTS];
   } itti_config;
 
   struct {
@@ -267,6 +361,9 @@ typedef struct mme_config_s {
     bstring        service_id[MME_CONFIG_MAX_SERVICE];
     interface_type_t interface_type[MME_CONFIG_MAX_SERVICE];
     struct in_addr service_ip_addr[MME_CONFIG_MAX_SERVICE];
+    uint16_t       weight[MME_CONFIG_MAX_SERVICE];
+    /** Lower the selection weight of peers with outstanding transactions. */
+    bool           load_feedback;
     /** MME entries. */
 
   } e_dns_emulation;
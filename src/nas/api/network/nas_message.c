@@ -70,6 +70,8 @@
 /****************************************************************************/
 
 #define SR_MAC_SIZE_BYTES 2
+/* Number of candidate uplink NAS COUNT tried for a SERVICE REQUEST (tolerates lost SERVICE REQUESTs) */
+#define SR_UL_COUNT_WINDOW 4
 
 /* Functions used to decode layer 3 NAS messages */
 
@@ -133,6 +135,12 @@ static uint32_t _nas_message_get_mac (
     int const direction,
     emm_security_context_t * const emm_security_context);
 
+static bool _nas_message_service_request_check_mac (
+    const unsigned char *const buffer,
+    const uint8_t sequence_number,
+    const uint16_t short_mac,
+    emm_security_context_t * const emm_security_context);
+
 /****************************************************************************/
 /******************  E X P O R T E D    F U N C T I O N S  ******************/
 /****************************************************************************/
@@ -396,7 +404,6 @@ int nas_message_decode (
   int                                     size  = 0;
   bool                                    is_sr = false;
   uint8_t                                 sequence_number = 0;
-  uint8_t                                 temp_sequence_number = 0;
   /*
    * Decode the header
    */
@@ -448,38 +455,12 @@ int nas_message_decode (
     }
 
     /*
-     * Compute offset of the sequence number field
+     * Check NAS message integrity, the uplink count is only updated if the MAC matches
      */
     // remove ksi
     sequence_number = sequence_number & 0x1F;
-    // Estimate 8bit sequence number from 5 bit sequence number 
-    temp_sequence_number = (emm_security_context->ul_count.seq_num & 0xE0) >> 5;
-    if ((emm_security_context->ul_count.seq_num & 0x1F) > sequence_number) {
-        temp_sequence_number+=1;  
-    }
-    sequence_number = ((temp_sequence_number & 0x07) << 5) | (sequence_number & 0x1F);
-
-    if (emm_security_context->ul_count.seq_num > sequence_number) {
-        emm_security_context->ul_count.overflow += 1;
-    }
-    emm_security_context->ul_count.seq_num = sequence_number;
-      
-    /*
-     * Compute the NAS message authentication code, return 0 if no security context
-     */
-    mac = _nas_message_get_mac (buffer,SR_MAC_SIZE_BYTES,SECU_DIRECTION_UPLINK,emm_security_context);
-      
-    /*
-     * Check NAS message integrity
-     */
-    
-    // Compare last 2 LSB bytes for SR
-    short_mac = mac & 0x0000FFFF;
-    if (short_mac == msg->plain.emm.service_request.messageauthenticationcode) {
+    if (_nas_message_service_request_check_mac (buffer, sequence_number, msg->plain.emm.service_request.messageauthenticationcode, emm_security_context)) {
       status->mac_matched = 1;
-      OAILOG_DEBUG (LOG_NAS, "Service Request: message MAC = %04X == computed = %04X\n", msg->plain.emm.service_request.messageauthenticationcode, short_mac);
-    } else {
-      OAILOG_DEBUG (LOG_NAS, "Service Request: message MAC = %04X != computed = %04X\n", msg->plain.emm.service_request.messageauthenticationcode, short_mac);
     }
     
     OAILOG_FUNC_RETURN (LOG_NAS, size + bytes);
@@ -1314,6 +1295,90 @@ static int _nas_message_encrypt (
    -----------------------------------------------------------------------------
 */
 
+/****************************************************************************
+ **                                                                        **
+ ** Name:  _nas_message_service_request_check_mac()                        **
+ **                                                                        **
+ ** Description: Check the short MAC of a SERVICE REQUEST message against  **
+ **    the window of uplink NAS COUNT values having the 5 LSB    **
+ **    received in the message. EIA2 MACs of the whole window    **
+ **    are computed in one pass with the cached key schedule.    **
+ **    The uplink count is only updated if a MAC matches, a      **
+ **    SERVICE REQUEST replayed with an already verified count   **
+ **    is rejected.                                              **
+ **                                                                        **
+ ** Inputs   buffer:  Pointer to the SERVICE REQUEST message            **
+ **    sequence_number: 5 LSB of the uplink NAS COUNT           **
+ **    short_mac: Received short MAC                            **
+ **    Others:  None                                                   **
+ **                                                                        **
+ ** Outputs:   None                                                      **
+ **      Return:  true if the short MAC matches                      **
+ **    Others:  emm_security_context->ul_count                      **
+ **                                                                        **
+ ***************************************************************************/
+static bool _nas_message_service_request_check_mac (
+    const unsigned char *const buffer,
+    const uint8_t sequence_number,
+    const uint16_t short_mac,
+    emm_security_context_t * const emm_security_context)
+{
+  OAILOG_FUNC_IN (LOG_NAS);
+  uint32_t                                candidates[SR_UL_COUNT_WINDOW];
+  const uint32_t                          ul_count = ((emm_security_context->ul_count.overflow & 0x0000FFFF) << 8) | (emm_security_context->ul_count.seq_num & 0x000000FF);
+  const bool                              replay_protection = (emm_security_context->sr_replay.valid) &&
+                                              (!memcmp (emm_security_context->sr_replay.knas_int, emm_security_context->knas_int, AUTH_KNAS_INT_SIZE));
+  int                                     num_candidates = 0;
+  int                                     matched = -1;
+
+  num_candidates = nas_ul_count_window (ul_count, sequence_number, replay_protection, emm_security_context->sr_replay.last_count,
+      candidates, SR_UL_COUNT_WINDOW);
+
+  if (NAS_SECURITY_ALGORITHMS_EIA2 == emm_security_context->selected_algorithms.integrity) {
+    nas_eia2_lane_t                       lanes[SR_UL_COUNT_WINDOW];
+
+    nas_stream_eia2_key_schedule (&emm_security_context->eia2_key_schedule, emm_security_context->knas_int);
+    for (int i = 0; i < num_candidates; i++) {
+      lanes[i].schedule  = &emm_security_context->eia2_key_schedule;
+      lanes[i].count     = candidates[i];
+      lanes[i].bearer    = 0x00;      //33.401 section 8.1.1
+      lanes[i].direction = SECU_DIRECTION_UPLINK;
+      lanes[i].message   = buffer;
+      lanes[i].length    = SR_MAC_SIZE_BYTES;
+    }
+    nas_stream_eia2_batch (lanes, num_candidates);
+    for (int i = 0; (i < num_candidates) && (0 > matched); i++) {
+      if ((lanes[i].mac & 0x0000FFFF) == short_mac) {
+        matched = i;
+      }
+    }
+  } else {
+    const count_t                         saved_ul_count = emm_security_context->ul_count;
+
+    for (int i = 0; (i < num_candidates) && (0 > matched); i++) {
+      emm_security_context->ul_count.overflow = (candidates[i] >> 8) & 0x0000FFFF;
+      emm_security_context->ul_count.seq_num  = candidates[i] & 0x000000FF;
+      if ((_nas_message_get_mac (buffer, SR_MAC_SIZE_BYTES, SECU_DIRECTION_UPLINK, emm_security_context) & 0x0000FFFF) == short_mac) {
+        matched = i;
+      }
+    }
+    emm_security_context->ul_count = saved_ul_count;
+  }
+
+  if (0 > matched) {
+    OAILOG_DEBUG (LOG_NAS, "Service Request: message MAC = %04X does not match for %d uplink count candidates from %06X (ul_count %06X)\n",
+        short_mac, num_candidates, (num_candidates) ? candidates[0] : 0, ul_count);
+    OAILOG_FUNC_RETURN (LOG_NAS, false);
+  }
+  OAILOG_DEBUG (LOG_NAS, "Service Request: message MAC = %04X matches for uplink count %06X (ul_count %06X)\n", short_mac, candidates[matched], ul_count);
+  emm_security_context->ul_count.overflow = (candidates[matched] >> 8) & 0x0000FFFF;
+  emm_security_context->ul_count.seq_num  = candidates[matched] & 0x000000FF;
+  memcpy (emm_security_context->sr_replay.knas_int, emm_security_context->knas_int, AUTH_KNAS_INT_SIZE);
+  emm_security_context->sr_replay.last_count = candidates[matched];
+  emm_security_context->sr_replay.valid      = true;
+  OAILOG_FUNC_RETURN (LOG_NAS, true);
+}
+
 /****************************************************************************
  **                                                                        **
  ** Name:  _nas_message_get_mac()                                        **
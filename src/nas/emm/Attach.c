@@ -1474,9 +1474,8 @@ int _emm_wrapper_attach_accept (mme_ue_s1ap_id_t ue_id, bstring esm_msg)
     OAILOG_FUNC_RETURN(LOG_NAS_ESM, RETURNerror);
   }
   // todo: lock_emm_context
-  if(attach_proc->esm_msg_out)
-    bdestroy_wrapper(&attach_proc->esm_msg_out);
-  attach_proc->esm_msg_out = bstrcpy(esm_msg);
+  // a previous copy is left in the procedure arena until the procedure ends
+  attach_proc->esm_msg_out = mem_arena_bstrcpy(attach_proc->emm_spec_proc.emm_proc.base_proc.arena, esm_msg);
 
   DevAssert(!attach_proc->ies->esm_msg_attach_proc);
 
@@ -675,10 +675,9 @@ int emm_proc_authentication_failure (
           emm_sap.u.emm_reg.u.common.previous_emm_fsm_state = auth_proc->emm_com_proc.emm_proc.previous_emm_fsm_state;
           rc = emm_sap_send (&emm_sap);
         }
-        if (auth_proc->unchecked_imsi) {
-          free_wrapper((void**)&auth_proc->unchecked_imsi);
+        if (!auth_proc->unchecked_imsi) {
+          auth_proc->unchecked_imsi = mem_arena_alloc(auth_proc->emm_com_proc.emm_proc.base_proc.arena, sizeof(*auth_proc->unchecked_imsi));
         }
-        auth_proc->unchecked_imsi = calloc(1, sizeof(*auth_proc->unchecked_imsi));
         memcpy(auth_proc->unchecked_imsi, &emm_ctx->_imsi, sizeof(*auth_proc->unchecked_imsi));
         rc = emm_proc_identification (emm_ctx, &auth_proc->emm_com_proc.emm_proc, IDENTITY_TYPE_2_IMSI, _authentication_check_imsi_5_4_2_5__1, _authentication_check_imsi_5_4_2_5__1_fail);
       }
@@ -71,6 +71,7 @@
 #include "mme_app_ue_context.h"
 #include "nas_itti_messaging.h" 
 #include "mme_app_defs.h"
+#include "mme_config.h"
 
 static void _emm_proc_create_procedure_detach_request(emm_data_context_t * const emm_context, emm_detach_request_ies_t * const ies);
 
@@ -225,6 +226,15 @@ emm_proc_detach (
     OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
   }
 
+  /*
+   * The UE is likely to re-attach (mobile reachable timer expiry, ...): let the S6A vector cache fetch its
+   * authentication vectors in advance. Not when the HSS cancelled the location, the UE is registered elsewhere.
+   */
+  if ((!clr) && (mme_config.s6a_config.auth_vector_cache.prefetch) && (IS_EMM_CTXT_VALID_IMSI(emm_context))) {
+    plmn_t visited_plmn = emm_context->originating_tai.plmn;
+    nas_itti_auth_info_prefetch_req (&emm_context->_imsi, &visited_plmn);
+  }
+
   /**
     * Although MME_APP and EMM contexts are separated, doing it like this causes the recursion problem.
     *
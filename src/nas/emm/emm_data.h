@@ -47,6 +47,7 @@ Description Defines internal private data handled by EPS Mobility
 #include "3gpp_24.301.h"
 #include "3gpp_24.008.h"
 #include "securityDef.h"
+#include "secu_defs.h"
 
 #include "nas_emm_procedures.h"
 #include "emm_fsm.h"
@@ -109,6 +110,14 @@ typedef struct emm_security_context_s {
   uint8_t   activated;
   uint8_t   direction_encode; // SECU_DIRECTION_DOWNLINK, SECU_DIRECTION_UPLINK
   uint8_t   direction_decode; // SECU_DIRECTION_DOWNLINK, SECU_DIRECTION_UPLINK
+
+  /* SERVICE REQUEST integrity check fast path */
+  nas_eia2_key_schedule_t eia2_key_schedule; /* expanded knas_int, rebuilt when knas_int changes */
+  struct {
+    uint8_t   knas_int[AUTH_KNAS_INT_SIZE];  /* integrity key last_count belongs to */
+    bool      valid;
+    uint32_t  last_count;                    /* uplink NAS COUNT of the last verified SERVICE REQUEST */
+  } sr_replay;
 } emm_security_context_t;
 
 
@@ -68,6 +68,8 @@
 static  nas_emm_common_proc_t *get_nas_common_procedure(const struct emm_data_context_s * const ctxt, emm_common_proc_type_t proc_type);
 static  nas_emm_cn_proc_t *get_nas_cn_procedure(const struct emm_data_context_s * const ctxt, cn_proc_type_t proc_type);
 
+static void *nas_emm_procedure_alloc(const size_t proc_size, const size_t wrapper_size, void ** const wrapper);
+static void nas_emm_procedure_free(nas_emm_base_proc_t * const base_proc);
 static void nas_emm_procedure_gc(struct emm_data_context_s * const emm_context);
 static void nas_delete_con_mngt_procedure(nas_emm_con_mngt_proc_t **  proc);
 static void nas_delete_auth_info_procedure(struct emm_data_context_s *emm_context, nas_auth_info_proc_t ** auth_info_proc);
@@ -307,6 +309,38 @@ int nas_unlink_emm_procedures(nas_emm_base_proc_t * const parent_proc, nas_emm_b
   return RETURNerror;
 }
 
+//-----------------------------------------------------------------------------
+// A procedure is the first allocation of its own arena, followed by its list wrapper if any.
+static void *nas_emm_procedure_alloc(const size_t proc_size, const size_t wrapper_size, void ** const wrapper)
+{
+  mem_arena_t         *arena = mem_arena_create();
+  nas_emm_base_proc_t *base_proc = NULL;
+
+  if (arena) {
+    base_proc = mem_arena_alloc(arena, proc_size);
+    if ((base_proc) && (wrapper_size)) {
+      *wrapper = mem_arena_alloc(arena, wrapper_size);
+      if (!(*wrapper)) {
+        base_proc = NULL;
+      }
+    }
+    if (base_proc) {
+      base_proc->arena = arena;
+    } else {
+      mem_arena_destroy(&arena);
+    }
+  }
+  return base_proc;
+}
+
+//-----------------------------------------------------------------------------
+// Release the procedure, its list wrapper and everything allocated in its arena.
+static void nas_emm_procedure_free(nas_emm_base_proc_t * const base_proc)
+{
+  mem_arena_t *arena = base_proc->arena;
+  mem_arena_destroy(&arena);
+}
+
 //-----------------------------------------------------------------------------
 static void nas_emm_procedure_gc(struct emm_data_context_s * const emm_context)
 {
@@ -347,7 +381,9 @@ static void nas_delete_con_mngt_procedure(nas_emm_con_mngt_proc_t **  proc)
 {
   if (*proc) {
     AssertFatal(0, "TODO");
-    free_wrapper((void**)proc);
+    nas_emm_con_mngt_proc_t *con_mngt_proc = *proc;
+    *proc = NULL;
+    nas_emm_procedure_free(&con_mngt_proc->emm_proc.base_proc);
   }
 }
 //-----------------------------------------------------------------------------
@@ -362,9 +398,6 @@ void nas_delete_common_procedure(struct emm_data_context_s *emm_context, nas_emm
       case EMM_COMM_PROC_AUTH: {
           nas_emm_auth_proc_t *auth_info_proc = (nas_emm_auth_proc_t *)(*proc);
           OAILOG_TRACE (LOG_NAS_EMM, "UE " MME_UE_S1AP_ID_FMT " Delete AUTH procedure\n", auth_info_proc->ue_id);
-          if (auth_info_proc->unchecked_imsi) {
-            free_wrapper((void**)&auth_info_proc->unchecked_imsi);
-          }
         }
         break;
       case EMM_COMM_PROC_SMC: {
@@ -391,10 +424,11 @@ void nas_delete_common_procedure(struct emm_data_context_s *emm_context, nas_emm
       while (p1) {
         p2 = LIST_NEXT(p1, entries);
         if (p1->proc == (nas_emm_common_proc_t*)(*proc)) {
-          LIST_REMOVE(p1, entries);
-          free_wrapper((void**)&p1->proc);
-          free_wrapper((void**)&p1);
+          // proc may point into the wrapper, which lives in the procedure arena
+          nas_emm_common_proc_t *common_proc = *proc;
           *proc = NULL;
+          LIST_REMOVE(p1, entries);
+          nas_emm_procedure_free(&common_proc->emm_proc.base_proc);
           return;
         }
         p1 = p2;
@@ -403,7 +437,9 @@ void nas_delete_common_procedure(struct emm_data_context_s *emm_context, nas_emm
     }
     // if not found in list, free it anyway
     if (*proc) {
-      free_wrapper((void**)proc);
+      nas_emm_common_proc_t *common_proc = *proc;
+      *proc = NULL;
+      nas_emm_procedure_free(&common_proc->emm_proc.base_proc);
     }
   }
 }
@@ -427,9 +463,6 @@ static void nas_delete_common_procedures(struct emm_data_context_s *emm_context)
         case EMM_COMM_PROC_AUTH: {
             nas_emm_auth_proc_t *auth_info_proc = (nas_emm_auth_proc_t *)p1->proc;
             OAILOG_DEBUG (LOG_NAS_EMM, "UE " MME_UE_S1AP_ID_FMT " Delete AUTH procedure & timer\n", auth_info_proc->ue_id);
-            if (auth_info_proc->unchecked_imsi) {
-              free_wrapper((void**)&auth_info_proc->unchecked_imsi);
-            }
             void * timer_callback_args = NULL;
             nas_stop_T3460(auth_info_proc->ue_id, &auth_info_proc->T3460, timer_callback_args);
 
@@ -459,8 +492,7 @@ static void nas_delete_common_procedures(struct emm_data_context_s *emm_context)
         default: ;
       }
 
-      free_wrapper((void**)&p1->proc);
-      free_wrapper((void**)&p1);
+      nas_emm_procedure_free(&p1->proc->emm_proc.base_proc);
 
       p1 = p2;
     }
@@ -485,9 +517,6 @@ void nas_delete_attach_procedure(struct emm_data_context_s *emm_context)
     if (proc->ies) {
       free_emm_attach_request_ies(&proc->ies);
     }
-    if (proc->esm_msg_out) {
-      bdestroy_wrapper(&proc->esm_msg_out);
-    }
 
     if(ue_ref){
       OAILOG_DEBUG(LOG_NAS_EMM, "EMM-PROC (NASx)  -  * * * * * (2) ueREF %p has mmeId " MME_UE_S1AP_ID_FMT ", enbId " ENB_UE_S1AP_ID_FMT " state %d and eNB_ref %p (timer arg %p). \n",
@@ -500,7 +529,8 @@ void nas_delete_attach_procedure(struct emm_data_context_s *emm_context)
                 ue_ref, ue_ref->mme_ue_s1ap_id, ue_ref->enb_ue_s1ap_id, ue_ref->s1_ue_state, ue_ref->enb, unused);
     }
     nas_delete_child_procedures(emm_context, (nas_emm_base_proc_t *)proc);
-    free_wrapper((void**)&emm_context->emm_procedures->emm_specific_proc);
+    emm_context->emm_procedures->emm_specific_proc = NULL;
+    nas_emm_procedure_free(&proc->emm_spec_proc.emm_proc.base_proc);
     nas_emm_procedure_gc(emm_context);
   }
 }
@@ -526,7 +556,8 @@ void nas_delete_tau_procedure(struct emm_data_context_s *emm_context)
 
     nas_delete_child_procedures(emm_context, (nas_emm_base_proc_t *)proc);
 
-    free_wrapper((void**)&emm_context->emm_procedures->emm_specific_proc);
+    emm_context->emm_procedures->emm_specific_proc = NULL;
+    nas_emm_procedure_free(&proc->emm_spec_proc.emm_proc.base_proc);
     nas_emm_procedure_gc(emm_context);
   }
 }
@@ -544,7 +575,8 @@ void nas_delete_detach_procedure(struct emm_data_context_s *emm_context)
 
     nas_delete_child_procedures(emm_context, (nas_emm_base_proc_t *)proc);
 
-    free_wrapper((void**)&emm_context->emm_procedures->emm_specific_proc);
+    emm_context->emm_procedures->emm_specific_proc = NULL;
+    nas_emm_procedure_free(&proc->emm_spec_proc.emm_proc.base_proc);
     nas_emm_procedure_gc(emm_context);
   }
 }
@@ -559,7 +591,8 @@ static void nas_delete_auth_info_procedure(struct emm_data_context_s *emm_contex
     }
     void *unused = NULL;
     nas_stop_Ts6a_auth_info(emm_context->ue_id, &(*auth_info_proc)->timer_s6a, unused);
-    free_wrapper((void**)auth_info_proc);
+    nas_emm_procedure_free(&(*auth_info_proc)->cn_proc.base_proc);
+    *auth_info_proc = NULL;
   }
 }
 
@@ -584,7 +617,8 @@ static void nas_delete_context_req_procedure(struct emm_data_context_s *emm_cont
 
    nas_stop_Ts10_ctx_res(emm_context->ue_id, &(*ctx_req_proc)->timer_s10, unused);
 
-   free_wrapper((void**)ctx_req_proc);
+   nas_emm_procedure_free(&(*ctx_req_proc)->cn_proc.base_proc);
+   *ctx_req_proc = NULL;
   }
 }
 
@@ -598,6 +632,9 @@ void nas_delete_cn_procedure(struct emm_data_context_s *emm_context, nas_emm_cn_
     while (p1) {
       p2 = LIST_NEXT(p1, entries);
       if (p1->proc == cn_proc) {
+        OAILOG_TRACE (LOG_NAS_EMM, "UE " MME_UE_S1AP_ID_FMT " Delete CN procedure %p\n", emm_context->ue_id, p1->proc);
+        // the wrapper lives in the procedure arena
+        LIST_REMOVE(p1, entries);
         switch (cn_proc->type) {
           case CN_PROC_AUTH_INFO:
             nas_delete_auth_info_procedure(emm_context, (nas_auth_info_proc_t**)&cn_proc);
@@ -606,13 +643,10 @@ void nas_delete_cn_procedure(struct emm_data_context_s *emm_context, nas_emm_cn_
             nas_delete_context_req_procedure(emm_context, (nas_ctx_req_proc_t**)&cn_proc);
             break;
           case CN_PROC_NONE:
-            free_wrapper((void**)&cn_proc);
+            nas_emm_procedure_free(&cn_proc->base_proc);
             break;
           default:;
         }
-        OAILOG_TRACE (LOG_NAS_EMM, "UE " MME_UE_S1AP_ID_FMT " Delete CN procedure %p\n", emm_context->ue_id, p1->proc);
-        LIST_REMOVE(p1, entries);
-        free_wrapper((void**)&p1);
         return;
       }
       p1 = p2;
@@ -629,18 +663,19 @@ static void nas_delete_cn_procedures(struct emm_data_context_s *emm_context)
     nas_cn_procedure_t *p2 = NULL;
     while (p1) {
       p2 = LIST_NEXT(p1, entries);
-      switch (p1->proc->type) {
+      // the wrapper lives in the procedure arena
+      nas_emm_cn_proc_t *cn_proc = p1->proc;
+      LIST_REMOVE(p1, entries);
+      switch (cn_proc->type) {
         case CN_PROC_AUTH_INFO:
-          nas_delete_auth_info_procedure(emm_context, (nas_auth_info_proc_t**)&p1->proc);
+          nas_delete_auth_info_procedure(emm_context, (nas_auth_info_proc_t**)&cn_proc);
           break;
         case CN_PROC_CTX_REQ:
-          nas_delete_context_req_procedure(emm_context, (nas_ctx_req_proc_t**)&p1->proc);
+          nas_delete_context_req_procedure(emm_context, (nas_ctx_req_proc_t**)&cn_proc);
           break;
         default:
-          free_wrapper((void**)&p1->proc);
+          nas_emm_procedure_free(&cn_proc->base_proc);
       }
-      LIST_REMOVE(p1, entries);
-      free_wrapper((void**)&p1);
       p1 = p2;
     }
     nas_emm_procedure_gc(emm_context);
@@ -684,7 +719,7 @@ nas_emm_attach_proc_t* nas_new_attach_procedure(struct emm_data_context_s * cons
         "UE " MME_UE_S1AP_ID_FMT " Attach procedure creation requested but another specific procedure found\n", emm_context->ue_id);
     return NULL;
   }
-  emm_context->emm_procedures->emm_specific_proc = calloc(1, sizeof(nas_emm_attach_proc_t));
+  emm_context->emm_procedures->emm_specific_proc = nas_emm_procedure_alloc(sizeof(nas_emm_attach_proc_t), 0, NULL);
   emm_context->emm_procedures->emm_specific_proc->emm_proc.base_proc.nas_puid = __sync_fetch_and_add (&nas_puid, 1);
   emm_context->emm_procedures->emm_specific_proc->emm_proc.type  = NAS_EMM_PROC_TYPE_SPECIFIC;
   /** Timer. */
@@ -715,7 +750,7 @@ nas_emm_tau_proc_t *nas_new_tau_procedure(struct emm_data_context_s * const emm_
         "UE " MME_UE_S1AP_ID_FMT " TAU procedure creation requested but another specific procedure found\n", emm_context->ue_id);
     return NULL;
   }
-  emm_context->emm_procedures->emm_specific_proc = calloc(1, sizeof(nas_emm_tau_proc_t));
+  emm_context->emm_procedures->emm_specific_proc = nas_emm_procedure_alloc(sizeof(nas_emm_tau_proc_t), 0, NULL);
   emm_context->emm_procedures->emm_specific_proc->emm_proc.base_proc.nas_puid = __sync_fetch_and_add (&nas_puid, 1);
   emm_context->emm_procedures->emm_specific_proc->emm_proc.type  = NAS_EMM_PROC_TYPE_SPECIFIC;
   /** Timer. */
@@ -743,7 +778,7 @@ nas_emm_detach_proc_t *nas_new_detach_procedure(struct emm_data_context_s * cons
         "UE " MME_UE_S1AP_ID_FMT " Detach procedure creation requested but another specific procedure found\n", emm_context->ue_id);
     return NULL;
   }
-  emm_context->emm_procedures->emm_specific_proc = calloc(1, sizeof(nas_emm_detach_proc_t));
+  emm_context->emm_procedures->emm_specific_proc = nas_emm_procedure_alloc(sizeof(nas_emm_detach_proc_t), 0, NULL);
   emm_context->emm_procedures->emm_specific_proc->emm_proc.base_proc.nas_puid = __sync_fetch_and_add (&nas_puid, 1);
   emm_context->emm_procedures->emm_specific_proc->emm_proc.type  = NAS_EMM_PROC_TYPE_SPECIFIC;
   emm_context->emm_procedures->emm_specific_proc->type  = EMM_SPEC_PROC_TYPE_DETACH;
@@ -765,7 +800,7 @@ nas_sr_proc_t* nas_new_service_request_procedure(struct emm_data_context_s * con
         "UE " MME_UE_S1AP_ID_FMT " SR procedure creation requested but another connection management procedure found\n", emm_context->ue_id);
     return NULL;
   }
-  emm_context->emm_procedures->emm_con_mngt_proc = calloc(1, sizeof(nas_sr_proc_t));
+  emm_context->emm_procedures->emm_con_mngt_proc = nas_emm_procedure_alloc(sizeof(nas_sr_proc_t), 0, NULL);
   emm_context->emm_procedures->emm_con_mngt_proc->emm_proc.base_proc.nas_puid = __sync_fetch_and_add (&nas_puid, 1);
   emm_context->emm_procedures->emm_con_mngt_proc->emm_proc.type  = NAS_EMM_PROC_TYPE_CONN_MNGT;
   emm_context->emm_procedures->emm_con_mngt_proc->type  = EMM_CON_MNGT_PROC_SERVICE_REQUEST;
@@ -782,7 +817,11 @@ nas_emm_ident_proc_t *nas_new_identification_procedure(struct emm_data_context_s
     emm_context->emm_procedures = _nas_new_emm_procedures(emm_context);
   }
 
-  nas_emm_ident_proc_t * ident_proc =  calloc(1, sizeof(nas_emm_ident_proc_t));
+  nas_emm_common_procedure_t * wrapper = NULL;
+  nas_emm_ident_proc_t * ident_proc =  nas_emm_procedure_alloc(sizeof(nas_emm_ident_proc_t), sizeof(*wrapper), (void**)&wrapper);
+  if (!ident_proc) {
+    return NULL;
+  }
 
   ident_proc->emm_com_proc.emm_proc.base_proc.nas_puid = __sync_fetch_and_add (&nas_puid, 1);
   ident_proc->emm_com_proc.emm_proc.type      = NAS_EMM_PROC_TYPE_COMMON;
@@ -791,15 +830,9 @@ nas_emm_ident_proc_t *nas_new_identification_procedure(struct emm_data_context_s
   ident_proc->T3470.sec       = mme_config.nas_config.t3470_sec;
   ident_proc->T3470.id        = NAS_TIMER_INACTIVE_ID;
 
-  nas_emm_common_procedure_t * wrapper = calloc(1, sizeof(*wrapper));
-  if (wrapper) {
-    wrapper->proc = &ident_proc->emm_com_proc;
-    LIST_INSERT_HEAD(&emm_context->emm_procedures->emm_common_procs, wrapper, entries);
-    OAILOG_TRACE (LOG_NAS_EMM, "New EMM_COMM_PROC_IDENT\n");
-    return ident_proc;
-  } else {
-    free_wrapper((void**)&ident_proc);
-  }
+  wrapper->proc = &ident_proc->emm_com_proc;
+  LIST_INSERT_HEAD(&emm_context->emm_procedures->emm_common_procs, wrapper, entries);
+  OAILOG_TRACE (LOG_NAS_EMM, "New EMM_COMM_PROC_IDENT\n");
   return ident_proc;
 }
 
@@ -810,7 +843,11 @@ nas_emm_auth_proc_t *nas_new_authentication_procedure(struct emm_data_context_s
     emm_context->emm_procedures = _nas_new_emm_procedures(emm_context);
   }
 
-  nas_emm_auth_proc_t * auth_proc =  calloc(1, sizeof(nas_emm_auth_proc_t));
+  nas_emm_common_procedure_t * wrapper = NULL;
+  nas_emm_auth_proc_t * auth_proc =  nas_emm_procedure_alloc(sizeof(nas_emm_auth_proc_t), sizeof(*wrapper), (void**)&wrapper);
+  if (!auth_proc) {
+    return NULL;
+  }
 
   auth_proc->emm_com_proc.emm_proc.base_proc.nas_puid = __sync_fetch_and_add (&nas_puid, 1);
   auth_proc->emm_com_proc.emm_proc.type      = NAS_EMM_PROC_TYPE_COMMON;
@@ -819,16 +856,10 @@ nas_emm_auth_proc_t *nas_new_authentication_procedure(struct emm_data_context_s
   auth_proc->T3460.sec       = mme_config.nas_config.t3460_sec;
   auth_proc->T3460.id        = NAS_TIMER_INACTIVE_ID;
 
-  nas_emm_common_procedure_t * wrapper = calloc(1, sizeof(*wrapper));
-  if (wrapper) {
-    wrapper->proc = &auth_proc->emm_com_proc;
-    LIST_INSERT_HEAD(&emm_context->emm_procedures->emm_common_procs, wrapper, entries);
-    OAILOG_TRACE (LOG_NAS_EMM, "New EMM_COMM_PROC_AUTH\n");
-    return auth_proc;
-  } else {
-    free_wrapper((void**)&auth_proc);
-  }
-  return NULL;
+  wrapper->proc = &auth_proc->emm_com_proc;
+  LIST_INSERT_HEAD(&emm_context->emm_procedures->emm_common_procs, wrapper, entries);
+  OAILOG_TRACE (LOG_NAS_EMM, "New EMM_COMM_PROC_AUTH\n");
+  return auth_proc;
 }
 
 //-----------------------------------------------------------------------------
@@ -838,7 +869,11 @@ nas_emm_smc_proc_t *nas_new_smc_procedure(struct emm_data_context_s * const emm_
     emm_context->emm_procedures = _nas_new_emm_procedures(emm_context);
   }
 
-  nas_emm_smc_proc_t * smc_proc =  calloc(1, sizeof(nas_emm_smc_proc_t));
+  nas_emm_common_procedure_t * wrapper = NULL;
+  nas_emm_smc_proc_t * smc_proc =  nas_emm_procedure_alloc(sizeof(nas_emm_smc_proc_t), sizeof(*wrapper), (void**)&wrapper);
+  if (!smc_proc) {
+    return NULL;
+  }
 
   smc_proc->emm_com_proc.emm_proc.base_proc.nas_puid = __sync_fetch_and_add (&nas_puid, 1);
   smc_proc->emm_com_proc.emm_proc.type      = NAS_EMM_PROC_TYPE_COMMON;
@@ -847,16 +882,10 @@ nas_emm_smc_proc_t *nas_new_smc_procedure(struct emm_data_context_s * const emm_
   smc_proc->T3460.sec       = mme_config.nas_config.t3460_sec;
   smc_proc->T3460.id        = NAS_TIMER_INACTIVE_ID;
 
-  nas_emm_common_procedure_t * wrapper = calloc(1, sizeof(*wrapper));
-  if (wrapper) {
-    wrapper->proc = &smc_proc->emm_com_proc;
-    LIST_INSERT_HEAD(&emm_context->emm_procedures->emm_common_procs, wrapper, entries);
-    OAILOG_TRACE (LOG_NAS_EMM, "New EMM_COMM_PROC_SMC\n");
-    return smc_proc;
-  } else {
-    free_wrapper((void**)&smc_proc);
-  }
-  return NULL;
+  wrapper->proc = &smc_proc->emm_com_proc;
+  LIST_INSERT_HEAD(&emm_context->emm_procedures->emm_common_procs, wrapper, entries);
+  OAILOG_TRACE (LOG_NAS_EMM, "New EMM_COMM_PROC_SMC\n");
+  return smc_proc;
 }
 
 //-----------------------------------------------------------------------------
@@ -866,22 +895,20 @@ nas_auth_info_proc_t *nas_new_cn_auth_info_procedure(struct emm_data_context_s *
     emm_context->emm_procedures = _nas_new_emm_procedures(emm_context);
   }
 
-  nas_auth_info_proc_t * auth_info_proc =  calloc(1, sizeof(nas_auth_info_proc_t));
+  nas_cn_procedure_t * wrapper = NULL;
+  nas_auth_info_proc_t * auth_info_proc =  nas_emm_procedure_alloc(sizeof(nas_auth_info_proc_t), sizeof(*wrapper), (void**)&wrapper);
+  if (!auth_info_proc) {
+    return NULL;
+  }
   auth_info_proc->cn_proc.base_proc.nas_puid = __sync_fetch_and_add (&nas_puid, 1);
   auth_info_proc->cn_proc.type           = CN_PROC_AUTH_INFO;
   auth_info_proc->timer_s6a.sec          = TIMER_S6A_AUTH_INFO_RSP_DEFAULT_VALUE;
   auth_info_proc->timer_s6a.id           = NAS_TIMER_INACTIVE_ID;
 
-  nas_cn_procedure_t * wrapper = calloc(1, sizeof(*wrapper));
-  if (wrapper) {
-    wrapper->proc = &auth_info_proc->cn_proc;
-    LIST_INSERT_HEAD(&emm_context->emm_procedures->cn_procs, wrapper, entries);
-    OAILOG_TRACE (LOG_NAS_EMM, "New CN_PROC_AUTH_INFO\n");
-    return auth_info_proc;
-  } else {
-    free_wrapper((void**)&auth_info_proc);
-  }
-  return NULL;
+  wrapper->proc = &auth_info_proc->cn_proc;
+  LIST_INSERT_HEAD(&emm_context->emm_procedures->cn_procs, wrapper, entries);
+  OAILOG_TRACE (LOG_NAS_EMM, "New CN_PROC_AUTH_INFO\n");
+  return auth_info_proc;
 }
 
 //-----------------------------------------------------------------------------
@@ -891,23 +918,21 @@ nas_ctx_req_proc_t *nas_new_cn_ctx_req_procedure(struct emm_data_context_s * con
     emm_context->emm_procedures = _nas_new_emm_procedures(emm_context);
   }
 
-  nas_ctx_req_proc_t * ctx_req_proc =  calloc(1, sizeof(nas_ctx_req_proc_t));
+  nas_cn_procedure_t * wrapper = NULL;
+  nas_ctx_req_proc_t * ctx_req_proc =  nas_emm_procedure_alloc(sizeof(nas_ctx_req_proc_t), sizeof(*wrapper), (void**)&wrapper);
+  if (!ctx_req_proc) {
+    return NULL;
+  }
   ctx_req_proc->cn_proc.base_proc.nas_puid = __sync_fetch_and_add (&nas_puid, 1);
   ctx_req_proc->cn_proc.type           = CN_PROC_CTX_REQ;
   // todo: timer necessary for context request?
   ctx_req_proc->timer_s10.sec          = TIMER_SPECIFIC_RETRY_DEFAULT_VALUE;
   ctx_req_proc->timer_s10.id           = NAS_TIMER_INACTIVE_ID;
 
-  nas_cn_procedure_t * wrapper = calloc(1, sizeof(*wrapper));
-  if (wrapper) {
-    wrapper->proc = &ctx_req_proc->cn_proc;
-    LIST_INSERT_HEAD(&emm_context->emm_procedures->cn_procs, wrapper, entries);
-    OAILOG_TRACE (LOG_NAS_EMM, "New CN_PROC_CTX_REQ\n");
-    return ctx_req_proc;
-  } else {
-    free_wrapper((void**)&ctx_req_proc);
-  }
-  return NULL;
+  wrapper->proc = &ctx_req_proc->cn_proc;
+  LIST_INSERT_HEAD(&emm_context->emm_procedures->cn_procs, wrapper, entries);
+  OAILOG_TRACE (LOG_NAS_EMM, "New CN_PROC_CTX_REQ\n");
+  return ctx_req_proc;
 }
 
 //-----------------------------------------------------------------------------
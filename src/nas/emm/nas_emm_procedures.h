@@ -33,6 +33,7 @@
 // todo: remove includes!
 #include "emm_fsm.h"
 #include "nas_timer.h"
+#include "mem_arena.h"
 
 struct emm_data_context_s;
 struct nas_emm_base_proc_s;
@@ -66,6 +67,7 @@ typedef struct nas_emm_base_proc_s {
 
   struct nas_emm_base_proc_s *parent;
   struct nas_emm_base_proc_s *child;
+  mem_arena_t                *arena;    // owns the procedure, its list wrapper and what is scoped to the procedure
 } nas_emm_base_proc_t;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -106,8 +106,10 @@ static int _emm_cn_authentication_res (emm_cn_auth_res_t * const msg)
 
     if (auth_info_proc) {
       for (int i = 0; i < msg->nb_vectors; i++) {
-        auth_info_proc->vector[i] = msg->vector[i];
-        msg->vector[i] = NULL;
+        // released with the procedure arena
+        auth_info_proc->vector[i] = mem_arena_alloc(auth_info_proc->cn_proc.base_proc.arena, sizeof(*auth_info_proc->vector[i]));
+        memcpy(auth_info_proc->vector[i], msg->vector[i], sizeof(*auth_info_proc->vector[i]));
+        free_wrapper((void**)&msg->vector[i]);
       }
       auth_info_proc->nb_vectors = msg->nb_vectors;
       rc = (*auth_info_proc->success_notif)(emm_context);
@@ -56,6 +56,7 @@
 #include "bstrlib.h"
 
 #include "dynamic_memory_check.h"
+#include "mem_arena.h"
 #include "assertions.h"
 #include "log.h"
 #include "common_types.h"
@@ -529,7 +530,7 @@ esm_proc_pdn_config_res(mme_ue_s1ap_id_t ue_id, bool * is_attach, pti_t * pti, i
   }
 
   if(!esm_proc_pdn_connectivity->subscribed_apn){
-	  esm_proc_pdn_connectivity->subscribed_apn = blk2bstr(apn_config->service_selection, apn_config->service_selection_length);  /**< Set the APN-NI from the service selection. */
+	  esm_proc_pdn_connectivity->subscribed_apn = mem_arena_blk2bstr(esm_proc_pdn_connectivity->esm_base_proc.arena, apn_config->service_selection, apn_config->service_selection_length);  /**< Set the APN-NI from the service selection. */
   }
   esm_proc_pdn_connectivity->pdn_cid = apn_config->context_identifier;
 
@@ -62,6 +62,7 @@
 #include "common_defs.h"
 #include "log.h"
 #include "assertions.h"
+#include "mem_arena.h"
 
 #include "mme_app_pdn_context.h"
 #include "emm_sap.h"
@@ -193,9 +194,7 @@ esm_proc_pdn_disconnect_request (
   esm_proc_pdn_disconnect->default_ebi = pdn_context->default_ebi;
   /** Update the PDN connectivity procedure with the PDN context information. */
   esm_proc_pdn_disconnect->pdn_cid = pdn_context->context_identifier;
-  if(esm_proc_pdn_disconnect->subscribed_apn)
-    bdestroy_wrapper(&esm_proc_pdn_disconnect->subscribed_apn);
-  esm_proc_pdn_disconnect->subscribed_apn = bstrcpy(pdn_context->apn_subscribed);
+  esm_proc_pdn_disconnect->subscribed_apn = mem_arena_bstrcpy(esm_proc_pdn_disconnect->esm_base_proc.arena, pdn_context->apn_subscribed);
   /*
    * Trigger an S11 Delete Session Request to the SAE-GW.
    * No need to process the response.
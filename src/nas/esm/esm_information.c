@@ -35,6 +35,7 @@
 
 #include "bstrlib.h"
 #include "dynamic_memory_check.h"
+#include "mem_arena.h"
 #include "log.h"
 
 #include "3gpp_24.007.h"
@@ -132,9 +133,7 @@ void esm_proc_esm_information_response (mme_ue_s1ap_id_t ue_id, pti_t pti, nas_e
 
   /** Process the result. */
   if (esm_information_resp->presencemask & ESM_INFORMATION_RESPONSE_ACCESS_POINT_NAME_PRESENT) {
-    if(esm_proc_pdn_connectivity->subscribed_apn)
-      bdestroy_wrapper(&esm_proc_pdn_connectivity->subscribed_apn);
-    esm_proc_pdn_connectivity->subscribed_apn = bstrcpy(esm_information_resp->accesspointname);
+    esm_proc_pdn_connectivity->subscribed_apn = mem_arena_bstrcpy(esm_proc_pdn_connectivity->esm_base_proc.arena, esm_information_resp->accesspointname);
   } else{
     /** No APN Name received from UE. We will used the default one from the subscription data. */
     OAILOG_ERROR (LOG_NAS_ESM, "ESM-SAP   - No APN name received in the ESM information response " "(ue_id=%d, pti=%d).\n", ue_id, pti);
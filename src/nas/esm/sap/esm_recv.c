@@ -48,6 +48,7 @@
 #include "bstrlib.h"
 #include "log.h"
 #include "dynamic_memory_check.h"
+#include "mem_arena.h"
 #include "common_types.h"
 #include "assertions.h"
 #include "conversions.h"
@@ -310,7 +311,7 @@ esm_recv_pdn_connectivity_request (
   esm_proc_pdn_connectivity->is_attach = *is_attach;
   memcpy(&esm_proc_pdn_connectivity->visited_tai, visited_tai, sizeof(tai_t));
   if(msg->presencemask & PDN_CONNECTIVITY_REQUEST_ACCESS_POINT_NAME_PRESENT)
-    esm_proc_pdn_connectivity->subscribed_apn = bstrcpy(msg->accesspointname);
+    esm_proc_pdn_connectivity->subscribed_apn = mem_arena_bstrcpy(esm_proc_pdn_connectivity->esm_base_proc.arena, msg->accesspointname);
 
   /*
    * Get the ESM information transfer flag
@@ -369,7 +370,7 @@ esm_recv_pdn_connectivity_request (
   OAILOG_INFO (LOG_NAS_ESM, "ESM-SAP   - Found a valid (default) APN configuration (cid=%d). Updating the UE context, if it is an attach procedure. Else, continuing with the PDN Connectivity procedure." "(ue_id=%d, pti=%d)\n", apn_configuration->context_identifier, ue_id, pti);
 
   if(!esm_proc_pdn_connectivity->subscribed_apn){
-    esm_proc_pdn_connectivity->subscribed_apn = blk2bstr(apn_configuration->service_selection, apn_configuration->service_selection_length);  /**< Set the APN-NI from the service selection. */
+    esm_proc_pdn_connectivity->subscribed_apn = mem_arena_blk2bstr(esm_proc_pdn_connectivity->esm_base_proc.arena, apn_configuration->service_selection, apn_configuration->service_selection_length);  /**< Set the APN-NI from the service selection. */
   }
   /* The APN-Configuration must be the correct one. */
   esm_proc_pdn_connectivity->pdn_cid = apn_configuration->context_identifier;
@@ -517,7 +518,7 @@ esm_cause_t esm_recv_information_response (
       apn_configuration->context_identifier, ue_id, pti);
 
   if(!esm_proc_pdn_connectivity->subscribed_apn){
-    esm_proc_pdn_connectivity->subscribed_apn = blk2bstr(apn_configuration->service_selection, apn_configuration->service_selection_length);  /**< Set the APN-NI from the service selection. */
+    esm_proc_pdn_connectivity->subscribed_apn = mem_arena_blk2bstr(esm_proc_pdn_connectivity->esm_base_proc.arena, apn_configuration->service_selection, apn_configuration->service_selection_length);  /**< Set the APN-NI from the service selection. */
   }
   esm_proc_pdn_connectivity->pdn_cid = apn_configuration->context_identifier;
 
@@ -453,6 +453,31 @@ void nas_itti_auth_info_req(
   OAILOG_FUNC_OUT(LOG_NAS);
 }
 
+//------------------------------------------------------------------------------
+void nas_itti_auth_info_prefetch_req(
+  const imsi_t   * const imsiP,
+  plmn_t         * const visited_plmnP)
+{
+  OAILOG_FUNC_IN(LOG_NAS);
+  MessageDef                             *message_p = NULL;
+  s6a_auth_info_req_t                    *auth_info_req = NULL;
+
+  message_p = itti_alloc_new_message (TASK_NAS_EMM, S6A_AUTH_INFO_PREFETCH_REQ);
+  auth_info_req = &message_p->ittiMsg.s6a_auth_info_prefetch_req;
+
+  IMSI_TO_STRING(imsiP,auth_info_req->imsi, IMSI_BCD_DIGITS_MAX+1);
+  auth_info_req->imsi_length = strlen(auth_info_req->imsi);
+  auth_info_req->visited_plmn  = *visited_plmnP;
+  /* Number of vectors set by the S6A vector cache. */
+  auth_info_req->nb_of_vectors = MAX_EPS_AUTH_VECTORS;
+
+  MSC_LOG_TX_MESSAGE (MSC_NAS_MME, MSC_S6A_MME, NULL, 0, "0 S6A_AUTH_INFO_PREFETCH_REQ IMSI %s visited_plmn "PLMN_FMT,
+      auth_info_req->imsi, PLMN_ARG(visited_plmnP));
+  itti_send_msg_to_task (TASK_S6A, INSTANCE_DEFAULT, message_p);
+
+  OAILOG_FUNC_OUT(LOG_NAS);
+}
+
 //------------------------------------------------------------------------------
 void nas_itti_s11_bearer_resource_cmd (
   const pti_t            pti,
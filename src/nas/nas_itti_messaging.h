@@ -113,6 +113,10 @@ void nas_itti_auth_info_req(
   const uint8_t          num_vectorsP,
   const_bstring    const auts_pP);
 
+void nas_itti_auth_info_prefetch_req(
+  const imsi_t   * const imsiP,
+  plmn_t         * const visited_plmnP);
+
 void nas_itti_s11_bearer_resource_cmd (
   const pti_t            pti,
   const ebi_t            linked_ebi,
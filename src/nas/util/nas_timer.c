@@ -46,6 +46,7 @@
 
 #include "bstrlib.h"
 
+#include "log.h"
 #include "intertask_interface.h"
 #include "timer.h"
 #include "common_defs.h"
@@ -54,6 +55,39 @@
 #include "intertask_interface_types.h"
 #include "nas_timer.h"
 
+/* Timer arguments may outlive the procedure that started the timer (expiry
+ * already queued when the timer is stopped), so they are not taken from the
+ * procedure arena but recycled through a per-thread free list. A recycled
+ * argument may be reached again by a stale expiry, so each argument carries
+ * the id of the timer owning it and the expiry is ignored on mismatch. For
+ * the same reason an argument is never freed: the list is not bounded, it
+ * grows up to the peak number of NAS timers running at the same time. */
+static __thread nas_itti_timer_arg_t   *nas_timer_arg_cache = NULL;
+
+//------------------------------------------------------------------------------
+static nas_itti_timer_arg_t *nas_timer_arg_get (void)
+{
+  nas_itti_timer_arg_t                   *nas_itti_timer_arg = nas_timer_arg_cache;
+
+  if (nas_itti_timer_arg) {
+    // cached entries are chained through their callback argument
+    nas_timer_arg_cache = (nas_itti_timer_arg_t *)nas_itti_timer_arg->nas_timer_callback_arg;
+    memset (nas_itti_timer_arg, 0, sizeof (*nas_itti_timer_arg));
+    return nas_itti_timer_arg;
+  }
+  return calloc (1, sizeof (nas_itti_timer_arg_t));
+}
+
+//------------------------------------------------------------------------------
+static void nas_timer_arg_put (nas_itti_timer_arg_t ** nas_itti_timer_arg)
+{
+  (*nas_itti_timer_arg)->nas_timer_callback = NULL;
+  (*nas_itti_timer_arg)->timer_id = NAS_TIMER_INACTIVE_ID;
+  (*nas_itti_timer_arg)->nas_timer_callback_arg = nas_timer_arg_cache;
+  nas_timer_arg_cache = *nas_itti_timer_arg;
+  *nas_itti_timer_arg = NULL;
+}
+
 //------------------------------------------------------------------------------
 int nas_timer_init (void)
 {
@@ -85,19 +119,24 @@ static long int nas_timer_start (
     return (NAS_TIMER_INACTIVE_ID);
   }
 
-  nas_itti_timer_arg = calloc(1, sizeof(nas_itti_timer_arg_t));
+  nas_itti_timer_arg = nas_timer_arg_get();
+  if (!nas_itti_timer_arg) {
+    return (long)NAS_TIMER_INACTIVE_ID;
+  }
   nas_itti_timer_arg->nas_timer_callback = nas_timer_callback;
   nas_itti_timer_arg->nas_timer_callback_arg = nas_timer_callback_args;
+  nas_itti_timer_arg->timer_id = NAS_TIMER_INACTIVE_ID;
 
   ret = timer_setup (sec, usec,
       ((is_emm) ? TASK_NAS_EMM : TASK_NAS_ESM),
       INSTANCE_DEFAULT, TIMER_ONE_SHOT, nas_itti_timer_arg, &timer_id);
 
   if (ret == -1) {
-    free_wrapper((void*)&nas_itti_timer_arg);
+    nas_timer_arg_put(&nas_itti_timer_arg);
     return (long)NAS_TIMER_INACTIVE_ID;
   }
-
+  // the expiry is handled by the NAS task, it cannot be processed before the timer id is set
+  nas_itti_timer_arg->timer_id = timer_id;
 
   return (timer_id);
 }
@@ -129,7 +168,7 @@ long int nas_timer_stop (long int timer_id, void **nas_timer_callback_arg)
   if (nas_itti_timer_arg) {
     *nas_timer_callback_arg = nas_itti_timer_arg->nas_timer_callback_arg;
     nas_itti_timer_arg->nas_timer_callback_arg = NULL;
-    free_wrapper((void**)&nas_itti_timer_arg);
+    nas_timer_arg_put(&nas_itti_timer_arg);
   } else {
     *nas_timer_callback_arg = NULL;
   }
@@ -139,10 +178,17 @@ long int nas_timer_stop (long int timer_id, void **nas_timer_callback_arg)
 //------------------------------------------------------------------------------
 void nas_timer_handle_signal_expiry (long timer_id, nas_itti_timer_arg_t *nas_itti_timer_arg)
 {
+  /*
+   * The argument was recycled (timer stopped while its expiry was queued), and possibly reused by another timer
+   */
+  if ((!nas_itti_timer_arg) || (!nas_itti_timer_arg->nas_timer_callback) || (timer_id != nas_itti_timer_arg->timer_id)) {
+    OAILOG_DEBUG (LOG_NAS, "Stale expiry of timer 0x%lx ignored\n", timer_id);
+    return;
+  }
   /*
    * Get the timer entry for which the system timer expired
    */
   nas_itti_timer_arg->nas_timer_callback (nas_itti_timer_arg->nas_timer_callback_arg);
   // assuming timer type is TIMER_ONE_SHOT
-  free_wrapper((void**)&nas_itti_timer_arg);
+  nas_timer_arg_put(&nas_itti_timer_arg);
 }
@@ -65,6 +65,7 @@ typedef void (*nas_timer_callback_t)(void *);
 typedef struct nas_itti_timer_arg_s {
   nas_timer_callback_t  nas_timer_callback;
   void                 *nas_timer_callback_arg;
+  long int              timer_id;   ///< timer owning the argument, NAS_TIMER_INACTIVE_ID once recycled
 }nas_itti_timer_arg_t;
 
 /****************************************************************************/
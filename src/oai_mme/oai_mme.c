@@ -63,6 +63,9 @@
 #include "mme_config.h"
 
 #include "intertask_interface_init.h"
+#include "intertask_interface_trace.h"
+#include "intertask_interface_latency.h"
+#include "itti_free_defined_msg.h"
 
 #include "sctp_primitives_server.h"
 #include "udp_primitives_server.h"
@@ -158,6 +161,25 @@ main (
           NULL,
 #endif
           NULL));
+  // content of the sheddable messages dropped on a full queue
+  itti_set_free_msg_content (itti_free_msg_content);
+  if (mme_config.itti_config.trace_file) {
+    CHECK_INIT_RETURN (itti_trace_init (bdata(mme_config.itti_config.trace_file), ((uint64_t)mme_config.itti_config.trace_file_size) << 20));
+    for (int i = 0; i < mme_config.itti_config.nb_trace_tasks; i++) {
+      AssertFatal (0 == itti_trace_select_task (bdata(mme_config.itti_config.trace_tasks[i])), "Unknown ITTI task %s in trace filter", bdata(mme_config.itti_config.trace_tasks[i]));
+    }
+    for (int i = 0; i < mme_config.itti_config.nb_trace_messages; i++) {
+      AssertFatal (0 == itti_trace_select_message (bdata(mme_config.itti_config.trace_messages[i])), "Unknown ITTI message %s in trace filter", bdata(mme_config.itti_config.trace_messages[i]));
+    }
+  }
+  if (mme_config.itti_config.latency_file) {
+    CHECK_INIT_RETURN (itti_latency_init (bdata(mme_config.itti_config.latency_file)));
+  }
+  for (int i = 0; i < mme_config.itti_config.nb_thread_placements; i++) {
+    AssertFatal (0 == itti_set_task_placement (bdata(mme_config.itti_config.thread_placement[i].task), bdata(mme_config.itti_config.thread_placement[i].cpus),
+        mme_config.itti_config.thread_placement[i].numa_node, mme_config.itti_config.thread_placement[i].wait_mode, mme_config.itti_config.thread_placement[i].spin_us),
+        "Bad ITTI thread placement for task %s", bdata(mme_config.itti_config.thread_placement[i].task));
+  }
   MSC_INIT (MSC_MME, THREAD_MAX + TASK_MAX);
   CHECK_INIT_RETURN (nas_emm_init (&mme_config));
   CHECK_INIT_RETURN (nas_esm_init ());
@@ -174,6 +196,8 @@ main (
    * Handle signals here
    */
   itti_wait_tasks_end ();
+  itti_trace_exit ();
+  itti_latency_exit ();
   pid_file_unlock();
   free_wrapper((void**)&pid_file_name);
   return 0;
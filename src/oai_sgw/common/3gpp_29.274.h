@@ -474,6 +474,21 @@ typedef struct {
   unsigned cmi:1;
 } UCI_t;
 
+//-------------------------------------
+// 8.85 Throttling
+#define THROTTLING_DELAY_UNIT_2_SECONDS   0x0
+#define THROTTLING_DELAY_UNIT_1_MINUTE    0x1
+#define THROTTLING_DELAY_UNIT_10_MINUTES  0x2
+#define THROTTLING_DELAY_UNIT_1_HOUR      0x3
+#define THROTTLING_DELAY_UNIT_10_HOURS    0x4
+#define THROTTLING_DELAY_UNIT_DEACTIVATED 0x7
+
+typedef struct throttling_s {
+  unsigned delay_unit:3;       ///< THROTTLING_DELAY_UNIT_*, other values are interpreted as 1 minute
+  unsigned delay_value:5;      ///< binary coded timer value, 0 or DEACTIVATED unit stops the throttling
+  uint8_t  factor;             ///< percentage 0..100 of the DL data notifications to drop
+} throttling_t;
+
 //-------------------------------------
 // 8.32 Bearer Flags
 
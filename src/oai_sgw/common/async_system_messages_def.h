@@ -28,3 +28,4 @@
 */
 
 MESSAGE_DEF(ASYNC_SYSTEM_COMMAND,           MESSAGE_PRIORITY_MED)
+MESSAGE_DEF(ASYNC_SYSTEM_COMMAND_RESULT,    MESSAGE_PRIORITY_MED)
@@ -33,12 +33,19 @@ extern "C" {
 #endif
 
 #define ASYNC_SYSTEM_COMMAND(mSGpTR)                     ((itti_async_system_command_t*)(mSGpTR)->itti_msg)
+#define ASYNC_SYSTEM_COMMAND_RESULT(mSGpTR)              ((itti_async_system_command_result_t*)(mSGpTR)->itti_msg)
 
 typedef struct itti_async_system_command_s {
   bstring                  system_command;
   bool                     is_abort_on_error;
+  bool                     is_notify_on_completion; ///< send back ASYNC_SYSTEM_COMMAND_RESULT to the origin task
 } itti_async_system_command_t;
 
+typedef struct itti_async_system_command_result_s {
+  bstring                  system_command;
+  int                      exit_status;             ///< exit code of the command, -1 if it could not be spawned or was killed
+} itti_async_system_command_result_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -34,3 +34,4 @@ MESSAGE_DEF(GTPV1U_DELETE_TUNNEL_RESP,  MESSAGE_PRIORITY_MED)
 MESSAGE_DEF(GTPV1U_TUNNEL_DATA_IND,     MESSAGE_PRIORITY_MED)
 MESSAGE_DEF(GTPV1U_TUNNEL_DATA_REQ,     MESSAGE_PRIORITY_MED)
 MESSAGE_DEF(GTPV1U_DOWNLINK_DATA_NOTIFICATION, MESSAGE_PRIORITY_MED)
+MESSAGE_DEF(GTPV1U_TUNNEL_BATCH_RESULT, MESSAGE_PRIORITY_MED)
@@ -44,6 +44,9 @@ extern "C" {
 #define GTPV1U_TUNNEL_DATA_IND(mSGpTR)      ((Gtpv1uTunnelDataInd*)(mSGpTR)->itti_msg)
 #define GTPV1U_TUNNEL_DATA_REQ(mSGpTR)      ((Gtpv1uTunnelDataReq*)(mSGpTR)->itti_msg)
 #define GTPV1U_DOWNLINK_DATA_NOTIFICATION(mSGpTR)      ((Gtpv1uDownlinkDataNotification*)(mSGpTR)->itti_msg)
+#define GTPV1U_TUNNEL_BATCH_RESULT(mSGpTR)  ((Gtpv1uTunnelBatchResult*)(mSGpTR)->itti_msg)
+
+#define GTPV1U_TUNNEL_BATCH_MAX_RESULTS     128
 
 typedef struct {
   teid_t           context_teid;               ///< Tunnel Endpoint Identifier
@@ -102,8 +105,25 @@ typedef struct {
 typedef struct {
   struct in_addr     ue_ip;
   ebi_t            eps_bearer_id;
+  uint32_t         sdf_id;          ///< sdf_id_t of the PCC rule matching the triggering packet, 0 if unknown
 }Gtpv1uDownlinkDataNotification;
 
+typedef struct gtpv1u_tunnel_result_s {
+  bool             is_add;           ///< tunnel addition, else deletion
+  ebi_t            eps_bearer_id;
+  struct in_addr   ue_ip;
+  struct in_addr   enb_ip;
+  teid_t           sgw_S1u_teid;     ///< SGW S1U local Tunnel Endpoint Identifier
+  teid_t           enb_S1u_teid;     ///< eNB S1U Tunnel Endpoint Identifier
+  int              status;           ///< 0 or -errno returned by the data plane
+} gtpv1u_tunnel_result_t;
+
+/* Tunnels programmed asynchronously by the data plane: additions and failures of one batch */
+typedef struct {
+  uint16_t                 num_results;
+  gtpv1u_tunnel_result_t   results[GTPV1U_TUNNEL_BATCH_MAX_RESULTS];
+} Gtpv1uTunnelBatchResult;
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,13 +24,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
 #include <signal.h>
 
+#include <sched.h>
+#include <limits.h>
+#include <time.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
 #include <malloc.h>
 
 
@@ -138,6 +145,24 @@ typedef struct thread_desc_s {
    */
   unsigned                                messages_pending;
   //#endif
+
+  /*
+   * Placement of the thread, see itti_set_task_placement ()
+   */
+  bool                                    cpu_set_configured;
+  cpu_set_t                               cpu_set;
+  int                                     numa_node;
+  volatile itti_wait_mode_t               wait_mode;
+  volatile uint32_t                       spin_us;
+
+  /*
+   * Kernel thread id, scheduler counters of the previous itti_print_thread_stats () call
+   */
+  pid_t                                   tid;
+  uint64_t                                previous_cpu_ns;
+  uint64_t                                previous_run_queue_ns;
+  uint64_t                                previous_timeslices;
+  uint64_t                                previous_stats_ns;
 } thread_desc_t;
 
 typedef struct task_desc_s {
@@ -185,6 +210,36 @@ typedef struct itti_desc_s {
 
 static itti_desc_t                      itti_desc;
 
+/* Nodes addressable by itti_set_task_placement () */
+#define ITTI_NUMA_NODEMASK_LONGS         4
+
+#if defined(__x86_64__) || defined(__i386__)
+#  define ITTI_CPU_RELAX()               __builtin_ia32_pause ()
+#else
+#  define ITTI_CPU_RELAX()               __asm__ __volatile__ ("" ::: "memory")
+#endif
+
+static const char * const               itti_wait_mode_names[] = {"block", "adaptive spin", "busy poll"};
+
+//------------------------------------------------------------------------------
+static inline uint64_t itti_monotonic_ns (void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+// Size of the queue elements of a task, rounded up to whole pages.
+static inline size_t itti_queue_elements_size (const task_id_t task_id)
+{
+  const size_t                            page_size = sysconf (_SC_PAGESIZE);
+  const size_t                            size = itti_desc.tasks_info[task_id].queue_size * sizeof (struct lfds710_queue_bmm_element);
+
+  return ((size + page_size - 1) / page_size) * page_size;
+}
+
 void                                   *
 itti_malloc (
   task_id_t origin_task_id,
@@ -528,6 +583,28 @@ itti_get_events (
   return itti_desc.threads[thread_id].epoll_nb_events;
 }
 
+//------------------------------------------------------------------------------
+// Poll the fds of the thread without sleeping, for spin_us in adaptive spin mode, until an event in busy poll mode.
+// Returns the number of events, 0 if the caller has to block.
+static int
+itti_spin_wait (
+  const thread_id_t thread_id)
+{
+  thread_desc_t * const                   thread = &itti_desc.threads[thread_id];
+  const uint64_t                          deadline_ns = itti_monotonic_ns () + 1000 * (uint64_t)thread->spin_us;
+  int                                     epoll_ret = 0;
+
+  do {
+    epoll_ret = epoll_wait (thread->epoll_fd, thread->events, thread->nb_events, 0);
+    if (epoll_ret) {
+      break;
+    }
+    ITTI_CPU_RELAX ();
+  } while ((ITTI_WAIT_MODE_BUSY_POLL == thread->wait_mode) || (itti_monotonic_ns () < deadline_ns));
+  // on error (EINTR) fall back to the blocking wait
+  return (epoll_ret > 0) ? epoll_ret:0;
+}
+
 static inline void
 itti_receive_msg_internal_event_fd (
   task_id_t task_id,
@@ -557,9 +634,15 @@ itti_receive_msg_internal_event_fd (
     epoll_timeout = -1;
   }
 
-  do {
-    epoll_ret = epoll_wait (itti_desc.threads[thread_id].epoll_fd, itti_desc.threads[thread_id].events, itti_desc.threads[thread_id].nb_events, epoll_timeout);
-  } while (epoll_ret < 0 && errno == EINTR);
+  if ((!polling) && (ITTI_WAIT_MODE_BLOCK != itti_desc.threads[thread_id].wait_mode)) {
+    epoll_ret = itti_spin_wait (thread_id);
+  }
+
+  if (0 == epoll_ret) {
+    do {
+      epoll_ret = epoll_wait (itti_desc.threads[thread_id].epoll_fd, itti_desc.threads[thread_id].events, itti_desc.threads[thread_id].nb_events, epoll_timeout);
+    } while (epoll_ret < 0 && errno == EINTR);
+  }
 
   if (epoll_ret < 0) {
     AssertFatal (0, "epoll_wait failed for task %s: %s!\n", itti_get_task_name (task_id), strerror (errno));
@@ -660,19 +743,32 @@ itti_create_task (
   AssertFatal (itti_desc.threads[thread_id].task_state == TASK_STATE_NOT_CONFIGURED, "Task %d, thread %d state is not correct (%d)!\n", task_id, thread_id, itti_desc.threads[thread_id].task_state);
   itti_desc.threads[thread_id].task_state = TASK_STATE_STARTING;
   ITTI_DEBUG (ITTI_DEBUG_INIT, " Creating thread for task %s ...\n", itti_get_task_name (task_id));
+  pthread_attr_t                          attr;
+  pthread_attr_t                         *attr_p = NULL;
+
 #if ITTI_TASK_STACK_SIZE
-  pthread_attr_t                          attr = {.__align = 0};
-  result = pthread_attr_init(&attr);
+  result = pthread_attr_init (&attr);
   AssertFatal (result == 0, "Thread attributes for task %d, thread %d init failed (%d)!\n", task_id, thread_id, result);
-  result = pthread_attr_setstacksize(&attr, ITTI_TASK_STACK_SIZE);
-  result = pthread_create (&itti_desc.threads[thread_id].task_thread, NULL, start_routine, args_p);
-  AssertFatal (result >= 0, "Thread creation for task %d, thread %d failed (%d)!\n", task_id, thread_id, result);
-  result = pthread_attr_destroy(&attr);
-  AssertFatal (result == 0, "Thread attributes for task %d, thread %d destroy failed (%d)!\n", task_id, thread_id, result);
-#else
-  result = pthread_create (&itti_desc.threads[thread_id].task_thread, NULL, start_routine, args_p);
-  AssertFatal (result >= 0, "Thread creation for task %d, thread %d failed (%d)!\n", task_id, thread_id, result);
+  result = pthread_attr_setstacksize (&attr, ITTI_TASK_STACK_SIZE);
+  AssertFatal (result == 0, "Thread stack size for task %d, thread %d failed (%d)!\n", task_id, thread_id, result);
+  attr_p = &attr;
 #endif
+  if (itti_desc.threads[thread_id].cpu_set_configured) {
+    // start the thread on its CPUs so that the memory it touches first is local to them
+    if (!attr_p) {
+      result = pthread_attr_init (&attr);
+      AssertFatal (result == 0, "Thread attributes for task %d, thread %d init failed (%d)!\n", task_id, thread_id, result);
+      attr_p = &attr;
+    }
+    result = pthread_attr_setaffinity_np (attr_p, sizeof (cpu_set_t), &itti_desc.threads[thread_id].cpu_set);
+    AssertFatal (result == 0, "Thread affinity for task %d, thread %d failed (%d)!\n", task_id, thread_id, result);
+  }
+  result = pthread_create (&itti_desc.threads[thread_id].task_thread, attr_p, start_routine, args_p);
+  AssertFatal (result >= 0, "Thread creation for task %d, thread %d failed (%d)!\n", task_id, thread_id, result);
+  if (attr_p) {
+    result = pthread_attr_destroy (attr_p);
+    AssertFatal (result == 0, "Thread attributes for task %d, thread %d destroy failed (%d)!\n", task_id, thread_id, result);
+  }
   char                                    name[16];
 
   snprintf (name, sizeof (name), "ITTI %d", thread_id);
@@ -708,6 +804,156 @@ itti_wait_ready (
   AssertFatal (itti_desc.created_tasks == itti_desc.ready_tasks, "Number of created tasks (%d) does not match ready tasks (%d), wait task %d!\n", itti_desc.created_tasks, itti_desc.ready_tasks, itti_desc.wait_tasks);
 }
 
+//------------------------------------------------------------------------------
+// Parse a CPU list in the taskset format, ex: "2-3,8".
+static int
+itti_parse_cpu_list (
+  const char * const cpu_list,
+  cpu_set_t * const cpu_set)
+{
+  const char                             *p = cpu_list;
+
+  CPU_ZERO (cpu_set);
+  while (*p) {
+    char                                   *end = NULL;
+    long                                    first = strtol (p, &end, 10);
+    long                                    last = first;
+
+    if ((end == p) || (0 > first)) {
+      return -1;
+    }
+    p = end;
+    if ('-' == *p) {
+      p++;
+      last = strtol (p, &end, 10);
+      if ((end == p) || (last < first)) {
+        return -1;
+      }
+      p = end;
+    }
+    if (CPU_SETSIZE <= last) {
+      return -1;
+    }
+    for (long cpu = first; cpu <= last; cpu++) {
+      CPU_SET (cpu, cpu_set);
+    }
+    if (',' == *p) {
+      p++;
+    } else if (*p) {
+      return -1;
+    }
+  }
+  return (CPU_COUNT (cpu_set)) ? 0:-1;
+}
+
+//------------------------------------------------------------------------------
+// Move the queue elements of a task to a NUMA node, they are page aligned and padded (see itti_init ()).
+static void
+itti_place_task_queue (
+  const task_id_t task_id,
+  const int numa_node)
+{
+  unsigned long                           nodemask[ITTI_NUMA_NODEMASK_LONGS] = {0};
+
+  nodemask[numa_node / (sizeof (unsigned long) * CHAR_BIT)] |= 1UL << (numa_node % (sizeof (unsigned long) * CHAR_BIT));
+  if (syscall (SYS_mbind, itti_desc.tasks[task_id].qbmme, itti_queue_elements_size (task_id), MPOL_PREFERRED,
+        nodemask, sizeof (nodemask) * CHAR_BIT, MPOL_MF_MOVE)) {
+    OAILOG_WARNING (LOG_ITTI, "Could not move the queue of task %s to NUMA node %d: %s\n", itti_get_task_name (task_id), numa_node, strerror (errno));
+  }
+}
+
+int
+itti_set_task_placement (
+  const char * const task_name,
+  const char * const cpu_list,
+  const int numa_node,
+  const itti_wait_mode_t wait_mode,
+  const uint32_t spin_us)
+{
+  task_id_t                               task_id;
+  thread_desc_t                          *thread = NULL;
+  cpu_set_t                               cpu_set;
+  const bool                              pin = (cpu_list) && (cpu_list[0]);
+
+  for (task_id = TASK_FIRST; task_id < itti_desc.task_max; task_id++) {
+    if (!strcmp (task_name, itti_desc.tasks_info[task_id].name)) {
+      break;
+    }
+  }
+  if ((task_id >= itti_desc.task_max) || (numa_node >= (int)(ITTI_NUMA_NODEMASK_LONGS * sizeof (unsigned long) * CHAR_BIT)) ||
+      (wait_mode > ITTI_WAIT_MODE_BUSY_POLL) || ((pin) && (itti_parse_cpu_list (cpu_list, &cpu_set)))) {
+    return -1;
+  }
+  thread = &itti_desc.threads[TASK_GET_THREAD_ID (task_id)];
+  if (pin) {
+    thread->cpu_set = cpu_set;
+    thread->cpu_set_configured = true;
+    // threads already running are moved now, the others are started on their CPUs
+    if (TASK_STATE_NOT_CONFIGURED != thread->task_state) {
+      int                                     result = pthread_setaffinity_np (thread->task_thread, sizeof (cpu_set_t), &thread->cpu_set);
+
+      if (result) {
+        OAILOG_WARNING (LOG_ITTI, "Could not pin task %s on CPUs %s: %s\n", task_name, cpu_list, strerror (result));
+      }
+    }
+  }
+  thread->numa_node = numa_node;
+  if (0 <= numa_node) {
+    itti_place_task_queue (task_id, numa_node);
+  }
+  thread->spin_us   = spin_us;
+  thread->wait_mode = wait_mode;
+  OAILOG_INFO (LOG_ITTI, "Task %s placement: CPUs %s, NUMA node %d, wait mode %s (spin %u us)\n",
+      task_name, (pin) ? cpu_list:"any", numa_node, itti_wait_mode_names[wait_mode], spin_us);
+  return 0;
+}
+
+void
+itti_print_thread_stats (
+  void)
+{
+  const uint64_t                          now_ns = itti_monotonic_ns ();
+  task_id_t                               task_id;
+
+  OAILOG_INFO (LOG_ITTI, "ITTI threads:\n");
+  for (task_id = TASK_FIRST; task_id < itti_desc.task_max; task_id++) {
+    thread_desc_t * const                 thread = &itti_desc.threads[TASK_GET_THREAD_ID (task_id)];
+    char                                  path[64];
+    FILE                                 *fp = NULL;
+    uint64_t                              cpu_ns = 0;
+    uint64_t                              run_queue_ns = 0;
+    uint64_t                              timeslices = 0;
+    int                                   fields = 0;
+
+    if ((TASK_UNKNOWN != itti_desc.tasks_info[task_id].parent_task) || (!thread->tid)) {
+      continue;
+    }
+    // time on CPU, time waiting on a run queue, number of time slices
+    snprintf (path, sizeof (path), "/proc/self/task/%d/schedstat", (int)thread->tid);
+    if (!(fp = fopen (path, "r"))) {
+      continue;
+    }
+    fields = fscanf (fp, "%"SCNu64" %"SCNu64" %"SCNu64, &cpu_ns, &run_queue_ns, &timeslices);
+    fclose (fp);
+    if (3 != fields) {
+      continue;
+    }
+
+    const double                          period_ns = (now_ns > thread->previous_stats_ns) ? (double)(now_ns - thread->previous_stats_ns):1.0;
+    const uint64_t                        slices = timeslices - thread->previous_timeslices;
+    const uint64_t                        run_queue_delta_ns = run_queue_ns - thread->previous_run_queue_ns;
+
+    OAILOG_INFO (LOG_ITTI, "  %-24s tid %6d cpu %5.1f%% run queue delay %9.1f us/s %7.1f us/slice, %s, %s\n",
+        itti_get_task_name (task_id), (int)thread->tid, (100.0 * (cpu_ns - thread->previous_cpu_ns)) / period_ns,
+        (1000000.0 * run_queue_delta_ns) / period_ns, (slices) ? run_queue_delta_ns / (1000.0 * slices):0.0,
+        (thread->cpu_set_configured) ? "pinned":"not pinned", itti_wait_mode_names[thread->wait_mode]);
+    thread->previous_cpu_ns       = cpu_ns;
+    thread->previous_run_queue_ns = run_queue_ns;
+    thread->previous_timeslices   = timeslices;
+    thread->previous_stats_ns     = now_ns;
+  }
+}
+
 void
 itti_mark_task_ready (
   task_id_t task_id)
@@ -720,6 +966,8 @@ itti_mark_task_ready (
    * Mark the thread as using LFDS queue
    */
   LFDS710_MISC_MAKE_VALID_ON_CURRENT_LOGICAL_CORE_INITS_COMPLETED_BEFORE_NOW_ON_ANY_OTHER_LOGICAL_CORE;
+  itti_desc.threads[thread_id].tid = syscall (SYS_gettid);
+  itti_desc.threads[thread_id].previous_stats_ns = itti_monotonic_ns ();
   itti_desc.threads[thread_id].task_state = TASK_STATE_READY;
   itti_desc.ready_tasks++;
 
@@ -803,7 +1051,9 @@ itti_init (
     ITTI_DEBUG (ITTI_DEBUG_INIT, " Creating queue of message of size %u\n", itti_desc.tasks_info[task_id].queue_size);
     printf (" Creating queue of message of size %u\n", itti_desc.tasks_info[task_id].queue_size);
 
-    itti_desc.tasks[task_id].qbmme = calloc(itti_desc.tasks_info[task_id].queue_size, sizeof(struct lfds710_queue_bmm_element));
+    itti_desc.tasks[task_id].qbmme = memalign(sysconf (_SC_PAGESIZE), itti_queue_elements_size (task_id));
+    AssertFatal (itti_desc.tasks[task_id].qbmme != NULL, "Queue allocation for task %d failed!\n", task_id);
+    memset(itti_desc.tasks[task_id].qbmme, 0, itti_queue_elements_size (task_id));
     lfds710_queue_bmm_init_valid_on_current_logical_core( &itti_desc.tasks[task_id].message_queue, itti_desc.tasks[task_id].qbmme, itti_desc.tasks_info[task_id].queue_size, NULL );
   }
 
@@ -812,6 +1062,8 @@ itti_init (
    */
   for (thread_id = THREAD_FIRST; thread_id < itti_desc.thread_max; thread_id++) {
     itti_desc.threads[thread_id].task_state = TASK_STATE_NOT_CONFIGURED;
+    itti_desc.threads[thread_id].numa_node = -1;
+    itti_desc.threads[thread_id].wait_mode = ITTI_WAIT_MODE_BLOCK;
     itti_desc.threads[thread_id].epoll_fd = epoll_create1 (0);
 
     if (itti_desc.threads[thread_id].epoll_fd == -1) {
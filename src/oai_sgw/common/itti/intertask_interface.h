@@ -77,6 +77,13 @@ typedef enum task_priorities_e {
   TASK_PRIORITY_MIN       = 10,
 } task_priorities_t;
 
+/* How a task thread waits for messages */
+typedef enum itti_wait_mode_e {
+  ITTI_WAIT_MODE_BLOCK = 0,    ///< sleep in epoll_wait
+  ITTI_WAIT_MODE_ADAPTIVE_SPIN,///< poll for spin_us, then sleep
+  ITTI_WAIT_MODE_BUSY_POLL,    ///< never sleep, the thread keeps its CPU
+} itti_wait_mode_t;
+
 typedef struct task_info_s {
   thread_id_t thread;
   task_id_t   parent_task;
@@ -157,6 +164,21 @@ int itti_create_task(task_id_t task_id,
 void itti_set_task_real_time(task_id_t task_id);
 //#endif
 
+/** \brief Set the CPUs, NUMA node and wait mode of the thread of a task.
+ * Can be called before or after the creation of the task, a running thread is moved immediately.
+ * \param task_name name of the task, ex: "TASK_S1AP"
+ * \param cpu_list CPUs the thread may run on, ex: "2-3,8", NULL or empty to leave the affinity unchanged
+ * \param numa_node node where the message queue of the task is moved, -1 to leave it where it is
+ * \param wait_mode how the thread waits for messages
+ * \param spin_us polling duration in ITTI_WAIT_MODE_ADAPTIVE_SPIN mode
+ * @returns -1 if the task is unknown or the CPU list is invalid, 0 otherwise
+ **/
+int itti_set_task_placement(const char *task_name, const char *cpu_list, int numa_node, itti_wait_mode_t wait_mode, uint32_t spin_us);
+
+/** \brief Log the CPU time and run queue delay of the task threads since the previous call
+ **/
+void itti_print_thread_stats(void);
+
 /** \brief Indicates to ITTI if newly created tasks should wait for all tasks to be ready
  * \param wait_tasks non 0 to make new created tasks to wait, 0 to let created tasks to run
  **/
@@ -78,6 +78,13 @@ void itti_free_msg_content (MessageDef * const message_p)
     }
     break;
 
+  case ASYNC_SYSTEM_COMMAND_RESULT:{
+      if (ASYNC_SYSTEM_COMMAND_RESULT (message_p)->system_command) {
+        bdestroy_wrapper(&ASYNC_SYSTEM_COMMAND_RESULT (message_p)->system_command);
+      }
+    }
+    break;
+
   case GTPV1U_CREATE_TUNNEL_REQ:
   case GTPV1U_CREATE_TUNNEL_RESP:
   case GTPV1U_UPDATE_TUNNEL_REQ:
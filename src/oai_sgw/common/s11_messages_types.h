@@ -1289,8 +1289,10 @@ typedef struct itti_s11_downlink_data_notification_acknowledge_s {
   teid_t          teid;                   ///< Tunnel Endpoint Identifier
   teid_t          local_teid;                   ///< Tunnel Endpoint Identifier
   gtpv2c_cause_t  cause;
-  imsi_t          imsi;
+  DelayValue_t    data_notification_delay;   ///< optional, in multiples of 50 ms
   // Recovery           ///< optional This IE shall be included if contacting the peer for the first time
+  throttling_t    dl_low_priority_traffic_throttling; ///< optional, applies to all the DL data notifications towards this MME
+  imsi_t          imsi;
   // Private Extension  ///< optional
 #define DOWNLINK_DATA_NOTIFICATION_ACK_PR_IE_CAUSE                                 0x0001
 #define DOWNLINK_DATA_NOTIFICATION_ACK_PR_IE_DATA_NOTIFICATION_DELAY               0x0002
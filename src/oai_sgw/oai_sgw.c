@@ -101,6 +101,13 @@ main (
    * Parse the command line for options and set the mme_config accordingly.
    */
   CHECK_INIT_RETURN (spgw_config_parse_opt_line (argc, argv, &spgw_config));
+  // tasks already running (ASYNC_SYSTEM) are moved, the others are started with their placement
+  for (int i = 0; i < spgw_config.sgw_config.itti_config.nb_thread_placements; i++) {
+    AssertFatal (0 == itti_set_task_placement (bdata(spgw_config.sgw_config.itti_config.thread_placement[i].task),
+        bdata(spgw_config.sgw_config.itti_config.thread_placement[i].cpus), spgw_config.sgw_config.itti_config.thread_placement[i].numa_node,
+        spgw_config.sgw_config.itti_config.thread_placement[i].wait_mode, spgw_config.sgw_config.itti_config.thread_placement[i].spin_us),
+        "Bad ITTI thread placement for task %s", bdata(spgw_config.sgw_config.itti_config.thread_placement[i].task));
+  }
   /*
    * Calling each layer init function
    */
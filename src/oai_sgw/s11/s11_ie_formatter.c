@@ -1502,6 +1502,48 @@ gtpv2c_delay_value_ie_set (
   return RETURNok;
 }
 
+//------------------------------------------------------------------------------
+nw_rc_t
+gtpv2c_throttling_ie_get (
+  uint8_t ieType,
+  uint16_t ieLength,
+  uint8_t ieInstance,
+  uint8_t * ieValue,
+  void *arg)
+{
+  throttling_t                           *throttling = (throttling_t *) arg;
+
+  DevAssert (arg );
+
+  if (ieLength != 2) {
+    return NW_GTPV2C_IE_INCORRECT;
+  }
+
+  throttling->delay_unit  = (ieValue[0] >> 5) & 0x07;
+  throttling->delay_value = ieValue[0] & 0x1F;
+  throttling->factor      = (ieValue[1] > 100) ? 0 : ieValue[1]; // values above 100 are interpreted as 0
+  OAILOG_DEBUG (LOG_S11, "\t - Throttling delay unit %u value %u factor %u\n", throttling->delay_unit, throttling->delay_value, throttling->factor);
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+int
+gtpv2c_throttling_ie_set (
+  nw_gtpv2c_msg_handle_t * msg,
+  const throttling_t * throttling)
+{
+  uint8_t                                 value[2];
+  nw_rc_t                                   rc;
+
+  DevAssert (msg );
+  DevAssert (throttling );
+  value[0] = (throttling->delay_unit << 5) | (throttling->delay_value & 0x1F);
+  value[1] = throttling->factor;
+  rc = nwGtpv2cMsgAddIe (*msg, NW_GTPV2C_IE_THROTTLING, 2, 0, value);
+  DevAssert (NW_OK == rc);
+  return RETURNok;
+}
+
 //------------------------------------------------------------------------------
 nw_rc_t
 gtpv2c_ue_time_zone_ie_get (
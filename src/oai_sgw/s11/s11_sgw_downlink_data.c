@@ -57,6 +57,38 @@ extern "C" {
 
 extern hash_table_ts_t                        *s11_sgw_teid_2_gtv2c_teid_handle;
 
+//------------------------------------------------------------------------------
+static nw_rc_t
+s11_sgw_ddn_ack_delay_value_ie_get (
+  uint8_t ieType,
+  uint16_t ieLength,
+  uint8_t ieInstance,
+  uint8_t * ieValue,
+  void *arg)
+{
+  itti_s11_downlink_data_notification_acknowledge_t *resp_p = (itti_s11_downlink_data_notification_acknowledge_t *) arg;
+  nw_rc_t rc = gtpv2c_delay_value_ie_get (ieType, ieLength, ieInstance, ieValue, &resp_p->data_notification_delay);
+
+  if (NW_OK == rc) resp_p->ie_presence_mask |= DOWNLINK_DATA_NOTIFICATION_ACK_PR_IE_DATA_NOTIFICATION_DELAY;
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static nw_rc_t
+s11_sgw_ddn_ack_throttling_ie_get (
+  uint8_t ieType,
+  uint16_t ieLength,
+  uint8_t ieInstance,
+  uint8_t * ieValue,
+  void *arg)
+{
+  itti_s11_downlink_data_notification_acknowledge_t *resp_p = (itti_s11_downlink_data_notification_acknowledge_t *) arg;
+  nw_rc_t rc = gtpv2c_throttling_ie_get (ieType, ieLength, ieInstance, ieValue, &resp_p->dl_low_priority_traffic_throttling);
+
+  if (NW_OK == rc) resp_p->ie_presence_mask |= DOWNLINK_DATA_NOTIFICATION_ACK_PR_IE_DL_LOW_PRIORITY_TRAFFIC_THROTTLING;
+  return rc;
+}
+
 //------------------------------------------------------------------------------
 int
 s11_sgw_handle_downlink_data_notification (
@@ -156,6 +188,14 @@ s11_sgw_handle_downlink_data_notification_ack (
       &resp_p->imsi);
   DevAssert (NW_OK == rc);
 
+  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_DELAY_VALUE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL,
+      s11_sgw_ddn_ack_delay_value_ie_get, resp_p);
+  DevAssert (NW_OK == rc);
+
+  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_THROTTLING, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL,
+      s11_sgw_ddn_ack_throttling_ie_get, resp_p);
+  DevAssert (NW_OK == rc);
+
 
   /*
    * Run the parser
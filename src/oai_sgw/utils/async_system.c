@@ -20,7 +20,11 @@
  */
 
 /*! \file async_system.c
-   \brief
+   \brief Executor of the unix commands requested through ASYNC_SYSTEM_COMMAND messages.
+   \ Commands are spawned without shell (posix_spawn) when they do not need one, and run concurrently by a small
+   \ pool of worker threads, each one with its own ordered queue. A command is queued on the worker selected by
+   \ its program name, so commands of a same program (ip route/rule/addr, ...) run in the order they were requested.
+   \ iptables commands have a dedicated worker, consecutive ones are coalesced into a single iptables-restore run.
    \author  Lionel GAUTHIER
    \date 2017
    \email: lionel.gauthier@eurecom.fr
@@ -35,10 +39,12 @@
 #include <inttypes.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #include <ctype.h>
 #include <fcntl.h>
 #include <pthread.h>
+#include <spawn.h>
 
 #include "bstrlib.h"
 
@@ -55,15 +61,354 @@
 extern "C" {
 #endif
 
+extern char **environ;
+
+#define ASYNC_SYSTEM_NUM_WORKERS          4   // including the iptables worker
+#define ASYNC_SYSTEM_NUM_GENERAL_LANES   (ASYNC_SYSTEM_NUM_WORKERS - 1)
+#define ASYNC_SYSTEM_MAX_BATCH_COMMANDS 256
+#define ASYNC_SYSTEM_MAX_ARGS            64
+
+typedef struct async_system_job_s {
+  struct async_system_job_s *next;
+  task_id_t                  origin_task;
+  bool                       is_abort_on_error;
+  bool                       is_notify_on_completion;
+  bstring                    command;
+} async_system_job_t;
+
+typedef struct async_system_lane_s {
+  pthread_mutex_t            lock;
+  pthread_cond_t             cond;
+  async_system_job_t        *head;
+  async_system_job_t        *tail;
+  int                        num_workers;
+  pthread_t                  workers[1];
+} async_system_lane_t;
+
+static async_system_lane_t   xtables_lane = {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER};
+// one worker per lane, a lane is selected by the program name of the command
+static async_system_lane_t   general_lanes[ASYNC_SYSTEM_NUM_GENERAL_LANES] = {
+    [0 ... ASYNC_SYSTEM_NUM_GENERAL_LANES - 1] = {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER}};
+static volatile bool         async_system_terminate = false;
+
 //-------------------------------
 void async_system_exit (void);
 void* async_system_task (__attribute__ ((unused)) void *args_p);
 
+//------------------------------------------------------------------------------
+// Split a command line in arguments, honoring simple and double quotes.
+// Return the number of arguments, or -1 if the command needs a shell (redirections, pipes, variables, globbing...).
+static int async_system_split_command (const char * const command, char * const buf, const size_t buf_size, char *argv[], const int max_args)
+{
+  const char * p   = command;
+  size_t       len = 0;
+  int          argc = 0;
+
+  while (*p) {
+    while (isspace((unsigned char)*p)) p++;
+    if (!*p) break;
+    if ((max_args - 1) <= argc) return -1;
+    argv[argc++] = &buf[len];
+    char quote = 0;
+    while (*p && (quote || !isspace((unsigned char)*p))) {
+      if (quote) {
+        if (*p == quote) {
+          quote = 0;
+        } else if (('"' == quote) && strchr("$`\\", *p)) {
+          return -1;
+        } else {
+          buf[len++] = *p;
+        }
+      } else if (('"' == *p) || ('\'' == *p)) {
+        quote = *p;
+      } else if (strchr("|&;<>()$`\\*?[]{}~#", *p)) {
+        return -1;
+      } else {
+        buf[len++] = *p;
+      }
+      p++;
+      if (buf_size <= (len + 1)) return -1;
+    }
+    if (quote) return -1;
+    buf[len++] = '\0';
+  }
+  argv[argc] = NULL;
+  if ((0 == argc) || ('!' == argv[0][0]) || strchr(argv[0], '=')) {
+    // empty command, negation, variable assignment
+    return -1;
+  }
+  return argc;
+}
+
+//------------------------------------------------------------------------------
+static int async_system_spawn_argv (char * const argv[], const int stdin_fd)
+{
+  posix_spawn_file_actions_t  file_actions;
+  pid_t                       pid = 0;
+  int                         status = 0;
+  int                         rc = 0;
+
+  posix_spawn_file_actions_init (&file_actions);
+  if (0 <= stdin_fd) {
+    posix_spawn_file_actions_adddup2 (&file_actions, stdin_fd, STDIN_FILENO);
+  }
+  rc = posix_spawnp (&pid, argv[0], &file_actions, NULL, argv, environ);
+  posix_spawn_file_actions_destroy (&file_actions);
+  if (rc) {
+    OAILOG_ERROR (LOG_ASYNC_SYSTEM, "posix_spawn %s failed: %s\n", argv[0], strerror(rc));
+    return -1;
+  }
+  while (0 > waitpid (pid, &status, 0)) {
+    if (EINTR != errno) {
+      OAILOG_ERROR (LOG_ASYNC_SYSTEM, "waitpid %s failed: %s\n", argv[0], strerror(errno));
+      return -1;
+    }
+  }
+  if (WIFEXITED(status)) {
+    return WEXITSTATUS(status);
+  }
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+int async_system_exec (const char * const command)
+{
+  char   *argv[ASYNC_SYSTEM_MAX_ARGS];
+  size_t  buf_size = strlen(command) + 1;
+  char   *buf = malloc(buf_size);
+  int     rc = -1;
+
+  if (!buf) return -1;
+  if (0 < async_system_split_command (command, buf, buf_size, argv, ASYNC_SYSTEM_MAX_ARGS)) {
+    rc = async_system_spawn_argv (argv, -1);
+  } else {
+    char * sh_argv[] = {"/bin/sh", "-c", (char*)command, NULL};
+    rc = async_system_spawn_argv (sh_argv, -1);
+  }
+  free_wrapper((void**)&buf);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static bool async_system_is_iptables (const_bstring command)
+{
+  const char * p = bdata(command);
+  while (isspace((unsigned char)*p)) p++;
+  return ((0 == strncmp(p, "iptables", 8)) && ((0 == p[8]) || isspace((unsigned char)p[8])));
+}
+
+//------------------------------------------------------------------------------
+// Select the general lane of a command from its program name (FNV-1a of the first word), the commands of a same
+// program are run in order by the same worker.
+static async_system_lane_t * async_system_general_lane (const_bstring command)
+{
+  const char * p = bdata(command);
+  uint32_t     hash = 2166136261u;
+
+  while (isspace((unsigned char)*p)) p++;
+  while ((*p) && (!isspace((unsigned char)*p))) {
+    hash = (hash ^ (unsigned char)*p++) * 16777619u;
+  }
+  return &general_lanes[hash % ASYNC_SYSTEM_NUM_GENERAL_LANES];
+}
+
+//------------------------------------------------------------------------------
+// Translate an "iptables [-t table] <rule>" command into an iptables-restore line, return false if it cannot be batched.
+static bool async_system_iptables_2_restore_line (const_bstring command, char * table, const size_t table_size, bstring line)
+{
+  static const char * const batchable_ops[] = {"-A", "--append", "-I", "--insert", "-D", "--delete", "-R", "--replace",
+                                               "-F", "--flush", "-N", "--new-chain", "-X", "--delete-chain", "-P", "--policy", "-Z", "--zero", NULL};
+  static const char * const forbidden_opts[] = {"-L", "--list", "-S", "--list-rules", "-C", "--check", "-E", "--rename-chain",
+                                                "-w", "--wait", "-W", "--wait-interval", "-h", "--help", "-V", "--version", NULL};
+  char   *argv[ASYNC_SYSTEM_MAX_ARGS];
+  char    buf[blength(command) + 1];
+  bool    has_op = false;
+  int     argc = async_system_split_command (bdata(command), buf, sizeof(buf), argv, ASYNC_SYSTEM_MAX_ARGS);
+
+  if ((2 > argc) || strcmp(argv[0], "iptables")) return false;
+  strncpy(table, "filter", table_size);
+  btrunc(line, 0);
+  for (int i = 1; i < argc; i++) {
+    if ((!strcmp(argv[i], "-t")) || (!strcmp(argv[i], "--table"))) {
+      if (++i == argc) return false;
+      strncpy(table, argv[i], table_size - 1);
+      table[table_size - 1] = '\0';
+      continue;
+    }
+    for (int j = 0; forbidden_opts[j]; j++) {
+      if (!strcmp(argv[i], forbidden_opts[j])) return false;
+    }
+    for (int j = 0; batchable_ops[j]; j++) {
+      if (!strcmp(argv[i], batchable_ops[j])) has_op = true;
+    }
+    if (blength(line)) bconchar(line, ' ');
+    if ((!argv[i][0]) || strpbrk(argv[i], " \t")) {
+      bformata(line, "\"%s\"", argv[i]);
+    } else {
+      bcatcstr(line, argv[i]);
+    }
+  }
+  return has_op;
+}
+
+//------------------------------------------------------------------------------
+static void async_system_job_done (async_system_job_t * job, const int exit_status)
+{
+  if (exit_status) {
+    OAILOG_ERROR (LOG_ASYNC_SYSTEM, "ERROR in system command %s: %d\n", bdata(job->command), exit_status);
+    if (job->is_abort_on_error) {
+      exit (-1);              // may be not exit
+    }
+  }
+  if (job->is_notify_on_completion) {
+    MessageDef *message_p = itti_alloc_new_message_sized (TASK_ASYNC_SYSTEM, ASYNC_SYSTEM_COMMAND_RESULT, sizeof(itti_async_system_command_result_t));
+    AssertFatal (message_p , "itti_alloc_new_message Failed");
+    ASYNC_SYSTEM_COMMAND_RESULT (message_p)->system_command = job->command;
+    ASYNC_SYSTEM_COMMAND_RESULT (message_p)->exit_status    = exit_status;
+    job->command = NULL;
+    itti_send_msg_to_task (job->origin_task, INSTANCE_DEFAULT, message_p);
+  }
+  bdestroy_wrapper(&job->command);
+  free_wrapper((void**)&job);
+}
+
+//------------------------------------------------------------------------------
+static void async_system_run_job (async_system_job_t * job)
+{
+  OAILOG_DEBUG (LOG_ASYNC_SYSTEM, "spawn: %s\n", bdata(job->command));
+  async_system_job_done (job, async_system_exec (bdata(job->command)));
+}
+
+//------------------------------------------------------------------------------
+// Run consecutive batchable iptables commands of the same table in one iptables-restore --noflush.
+// The table is committed atomically, so on failure nothing was applied and the commands are replayed
+// one by one to report the faulty one(s).
+static void async_system_run_iptables_batch (async_system_job_t * jobs, const char * const table)
+{
+  char      job_table[32] = {0};
+  bstring   line  = bfromcstralloc(256, "");
+  bstring   input = bformat("*%s\n", table);
+  int       num_jobs = 0;
+  int       rc = -1;
+
+  for (async_system_job_t * job = jobs; job; job = job->next) {
+    async_system_iptables_2_restore_line (job->command, job_table, sizeof(job_table), line);
+    bconcat(input, line);
+    bconchar(input, '\n');
+    num_jobs++;
+  }
+  bcatcstr(input, "COMMIT\n");
+  bdestroy_wrapper(&line);
+
+  FILE * fp = tmpfile();
+  if ((fp) && (1 == fwrite(input->data, blength(input), 1, fp)) && (0 == fflush(fp)) && (0 == lseek(fileno(fp), 0, SEEK_SET))) {
+    char * argv[] = {"iptables-restore", "--noflush", NULL};
+    OAILOG_DEBUG (LOG_ASYNC_SYSTEM, "iptables-restore batch of %d commands:\n%s", num_jobs, bdata(input));
+    rc = async_system_spawn_argv (argv, fileno(fp));
+  }
+  if (fp) fclose(fp);
+  bdestroy_wrapper(&input);
+
+  if (rc) {
+    OAILOG_WARNING (LOG_ASYNC_SYSTEM, "iptables-restore batch of %d commands failed (%d), replaying them one by one\n", num_jobs, rc);
+  }
+  while (jobs) {
+    async_system_job_t * job = jobs;
+    jobs = jobs->next;
+    if (rc) {
+      async_system_run_job (job);
+    } else {
+      async_system_job_done (job, 0);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static async_system_job_t * async_system_lane_pop (async_system_lane_t * lane)
+{
+  async_system_job_t * job = NULL;
+  pthread_mutex_lock(&lane->lock);
+  while ((!lane->head) && (!async_system_terminate)) {
+    pthread_cond_wait(&lane->cond, &lane->lock);
+  }
+  job = lane->head;
+  if (job) {
+    lane->head = job->next;
+    if (!lane->head) lane->tail = NULL;
+    job->next = NULL;
+  }
+  pthread_mutex_unlock(&lane->lock);
+  return job;
+}
+
+//------------------------------------------------------------------------------
+static void async_system_lane_push (async_system_lane_t * lane, async_system_job_t * job)
+{
+  job->next = NULL;
+  pthread_mutex_lock(&lane->lock);
+  if (lane->tail) {
+    lane->tail->next = job;
+  } else {
+    lane->head = job;
+  }
+  lane->tail = job;
+  pthread_cond_signal(&lane->cond);
+  pthread_mutex_unlock(&lane->lock);
+}
+
+//------------------------------------------------------------------------------
+static void* async_system_general_worker (void *args_p)
+{
+  async_system_lane_t * lane = (async_system_lane_t *)args_p;
+  async_system_job_t  * job = NULL;
+  while ((job = async_system_lane_pop(lane))) {
+    async_system_run_job (job);
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void* async_system_xtables_worker (__attribute__ ((unused)) void *args_p)
+{
+  char                 table[32];
+  char                 next_table[32];
+  bstring              line = bfromcstralloc(256, "");
+  async_system_job_t * job  = NULL;
+
+  while ((job = async_system_lane_pop(&xtables_lane))) {
+    if (!async_system_iptables_2_restore_line (job->command, table, sizeof(table), line)) {
+      async_system_run_job (job);
+      continue;
+    }
+    // take the following batchable commands on the same table that were queued while the previous batch was running
+    async_system_job_t * batch_tail = job;
+    int                  num_jobs   = 1;
+    pthread_mutex_lock(&xtables_lane.lock);
+    while ((xtables_lane.head) && (ASYNC_SYSTEM_MAX_BATCH_COMMANDS > num_jobs) &&
+        (async_system_iptables_2_restore_line (xtables_lane.head->command, next_table, sizeof(next_table), line)) &&
+        (!strcmp(table, next_table))) {
+      batch_tail->next  = xtables_lane.head;
+      batch_tail        = batch_tail->next;
+      xtables_lane.head = batch_tail->next;
+      batch_tail->next  = NULL;
+      num_jobs++;
+    }
+    if (!xtables_lane.head) xtables_lane.tail = NULL;
+    pthread_mutex_unlock(&xtables_lane.lock);
+    if (1 == num_jobs) {
+      async_system_run_job (job);
+    } else {
+      async_system_run_iptables_batch (job, table);
+    }
+  }
+  bdestroy_wrapper(&line);
+  return NULL;
+}
+
 //------------------------------------------------------------------------------
 void* async_system_task (__attribute__ ((unused)) void *args_p)
 {
   MessageDef                             *received_message_p = NULL;
-  int                                     rc = 0;
 
   itti_mark_task_ready (TASK_ASYNC_SYSTEM);
 
@@ -75,17 +420,18 @@ void* async_system_task (__attribute__ ((unused)) void *args_p)
       switch (ITTI_MSG_ID (received_message_p)) {
 
       case ASYNC_SYSTEM_COMMAND:{
-          rc = 0;
-          OAILOG_DEBUG (LOG_ASYNC_SYSTEM, "C system() call: %s\n", bdata(ASYNC_SYSTEM_COMMAND (received_message_p)->system_command));
-          rc = system (bdata(ASYNC_SYSTEM_COMMAND (received_message_p)->system_command));
-
-          if (rc) {
-            OAILOG_ERROR (LOG_ASYNC_SYSTEM, "ERROR in system command %s: %d\n", bdata(ASYNC_SYSTEM_COMMAND (received_message_p)->system_command), rc);
-            if (ASYNC_SYSTEM_COMMAND (received_message_p)->is_abort_on_error) {
-              bdestroy_wrapper(&ASYNC_SYSTEM_COMMAND (received_message_p)->system_command);
-              exit (-1);              // may be not exit
-            }
-            bdestroy_wrapper(&ASYNC_SYSTEM_COMMAND (received_message_p)->system_command);
+          async_system_job_t * job = calloc(1, sizeof(async_system_job_t));
+          AssertFatal (job, "calloc failed");
+          job->origin_task             = ITTI_MSG_ORIGIN_ID (received_message_p);
+          job->is_abort_on_error       = ASYNC_SYSTEM_COMMAND (received_message_p)->is_abort_on_error;
+          job->is_notify_on_completion = ASYNC_SYSTEM_COMMAND (received_message_p)->is_notify_on_completion;
+          // steal the command string
+          job->command = ASYNC_SYSTEM_COMMAND (received_message_p)->system_command;
+          ASYNC_SYSTEM_COMMAND (received_message_p)->system_command = NULL;
+          if (async_system_is_iptables(job->command)) {
+            async_system_lane_push (&xtables_lane, job);
+          } else {
+            async_system_lane_push (async_system_general_lane(job->command), job);
           }
         }
         break;
@@ -113,6 +459,18 @@ void* async_system_task (__attribute__ ((unused)) void *args_p)
 int async_system_init (void)
 {
   OAI_FPRINTF_INFO("Initializing ASYNC_SYSTEM\n");
+  if (pthread_create (&xtables_lane.workers[0], NULL, async_system_xtables_worker, NULL)) {
+    OAILOG_ALERT (LOG_ASYNC_SYSTEM, "Initializing ASYNC_SYSTEM iptables worker: ERROR\n");
+    return RETURNerror;
+  }
+  xtables_lane.num_workers = 1;
+  for (int i = 0; i < ASYNC_SYSTEM_NUM_GENERAL_LANES; i++) {
+    if (pthread_create (&general_lanes[i].workers[0], NULL, async_system_general_worker, &general_lanes[i])) {
+      OAILOG_ALERT (LOG_ASYNC_SYSTEM, "Initializing ASYNC_SYSTEM worker %d: ERROR\n", i + 1);
+      return RETURNerror;
+    }
+    general_lanes[i].num_workers = 1;
+  }
   if (itti_create_task (TASK_ASYNC_SYSTEM, &async_system_task, NULL) < 0) {
     perror ("pthread_create");
     OAILOG_ALERT (LOG_ASYNC_SYSTEM, "Initializing ASYNC_SYSTEM task interface: ERROR\n");
@@ -123,19 +481,17 @@ int async_system_init (void)
 }
 
 //------------------------------------------------------------------------------
-int async_system_command (int sender_itti_task, bool is_abort_on_error, char *format, ...)
+static int async_system_vcommand (int sender_itti_task, bool is_abort_on_error, bool is_notify_on_completion, char *format, va_list args)
 {
-  va_list                                 args;
   int                                     rv    = 0;
   bstring                                 bstr = NULL;
-  va_start (args, format);
   bstr = bfromcstralloc(1024, " ");
   btrunc(bstr, 0);
   rv = bvcformata (bstr, 1024, format, args); // big number, see bvcformata
-  va_end (args);
 
-  if (NULL == bstr) {
+  if ((NULL == bstr) || (BSTR_ERR == rv)) {
     OAILOG_ERROR(LOG_ASYNC_SYSTEM, "Error while formatting system command");
+    bdestroy_wrapper(&bstr);
     return RETURNerror;
   }
   MessageDef                             *message_p = NULL;
@@ -143,13 +499,53 @@ int async_system_command (int sender_itti_task, bool is_abort_on_error, char *fo
   AssertFatal (message_p , "itti_alloc_new_message Failed");
   ASYNC_SYSTEM_COMMAND (message_p)->system_command = bstr;
   ASYNC_SYSTEM_COMMAND (message_p)->is_abort_on_error = is_abort_on_error;
+  ASYNC_SYSTEM_COMMAND (message_p)->is_notify_on_completion = is_notify_on_completion;
   rv = itti_send_msg_to_task (TASK_ASYNC_SYSTEM, INSTANCE_DEFAULT, message_p);
   return rv;
 }
 
+//------------------------------------------------------------------------------
+int async_system_command (int sender_itti_task, bool is_abort_on_error, char *format, ...)
+{
+  va_list                                 args;
+  int                                     rv    = 0;
+  va_start (args, format);
+  rv = async_system_vcommand (sender_itti_task, is_abort_on_error, false, format, args);
+  va_end (args);
+  return rv;
+}
+
+//------------------------------------------------------------------------------
+int async_system_command_notify (int sender_itti_task, bool is_abort_on_error, char *format, ...)
+{
+  va_list                                 args;
+  int                                     rv    = 0;
+  va_start (args, format);
+  rv = async_system_vcommand (sender_itti_task, is_abort_on_error, true, format, args);
+  va_end (args);
+  return rv;
+}
+
 //------------------------------------------------------------------------------
 void async_system_exit (void)
 {
+  async_system_lane_t * lanes[1 + ASYNC_SYSTEM_NUM_GENERAL_LANES] = {&xtables_lane};
+
+  for (int l = 0; l < ASYNC_SYSTEM_NUM_GENERAL_LANES; l++) {
+    lanes[1 + l] = &general_lanes[l];
+  }
+  async_system_terminate = true;
+  for (int l = 0; l < (1 + ASYNC_SYSTEM_NUM_GENERAL_LANES); l++) {
+    pthread_mutex_lock(&lanes[l]->lock);
+    pthread_cond_broadcast(&lanes[l]->cond);
+    pthread_mutex_unlock(&lanes[l]->lock);
+  }
+  for (int l = 0; l < (1 + ASYNC_SYSTEM_NUM_GENERAL_LANES); l++) {
+    for (int i = 0; i < lanes[l]->num_workers; i++) {
+      pthread_join(lanes[l]->workers[i], NULL);
+    }
+    lanes[l]->num_workers = 0;
+  }
   OAI_FPRINTF_INFO("TASK_ASYNC_SYSTEM terminated");
 }
 
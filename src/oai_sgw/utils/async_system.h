@@ -36,7 +36,16 @@ extern "C" {
 #endif
 
 int async_system_init (void);
+/* Queue a command to be run by a worker of TASK_ASYNC_SYSTEM and return without waiting for it.
+ * Ordering: the commands of a same program (first word of the command: "ip", "iptables", ...) are run one at a time,
+ * in the order they were requested; commands of different programs may run concurrently and complete in any order.
+ * The ordering is the one of the requests received by TASK_ASYNC_SYSTEM, so it holds for the commands of a same
+ * sender task. */
 int async_system_command (int sender_itti_task, bool is_abort_on_error, char *format, ...);
+/* Same as async_system_command, ASYNC_SYSTEM_COMMAND_RESULT is sent back to sender_itti_task when the command completes. */
+int async_system_command_notify (int sender_itti_task, bool is_abort_on_error, char *format, ...);
+/* Run a command synchronously in the calling thread, without shell if not needed. Return the exit code of the command, -1 on failure. */
+int async_system_exec (const char * const command);
 
 #ifdef __cplusplus
 }
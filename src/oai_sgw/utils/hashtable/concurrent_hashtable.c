@@ -0,0 +1,623 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+/*! \file concurrent_hashtable.c
+  \brief Concurrent hash map with lock free readers, striped writer locks and incremental resize.
+*/
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "bstrlib.h"
+
+#include "assertions.h"
+#include "concurrent_hashtable.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// number of buckets of the previous array migrated by a writer, in addition to its own bucket
+#define CONCURRENT_HASHTABLE_MIGRATE_PER_WRITE  4
+// retired memory is reclaimed every CONCURRENT_HASHTABLE_EBR_COLLECT_PERIOD retirements
+#define CONCURRENT_HASHTABLE_EBR_COLLECT_PERIOD 128
+
+// wyhash constants
+#define CHT_P0 0xa0761d6478bd642full
+#define CHT_P1 0xe7037ed1a0b428dbull
+#define CHT_P2 0x8ebc6af09c88c6e3ull
+#define CHT_P3 0x589965cc75374cc3ull
+
+// bucket head of a migrated bucket in the previous array
+static concurrent_hashtable_node_t      cht_migrated_sentinel;
+#define CHT_MIGRATED (&cht_migrated_sentinel)
+
+//------------------------------------------------------------------------------
+// Epoch based reclamation
+// A thread accessing a table publishes the global epoch it observed in its slot (0 when outside).
+// The global epoch can only advance when all threads inside observed it, memory retired at epoch e
+// is freed when the global epoch reaches e+2: no thread can still hold a reference to it.
+//------------------------------------------------------------------------------
+typedef struct cht_ebr_slot_s {
+  volatile uint64_t                       epoch;
+  volatile int                            in_use;
+} __attribute__ ((aligned (64))) cht_ebr_slot_t;
+
+typedef struct cht_ebr_retired_s {
+  void                                   *ptr;
+  uint64_t                                epoch;
+  struct cht_ebr_retired_s               *next;
+} cht_ebr_retired_t;
+
+static cht_ebr_slot_t                     cht_ebr_slots[CONCURRENT_HASHTABLE_EBR_MAX_THREADS];
+static volatile int                       cht_ebr_num_slots = 0;
+static volatile uint64_t                  cht_ebr_epoch     = 1;
+static __thread int                       cht_ebr_slot_index = -1;
+static __thread int                       cht_ebr_nesting    = 0;
+static pthread_once_t                     cht_once = PTHREAD_ONCE_INIT;
+static pthread_key_t                      cht_ebr_thread_key;
+static pthread_mutex_t                    cht_ebr_retired_mutex = PTHREAD_MUTEX_INITIALIZER;
+static cht_ebr_retired_t                 *cht_ebr_retired = NULL;
+static uint64_t                           cht_ebr_num_retired = 0;
+static uint64_t                           cht_process_seed = 0;
+static volatile uint64_t                  cht_seed_counter = 0;
+
+//------------------------------------------------------------------------------
+static inline uint64_t cht_mix (const uint64_t a, const uint64_t b)
+{
+  const __uint128_t                       r = (__uint128_t)a * b;
+
+  return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+//------------------------------------------------------------------------------
+static void cht_ebr_thread_exit (void * arg)
+{
+  if (0 <= cht_ebr_slot_index) {
+    __atomic_store_n (&cht_ebr_slots[cht_ebr_slot_index].epoch, 0, __ATOMIC_RELEASE);
+    __atomic_store_n (&cht_ebr_slots[cht_ebr_slot_index].in_use, 0, __ATOMIC_RELEASE);
+    cht_ebr_slot_index = -1;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void cht_once_init (void)
+{
+  struct timespec                         ts = {0};
+  int                                     fd = open ("/dev/urandom", O_RDONLY);
+
+  pthread_key_create (&cht_ebr_thread_key, cht_ebr_thread_exit);
+  if ((0 > fd) || (sizeof (cht_process_seed) != read (fd, &cht_process_seed, sizeof (cht_process_seed)))) {
+    clock_gettime (CLOCK_REALTIME, &ts);
+    cht_process_seed = cht_mix ((uint64_t)ts.tv_sec ^ CHT_P0, (uint64_t)ts.tv_nsec ^ ((uint64_t)getpid () << 32) ^ CHT_P1);
+  }
+  if (0 <= fd) close (fd);
+}
+
+//------------------------------------------------------------------------------
+static void cht_ebr_register (void)
+{
+  for (int i = 0; i < CONCURRENT_HASHTABLE_EBR_MAX_THREADS; i++) {
+    int                                   expected = 0;
+
+    if (__atomic_compare_exchange_n (&cht_ebr_slots[i].in_use, &expected, 1, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+      int                                 num_slots = __atomic_load_n (&cht_ebr_num_slots, __ATOMIC_RELAXED);
+
+      while ((num_slots <= i) &&
+             (!__atomic_compare_exchange_n (&cht_ebr_num_slots, &num_slots, i + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)));
+      cht_ebr_slot_index = i;
+      pthread_once (&cht_once, cht_once_init);
+      pthread_setspecific (cht_ebr_thread_key, &cht_ebr_slots[i]);
+      return;
+    }
+  }
+  AssertFatal (0, "More than %d threads accessing concurrent hashtables\n", CONCURRENT_HASHTABLE_EBR_MAX_THREADS);
+}
+
+//------------------------------------------------------------------------------
+static inline void cht_ebr_enter (void)
+{
+  if (0 == cht_ebr_nesting++) {
+    if (0 > cht_ebr_slot_index) {
+      cht_ebr_register ();
+    }
+    __atomic_store_n (&cht_ebr_slots[cht_ebr_slot_index].epoch, __atomic_load_n (&cht_ebr_epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+    __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  }
+}
+
+//------------------------------------------------------------------------------
+static inline void cht_ebr_exit (void)
+{
+  if (0 == --cht_ebr_nesting) {
+    __atomic_store_n (&cht_ebr_slots[cht_ebr_slot_index].epoch, 0, __ATOMIC_RELEASE);
+  }
+}
+
+//------------------------------------------------------------------------------
+// cht_ebr_retired_mutex must be locked
+static void cht_ebr_collect (void)
+{
+  uint64_t                                epoch = __atomic_load_n (&cht_ebr_epoch, __ATOMIC_SEQ_CST);
+  const int                               num_slots = __atomic_load_n (&cht_ebr_num_slots, __ATOMIC_ACQUIRE);
+  bool                                    advance = true;
+  cht_ebr_retired_t                     **pp = &cht_ebr_retired;
+
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  for (int i = 0; (i < num_slots) && (advance); i++) {
+    const uint64_t                        slot_epoch = __atomic_load_n (&cht_ebr_slots[i].epoch, __ATOMIC_SEQ_CST);
+
+    advance = ((0 == slot_epoch) || (epoch == slot_epoch));
+  }
+  if (advance) {
+    __atomic_compare_exchange_n (&cht_ebr_epoch, &epoch, epoch + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    epoch = __atomic_load_n (&cht_ebr_epoch, __ATOMIC_SEQ_CST);
+  }
+  while (*pp) {
+    cht_ebr_retired_t                    *retired = *pp;
+
+    if ((retired->epoch + 2) <= epoch) {
+      *pp = retired->next;
+      free (retired->ptr);
+      free (retired);
+      cht_ebr_num_retired--;
+    } else {
+      pp = &retired->next;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// ptr is no longer reachable from the table, free it when no reader can still access it
+static void cht_ebr_retire (void * ptr)
+{
+  cht_ebr_retired_t                      *retired = malloc (sizeof (cht_ebr_retired_t));
+
+  AssertFatal (retired, "Out of memory\n");
+  retired->ptr   = ptr;
+  retired->epoch = __atomic_load_n (&cht_ebr_epoch, __ATOMIC_SEQ_CST);
+  pthread_mutex_lock (&cht_ebr_retired_mutex);
+  retired->next = cht_ebr_retired;
+  cht_ebr_retired = retired;
+  if (0 == (++cht_ebr_num_retired % CONCURRENT_HASHTABLE_EBR_COLLECT_PERIOD)) {
+    cht_ebr_collect ();
+  }
+  pthread_mutex_unlock (&cht_ebr_retired_mutex);
+}
+
+//------------------------------------------------------------------------------
+static concurrent_hashtable_buckets_t * cht_buckets_alloc (const uint64_t size)
+{
+  concurrent_hashtable_buckets_t         *buckets = calloc (1, sizeof (concurrent_hashtable_buckets_t) + size * sizeof (concurrent_hashtable_node_t *));
+
+  if (buckets) {
+    buckets->size = size;
+    buckets->mask = size - 1;
+  }
+  return buckets;
+}
+
+//------------------------------------------------------------------------------
+static uint64_t cht_size (const uint64_t size)
+{
+  uint64_t                                s = CONCURRENT_HASHTABLE_NUM_STRIPES;
+
+  while (s < size) s <<= 1;
+  return s;
+}
+
+//------------------------------------------------------------------------------
+static inline bool cht_node_match (const concurrent_hashtable_t * const table, const concurrent_hashtable_node_t * const node,
+    const uint64_t hash, const uint64_t key, const void * const obj_key, const int obj_key_size)
+{
+  if (node->hash != hash) {
+    return false;
+  }
+  if (table->obj_keys) {
+    return ((node->obj_key_size == obj_key_size) && (!memcmp (node->obj_key, obj_key, obj_key_size)));
+  }
+  return (node->key == key);
+}
+
+//------------------------------------------------------------------------------
+int concurrent_hashtable_init (concurrent_hashtable_t * const table, const uint64_t size, const bool obj_keys)
+{
+  pthread_mutexattr_t                     attr;
+
+  pthread_once (&cht_once, cht_once_init);
+  memset (table, 0, sizeof (*table));
+  table->obj_keys = obj_keys;
+  table->seed     = cht_mix (cht_process_seed ^ CHT_P2, __atomic_add_fetch (&cht_seed_counter, CHT_P3, __ATOMIC_RELAXED));
+  if (!(table->current = cht_buckets_alloc (cht_size (size)))) {
+    return -1;
+  }
+  pthread_mutex_init (&table->resize_mutex, NULL);
+  pthread_mutexattr_init (&attr);
+  pthread_mutexattr_settype (&attr, PTHREAD_MUTEX_RECURSIVE);
+  for (int i = 0; i < CONCURRENT_HASHTABLE_NUM_STRIPES; i++) {
+    pthread_mutex_init (&table->stripes[i], &attr);
+  }
+  pthread_mutexattr_destroy (&attr);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static void cht_buckets_destroy (concurrent_hashtable_buckets_t * const buckets, void (*value_free_func)(uint64_t value, void * arg), void * arg)
+{
+  for (uint64_t i = 0; i < buckets->size; i++) {
+    concurrent_hashtable_node_t          *node = buckets->heads[i];
+
+    if (CHT_MIGRATED == node) continue;
+    while (node) {
+      concurrent_hashtable_node_t        *next = node->next;
+
+      if (value_free_func) value_free_func (node->value, arg);
+      free (node);
+      node = next;
+    }
+  }
+  free (buckets);
+}
+
+//------------------------------------------------------------------------------
+void concurrent_hashtable_destroy (concurrent_hashtable_t * const table, void (*value_free_func)(uint64_t value, void * arg), void * arg)
+{
+  if (table->previous) {
+    cht_buckets_destroy (table->previous, value_free_func, arg);
+    table->previous = NULL;
+  }
+  if (table->current) {
+    cht_buckets_destroy (table->current, value_free_func, arg);
+    table->current = NULL;
+  }
+  table->num_elements = 0;
+  pthread_mutex_destroy (&table->resize_mutex);
+  for (int i = 0; i < CONCURRENT_HASHTABLE_NUM_STRIPES; i++) {
+    pthread_mutex_destroy (&table->stripes[i]);
+  }
+}
+
+//------------------------------------------------------------------------------
+uint64_t concurrent_hashtable_hash_key (const concurrent_hashtable_t * const table, const uint64_t key)
+{
+  return cht_mix (cht_mix (key ^ CHT_P0, table->seed ^ CHT_P1) ^ CHT_P2, sizeof (key) ^ CHT_P3);
+}
+
+//------------------------------------------------------------------------------
+uint64_t concurrent_hashtable_hash_obj_key (const concurrent_hashtable_t * const table, const void * const key, const int key_size)
+{
+  const uint8_t                          *p = (const uint8_t *)key;
+  int                                     n = key_size;
+  uint64_t                                h = table->seed ^ CHT_P0;
+  uint64_t                                a = 0, b = 0;
+
+  while (n > 16) {
+    memcpy (&a, p, 8);
+    memcpy (&b, p + 8, 8);
+    h = cht_mix (a ^ CHT_P1, b ^ h);
+    p += 16;
+    n -= 16;
+  }
+  a = 0;
+  b = 0;
+  if (n > 8) {
+    memcpy (&a, p, 8);
+    memcpy (&b, p + 8, n - 8);
+  } else if (n > 0) {
+    memcpy (&a, p, n);
+  }
+  h = cht_mix (a ^ CHT_P1, b ^ h);
+  return cht_mix (h ^ CHT_P2, (uint64_t)key_size ^ CHT_P3);
+}
+
+//------------------------------------------------------------------------------
+bool concurrent_hashtable_get (concurrent_hashtable_t * const table, const uint64_t hash, const uint64_t key,
+    const void * const obj_key, const int obj_key_size, uint64_t * const value)
+{
+  concurrent_hashtable_node_t            *node = NULL;
+
+  cht_ebr_enter ();
+  for (;;) {
+    concurrent_hashtable_buckets_t * const current  = __atomic_load_n (&table->current, __ATOMIC_ACQUIRE);
+    concurrent_hashtable_buckets_t * const previous = __atomic_load_n (&table->previous, __ATOMIC_ACQUIRE);
+
+    // a bucket not yet migrated is the reference
+    if ((previous) && (previous != current)) {
+      node = __atomic_load_n (&previous->heads[hash & previous->mask], __ATOMIC_ACQUIRE);
+      if (CHT_MIGRATED != node) break;
+    }
+    node = __atomic_load_n (&current->heads[hash & current->mask], __ATOMIC_ACQUIRE);
+    // else current became previous of a new resize and this bucket has been migrated, retry
+    if (CHT_MIGRATED != node) break;
+  }
+  for (; node; node = __atomic_load_n (&node->next, __ATOMIC_ACQUIRE)) {
+    if (cht_node_match (table, node, hash, key, obj_key, obj_key_size)) {
+      if (value) *value = __atomic_load_n (&node->value, __ATOMIC_ACQUIRE);
+      cht_ebr_exit ();
+      return true;
+    }
+  }
+  cht_ebr_exit ();
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Copy the nodes of bucket index of previous in current, bucket lock must be held
+static void cht_migrate_bucket_locked (concurrent_hashtable_t * const table, concurrent_hashtable_buckets_t * const previous,
+    concurrent_hashtable_buckets_t * const current, const uint64_t index)
+{
+  concurrent_hashtable_node_t            *node = __atomic_load_n (&previous->heads[index], __ATOMIC_ACQUIRE);
+  concurrent_hashtable_node_t            *head = node;
+
+  if (CHT_MIGRATED == node) {
+    return;
+  }
+  for (; node; node = node->next) {
+    const size_t                          node_size = sizeof (concurrent_hashtable_node_t) + ((table->obj_keys) ? node->obj_key_size : 0);
+    concurrent_hashtable_node_t          *copy = malloc (node_size);
+    concurrent_hashtable_node_t * volatile * const bucket = &current->heads[node->hash & current->mask];
+
+    AssertFatal (copy, "Out of memory\n");
+    memcpy (copy, node, node_size);
+    copy->next = *bucket;
+    __atomic_store_n (bucket, copy, __ATOMIC_RELEASE);
+  }
+  __atomic_store_n (&previous->heads[index], CHT_MIGRATED, __ATOMIC_RELEASE);
+  while (head) {
+    concurrent_hashtable_node_t          *next = head->next;
+
+    cht_ebr_retire (head);
+    head = next;
+  }
+  if (__atomic_add_fetch (&table->migrated, 1, __ATOMIC_ACQ_REL) == previous->size) {
+    __atomic_store_n (&table->previous, NULL, __ATOMIC_RELEASE);
+    cht_ebr_retire (previous);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Migrate the remaining buckets of the resize in progress, if any
+static void cht_finish_migration (concurrent_hashtable_t * const table)
+{
+  concurrent_hashtable_buckets_t * const previous = __atomic_load_n (&table->previous, __ATOMIC_ACQUIRE);
+
+  if (!previous) {
+    return;
+  }
+  for (uint64_t i = 0; i < previous->size; i++) {
+    pthread_mutex_t * const               lock = &table->stripes[i & (CONCURRENT_HASHTABLE_NUM_STRIPES - 1)];
+
+    pthread_mutex_lock (lock);
+    if (__atomic_load_n (&table->previous, __ATOMIC_ACQUIRE) != previous) {
+      pthread_mutex_unlock (lock);
+      return;
+    }
+    cht_migrate_bucket_locked (table, previous, __atomic_load_n (&table->current, __ATOMIC_ACQUIRE), i);
+    pthread_mutex_unlock (lock);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void cht_help_migration (concurrent_hashtable_t * const table)
+{
+  for (int k = 0; k < CONCURRENT_HASHTABLE_MIGRATE_PER_WRITE; k++) {
+    concurrent_hashtable_buckets_t * const previous = __atomic_load_n (&table->previous, __ATOMIC_ACQUIRE);
+
+    if (!previous) {
+      return;
+    }
+    const uint64_t                        i = __atomic_fetch_add (&table->migrate_cursor, 1, __ATOMIC_RELAXED);
+
+    if (i >= previous->size) {
+      // all buckets claimed, some claims may have been lost on a stale previous array
+      if (0 == pthread_mutex_trylock (&table->resize_mutex)) {
+        cht_finish_migration (table);
+        pthread_mutex_unlock (&table->resize_mutex);
+      }
+      return;
+    }
+    pthread_mutex_t * const               lock = &table->stripes[i & (CONCURRENT_HASHTABLE_NUM_STRIPES - 1)];
+
+    pthread_mutex_lock (lock);
+    if (__atomic_load_n (&table->previous, __ATOMIC_ACQUIRE) == previous) {
+      cht_migrate_bucket_locked (table, previous, __atomic_load_n (&table->current, __ATOMIC_ACQUIRE), i);
+    }
+    pthread_mutex_unlock (lock);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Publish a new bucket array, the migration is done by the next writers
+static void cht_start_resize (concurrent_hashtable_t * const table, const uint64_t size)
+{
+  if (pthread_mutex_trylock (&table->resize_mutex)) {
+    return;
+  }
+  concurrent_hashtable_buckets_t * const current = __atomic_load_n (&table->current, __ATOMIC_ACQUIRE);
+
+  if ((!__atomic_load_n (&table->previous, __ATOMIC_ACQUIRE)) && (current->size < size)) {
+    concurrent_hashtable_buckets_t * const buckets = cht_buckets_alloc (size);
+
+    if (buckets) {
+      __atomic_store_n (&table->migrate_cursor, 0, __ATOMIC_RELAXED);
+      __atomic_store_n (&table->migrated, 0, __ATOMIC_RELAXED);
+      // previous before current: a reader seeing the new current sees the previous array
+      __atomic_store_n (&table->previous, current, __ATOMIC_RELEASE);
+      __atomic_store_n (&table->current, buckets, __ATOMIC_RELEASE);
+    }
+  }
+  pthread_mutex_unlock (&table->resize_mutex);
+}
+
+//------------------------------------------------------------------------------
+void concurrent_hashtable_write_begin (concurrent_hashtable_t * const table, const uint64_t hash, concurrent_hashtable_writer_t * const writer)
+{
+  cht_ebr_enter ();
+  writer->table = table;
+  writer->hash  = hash;
+  writer->lock  = &table->stripes[hash & (CONCURRENT_HASHTABLE_NUM_STRIPES - 1)];
+  for (;;) {
+    pthread_mutex_lock (writer->lock);
+    // current before previous, see cht_start_resize()
+    concurrent_hashtable_buckets_t * const current  = __atomic_load_n (&table->current, __ATOMIC_ACQUIRE);
+    concurrent_hashtable_buckets_t * const previous = __atomic_load_n (&table->previous, __ATOMIC_ACQUIRE);
+
+    if ((previous) && (previous != current)) {
+      cht_migrate_bucket_locked (table, previous, current, hash & previous->mask);
+    }
+    writer->head = &current->heads[hash & current->mask];
+    if (CHT_MIGRATED != __atomic_load_n (writer->head, __ATOMIC_ACQUIRE)) {
+      return;
+    }
+    pthread_mutex_unlock (writer->lock);
+  }
+}
+
+//------------------------------------------------------------------------------
+concurrent_hashtable_node_t *concurrent_hashtable_find_locked (const concurrent_hashtable_writer_t * const writer, const uint64_t key,
+    const void * const obj_key, const int obj_key_size)
+{
+  for (concurrent_hashtable_node_t *node = *writer->head; node; node = node->next) {
+    if (cht_node_match (writer->table, node, writer->hash, key, obj_key, obj_key_size)) {
+      return node;
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+concurrent_hashtable_node_t *concurrent_hashtable_link_locked (concurrent_hashtable_writer_t * const writer, const uint64_t key,
+    const void * const obj_key, const int obj_key_size, const uint64_t value)
+{
+  concurrent_hashtable_node_t            *node = malloc (sizeof (concurrent_hashtable_node_t) + ((writer->table->obj_keys) ? obj_key_size : 0));
+
+  if (!node) {
+    return NULL;
+  }
+  node->hash         = writer->hash;
+  node->key          = key;
+  node->value        = value;
+  node->obj_key_size = (writer->table->obj_keys) ? obj_key_size : 0;
+  if (writer->table->obj_keys) {
+    memcpy (node->obj_key, obj_key, obj_key_size);
+  }
+  node->next = *writer->head;
+  __atomic_store_n (writer->head, node, __ATOMIC_RELEASE);
+  __atomic_add_fetch (&writer->table->num_elements, 1, __ATOMIC_RELAXED);
+  return node;
+}
+
+//------------------------------------------------------------------------------
+void concurrent_hashtable_unlink_locked (concurrent_hashtable_writer_t * const writer, concurrent_hashtable_node_t * const node)
+{
+  concurrent_hashtable_node_t * volatile *pp = writer->head;
+
+  while ((*pp) && (*pp != node)) {
+    pp = &(*pp)->next;
+  }
+  if (*pp) {
+    __atomic_store_n (pp, node->next, __ATOMIC_RELEASE);
+    __atomic_sub_fetch (&writer->table->num_elements, 1, __ATOMIC_RELAXED);
+    cht_ebr_retire (node);
+  }
+}
+
+//------------------------------------------------------------------------------
+void concurrent_hashtable_set_value_locked (concurrent_hashtable_node_t * const node, const uint64_t value)
+{
+  __atomic_store_n (&node->value, value, __ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+void concurrent_hashtable_write_end (concurrent_hashtable_writer_t * const writer)
+{
+  concurrent_hashtable_t * const          table = writer->table;
+
+  pthread_mutex_unlock (writer->lock);
+  if (__atomic_load_n (&table->previous, __ATOMIC_ACQUIRE)) {
+    cht_help_migration (table);
+  } else {
+    concurrent_hashtable_buckets_t * const current = __atomic_load_n (&table->current, __ATOMIC_ACQUIRE);
+
+    if (__atomic_load_n (&table->num_elements, __ATOMIC_RELAXED) > current->size) {
+      cht_start_resize (table, current->size << 1);
+    }
+  }
+  cht_ebr_exit ();
+}
+
+//------------------------------------------------------------------------------
+void concurrent_hashtable_iterate (concurrent_hashtable_t * const table, bool (*callback)(concurrent_hashtable_node_t * const node, void * arg), void * arg)
+{
+  cht_ebr_enter ();
+  // no resize can start while iterating
+  pthread_mutex_lock (&table->resize_mutex);
+  cht_finish_migration (table);
+
+  concurrent_hashtable_buckets_t * const  current = __atomic_load_n (&table->current, __ATOMIC_ACQUIRE);
+  bool                                    stop = false;
+
+  for (uint64_t i = 0; (i < current->size) && (!stop); i++) {
+    pthread_mutex_t * const               lock = &table->stripes[i & (CONCURRENT_HASHTABLE_NUM_STRIPES - 1)];
+    concurrent_hashtable_node_t          *node = NULL;
+
+    pthread_mutex_lock (lock);
+    node = __atomic_load_n (&current->heads[i], __ATOMIC_ACQUIRE);
+    while ((node) && (!stop)) {
+      // the callback may unlink the node (not freed before cht_ebr_exit())
+      concurrent_hashtable_node_t        *next = __atomic_load_n (&node->next, __ATOMIC_ACQUIRE);
+
+      stop = callback (node, arg);
+      node = next;
+    }
+    pthread_mutex_unlock (lock);
+  }
+  pthread_mutex_unlock (&table->resize_mutex);
+  cht_ebr_exit ();
+}
+
+//------------------------------------------------------------------------------
+int concurrent_hashtable_reserve (concurrent_hashtable_t * const table, const uint64_t size)
+{
+  cht_ebr_enter ();
+  pthread_mutex_lock (&table->resize_mutex);
+  cht_finish_migration (table);
+  pthread_mutex_unlock (&table->resize_mutex);
+  cht_start_resize (table, cht_size (size));
+  cht_ebr_exit ();
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+uint64_t concurrent_hashtable_num_elements (const concurrent_hashtable_t * const table)
+{
+  return __atomic_load_n (&table->num_elements, __ATOMIC_RELAXED);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file concurrent_hashtable.h
+  \brief Concurrent hash map used by the thread safe hashtables (hashtable_ts_*, hashtable_uint64_ts_*, obj_hashtable_ts_*, obj_hashtable_uint64_ts_*).
+  Readers (get, is_key_exists) take no lock: nodes and bucket arrays are reclaimed with epoch based reclamation.
+  Writers take one of CONCURRENT_HASHTABLE_NUM_STRIPES recursive locks, selected by the low bits of the hash.
+  The table doubles when the load factor exceeds 1, buckets are migrated incrementally by the writers (no stop the world).
+  Keys are hashed with a per table random seed (wyhash style multiply-xor mixing), on top of the user hash function if any.
+*/
+
+#ifndef FILE_CONCURRENT_HASHTABLE_SEEN
+#define FILE_CONCURRENT_HASHTABLE_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONCURRENT_HASHTABLE_NUM_STRIPES   64   /* power of 2, also the minimal number of buckets */
+#define CONCURRENT_HASHTABLE_EBR_MAX_THREADS 1024
+
+typedef struct concurrent_hashtable_node_s {
+  struct concurrent_hashtable_node_s * volatile next;
+  uint64_t                            hash;       /* seeded hash, also used to migrate without hashing again */
+  uint64_t                            key;        /* integer key */
+  volatile uint64_t                   value;      /* pointer or uint64_t data */
+  int                                 obj_key_size;
+  uint8_t                             obj_key[]; /* object key, copied at insertion */
+} concurrent_hashtable_node_t;
+
+typedef struct concurrent_hashtable_buckets_s {
+  uint64_t                            size;
+  uint64_t                            mask;
+  concurrent_hashtable_node_t * volatile heads[];
+} concurrent_hashtable_buckets_t;
+
+typedef struct concurrent_hashtable_s {
+  concurrent_hashtable_buckets_t * volatile current;
+  concurrent_hashtable_buckets_t * volatile previous;   /* being migrated to current, NULL if no resize in progress */
+  volatile uint64_t                   migrate_cursor;
+  volatile uint64_t                   migrated;
+  volatile uint64_t                   num_elements;
+  uint64_t                            seed;
+  bool                                obj_keys;
+  pthread_mutex_t                     resize_mutex;
+  pthread_mutex_t                     stripes[CONCURRENT_HASHTABLE_NUM_STRIPES];
+} concurrent_hashtable_t;
+
+/* Write access to the bucket of a hash, see concurrent_hashtable_write_begin() */
+typedef struct concurrent_hashtable_writer_s {
+  concurrent_hashtable_t             *table;
+  uint64_t                            hash;
+  concurrent_hashtable_node_t * volatile *head;
+  pthread_mutex_t                    *lock;
+} concurrent_hashtable_writer_t;
+
+int      concurrent_hashtable_init (concurrent_hashtable_t * const table, const uint64_t size, const bool obj_keys);
+/* Not thread safe, value_free_func is called on each value */
+void     concurrent_hashtable_destroy (concurrent_hashtable_t * const table, void (*value_free_func)(uint64_t value, void * arg), void * arg);
+
+uint64_t concurrent_hashtable_hash_key (const concurrent_hashtable_t * const table, const uint64_t key) __attribute__ ((hot));
+uint64_t concurrent_hashtable_hash_obj_key (const concurrent_hashtable_t * const table, const void * const key, const int key_size) __attribute__ ((hot));
+
+/* Lock free lookup, return false if not found */
+bool     concurrent_hashtable_get (concurrent_hashtable_t * const table, const uint64_t hash, const uint64_t key,
+                                   const void * const obj_key, const int obj_key_size, uint64_t * const value) __attribute__ ((hot));
+
+/*
+ * Writers: write_begin() locks the bucket of the hash (migrating it first if a resize is in progress),
+ * then find/link/unlink/set_value can be called until write_end(). Locks are recursive.
+ */
+void     concurrent_hashtable_write_begin (concurrent_hashtable_t * const table, const uint64_t hash, concurrent_hashtable_writer_t * const writer);
+concurrent_hashtable_node_t *concurrent_hashtable_find_locked (const concurrent_hashtable_writer_t * const writer, const uint64_t key,
+                                   const void * const obj_key, const int obj_key_size);
+concurrent_hashtable_node_t *concurrent_hashtable_link_locked (concurrent_hashtable_writer_t * const writer, const uint64_t key,
+                                   const void * const obj_key, const int obj_key_size, const uint64_t value);
+void     concurrent_hashtable_unlink_locked (concurrent_hashtable_writer_t * const writer, concurrent_hashtable_node_t * const node);
+void     concurrent_hashtable_set_value_locked (concurrent_hashtable_node_t * const node, const uint64_t value);
+void     concurrent_hashtable_write_end (concurrent_hashtable_writer_t * const writer);
+
+/*
+ * Walk all entries, the bucket being walked is locked (a callback may modify the table).
+ * Stop when the callback returns true.
+ */
+void     concurrent_hashtable_iterate (concurrent_hashtable_t * const table, bool (*callback)(concurrent_hashtable_node_t * const node, void * arg), void * arg);
+
+/* Grow to at least size buckets, incrementally */
+int      concurrent_hashtable_reserve (concurrent_hashtable_t * const table, const uint64_t size);
+
+uint64_t concurrent_hashtable_num_elements (const concurrent_hashtable_t * const table);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FILE_CONCURRENT_HASHTABLE_SEEN */
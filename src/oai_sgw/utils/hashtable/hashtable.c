@@ -184,6 +184,94 @@ hashtable_create (
   return hashtbl;
 }
 
+//------------------------------------------------------------------------------
+/*
+   Thread safe hash tables are backed by a concurrent_hashtable_t: the user hash function (identity by default) result
+   is mixed with a per table random seed, lookups are lock free and the table grows incrementally when the
+   number of elements exceeds the number of buckets.
+*/
+static inline uint64_t hashtable_ts_hash (const hash_table_ts_t * const hashtblP, const hash_key_t keyP)
+{
+  return concurrent_hashtable_hash_key (&hashtblP->map, hashtblP->hashfunc (keyP));
+}
+
+//------------------------------------------------------------------------------
+static void hashtable_ts_free_value (uint64_t value, void * arg)
+{
+  hash_table_ts_t                        *hashtblP = (hash_table_ts_t *)arg;
+  void                                   *data = (void *)(uintptr_t)value;
+
+  if (data) {
+    hashtblP->freefunc (&data);
+  }
+}
+
+typedef struct hashtable_ts_iterate_arg_s {
+  hash_table_ts_t                        *hashtbl;
+  bool                                  (*funct_cb)(const hash_key_t keyP, void * const dataP, void *parameterP, void ** resultP);
+  void                                   *parameter;
+  void                                  **result;
+  hashtable_key_array_t                  *ka;
+  hashtable_element_array_t              *ea;
+  int                                     capacity;
+  bstring                                 str;
+} hashtable_ts_iterate_arg_t;
+
+//------------------------------------------------------------------------------
+static bool hashtable_ts_get_keys_cb (concurrent_hashtable_node_t * const node, void * arg)
+{
+  hashtable_ts_iterate_arg_t             *iarg = (hashtable_ts_iterate_arg_t *)arg;
+
+  if (iarg->ka->num_keys == iarg->capacity) {
+    hash_key_t                           *keys = realloc (iarg->ka->keys, 2 * iarg->capacity * sizeof (hash_key_t));
+
+    if (!keys) return true;
+    iarg->ka->keys = keys;
+    iarg->capacity *= 2;
+  }
+  iarg->ka->keys[iarg->ka->num_keys++] = node->key;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static bool hashtable_ts_get_elements_cb (concurrent_hashtable_node_t * const node, void * arg)
+{
+  hashtable_ts_iterate_arg_t             *iarg = (hashtable_ts_iterate_arg_t *)arg;
+
+  if (iarg->ea->num_elements == iarg->capacity) {
+    void                                **elements = realloc (iarg->ea->elements, 2 * iarg->capacity * sizeof (void *));
+
+    if (!elements) return true;
+    iarg->ea->elements = elements;
+    iarg->capacity *= 2;
+  }
+  iarg->ea->elements[iarg->ea->num_elements++] = (void *)(uintptr_t)node->value;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static bool hashtable_ts_apply_callback_cb (concurrent_hashtable_node_t * const node, void * arg)
+{
+  hashtable_ts_iterate_arg_t             *iarg = (hashtable_ts_iterate_arg_t *)arg;
+
+  return iarg->funct_cb (node->key, (void *)(uintptr_t)node->value, iarg->parameter, iarg->result);
+}
+
+//------------------------------------------------------------------------------
+static bool hashtable_ts_dump_content_cb (concurrent_hashtable_node_t * const node, void * arg)
+{
+  hashtable_ts_iterate_arg_t             *iarg = (hashtable_ts_iterate_arg_t *)arg;
+  bstring                                 b0 = bformat ("Key 0x%"PRIx64" Element %p Node %p Next %p\n", node->key, (void *)(uintptr_t)node->value, node, node->next);
+
+  if (!b0) {
+    PRINT_HASHTABLE (iarg->hashtbl, "Error while dumping hashtable content");
+  } else {
+    bconcat(iarg->str, b0);
+    bdestroy_wrapper (&b0);
+  }
+  return false;
+}
+
 //------------------------------------------------------------------------------
 /*
    Initialization
@@ -197,46 +285,12 @@ hash_table_ts_t * hashtable_ts_init (hash_table_ts_t * const hashtblP,
     void (*freefuncP) (void **),
     bstring display_name_pP)
 {
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
   memset(hashtblP, 0, sizeof(*hashtblP));
 
-  if (!(hashtblP->nodes = calloc (size, sizeof (hash_node_t *)))) {
-    free_wrapper ((void**)&hashtblP);
+  if (concurrent_hashtable_init (&hashtblP->map, sizeP, false)) {
     return NULL;
   }
 
-  if (!(hashtblP->lock_nodes = calloc (size, sizeof (pthread_mutex_t)))) {
-    free_wrapper ((void**)&hashtblP->nodes);
-    free_wrapper ((void**)&hashtblP->name);
-    free_wrapper ((void**)&hashtblP);
-    return NULL;
-  }
-
-  pthread_mutex_init(&hashtblP->mutex, NULL);
-  for (int i = 0; i < size; i++) {
-    pthread_mutex_init(&hashtblP->lock_nodes[i], NULL);
-  }
-
-  hashtblP->size = size;
-
   if (hashfuncP)
     hashtblP->hashfunc = hashfuncP;
   else
@@ -275,7 +329,10 @@ hashtable_ts_create (
   if (!(hashtbl = calloc (1, sizeof (hash_table_ts_t)))) {
     return NULL;
   }
-  hashtbl =  hashtable_ts_init(hashtbl, sizeP, hashfuncP, freefuncP, display_name_pP);
+  if (!hashtable_ts_init(hashtbl, sizeP, hashfuncP, freefuncP, display_name_pP)) {
+    free_wrapper ((void**)&hashtbl);
+    return NULL;
+  }
   hashtbl->is_allocated_by_malloc = true;
   return hashtbl;
 }
@@ -329,36 +386,12 @@ hashtable_rc_t
 hashtable_ts_destroy (
   hash_table_ts_t * hashtblP)
 {
-  hash_size_t                             n = 0;
-  hash_node_t                            *node = NULL,
-                                         *oldnode = NULL;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_lock (&hashtblP->lock_nodes[n]);
-    node = hashtblP->nodes[n];
-
-    while (node) {
-      oldnode = node;
-      node = node->next;
-
-      if (oldnode->data) {
-        hashtblP->freefunc (&oldnode->data);
-      }
-
-      free_wrapper ((void**)&oldnode);
-    }
-
-    pthread_mutex_unlock (&hashtblP->lock_nodes[n]);
-    pthread_mutex_destroy (&hashtblP->lock_nodes[n]);
-  }
-
-  free_wrapper ((void**)&hashtblP->nodes);
+  concurrent_hashtable_destroy (&hashtblP->map, hashtable_ts_free_value, hashtblP);
   bdestroy_wrapper (&hashtblP->name);
-  free_wrapper((void**)&hashtblP->lock_nodes);
   if (hashtblP->is_allocated_by_malloc) {
     free_wrapper ((void**)&hashtblP);
   }
@@ -403,27 +436,14 @@ hashtable_ts_is_key_exists (
   const hash_table_ts_t * const hashtblP,
   const hash_key_t keyP)
 {
-  hash_node_t                            *node = NULL;
-  hash_size_t                             hash = 0;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock (&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
-    }
-
-    node = node->next;
+  if (concurrent_hashtable_get ((concurrent_hashtable_t *)&hashtblP->map, hashtable_ts_hash (hashtblP, keyP), keyP, NULL, 0, NULL)) {
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
@@ -474,59 +494,31 @@ hashtable_apply_callback_on_elements (
 // may cost a lot CPU...
 hashtable_key_array_t * hashtable_ts_get_keys (hash_table_ts_t * const hashtblP)
 {
-  hash_node_t                            *node = NULL;
-  unsigned int                            i = 0;
-  hashtable_key_array_t                  *ka = NULL;
+  hashtable_ts_iterate_arg_t              iarg = {0};
 
-  if ((!hashtblP) || !(hashtblP->num_elements)){
+  if ((!hashtblP) || !(iarg.capacity = concurrent_hashtable_num_elements (&hashtblP->map))){
     return NULL;
   }
 
-  ka = calloc(1, sizeof(hashtable_key_array_t));
-  ka->keys = calloc(hashtblP->num_elements, sizeof(hash_key_t*));
-
-  while ((ka->num_keys < hashtblP->num_elements) && (i < hashtblP->size)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-      while (node) {
-        ka->keys[ka->num_keys++] = node->key;
-        node = node->next;
-      }
-    }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    i++;
-  }
-  return ka;
+  iarg.ka = calloc(1, sizeof(hashtable_key_array_t));
+  iarg.ka->keys = calloc(iarg.capacity, sizeof(hash_key_t));
+  concurrent_hashtable_iterate (&hashtblP->map, hashtable_ts_get_keys_cb, &iarg);
+  return iarg.ka;
 }
 
 //------------------------------------------------------------------------------
 // may cost a lot CPU...
 hashtable_element_array_t * hashtable_ts_get_elements (hash_table_ts_t * const hashtblP)
 {
-  hash_node_t                            *node = NULL;
-  unsigned int                            i = 0;
-  hashtable_element_array_t              *ea = NULL;
+  hashtable_ts_iterate_arg_t              iarg = {0};
 
-  if ((!hashtblP) || !(hashtblP->num_elements)){
+  if ((!hashtblP) || !(iarg.capacity = concurrent_hashtable_num_elements (&hashtblP->map))){
     return NULL;
   }
-  ea = calloc(1, sizeof(hashtable_element_array_t));
-  ea->elements = calloc(hashtblP->num_elements, sizeof(hash_key_t*));
-
-  while ((ea->num_elements < hashtblP->num_elements) && (i < hashtblP->size)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-      while (node) {
-        ea->elements[ea->num_elements++] = node->data;
-        node = node->next;
-      }
-    }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    i++;
-  }
-  return ea;
+  iarg.ea = calloc(1, sizeof(hashtable_element_array_t));
+  iarg.ea->elements = calloc(iarg.capacity, sizeof(void*));
+  concurrent_hashtable_iterate (&hashtblP->map, hashtable_ts_get_elements_cb, &iarg);
+  return iarg.ea;
 }
 
 
@@ -544,32 +536,13 @@ hashtable_ts_apply_callback_on_elements (
   void *parameterP,
   void** resultP)
 {
-  hash_node_t                            *node = NULL;
-  unsigned int                            i = 0;
-  unsigned int                            num_elements = 0;
+  hashtable_ts_iterate_arg_t              iarg = {.hashtbl = hashtblP, .funct_cb = funct_cb, .parameter = parameterP, .result = resultP};
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  while ((num_elements < hashtblP->num_elements) && (i < hashtblP->size)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        num_elements++;
-        if (funct_cb (node->key, node->data, parameterP, resultP)) {
-          pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-          return HASH_TABLE_OK;
-        }
-        node = node->next;
-      }
-    }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    i++;
-  }
-
+  concurrent_hashtable_iterate (&hashtblP->map, hashtable_ts_apply_callback_cb, &iarg);
   return HASH_TABLE_OK;
 }
 
@@ -615,34 +588,14 @@ hashtable_ts_dump_content (
   const hash_table_ts_t * const hashtblP,
   bstring str)
 {
-  hash_node_t                            *node = NULL;
-  unsigned int                            i = 0;
+  hashtable_ts_iterate_arg_t              iarg = {.hashtbl = (hash_table_ts_t *)hashtblP, .str = str};
 
   if (!hashtblP) {
     bcatcstr(str, "HASH_TABLE_BAD_PARAMETER_HASHTABLE");
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  while (i < hashtblP->size) {
-    if (hashtblP->nodes[i] != NULL) {
-      pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        bstring b0 = bformat ("Key 0x%"PRIx64" Element %p Node %p Next %p\n", node->key, node->data, node, node->next);
-        if (!b0) {
-          PRINT_HASHTABLE (hashtblP, "Error while dumping hashtable content");
-        } else {
-          bconcat(str, b0);
-          bdestroy_wrapper (&b0);
-        }
-        node = node->next;
-
-      }
-      pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    }
-    i += 1;
-  }
+  concurrent_hashtable_iterate ((concurrent_hashtable_t *)&hashtblP->map, hashtable_ts_dump_content_cb, &iarg);
   return HASH_TABLE_OK;
 }
 
@@ -717,51 +670,37 @@ hashtable_ts_insert (
   const hash_key_t keyP,
   void *dataP)
 {
-  hash_node_t                            *node = NULL;
-  hash_size_t                             hash = 0;
+  concurrent_hashtable_writer_t           writer = {0};
+  concurrent_hashtable_node_t            *node = NULL;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
+  concurrent_hashtable_write_begin (&hashtblP->map, hashtable_ts_hash (hashtblP, keyP), &writer);
+  node = concurrent_hashtable_find_locked (&writer, keyP, NULL, 0);
 
-  while (node) {
-    if (node->key == keyP) {
-      if ((node->data) && (node->data != dataP)) {
-        hashtblP->freefunc (&node->data);
-        node->data = dataP;
-        pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-        PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
-        return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
-      }
-      node->data = dataP;
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
-      return HASH_TABLE_OK;
-    }
+  if (node) {
+    void                                 *old_data = (void *)(uintptr_t)node->value;
 
-    node = node->next;
+    concurrent_hashtable_set_value_locked (node, (uintptr_t)dataP);
+    if ((old_data) && (old_data != dataP)) {
+      hashtblP->freefunc (&old_data); /**< Old EMM context will be freed. */
+      concurrent_hashtable_write_end (&writer);
+      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
+      return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
+    }
+    concurrent_hashtable_write_end (&writer);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
+    return HASH_TABLE_OK;
   }
 
-  if (!(node = malloc (sizeof (hash_node_t))))
-    return -1;
-
-  node->key = keyP;
-  node->data = dataP;
-
-  if (hashtblP->nodes[hash]) {
-    node->next = hashtblP->nodes[hash];
-  } else {
-    node->next = NULL;
+  node = concurrent_hashtable_link_locked (&writer, keyP, NULL, 0, (uintptr_t)dataP);
+  concurrent_hashtable_write_end (&writer);
+  if (!node) {
+    return HASH_TABLE_SYSTEM_ERROR;
   }
-
-  hashtblP->nodes[hash] = node;
-  __sync_fetch_and_add (&hashtblP->num_elements, 1);
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) next %p return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, node->next);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
   return HASH_TABLE_OK;
 }
 
@@ -824,42 +763,27 @@ hashtable_ts_free (
   hash_table_ts_t * const hashtblP,
   const hash_key_t keyP)
 {
-  hash_node_t                            *node,
-                                         *prevnode = NULL;
-  hash_size_t                             hash = 0;
+  concurrent_hashtable_writer_t           writer = {0};
+  concurrent_hashtable_node_t            *node = NULL;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
+  concurrent_hashtable_write_begin (&hashtblP->map, hashtable_ts_hash (hashtblP, keyP), &writer);
+  if ((node = concurrent_hashtable_find_locked (&writer, keyP, NULL, 0))) {
+    void                                 *data = (void *)(uintptr_t)node->value;
 
-  while (node) {
-    if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      if (node->data) {
-        hashtblP->freefunc (&node->data);
-      }
-
-      free_wrapper ((void**)&node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
+    concurrent_hashtable_unlink_locked (&writer, node);
+    if (data) {
+      hashtblP->freefunc (&data);
     }
-
-    prevnode = node;
-    node = node->next;
+    concurrent_hashtable_write_end (&writer);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
-
-   pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+  concurrent_hashtable_write_end (&writer);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
 
@@ -921,38 +845,22 @@ hashtable_ts_remove (
   const hash_key_t keyP,
   void **dataP)
 {
-  hash_node_t                            *node,
-                                         *prevnode = NULL;
-  hash_size_t                             hash = 0;
+  concurrent_hashtable_writer_t           writer = {0};
+  concurrent_hashtable_node_t            *node = NULL;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      *dataP = node->data;
-      free_wrapper ((void**)&node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
+  concurrent_hashtable_write_begin (&hashtblP->map, hashtable_ts_hash (hashtblP, keyP), &writer);
+  if ((node = concurrent_hashtable_find_locked (&writer, keyP, NULL, 0))) {
+    *dataP = (void *)(uintptr_t)node->value;
+    concurrent_hashtable_unlink_locked (&writer, node);
+    concurrent_hashtable_write_end (&writer);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-
+  concurrent_hashtable_write_end (&writer);
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
@@ -1006,32 +914,19 @@ hashtable_ts_get (
   const hash_key_t keyP,
   void **dataP)
 {
-  hash_node_t                            *node = NULL;
-  hash_size_t                             hash = 0;
+  uint64_t                                value = 0;
 
   *dataP = NULL;
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      *dataP = node->data;
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP);
-      return HASH_TABLE_OK;
-    }
-
-    node = node->next;
+  if (concurrent_hashtable_get ((concurrent_hashtable_t *)&hashtblP->map, hashtable_ts_hash (hashtblP, keyP), keyP, NULL, 0, &value)) {
+    *dataP = (void *)(uintptr_t)value;
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
 
@@ -1120,63 +1015,12 @@ hashtable_ts_resize (
   hash_table_ts_t * const hashtblP,
   const hash_size_t sizeP)
 {
-  hash_table_ts_t                         newtbl = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0};
-  hash_size_t                             n      = 0;
-  hash_node_t                            *node   = NULL,
-                                         *next   = NULL;
-  void                                   *dummy  = NULL;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
-  newtbl.size = size;
-  newtbl.hashfunc = hashtblP->hashfunc;
-
-  if (!(newtbl.nodes = calloc (size, sizeof (hash_node_t *))))
+  if (concurrent_hashtable_reserve (&hashtblP->map, sizeP)) {
     return HASH_TABLE_SYSTEM_ERROR;
-
-  if (!(newtbl.lock_nodes = calloc (size, sizeof (pthread_mutex_t)))) {
-    free_wrapper ((void**)&newtbl.nodes);
-    return HASH_TABLE_SYSTEM_ERROR;
-  }
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_init(&newtbl.lock_nodes[n], NULL);
-  }
-
-  pthread_mutex_lock(&hashtblP->mutex);
-  for (n = 0; n < hashtblP->size; ++n) {
-    for (node = hashtblP->nodes[n]; node; node = next) {
-      next = node->next;
-      hashtable_ts_remove (hashtblP, node->key, &dummy);
-      hashtable_ts_insert (&newtbl, node->key, node->data);
-    }
   }
-
-  free_wrapper ((void**)&hashtblP->nodes);
-  free_wrapper ((void**)&hashtblP->lock_nodes);
-  hashtblP->size = newtbl.size;
-  hashtblP->nodes = newtbl.nodes;
-  hashtblP->lock_nodes = newtbl.lock_nodes;
-  pthread_mutex_unlock(&hashtblP->mutex);
   return HASH_TABLE_OK;
 }
 
@@ -28,6 +28,8 @@
 #ifndef FILE_HASH_TABLE_SEEN
 #define FILE_HASH_TABLE_SEEN
 
+#include "concurrent_hashtable.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -78,11 +80,7 @@ typedef struct hash_table_s {
 } hash_table_t;
 
 typedef struct hash_table_ts_s {
-    pthread_mutex_t     mutex;
-    hash_size_t         size;
-    hash_size_t         num_elements;
-    struct hash_node_s **nodes;
-    pthread_mutex_t     *lock_nodes;
+    concurrent_hashtable_t map;
     hash_size_t       (*hashfunc)(const hash_key_t);
     void              (*freefunc)(void**);
     bstring             name;
@@ -100,11 +98,7 @@ typedef struct hash_table_uint64_s {
 } hash_table_uint64_t;
 
 typedef struct hash_table_uint64_ts_s {
-    pthread_mutex_t     mutex;
-    hash_size_t         size;
-    hash_size_t         num_elements;
-    struct hash_node_uint64_s **nodes;
-    pthread_mutex_t     *lock_nodes;
+    concurrent_hashtable_t map;
     hash_size_t       (*hashfunc)(const hash_key_t);
     bstring             name;
     bool                is_allocated_by_malloc;
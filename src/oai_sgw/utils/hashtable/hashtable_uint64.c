@@ -140,6 +140,81 @@ hashtable_uint64_create (
   return hashtbl;
 }
 
+//------------------------------------------------------------------------------
+/*
+   Thread safe hash tables are backed by a concurrent_hashtable_t, see hashtable.c.
+*/
+static inline uint64_t hashtable_uint64_ts_hash (const hash_table_uint64_ts_t * const hashtblP, const hash_key_t keyP)
+{
+  return concurrent_hashtable_hash_key (&hashtblP->map, hashtblP->hashfunc (keyP));
+}
+
+typedef struct hashtable_uint64_ts_iterate_arg_s {
+  hash_table_uint64_ts_t                 *hashtbl;
+  bool                                  (*funct_cb)(const hash_key_t keyP, const uint64_t dataP, void *parameterP, void ** resultP);
+  void                                   *parameter;
+  void                                  **result;
+  hashtable_key_array_t                  *ka;
+  hashtable_uint64_element_array_t       *ea;
+  int                                     capacity;
+  bstring                                 str;
+} hashtable_uint64_ts_iterate_arg_t;
+
+//------------------------------------------------------------------------------
+static bool hashtable_uint64_ts_get_keys_cb (concurrent_hashtable_node_t * const node, void * arg)
+{
+  hashtable_uint64_ts_iterate_arg_t      *iarg = (hashtable_uint64_ts_iterate_arg_t *)arg;
+
+  if (iarg->ka->num_keys == iarg->capacity) {
+    hash_key_t                           *keys = realloc (iarg->ka->keys, 2 * iarg->capacity * sizeof (hash_key_t));
+
+    if (!keys) return true;
+    iarg->ka->keys = keys;
+    iarg->capacity *= 2;
+  }
+  iarg->ka->keys[iarg->ka->num_keys++] = node->key;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static bool hashtable_uint64_ts_get_elements_cb (concurrent_hashtable_node_t * const node, void * arg)
+{
+  hashtable_uint64_ts_iterate_arg_t      *iarg = (hashtable_uint64_ts_iterate_arg_t *)arg;
+
+  if (iarg->ea->num_elements == iarg->capacity) {
+    uint64_t                             *elements = realloc (iarg->ea->elements, 2 * iarg->capacity * sizeof (uint64_t));
+
+    if (!elements) return true;
+    iarg->ea->elements = elements;
+    iarg->capacity *= 2;
+  }
+  iarg->ea->elements[iarg->ea->num_elements++] = node->value;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static bool hashtable_uint64_ts_apply_callback_cb (concurrent_hashtable_node_t * const node, void * arg)
+{
+  hashtable_uint64_ts_iterate_arg_t      *iarg = (hashtable_uint64_ts_iterate_arg_t *)arg;
+
+  return iarg->funct_cb (node->key, node->value, iarg->parameter, iarg->result);
+}
+
+//------------------------------------------------------------------------------
+static bool hashtable_uint64_ts_dump_content_cb (concurrent_hashtable_node_t * const node, void * arg)
+{
+  hashtable_uint64_ts_iterate_arg_t      *iarg = (hashtable_uint64_ts_iterate_arg_t *)arg;
+  bstring                                 b0 = bformat ("Key 0x%"PRIx64" Element %"PRIx64" Node %p Next %p\n", node->key, node->value, node, node->next);
+
+  if (!b0) {
+    PRINT_HASHTABLE (iarg->hashtbl, "Error while dumping hashtable content");
+  } else {
+    bconcat(iarg->str, b0);
+    bdestroy_wrapper (&b0);
+  }
+  return false;
+}
+
 //------------------------------------------------------------------------------
 /*
    Initialization
@@ -152,46 +227,12 @@ hash_table_uint64_ts_t * hashtable_uint64_ts_init (hash_table_uint64_ts_t * cons
     hash_size_t (*hashfuncP) (const hash_key_t),
     bstring display_name_pP)
 {
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
   memset(hashtblP, 0, sizeof(*hashtblP));
 
-  if (!(hashtblP->nodes = calloc (size, sizeof (hash_node_uint64_t *)))) {
-    free_wrapper ((void**)&hashtblP);
+  if (concurrent_hashtable_init (&hashtblP->map, sizeP, false)) {
     return NULL;
   }
 
-  if (!(hashtblP->lock_nodes = calloc (size, sizeof (pthread_mutex_t)))) {
-    free_wrapper ((void**)&hashtblP->nodes);
-    free_wrapper ((void**)&hashtblP->name);
-    free_wrapper ((void**)&hashtblP);
-    return NULL;
-  }
-
-  pthread_mutex_init(&hashtblP->mutex, NULL);
-  for (int i = 0; i < size; i++) {
-    pthread_mutex_init(&hashtblP->lock_nodes[i], NULL);
-  }
-
-  hashtblP->size = size;
-
   if (hashfuncP)
     hashtblP->hashfunc = hashfuncP;
   else
@@ -224,7 +265,10 @@ hashtable_uint64_ts_create (
   if (!(hashtbl = calloc (1, sizeof (hash_table_uint64_ts_t)))) {
     return NULL;
   }
-  hashtbl =  hashtable_uint64_ts_init(hashtbl, sizeP, hashfuncP, display_name_pP);
+  if (!hashtable_uint64_ts_init(hashtbl, sizeP, hashfuncP, display_name_pP)) {
+    free_wrapper ((void**)&hashtbl);
+    return NULL;
+  }
   hashtbl->is_allocated_by_malloc = true;
   return hashtbl;
 }
@@ -273,31 +317,12 @@ hashtable_rc_t
 hashtable_uint64_ts_destroy (
   hash_table_uint64_ts_t * hashtblP)
 {
-  hash_size_t                             n = 0;
-  hash_node_uint64_t                     *node = NULL,
-                                         *oldnode = NULL;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_lock (&hashtblP->lock_nodes[n]);
-    node = hashtblP->nodes[n];
-
-    while (node) {
-      oldnode = node;
-      node = node->next;
-      free_wrapper ((void**)&oldnode);
-    }
-
-    pthread_mutex_unlock (&hashtblP->lock_nodes[n]);
-    pthread_mutex_destroy (&hashtblP->lock_nodes[n]);
-  }
-
-  free_wrapper ((void**)&hashtblP->nodes);
+  concurrent_hashtable_destroy (&hashtblP->map, NULL, NULL);
   bdestroy_wrapper (&hashtblP->name);
-  free_wrapper((void**)&hashtblP->lock_nodes);
   if (hashtblP->is_allocated_by_malloc) {
     free_wrapper ((void**)&hashtblP);
   }
@@ -342,27 +367,14 @@ hashtable_uint64_ts_is_key_exists (
   const hash_table_uint64_ts_t * const hashtblP,
   const hash_key_t keyP)
 {
-  hash_node_uint64_t                     *node = NULL;
-  hash_size_t                             hash = 0;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock (&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
-    }
-
-    node = node->next;
+  if (concurrent_hashtable_get ((concurrent_hashtable_t *)&hashtblP->map, hashtable_uint64_ts_hash (hashtblP, keyP), keyP, NULL, 0, NULL)) {
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
@@ -413,59 +425,31 @@ hashtable_uint64_apply_callback_on_elements (
 // may cost a lot CPU...
 hashtable_key_array_t * hashtable_uint64_ts_get_keys (hash_table_uint64_ts_t * const hashtblP)
 {
-  hash_node_uint64_t                     *node = NULL;
-  unsigned int                            i = 0;
-  hashtable_key_array_t                  *ka = NULL;
+  hashtable_uint64_ts_iterate_arg_t       iarg = {0};
 
-  if ((!hashtblP) || !(hashtblP->num_elements)){
+  if ((!hashtblP) || !(iarg.capacity = concurrent_hashtable_num_elements (&hashtblP->map))){
     return NULL;
   }
-  ka = calloc(1, sizeof(hashtable_key_array_t));
-  ka->keys = calloc(hashtblP->num_elements, sizeof(hash_key_t*));
-
-  while ((ka->num_keys < hashtblP->num_elements) && (i < hashtblP->size)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-      while (node) {
-        ka->keys[ka->num_keys++] = node->key;
-        node = node->next;
-      }
-    }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    i++;
-  }
-  return ka;
+  iarg.ka = calloc(1, sizeof(hashtable_key_array_t));
+  iarg.ka->keys = calloc(iarg.capacity, sizeof(hash_key_t));
+  concurrent_hashtable_iterate (&hashtblP->map, hashtable_uint64_ts_get_keys_cb, &iarg);
+  return iarg.ka;
 }
 
 //------------------------------------------------------------------------------
 // may cost a lot CPU...
 hashtable_uint64_element_array_t * hashtable_uint64_ts_get_elements (hash_table_uint64_ts_t * const hashtblP)
 {
-  hash_node_uint64_t                     *node = NULL;
-  unsigned int                            i = 0;
-  hashtable_uint64_element_array_t       *ea = NULL;
+  hashtable_uint64_ts_iterate_arg_t       iarg = {0};
 
-  if ((!hashtblP) || !(hashtblP->num_elements)){
+  if ((!hashtblP) || !(iarg.capacity = concurrent_hashtable_num_elements (&hashtblP->map))){
     return NULL;
   }
 
-  ea = calloc(1, sizeof(hashtable_uint64_element_array_t));
-  ea->elements = calloc(hashtblP->num_elements, sizeof(uint64_t*));
-
-  while ((ea->num_elements < hashtblP->num_elements) && (i < hashtblP->size)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-      while (node) {
-        ea->elements[ea->num_elements++] = node->data;
-        node = node->next;
-      }
-    }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    i++;
-  }
-  return ea;
+  iarg.ea = calloc(1, sizeof(hashtable_uint64_element_array_t));
+  iarg.ea->elements = calloc(iarg.capacity, sizeof(uint64_t));
+  concurrent_hashtable_iterate (&hashtblP->map, hashtable_uint64_ts_get_elements_cb, &iarg);
+  return iarg.ea;
 }
 
 
@@ -483,32 +467,13 @@ hashtable_uint64_ts_apply_callback_on_elements (
   void *parameterP,
   void** resultP)
 {
-  hash_node_uint64_t                     *node = NULL;
-  unsigned int                            i = 0;
-  unsigned int                            num_elements = 0;
+  hashtable_uint64_ts_iterate_arg_t       iarg = {.hashtbl = hashtblP, .funct_cb = funct_cb, .parameter = parameterP, .result = resultP};
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  while ((num_elements < hashtblP->num_elements) && (i < hashtblP->size)) {
-    pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-    if (hashtblP->nodes[i] != NULL) {
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        num_elements++;
-        if (funct_cb (node->key, node->data, parameterP, resultP)) {
-          pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-          return HASH_TABLE_OK;
-        }
-        node = node->next;
-      }
-    }
-    pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    i++;
-  }
-
+  concurrent_hashtable_iterate (&hashtblP->map, hashtable_uint64_ts_apply_callback_cb, &iarg);
   return HASH_TABLE_OK;
 }
 
@@ -554,34 +519,14 @@ hashtable_uint64_ts_dump_content (
   const hash_table_uint64_ts_t * const hashtblP,
   bstring str)
 {
-  hash_node_uint64_t                     *node = NULL;
-  unsigned int                            i = 0;
+  hashtable_uint64_ts_iterate_arg_t       iarg = {.hashtbl = (hash_table_uint64_ts_t *)hashtblP, .str = str};
 
   if (!hashtblP) {
     bcatcstr(str, "HASH_TABLE_BAD_PARAMETER_HASHTABLE");
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  while (i < hashtblP->size) {
-    if (hashtblP->nodes[i] != NULL) {
-      pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        bstring b0 = bformat ("Key 0x%"PRIx64" Element %"PRIx64" Node %p Next %p\n", node->key, node->data, node, node->next);
-        if (!b0) {
-          PRINT_HASHTABLE (hashtblP, "Error while dumping hashtable content");
-        } else {
-          bconcat(str, b0);
-          bdestroy_wrapper (&b0);
-        }
-        node = node->next;
-
-      }
-      pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    }
-    i += 1;
-  }
+  concurrent_hashtable_iterate ((concurrent_hashtable_t *)&hashtblP->map, hashtable_uint64_ts_dump_content_cb, &iarg);
   return HASH_TABLE_OK;
 }
 
@@ -654,50 +599,34 @@ hashtable_uint64_ts_insert (
   const hash_key_t keyP,
   const uint64_t dataP)
 {
-  hash_node_uint64_t                     *node = NULL;
-  hash_size_t                             hash = 0;
+  concurrent_hashtable_writer_t           writer = {0};
+  concurrent_hashtable_node_t            *node = NULL;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
+  concurrent_hashtable_write_begin (&hashtblP->map, hashtable_uint64_ts_hash (hashtblP, keyP), &writer);
+  node = concurrent_hashtable_find_locked (&writer, keyP, NULL, 0);
 
-  while (node) {
-    if (node->key == keyP) {
-      if (node->data != dataP) {
-        node->data = dataP;
-        pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-        PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
-        return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
-      }
-      node->data = dataP;
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
-      return HASH_TABLE_OK;
+  if (node) {
+    if (node->value != dataP) {
+      concurrent_hashtable_set_value_locked (node, dataP);
+      concurrent_hashtable_write_end (&writer);
+      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
+      return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
     }
-
-    node = node->next;
+    concurrent_hashtable_write_end (&writer);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
+    return HASH_TABLE_OK;
   }
 
-  if (!(node = malloc (sizeof (hash_node_uint64_t))))
-    return -1;
-
-  node->key = keyP;
-  node->data = dataP;
-
-  if (hashtblP->nodes[hash]) {
-    node->next = hashtblP->nodes[hash];
-  } else {
-    node->next = NULL;
+  node = concurrent_hashtable_link_locked (&writer, keyP, NULL, 0, dataP);
+  concurrent_hashtable_write_end (&writer);
+  if (!node) {
+    return HASH_TABLE_SYSTEM_ERROR;
   }
-
-  hashtblP->nodes[hash] = node;
-  __sync_fetch_and_add (&hashtblP->num_elements, 1);
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) next %p return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, node->next);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
   return HASH_TABLE_OK;
 }
 
@@ -756,38 +685,22 @@ hashtable_uint64_ts_free (
   hash_table_uint64_ts_t * const hashtblP,
   const hash_key_t keyP)
 {
-  hash_node_uint64_t                     *node,
-                                         *prevnode = NULL;
-  hash_size_t                             hash = 0;
+  concurrent_hashtable_writer_t           writer = {0};
+  concurrent_hashtable_node_t            *node = NULL;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      free_wrapper ((void**)&node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
+  concurrent_hashtable_write_begin (&hashtblP->map, hashtable_uint64_ts_hash (hashtblP, keyP), &writer);
+  if ((node = concurrent_hashtable_find_locked (&writer, keyP, NULL, 0))) {
+    concurrent_hashtable_unlink_locked (&writer, node);
+    concurrent_hashtable_write_end (&writer);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
-
-   pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+  concurrent_hashtable_write_end (&writer);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
 
@@ -846,37 +759,21 @@ hashtable_uint64_ts_remove (
   hash_table_uint64_ts_t * const hashtblP,
   const hash_key_t keyP)
 {
-  hash_node_uint64_t                     *node,
-                                         *prevnode = NULL;
-  hash_size_t                             hash = 0;
+  concurrent_hashtable_writer_t           writer = {0};
+  concurrent_hashtable_node_t            *node = NULL;
 
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if (prevnode)
-        prevnode->next = node->next;
-      else
-        hashtblP->nodes[hash] = node->next;
-
-      free_wrapper ((void**)&node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
+  concurrent_hashtable_write_begin (&hashtblP->map, hashtable_uint64_ts_hash (hashtblP, keyP), &writer);
+  if ((node = concurrent_hashtable_find_locked (&writer, keyP, NULL, 0))) {
+    concurrent_hashtable_unlink_locked (&writer, node);
+    concurrent_hashtable_write_end (&writer);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-
+  concurrent_hashtable_write_end (&writer);
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
@@ -929,29 +826,14 @@ hashtable_uint64_ts_get (
   const hash_key_t keyP,
   uint64_t * const dataP)
 {
-  hash_node_uint64_t                     *node = NULL;
-  hash_size_t                             hash = 0;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  hash = hashtblP->hashfunc (keyP) % hashtblP->size;
-
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      *dataP = node->data;
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP);
-      return HASH_TABLE_OK;
-    }
-
-    node = node->next;
+  if (concurrent_hashtable_get ((concurrent_hashtable_t *)&hashtblP->map, hashtable_uint64_ts_hash (hashtblP, keyP), keyP, NULL, 0, dataP)) {
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
   PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
@@ -1031,8 +913,7 @@ hashtable_uint64_resize (
    Resizing a hash table is not as easy as a realloc(). All hash values must be recalculated and each element must be inserted into its new position.
    We create a temporary hash_table_uint64_t object (newtbl) to be used while building the new hashes.
    This allows us to reuse hashtable_uint64_insert() and hashtable_uint64_free(), when moving the elements to the new table.
-   After that, we can just free_wrapper the old table and copy the elements from newtbl to hashtbl.
-   Dangerous not really thread safe.
+   The thread safe hash table grows by itself, hashtable_uint64_ts_resize() only reserves buckets in advance (see hashtable_ts_resize()).
 */
 
 hashtable_rc_t
@@ -1040,62 +921,12 @@ hashtable_uint64_ts_resize (
   hash_table_uint64_ts_t * const hashtblP,
   const hash_size_t sizeP)
 {
-  hash_table_uint64_ts_t                  newtbl = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0};
-  hash_size_t                             n      = 0;
-  hash_node_uint64_t                     *node   = NULL,
-                                         *next   = NULL;
-
   if (!hashtblP) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
-  newtbl.size = size;
-  newtbl.hashfunc = hashtblP->hashfunc;
-
-  if (!(newtbl.nodes = calloc (size, sizeof (hash_node_uint64_t *))))
-    return HASH_TABLE_SYSTEM_ERROR;
-
-  if (!(newtbl.lock_nodes = calloc (size, sizeof (pthread_mutex_t)))) {
-    free_wrapper ((void**)&newtbl.nodes);
+  if (concurrent_hashtable_reserve (&hashtblP->map, sizeP)) {
     return HASH_TABLE_SYSTEM_ERROR;
   }
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_init(&newtbl.lock_nodes[n], NULL);
-  }
-
-  pthread_mutex_lock(&hashtblP->mutex);
-  for (n = 0; n < hashtblP->size; ++n) {
-    for (node = hashtblP->nodes[n]; node; node = next) {
-      next = node->next;
-      hashtable_uint64_ts_remove (hashtblP, node->key);
-      hashtable_uint64_ts_insert (&newtbl, node->key, node->data);
-    }
-  }
-
-  free_wrapper ((void**)&hashtblP->nodes);
-  free_wrapper ((void**)&hashtblP->lock_nodes);
-  hashtblP->size = newtbl.size;
-  hashtblP->nodes = newtbl.nodes;
-  hashtblP->lock_nodes = newtbl.lock_nodes;
-  pthread_mutex_unlock(&hashtblP->mutex);
   return HASH_TABLE_OK;
 }
 
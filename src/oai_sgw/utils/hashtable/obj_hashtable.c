@@ -180,6 +180,63 @@ obj_hashtable_create (
   return obj_hashtable_init(hashtbl, sizeP, hashfuncP, freekeyfuncP, freedatafuncP, display_name_pP);
 }
 
+//------------------------------------------------------------------------------
+/*
+   Thread safe hash tables are backed by a concurrent_hashtable_t, see hashtable.c.
+   Keys are copied in the nodes and matched by content, freekeyfunc is not used.
+*/
+static inline uint64_t obj_hashtable_ts_hash (const obj_hash_table_t * const hashtblP, const void *const keyP, const int key_sizeP)
+{
+  if (hashtblP->hashfunc) {
+    return concurrent_hashtable_hash_key (&hashtblP->map, hashtblP->hashfunc (keyP, key_sizeP));
+  }
+  return concurrent_hashtable_hash_obj_key (&hashtblP->map, keyP, key_sizeP);
+}
+
+//------------------------------------------------------------------------------
+static void obj_hashtable_ts_free_value (uint64_t value, void * arg)
+{
+  obj_hash_table_t                       *hashtblP = (obj_hash_table_t *)arg;
+  void                                   *data = (void *)(uintptr_t)value;
+
+  hashtblP->freedatafunc (&data);
+}
+
+typedef struct obj_hashtable_ts_iterate_arg_s {
+  obj_hash_table_t *hashtbl;
+  void                                  **keys;
+  unsigned int                            num_keys;
+  unsigned int                            capacity;
+  bstring                                 str;
+} obj_hashtable_ts_iterate_arg_t;
+
+//------------------------------------------------------------------------------
+static bool obj_hashtable_ts_get_keys_cb (concurrent_hashtable_node_t * const node, void * arg)
+{
+  obj_hashtable_ts_iterate_arg_t *iarg = (obj_hashtable_ts_iterate_arg_t *)arg;
+
+  if (iarg->num_keys >= iarg->capacity) {
+    return true;
+  }
+  iarg->keys[iarg->num_keys++] = node->obj_key;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static bool obj_hashtable_ts_dump_content_cb (concurrent_hashtable_node_t * const node, void * arg)
+{
+  obj_hashtable_ts_iterate_arg_t *iarg = (obj_hashtable_ts_iterate_arg_t *)arg;
+  bstring                                 b0 = bformat("Hash %"PRIx64" Key %p Key length %d Element %p\n", node->hash, node->obj_key, node->obj_key_size, (void *)(uintptr_t)node->value);
+
+  if (!b0) {
+    PRINT_HASHTABLE (iarg->hashtbl, "Error while dumping hashtable content");
+  } else {
+    bconcat(iarg->str, b0);
+    bdestroy_wrapper (&b0);
+  }
+  return false;
+}
+
 //------------------------------------------------------------------------------
 /*
    Initialization
@@ -197,37 +254,29 @@ obj_hashtable_ts_init (
   void (*freedatafuncP) (void **),
   bstring display_name_pP)
 {
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
+  memset(hashtblP, 0, sizeof(*hashtblP));
 
-  if (!(hashtblP->lock_nodes = calloc (size, sizeof (pthread_mutex_t)))) {
-    free_wrapper ((void**)&hashtblP->nodes);
-    free_wrapper ((void**)&hashtblP->name);
-    free_wrapper ((void**)&hashtblP);
+  if (concurrent_hashtable_init (&hashtblP->map, sizeP, true)) {
     return NULL;
   }
+  // NULL: seeded hash of the key content
+  hashtblP->hashfunc = hashfuncP;
 
-  pthread_mutex_init(&hashtblP->mutex, NULL);
-  for (int i = 0; i < size; i++) {
-    pthread_mutex_init(&hashtblP->lock_nodes[i], NULL);
-  }
+  if (freekeyfuncP)
+    hashtblP->freekeyfunc = freekeyfuncP;
+  else
+    hashtblP->freekeyfunc = free_wrapper;
+
+  if (freedatafuncP)
+    hashtblP->freedatafunc = freedatafuncP;
+  else
+    hashtblP->freedatafunc = free_wrapper;
 
+  if (display_name_pP) {
+    hashtblP->name = bstrcpy(display_name_pP);
+  } else {
+    hashtblP->name = bformat("obj_hashtable@%p", hashtblP);
+  }
   hashtblP->log_enabled = true;
   return hashtblP;
 }
@@ -250,30 +299,14 @@ obj_hashtable_ts_create (
 {
   obj_hash_table_t                       *hashtbl = NULL;
 
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
-  if (!(hashtbl = obj_hashtable_create (size,hashfuncP,freekeyfuncP,freedatafuncP,display_name_pP))) {
+  if (!(hashtbl = calloc (1, sizeof (obj_hash_table_t)))) {
     return NULL;
   }
-
-  return obj_hashtable_ts_init(hashtbl, size, hashfuncP, freekeyfuncP, freedatafuncP, display_name_pP);
+  if (!obj_hashtable_ts_init(hashtbl, sizeP, hashfuncP, freekeyfuncP, freedatafuncP, display_name_pP)) {
+    free_wrapper ((void**)&hashtbl);
+    return NULL;
+  }
+  return hashtbl;
 }
 
 //------------------------------------------------------------------------------
@@ -317,27 +350,11 @@ hashtable_rc_t
 obj_hashtable_ts_destroy (
   obj_hash_table_t * const hashtblP)
 {
-  hash_size_t                             n;
-  obj_hash_node_t                        *node,
-                                         *oldnode;
-
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_lock (&hashtblP->lock_nodes[n]);
-    node = hashtblP->nodes[n];
-
-    while (node) {
-      oldnode = node;
-      node = node->next;
-      hashtblP->freekeyfunc (&oldnode->key);
-      hashtblP->freedatafunc (&oldnode->data);
-      free_wrapper ((void**)&oldnode);
-    }
-    pthread_mutex_unlock (&hashtblP->lock_nodes[n]);
-    pthread_mutex_destroy (&hashtblP->lock_nodes[n]);
+  if (hashtblP == NULL) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  free_wrapper ((void**)&hashtblP->nodes);
-  free_wrapper((void**)&hashtblP->lock_nodes);
+  concurrent_hashtable_destroy (&hashtblP->map, obj_hashtable_ts_free_value, hashtblP);
   bdestroy_wrapper (&hashtblP->name);
   free_wrapper ((void**)&hashtblP);
   return HASH_TABLE_OK;
@@ -389,9 +406,6 @@ obj_hashtable_ts_is_key_exists (
   const void *const keyP,
   const int key_sizeP)
 {
-  obj_hash_node_t                        *node;
-  hash_size_t                             hash;
-
   if (hashtblP == NULL) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
@@ -401,31 +415,11 @@ obj_hashtable_ts_is_key_exists (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  pthread_mutex_lock (&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u) hash %lx return OK\n", __FUNCTION__,
-              bdata(hashtblP->name), keyP, key_sizeP, hash);
-      return HASH_TABLE_OK;
-    } else if (node->key_size == key_sizeP) {
-      if (memcmp (node->key, keyP, key_sizeP) == 0) {
-        pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
-        PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u) hash %lx return OK\n", __FUNCTION__,
-                bdata(hashtblP->name), keyP, key_sizeP, hash);
-        return HASH_TABLE_OK;
-      }
-    }
-
-    node = node->next;
+  if (concurrent_hashtable_get ((concurrent_hashtable_t *)&hashtblP->map, obj_hashtable_ts_hash (hashtblP, keyP, key_sizeP), 0, keyP, key_sizeP, NULL)) {
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %d) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, key_sizeP);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
-
-  PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u) hash %lx return KEY_NOT_EXISTS\n", __FUNCTION__,
-          bdata(hashtblP->name), keyP, key_sizeP, hash);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %d) return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP, key_sizeP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
 
@@ -469,33 +463,14 @@ obj_hashtable_ts_dump_content (
   const obj_hash_table_t * const hashtblP,
   bstring str)
 {
-  obj_hash_node_t                        *node = NULL;
-  unsigned int                            i = 0;
+  obj_hashtable_ts_iterate_arg_t iarg = {.hashtbl = (obj_hash_table_t *)hashtblP, .str = str};
 
   if (hashtblP == NULL) {
     bcatcstr(str, "HASH_TABLE_BAD_PARAMETER_HASHTABLE");
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  while (i < hashtblP->size) {
-    if (hashtblP->nodes[i] != NULL) {
-      pthread_mutex_lock(&hashtblP->lock_nodes[i]);
-      node = hashtblP->nodes[i];
-
-      while (node) {
-        bstring b0 = bformat("Hash %x Key %p Key length %d Element %p\n", i, node->key, node->key_size, node->data);
-        if (!b0) {
-          PRINT_HASHTABLE (hashtblP, "Error while dumping hashtable content");
-        } else {
-          bconcat(str, b0);
-          bdestroy_wrapper (&b0);
-        }
-        node = node->next;
-      }
-      pthread_mutex_unlock(&hashtblP->lock_nodes[i]);
-    }
-    i += 1;
-  }
+  concurrent_hashtable_iterate ((concurrent_hashtable_t *)&hashtblP->map, obj_hashtable_ts_dump_content_cb, &iarg);
   return HASH_TABLE_OK;
 }
 
@@ -583,8 +558,8 @@ obj_hashtable_ts_insert (
   const int key_sizeP,
   void *dataP)
 {
-  obj_hash_node_t                        *node;
-  hash_size_t                             hash;
+  concurrent_hashtable_writer_t           writer = {0};
+  concurrent_hashtable_node_t            *node = NULL;
 
   if (hashtblP == NULL) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
@@ -595,62 +570,29 @@ obj_hashtable_ts_insert (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      if ((node->data) && (node->data != dataP)) {
-        hashtblP->freedatafunc (&node->data);
-      
-
-        node->data = dataP;
-        node->key_size = key_sizeP;
-        // no waste of memory here because if node->key == keyP, it is a reuse of the same key
-        pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-        PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, hash);
-        return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
-      }
-      node->data = dataP;
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) hash %lx return ok\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, hash);
-      return HASH_TABLE_OK;
+  concurrent_hashtable_write_begin (&hashtblP->map, obj_hashtable_ts_hash (hashtblP, keyP, key_sizeP), &writer);
+  node = concurrent_hashtable_find_locked (&writer, 0, keyP, key_sizeP);
 
+  if (node) {
+    if (node->value != (uintptr_t)dataP) {
+      // the previous data is left to the caller (may be referenced elsewhere)
+      concurrent_hashtable_set_value_locked (node, (uintptr_t)dataP);
+      concurrent_hashtable_write_end (&writer);
+      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) return INSERT_OVERWRITTEN_DATA\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
+      return HASH_TABLE_INSERT_OVERWRITTEN_DATA;
     }
-
-    node = node->next;
+    concurrent_hashtable_write_end (&writer);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p data %p) return ok\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP);
+    return HASH_TABLE_OK;
   }
 
-  if (!(node = calloc (1, sizeof (obj_hash_node_t)))) {
-    pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
-    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return SYSTEM_ERROR\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
+  node = concurrent_hashtable_link_locked (&writer, 0, keyP, key_sizeP, (uintptr_t)dataP);
+  concurrent_hashtable_write_end (&writer);
+  if (!node) {
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) return SYSTEM_ERROR\n", __FUNCTION__, bdata(hashtblP->name), keyP);
     return HASH_TABLE_SYSTEM_ERROR;
   }
-
-  if (!(node->key = calloc (1, key_sizeP))) {
-    free_wrapper ((void**)&node);
-    pthread_mutex_unlock (&hashtblP->lock_nodes[hash]);
-    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return SYSTEM_ERROR\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
-    return HASH_TABLE_SYSTEM_ERROR;
-  }
-
-
-  memcpy (node->key, keyP, key_sizeP);
-  node->data = dataP;
-  node->key_size = key_sizeP;
-
-  if (hashtblP->nodes[hash]) {
-    node->next = hashtblP->nodes[hash];
-  } else {
-    node->next = NULL;
-  }
-
-  hashtblP->nodes[hash] = node;
-  __sync_fetch_and_add (&hashtblP->num_elements, 1);
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-  PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u data %p) hash %lx return OK\n", __FUNCTION__,
-          bdata(hashtblP->name), keyP, key_sizeP, dataP, hash);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, key_sizeP, dataP);
   return HASH_TABLE_OK;
 }
 
@@ -715,9 +657,8 @@ obj_hashtable_ts_free (
   const void *const keyP,
   const int key_sizeP)
 {
-  obj_hash_node_t                        *node,
-                                         *prevnode = NULL;
-  hash_size_t                             hash;
+  concurrent_hashtable_writer_t           writer = {0};
+  concurrent_hashtable_node_t            *node = NULL;
 
   if (hashtblP == NULL) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
@@ -728,32 +669,18 @@ obj_hashtable_ts_free (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if ((node->key == keyP) || ((node->key_size == key_sizeP) && (memcmp (node->key, keyP, key_sizeP) == 0))) {
-      if (prevnode) {
-        prevnode->next = node->next;
-      } else {
-        hashtblP->nodes[hash] = node->next;
-      }
+  concurrent_hashtable_write_begin (&hashtblP->map, obj_hashtable_ts_hash (hashtblP, keyP, key_sizeP), &writer);
+  if ((node = concurrent_hashtable_find_locked (&writer, 0, keyP, key_sizeP))) {
+    void                                 *data = (void *)(uintptr_t)node->value;
 
-      hashtblP->freekeyfunc (&node->key);
-      hashtblP->freedatafunc (&node->data);
-      free_wrapper ((void**)&node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
+    concurrent_hashtable_unlink_locked (&writer, node);
+    hashtblP->freedatafunc (&data);
+    concurrent_hashtable_write_end (&writer);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-
+  concurrent_hashtable_write_end (&writer);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
 
@@ -820,9 +747,8 @@ obj_hashtable_ts_remove (
   const int key_sizeP,
   void **dataP)
 {
-  obj_hash_node_t                        *node,
-                                         *prevnode = NULL;
-  hash_size_t                             hash;
+  concurrent_hashtable_writer_t           writer = {0};
+  concurrent_hashtable_node_t            *node = NULL;
 
   if (hashtblP == NULL) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
@@ -833,32 +759,16 @@ obj_hashtable_ts_remove (
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if ((node->key == keyP) || ((node->key_size == key_sizeP) && (memcmp (node->key, keyP, key_sizeP) == 0))) {
-      if (prevnode) {
-        prevnode->next = node->next;
-      } else {
-        hashtblP->nodes[hash] = node->next;
-      }
-
-      hashtblP->freekeyfunc (&node->key);
-      *dataP = node->data;
-      free_wrapper ((void**)&node);
-      __sync_fetch_and_sub (&hashtblP->num_elements, 1);
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) hash %lx return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, hash);
-      return HASH_TABLE_OK;
-    }
-
-    prevnode = node;
-    node = node->next;
+  concurrent_hashtable_write_begin (&hashtblP->map, obj_hashtable_ts_hash (hashtblP, keyP, key_sizeP), &writer);
+  if ((node = concurrent_hashtable_find_locked (&writer, 0, keyP, key_sizeP))) {
+    *dataP = (void *)(uintptr_t)node->value;
+    concurrent_hashtable_unlink_locked (&writer, node);
+    concurrent_hashtable_write_end (&writer);
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP);
+    return HASH_TABLE_OK;
   }
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-
+  concurrent_hashtable_write_end (&writer);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key %p) return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
 
@@ -923,8 +833,7 @@ obj_hashtable_ts_get (
   const int key_sizeP,
   void **dataP)
 {
-  obj_hash_node_t                        *node;
-  hash_size_t                             hash;
+  uint64_t                                value = 0;
 
   if (hashtblP == NULL) {
     *dataP = NULL;
@@ -932,38 +841,18 @@ obj_hashtable_ts_get (
   }
 
   if (keyP == NULL) {
+    *dataP = NULL;
     PRINT_HASHTABLE (hashtblP, "return HASH_TABLE_BAD_PARAMETER_KEY\n");
     return HASH_TABLE_BAD_PARAMETER_KEY;
   }
 
-  hash = hashtblP->hashfunc (keyP, key_sizeP) % hashtblP->size;
-  pthread_mutex_lock(&hashtblP->lock_nodes[hash]);
-  node = hashtblP->nodes[hash];
-
-  while (node) {
-    if (node->key == keyP) {
-      *dataP = node->data;
-      pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-      PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u data %p) hash %lx return OK\n", __FUNCTION__,
-              bdata(hashtblP->name), keyP, key_sizeP, *dataP, hash);
-      return HASH_TABLE_OK;
-    } else if (node->key_size == key_sizeP) {
-      if (memcmp (node->key, keyP, key_sizeP) == 0) {
-        *dataP = node->data;
-        pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-        PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u data %p) hash %lx return OK\n", __FUNCTION__,
-                bdata(hashtblP->name), keyP, key_sizeP, *dataP, hash);
-        return HASH_TABLE_OK;
-      }
-    }
-
-    node = node->next;
+  if (concurrent_hashtable_get ((concurrent_hashtable_t *)&hashtblP->map, obj_hashtable_ts_hash (hashtblP, keyP, key_sizeP), 0, keyP, key_sizeP, &value)) {
+    *dataP = (void *)(uintptr_t)value;
+    PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %d data %p) return OK\n", __FUNCTION__, bdata(hashtblP->name), keyP, key_sizeP, *dataP);
+    return HASH_TABLE_OK;
   }
-
   *dataP = NULL;
-  pthread_mutex_unlock(&hashtblP->lock_nodes[hash]);
-  PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %u) hash %lx return KEY_NOT_EXISTS\n", __FUNCTION__,
-          bdata(hashtblP->name), keyP, key_sizeP, hash);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key %p klen %d) return KEY_NOT_EXISTS\n", __FUNCTION__, bdata(hashtblP->name), keyP, key_sizeP);
   return HASH_TABLE_KEY_NOT_EXISTS;
 }
 
@@ -1014,33 +903,18 @@ obj_hashtable_ts_get_keys (
   void **keysP,
   unsigned int *sizeP)
 {
-  size_t                                  n = 0;
-  obj_hash_node_t                        *node = NULL;
-  obj_hash_node_t                        *next = NULL;
+  obj_hashtable_ts_iterate_arg_t iarg = {.hashtbl = (obj_hash_table_t *)hashtblP, .keys = keysP};
 
-  if (hashtblP == NULL) {
-    keysP = NULL;
+  if ((hashtblP == NULL) || (keysP == NULL)) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
 
-  *sizeP = 0;
-  keysP = calloc (hashtblP->num_elements,  sizeof (void *));
-
-  if (keysP) {
-    for (n = 0; n < hashtblP->size; ++n) {
-      pthread_mutex_lock (&hashtblP->lock_nodes[n]);
-      for (node = hashtblP->nodes[n]; node; node = next) {
-        keysP[*sizeP++] = node->key;
-        next = node->next;
-      }
-      pthread_mutex_unlock (&hashtblP->lock_nodes[n]);
-    }
-
-    PRINT_HASHTABLE (hashtblP, "return OK\n");
-    return HASH_TABLE_OK;
-  }
-  PRINT_HASHTABLE (hashtblP, "return SYSTEM_ERROR\n");
-  return HASH_TABLE_SYSTEM_ERROR;
+  // keysP must have room for all elements of the table, keys returned are the copies stored in the table
+  iarg.capacity = concurrent_hashtable_num_elements (&hashtblP->map);
+  concurrent_hashtable_iterate ((concurrent_hashtable_t *)&hashtblP->map, obj_hashtable_ts_get_keys_cb, &iarg);
+  *sizeP = iarg.num_keys;
+  PRINT_HASHTABLE (hashtblP, "return OK\n");
+  return HASH_TABLE_OK;
 }
 
 //------------------------------------------------------------------------------
@@ -1124,64 +998,12 @@ obj_hashtable_ts_resize (
   obj_hash_table_t * const hashtblP,
   const hash_size_t sizeP)
 {
-  obj_hash_table_t                        newtbl = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0};
-  hash_size_t                             n;
-  obj_hash_node_t                        *node,
-                                         *next;
-  void                                   *dummy = NULL;
-
   if (hashtblP == NULL) {
     return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
   }
-  hash_size_t size = sizeP;
-  // upper power of two: http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2Float
-  //  By Sean Eron Anderson
-  // seander@cs.stanford.edu
-  // Individually, the code snippets here are in the public domain (unless otherwise noted) — feel free to use them however you please.
-  // The aggregate collection and descriptions are © 1997-2005 Sean Eron Anderson. The code and descriptions are distributed in the hope
-  // that they will be useful, but WITHOUT ANY WARRANTY and without even the implied warranty of merchantability or fitness for a particular
-  // purpose. As of May 5, 2005, all the code has been tested thoroughly. Thousands of people have read it. Moreover, Professor Randal Bryant,
-  // the Dean of Computer Science at Carnegie Mellon University, has personally tested almost everything with his Uclid code verification system.
-  // What he hasn't tested, I have checked against all possible inputs on a 32-bit machine. To the first person to inform me of a legitimate bug
-  // in the code, I'll pay a bounty of US$10 (by check or Paypal). If directed to a charity, I'll pay US$20.
-  size--;
-  size |= size >> 1;
-  size |= size >> 2;
-  size |= size >> 4;
-  size |= size >> 8;
-  size |= size >> 16;
-  size++;
-
-  newtbl.size = size;
-  newtbl.hashfunc = hashtblP->hashfunc;
-
-  if (!(newtbl.nodes = calloc (size, sizeof (obj_hash_node_t *))))
+  if (concurrent_hashtable_reserve (&hashtblP->map, sizeP)) {
     return HASH_TABLE_SYSTEM_ERROR;
-
-  if (!(newtbl.lock_nodes = calloc (size, sizeof (pthread_mutex_t)))) {
-    free_wrapper ((void**)&newtbl.nodes);
-    return HASH_TABLE_SYSTEM_ERROR;
-  }
-  for (n = 0; n < hashtblP->size; ++n) {
-    pthread_mutex_init(&newtbl.lock_nodes[n], NULL);
   }
-
-  pthread_mutex_lock(&hashtblP->mutex);
-  for (n = 0; n < hashtblP->size; ++n) {
-    for (node = hashtblP->nodes[n]; node; node = next) {
-      next = node->next;
-      obj_hashtable_ts_remove (hashtblP, node->key, node->key_size, &dummy);
-      obj_hashtable_insert (&newtbl, node->key, node->key_size, node->data);
-    }
-  }
-
-  free_wrapper ((void**)&hashtblP->nodes);
-  free_wrapper ((void**)&hashtblP->nodes);
-  hashtblP->size = newtbl.size;
-  hashtblP->nodes = newtbl.nodes;
-  hashtblP->lock_nodes = newtbl.lock_nodes;
-  pthread_mutex_unlock(&hashtblP->mutex);
-  PRINT_HASHTABLE (hashtblP, "return OK\n");
   return HASH_TABLE_OK;
 }
 
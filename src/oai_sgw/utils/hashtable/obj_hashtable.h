@@ -49,6 +49,7 @@ typedef struct obj_hash_node_uint64_s {
 } obj_hash_node_uint64_t;
 
 typedef struct obj_hash_table_s {
+    concurrent_hashtable_t map;  /* obj_hashtable*_ts_* functions only */
     pthread_mutex_t     mutex;
     hash_size_t         size;
     hash_size_t         num_elements;
@@ -61,6 +62,7 @@ typedef struct obj_hash_table_s {
     bool                log_enabled;
 } obj_hash_table_t;
 typedef struct obj_hash_table_uint64_s {
+    concurrent_hashtable_t map;  /* obj_hashtable*_ts_* functions only */
     pthread_mutex_t     mutex;
     hash_size_t         size;
     hash_size_t         num_elements;
@@ -31,4 +31,7 @@
 
 int s11_mme_init(const mme_config_t * const mme_config);
 
+/* Queue the creation of the local S11 tunnel of a UE context restored at startup, done by the S11 task */
+void s11_mme_restore_tunnel(const teid_t local_teid, const struct in_addr peer_ip);
+
 #endif /* FILE_S11_MME_SEEN */
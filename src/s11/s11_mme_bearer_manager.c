@@ -40,6 +40,7 @@
 #include "msc.h"
 #include "assertions.h"
 #include "intertask_interface.h"
+#include "intertask_interface_latency.h"
 #include "msc.h"
 
 #include "NwGtpv2c.h"
@@ -1040,6 +1041,8 @@ s11_mme_handle_downlink_data_notification(
   MessageDef                             *message_p;
 
   DevAssert (stack_p );
+  // paging is not bound to an S1 connection, only its hops are measured
+  itti_latency_procedure_start (NULL, ITTI_LATENCY_PROC_PAGING);
   message_p = itti_alloc_new_message (TASK_S10, S11_DOWNLINK_DATA_NOTIFICATION);
   notif_p = &message_p->ittiMsg.s11_downlink_data_notification;
   memset(notif_p, 0, sizeof(*notif_p));
@@ -184,6 +184,7 @@ s11_mme_handle_create_session_response (
   resp_p = &message_p->ittiMsg.s11_create_session_response;
 
   resp_p->teid = nwGtpv2cMsgGetTeid(pUlpApi->hMsg);
+  resp_p->peer_ip.s_addr = pUlpApi->u_api_info.triggeredRspIndInfo.peerIp.s_addr;
 
   /*
    * Create a new message parser
@@ -451,6 +452,8 @@ s11_mme_handle_ulp_error_indicatior(
     rsp_p->teid = pUlpApi->u_api_info.rspFailureInfo.teidLocal;
     /** Set the transaction for the triggered acknowledgment. */
     rsp_p->trxn = (void *)pUlpApi->u_api_info.rspFailureInfo.hUlpTrxn;
+    /** The peer the request was sent to (SGW load feedback). */
+    rsp_p->peer_ip = pUlpApi->u_api_info.rspFailureInfo.peerIp;
     /** Set the cause. */
     rsp_p->cause.cause_value = SYSTEM_FAILURE; /**< Would mean that this message either did not come at all or could not be dealt with properly. */
   }
@@ -27,6 +27,8 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <inttypes.h>
@@ -56,6 +58,22 @@ static nw_gtpv2c_stack_handle_t             s11_mme_stack_handle = 0;
 // Store the GTPv2-C teid handle
 hash_table_ts_t                        *s11_mme_teid_2_gtv2c_teid_handle = NULL;
 
+/*
+ * Local tunnels of the UE contexts restored at startup. They are created by the S11 task before it handles
+ * its next message, otherwise the stack discards the S-GW requests received on them.
+ */
+typedef struct s11_mme_restored_tunnel_s {
+  teid_t                    local_teid;
+  struct in_addr            peer_ip;
+} s11_mme_restored_tunnel_t;
+
+static struct {
+  pthread_mutex_t           mutex;
+  s11_mme_restored_tunnel_t *tunnels;
+  int                       nb_tunnels;
+  int                       size;
+} s11_mme_restored = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
 static void s11_mme_exit (void);
 
 //------------------------------------------------------------------------------
@@ -84,6 +102,15 @@ s11_mme_ulp_process_stack_req_cb (
 
   switch (pUlpApi->apiType) {
     case NW_GTPV2C_ULP_API_TRIGGERED_RSP_IND:
+      switch (pUlpApi->u_api_info.triggeredRspIndInfo.msgType) {
+      case NW_GTP_CREATE_SESSION_RSP:
+      case NW_GTP_DELETE_SESSION_RSP:
+      case NW_GTP_MODIFY_BEARER_RSP:
+      case NW_GTP_RELEASE_ACCESS_BEARERS_RSP:
+        itti_transaction_end (TASK_S11);
+        break;
+      default:;
+      }
       switch (pUlpApi->u_api_info.triggeredRspIndInfo.msgType) {
       case NW_GTP_CREATE_SESSION_RSP:
         ret = s11_mme_handle_create_session_response (&s11_mme_stack_handle, pUlpApi);
@@ -140,6 +167,15 @@ s11_mme_ulp_process_stack_req_cb (
 
     /** Timeout Handler */
     case NW_GTPV2C_ULP_API_RSP_FAILURE_IND:
+       switch (pUlpApi->u_api_info.rspFailureInfo.msgType) {
+       case NW_GTP_CREATE_SESSION_REQ:
+       case NW_GTP_DELETE_SESSION_REQ:
+       case NW_GTP_MODIFY_BEARER_REQ:
+       case NW_GTP_RELEASE_ACCESS_BEARERS_REQ:
+         itti_transaction_end (TASK_S11);
+         break;
+       default:;
+       }
        ret = s11_mme_handle_ulp_error_indicatior(&s11_mme_stack_handle, pUlpApi);
        break;
        // todo: add initial reqs --> CBR / UBR / DBR !
@@ -215,6 +251,57 @@ s11_mme_stop_timer_wrapper (
   return ((timer_remove (timer_id, &timeoutArg) == 0) ? NW_OK : NW_FAILURE);
 }
 
+//------------------------------------------------------------------------------
+void
+s11_mme_restore_tunnel (
+  const teid_t local_teid,
+  const struct in_addr peer_ip)
+{
+  pthread_mutex_lock (&s11_mme_restored.mutex);
+  if (s11_mme_restored.nb_tunnels == s11_mme_restored.size) {
+    s11_mme_restored.size = (s11_mme_restored.size) ? 2 * s11_mme_restored.size : 64;
+    s11_mme_restored.tunnels = realloc (s11_mme_restored.tunnels, s11_mme_restored.size * sizeof (s11_mme_restored_tunnel_t));
+    AssertFatal (s11_mme_restored.tunnels, "Out of memory");
+  }
+  s11_mme_restored.tunnels[s11_mme_restored.nb_tunnels].local_teid = local_teid;
+  s11_mme_restored.tunnels[s11_mme_restored.nb_tunnels].peer_ip    = peer_ip;
+  __atomic_store_n (&s11_mme_restored.nb_tunnels, s11_mme_restored.nb_tunnels + 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock (&s11_mme_restored.mutex);
+}
+
+//------------------------------------------------------------------------------
+static void
+s11_mme_create_restored_tunnels (
+  void)
+{
+  nw_gtpv2c_ulp_api_t                     ulp_req;
+
+  if (!__atomic_load_n (&s11_mme_restored.nb_tunnels, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+  pthread_mutex_lock (&s11_mme_restored.mutex);
+  for (int i = 0; i < s11_mme_restored.nb_tunnels; i++) {
+    memset (&ulp_req, 0, sizeof (nw_gtpv2c_ulp_api_t));
+    ulp_req.apiType = NW_GTPV2C_ULP_CREATE_LOCAL_TUNNEL;
+    ulp_req.u_api_info.createLocalTunnelInfo.teidLocal = s11_mme_restored.tunnels[i].local_teid;
+    ulp_req.u_api_info.createLocalTunnelInfo.peerIp    = s11_mme_restored.tunnels[i].peer_ip;
+    if (NW_OK != nwGtpv2cProcessUlpReq (s11_mme_stack_handle, &ulp_req)) {
+      OAILOG_WARNING (LOG_S11, "Could not restore GTPv2-C tunnel for local teid %X\n", s11_mme_restored.tunnels[i].local_teid);
+      continue;
+    }
+    if (HASH_TABLE_OK != hashtable_ts_insert (s11_mme_teid_2_gtv2c_teid_handle,
+        (hash_key_t) s11_mme_restored.tunnels[i].local_teid, (void *)ulp_req.u_api_info.createLocalTunnelInfo.hTunnel)) {
+      OAILOG_WARNING (LOG_S11, "Could not save GTPv2-C hTunnel %p for local teid %X\n", (void*)ulp_req.u_api_info.createLocalTunnelInfo.hTunnel,
+          s11_mme_restored.tunnels[i].local_teid);
+    }
+  }
+  OAILOG_INFO (LOG_S11, "Restored %d GTPv2-C tunnel(s)\n", s11_mme_restored.nb_tunnels);
+  free_wrapper ((void**)&s11_mme_restored.tunnels);
+  s11_mme_restored.size = 0;
+  __atomic_store_n (&s11_mme_restored.nb_tunnels, 0, __ATOMIC_RELEASE);
+  pthread_mutex_unlock (&s11_mme_restored.mutex);
+}
+
 //------------------------------------------------------------------------------
 static void                            *
 s11_mme_thread (
@@ -227,6 +314,7 @@ s11_mme_thread (
 
     itti_receive_msg (TASK_S11, &received_message_p);
     assert (received_message_p );
+    s11_mme_create_restored_tunnels ();
 
     switch (ITTI_MSG_ID (received_message_p)) {
     case MESSAGE_TEST:{
@@ -250,12 +338,17 @@ s11_mme_thread (
       break;
 
     case S11_CREATE_SESSION_REQUEST:{
-        s11_mme_create_session_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_create_session_request);
+        if (RETURNok == s11_mme_create_session_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_create_session_request)) {
+          // answered or timed out in s11_mme_ulp_process_stack_req_cb ()
+          itti_transaction_start (TASK_S11);
+        }
       }
       break;
 
     case S11_DELETE_SESSION_REQUEST:{
-        s11_mme_delete_session_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_delete_session_request);
+        if (RETURNok == s11_mme_delete_session_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_delete_session_request)) {
+          itti_transaction_start (TASK_S11);
+        }
       }
       break;
 
@@ -270,12 +363,16 @@ s11_mme_thread (
       break;
 
     case S11_MODIFY_BEARER_REQUEST:{
-        s11_mme_modify_bearer_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_modify_bearer_request);
+        if (RETURNok == s11_mme_modify_bearer_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_modify_bearer_request)) {
+          itti_transaction_start (TASK_S11);
+        }
       }
       break;
 
     case S11_RELEASE_ACCESS_BEARERS_REQUEST:{
-        s11_mme_release_access_bearers_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_release_access_bearers_request);
+        if (RETURNok == s11_mme_release_access_bearers_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_release_access_bearers_request)) {
+          itti_transaction_start (TASK_S11);
+        }
       }
       break;
 
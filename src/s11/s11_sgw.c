@@ -27,6 +27,8 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <inttypes.h>
@@ -60,6 +62,22 @@ static nw_gtpv2c_stack_handle_t             s11_sgw_stack_handle = 0;
 
 hash_table_ts_t                        *s11_sgw_teid_2_gtv2c_teid_handle = NULL;
 
+/*
+ * Local tunnels of the sessions restored from the journal at startup. They are created by the S11 task before
+ * it handles its next message, otherwise the stack discards the MME requests received on them.
+ */
+typedef struct s11_sgw_restored_tunnel_s {
+  teid_t                    local_teid;
+  struct in_addr            peer_ip;
+} s11_sgw_restored_tunnel_t;
+
+static struct {
+  pthread_mutex_t           mutex;
+  s11_sgw_restored_tunnel_t *tunnels;
+  int                       nb_tunnels;
+  int                       size;
+} s11_sgw_restored = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
 static void s11_sgw_exit (void);
 
 /* ULP callback for the GTPv2-C stack */
@@ -191,6 +209,52 @@ static nw_rc_t s11_sgw_stop_timer_wrapper (
   return ret == 0 ? NW_OK : NW_FAILURE;
 }
 
+//------------------------------------------------------------------------------
+void s11_sgw_restore_tunnel (const teid_t local_teid, const struct in_addr peer_ip)
+{
+  pthread_mutex_lock (&s11_sgw_restored.mutex);
+  if (s11_sgw_restored.nb_tunnels == s11_sgw_restored.size) {
+    s11_sgw_restored.size = (s11_sgw_restored.size) ? 2 * s11_sgw_restored.size : 64;
+    s11_sgw_restored.tunnels = realloc (s11_sgw_restored.tunnels, s11_sgw_restored.size * sizeof (s11_sgw_restored_tunnel_t));
+    AssertFatal (s11_sgw_restored.tunnels, "Out of memory");
+  }
+  s11_sgw_restored.tunnels[s11_sgw_restored.nb_tunnels].local_teid = local_teid;
+  s11_sgw_restored.tunnels[s11_sgw_restored.nb_tunnels].peer_ip    = peer_ip;
+  __atomic_store_n (&s11_sgw_restored.nb_tunnels, s11_sgw_restored.nb_tunnels + 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock (&s11_sgw_restored.mutex);
+}
+
+//------------------------------------------------------------------------------
+static void s11_sgw_create_restored_tunnels (void)
+{
+  nw_gtpv2c_ulp_api_t                     ulp_req;
+
+  if (!__atomic_load_n (&s11_sgw_restored.nb_tunnels, __ATOMIC_ACQUIRE)) {
+    return;
+  }
+  pthread_mutex_lock (&s11_sgw_restored.mutex);
+  for (int i = 0; i < s11_sgw_restored.nb_tunnels; i++) {
+    memset (&ulp_req, 0, sizeof (nw_gtpv2c_ulp_api_t));
+    ulp_req.apiType = NW_GTPV2C_ULP_CREATE_LOCAL_TUNNEL;
+    ulp_req.u_api_info.createLocalTunnelInfo.teidLocal = s11_sgw_restored.tunnels[i].local_teid;
+    ulp_req.u_api_info.createLocalTunnelInfo.peerIp    = s11_sgw_restored.tunnels[i].peer_ip;
+    if (NW_OK != nwGtpv2cProcessUlpReq (s11_sgw_stack_handle, &ulp_req)) {
+      OAILOG_WARNING (LOG_S11, "Could not restore GTPv2-C tunnel for local teid %X\n", s11_sgw_restored.tunnels[i].local_teid);
+      continue;
+    }
+    if (HASH_TABLE_OK != hashtable_ts_insert (s11_sgw_teid_2_gtv2c_teid_handle,
+        (hash_key_t) s11_sgw_restored.tunnels[i].local_teid, (void *)ulp_req.u_api_info.createLocalTunnelInfo.hTunnel)) {
+      OAILOG_WARNING (LOG_S11, "Could not save GTPv2-C hTunnel %p for local teid %X\n", (void*)ulp_req.u_api_info.createLocalTunnelInfo.hTunnel,
+          s11_sgw_restored.tunnels[i].local_teid);
+    }
+  }
+  OAILOG_INFO (LOG_S11, "Restored %d GTPv2-C tunnel(s)\n", s11_sgw_restored.nb_tunnels);
+  free_wrapper ((void**)&s11_sgw_restored.tunnels);
+  s11_sgw_restored.size = 0;
+  __atomic_store_n (&s11_sgw_restored.nb_tunnels, 0, __ATOMIC_RELEASE);
+  pthread_mutex_unlock (&s11_sgw_restored.mutex);
+}
+
 //------------------------------------------------------------------------------
 static void *s11_sgw_thread (void *args)
 {
@@ -200,6 +264,7 @@ static void *s11_sgw_thread (void *args)
     MessageDef                             *received_message_p = NULL;
 
     itti_receive_msg (TASK_S11, &received_message_p);
+    s11_sgw_create_restored_tunnels ();
 
     switch (ITTI_MSG_ID (received_message_p)) {
     case UDP_DATA_IND:{
@@ -31,4 +31,7 @@
 
 int s11_sgw_init(sgw_config_t *mme_config);
 
+/* Queue the creation of the local S11 tunnel of a session restored at startup, done by the S11 task */
+void s11_sgw_restore_tunnel(const teid_t local_teid, const struct in_addr peer_ip);
+
 #endif /* FILE_S11_SGW_SEEN */
@@ -0,0 +1,871 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_fast_codec.c
+  \brief
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bstrlib.h"
+
+#include "common_defs.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_fast_codec.h"
+
+/*
+ * APER encoding of an initiating message (X.691), S1AP-PDU is an extensible CHOICE
+ * of 3 alternatives, InitiatingMessage a SEQUENCE without extension marker:
+ *   octet 0    : CHOICE extension bit (0), CHOICE index (2 bits), padding
+ *   octet 1    : procedure code INTEGER (0..255)
+ *   octet 2    : criticality ENUMERATED (2 bits), padding
+ *   octet 3..  : open type length determinant, value
+ * The value is an extensible SEQUENCE holding a SEQUENCE (SIZE (0..65535)) OF ProtocolIE-Field:
+ *   octet 0    : extension bit (0), padding
+ *   octet 1..2 : number of IEs
+ * each ProtocolIE-Field being:
+ *   octet 0..1 : id INTEGER (0..65535)
+ *   octet 2    : criticality (2 bits), padding
+ *   octet 3..  : open type length determinant, IE value
+ */
+#define S1AP_FAST_LENGTH_DETERMINANT_MAX    16383   // longer lengths are fragmented
+
+typedef enum {
+  S1AP_FAST_MME_UE_S1AP_ID = 0,
+  S1AP_FAST_ENB_UE_S1AP_ID,
+  S1AP_FAST_NAS_PDU,
+  S1AP_FAST_TAI,
+  S1AP_FAST_EUTRAN_CGI,
+  S1AP_FAST_RRC_ESTABLISHMENT_CAUSE,
+  S1AP_FAST_S_TMSI,
+  S1AP_FAST_CSG_ID,
+  S1AP_FAST_GUMMEI,
+  S1AP_FAST_CELL_ACCESS_MODE,
+  S1AP_FAST_RELAY_NODE_INDICATOR,
+  S1AP_FAST_GUMMEI_TYPE,
+  S1AP_FAST_CAUSE,
+  S1AP_FAST_GW_CONTEXT_RELEASE_INDICATION,
+  S1AP_FAST_SUBSCRIBER_PROFILE_ID_FOR_RFP,
+} s1ap_fast_ie_type_t;
+
+typedef struct s1ap_fast_ie_desc_s {
+  S1ap_ProtocolIE_ID_t        id;
+  S1ap_Criticality_t          criticality;   // criticality used when encoding (same as the generic encoder)
+  s1ap_fast_ie_type_t         type;
+  size_t                      offset;        // in the IEs structure
+  uint16_t                    presence;      // bit in presenceMask, 0 for a mandatory IE
+} s1ap_fast_ie_desc_t;
+
+typedef struct s1ap_fast_msg_desc_s {
+  S1ap_ProcedureCode_t        procedure_code;
+  size_t                      ies_size;
+  size_t                      presence_mask_offset;
+  int                         num_ies;
+  const s1ap_fast_ie_desc_t  *ies;
+} s1ap_fast_msg_desc_t;
+
+#define S1AP_FAST_IE(mSgIEs, iD, cRiT, tYpE, fIeLd, pReSeNcE) \
+  {.id = S1ap_ProtocolIE_ID_id_##iD, .criticality = S1ap_Criticality_##cRiT, .type = S1AP_FAST_##tYpE, .offset = offsetof(mSgIEs, fIeLd), .presence = (pReSeNcE)}
+
+/* IEs are listed in the order used by the generic encoder. */
+static const s1ap_fast_ie_desc_t s1ap_fast_uplink_nas_transport_ies[] = {
+  S1AP_FAST_IE (S1ap_UplinkNASTransportIEs_t, MME_UE_S1AP_ID, reject, MME_UE_S1AP_ID, mme_ue_s1ap_id, 0),
+  S1AP_FAST_IE (S1ap_UplinkNASTransportIEs_t, eNB_UE_S1AP_ID, reject, ENB_UE_S1AP_ID, eNB_UE_S1AP_ID, 0),
+  S1AP_FAST_IE (S1ap_UplinkNASTransportIEs_t, NAS_PDU,        reject, NAS_PDU,        nas_pdu,        0),
+  S1AP_FAST_IE (S1ap_UplinkNASTransportIEs_t, EUTRAN_CGI,     ignore, EUTRAN_CGI,     eutran_cgi,     0),
+  S1AP_FAST_IE (S1ap_UplinkNASTransportIEs_t, TAI,            ignore, TAI,            tai,            0),
+};
+
+static const s1ap_fast_ie_desc_t s1ap_fast_downlink_nas_transport_ies[] = {
+  S1AP_FAST_IE (S1ap_DownlinkNASTransportIEs_t, MME_UE_S1AP_ID,            reject, MME_UE_S1AP_ID,            mme_ue_s1ap_id,            0),
+  S1AP_FAST_IE (S1ap_DownlinkNASTransportIEs_t, eNB_UE_S1AP_ID,            reject, ENB_UE_S1AP_ID,            eNB_UE_S1AP_ID,            0),
+  S1AP_FAST_IE (S1ap_DownlinkNASTransportIEs_t, NAS_PDU,                   reject, NAS_PDU,                   nas_pdu,                   0),
+  S1AP_FAST_IE (S1ap_DownlinkNASTransportIEs_t, SubscriberProfileIDforRFP, ignore, SUBSCRIBER_PROFILE_ID_FOR_RFP, subscriberProfileIDforRFP,
+                S1AP_DOWNLINKNASTRANSPORTIES_SUBSCRIBERPROFILEIDFORRFP_PRESENT),
+};
+
+static const s1ap_fast_ie_desc_t s1ap_fast_initial_ue_message_ies[] = {
+  S1AP_FAST_IE (S1ap_InitialUEMessageIEs_t, eNB_UE_S1AP_ID,          reject, ENB_UE_S1AP_ID,          eNB_UE_S1AP_ID,          0),
+  S1AP_FAST_IE (S1ap_InitialUEMessageIEs_t, NAS_PDU,                 reject, NAS_PDU,                 nas_pdu,                 0),
+  S1AP_FAST_IE (S1ap_InitialUEMessageIEs_t, TAI,                     reject, TAI,                     tai,                     0),
+  S1AP_FAST_IE (S1ap_InitialUEMessageIEs_t, EUTRAN_CGI,              ignore, EUTRAN_CGI,              eutran_cgi,              0),
+  S1AP_FAST_IE (S1ap_InitialUEMessageIEs_t, RRC_Establishment_Cause, ignore, RRC_ESTABLISHMENT_CAUSE, rrC_Establishment_Cause, 0),
+  S1AP_FAST_IE (S1ap_InitialUEMessageIEs_t, S_TMSI,                  reject, S_TMSI,                  s_tmsi,                  S1AP_INITIALUEMESSAGEIES_S_TMSI_PRESENT),
+  S1AP_FAST_IE (S1ap_InitialUEMessageIEs_t, CSG_Id,                  reject, CSG_ID,                  csG_Id,                  S1AP_INITIALUEMESSAGEIES_CSG_ID_PRESENT),
+  S1AP_FAST_IE (S1ap_InitialUEMessageIEs_t, GUMMEI_ID,               reject, GUMMEI,                  gummei_id,               S1AP_INITIALUEMESSAGEIES_GUMMEI_ID_PRESENT),
+  S1AP_FAST_IE (S1ap_InitialUEMessageIEs_t, CellAccessMode,          reject, CELL_ACCESS_MODE,        cellAccessMode,          S1AP_INITIALUEMESSAGEIES_CELLACCESSMODE_PRESENT),
+  S1AP_FAST_IE (S1ap_InitialUEMessageIEs_t, RelayNode_Indicator,     reject, RELAY_NODE_INDICATOR,    relayNode_Indicator,     S1AP_INITIALUEMESSAGEIES_RELAYNODE_INDICATOR_PRESENT),
+  S1AP_FAST_IE (S1ap_InitialUEMessageIEs_t, GUMMEIType,              ignore, GUMMEI_TYPE,             gummeiType,              S1AP_INITIALUEMESSAGEIES_GUMMEITYPE_PRESENT),
+};
+
+static const s1ap_fast_ie_desc_t s1ap_fast_ue_context_release_request_ies[] = {
+  S1AP_FAST_IE (S1ap_UEContextReleaseRequestIEs_t, MME_UE_S1AP_ID,             reject, MME_UE_S1AP_ID,             mme_ue_s1ap_id,             0),
+  S1AP_FAST_IE (S1ap_UEContextReleaseRequestIEs_t, eNB_UE_S1AP_ID,             reject, ENB_UE_S1AP_ID,             eNB_UE_S1AP_ID,             0),
+  S1AP_FAST_IE (S1ap_UEContextReleaseRequestIEs_t, Cause,                      ignore, CAUSE,                      cause,                      0),
+  S1AP_FAST_IE (S1ap_UEContextReleaseRequestIEs_t, GWContextReleaseIndication, reject, GW_CONTEXT_RELEASE_INDICATION, gwContextReleaseIndication,
+                S1AP_UECONTEXTRELEASEREQUESTIES_GWCONTEXTRELEASEINDICATION_PRESENT),
+};
+
+#define S1AP_FAST_MSG(pRoC, mSgIEs, iEs) \
+  {.procedure_code = S1ap_ProcedureCode_id_##pRoC, .ies_size = sizeof(mSgIEs), .presence_mask_offset = offsetof(mSgIEs, presenceMask), \
+   .num_ies = sizeof(iEs)/sizeof(iEs[0]), .ies = iEs}
+
+static const s1ap_fast_msg_desc_t s1ap_fast_msgs[] = {
+  S1AP_FAST_MSG (uplinkNASTransport,      S1ap_UplinkNASTransportIEs_t,      s1ap_fast_uplink_nas_transport_ies),
+  S1AP_FAST_MSG (downlinkNASTransport,    S1ap_DownlinkNASTransportIEs_t,    s1ap_fast_downlink_nas_transport_ies),
+  S1AP_FAST_MSG (initialUEMessage,        S1ap_InitialUEMessageIEs_t,        s1ap_fast_initial_ue_message_ies),
+  S1AP_FAST_MSG (UEContextReleaseRequest, S1ap_UEContextReleaseRequestIEs_t, s1ap_fast_ue_context_release_request_ies),
+};
+
+/* Largest IEs structure handled, decoding is done in a temporary copy. */
+typedef union s1ap_fast_ies_u {
+  S1ap_UplinkNASTransportIEs_t            uplink_nas_transport;
+  S1ap_DownlinkNASTransportIEs_t          downlink_nas_transport;
+  S1ap_InitialUEMessageIEs_t              initial_ue_message;
+  S1ap_UEContextReleaseRequestIEs_t       ue_context_release_request;
+} s1ap_fast_ies_t;
+
+/* CauseRadioNetwork, CauseTransport, CauseNas, CauseProtocol, CauseMisc: root values, extension values, bits of root index. */
+static const uint8_t s1ap_fast_cause_root_values[]      = {36, 2, 4, 7, 6};
+static const uint8_t s1ap_fast_cause_extension_values[] = { 3, 0, 1, 0, 0};
+static const uint8_t s1ap_fast_cause_root_bits[]        = { 6, 1, 2, 3, 3};
+
+#define S1AP_FAST_RRC_ESTABLISHMENT_CAUSE_ROOT_VALUES    5
+#define S1AP_FAST_RRC_ESTABLISHMENT_CAUSE_VALUES         6
+
+//------------------------------------------------------------------------------
+static inline const s1ap_fast_msg_desc_t * s1ap_fast_get_msg_desc (const S1ap_ProcedureCode_t procedure_code)
+{
+  for (int i = 0; i < sizeof (s1ap_fast_msgs) / sizeof (s1ap_fast_msgs[0]); i++) {
+    if (procedure_code == s1ap_fast_msgs[i].procedure_code) {
+      return &s1ap_fast_msgs[i];
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+bool s1ap_fast_codec_is_handled_procedure (const S1ap_ProcedureCode_t procedure_code)
+{
+  return (NULL != s1ap_fast_get_msg_desc (procedure_code));
+}
+
+//------------------------------------------------------------------------------
+// Length determinant (X.691 10.9), return number of octets read, -1 if not handled
+static inline int s1ap_fast_get_length (const uint8_t * const p, const uint32_t available, uint32_t * const length)
+{
+  if (available < 1) {
+    return -1;
+  }
+  if (!(p[0] & 0x80)) {
+    *length = p[0];
+    return 1;
+  }
+  if (((p[0] & 0xC0) == 0x80) && (available >= 2)) {
+    *length = ((uint32_t)(p[0] & 0x3F) << 8) | p[1];
+    return 2;
+  }
+  return -1; // fragmented
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t s1ap_fast_length_size (const uint32_t length)
+{
+  return (length < 128) ? 1 : 2;
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t s1ap_fast_put_length (uint8_t * const p, const uint32_t length)
+{
+  if (length < 128) {
+    p[0] = (uint8_t)length;
+    return 1;
+  }
+  p[0] = 0x80 | (uint8_t)(length >> 8);
+  p[1] = (uint8_t)length;
+  return 2;
+}
+
+//------------------------------------------------------------------------------
+static int s1ap_fast_octet_string_set (OCTET_STRING_t * const os, const uint8_t * const data, const uint32_t size)
+{
+  // same layout as asn1c decoders: one more zeroed octet
+  os->buf = malloc (size + 1);
+  if (!os->buf) {
+    return RETURNerror;
+  }
+  memcpy (os->buf, data, size);
+  os->buf[size] = 0;
+  os->size = size;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int s1ap_fast_bit_string_set (BIT_STRING_t * const bs, const uint8_t * const data, const uint32_t size, const int bits_unused)
+{
+  if (RETURNok != s1ap_fast_octet_string_set ((OCTET_STRING_t *)bs, data, size)) {
+    return RETURNerror;
+  }
+  bs->buf[size - 1] &= (uint8_t)(0xFF << bits_unused);
+  bs->bits_unused = bits_unused;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void s1ap_fast_free_ie (const s1ap_fast_ie_type_t type, void * const field)
+{
+  switch (type) {
+  case S1AP_FAST_NAS_PDU:
+  case S1AP_FAST_CSG_ID:
+    free (((OCTET_STRING_t *)field)->buf);
+    break;
+  case S1AP_FAST_TAI:
+    free (((S1ap_TAI_t *)field)->pLMNidentity.buf);
+    free (((S1ap_TAI_t *)field)->tAC.buf);
+    break;
+  case S1AP_FAST_EUTRAN_CGI:
+    free (((S1ap_EUTRAN_CGI_t *)field)->pLMNidentity.buf);
+    free (((S1ap_EUTRAN_CGI_t *)field)->cell_ID.buf);
+    break;
+  case S1AP_FAST_S_TMSI:
+    free (((S1ap_S_TMSI_t *)field)->mMEC.buf);
+    free (((S1ap_S_TMSI_t *)field)->m_TMSI.buf);
+    break;
+  case S1AP_FAST_GUMMEI:
+    free (((S1ap_GUMMEI_t *)field)->pLMN_Identity.buf);
+    free (((S1ap_GUMMEI_t *)field)->mME_Group_ID.buf);
+    free (((S1ap_GUMMEI_t *)field)->mME_Code.buf);
+    break;
+  default:
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Constrained whole number of range > 64K (X.691 10.5.7.4): octet count - 1 in 2 bits, octet aligned value
+static int s1ap_fast_decode_ue_s1ap_id (const uint8_t * const p, const uint32_t length, const int max_octets, unsigned long * const value)
+{
+  int                                     octets = 0;
+
+  if (length < 1) {
+    return RETURNerror;
+  }
+  octets = (p[0] >> 6) + 1;
+  if ((octets > max_octets) || (length != 1 + octets)) {
+    return RETURNerror;
+  }
+  *value = 0;
+  for (int i = 1; i <= octets; i++) {
+    *value = (*value << 8) | p[i];
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int s1ap_fast_decode_ie (const s1ap_fast_ie_type_t type, const uint8_t * const p, const uint32_t length, void * const field)
+{
+  unsigned long                           value = 0;
+
+  switch (type) {
+  case S1AP_FAST_MME_UE_S1AP_ID:
+    if (RETURNok != s1ap_fast_decode_ue_s1ap_id (p, length, 4, &value)) {
+      return RETURNerror;
+    }
+    *(S1ap_MME_UE_S1AP_ID_t *)field = value;
+    return RETURNok;
+
+  case S1AP_FAST_ENB_UE_S1AP_ID:
+    if (RETURNok != s1ap_fast_decode_ue_s1ap_id (p, length, 3, &value)) {
+      return RETURNerror;
+    }
+    *(S1ap_ENB_UE_S1AP_ID_t *)field = (S1ap_ENB_UE_S1AP_ID_t)value;
+    return RETURNok;
+
+  case S1AP_FAST_NAS_PDU: {
+      uint32_t size = 0;
+      int      n = s1ap_fast_get_length (p, length, &size);
+
+      if ((n < 0) || (length != n + size)) {
+        return RETURNerror;
+      }
+      return s1ap_fast_octet_string_set ((OCTET_STRING_t *)field, &p[n], size);
+    }
+
+  case S1AP_FAST_TAI: {
+      S1ap_TAI_t *tai = (S1ap_TAI_t *)field;
+
+      // extension bit, iE-Extensions presence bit, padding, PLMN identity, TAC
+      if ((length != 6) || (p[0] & 0xC0)) {
+        return RETURNerror;
+      }
+      if ((RETURNok != s1ap_fast_octet_string_set (&tai->pLMNidentity, &p[1], 3)) ||
+          (RETURNok != s1ap_fast_octet_string_set (&tai->tAC, &p[4], 2))) {
+        s1ap_fast_free_ie (type, field);
+        return RETURNerror;
+      }
+      return RETURNok;
+    }
+
+  case S1AP_FAST_EUTRAN_CGI: {
+      S1ap_EUTRAN_CGI_t *cgi = (S1ap_EUTRAN_CGI_t *)field;
+
+      // extension bit, iE-Extensions presence bit, padding, PLMN identity, cell identity BIT STRING (SIZE (28))
+      if ((length != 8) || (p[0] & 0xC0)) {
+        return RETURNerror;
+      }
+      if ((RETURNok != s1ap_fast_octet_string_set (&cgi->pLMNidentity, &p[1], 3)) ||
+          (RETURNok != s1ap_fast_bit_string_set (&cgi->cell_ID, &p[4], 4, 4))) {
+        s1ap_fast_free_ie (type, field);
+        return RETURNerror;
+      }
+      return RETURNok;
+    }
+
+  case S1AP_FAST_RRC_ESTABLISHMENT_CAUSE:
+    if (length != 1) {
+      return RETURNerror;
+    }
+    if (p[0] & 0x80) {
+      // extension value: normally small non-negative whole number, only delay-TolerantAccess is known
+      if (p[0] & 0x7F) {
+        return RETURNerror;
+      }
+      *(S1ap_RRC_Establishment_Cause_t *)field = S1AP_FAST_RRC_ESTABLISHMENT_CAUSE_ROOT_VALUES;
+      return RETURNok;
+    }
+    if (((p[0] >> 4) & 0x07) >= S1AP_FAST_RRC_ESTABLISHMENT_CAUSE_ROOT_VALUES) {
+      return RETURNerror;
+    }
+    *(S1ap_RRC_Establishment_Cause_t *)field = (p[0] >> 4) & 0x07;
+    return RETURNok;
+
+  case S1AP_FAST_S_TMSI: {
+      S1ap_S_TMSI_t *s_tmsi = (S1ap_S_TMSI_t *)field;
+      uint8_t        mmec = 0;
+
+      // extension bit, iE-Extensions presence bit, MME code (8 bits, not aligned), padding, M-TMSI
+      if ((length != 6) || (p[0] & 0xC0)) {
+        return RETURNerror;
+      }
+      mmec = (uint8_t)((p[0] << 2) | (p[1] >> 6));
+      if ((RETURNok != s1ap_fast_octet_string_set (&s_tmsi->mMEC, &mmec, 1)) ||
+          (RETURNok != s1ap_fast_octet_string_set (&s_tmsi->m_TMSI, &p[2], 4))) {
+        s1ap_fast_free_ie (type, field);
+        return RETURNerror;
+      }
+      return RETURNok;
+    }
+
+  case S1AP_FAST_CSG_ID:
+    // BIT STRING (SIZE (27))
+    if (length != 4) {
+      return RETURNerror;
+    }
+    return s1ap_fast_bit_string_set ((BIT_STRING_t *)field, p, 4, 5);
+
+  case S1AP_FAST_GUMMEI: {
+      S1ap_GUMMEI_t *gummei = (S1ap_GUMMEI_t *)field;
+
+      // extension bit, iE-Extensions presence bit, padding, PLMN identity, MME group id, MME code
+      if ((length != 7) || (p[0] & 0xC0)) {
+        return RETURNerror;
+      }
+      if ((RETURNok != s1ap_fast_octet_string_set (&gummei->pLMN_Identity, &p[1], 3)) ||
+          (RETURNok != s1ap_fast_octet_string_set (&gummei->mME_Group_ID, &p[4], 2)) ||
+          (RETURNok != s1ap_fast_octet_string_set (&gummei->mME_Code, &p[6], 1))) {
+        s1ap_fast_free_ie (type, field);
+        return RETURNerror;
+      }
+      return RETURNok;
+    }
+
+  case S1AP_FAST_CELL_ACCESS_MODE:
+  case S1AP_FAST_RELAY_NODE_INDICATOR:
+  case S1AP_FAST_GW_CONTEXT_RELEASE_INDICATION:
+    // extensible ENUMERATED with a single root value
+    if ((length != 1) || (p[0] & 0x80)) {
+      return RETURNerror;
+    }
+    *(long *)field = 0;
+    return RETURNok;
+
+  case S1AP_FAST_GUMMEI_TYPE:
+    if ((length != 1) || (p[0] & 0x80)) {
+      return RETURNerror;
+    }
+    *(S1ap_GUMMEIType_t *)field = (p[0] >> 6) & 0x01;
+    return RETURNok;
+
+  case S1AP_FAST_SUBSCRIBER_PROFILE_ID_FOR_RFP:
+    // INTEGER (1..256), one octet aligned
+    if (length != 1) {
+      return RETURNerror;
+    }
+    *(S1ap_SubscriberProfileIDforRFP_t *)field = (long)p[0] + 1;
+    return RETURNok;
+
+  case S1AP_FAST_CAUSE: {
+      S1ap_Cause_t *cause = (S1ap_Cause_t *)field;
+      uint16_t      bits = (uint16_t)(p[0] << 8) | ((length > 1) ? p[1] : 0);
+      int           index = (bits >> 12) & 0x07;
+      long          value = 0;
+      uint32_t      expected_length = 0;
+
+      // CHOICE extension bit, CHOICE index (3 bits), ENUMERATED extension bit, ENUMERATED value
+      if ((length < 1) || (length > 2) || (bits & 0x8000) || (index > 4)) {
+        return RETURNerror;
+      }
+      if (bits & 0x0800) {
+        // normally small non-negative whole number
+        if ((bits & 0x0400) || (((bits >> 4) & 0x3F) >= s1ap_fast_cause_extension_values[index])) {
+          return RETURNerror;
+        }
+        value = s1ap_fast_cause_root_values[index] + ((bits >> 4) & 0x3F);
+        expected_length = 2;
+      } else {
+        value = (bits >> (11 - s1ap_fast_cause_root_bits[index])) & ((1 << s1ap_fast_cause_root_bits[index]) - 1);
+        if (value >= s1ap_fast_cause_root_values[index]) {
+          return RETURNerror;
+        }
+        expected_length = (5 + s1ap_fast_cause_root_bits[index] + 7) / 8;
+      }
+      if (length != expected_length) {
+        return RETURNerror;
+      }
+      cause->present = S1ap_Cause_PR_radioNetwork + index;
+      switch (cause->present) {
+      case S1ap_Cause_PR_radioNetwork: cause->choice.radioNetwork = value; break;
+      case S1ap_Cause_PR_transport:    cause->choice.transport = value;    break;
+      case S1ap_Cause_PR_nas:          cause->choice.nas = value;          break;
+      case S1ap_Cause_PR_protocol:     cause->choice.protocol = value;     break;
+      default:                         cause->choice.misc = value;         break;
+      }
+      return RETURNok;
+    }
+
+  default:
+    return RETURNerror;
+  }
+}
+
+//------------------------------------------------------------------------------
+int s1ap_fast_codec_decode_pdu (s1ap_message * const message, const uint8_t * const buffer, const uint32_t length)
+{
+  const s1ap_fast_msg_desc_t             *msg_desc = NULL;
+  s1ap_fast_ies_t                         ies;
+  uint32_t                                decoded_ies = 0;   // bit per IE descriptor
+  uint32_t                                value_length = 0;
+  uint32_t                                offset = 3;
+  int                                     n = 0;
+
+  // initiating message without extension, criticality padding bits
+  if ((!buffer) || (length < 7) || (buffer[0]) || (buffer[2] & 0x3F) || ((buffer[2] >> 6) > S1ap_Criticality_notify)) {
+    return RETURNerror;
+  }
+  if (!(msg_desc = s1ap_fast_get_msg_desc (buffer[1]))) {
+    return RETURNerror;
+  }
+  if (((n = s1ap_fast_get_length (&buffer[offset], length - offset, &value_length)) < 0) ||
+      (length != offset + n + value_length) || (value_length < 3)) {
+    return RETURNerror;
+  }
+  offset += n;
+  // no SEQUENCE extension, IE count
+  if (buffer[offset]) {
+    return RETURNerror;
+  }
+  uint32_t num_ies = ((uint32_t)buffer[offset + 1] << 8) | buffer[offset + 2];
+  offset += 3;
+
+  memset (&ies, 0, sizeof (ies));
+  uint16_t *presence_mask = (uint16_t *)((uint8_t *)&ies + msg_desc->presence_mask_offset);
+
+  for (uint32_t i = 0; i < num_ies; i++) {
+    const s1ap_fast_ie_desc_t *ie_desc = NULL;
+    uint32_t                   ie_length = 0;
+    int                        d = 0;
+
+    if ((length - offset < 4) || (buffer[offset + 2] & 0x3F)) {
+      goto fallback;
+    }
+    S1ap_ProtocolIE_ID_t id = ((S1ap_ProtocolIE_ID_t)buffer[offset] << 8) | buffer[offset + 1];
+    for (d = 0; d < msg_desc->num_ies; d++) {
+      if (id == msg_desc->ies[d].id) {
+        ie_desc = &msg_desc->ies[d];
+        break;
+      }
+    }
+    // unknown or repeated IE
+    if ((!ie_desc) || (decoded_ies & (1 << d))) {
+      goto fallback;
+    }
+    offset += 3;
+    if (((n = s1ap_fast_get_length (&buffer[offset], length - offset, &ie_length)) < 0) || (length - offset - n < ie_length) || (!ie_length)) {
+      goto fallback;
+    }
+    offset += n;
+    if (RETURNok != s1ap_fast_decode_ie (ie_desc->type, &buffer[offset], ie_length, (uint8_t *)&ies + ie_desc->offset)) {
+      goto fallback;
+    }
+    decoded_ies |= (1 << d);
+    *presence_mask |= ie_desc->presence;
+    offset += ie_length;
+  }
+  if (offset != length) {
+    goto fallback;
+  }
+  for (int d = 0; d < msg_desc->num_ies; d++) {
+    if ((!msg_desc->ies[d].presence) && (!(decoded_ies & (1 << d)))) {
+      goto fallback;
+    }
+  }
+
+  message->procedureCode = msg_desc->procedure_code;
+  message->criticality   = buffer[2] >> 6;
+  message->direction     = S1AP_PDU_PR_initiatingMessage;
+  memcpy (&message->msg, &ies, msg_desc->ies_size);
+  return RETURNok;
+
+fallback:
+  for (int d = 0; d < msg_desc->num_ies; d++) {
+    if (decoded_ies & (1 << d)) {
+      s1ap_fast_free_ie (msg_desc->ies[d].type, (uint8_t *)&ies + msg_desc->ies[d].offset);
+    }
+  }
+  return RETURNerror;
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t s1ap_fast_ue_s1ap_id_octets (const unsigned long value)
+{
+  return (value > 0xFFFFFF) ? 4 : (value > 0xFFFF) ? 3 : (value > 0xFF) ? 2 : 1;
+}
+
+//------------------------------------------------------------------------------
+// Return the length of the IE value, 0 if not handled
+static uint32_t s1ap_fast_ie_length (const s1ap_fast_ie_type_t type, const void * const field)
+{
+  switch (type) {
+  case S1AP_FAST_MME_UE_S1AP_ID:
+    if (*(const S1ap_MME_UE_S1AP_ID_t *)field > 0xFFFFFFFF) {
+      return 0;
+    }
+    return 1 + s1ap_fast_ue_s1ap_id_octets (*(const S1ap_MME_UE_S1AP_ID_t *)field);
+
+  case S1AP_FAST_ENB_UE_S1AP_ID:
+    if ((*(const S1ap_ENB_UE_S1AP_ID_t *)field < 0) || (*(const S1ap_ENB_UE_S1AP_ID_t *)field > 0xFFFFFF)) {
+      return 0;
+    }
+    return 1 + s1ap_fast_ue_s1ap_id_octets (*(const S1ap_ENB_UE_S1AP_ID_t *)field);
+
+  case S1AP_FAST_NAS_PDU: {
+      const OCTET_STRING_t *nas_pdu = (const OCTET_STRING_t *)field;
+
+      if ((nas_pdu->size < 0) || (nas_pdu->size > S1AP_FAST_LENGTH_DETERMINANT_MAX) || ((!nas_pdu->buf) && (nas_pdu->size))) {
+        return 0;
+      }
+      return s1ap_fast_length_size (nas_pdu->size) + nas_pdu->size;
+    }
+
+  case S1AP_FAST_TAI: {
+      const S1ap_TAI_t *tai = (const S1ap_TAI_t *)field;
+
+      return ((tai->pLMNidentity.size == 3) && (tai->tAC.size == 2) && (!tai->iE_Extensions)) ? 6 : 0;
+    }
+
+  case S1AP_FAST_EUTRAN_CGI: {
+      const S1ap_EUTRAN_CGI_t *cgi = (const S1ap_EUTRAN_CGI_t *)field;
+
+      return ((cgi->pLMNidentity.size == 3) && (cgi->cell_ID.size == 4) && (!cgi->iE_Extensions)) ? 8 : 0;
+    }
+
+  case S1AP_FAST_RRC_ESTABLISHMENT_CAUSE: {
+      const S1ap_RRC_Establishment_Cause_t value = *(const S1ap_RRC_Establishment_Cause_t *)field;
+
+      return ((value >= 0) && (value < S1AP_FAST_RRC_ESTABLISHMENT_CAUSE_VALUES)) ? 1 : 0;
+    }
+
+  case S1AP_FAST_S_TMSI: {
+      const S1ap_S_TMSI_t *s_tmsi = (const S1ap_S_TMSI_t *)field;
+
+      return ((s_tmsi->mMEC.size == 1) && (s_tmsi->m_TMSI.size == 4) && (!s_tmsi->iE_Extensions)) ? 6 : 0;
+    }
+
+  case S1AP_FAST_CSG_ID:
+    return (((const BIT_STRING_t *)field)->size == 4) ? 4 : 0;
+
+  case S1AP_FAST_GUMMEI: {
+      const S1ap_GUMMEI_t *gummei = (const S1ap_GUMMEI_t *)field;
+
+      return ((gummei->pLMN_Identity.size == 3) && (gummei->mME_Group_ID.size == 2) && (gummei->mME_Code.size == 1) && (!gummei->iE_Extensions)) ? 7 : 0;
+    }
+
+  case S1AP_FAST_CELL_ACCESS_MODE:
+  case S1AP_FAST_RELAY_NODE_INDICATOR:
+  case S1AP_FAST_GW_CONTEXT_RELEASE_INDICATION:
+    return (0 == *(const long *)field) ? 1 : 0;
+
+  case S1AP_FAST_GUMMEI_TYPE:
+    return ((*(const S1ap_GUMMEIType_t *)field == 0) || (*(const S1ap_GUMMEIType_t *)field == 1)) ? 1 : 0;
+
+  case S1AP_FAST_SUBSCRIBER_PROFILE_ID_FOR_RFP: {
+      const S1ap_SubscriberProfileIDforRFP_t value = *(const S1ap_SubscriberProfileIDforRFP_t *)field;
+
+      return ((value >= 1) && (value <= 256)) ? 1 : 0;
+    }
+
+  case S1AP_FAST_CAUSE: {
+      const S1ap_Cause_t *cause = (const S1ap_Cause_t *)field;
+      int                 index = (int)cause->present - S1ap_Cause_PR_radioNetwork;
+      long                value = 0;
+
+      if ((index < 0) || (index > 4)) {
+        return 0;
+      }
+      value = cause->choice.radioNetwork; // all alternatives are long
+      if ((value < 0) || (value >= s1ap_fast_cause_root_values[index] + s1ap_fast_cause_extension_values[index])) {
+        return 0;
+      }
+      return (value < s1ap_fast_cause_root_values[index]) ? (5 + s1ap_fast_cause_root_bits[index] + 7) / 8 : 2;
+    }
+
+  default:
+    return 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void s1ap_fast_encode_ie (const s1ap_fast_ie_type_t type, const void * const field, uint8_t * const p)
+{
+  switch (type) {
+  case S1AP_FAST_MME_UE_S1AP_ID:
+  case S1AP_FAST_ENB_UE_S1AP_ID: {
+      unsigned long value  = (S1AP_FAST_MME_UE_S1AP_ID == type) ?
+          *(const S1ap_MME_UE_S1AP_ID_t *)field : (unsigned long)*(const S1ap_ENB_UE_S1AP_ID_t *)field;
+      uint32_t      octets = s1ap_fast_ue_s1ap_id_octets (value);
+
+      p[0] = (uint8_t)((octets - 1) << 6);
+      for (uint32_t i = octets; i > 0; i--) {
+        p[i] = (uint8_t)value;
+        value >>= 8;
+      }
+    }
+    break;
+
+  case S1AP_FAST_NAS_PDU: {
+      const OCTET_STRING_t *nas_pdu = (const OCTET_STRING_t *)field;
+      uint32_t              n = s1ap_fast_put_length (p, nas_pdu->size);
+
+      if (nas_pdu->size) {
+        memcpy (&p[n], nas_pdu->buf, nas_pdu->size);
+      }
+    }
+    break;
+
+  case S1AP_FAST_TAI: {
+      const S1ap_TAI_t *tai = (const S1ap_TAI_t *)field;
+
+      p[0] = 0;
+      memcpy (&p[1], tai->pLMNidentity.buf, 3);
+      memcpy (&p[4], tai->tAC.buf, 2);
+    }
+    break;
+
+  case S1AP_FAST_EUTRAN_CGI: {
+      const S1ap_EUTRAN_CGI_t *cgi = (const S1ap_EUTRAN_CGI_t *)field;
+
+      p[0] = 0;
+      memcpy (&p[1], cgi->pLMNidentity.buf, 3);
+      memcpy (&p[4], cgi->cell_ID.buf, 4);
+      p[7] &= 0xF0;
+    }
+    break;
+
+  case S1AP_FAST_RRC_ESTABLISHMENT_CAUSE: {
+      const S1ap_RRC_Establishment_Cause_t value = *(const S1ap_RRC_Establishment_Cause_t *)field;
+
+      p[0] = (value < S1AP_FAST_RRC_ESTABLISHMENT_CAUSE_ROOT_VALUES) ? (uint8_t)(value << 4) : 0x80 | (uint8_t)(value - S1AP_FAST_RRC_ESTABLISHMENT_CAUSE_ROOT_VALUES);
+    }
+    break;
+
+  case S1AP_FAST_S_TMSI: {
+      const S1ap_S_TMSI_t *s_tmsi = (const S1ap_S_TMSI_t *)field;
+
+      p[0] = s_tmsi->mMEC.buf[0] >> 2;
+      p[1] = (uint8_t)(s_tmsi->mMEC.buf[0] << 6);
+      memcpy (&p[2], s_tmsi->m_TMSI.buf, 4);
+    }
+    break;
+
+  case S1AP_FAST_CSG_ID:
+    memcpy (p, ((const BIT_STRING_t *)field)->buf, 4);
+    p[3] &= 0xE0;
+    break;
+
+  case S1AP_FAST_GUMMEI: {
+      const S1ap_GUMMEI_t *gummei = (const S1ap_GUMMEI_t *)field;
+
+      p[0] = 0;
+      memcpy (&p[1], gummei->pLMN_Identity.buf, 3);
+      memcpy (&p[4], gummei->mME_Group_ID.buf, 2);
+      p[6] = gummei->mME_Code.buf[0];
+    }
+    break;
+
+  case S1AP_FAST_CELL_ACCESS_MODE:
+  case S1AP_FAST_RELAY_NODE_INDICATOR:
+  case S1AP_FAST_GW_CONTEXT_RELEASE_INDICATION:
+    p[0] = 0;
+    break;
+
+  case S1AP_FAST_GUMMEI_TYPE:
+    p[0] = (uint8_t)(*(const S1ap_GUMMEIType_t *)field << 6);
+    break;
+
+  case S1AP_FAST_SUBSCRIBER_PROFILE_ID_FOR_RFP:
+    p[0] = (uint8_t)(*(const S1ap_SubscriberProfileIDforRFP_t *)field - 1);
+    break;
+
+  case S1AP_FAST_CAUSE: {
+      const S1ap_Cause_t *cause = (const S1ap_Cause_t *)field;
+      int                 index = (int)cause->present - S1ap_Cause_PR_radioNetwork;
+      long                value = cause->choice.radioNetwork;
+      uint16_t            bits = (uint16_t)(index << 12);
+
+      if (value < s1ap_fast_cause_root_values[index]) {
+        bits |= (uint16_t)(value << (11 - s1ap_fast_cause_root_bits[index]));
+      } else {
+        bits |= 0x0800 | (uint16_t)((value - s1ap_fast_cause_root_values[index]) << 4);
+      }
+      p[0] = (uint8_t)(bits >> 8);
+      if (s1ap_fast_ie_length (type, field) > 1) {
+        p[1] = (uint8_t)bits;
+      }
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Return the length of the PDU value (IE container), 0 if not handled
+static uint32_t s1ap_fast_value_length (const s1ap_fast_msg_desc_t * const msg_desc, const uint8_t * const ies, uint32_t * const num_ies)
+{
+  const uint16_t                          presence_mask = *(const uint16_t *)(ies + msg_desc->presence_mask_offset);
+  uint16_t                                handled_presence = 0;
+  uint32_t                                value_length = 3;
+
+  *num_ies = 0;
+  for (int d = 0; d < msg_desc->num_ies; d++) {
+    const s1ap_fast_ie_desc_t *ie_desc = &msg_desc->ies[d];
+
+    handled_presence |= ie_desc->presence;
+    if ((ie_desc->presence) && (!(presence_mask & ie_desc->presence))) {
+      continue;
+    }
+    uint32_t ie_length = s1ap_fast_ie_length (ie_desc->type, ies + ie_desc->offset);
+    if ((!ie_length) || (ie_length > S1AP_FAST_LENGTH_DETERMINANT_MAX)) {
+      return 0;
+    }
+    value_length += 3 + s1ap_fast_length_size (ie_length) + ie_length;
+    (*num_ies)++;
+  }
+  // optional IE not handled by the fast codec
+  if (presence_mask & ~handled_presence) {
+    return 0;
+  }
+  return (value_length <= S1AP_FAST_LENGTH_DETERMINANT_MAX) ? value_length : 0;
+}
+
+//------------------------------------------------------------------------------
+uint32_t s1ap_fast_codec_encoded_length (const s1ap_message * const message)
+{
+  const s1ap_fast_msg_desc_t             *msg_desc = NULL;
+  uint32_t                                value_length = 0;
+  uint32_t                                num_ies = 0;
+
+  if ((!message) || (S1AP_PDU_PR_initiatingMessage != message->direction) ||
+      (!(msg_desc = s1ap_fast_get_msg_desc (message->procedureCode)))) {
+    return 0;
+  }
+  if (!(value_length = s1ap_fast_value_length (msg_desc, (const uint8_t *)&message->msg, &num_ies))) {
+    return 0;
+  }
+  return 3 + s1ap_fast_length_size (value_length) + value_length;
+}
+
+//------------------------------------------------------------------------------
+int s1ap_fast_codec_encode_pdu (const s1ap_message * const message, uint8_t * const buffer, const uint32_t size, uint32_t * const length)
+{
+  const s1ap_fast_msg_desc_t             *msg_desc = NULL;
+  const uint8_t                          *ies = NULL;
+  uint16_t                                presence_mask = 0;
+  uint32_t                                value_length = 0;
+  uint32_t                                num_ies = 0;
+  uint32_t                                offset = 0;
+
+  if ((!message) || (!buffer) || (S1AP_PDU_PR_initiatingMessage != message->direction) ||
+      ((uint32_t)message->criticality > S1ap_Criticality_notify) ||
+      (!(msg_desc = s1ap_fast_get_msg_desc (message->procedureCode)))) {
+    return RETURNerror;
+  }
+  ies = (const uint8_t *)&message->msg;
+  if (!(value_length = s1ap_fast_value_length (msg_desc, ies, &num_ies))) {
+    return RETURNerror;
+  }
+  if (size < 3 + s1ap_fast_length_size (value_length) + value_length) {
+    return RETURNerror;
+  }
+
+  buffer[offset++] = 0x00;
+  buffer[offset++] = (uint8_t)msg_desc->procedure_code;
+  buffer[offset++] = (uint8_t)(message->criticality << 6);
+  offset += s1ap_fast_put_length (&buffer[offset], value_length);
+  buffer[offset++] = 0x00;
+  buffer[offset++] = (uint8_t)(num_ies >> 8);
+  buffer[offset++] = (uint8_t)num_ies;
+
+  presence_mask = *(const uint16_t *)(ies + msg_desc->presence_mask_offset);
+  for (int d = 0; d < msg_desc->num_ies; d++) {
+    const s1ap_fast_ie_desc_t *ie_desc = &msg_desc->ies[d];
+
+    if ((ie_desc->presence) && (!(presence_mask & ie_desc->presence))) {
+      continue;
+    }
+    uint32_t ie_length = s1ap_fast_ie_length (ie_desc->type, ies + ie_desc->offset);
+
+    buffer[offset++] = (uint8_t)(ie_desc->id >> 8);
+    buffer[offset++] = (uint8_t)ie_desc->id;
+    buffer[offset++] = (uint8_t)(ie_desc->criticality << 6);
+    offset += s1ap_fast_put_length (&buffer[offset], ie_length);
+    s1ap_fast_encode_ie (ie_desc->type, ies + ie_desc->offset, &buffer[offset]);
+    offset += ie_length;
+  }
+  *length = offset;
+  return RETURNok;
+}
@@ -0,0 +1,63 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_fast_codec.h
+  \brief Specialized APER codec for the most frequent UE associated S1AP PDUs.
+
+  UplinkNASTransport, DownlinkNASTransport, InitialUEMessage and UEContextReleaseRequest
+  are decoded directly from the received buffer into the s1ap_message IE structures
+  and encoded directly into a caller provided buffer, without building the
+  intermediate asn1c PDU and protocol IE container.
+  Only the IEs these PDUs carry in practice are handled: a PDU with any other
+  content (unknown IE, IE extension, extension value, length >= 16K) is reported
+  as not handled, nothing is allocated, and the caller falls back on the generic
+  asn1c codec. Decoded IE structures are freed with the generic free_s1ap_xxx() functions.
+*/
+
+#ifndef FILE_S1AP_FAST_CODEC_SEEN
+#define FILE_S1AP_FAST_CODEC_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+
+bool s1ap_fast_codec_is_handled_procedure (const S1ap_ProcedureCode_t procedure_code);
+
+/*
+ * Return RETURNok if the PDU has been decoded in message (procedureCode, criticality, direction and IEs),
+ * RETURNerror if the PDU is not handled by the fast codec, message is then left untouched.
+ */
+int s1ap_fast_codec_decode_pdu (s1ap_message * const message, const uint8_t * const buffer, const uint32_t length) __attribute__ ((hot, warn_unused_result));
+
+/*
+ * Return the encoded length of message, 0 if message is not handled by the fast codec.
+ */
+uint32_t s1ap_fast_codec_encoded_length (const s1ap_message * const message);
+
+/*
+ * Encode message in buffer (size bytes), the encoded length is returned in length.
+ * Return RETURNerror if message is not handled by the fast codec or if buffer is too small.
+ */
+int s1ap_fast_codec_encode_pdu (const s1ap_message * const message, uint8_t * const buffer, const uint32_t size, uint32_t * const length) __attribute__ ((hot, warn_unused_result));
+
+#endif /* FILE_S1AP_FAST_CODEC_SEEN */
@@ -34,6 +34,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <pthread.h>
 
 
@@ -54,6 +55,7 @@
 #include "s1ap_mme_handlers.h"
 #include "s1ap_mme_nas_procedures.h"
 #include "s1ap_mme_retransmission.h"
+#include "s1ap_mme_overload.h"
 #include "s1ap_mme_itti_messaging.h"
 #include "dynamic_memory_check.h"
 #include "3gpp_23.003.h"
@@ -72,11 +74,17 @@
 bool                                    hss_associated = false;
 uint32_t                                nb_enb_associated = 0;
 
-hash_table_ts_t g_s1ap_enb_coll = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0}; // contains eNB_description_s, key is eNB_description_s.enb_id (uint32_t);
-hash_table_ts_t g_s1ap_mme_id2assoc_id_coll = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0}; // contains sctp association id, key is mme_ue_s1ap_id;
+hash_table_ts_t g_s1ap_enb_coll = {0}; // contains eNB_description_s, key is eNB_description_s.enb_id (uint32_t);
+hash_table_ts_t g_s1ap_mme_id2assoc_id_coll = {0}; // contains sctp association id, key is mme_ue_s1ap_id;
 
 static int                              indent = 0;
 extern struct mme_config_s              mme_config;
+
+// Admission control, only accessed by the S1AP task
+static uint32_t                         s1ap_admission_queue_high = 0;
+static uint32_t                         s1ap_admission_queue_low = 0;
+static bool                             s1ap_admission_shedding = false;
+static uint64_t                         s1ap_admission_shed = 0;
 void *s1ap_mme_thread (void *args);
 
 //------------------------------------------------------------------------------
@@ -287,6 +295,9 @@ s1ap_mme_thread (
 
       case TIMER_HAS_EXPIRED:{
         ue_description_t                       *ue_ref_p = NULL;
+        if (s1ap_mme_overload_handle_timer_expiry (received_message_p->ittiMsg.timer_has_expired.timer_id)) {
+          break;
+        }
         if (received_message_p->ittiMsg.timer_has_expired.arg != NULL) {
           enb_s1ap_id_key_t enb_s1ap_id_key = (enb_s1ap_id_key_t)(received_message_p->ittiMsg.timer_has_expired.arg);
           enb_ue_s1ap_id_t enb_ue_s1ap_id = MME_APP_ENB_S1AP_ID_KEY2ENB_S1AP_ID(enb_s1ap_id_key);
@@ -350,6 +361,32 @@ s1ap_mme_thread (
   return NULL;
 }
 
+//------------------------------------------------------------------------------
+bool s1ap_mme_admit_initial_ue_message (void)
+{
+  uint32_t                                depth = 0;
+
+  if (!s1ap_admission_queue_high) {
+    return true;
+  }
+  depth = itti_get_queue_depth (TASK_MME_APP);
+  if (itti_get_queue_depth (TASK_NAS_EMM) > depth) {
+    depth = itti_get_queue_depth (TASK_NAS_EMM);
+  }
+  if ((!s1ap_admission_shedding) && (depth >= s1ap_admission_queue_high)) {
+    s1ap_admission_shedding = true;
+    OAILOG_WARNING (LOG_S1AP, "MME overloaded (%u queued messages), dropping new INITIAL UE MESSAGEs\n", depth);
+  } else if ((s1ap_admission_shedding) && (depth <= s1ap_admission_queue_low)) {
+    s1ap_admission_shedding = false;
+    OAILOG_WARNING (LOG_S1AP, "MME load back to %u queued messages, %"PRIu64" INITIAL UE MESSAGEs dropped so far\n", depth, s1ap_admission_shed);
+  }
+  if (s1ap_admission_shedding) {
+    s1ap_admission_shed++;
+    return false;
+  }
+  return true;
+}
+
 //------------------------------------------------------------------------------
 int
 s1ap_mme_init(void)
@@ -375,6 +412,15 @@ s1ap_mme_init(void)
   bdestroy_wrapper (&bs2);
   if (!h) return RETURNerror;
 
+  s1ap_admission_queue_high = mme_config.s1ap_config.admission_queue_high;
+  s1ap_admission_queue_low  = mme_config.s1ap_config.admission_queue_low;
+  // new UEs are not admitted when MME_APP cannot queue them, the S1AP UE reference is removed then
+  itti_set_message_sheddable (S1AP_INITIAL_UE_MESSAGE);
+
+  if (s1ap_mme_overload_init (&mme_config) != RETURNok) {
+    return RETURNerror;
+  }
+
   if (itti_create_task (TASK_S1AP, &s1ap_mme_thread, NULL) < 0) {
     OAILOG_ERROR (LOG_S1AP, "Error while creating S1AP task\n");
     return RETURNerror;
@@ -388,6 +434,8 @@ void s1ap_mme_exit (void)
 {
   OAILOG_DEBUG (LOG_S1AP, "Cleaning S1AP\n");
 
+  s1ap_mme_overload_exit ();
+
   if (hashtable_ts_destroy(&g_s1ap_enb_coll) != HASH_TABLE_OK) {
     OAILOG_ERROR(LOG_S1AP, "An error occured while destroying s1 eNB hash table. \n");
   }
@@ -814,6 +862,7 @@ s1ap_remove_ue (
   OAILOG_TRACE(LOG_S1AP, "Removing UE enb_ue_s1ap_id: " ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id:" MME_UE_S1AP_ID_FMT " in eNB id : %d\n",
       ue_ref->enb_ue_s1ap_id, ue_ref->mme_ue_s1ap_id, enb_ref->enb_id);
 
+  itti_latency_procedure_end (&ue_ref->trace, ue_ref->trace_last_activity_ns);
   ue_ref->s1_ue_state = S1AP_UE_INVALID_STATE;
   hashtable_ts_free (&enb_ref->ue_coll, ue_ref->enb_ue_s1ap_id);
 
@@ -832,6 +881,66 @@ s1ap_remove_ue (
   }
 }
 
+//------------------------------------------------------------------------------
+void s1ap_ue_latency_procedure_start (ue_description_t * const ue_ref, const itti_latency_procedure_t procedure)
+{
+  if (__builtin_expect(itti_latency_enabled, 0)) {
+    itti_latency_procedure_end (&ue_ref->trace, ue_ref->trace_last_activity_ns);
+    itti_latency_procedure_start (&ue_ref->trace, procedure);
+    ue_ref->trace_last_activity_ns = ue_ref->trace.start_ns;
+  }
+}
+
+//------------------------------------------------------------------------------
+void s1ap_ue_latency_procedure_continue (ue_description_t * const ue_ref)
+{
+  if (__builtin_expect(itti_latency_enabled, 0)) {
+    itti_latency_procedure_resume (&ue_ref->trace);
+    ue_ref->trace_last_activity_ns = itti_latency_now_ns ();
+  }
+}
+
+//------------------------------------------------------------------------------
+itti_latency_procedure_t s1ap_ue_latency_nas_procedure (const uint8_t * const nas, const size_t length)
+{
+  uint8_t                                 message_type = 0;
+
+  // EPS mobility management protocol discriminator (TS 24.007)
+  if ((length < 2) || ((nas[0] & 0x0f) != 0x07)) {
+    return ITTI_LATENCY_PROC_OTHER;
+  }
+  switch (nas[0] >> 4) {
+    case 0x0:     // plain NAS message
+      message_type = nas[1];
+      break;
+    case 0x1:     // integrity protected (and ciphered) NAS message, with new EPS security context or not
+    case 0x2:
+    case 0x3:
+    case 0x4:
+      if (length < 8) {
+        return ITTI_LATENCY_PROC_OTHER;
+      }
+      message_type = nas[7];
+      break;
+    case 0xc:     // security header for the SERVICE REQUEST message
+      return ITTI_LATENCY_PROC_SERVICE_REQUEST;
+    default:
+      return ITTI_LATENCY_PROC_OTHER;
+  }
+  switch (message_type) {
+    case 0x41:    // ATTACH REQUEST
+      return ITTI_LATENCY_PROC_ATTACH;
+    case 0x45:    // DETACH REQUEST
+      return ITTI_LATENCY_PROC_DETACH;
+    case 0x48:    // TRACKING AREA UPDATE REQUEST
+      return ITTI_LATENCY_PROC_TAU;
+    case 0x4c:    // EXTENDED SERVICE REQUEST
+      return ITTI_LATENCY_PROC_SERVICE_REQUEST;
+    default:
+      return ITTI_LATENCY_PROC_OTHER;
+  }
+}
+
 //bool
 //s1ap_add_bearer_context_to_list (__attribute__((unused))const hash_key_t keyP,
 //               void * const bearer_ctx_void,
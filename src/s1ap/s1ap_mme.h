@@ -32,6 +32,7 @@
 
 #if MME_CLIENT_TEST == 0
 # include "intertask_interface.h"
+# include "intertask_interface_latency.h"
 #endif
 
 #include "hashtable.h"
@@ -97,6 +98,10 @@ typedef struct ue_description_s {
   struct s1ap_timer_t       s1ap_ue_context_rel_timer;
   // Handover/TAU completion timer (TS 23.401)
   struct s1ap_timer_t       s1ap_handover_completion_timer; // todo: not TXXXX value found for this.
+
+  // Procedure latency trace (see intertask_interface_latency.h)
+  itti_trace_context_t      trace;
+  uint64_t                  trace_last_activity_ns;
 } ue_description_t;
 
 /* Main structure representing eNB association over s1ap
@@ -252,6 +257,21 @@ s1ap_set_tai (enb_description_t * enb_ref, S1ap_SupportedTAs_t * ta_list);
  **/
 void s1ap_remove_ue(ue_description_t *ue_ref);
 
+/** \brief Admission control of new UE S1 connections, based on the queue depth of MME_APP and NAS EMM tasks
+ * (ADMISSION_QUEUE_HIGH_THRESHOLD / ADMISSION_QUEUE_LOW_THRESHOLD hysteresis).
+ * \returns false if the INITIAL UE MESSAGE has to be dropped
+ **/
+bool s1ap_mme_admit_initial_ue_message (void);
+
+/** \brief Procedure latency measurement: the procedure started by the message being handled replaces the current one
+ * of the UE, following messages of the UE (both directions) continue it.
+ **/
+void s1ap_ue_latency_procedure_start (ue_description_t * const ue_ref, const itti_latency_procedure_t procedure);
+void s1ap_ue_latency_procedure_continue (ue_description_t * const ue_ref);
+
+/** \brief Classify the procedure initiated by the NAS message of an INITIAL UE MESSAGE (plain or integrity protected EMM message). **/
+itti_latency_procedure_t s1ap_ue_latency_nas_procedure (const uint8_t * const nas, const size_t length);
+
 ///**
 // * Add a bearer context to the list.
 // */
@@ -39,6 +39,7 @@
 #include "intertask_interface.h"
 #include "s1ap_common.h"
 #include "s1ap_ies_defs.h"
+#include "s1ap_fast_codec.h"
 #include "s1ap_mme_handlers.h"
 #include "dynamic_memory_check.h"
 
@@ -332,6 +333,66 @@ s1ap_mme_decode_unsuccessfull_outcome (
   return ret;
 }
 
+//------------------------------------------------------------------------------
+/*
+ * Message already decoded by the fast codec, only the log message remains to be generated.
+ */
+static int
+s1ap_mme_decode_fast_initiating (
+  s1ap_message *message,
+  MessagesIds *message_id) {
+  MessageDef                             *message_p = NULL;
+  char                                   *message_string = NULL;
+  size_t                                  message_string_size;
+
+  switch (message->procedureCode) {
+    case S1ap_ProcedureCode_id_uplinkNASTransport:
+      *message_id = S1AP_UPLINK_NAS_LOG;
+      break;
+
+    case S1ap_ProcedureCode_id_initialUEMessage:
+      *message_id = S1AP_INITIAL_UE_MESSAGE_LOG;
+      break;
+
+    case S1ap_ProcedureCode_id_UEContextReleaseRequest:
+      *message_id = S1AP_UE_CONTEXT_RELEASE_REQ_LOG;
+      break;
+
+    default:
+      /*
+       * Not expected by the MME (DownlinkNASTransport), let the generic decoder report it.
+       */
+      free_s1ap_downlinknastransport (&message->msg.s1ap_DownlinkNASTransportIEs);
+      return RETURNerror;
+  }
+
+  message_string = calloc (20000, sizeof (char));
+  s1ap_string_total_size = 0;
+
+  switch (*message_id) {
+    case S1AP_UPLINK_NAS_LOG:
+      s1ap_xer_print_s1ap_uplinknastransport (s1ap_xer__print2sp, message_string, message);
+      break;
+
+    case S1AP_INITIAL_UE_MESSAGE_LOG:
+      s1ap_xer_print_s1ap_initialuemessage (s1ap_xer__print2sp, message_string, message);
+      break;
+
+    default:
+      s1ap_xer_print_s1ap_uecontextreleaserequest (s1ap_xer__print2sp, message_string, message);
+      break;
+  }
+
+  message_string_size = strlen (message_string);
+  message_p = itti_alloc_new_message_sized (TASK_S1AP, *message_id, message_string_size + sizeof (IttiMsgText));
+  message_p->ittiMsg.s1ap_uplink_nas_log.size = message_string_size;
+  memcpy (&message_p->ittiMsg.s1ap_uplink_nas_log.text, message_string, message_string_size);
+  itti_send_msg_to_task (TASK_UNKNOWN, INSTANCE_DEFAULT, message_p);
+  free_wrapper ((void**)&message_string);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
 int
 s1ap_mme_decode_pdu (
   s1ap_message *message,
@@ -341,6 +402,17 @@ s1ap_mme_decode_pdu (
   S1AP_PDU_t                             *pdu_p = &pdu;
   asn_dec_rval_t                          dec_ret = {(RC_OK)};
   DevAssert (raw != NULL);
+
+  /*
+   * NAS transport, Initial UE message and UE context release request do not need the asn1c decoder.
+   */
+  if (RETURNok == s1ap_fast_codec_decode_pdu (message, (const uint8_t *)bdata(raw), blength(raw))) {
+    if (RETURNok == s1ap_mme_decode_fast_initiating (message, message_id)) {
+      return RETURNok;
+    }
+    memset ((void *)message, 0, sizeof (*message));
+  }
+
   memset ((void *)pdu_p, 0, sizeof (S1AP_PDU_t));
   dec_ret = aper_decode (NULL, &asn_DEF_S1AP_PDU, (void **)&pdu_p, bdata(raw), blength(raw), 0, 0);
 
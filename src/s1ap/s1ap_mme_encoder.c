@@ -37,9 +37,11 @@
 #include "mme_api.h"
 #include "s1ap_common.h"
 #include "s1ap_ies_defs.h"
+#include "s1ap_fast_codec.h"
 #include "s1ap_mme_encoder.h"
 #include "assertions.h"
 #include "log.h"
+#include "dynamic_memory_check.h"
 
 static inline int                       s1ap_mme_encode_initial_context_setup_request (
   s1ap_message * message_p,
@@ -81,6 +83,16 @@ static inline int                       s1ap_mme_encode_paging(
   uint8_t ** buffer,
   uint32_t * length);
 
+static inline int                       s1ap_mme_encode_overload_start (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length);
+
+static inline int                       s1ap_mme_encode_overload_stop (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length);
+
 static inline int                       s1ap_mme_encode_initiating (
   s1ap_message * message_p,
   MessagesIds *message_id,
@@ -216,6 +228,10 @@ int s1ap_free_mme_encode_pdu(
     return free_s1ap_mmestatustransfer(&message->msg.s1ap_MMEStatusTransferIEs);
   case S1AP_PAGING_LOG:
     return free_s1ap_paging(&message->msg.s1ap_PagingIEs);
+  case S1AP_OVERLOAD_START_LOG:
+    return free_s1ap_overloadstart(&message->msg.s1ap_OverloadStartIEs);
+  case S1AP_OVERLOAD_STOP_LOG:
+    return free_s1ap_overloadstop(&message->msg.s1ap_OverloadStopIEs);
   case S1AP_PATH_SWITCH_ACK_LOG:
     return free_s1ap_pathswitchrequestacknowledge(&message->msg.s1ap_PathSwitchRequestAcknowledgeIEs);
   case S1AP_HANDOVER_COMMAND_LOG:
@@ -281,6 +297,14 @@ s1ap_mme_encode_initiating (
     *message_id = S1AP_PAGING_LOG;
     return s1ap_mme_encode_paging(message_p, buffer, length);
 
+  case S1ap_ProcedureCode_id_OverloadStart:
+    *message_id = S1AP_OVERLOAD_START_LOG;
+    return s1ap_mme_encode_overload_start (message_p, buffer, length);
+
+  case S1ap_ProcedureCode_id_OverloadStop:
+    *message_id = S1AP_OVERLOAD_STOP_LOG;
+    return s1ap_mme_encode_overload_stop (message_p, buffer, length);
+
   default:
     OAILOG_NOTICE (LOG_S1AP, "Unknown procedure ID (%d) for initiating message_p\n", (int)message_p->procedureCode);
     break;
@@ -553,6 +577,18 @@ s1ap_mme_encode_downlink_nas_transport (
 {
   S1ap_DownlinkNASTransport_t             downlinkNasTransport;
   S1ap_DownlinkNASTransport_t            *downlinkNasTransport_p = &downlinkNasTransport;
+  uint32_t                                fast_length = s1ap_fast_codec_encoded_length (message_p);
+
+  /*
+   * Encode directly in the final buffer when the message content allows it
+   */
+  if (fast_length) {
+    *buffer = malloc (fast_length);
+    if ((*buffer) && (RETURNok == s1ap_fast_codec_encode_pdu (message_p, *buffer, fast_length, length))) {
+      return RETURNok;
+    }
+    free_wrapper ((void**)buffer);
+  }
 
   memset (downlinkNasTransport_p, 0, sizeof (S1ap_DownlinkNASTransport_t));
 
@@ -678,3 +714,41 @@ s1ap_mme_encode_paging(
 
   return s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_Paging, message_p->criticality, &asn_DEF_S1ap_E_RABSetupRequest, paging_p);
 }
+
+//------------------------------------------------------------------------------
+static inline int
+s1ap_mme_encode_overload_start (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length)
+{
+  S1ap_OverloadStart_t                    overload_start;
+  S1ap_OverloadStart_t                   *overload_start_p = &overload_start;
+
+  memset (overload_start_p, 0, sizeof (S1ap_OverloadStart_t));
+
+  if (s1ap_encode_s1ap_overloadstarties (overload_start_p, &message_p->msg.s1ap_OverloadStartIEs) < 0) {
+    return -1;
+  }
+
+  return s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_OverloadStart, message_p->criticality, &asn_DEF_S1ap_OverloadStart, overload_start_p);
+}
+
+//------------------------------------------------------------------------------
+static inline int
+s1ap_mme_encode_overload_stop (
+  s1ap_message * message_p,
+  uint8_t ** buffer,
+  uint32_t * length)
+{
+  S1ap_OverloadStop_t                     overload_stop;
+  S1ap_OverloadStop_t                    *overload_stop_p = &overload_stop;
+
+  memset (overload_stop_p, 0, sizeof (S1ap_OverloadStop_t));
+
+  if (s1ap_encode_s1ap_overloadstopies (overload_stop_p, &message_p->msg.s1ap_OverloadStopIEs) < 0) {
+    return -1;
+  }
+
+  return s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_OverloadStop, message_p->criticality, &asn_DEF_S1ap_OverloadStop, overload_stop_p);
+}
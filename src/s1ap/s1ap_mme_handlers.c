@@ -51,6 +51,7 @@
 #include "s1ap_mme_ta.h"
 #include "s1ap_mme_gummei.h"
 #include "s1ap_mme_handlers.h"
+#include "s1ap_mme_overload.h"
 #include "mme_app_statistics.h"
 #include "timer.h"
 #include "dynamic_memory_check.h"
@@ -531,6 +532,10 @@ s1ap_generate_s1_setup_response (
   free(buffer);
   s1ap_free_mme_encode_pdu(&message, message_id);
   rc = s1ap_mme_itti_send_sctp_request (&b, enb_association->sctp_assoc_id, 0, INVALID_MME_UE_S1AP_ID);
+  if ((RETURNok == rc) && (S1AP_READY == enb_association->s1_state)) {
+    // The eNB must know the MME is overloaded before sending it new UEs
+    s1ap_mme_overload_enb_ready (enb_association);
+  }
   OAILOG_FUNC_RETURN (LOG_S1AP, rc);
 }
 
@@ -647,6 +652,7 @@ s1ap_mme_handle_initial_context_setup_response (
   }
 
   ue_ref_p->s1_ue_state = S1AP_UE_CONNECTED;
+  s1ap_ue_latency_procedure_continue (ue_ref_p);
   message_p = itti_alloc_new_message (TASK_S1AP, MME_APP_INITIAL_CONTEXT_SETUP_RSP);
   memset ((void *)&message_p->ittiMsg.mme_app_initial_context_setup_rsp, 0, sizeof (itti_mme_app_initial_context_setup_rsp_t));
   AssertFatal (message_p != NULL, "itti_alloc_new_message Failed");
@@ -780,6 +786,7 @@ s1ap_mme_handle_ue_context_release_request (
        */
       //s1ap_mme_generate_ue_context_release_command(ue_ref_p);
       // UE context will be removed when receiving UE_CONTEXT_RELEASE_COMPLETE
+      s1ap_ue_latency_procedure_start (ue_ref_p, ITTI_LATENCY_PROC_UE_CONTEXT_RELEASE);
       message_p = itti_alloc_new_message (TASK_S1AP, S1AP_UE_CONTEXT_RELEASE_REQ);
       AssertFatal (message_p != NULL, "itti_alloc_new_message Failed");
       S1AP_UE_CONTEXT_RELEASE_REQ (message_p).mme_ue_s1ap_id = ue_ref_p->mme_ue_s1ap_id;
@@ -964,6 +971,7 @@ s1ap_handle_ue_context_release_command (
   if(ue_ref_p){
     OAILOG_DEBUG (LOG_S1AP, "UE reference for enbUeS1apId " ENB_UE_S1AP_ID_FMT " and enbId %d is %p. \n",
                       ue_context_release_command_pP->enb_ue_s1ap_id, ue_context_release_command_pP->enb_id, ue_ref_p);
+    s1ap_ue_latency_procedure_continue (ue_ref_p);
   }
 
   /**
@@ -1028,6 +1036,7 @@ s1ap_mme_handle_ue_context_release_complete (
    * eNB has sent a release complete message. We can safely remove UE context.
    * TODO: inform NAS and remove e-RABS.
    */
+  s1ap_ue_latency_procedure_continue (ue_ref_p);
   message_p = itti_alloc_new_message (TASK_S1AP, S1AP_UE_CONTEXT_RELEASE_COMPLETE);
   AssertFatal (message_p != NULL, "itti_alloc_new_message Failed");
   S1AP_UE_CONTEXT_RELEASE_COMPLETE (message_p).mme_ue_s1ap_id = ueContextReleaseComplete_p->mme_ue_s1ap_id;
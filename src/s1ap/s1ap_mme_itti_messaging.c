@@ -36,6 +36,7 @@
 #include "log.h"
 #include "assertions.h"
 #include "intertask_interface.h"
+#include "shared_buffer.h"
 #include "s1ap_common.h"
 #include "s1ap_mme_itti_messaging.h"
 
@@ -60,6 +61,25 @@ s1ap_mme_itti_send_sctp_request (
   return itti_send_msg_to_task (TASK_SCTP, INSTANCE_DEFAULT, message_p);
 }
 
+//------------------------------------------------------------------------------
+int
+s1ap_mme_itti_send_sctp_shared_request (
+  shared_buffer_t * const payload,
+  const sctp_assoc_id_t assoc_id,
+  const sctp_stream_id_t stream,
+  const mme_ue_s1ap_id_t ue_id)
+{
+  MessageDef                             *message_p = NULL;
+
+  message_p = itti_alloc_new_message (TASK_S1AP, SCTP_DATA_REQ);
+
+  SCTP_DATA_REQ (message_p).shared_payload = shared_buffer_ref (payload);
+  SCTP_DATA_REQ (message_p).assoc_id = assoc_id;
+  SCTP_DATA_REQ (message_p).stream = stream;
+  SCTP_DATA_REQ (message_p).mme_ue_s1ap_id = ue_id;
+  return itti_send_msg_to_task (TASK_SCTP, INSTANCE_DEFAULT, message_p);
+}
+
 //------------------------------------------------------------------------------
 int
 s1ap_mme_itti_nas_uplink_ind (
@@ -113,13 +133,12 @@ s1ap_mme_itti_nas_downlink_cnf (
   return itti_send_msg_to_task (TASK_NAS_ESM, INSTANCE_DEFAULT, message_p);
 }
 //------------------------------------------------------------------------------
-void s1ap_mme_itti_s1ap_initial_ue_message(
+int s1ap_mme_itti_s1ap_initial_ue_message(
   const sctp_assoc_id_t   assoc_id,
   const uint32_t          enb_id,
   const enb_ue_s1ap_id_t  enb_ue_s1ap_id,
   const mme_ue_s1ap_id_t  mme_ue_s1ap_id,
-  const uint8_t * const   nas_msg,
-  const size_t            nas_msg_length,
+  STOLEN_REF bstring     *nas_msg,
   const tai_t      *const tai,
   const ecgi_t     *const ecgi,
   const long              rrc_cause,
@@ -133,8 +152,8 @@ void s1ap_mme_itti_s1ap_initial_ue_message(
   MessageDef  *message_p = NULL;
 
   OAILOG_FUNC_IN (LOG_S1AP);
-  AssertFatal((nas_msg_length < 1000), "Bad length for NAS message %lu", nas_msg_length);
-  OAILOG_DEBUG(LOG_S1AP, "S1AP:Initial UE Message- Size %d: \n", nas_msg_length);
+  AssertFatal((blength(*nas_msg) < 1000), "Bad length for NAS message %d", blength(*nas_msg));
+  OAILOG_DEBUG(LOG_S1AP, "S1AP:Initial UE Message- Size %d: \n", blength(*nas_msg));
 
   message_p = itti_alloc_new_message(TASK_S1AP, S1AP_INITIAL_UE_MESSAGE);
 
@@ -142,7 +161,8 @@ void s1ap_mme_itti_s1ap_initial_ue_message(
   S1AP_INITIAL_UE_MESSAGE(message_p).enb_ue_s1ap_id         = enb_ue_s1ap_id;
   S1AP_INITIAL_UE_MESSAGE(message_p).mme_ue_s1ap_id         = mme_ue_s1ap_id;
 
-  S1AP_INITIAL_UE_MESSAGE(message_p).nas                    = blk2bstr(nas_msg, nas_msg_length);
+  S1AP_INITIAL_UE_MESSAGE(message_p).nas                    = *nas_msg;
+  *nas_msg = NULL;
 
   S1AP_INITIAL_UE_MESSAGE(message_p).tai                    = *tai;
   S1AP_INITIAL_UE_MESSAGE(message_p).ecgi                    = *ecgi;
@@ -186,8 +206,7 @@ void s1ap_mme_itti_s1ap_initial_ue_message(
         (9 < S1AP_INITIAL_UE_MESSAGE(message_p).tai.mnc_digit3) ? ' ': (char)(S1AP_INITIAL_UE_MESSAGE(message_p).tai.mnc_digit3 + 0x30),
         S1AP_INITIAL_UE_MESSAGE(message_p).tai.tac,
         S1AP_INITIAL_UE_MESSAGE(message_p).nas->slen);
-  itti_send_msg_to_task(TASK_MME_APP, INSTANCE_DEFAULT, message_p);
-  OAILOG_FUNC_OUT (LOG_S1AP);
+  OAILOG_FUNC_RETURN (LOG_S1AP, itti_send_msg_to_task(TASK_MME_APP, INSTANCE_DEFAULT, message_p));
 }
 
 //------------------------------------------------------------------------------
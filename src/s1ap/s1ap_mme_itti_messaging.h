@@ -30,12 +30,19 @@
 #define FILE_S1AP_MME_ITTI_MESSAGING_SEEN
 
 #include "common_defs.h"
+#include "shared_buffer.h"
 
 int s1ap_mme_itti_send_sctp_request(STOLEN_REF bstring *payload,
                                     const  uint32_t sctp_assoc_id_t,
                                     const sctp_stream_id_t stream,
                                     const mme_ue_s1ap_id_t ue_id);
 
+/* Take a reference on payload, the caller keeps its own one (fan-out of the same PDU to several associations). */
+int s1ap_mme_itti_send_sctp_shared_request(shared_buffer_t * const payload,
+                                           const sctp_assoc_id_t assoc_id,
+                                           const sctp_stream_id_t stream,
+                                           const mme_ue_s1ap_id_t ue_id);
+
 int s1ap_mme_itti_nas_uplink_ind(const mme_ue_s1ap_id_t ue_id,
                                  STOLEN_REF bstring *payload,
                                  const tai_t      *const tai,
@@ -43,13 +50,12 @@ int s1ap_mme_itti_nas_uplink_ind(const mme_ue_s1ap_id_t ue_id,
 
 int s1ap_mme_itti_nas_downlink_cnf (const mme_ue_s1ap_id_t ue_id, const bool is_success);
 
-void s1ap_mme_itti_s1ap_initial_ue_message(
+int s1ap_mme_itti_s1ap_initial_ue_message(
   const sctp_assoc_id_t   assoc_id,
   const uint32_t          enb_id,
   const enb_ue_s1ap_id_t  enb_ue_s1ap_id,
   const mme_ue_s1ap_id_t  mme_ue_s1ap_id,
-  const uint8_t * const   nas_msg,
-  const size_t            nas_msg_length,
+  STOLEN_REF bstring     *nas_msg,
   const tai_t      *const tai,
   const ecgi_t     *const cgi,
   const long              rrc_cause,
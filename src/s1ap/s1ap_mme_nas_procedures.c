@@ -27,6 +27,8 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -44,9 +46,11 @@
 #include "asn1_conversions.h"
 #include "s1ap_common.h"
 #include "s1ap_ies_defs.h"
+#include "s1ap_fast_codec.h"
 #include "s1ap_mme_encoder.h"
 #include "s1ap_mme_itti_messaging.h"
 #include "s1ap_mme.h"
+#include "s1ap_mme_overload.h"
 #include "mme_config.h"
 
 /* Every time a new UE is associated, increment this variable.
@@ -67,6 +71,123 @@ extern hash_table_ts_t g_s1ap_mme_id2assoc_id_coll; // contains sctp association
 //s1ap_add_bearer_context_to_switch_list (S1ap_E_RABToBeSwitchedULListIEs_t * const e_RABToBeSwitchedListHOReq_p,
 //    S1ap_E_RABToBeSwitchedULItem_t        * e_RABToBeSwitchedHO_p, bearer_context_t * bearer_ctxt_p);
 
+//------------------------------------------------------------------------------
+/*
+ * Hand the decoded NAS PDU buffer over to a bstring without copying it.
+ * asn1c and the fast codec allocate OCTET STRING buffers of size + 1 bytes.
+ */
+static bstring s1ap_nas_pdu_2_bstring (S1ap_NAS_PDU_t * const nas_pdu)
+{
+  bstring                                 b = NULL;
+
+  if (!nas_pdu->buf) {
+    return blk2bstr ("", 0);
+  }
+  b = malloc (sizeof (*b));
+  if (b) {
+    b->data = nas_pdu->buf;
+    b->slen = nas_pdu->size;
+    b->mlen = nas_pdu->size + 1;
+    nas_pdu->buf = NULL;
+    nas_pdu->size = 0;
+  }
+  return b;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Encode the DownlinkNASTransport in the buffer SCTP will send, the NAS PDU is copied once.
+ */
+static shared_buffer_t * s1ap_encode_downlink_nas_transport (s1ap_message * const message, MessagesIds * const message_id)
+{
+  uint8_t                                *buffer_p = NULL;
+  uint32_t                                length = s1ap_fast_codec_encoded_length (message);
+  shared_buffer_t                        *shared_p = NULL;
+  S1ap_NAS_PDU_t                         *nas_pdu = &message->msg.s1ap_DownlinkNASTransportIEs.nas_pdu;
+  const uint8_t                          *nas = nas_pdu->buf;
+  const int                               nas_size = nas_pdu->size;
+
+  if ((length) && (shared_p = shared_buffer_create (NULL, length))) {
+    if (RETURNok == s1ap_fast_codec_encode_pdu (message, shared_p->data, length, &length)) {
+      return shared_p;
+    }
+    shared_buffer_unref (&shared_p);
+  }
+
+  /*
+   * Generic asn1c encoder, the NAS PDU must belong to the message
+   */
+  memset (nas_pdu, 0, sizeof (*nas_pdu));
+  if (OCTET_STRING_fromBuf (nas_pdu, (const char *)nas, nas_size)) {
+    return NULL;
+  }
+  if (s1ap_mme_encode_pdu (message, message_id, &buffer_p, &length) >= 0) {
+    shared_p = shared_buffer_create (buffer_p, length);
+    free_wrapper ((void**)&buffer_p);
+  }
+  s1ap_free_mme_encode_pdu (message, *message_id);
+  return shared_p;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Reject an INITIAL UE MESSAGE not allowed by the overload action without creating any UE context: the NAS reject
+ * is followed by the release of the UE-associated signalling connection, with an MME UE S1AP ID from a reserved range.
+ * The UE CONTEXT RELEASE COMPLETE finds no UE and is ignored.
+ */
+static int s1ap_mme_overload_reject_initial_ue (
+  const enb_description_t * const eNB_ref,
+  const enb_ue_s1ap_id_t enb_ue_s1ap_id,
+  const sctp_stream_id_t stream,
+  const S1ap_NAS_PDU_t * const nas_pdu)
+{
+  bstring                                 nas_reject = s1ap_mme_overload_nas_reject (nas_pdu->buf, nas_pdu->size);
+  const mme_ue_s1ap_id_t                  mme_ue_s1ap_id = s1ap_mme_overload_new_ue_id ();
+  s1ap_message                            message = {0};
+  MessagesIds                             message_id = MESSAGES_ID_MAX;
+  shared_buffer_t                        *pdu = NULL;
+  uint8_t                                *buffer_p = NULL;
+  uint32_t                                length = 0;
+
+  if (!nas_reject) {
+    return RETURNerror;
+  }
+  message.procedureCode = S1ap_ProcedureCode_id_downlinkNASTransport;
+  message.direction = S1AP_PDU_PR_initiatingMessage;
+  message.msg.s1ap_DownlinkNASTransportIEs.mme_ue_s1ap_id = mme_ue_s1ap_id;
+  message.msg.s1ap_DownlinkNASTransportIEs.eNB_UE_S1AP_ID = enb_ue_s1ap_id;
+  message.msg.s1ap_DownlinkNASTransportIEs.nas_pdu.buf  = (uint8_t *)bdata(nas_reject);
+  message.msg.s1ap_DownlinkNASTransportIEs.nas_pdu.size = blength(nas_reject);
+  pdu = s1ap_encode_downlink_nas_transport (&message, &message_id);
+  bdestroy_wrapper (&nas_reject);
+  if (!pdu) {
+    return RETURNerror;
+  }
+  s1ap_mme_itti_send_sctp_shared_request (pdu, eNB_ref->sctp_assoc_id, stream, INVALID_MME_UE_S1AP_ID);
+  shared_buffer_unref (&pdu);
+
+  memset (&message, 0, sizeof (message));
+  message.procedureCode = S1ap_ProcedureCode_id_UEContextRelease;
+  message.direction = S1AP_PDU_PR_initiatingMessage;
+  message.msg.s1ap_UEContextReleaseCommandIEs.uE_S1AP_IDs.present = S1ap_UE_S1AP_IDs_PR_uE_S1AP_ID_pair;
+  message.msg.s1ap_UEContextReleaseCommandIEs.uE_S1AP_IDs.choice.uE_S1AP_ID_pair.mME_UE_S1AP_ID = mme_ue_s1ap_id;
+  message.msg.s1ap_UEContextReleaseCommandIEs.uE_S1AP_IDs.choice.uE_S1AP_ID_pair.eNB_UE_S1AP_ID = enb_ue_s1ap_id;
+  message.msg.s1ap_UEContextReleaseCommandIEs.cause.present = S1ap_Cause_PR_misc;
+  message.msg.s1ap_UEContextReleaseCommandIEs.cause.choice.misc = S1ap_CauseMisc_control_processing_overload;
+  if (s1ap_mme_encode_pdu (&message, &message_id, &buffer_p, &length) < 0) {
+    OAILOG_ERROR (LOG_S1AP, "Failed to encode UE CONTEXT RELEASE COMMAND for rejected eNB_UE_S1AP_ID " ENB_UE_S1AP_ID_FMT "\n", enb_ue_s1ap_id);
+    return RETURNok;
+  }
+  pdu = shared_buffer_create (buffer_p, length);
+  free_wrapper ((void**)&buffer_p);
+  s1ap_free_mme_encode_pdu (&message, message_id);
+  if (pdu) {
+    s1ap_mme_itti_send_sctp_shared_request (pdu, eNB_ref->sctp_assoc_id, stream, INVALID_MME_UE_S1AP_ID);
+    shared_buffer_unref (&pdu);
+  }
+  return RETURNok;
+}
+
 //------------------------------------------------------------------------------
 int
 s1ap_mme_handle_initial_ue_message (
@@ -112,6 +233,16 @@ s1ap_mme_handle_initial_ue_message (
      * * * * Update eNB UE list.
      * * * * Forward message to NAS.
      */
+    if ((!s1ap_mme_overload_admit (initialUEMessage_p->rrC_Establishment_Cause)) &&
+        (RETURNok == s1ap_mme_overload_reject_initial_ue (eNB_ref, enb_ue_s1ap_id, stream, &initialUEMessage_p->nas_pdu))) {
+      OAILOG_DEBUG (LOG_S1AP, "S1AP:Initial UE Message- Rejected (overload action), eNBUeS1APId:" ENB_UE_S1AP_ID_FMT "\n", enb_ue_s1ap_id);
+      OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
+    }
+    if (!s1ap_mme_admit_initial_ue_message ()) {
+      // the eNB will release the RRC connection on its own, the UE retries later
+      OAILOG_DEBUG (LOG_S1AP, "S1AP:Initial UE Message- Dropped (overload), eNBUeS1APId:" ENB_UE_S1AP_ID_FMT "\n", enb_ue_s1ap_id);
+      OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
+    }
     if ((ue_ref = s1ap_new_ue (assoc_id, enb_ue_s1ap_id)) == NULL) {
       // If we failed to allocate a new UE return -1
       OAILOG_ERROR (LOG_S1AP, "S1AP:Initial UE Message- Failed to allocate S1AP UE Context, eNBUeS1APId:" ENB_UE_S1AP_ID_FMT "\n", enb_ue_s1ap_id);
@@ -119,6 +250,7 @@ s1ap_mme_handle_initial_ue_message (
     }
 
     ue_ref->s1_ue_state = S1AP_UE_WAITING_CSR;
+    s1ap_ue_latency_procedure_start (ue_ref, s1ap_ue_latency_nas_procedure (initialUEMessage_p->nas_pdu.buf, initialUEMessage_p->nas_pdu.size));
 
     ue_ref->enb_ue_s1ap_id = enb_ue_s1ap_id;
     // Will be allocated by NAS
@@ -192,12 +324,17 @@ s1ap_mme_handle_initial_ue_message (
         initialUEMessage_p->rrC_Establishment_Cause,
         &tai, &cgi, &s_tmsi, &gummei);
 #else
-    s1ap_mme_itti_s1ap_initial_ue_message (assoc_id,
+    bstring nas = s1ap_nas_pdu_2_bstring (&initialUEMessage_p->nas_pdu);
+    if (!nas) {
+      OAILOG_ERROR (LOG_S1AP, "S1AP:Initial UE Message- Failed to allocate the NAS PDU, eNBUeS1APId:" ENB_UE_S1AP_ID_FMT "\n", enb_ue_s1ap_id);
+      s1ap_remove_ue (ue_ref);
+      OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
+    }
+    if (0 > s1ap_mme_itti_s1ap_initial_ue_message (assoc_id,
         ue_ref->enb->enb_id,
         ue_ref->enb_ue_s1ap_id,
         ue_ref->mme_ue_s1ap_id,
-        initialUEMessage_p->nas_pdu.buf,
-        initialUEMessage_p->nas_pdu.size,
+        &nas,
         &tai,
         &ecgi,
         initialUEMessage_p->rrC_Establishment_Cause,
@@ -207,7 +344,11 @@ s1ap_mme_handle_initial_ue_message (
         NULL, // CELL ACCESS MODE
         NULL, // GW Transport Layer Address
         NULL  //Relay Node Indicator
-        );
+        )) {
+      // dropped by ITTI, MME_APP queue full: as if not admitted
+      OAILOG_WARNING (LOG_S1AP, "S1AP:Initial UE Message dropped, MME_APP overloaded, eNBUeS1APId:" ENB_UE_S1AP_ID_FMT "\n", enb_ue_s1ap_id);
+      s1ap_remove_ue (ue_ref);
+    }
 #endif
 #endif
   }else {
@@ -264,6 +405,7 @@ s1ap_mme_handle_uplink_nas_transport (
       }
     }
   }
+  s1ap_ue_latency_procedure_continue (ue_ref);
 
 
 
@@ -303,7 +445,12 @@ s1ap_mme_handle_uplink_nas_transport (
                       (enb_ue_s1ap_id_t)uplinkNASTransport_p->eNB_UE_S1AP_ID,
                       uplinkNASTransport_p->nas_pdu.size);
 
-  bstring b = blk2bstr(uplinkNASTransport_p->nas_pdu.buf, uplinkNASTransport_p->nas_pdu.size);
+  bstring b = s1ap_nas_pdu_2_bstring (&uplinkNASTransport_p->nas_pdu);
+  if (!b) {
+    OAILOG_ERROR (LOG_S1AP, "Failed to allocate the NAS PDU of UPLINK_NAS_TRANSPORT, mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n",
+        (mme_ue_s1ap_id_t)uplinkNASTransport_p->mme_ue_s1ap_id);
+    OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
+  }
   s1ap_mme_itti_nas_uplink_ind (uplinkNASTransport_p->mme_ue_s1ap_id,
                                 &b,
                                 &tai,
@@ -374,8 +521,6 @@ s1ap_generate_downlink_nas_transport (
 {
   OAILOG_FUNC_IN (LOG_S1AP);
   ue_description_t                       *ue_ref = NULL;
-  uint8_t                                *buffer_p = NULL;
-  uint32_t                                length = 0;
   MessagesIds                             message_id = MESSAGES_ID_MAX;
   void                                   *id = NULL;
 
@@ -408,6 +553,7 @@ s1ap_generate_downlink_nas_transport (
         OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
       }
   }
+  s1ap_ue_latency_procedure_continue (ue_ref);
 
   /*
    * We have fount the UE in the list.
@@ -426,12 +572,14 @@ s1ap_generate_downlink_nas_transport (
   downlinkNasTransport->mme_ue_s1ap_id = ue_ref->mme_ue_s1ap_id;
   downlinkNasTransport->eNB_UE_S1AP_ID = ue_ref->enb_ue_s1ap_id;
   /*eNB
-   * Fill in the NAS pdu
+   * Fill in the NAS pdu, only referenced while encoding
    */
-  OCTET_STRING_fromBuf (&downlinkNasTransport->nas_pdu, (char *)bdata(*payload), blength(*payload));
-  bdestroy_wrapper (payload);
+  downlinkNasTransport->nas_pdu.buf  = (uint8_t *)bdata(*payload);
+  downlinkNasTransport->nas_pdu.size = blength(*payload);
 
-  if (s1ap_mme_encode_pdu (&message, &message_id, &buffer_p, &length) < 0) {
+  shared_buffer_t *pdu = s1ap_encode_downlink_nas_transport (&message, &message_id);
+  bdestroy_wrapper (payload);
+  if (!pdu) {
     // TODO: handle something
     OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
   }
@@ -441,11 +589,9 @@ s1ap_generate_downlink_nas_transport (
       MSC_S1AP_ENB,
       NULL, 0,
       "0 downlinkNASTransport/initiatingMessage ue_id " MME_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " enb_ue_s1ap_id" ENB_UE_S1AP_ID_FMT " nas length %u",
-      ue_id, (mme_ue_s1ap_id_t)downlinkNasTransport->mme_ue_s1ap_id, (enb_ue_s1ap_id_t)downlinkNasTransport->eNB_UE_S1AP_ID, length);
-  bstring b = blk2bstr(buffer_p, length);
-  free(buffer_p);
-  s1ap_free_mme_encode_pdu(&message, message_id);
-  s1ap_mme_itti_send_sctp_request (&b , ue_ref->enb->sctp_assoc_id, ue_ref->sctp_stream_send, ue_ref->mme_ue_s1ap_id);
+      ue_id, (mme_ue_s1ap_id_t)downlinkNasTransport->mme_ue_s1ap_id, (enb_ue_s1ap_id_t)downlinkNasTransport->eNB_UE_S1AP_ID, pdu->length);
+  s1ap_mme_itti_send_sctp_shared_request (pdu, ue_ref->enb->sctp_assoc_id, ue_ref->sctp_stream_send, ue_ref->mme_ue_s1ap_id);
+  shared_buffer_unref (&pdu);
 
   OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
 }
@@ -862,6 +1008,7 @@ s1ap_handle_conn_est_cnf (
     // There are some race conditions were NAS T3450 timer is stopped and removed at same time
     OAILOG_FUNC_OUT (LOG_S1AP);
   }
+  s1ap_ue_latency_procedure_continue (ue_ref);
 
   /*
    * Start the outcome response timer.
@@ -1788,14 +1935,93 @@ s1ap_handle_mme_status_transfer( const itti_s1ap_status_transfer_t * const s1ap_
   OAILOG_FUNC_OUT (LOG_S1AP);
 }
 
+/*
+ * The paging PDU only depends on the UE and on the TAI list of the eNB, eNBs
+ * sharing the same TAI list receive the same bytes: the PDU is encoded once per
+ * distinct TAI list and the encoded buffer is shared by all SCTP send requests.
+ */
+typedef struct s1ap_paging_target_s {
+  struct {
+    plmn_t                                plmn;
+    uint8_t                               numberofelements;
+    tac_t                                 tac[TRACKING_AREA_IDENTITY_LIST_MAXIMUM_NUM_TAI];
+  } key;                                  // must be memset before being filled (compared with memcmp)
+  enb_description_t                      *enb;
+} s1ap_paging_target_t;
+
+//------------------------------------------------------------------------------
+static int s1ap_paging_target_cmp (const void *a, const void *b)
+{
+  return memcmp (&((const s1ap_paging_target_t *)a)->key, &((const s1ap_paging_target_t *)b)->key, sizeof (((const s1ap_paging_target_t *)a)->key));
+}
+
+//------------------------------------------------------------------------------
+static shared_buffer_t * s1ap_encode_paging (const itti_s1ap_paging_t * const s1ap_paging_pP, const enb_description_t * const eNB_ref)
+{
+  uint8_t                                *buffer_p = NULL;
+  uint32_t                                length = 0;
+  MessagesIds                             message_id = MESSAGES_ID_MAX;
+  s1ap_message                            message = {0}; // yes, alloc on stack
+  S1ap_PagingIEs_t                       *paging_p = NULL;
+  shared_buffer_t                        *shared_p = NULL;
+  const partial_tai_list_t               *partial_tai_list = &eNB_ref->tai_list.partial_tai_list[0];
+  const plmn_t                           *enb_plmn = &partial_tai_list->u.tai_one_plmn_non_consecutive_tacs.plmn;
+
+  /** Just create the message without creating a S1AP UE reference. */
+  message.procedureCode = S1ap_ProcedureCode_id_Paging;
+  message.direction = S1AP_PDU_PR_initiatingMessage;
+  paging_p = &message.msg.s1ap_PagingIEs;
+
+  /** Encode and set the UE Identity Index Value. */
+  paging_p->ueIdentityIndexValue.buf = calloc (2, sizeof(uint8_t));
+  uint16_t index_val = htons(s1ap_paging_pP->ue_identity_index << 6);
+  memcpy(paging_p->ueIdentityIndexValue.buf, (uint8_t*)&index_val, 2);
+
+  paging_p->ueIdentityIndexValue.size = 2;
+  paging_p->ueIdentityIndexValue.bits_unused = 6;
+
+  /** Encode the CN Domain. */
+  paging_p->cnDomain = S1ap_CNDomain_ps;
+
+  /** Set the UE Paging Identity . */
+  paging_p->uePagingID.present = S1ap_UEPagingID_PR_s_TMSI;
+  INT32_TO_OCTET_STRING(s1ap_paging_pP->tmsi, &paging_p->uePagingID.choice.s_TMSI.m_TMSI);
+  // todo: chose the right gummei or get it from the request!
+  INT8_TO_OCTET_STRING(mme_config.gummei.gummei[0].mme_code, &paging_p->uePagingID.choice.s_TMSI.mMEC);
+
+  /** Set the TAI-List. */
+  uint8_t                                 plmn[3] = { 0x00, 0x00, 0x00 };     //{ 0x02, 0xF8, 0x29 };
+  S1ap_TAIItemIEs_t * tai_item = calloc(1, sizeof(S1ap_TAIItemIEs_t));
+  PLMN_T_TO_TBCD (*enb_plmn,
+      plmn,
+      mme_config_find_mnc_length(enb_plmn->mcc_digit1, enb_plmn->mcc_digit2, enb_plmn->mcc_digit3,
+          enb_plmn->mnc_digit1, enb_plmn->mnc_digit2, enb_plmn->mnc_digit3));
+  OCTET_STRING_fromBuf(&tai_item->taiItem.tAI.pLMNidentity, (const char *)plmn, 3);
+  INT16_TO_OCTET_STRING(partial_tai_list->u.tai_one_plmn_non_consecutive_tacs.tac[0], &tai_item->taiItem.tAI.tAC);
+  /** Set the TAI. */
+  ASN_SEQUENCE_ADD (&paging_p->taiList, tai_item);
+
+  for(int ntac = 1; (ntac < partial_tai_list->numberofelements) && (ntac < TRACKING_AREA_IDENTITY_LIST_MAXIMUM_NUM_TAI); ntac++){
+    tai_item = calloc(1, sizeof(S1ap_TAIItemIEs_t));
+    INT16_TO_OCTET_STRING(partial_tai_list->u.tai_one_plmn_non_consecutive_tacs.tac[ntac], &tai_item->taiItem.tAI.tAC);
+    /** Set the TAI. */
+    ASN_SEQUENCE_ADD (&paging_p->taiList, tai_item);
+  }
+
+  if (s1ap_mme_encode_pdu (&message, &message_id, &buffer_p, &length) < 0) {
+    return NULL;
+  }
+  shared_p = shared_buffer_create (buffer_p, length);
+  free(buffer_p);
+  s1ap_free_mme_encode_pdu(&message, message_id);
+  return shared_p;
+}
+
 //------------------------------------------------------------------------------
 void
 s1ap_handle_paging( const itti_s1ap_paging_t * const s1ap_paging_pP){
 
-  uint                                    offset = 0;
   ue_description_t                       *ue_ref = NULL;
-  enb_description_t                      *eNB_ref = NULL;
-  S1ap_PagingIEs_t                       *paging_p = NULL;
 
   OAILOG_FUNC_IN (LOG_S1AP);
   DevAssert (s1ap_paging_pP != NULL);
@@ -1810,98 +2036,73 @@ s1ap_handle_paging( const itti_s1ap_paging_t * const s1ap_paging_pP){
   }
 
   /** Collect all eNBs for the given TAC. */
-//  hashtable_element_array_t              ea;
-  enb_description_t *			         enb_p_elements[mme_config.max_enbs];
-//  memset(&ea, 0, sizeof(hashtable_element_array_t));
+  enb_description_t *                     enb_p_elements[mme_config.max_enbs];
   memset(&enb_p_elements, 0, (sizeof(enb_description_t*) * mme_config.max_enbs));
-//  ea.elements = enb_p_elements;
 
   int num_enbs = 0;
-  s1ap_is_tac_in_list (s1ap_paging_pP->tac, &num_enbs, &enb_p_elements);
+  s1ap_is_tac_in_list (s1ap_paging_pP->tac, &num_enbs, (enb_description_t **)enb_p_elements);
 
-//  void * enb_list_next_element = enb_list;
   if(!num_enbs){
-	  OAILOG_ERROR (LOG_S1AP, " No eNBs could be found for the received TAC " TAC_FMT " for the UE " MME_UE_S1AP_ID_FMT". \n",
-			  s1ap_paging_pP->tac, s1ap_paging_pP->mme_ue_s1ap_id);
-	  OAILOG_FUNC_OUT (LOG_S1AP);
+    OAILOG_ERROR (LOG_S1AP, " No eNBs could be found for the received TAC " TAC_FMT " for the UE " MME_UE_S1AP_ID_FMT". \n",
+        s1ap_paging_pP->tac, s1ap_paging_pP->mme_ue_s1ap_id);
+    OAILOG_FUNC_OUT (LOG_S1AP);
   }
 
+  /** Group the eNBs by TAI list. */
+  s1ap_paging_target_t                   *targets = calloc (num_enbs, sizeof (s1ap_paging_target_t));
+  int                                     num_targets = 0;
+
+  AssertFatal (targets, "Cannot allocate paging targets");
   for(int i = 0; i < num_enbs; i++){
-	  if((eNB_ref = enb_p_elements[i])){
-
-		  uint8_t                                *buffer_p = NULL;
-		  uint32_t                                length = 0;
-		  MessagesIds                             message_id = MESSAGES_ID_MAX;
-		  s1ap_message                            message = {0}; // yes, alloc on stack
-
-		  /** Trigger a paging signal to the target eNB. */
-		  /** Just create the message and send it without creating a S1AP UE reference. */
-		  message.procedureCode = S1ap_ProcedureCode_id_Paging;
-		  message.direction = S1AP_PDU_PR_initiatingMessage;
-		  paging_p = &message.msg.s1ap_PagingIEs;
-
-		  /** Encode and set the UE Identity Index Value. */
-		  paging_p->ueIdentityIndexValue.buf = calloc (2, sizeof(uint8_t));
-		  uint16_t index_val = htons(s1ap_paging_pP->ue_identity_index << 6);
-		  memcpy(paging_p->ueIdentityIndexValue.buf, (uint8_t*)&index_val, 2);
-
-		  paging_p->ueIdentityIndexValue.size = 2;
-		  paging_p->ueIdentityIndexValue.bits_unused = 6;
-
-		  /** Encode the CN Domain. */
-		  paging_p->cnDomain = S1ap_CNDomain_ps;
-
-		  /** Set the UE Paging Identity . */
-		  paging_p->uePagingID.present = S1ap_UEPagingID_PR_s_TMSI;
-		  INT32_TO_OCTET_STRING(s1ap_paging_pP->tmsi, &paging_p->uePagingID.choice.s_TMSI.m_TMSI);
-		  // todo: chose the right gummei or get it from the request!
-		  INT8_TO_OCTET_STRING(mme_config.gummei.gummei[0].mme_code, &paging_p->uePagingID.choice.s_TMSI.mMEC);
-
-		  /** Set the TAI-List. */
-		  uint8_t                                 plmn[3] = { 0x00, 0x00, 0x00 };     //{ 0x02, 0xF8, 0x29 };
-		  S1ap_TAIItemIEs_t * tai_item = calloc(1, sizeof(S1ap_TAIItemIEs_t));
-		  PLMN_T_TO_TBCD (eNB_ref->tai_list.partial_tai_list[0].u.tai_one_plmn_non_consecutive_tacs.plmn,
-				  plmn,
-				  mme_config_find_mnc_length(
-						  eNB_ref->tai_list.partial_tai_list[0].u.tai_one_plmn_non_consecutive_tacs.plmn.mcc_digit1, eNB_ref->tai_list.partial_tai_list[0].u.tai_one_plmn_non_consecutive_tacs.plmn.mcc_digit2, eNB_ref->tai_list.partial_tai_list[0].u.tai_one_plmn_non_consecutive_tacs.plmn.mcc_digit3,
-						  eNB_ref->tai_list.partial_tai_list[0].u.tai_one_plmn_non_consecutive_tacs.plmn.mnc_digit1, eNB_ref->tai_list.partial_tai_list[0].u.tai_one_plmn_non_consecutive_tacs.plmn.mnc_digit2, eNB_ref->tai_list.partial_tai_list[0].u.tai_one_plmn_non_consecutive_tacs.plmn.mnc_digit3)
-		  )
-		  ;
-		  OCTET_STRING_fromBuf(&tai_item->taiItem.tAI.pLMNidentity, plmn, 3);
-		  INT16_TO_OCTET_STRING(eNB_ref->tai_list.partial_tai_list[0].u.tai_one_plmn_non_consecutive_tacs.tac[0], &tai_item->taiItem.tAI.tAC);
-		  /** Set the TAI. */
-		  ASN_SEQUENCE_ADD (&paging_p->taiList, tai_item);
-
-		  for(int ntac = 1; ntac < eNB_ref->tai_list.partial_tai_list[0].numberofelements; ntac++){
-			  tai_item = calloc(1, sizeof(S1ap_TAIItemIEs_t));
-			  INT16_TO_OCTET_STRING(eNB_ref->tai_list.partial_tai_list[0].u.tai_one_plmn_non_consecutive_tacs.tac[ntac], &tai_item->taiItem.tAI.tAC);
-			  /** Set the TAI. */
-			  ASN_SEQUENCE_ADD (&paging_p->taiList, tai_item);
-		  }
-
-		  /** Encoding without allocating? */
-		  if (s1ap_mme_encode_pdu (&message, &message_id, &buffer_p, &length) < 0) {
-			  OAILOG_ERROR (LOG_S1AP, "Failed to encode S1AP paging for enb# %d with tac " TAC_FMT" for UE " MME_UE_S1AP_ID_FMT ".\n",
-					  i, s1ap_paging_pP->tac, s1ap_paging_pP->mme_ue_s1ap_id);
-			  // todo: in this case we will ignore this. no UE contex modification should occure
-			  OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
-		  }
-
-		  OAILOG_NOTICE (LOG_S1AP, "Send S1AP_PAGING message MME_UE_S1AP_ID = " MME_UE_S1AP_ID_FMT " \n",
-				  (mme_ue_s1ap_id_t)s1ap_paging_pP->mme_ue_s1ap_id);
-		  MSC_LOG_TX_MESSAGE (MSC_S1AP_MME,
-				  MSC_S1AP_ENB,
-				  NULL, 0,
-				  "0 S1AP Paging/successfullOutcome mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT,
-				  (mme_ue_s1ap_id_t)s1ap_paging_pP->mme_ue_s1ap_id);
-		  bstring b = blk2bstr(buffer_p, length);
-		  free(buffer_p);
-		  s1ap_free_mme_encode_pdu(&message, message_id);
-		  s1ap_mme_itti_send_sctp_request (&b, eNB_ref->sctp_assoc_id, eNB_ref->next_sctp_stream, s1ap_paging_pP->mme_ue_s1ap_id);
-	  }
+    if (enb_p_elements[i]) {
+      const partial_tai_list_t *partial_tai_list = &enb_p_elements[i]->tai_list.partial_tai_list[0];
+      s1ap_paging_target_t     *target = &targets[num_targets++];
+
+      target->key.plmn             = partial_tai_list->u.tai_one_plmn_non_consecutive_tacs.plmn;
+      target->key.numberofelements = partial_tai_list->numberofelements;
+      for (int ntac = 0; (ntac < partial_tai_list->numberofelements) && (ntac < TRACKING_AREA_IDENTITY_LIST_MAXIMUM_NUM_TAI); ntac++) {
+        target->key.tac[ntac] = partial_tai_list->u.tai_one_plmn_non_consecutive_tacs.tac[ntac];
+      }
+      target->enb = enb_p_elements[i];
+    }
   }
+  qsort (targets, num_targets, sizeof (s1ap_paging_target_t), s1ap_paging_target_cmp);
+
+  int num_groups = 0;
+  for (int first = 0; first < num_targets; ) {
+    int last = first + 1;
 
+    while ((last < num_targets) && (0 == s1ap_paging_target_cmp (&targets[first], &targets[last]))) {
+      last++;
+    }
 
+    /** Trigger a paging signal to all eNBs of the group, the PDU is encoded once. */
+    shared_buffer_t *payload = s1ap_encode_paging (s1ap_paging_pP, targets[first].enb);
+    if (!payload) {
+      OAILOG_ERROR (LOG_S1AP, "Failed to encode S1AP paging for %d enb(s) with tac " TAC_FMT" for UE " MME_UE_S1AP_ID_FMT ".\n",
+          last - first, s1ap_paging_pP->tac, s1ap_paging_pP->mme_ue_s1ap_id);
+      // todo: in this case we will ignore this. no UE contex modification should occure
+      first = last;
+      continue;
+    }
+    num_groups++;
+
+    for (int i = first; i < last; i++) {
+      OAILOG_NOTICE (LOG_S1AP, "Send S1AP_PAGING message MME_UE_S1AP_ID = " MME_UE_S1AP_ID_FMT " \n",
+          (mme_ue_s1ap_id_t)s1ap_paging_pP->mme_ue_s1ap_id);
+      MSC_LOG_TX_MESSAGE (MSC_S1AP_MME,
+          MSC_S1AP_ENB,
+          NULL, 0,
+          "0 S1AP Paging/successfullOutcome mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT,
+          (mme_ue_s1ap_id_t)s1ap_paging_pP->mme_ue_s1ap_id);
+      s1ap_mme_itti_send_sctp_shared_request (payload, targets[i].enb->sctp_assoc_id, targets[i].enb->next_sctp_stream, s1ap_paging_pP->mme_ue_s1ap_id);
+    }
+    shared_buffer_unref (&payload);
+    first = last;
+  }
+  OAILOG_DEBUG (LOG_S1AP, "Paged UE " MME_UE_S1AP_ID_FMT " on %d eNB(s) with %d encoded PDU(s)\n",
+      s1ap_paging_pP->mme_ue_s1ap_id, num_targets, num_groups);
+  free_wrapper ((void**)&targets);
   OAILOG_FUNC_OUT (LOG_S1AP);
 }
 
@@ -0,0 +1,396 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_mme_overload.c
+  \brief MME overload control, see s1ap_mme_overload.h
+  \date 2018
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "hashtable.h"
+#include "log.h"
+#include "assertions.h"
+#include "intertask_interface.h"
+#include "timer.h"
+#include "3gpp_24.008.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_mme_encoder.h"
+#include "s1ap_mme_itti_messaging.h"
+#include "s1ap_mme.h"
+#include "s1ap_mme_overload.h"
+#include "mme_config.h"
+
+extern hash_table_ts_t g_s1ap_enb_coll;
+
+typedef struct s1ap_overload_s {
+  long                 timer_id;
+  uint32_t             queue_threshold;
+  uint32_t             s6a_threshold;
+  uint32_t             s11_threshold;
+  uint32_t             cpu_threshold;
+  uint32_t             stop_hysteresis;
+  int                  nb_levels;
+  struct {
+    uint32_t           load;
+    overload_action_t  action;
+    uint8_t            traffic_load_reduction;
+  } level[MME_CONFIG_MAX_OVERLOAD_LEVELS];
+  uint32_t             t3346_min;
+
+  int                  current_level;       ///< 0: not overloaded, else index + 1 in level
+  uint32_t             load;                ///< last sampled load (%)
+  uint64_t             cpu_us;              ///< process CPU time at last sample
+  uint64_t             wall_us;             ///< monotonic time at last sample
+  long                 nb_cpus;
+  uint32_t             next_ue_id;
+  uint64_t             rejected;            ///< INITIAL UE MESSAGEs rejected in the current overload period
+} s1ap_overload_t;
+
+static s1ap_overload_t                  s1ap_overload = {.timer_id = -1};
+
+/* ITTI tasks whose queue depth is part of the load */
+static const task_id_t                  s1ap_overload_tasks[] = {TASK_MME_APP, TASK_NAS_EMM, TASK_NAS_ESM, TASK_S6A, TASK_S11};
+
+//------------------------------------------------------------------------------
+static uint64_t s1ap_overload_process_cpu_us (void)
+{
+  struct rusage                           usage = {0};
+
+  getrusage (RUSAGE_SELF, &usage);
+  return ((uint64_t)usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+//------------------------------------------------------------------------------
+static uint64_t s1ap_overload_wall_us (void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t s1ap_overload_ratio (const uint64_t value, const uint32_t threshold)
+{
+  return (threshold) ? (uint32_t)((value * 100) / threshold) : 0;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Load in % of the configured capacity, the most loaded resource gives the load of the MME.
+ */
+static uint32_t s1ap_overload_sample (void)
+{
+  itti_task_stats_t                       stats = {0};
+  uint32_t                                load = 0;
+  uint32_t                                ratio = 0;
+  uint32_t                                depth = 0;
+  uint64_t                                cpu_us = s1ap_overload_process_cpu_us ();
+  uint64_t                                wall_us = s1ap_overload_wall_us ();
+
+  if (s1ap_overload.queue_threshold) {
+    for (size_t i = 0; i < sizeof (s1ap_overload_tasks) / sizeof (s1ap_overload_tasks[0]); i++) {
+      uint32_t task_depth = itti_get_queue_depth (s1ap_overload_tasks[i]);
+      if (task_depth > depth) depth = task_depth;
+    }
+    load = s1ap_overload_ratio (depth, s1ap_overload.queue_threshold);
+  }
+  if (s1ap_overload.s6a_threshold) {
+    itti_get_task_stats (TASK_S6A, &stats);
+    ratio = s1ap_overload_ratio (stats.outstanding, s1ap_overload.s6a_threshold);
+    if (ratio > load) load = ratio;
+  }
+  if (s1ap_overload.s11_threshold) {
+    itti_get_task_stats (TASK_S11, &stats);
+    ratio = s1ap_overload_ratio (stats.outstanding, s1ap_overload.s11_threshold);
+    if (ratio > load) load = ratio;
+  }
+  if ((s1ap_overload.cpu_threshold) && (wall_us > s1ap_overload.wall_us)) {
+    // CPU usage in % of all cores since the previous sample
+    uint64_t cpu_percent = ((cpu_us - s1ap_overload.cpu_us) * 100) / ((wall_us - s1ap_overload.wall_us) * s1ap_overload.nb_cpus);
+    ratio = s1ap_overload_ratio (cpu_percent, s1ap_overload.cpu_threshold);
+    if (ratio > load) load = ratio;
+  }
+  s1ap_overload.cpu_us = cpu_us;
+  s1ap_overload.wall_us = wall_us;
+  return load;
+}
+
+//------------------------------------------------------------------------------
+static shared_buffer_t * s1ap_overload_encode (void)
+{
+  uint8_t                                *buffer_p = NULL;
+  uint32_t                                length = 0;
+  MessagesIds                             message_id = MESSAGES_ID_MAX;
+  s1ap_message                            message = {0}; // yes, alloc on stack
+  shared_buffer_t                        *shared_p = NULL;
+
+  message.direction = S1AP_PDU_PR_initiatingMessage;
+  message.criticality = S1ap_Criticality_ignore;
+  if (s1ap_overload.current_level) {
+    S1ap_OverloadStartIEs_t              *overload_start_p = &message.msg.s1ap_OverloadStartIEs;
+    const int                             level = s1ap_overload.current_level - 1;
+
+    message.procedureCode = S1ap_ProcedureCode_id_OverloadStart;
+    overload_start_p->overloadResponse.present = S1ap_OverloadResponse_PR_overloadAction;
+    overload_start_p->overloadResponse.choice.overloadAction = (S1ap_OverloadAction_t) s1ap_overload.level[level].action;
+    if (s1ap_overload.level[level].traffic_load_reduction) {
+      overload_start_p->presenceMask |= S1AP_OVERLOADSTARTIES_TRAFFICLOADREDUCTIONINDICATION_PRESENT;
+      overload_start_p->trafficLoadReductionIndication = s1ap_overload.level[level].traffic_load_reduction;
+    }
+  } else {
+    message.procedureCode = S1ap_ProcedureCode_id_OverloadStop;
+  }
+
+  if (s1ap_mme_encode_pdu (&message, &message_id, &buffer_p, &length) < 0) {
+    return NULL;
+  }
+  shared_p = shared_buffer_create (buffer_p, length);
+  free_wrapper ((void**)&buffer_p);
+  s1ap_free_mme_encode_pdu (&message, message_id);
+  return shared_p;
+}
+
+//------------------------------------------------------------------------------
+static bool s1ap_overload_send_to_enb_cb (__attribute__((unused)) const hash_key_t keyP,
+                                          void * const elementP, void * parameterP,
+                                          __attribute__((unused)) void **resultP)
+{
+  const enb_description_t * const         enb_ref = (const enb_description_t *)elementP;
+  shared_buffer_t                        *payload = (shared_buffer_t *)parameterP;
+
+  if ((enb_ref) && (S1AP_READY == enb_ref->s1_state)) {
+    // Non-UE signalling -> stream 0
+    s1ap_mme_itti_send_sctp_shared_request (payload, enb_ref->sctp_assoc_id, 0, INVALID_MME_UE_S1AP_ID);
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static void s1ap_overload_signal_all_enbs (void)
+{
+  shared_buffer_t                        *payload = s1ap_overload_encode ();
+
+  if (!payload) {
+    OAILOG_ERROR (LOG_S1AP, "Failed to encode S1AP OVERLOAD %s\n", (s1ap_overload.current_level) ? "START":"STOP");
+    return;
+  }
+  // encoded once for all eNBs
+  hashtable_ts_apply_callback_on_elements (&g_s1ap_enb_coll, s1ap_overload_send_to_enb_cb, (void *)payload, NULL);
+  shared_buffer_unref (&payload);
+}
+
+//------------------------------------------------------------------------------
+int s1ap_mme_overload_init (const mme_config_t * mme_config_p)
+{
+  memset (&s1ap_overload, 0, sizeof (s1ap_overload));
+  s1ap_overload.timer_id = -1;
+  s1ap_overload.nb_levels = mme_config_p->s1ap_config.overload.nb_levels;
+  if (!s1ap_overload.nb_levels) {
+    return RETURNok;
+  }
+  s1ap_overload.queue_threshold = mme_config_p->s1ap_config.overload.queue_threshold;
+  s1ap_overload.s6a_threshold   = mme_config_p->s1ap_config.overload.s6a_threshold;
+  s1ap_overload.s11_threshold   = mme_config_p->s1ap_config.overload.s11_threshold;
+  s1ap_overload.cpu_threshold   = mme_config_p->s1ap_config.overload.cpu_threshold;
+  s1ap_overload.stop_hysteresis = mme_config_p->s1ap_config.overload.stop_hysteresis;
+  for (int i = 0; i < s1ap_overload.nb_levels; i++) {
+    s1ap_overload.level[i].load                   = mme_config_p->s1ap_config.overload.level[i].load;
+    s1ap_overload.level[i].action                 = mme_config_p->s1ap_config.overload.level[i].action;
+    s1ap_overload.level[i].traffic_load_reduction = mme_config_p->s1ap_config.overload.level[i].traffic_load_reduction;
+  }
+  // T3346 is configured in minutes
+  s1ap_overload.t3346_min = mme_config_p->nas_config.t3346_sec;
+  s1ap_overload.nb_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+  if (s1ap_overload.nb_cpus < 1) {
+    s1ap_overload.nb_cpus = 1;
+  }
+  s1ap_overload.cpu_us = s1ap_overload_process_cpu_us ();
+  s1ap_overload.wall_us = s1ap_overload_wall_us ();
+
+  if (timer_setup (mme_config_p->s1ap_config.overload.period_ms / 1000, (mme_config_p->s1ap_config.overload.period_ms % 1000) * 1000,
+      TASK_S1AP, INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &s1ap_overload.timer_id) < 0) {
+    OAILOG_ERROR (LOG_S1AP, "Failed to start the overload control timer\n");
+    s1ap_overload.timer_id = -1;
+    return RETURNerror;
+  }
+  OAILOG_INFO (LOG_S1AP, "Overload control started with %d level(s), sampled every %u ms\n",
+      s1ap_overload.nb_levels, mme_config_p->s1ap_config.overload.period_ms);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void s1ap_mme_overload_exit (void)
+{
+  if (-1 != s1ap_overload.timer_id) {
+    timer_remove (s1ap_overload.timer_id, NULL);
+    s1ap_overload.timer_id = -1;
+  }
+}
+
+//------------------------------------------------------------------------------
+bool s1ap_mme_overload_handle_timer_expiry (const long timer_id)
+{
+  int                                     new_level = 0;
+
+  if ((-1 == s1ap_overload.timer_id) || (timer_id != s1ap_overload.timer_id)) {
+    return false;
+  }
+  s1ap_overload.load = s1ap_overload_sample ();
+
+  // Enter the highest level reached at once, leave levels one by one with an hysteresis
+  for (int i = 0; i < s1ap_overload.nb_levels; i++) {
+    if (s1ap_overload.load >= s1ap_overload.level[i].load) {
+      new_level = i + 1;
+    }
+  }
+  if (new_level < s1ap_overload.current_level) {
+    new_level = s1ap_overload.current_level;
+    while ((new_level) && ((s1ap_overload.load + s1ap_overload.stop_hysteresis) < s1ap_overload.level[new_level - 1].load)) {
+      new_level--;
+    }
+  }
+  if (new_level == s1ap_overload.current_level) {
+    return true;
+  }
+
+  if (new_level) {
+    OAILOG_WARNING (LOG_S1AP, "MME load %u%%, overload level %d -> %d (action %d, traffic load reduction %u%%), sending OVERLOAD START\n",
+        s1ap_overload.load, s1ap_overload.current_level, new_level, s1ap_overload.level[new_level - 1].action,
+        s1ap_overload.level[new_level - 1].traffic_load_reduction);
+  } else {
+    OAILOG_WARNING (LOG_S1AP, "MME load %u%%, overload ended, %"PRIu64" INITIAL UE MESSAGEs rejected, sending OVERLOAD STOP\n",
+        s1ap_overload.load, s1ap_overload.rejected);
+    s1ap_overload.rejected = 0;
+  }
+  s1ap_overload.current_level = new_level;
+  s1ap_overload_signal_all_enbs ();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void s1ap_mme_overload_enb_ready (const enb_description_t * const enb_ref)
+{
+  shared_buffer_t                        *payload = NULL;
+
+  if (!s1ap_overload.current_level) {
+    return;
+  }
+  if ((payload = s1ap_overload_encode ())) {
+    s1ap_mme_itti_send_sctp_shared_request (payload, enb_ref->sctp_assoc_id, 0, INVALID_MME_UE_S1AP_ID);
+    shared_buffer_unref (&payload);
+  }
+}
+
+//------------------------------------------------------------------------------
+bool s1ap_mme_overload_admit (const long rrc_establishment_cause)
+{
+  bool                                    reject = false;
+
+  if (!s1ap_overload.current_level) {
+    return true;
+  }
+  switch (s1ap_overload.level[s1ap_overload.current_level - 1].action) {
+    case OVERLOAD_ACTION_REJECT_NON_EMERGENCY_MO_DT:
+      reject = (S1ap_RRC_Establishment_Cause_mo_Data == rrc_establishment_cause);
+      break;
+    case OVERLOAD_ACTION_REJECT_RRC_CR_SIGNALLING:
+      reject = (S1ap_RRC_Establishment_Cause_mo_Data == rrc_establishment_cause) ||
+               (S1ap_RRC_Establishment_Cause_mo_Signalling == rrc_establishment_cause);
+      break;
+    case OVERLOAD_ACTION_PERMIT_EMERGENCY_SESSIONS_AND_MOBILE_TERMINATED_SERVICES_ONLY:
+      reject = (S1ap_RRC_Establishment_Cause_emergency != rrc_establishment_cause) &&
+               (S1ap_RRC_Establishment_Cause_mt_Access != rrc_establishment_cause);
+      break;
+    case OVERLOAD_ACTION_PERMIT_HIGH_PRIORITY_SESSIONS_AND_MOBILE_TERMINATED_SERVICES_ONLY:
+      reject = (S1ap_RRC_Establishment_Cause_emergency != rrc_establishment_cause) &&
+               (S1ap_RRC_Establishment_Cause_highPriorityAccess != rrc_establishment_cause) &&
+               (S1ap_RRC_Establishment_Cause_mt_Access != rrc_establishment_cause);
+      break;
+    case OVERLOAD_ACTION_REJECT_DELAY_TOLERANT_ACCESS:
+      reject = (S1ap_RRC_Establishment_Cause_delay_TolerantAccess == rrc_establishment_cause);
+      break;
+    default:
+      break;
+  }
+  // Shed the same share of the traffic as the eNBs were asked to
+  if ((reject) && (s1ap_overload.level[s1ap_overload.current_level - 1].traffic_load_reduction)) {
+    reject = ((uint32_t)(random () % 100) < s1ap_overload.level[s1ap_overload.current_level - 1].traffic_load_reduction);
+  }
+  return !reject;
+}
+
+//------------------------------------------------------------------------------
+bstring s1ap_mme_overload_nas_reject (const uint8_t * const nas, const uint32_t length)
+{
+  uint8_t                                 pdu[6] = {0x07, 0x00, 0x16, 0x5f, 0x01, 0x00}; // plain EMM, type, cause #22 congestion, T3346
+  uint32_t                                t3346 = s1ap_overload.t3346_min;
+
+  switch (s1ap_ue_latency_nas_procedure (nas, length)) {
+    case ITTI_LATENCY_PROC_ATTACH:
+      pdu[1] = 0x44;    // ATTACH REJECT
+      break;
+    case ITTI_LATENCY_PROC_TAU:
+      pdu[1] = 0x4b;    // TRACKING AREA UPDATE REJECT
+      break;
+    case ITTI_LATENCY_PROC_SERVICE_REQUEST:
+      pdu[1] = 0x4e;    // SERVICE REJECT
+      break;
+    default:
+      // DETACH REQUEST and anything else go through
+      return NULL;
+  }
+  s1ap_overload.rejected++;
+  if (!t3346) {
+    return blk2bstr (pdu, 3);
+  }
+  // TS 23.401 4.3.7.4.2.4: spread the back-off timers so that the deferred requests are not synchronized (+-25%)
+  t3346 = t3346 - t3346 / 4 + (uint32_t)(random () % (t3346 / 2 + 1));
+  if (t3346 <= 31) {
+    pdu[5] = (GPRS_TIMER_UNIT_60S << 5) | t3346;
+  } else {
+    t3346 = (t3346 + 5) / 6;
+    pdu[5] = (GPRS_TIMER_UNIT_360S << 5) | ((t3346 <= 31) ? t3346 : 31);
+  }
+  return blk2bstr (pdu, sizeof (pdu));
+}
+
+//------------------------------------------------------------------------------
+mme_ue_s1ap_id_t s1ap_mme_overload_new_ue_id (void)
+{
+  s1ap_overload.next_ue_id = (s1ap_overload.next_ue_id + 1) & S1AP_OVERLOAD_MME_UE_S1AP_ID_MASK;
+  return S1AP_OVERLOAD_MME_UE_S1AP_ID_BASE | s1ap_overload.next_ue_id;
+}
@@ -0,0 +1,74 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_mme_overload.h
+  \brief MME overload control (3GPP TS 23.401 4.3.7.4.1, TS 36.413 8.7.6).
+  \ The MME load is sampled periodically in the S1AP task from the ITTI queue depths, the outstanding S6a and S11
+  \ requests and the process CPU usage. Crossing a configured level sends OVERLOAD START with the level action to
+  \ all eNBs, INITIAL UE MESSAGEs not allowed by the action are rejected by the MME itself (backstop for eNBs
+  \ not applying it) with EMM cause #22 and T3346. OVERLOAD STOP is sent once the load is back below the levels.
+  \date 2018
+*/
+
+#ifndef FILE_S1AP_MME_OVERLOAD_SEEN
+#define FILE_S1AP_MME_OVERLOAD_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bstrlib.h"
+
+struct mme_config_s;
+struct enb_description_s;
+
+/* MME UE S1AP IDs of the UE-associated signalling connections released by the overload control, never allocated by MME_APP */
+#define S1AP_OVERLOAD_MME_UE_S1AP_ID_BASE   0xFF000000
+#define S1AP_OVERLOAD_MME_UE_S1AP_ID_MASK   0x00FFFFFF
+
+int  s1ap_mme_overload_init (const struct mme_config_s * mme_config_p);
+void s1ap_mme_overload_exit (void);
+
+/** \brief Sample the load, change the overload level and signal it to the eNBs if needed.
+ \param timer_id Id of the expired timer
+ @returns false if the timer is not the overload sampling timer
+ **/
+bool s1ap_mme_overload_handle_timer_expiry (const long timer_id);
+
+/** \brief Send the current OVERLOAD START, if any, to an eNB that just completed the S1 setup. **/
+void s1ap_mme_overload_enb_ready (const struct enb_description_s * const enb_ref);
+
+/** \brief Check a new UE-associated signalling connection against the current overload action.
+ \param rrc_establishment_cause RRC Establishment Cause of the INITIAL UE MESSAGE
+ @returns true if the connection is accepted
+ **/
+bool s1ap_mme_overload_admit (const long rrc_establishment_cause);
+
+/** \brief Build the plain NAS reject answering an initial NAS message, with EMM cause #22 and T3346.
+ \param nas Initial NAS message
+ \param length Length of nas
+ @returns NULL if the NAS message must not be rejected (DETACH REQUEST, unknown message)
+ **/
+bstring s1ap_mme_overload_nas_reject (const uint8_t * const nas, const uint32_t length);
+
+/** \brief Next MME UE S1AP ID to use for a connection released by the overload control. **/
+mme_ue_s1ap_id_t s1ap_mme_overload_new_ue_id (void);
+
+#endif /* FILE_S1AP_MME_OVERLOAD_SEEN */
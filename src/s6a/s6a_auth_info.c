@@ -41,6 +41,8 @@
 #include "intertask_interface.h"
 #include "s6a_defs.h"
 #include "s6a_messages.h"
+#include "s6a_auth_vector_cache.h"
+#include "s6a_pipeline.h"
 #include "msc.h"
 
 static
@@ -164,14 +166,15 @@ s6a_parse_e_utran_vector (
 static inline int
 s6a_parse_authentication_info_avp (
   struct avp *avp_auth_info,
-  authentication_info_t * authentication_info)
+  eutran_vector_t * vectors,
+  int * nb_vectors)
 {
   struct avp                             *avp;
   struct avp_hdr                         *hdr;
 
   CHECK_FCT (fd_msg_avp_hdr (avp_auth_info, &hdr));
   DevCheck (hdr->avp_code == AVP_CODE_AUTHENTICATION_INFO, hdr->avp_code, AVP_CODE_AUTHENTICATION_INFO, 0);
-  authentication_info->nb_of_vectors = 0;
+  *nb_vectors = 0;
   CHECK_FCT (fd_msg_browse (avp_auth_info, MSG_BRW_FIRST_CHILD, &avp, NULL));
 
   while (avp) {
@@ -179,9 +182,9 @@ s6a_parse_authentication_info_avp (
 
     switch (hdr->avp_code) {
     case AVP_CODE_E_UTRAN_VECTOR:{
-      DevAssert (MAX_EPS_AUTH_VECTORS > authentication_info->nb_of_vectors);
-      CHECK_FCT (s6a_parse_e_utran_vector (avp, &authentication_info->eutran_vector[authentication_info->nb_of_vectors]));
-      authentication_info->nb_of_vectors++;
+      DevAssert (S6A_AUTH_VECTOR_CACHE_MAX_VECTORS > *nb_vectors);
+      CHECK_FCT (s6a_parse_e_utran_vector (avp, &vectors[*nb_vectors]));
+      (*nb_vectors)++;
       }
       break;
 
@@ -217,9 +220,16 @@ s6a_aia_cb (
   MessageDef                             *message_p = NULL;
   s6a_auth_info_ans_t                    *s6a_auth_info_ans_p = NULL;
   int                                     skip_auth_res = 0;
+  eutran_vector_t                         vectors[S6A_AUTH_VECTOR_CACHE_MAX_VECTORS];
+  int                                     nb_vectors = 0;
 
   DevAssert (msg );
   ans = *msg;
+  if (!s6a_pipeline_answer_received (ans)) {
+    fd_msg_free (*msg);
+    *msg = NULL;
+    return RETURNok;
+  }
   /*
    * Retrieve the original query associated with the asnwer
    */
@@ -287,7 +297,7 @@ s6a_aia_cb (
     CHECK_FCT (fd_msg_search_avp (ans, s6a_fd_cnf.dataobj_s6a_authentication_info, &avp));
 
     if (avp) {
-      CHECK_FCT (s6a_parse_authentication_info_avp (avp, &s6a_auth_info_ans_p->auth_info));
+      CHECK_FCT (s6a_parse_authentication_info_avp (avp, vectors, &nb_vectors));
     } else {
       DevMessage ("We requested E-UTRAN vectors with an immediate response...\n");
       return RETURNerror;
@@ -296,7 +306,15 @@ s6a_aia_cb (
   fd_msg_free(*msg);
   *msg = NULL;
 
-  itti_send_msg_to_task (TASK_NAS_EMM, INSTANCE_DEFAULT, message_p);
+  /*
+   * Vectors not needed by NAS are kept for next authentications, answers of prefetches are not forwarded
+   */
+  if (!s6a_auth_vector_cache_store (s6a_auth_info_ans_p->imsi, vectors, nb_vectors, &s6a_auth_info_ans_p->auth_info)) {
+    OAILOG_DEBUG (LOG_S6A, "Stored %d prefetched authentication vectors of IMSI %s\n", nb_vectors, s6a_auth_info_ans_p->imsi);
+    itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
+    return RETURNok;
+  }
+  s6a_pipeline_post (TASK_NAS_EMM, message_p);
 err:
   return RETURNok;
 }
@@ -314,7 +332,7 @@ s6a_generate_authentication_info_req (
   /*
    * Create the new update location request message
    */
-  CHECK_FCT (fd_msg_new (s6a_fd_cnf.dataobj_s6a_air, 0, &msg));
+  CHECK_FCT (fd_msg_new (s6a_fd_cnf.dataobj_s6a_air, MSGFL_ALLOC_ETEID, &msg));
   /*
    * Create a new session
    */
@@ -430,6 +448,5 @@ s6a_generate_authentication_info_req (
 
     CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
   }
-  CHECK_FCT (fd_msg_send (&msg, NULL, NULL));
-  return RETURNok;
+  return s6a_pipeline_send (&msg, S6A_REQUEST_AIR, air_p->imsi, INVALID_MME_UE_S1AP_ID);
 }
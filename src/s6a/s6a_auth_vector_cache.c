@@ -0,0 +1,424 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s6a_auth_vector_cache.c
+  \brief Authentication vector cache of the S6A task.
+  \date 2018
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "log.h"
+#include "assertions.h"
+#include "queue.h"
+#include "hashtable.h"
+#include "common_types.h"
+#include "common_defs.h"
+#include "mme_config.h"
+#include "intertask_interface.h"
+#include "s6a_auth_vector_cache.h"
+
+typedef struct s6a_auth_vector_cache_entry_s {
+  char                 imsi[IMSI_BCD_DIGITS_MAX + 1];
+  hash_key_t           key;
+  bool                 air_in_flight;
+  bool                 nas_waiting;       ///< the answer of the AIR in flight is for NAS, not a prefetch
+  bool                 discard_answer;    ///< invalidated while an AIR was in flight
+  uint8_t              nas_nb_vectors;
+  time_t               air_sent_sec;
+  int                  nb_vectors;
+  time_t               fetched_sec[S6A_AUTH_VECTOR_CACHE_MAX_VECTORS];
+  eutran_vector_t      vector[S6A_AUTH_VECTOR_CACHE_MAX_VECTORS];  ///< oldest (lowest SQN) first
+  TAILQ_ENTRY(s6a_auth_vector_cache_entry_s) lru;
+} s6a_auth_vector_cache_entry_t;
+
+typedef struct s6a_auth_vector_cache_s {
+  pthread_mutex_t      lock;               ///< AIAs, CLRs and Resets are handled in freeDiameter threads
+  hash_table_t        *entries;
+  TAILQ_HEAD(s6a_auth_vector_cache_lru_s, s6a_auth_vector_cache_entry_s) lru; ///< least recently used first
+  uint32_t             nb_entries;
+  uint32_t             max_entries;
+  uint32_t             nb_vectors_per_air;
+  uint32_t             max_age_sec;
+  bool                 prefetch;
+  uint64_t             hits;
+  uint64_t             misses;
+  uint64_t             prefetches;
+  uint64_t             expired;
+} s6a_auth_vector_cache_t;
+
+static s6a_auth_vector_cache_t   g_s6a_avc = {.lock = PTHREAD_MUTEX_INITIALIZER, .entries = NULL};
+
+//------------------------------------------------------------------------------
+static inline time_t s6a_auth_vector_cache_now_sec (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+//------------------------------------------------------------------------------
+static inline hash_key_t s6a_auth_vector_cache_key (const char * const imsi)
+{
+  return (hash_key_t)strtoull (imsi, NULL, 10);
+}
+
+//------------------------------------------------------------------------------
+static s6a_auth_vector_cache_entry_t * s6a_auth_vector_cache_find (const char * const imsi)
+{
+  s6a_auth_vector_cache_entry_t * entry = NULL;
+
+  if (HASH_TABLE_OK == hashtable_get (g_s6a_avc.entries, s6a_auth_vector_cache_key (imsi), (void **)&entry)) {
+    if (!strcmp (entry->imsi, imsi)) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void s6a_auth_vector_cache_remove (s6a_auth_vector_cache_entry_t * entry)
+{
+  TAILQ_REMOVE (&g_s6a_avc.lru, entry, lru);
+  hashtable_remove (g_s6a_avc.entries, entry->key, (void **)&entry);
+  g_s6a_avc.nb_entries--;
+  free_wrapper ((void **)&entry);
+}
+
+//------------------------------------------------------------------------------
+static s6a_auth_vector_cache_entry_t * s6a_auth_vector_cache_new (const char * const imsi)
+{
+  s6a_auth_vector_cache_entry_t * entry = NULL;
+
+  if (g_s6a_avc.nb_entries >= g_s6a_avc.max_entries) {
+    // evict the least recently used IMSI, unless an answer is expected for it
+    TAILQ_FOREACH(entry, &g_s6a_avc.lru, lru) {
+      if (!entry->air_in_flight) {
+        break;
+      }
+    }
+    if (!entry) {
+      return NULL;
+    }
+    s6a_auth_vector_cache_remove (entry);
+  }
+  entry = calloc (1, sizeof (*entry));
+  if (!entry) {
+    return NULL;
+  }
+  strncpy (entry->imsi, imsi, IMSI_BCD_DIGITS_MAX);
+  entry->key = s6a_auth_vector_cache_key (imsi);
+  if (HASH_TABLE_OK != hashtable_insert (g_s6a_avc.entries, entry->key, entry)) {
+    free_wrapper ((void **)&entry);
+    return NULL;
+  }
+  TAILQ_INSERT_TAIL (&g_s6a_avc.lru, entry, lru);
+  g_s6a_avc.nb_entries++;
+  return entry;
+}
+
+//------------------------------------------------------------------------------
+static void s6a_auth_vector_cache_touch (s6a_auth_vector_cache_entry_t * const entry)
+{
+  TAILQ_REMOVE (&g_s6a_avc.lru, entry, lru);
+  TAILQ_INSERT_TAIL (&g_s6a_avc.lru, entry, lru);
+}
+
+//------------------------------------------------------------------------------
+static void s6a_auth_vector_cache_pop (s6a_auth_vector_cache_entry_t * const entry, const int nb)
+{
+  entry->nb_vectors -= nb;
+  memmove (&entry->vector[0], &entry->vector[nb], entry->nb_vectors * sizeof (entry->vector[0]));
+  memmove (&entry->fetched_sec[0], &entry->fetched_sec[nb], entry->nb_vectors * sizeof (entry->fetched_sec[0]));
+}
+
+//------------------------------------------------------------------------------
+static void s6a_auth_vector_cache_expire (s6a_auth_vector_cache_entry_t * const entry, const time_t now)
+{
+  int nb = 0;
+
+  // vectors are ordered by fetch time
+  while ((nb < entry->nb_vectors) && ((entry->fetched_sec[nb] + g_s6a_avc.max_age_sec) < now)) {
+    nb++;
+  }
+  if (nb) {
+    g_s6a_avc.expired += nb;
+    s6a_auth_vector_cache_pop (entry, nb);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void s6a_auth_vector_cache_copy_to_nas (const eutran_vector_t * const vectors, const int nb_vectors,
+    authentication_info_t * const auth_info)
+{
+  auth_info->nb_of_vectors = 0;
+  for (int i = 0; (i < nb_vectors) && (i < MAX_EPS_AUTH_VECTORS); i++) {
+    auth_info->eutran_vector[i] = vectors[i];
+    auth_info->nb_of_vectors++;
+  }
+}
+
+//------------------------------------------------------------------------------
+int s6a_auth_vector_cache_init (const mme_config_t * mme_config_p)
+{
+  g_s6a_avc.max_entries        = mme_config_p->s6a_config.auth_vector_cache.size;
+  g_s6a_avc.nb_vectors_per_air = mme_config_p->s6a_config.auth_vector_cache.nb_vectors;
+  g_s6a_avc.max_age_sec        = mme_config_p->s6a_config.auth_vector_cache.max_age_sec;
+  g_s6a_avc.prefetch           = mme_config_p->s6a_config.auth_vector_cache.prefetch;
+  TAILQ_INIT (&g_s6a_avc.lru);
+  if (!g_s6a_avc.max_entries) {
+    return RETURNok;
+  }
+  bstring b = bfromcstr ("s6a_auth_vector_cache");
+  g_s6a_avc.entries = hashtable_create (g_s6a_avc.max_entries, NULL, hash_free_func, b);
+  bdestroy_wrapper (&b);
+  if (!g_s6a_avc.entries) {
+    OAILOG_ERROR (LOG_S6A, "Failed to allocate the authentication vector cache\n");
+    return RETURNerror;
+  }
+  g_s6a_avc.entries->log_enabled = false;
+  OAILOG_INFO (LOG_S6A, "Authentication vector cache of %u IMSIs, %u vectors per AIR\n", g_s6a_avc.max_entries, g_s6a_avc.nb_vectors_per_air);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void s6a_auth_vector_cache_exit (void)
+{
+  pthread_mutex_lock (&g_s6a_avc.lock);
+  if (g_s6a_avc.entries) {
+    OAILOG_INFO (LOG_S6A, "Authentication vector cache: %" PRIu64 " hits %" PRIu64 " misses %" PRIu64 " prefetches %" PRIu64 " expired vectors\n",
+        g_s6a_avc.hits, g_s6a_avc.misses, g_s6a_avc.prefetches, g_s6a_avc.expired);
+    hashtable_destroy (g_s6a_avc.entries);
+    g_s6a_avc.entries = NULL;
+    TAILQ_INIT (&g_s6a_avc.lru);
+    g_s6a_avc.nb_entries = 0;
+  }
+  pthread_mutex_unlock (&g_s6a_avc.lock);
+}
+
+//------------------------------------------------------------------------------
+s6a_auth_vector_cache_rc_t s6a_auth_vector_cache_lookup (s6a_auth_info_req_t * const air_p, authentication_info_t * const auth_info)
+{
+  s6a_auth_vector_cache_entry_t * entry = NULL;
+  const time_t                    now = s6a_auth_vector_cache_now_sec ();
+  s6a_auth_vector_cache_rc_t      rc = S6A_AUTH_VECTOR_CACHE_MISS;
+
+  if (!g_s6a_avc.entries) {
+    return S6A_AUTH_VECTOR_CACHE_MISS;
+  }
+  pthread_mutex_lock (&g_s6a_avc.lock);
+  entry = s6a_auth_vector_cache_find (air_p->imsi);
+  if (entry) {
+    s6a_auth_vector_cache_touch (entry);
+    if (air_p->re_synchronization) {
+      // SQN of the USIM is out of the range of the cached vectors
+      entry->nb_vectors = 0;
+      entry->discard_answer = false;
+    } else {
+      s6a_auth_vector_cache_expire (entry, now);
+      if (entry->nb_vectors) {
+        int nb = (air_p->nb_of_vectors < entry->nb_vectors) ? air_p->nb_of_vectors : entry->nb_vectors;
+
+        s6a_auth_vector_cache_copy_to_nas (entry->vector, nb, auth_info);
+        s6a_auth_vector_cache_pop (entry, auth_info->nb_of_vectors);
+        g_s6a_avc.hits++;
+        pthread_mutex_unlock (&g_s6a_avc.lock);
+        OAILOG_DEBUG (LOG_S6A, "Authentication vector of IMSI %s taken from the cache\n", air_p->imsi);
+        return S6A_AUTH_VECTOR_CACHE_HIT;
+      }
+      if ((entry->air_in_flight) && ((now - entry->air_sent_sec) < S6A_AUTH_VECTOR_CACHE_AIR_TIMEOUT_SEC)) {
+        entry->nas_waiting    = true;
+        entry->nas_nb_vectors = air_p->nb_of_vectors;
+        pthread_mutex_unlock (&g_s6a_avc.lock);
+        OAILOG_DEBUG (LOG_S6A, "Waiting for the prefetched authentication vectors of IMSI %s\n", air_p->imsi);
+        return S6A_AUTH_VECTOR_CACHE_PENDING;
+      }
+    }
+  } else {
+    entry = s6a_auth_vector_cache_new (air_p->imsi);
+  }
+  g_s6a_avc.misses++;
+  if (entry) {
+    entry->air_in_flight  = true;
+    entry->air_sent_sec   = now;
+    entry->nas_waiting    = true;
+    entry->nas_nb_vectors = air_p->nb_of_vectors;
+    if (air_p->nb_of_vectors < g_s6a_avc.nb_vectors_per_air) {
+      air_p->nb_of_vectors = g_s6a_avc.nb_vectors_per_air;
+    }
+  }
+  pthread_mutex_unlock (&g_s6a_avc.lock);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+bool s6a_auth_vector_cache_prefetch (s6a_auth_info_req_t * const air_p)
+{
+  s6a_auth_vector_cache_entry_t * entry = NULL;
+  const time_t                    now = s6a_auth_vector_cache_now_sec ();
+
+  if ((!g_s6a_avc.entries) || (!g_s6a_avc.prefetch)) {
+    return false;
+  }
+  pthread_mutex_lock (&g_s6a_avc.lock);
+  entry = s6a_auth_vector_cache_find (air_p->imsi);
+  if (entry) {
+    s6a_auth_vector_cache_expire (entry, now);
+    if ((entry->nb_vectors) || ((entry->air_in_flight) && ((now - entry->air_sent_sec) < S6A_AUTH_VECTOR_CACHE_AIR_TIMEOUT_SEC))) {
+      pthread_mutex_unlock (&g_s6a_avc.lock);
+      return false;
+    }
+    s6a_auth_vector_cache_touch (entry);
+  } else if (!(entry = s6a_auth_vector_cache_new (air_p->imsi))) {
+    pthread_mutex_unlock (&g_s6a_avc.lock);
+    return false;
+  }
+  entry->air_in_flight  = true;
+  entry->air_sent_sec   = now;
+  entry->nas_waiting    = false;
+  entry->discard_answer = false;
+  g_s6a_avc.prefetches++;
+  pthread_mutex_unlock (&g_s6a_avc.lock);
+
+  air_p->nb_of_vectors      = g_s6a_avc.nb_vectors_per_air;
+  air_p->re_synchronization = 0;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void s6a_auth_vector_cache_air_failed (const char * const imsi)
+{
+  s6a_auth_vector_cache_entry_t * entry = NULL;
+
+  if (!g_s6a_avc.entries) {
+    return;
+  }
+  pthread_mutex_lock (&g_s6a_avc.lock);
+  if ((entry = s6a_auth_vector_cache_find (imsi))) {
+    entry->air_in_flight = false;
+    entry->nas_waiting   = false;
+  }
+  pthread_mutex_unlock (&g_s6a_avc.lock);
+}
+
+//------------------------------------------------------------------------------
+bool s6a_auth_vector_cache_store (const char * const imsi, const eutran_vector_t * const vectors, const int nb_vectors,
+    authentication_info_t * const auth_info)
+{
+  s6a_auth_vector_cache_entry_t * entry = NULL;
+  const time_t                    now = s6a_auth_vector_cache_now_sec ();
+  bool                            to_nas = true;
+  int                             first = 0;
+
+  if (!g_s6a_avc.entries) {
+    s6a_auth_vector_cache_copy_to_nas (vectors, nb_vectors, auth_info);
+    return true;
+  }
+  pthread_mutex_lock (&g_s6a_avc.lock);
+  entry = s6a_auth_vector_cache_find (imsi);
+  if ((!entry) || (!entry->air_in_flight)) {
+    // AIR sent without the cache (full or answer given up)
+    pthread_mutex_unlock (&g_s6a_avc.lock);
+    s6a_auth_vector_cache_copy_to_nas (vectors, nb_vectors, auth_info);
+    return true;
+  }
+  entry->air_in_flight = false;
+  to_nas = entry->nas_waiting;
+  entry->nas_waiting = false;
+  if (to_nas) {
+    int nb = (entry->nas_nb_vectors < nb_vectors) ? entry->nas_nb_vectors : nb_vectors;
+
+    s6a_auth_vector_cache_copy_to_nas (vectors, nb, auth_info);
+    first = auth_info->nb_of_vectors;
+    if (first) {
+      // cached vectors have a lower SQN than the one given to NAS, the USIM would reject them
+      entry->nb_vectors = 0;
+    }
+  }
+  if (entry->discard_answer) {
+    entry->discard_answer = false;
+  } else {
+    for (int i = first; (i < nb_vectors) && (entry->nb_vectors < S6A_AUTH_VECTOR_CACHE_MAX_VECTORS); i++) {
+      entry->vector[entry->nb_vectors]      = vectors[i];
+      entry->fetched_sec[entry->nb_vectors] = now;
+      entry->nb_vectors++;
+    }
+  }
+  if ((!entry->nb_vectors) && (!to_nas)) {
+    // failed prefetch
+    s6a_auth_vector_cache_remove (entry);
+  }
+  pthread_mutex_unlock (&g_s6a_avc.lock);
+  return to_nas;
+}
+
+//------------------------------------------------------------------------------
+void s6a_auth_vector_cache_invalidate (const char * const imsi)
+{
+  s6a_auth_vector_cache_entry_t * entry = NULL;
+
+  if (!g_s6a_avc.entries) {
+    return;
+  }
+  pthread_mutex_lock (&g_s6a_avc.lock);
+  if ((entry = s6a_auth_vector_cache_find (imsi))) {
+    if (entry->air_in_flight) {
+      entry->nb_vectors     = 0;
+      entry->discard_answer = true;
+    } else {
+      s6a_auth_vector_cache_remove (entry);
+    }
+  }
+  pthread_mutex_unlock (&g_s6a_avc.lock);
+}
+
+//------------------------------------------------------------------------------
+void s6a_auth_vector_cache_flush (void)
+{
+  s6a_auth_vector_cache_entry_t * entry = NULL;
+  s6a_auth_vector_cache_entry_t * next = NULL;
+
+  if (!g_s6a_avc.entries) {
+    return;
+  }
+  pthread_mutex_lock (&g_s6a_avc.lock);
+  for (entry = TAILQ_FIRST (&g_s6a_avc.lru); entry; entry = next) {
+    next = TAILQ_NEXT (entry, lru);
+    if (entry->air_in_flight) {
+      entry->nb_vectors     = 0;
+      entry->discard_answer = true;
+    } else {
+      s6a_auth_vector_cache_remove (entry);
+    }
+  }
+  pthread_mutex_unlock (&g_s6a_avc.lock);
+}
@@ -0,0 +1,80 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s6a_auth_vector_cache.h
+  \brief Authentication vector cache of the S6A task.
+  \ When enabled, AIRs ask the HSS for several E-UTRAN vectors, the ones not used by NAS are kept per IMSI in a bounded
+  \ LRU cache that outlives the UE context, so that the next authentication of the UE (re-attach after an implicit
+  \ detach for instance) does not wait for the HSS. Vectors are handed out in the order of the HSS (increasing SQN),
+  \ dropped after a maximum age, on SQN re-synchronization, Cancel Location and Reset.
+  \date 2018
+*/
+
+#ifndef FILE_S6A_AUTH_VECTOR_CACHE_SEEN
+#define FILE_S6A_AUTH_VECTOR_CACHE_SEEN
+
+#include <stdbool.h>
+
+struct mme_config_s;
+
+/* Number-Of-Requested-Vectors upper bound */
+#define S6A_AUTH_VECTOR_CACHE_MAX_VECTORS        5
+/* An AIR in flight for longer than this is considered lost */
+#define S6A_AUTH_VECTOR_CACHE_AIR_TIMEOUT_SEC    5
+
+typedef enum s6a_auth_vector_cache_rc_e {
+  S6A_AUTH_VECTOR_CACHE_HIT = 0,       ///< vectors taken from the cache
+  S6A_AUTH_VECTOR_CACHE_MISS,          ///< an AIR has to be sent
+  S6A_AUTH_VECTOR_CACHE_PENDING        ///< an AIR is already in flight for the IMSI, its answer will be given to NAS
+} s6a_auth_vector_cache_rc_t;
+
+int  s6a_auth_vector_cache_init (const struct mme_config_s * mme_config_p);
+void s6a_auth_vector_cache_exit (void);
+
+/** \brief Look for vectors for an AIR received from NAS (S6A task).
+ \param air_p On a miss, its number of requested vectors may be raised to the configured value
+ \param auth_info Filled on a hit
+ **/
+s6a_auth_vector_cache_rc_t s6a_auth_vector_cache_lookup (s6a_auth_info_req_t * const air_p, authentication_info_t * const auth_info);
+
+/** \brief Prepare the prefetch of vectors for a UE whose context is being removed (S6A task).
+ @returns true if the AIR has to be sent
+ **/
+bool s6a_auth_vector_cache_prefetch (s6a_auth_info_req_t * const air_p);
+
+/** \brief The AIR could not be sent. **/
+void s6a_auth_vector_cache_air_failed (const char * const imsi);
+
+/** \brief Split the vectors of an AIA between NAS and the cache (freeDiameter thread).
+ \param nb_vectors 0 if the AIA reports an error
+ \param auth_info Filled with the vectors of NAS
+ @returns false if nobody waits for the answer (prefetch)
+ **/
+bool s6a_auth_vector_cache_store (const char * const imsi, const eutran_vector_t * const vectors, const int nb_vectors,
+    authentication_info_t * const auth_info);
+
+/** \brief Drop the vectors of an IMSI (Cancel Location). **/
+void s6a_auth_vector_cache_invalidate (const char * const imsi);
+
+/** \brief Drop all vectors (Reset). **/
+void s6a_auth_vector_cache_flush (void);
+
+#endif /* FILE_S6A_AUTH_VECTOR_CACHE_SEEN */
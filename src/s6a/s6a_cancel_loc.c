@@ -30,6 +30,7 @@
 #include "intertask_interface.h"
 #include "s6a_defs.h"
 #include "s6a_messages.h"
+#include "s6a_auth_vector_cache.h"
 #include "msc.h"
 #include "log.h"
 
@@ -92,6 +93,8 @@ s6a_clr_cb (
       memcpy (s6a_cancel_location_req_p->imsi, hdr_p->avp_value->os.data, hdr_p->avp_value->os.len);
       s6a_cancel_location_req_p->imsi[hdr_p->avp_value->os.len] = '\0';
       s6a_cancel_location_req_p->imsi_length = hdr_p->avp_value->os.len;
+      // the UE registered elsewhere, the SQN of the cached vectors may be stale
+      s6a_auth_vector_cache_invalidate (s6a_cancel_location_req_p->imsi);
       OAILOG_DEBUG (LOG_S6A, "Received s6a ula for imsi=%*s\n", (int)hdr_p->avp_value->os.len, hdr_p->avp_value->os.data);
     }
   } else {
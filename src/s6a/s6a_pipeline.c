@@ -0,0 +1,531 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s6a_pipeline.c
+  \brief S6a request pipeline.
+  \date 2018
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "log.h"
+#include "assertions.h"
+#include "common_types.h"
+#include "common_defs.h"
+#include "intertask_interface.h"
+#include "timer.h"
+#include "s6a_defs.h"
+#include "s6a_auth_vector_cache.h"
+#include "s6a_pipeline.h"
+
+#define S6A_PIPELINE_NONE   (-1)
+
+typedef struct s6a_request_s {
+  uint32_t             eteid;
+  s6a_request_type_t   type;
+  mme_ue_s1ap_id_t     ue_id;
+  char                 imsi[IMSI_BCD_DIGITS_MAX + 1];
+  uint64_t             deadline_tick;
+  int32_t              wheel_prev;
+  int32_t              wheel_next;
+} s6a_request_t;
+
+typedef struct s6a_backlog_request_s {
+  struct msg          *msg;
+  s6a_request_type_t   type;
+  mme_ue_s1ap_id_t     ue_id;
+  char                 imsi[IMSI_BCD_DIGITS_MAX + 1];
+} s6a_backlog_request_t;
+
+typedef struct s6a_itti_batch_s {
+  pthread_mutex_t      lock;
+  int                  nb_messages;
+  MessageDef          *messages[S6A_PIPELINE_BATCH_MAX];
+} s6a_itti_batch_t;
+
+typedef struct s6a_pipeline_s {
+  pthread_mutex_t      lock;
+
+  // correlation table: request slots, open addressing index End-to-End id -> slot
+  s6a_request_t       *requests;
+  int32_t             *free_requests;
+  uint32_t             nb_free_requests;
+  int32_t             *index;
+  uint32_t             index_mask;
+  uint32_t             max_in_flight;
+  uint32_t             in_flight;
+
+  // requests waiting for room in the window
+  s6a_backlog_request_t *backlog;
+  uint32_t             backlog_size;
+  uint32_t             backlog_head;
+  uint32_t             backlog_count;
+
+  // timer wheel
+  int32_t             *wheel;
+  uint32_t             wheel_mask;
+  uint64_t             timeout_ticks;
+  uint64_t             last_tick;
+  long                 timer_id;
+  s6a_request_t       *expired;            ///< requests expired during a tick, copied out of the table
+
+  s6a_itti_batch_t     batch[TASK_MAX];
+
+  uint64_t             sent;
+  uint64_t             answered;
+  uint64_t             timed_out;
+  uint64_t             rejected;
+  uint64_t             backlogged;
+} s6a_pipeline_t;
+
+static s6a_pipeline_t            g_s6a_pipeline = {.lock = PTHREAD_MUTEX_INITIALIZER, .requests = NULL};
+
+//------------------------------------------------------------------------------
+static inline uint64_t s6a_pipeline_now_tick (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (((uint64_t)ts.tv_sec) * 1000 + ts.tv_nsec / 1000000) / S6A_PIPELINE_TICK_MS;
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t s6a_pipeline_pow2 (uint32_t v)
+{
+  uint32_t p = 1;
+
+  while (p < v) {
+    p <<= 1;
+  }
+  return p;
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t s6a_pipeline_hash (const uint32_t eteid)
+{
+  return (eteid * 2654435761u) & g_s6a_pipeline.index_mask;
+}
+
+//------------------------------------------------------------------------------
+static int32_t s6a_pipeline_index_find (const uint32_t eteid, uint32_t * const position)
+{
+  uint32_t pos = s6a_pipeline_hash (eteid);
+
+  while (S6A_PIPELINE_NONE != g_s6a_pipeline.index[pos]) {
+    if (g_s6a_pipeline.requests[g_s6a_pipeline.index[pos]].eteid == eteid) {
+      *position = pos;
+      return g_s6a_pipeline.index[pos];
+    }
+    pos = (pos + 1) & g_s6a_pipeline.index_mask;
+  }
+  return S6A_PIPELINE_NONE;
+}
+
+//------------------------------------------------------------------------------
+static void s6a_pipeline_index_remove (uint32_t pos)
+{
+  uint32_t next = pos;
+
+  // backward shift deletion, no tombstones
+  g_s6a_pipeline.index[pos] = S6A_PIPELINE_NONE;
+  for (;;) {
+    next = (next + 1) & g_s6a_pipeline.index_mask;
+    if (S6A_PIPELINE_NONE == g_s6a_pipeline.index[next]) {
+      return;
+    }
+    const uint32_t home = s6a_pipeline_hash (g_s6a_pipeline.requests[g_s6a_pipeline.index[next]].eteid);
+
+    if (((next - home) & g_s6a_pipeline.index_mask) >= ((next - pos) & g_s6a_pipeline.index_mask)) {
+      g_s6a_pipeline.index[pos]  = g_s6a_pipeline.index[next];
+      g_s6a_pipeline.index[next] = S6A_PIPELINE_NONE;
+      pos = next;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void s6a_pipeline_wheel_unlink (const int32_t slot)
+{
+  s6a_request_t * const request = &g_s6a_pipeline.requests[slot];
+
+  if (S6A_PIPELINE_NONE != request->wheel_prev) {
+    g_s6a_pipeline.requests[request->wheel_prev].wheel_next = request->wheel_next;
+  } else {
+    g_s6a_pipeline.wheel[request->deadline_tick & g_s6a_pipeline.wheel_mask] = request->wheel_next;
+  }
+  if (S6A_PIPELINE_NONE != request->wheel_next) {
+    g_s6a_pipeline.requests[request->wheel_next].wheel_prev = request->wheel_prev;
+  }
+}
+
+//------------------------------------------------------------------------------
+// lock held, the window has room
+static void s6a_pipeline_track (const uint32_t eteid, const s6a_request_type_t type, const char * const imsi, const mme_ue_s1ap_id_t ue_id)
+{
+  const int32_t   slot = g_s6a_pipeline.free_requests[--g_s6a_pipeline.nb_free_requests];
+  s6a_request_t * request = &g_s6a_pipeline.requests[slot];
+  uint32_t        pos = s6a_pipeline_hash (eteid);
+  int32_t       * head = NULL;
+
+  request->eteid = eteid;
+  request->type  = type;
+  request->ue_id = ue_id;
+  strncpy (request->imsi, imsi, IMSI_BCD_DIGITS_MAX);
+  request->imsi[IMSI_BCD_DIGITS_MAX] = '\0';
+
+  while (S6A_PIPELINE_NONE != g_s6a_pipeline.index[pos]) {
+    pos = (pos + 1) & g_s6a_pipeline.index_mask;
+  }
+  g_s6a_pipeline.index[pos] = slot;
+
+  request->deadline_tick = s6a_pipeline_now_tick () + g_s6a_pipeline.timeout_ticks;
+  head = &g_s6a_pipeline.wheel[request->deadline_tick & g_s6a_pipeline.wheel_mask];
+  request->wheel_prev = S6A_PIPELINE_NONE;
+  request->wheel_next = *head;
+  if (S6A_PIPELINE_NONE != *head) {
+    g_s6a_pipeline.requests[*head].wheel_prev = slot;
+  }
+  *head = slot;
+  g_s6a_pipeline.in_flight++;
+  itti_transaction_set (TASK_S6A, g_s6a_pipeline.in_flight);
+}
+
+//------------------------------------------------------------------------------
+// lock held
+static void s6a_pipeline_untrack (const int32_t slot, const uint32_t pos)
+{
+  s6a_pipeline_wheel_unlink (slot);
+  s6a_pipeline_index_remove (pos);
+  g_s6a_pipeline.free_requests[g_s6a_pipeline.nb_free_requests++] = slot;
+  g_s6a_pipeline.in_flight--;
+  itti_transaction_set (TASK_S6A, g_s6a_pipeline.in_flight);
+}
+
+//------------------------------------------------------------------------------
+static void s6a_pipeline_flush (const task_id_t task_id)
+{
+  s6a_itti_batch_t * const batch = &g_s6a_pipeline.batch[task_id];
+  MessageDef             * messages[S6A_PIPELINE_BATCH_MAX];
+  int                      nb_messages = 0;
+
+  pthread_mutex_lock (&batch->lock);
+  nb_messages = batch->nb_messages;
+  memcpy (messages, batch->messages, nb_messages * sizeof (messages[0]));
+  batch->nb_messages = 0;
+  pthread_mutex_unlock (&batch->lock);
+  if (nb_messages) {
+    itti_send_msg_to_task_batch (task_id, INSTANCE_DEFAULT, messages, nb_messages);
+  }
+}
+
+//------------------------------------------------------------------------------
+void s6a_pipeline_post (const task_id_t task_id, MessageDef * const message_p)
+{
+  s6a_itti_batch_t * const batch = &g_s6a_pipeline.batch[task_id];
+  bool                     flush = false;
+
+  pthread_mutex_lock (&batch->lock);
+  batch->messages[batch->nb_messages++] = message_p;
+  // wait for other answers only if enough are expected to fill the batch soon, else do not delay this one
+  flush = (batch->nb_messages >= S6A_PIPELINE_BATCH_MAX) ||
+          (__atomic_load_n (&g_s6a_pipeline.in_flight, __ATOMIC_RELAXED) < S6A_PIPELINE_BATCH_MAX);
+  pthread_mutex_unlock (&batch->lock);
+  if (flush) {
+    s6a_pipeline_flush (task_id);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void s6a_pipeline_fail (const s6a_request_type_t type, const char * const imsi, const mme_ue_s1ap_id_t ue_id, const uint32_t result_code)
+{
+  MessageDef                             *message_p = NULL;
+
+  if (S6A_REQUEST_AIR == type) {
+    s6a_auth_info_ans_t                  *aia_p = NULL;
+
+    message_p = itti_alloc_new_message (TASK_S6A, S6A_AUTH_INFO_ANS);
+    aia_p = &message_p->ittiMsg.s6a_auth_info_ans;
+    strncpy (aia_p->imsi, imsi, IMSI_BCD_DIGITS_MAX);
+    aia_p->imsi_length = strlen (aia_p->imsi);
+    aia_p->result.present = S6A_RESULT_BASE;
+    aia_p->result.choice.base = result_code;
+    if (!s6a_auth_vector_cache_store (aia_p->imsi, NULL, 0, &aia_p->auth_info)) {
+      // failed prefetch
+      itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
+      return;
+    }
+    s6a_pipeline_post (TASK_NAS_EMM, message_p);
+  } else {
+    s6a_update_location_ans_t            *ula_p = NULL;
+
+    message_p = itti_alloc_new_message (TASK_S6A, S6A_UPDATE_LOCATION_ANS);
+    ula_p = &message_p->ittiMsg.s6a_update_location_ans;
+    strncpy (ula_p->imsi, imsi, IMSI_BCD_DIGITS_MAX);
+    ula_p->imsi_length = strlen (ula_p->imsi);
+    ula_p->ue_id = ue_id;
+    ula_p->result.present = S6A_RESULT_BASE;
+    ula_p->result.choice.base = result_code;
+    s6a_pipeline_post (TASK_MME_APP, message_p);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void s6a_pipeline_send_tracked (struct msg ** msg, const uint32_t eteid)
+{
+  uint32_t                                pos = 0;
+  int32_t                                 slot = S6A_PIPELINE_NONE;
+  s6a_request_t                           request;
+
+  if (!fd_msg_send (msg, NULL, NULL)) {
+    return;
+  }
+  pthread_mutex_lock (&g_s6a_pipeline.lock);
+  if (S6A_PIPELINE_NONE == (slot = s6a_pipeline_index_find (eteid, &pos))) {
+    pthread_mutex_unlock (&g_s6a_pipeline.lock);
+    return;
+  }
+  request = g_s6a_pipeline.requests[slot];
+  s6a_pipeline_untrack (slot, pos);
+  g_s6a_pipeline.sent--;
+  pthread_mutex_unlock (&g_s6a_pipeline.lock);
+  OAILOG_ERROR (LOG_S6A, "Failed to send s6a %s for imsi=%s\n", (S6A_REQUEST_AIR == request.type) ? "air":"ulr", request.imsi);
+  if (S6A_REQUEST_AIR == request.type) {
+    s6a_auth_vector_cache_air_failed (request.imsi);
+  }
+  s6a_pipeline_fail (request.type, request.imsi, request.ue_id, ER_DIAMETER_UNABLE_TO_DELIVER);
+}
+
+//------------------------------------------------------------------------------
+// send the backlogged requests that fit in the window
+static void s6a_pipeline_pump (void)
+{
+  for (;;) {
+    s6a_backlog_request_t                 pending;
+    struct msg_hdr                       *hdr = NULL;
+
+    pthread_mutex_lock (&g_s6a_pipeline.lock);
+    if ((!g_s6a_pipeline.backlog_count) || (g_s6a_pipeline.in_flight >= g_s6a_pipeline.max_in_flight)) {
+      pthread_mutex_unlock (&g_s6a_pipeline.lock);
+      return;
+    }
+    pending = g_s6a_pipeline.backlog[g_s6a_pipeline.backlog_head];
+    g_s6a_pipeline.backlog_head = (g_s6a_pipeline.backlog_head + 1) % g_s6a_pipeline.backlog_size;
+    g_s6a_pipeline.backlog_count--;
+    fd_msg_hdr (pending.msg, &hdr);
+    s6a_pipeline_track (hdr->msg_eteid, pending.type, pending.imsi, pending.ue_id);
+    g_s6a_pipeline.sent++;
+    pthread_mutex_unlock (&g_s6a_pipeline.lock);
+    s6a_pipeline_send_tracked (&pending.msg, hdr->msg_eteid);
+  }
+}
+
+//------------------------------------------------------------------------------
+int s6a_pipeline_init (const mme_config_t * mme_config_p)
+{
+  const uint32_t   max_in_flight = mme_config_p->s6a_config.max_in_flight;
+  const uint64_t   timeout_ticks = (mme_config_p->s6a_config.request_timeout_ms + S6A_PIPELINE_TICK_MS - 1) / S6A_PIPELINE_TICK_MS;
+  const uint32_t   index_size = s6a_pipeline_pow2 (2 * max_in_flight);
+  const uint32_t   wheel_size = s6a_pipeline_pow2 (timeout_ticks + 1);
+
+  g_s6a_pipeline.requests      = calloc (max_in_flight, sizeof (s6a_request_t));
+  g_s6a_pipeline.expired       = calloc (max_in_flight, sizeof (s6a_request_t));
+  g_s6a_pipeline.free_requests = calloc (max_in_flight, sizeof (int32_t));
+  g_s6a_pipeline.index         = calloc (index_size, sizeof (int32_t));
+  g_s6a_pipeline.wheel         = calloc (wheel_size, sizeof (int32_t));
+  g_s6a_pipeline.backlog_size  = mme_config_p->s6a_config.backlog;
+  if (g_s6a_pipeline.backlog_size) {
+    g_s6a_pipeline.backlog     = calloc (g_s6a_pipeline.backlog_size, sizeof (s6a_backlog_request_t));
+  }
+  if ((!g_s6a_pipeline.requests) || (!g_s6a_pipeline.expired) || (!g_s6a_pipeline.free_requests) || (!g_s6a_pipeline.index) ||
+      (!g_s6a_pipeline.wheel) || ((g_s6a_pipeline.backlog_size) && (!g_s6a_pipeline.backlog))) {
+    OAILOG_ERROR (LOG_S6A, "Failed to allocate the S6a request pipeline\n");
+    return RETURNerror;
+  }
+  for (uint32_t i = 0; i < max_in_flight; i++) {
+    g_s6a_pipeline.free_requests[i] = max_in_flight - 1 - i;
+  }
+  memset (g_s6a_pipeline.index, 0xFF, index_size * sizeof (int32_t));
+  memset (g_s6a_pipeline.wheel, 0xFF, wheel_size * sizeof (int32_t));
+  g_s6a_pipeline.nb_free_requests = max_in_flight;
+  g_s6a_pipeline.max_in_flight = max_in_flight;
+  g_s6a_pipeline.index_mask    = index_size - 1;
+  g_s6a_pipeline.wheel_mask    = wheel_size - 1;
+  g_s6a_pipeline.timeout_ticks = timeout_ticks;
+  g_s6a_pipeline.last_tick     = s6a_pipeline_now_tick ();
+  for (int i = 0; i < TASK_MAX; i++) {
+    pthread_mutex_init (&g_s6a_pipeline.batch[i].lock, NULL);
+  }
+  if (timer_setup (0, S6A_PIPELINE_TICK_MS * 1000, TASK_S6A, INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &g_s6a_pipeline.timer_id) < 0) {
+    OAILOG_ERROR (LOG_S6A, "Failed to start the S6a request timer wheel\n");
+    return RETURNerror;
+  }
+  OAILOG_DEBUG (LOG_S6A, "S6a pipeline: %u requests in flight, backlog %u, timeout %"PRIu64" ticks\n", max_in_flight, g_s6a_pipeline.backlog_size, timeout_ticks);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void s6a_pipeline_exit (void)
+{
+  if (g_s6a_pipeline.timer_id) {
+    timer_remove (g_s6a_pipeline.timer_id, NULL);
+    g_s6a_pipeline.timer_id = 0;
+  }
+  pthread_mutex_lock (&g_s6a_pipeline.lock);
+  OAILOG_INFO (LOG_S6A, "S6a pipeline: %"PRIu64" sent %"PRIu64" answered %"PRIu64" timed out %"PRIu64" backlogged %"PRIu64" rejected\n",
+      g_s6a_pipeline.sent, g_s6a_pipeline.answered, g_s6a_pipeline.timed_out, g_s6a_pipeline.backlogged, g_s6a_pipeline.rejected);
+  while (g_s6a_pipeline.backlog_count) {
+    fd_msg_free (g_s6a_pipeline.backlog[g_s6a_pipeline.backlog_head].msg);
+    g_s6a_pipeline.backlog_head = (g_s6a_pipeline.backlog_head + 1) % g_s6a_pipeline.backlog_size;
+    g_s6a_pipeline.backlog_count--;
+  }
+  free_wrapper ((void **)&g_s6a_pipeline.backlog);
+  free_wrapper ((void **)&g_s6a_pipeline.requests);
+  free_wrapper ((void **)&g_s6a_pipeline.expired);
+  free_wrapper ((void **)&g_s6a_pipeline.free_requests);
+  free_wrapper ((void **)&g_s6a_pipeline.index);
+  free_wrapper ((void **)&g_s6a_pipeline.wheel);
+  g_s6a_pipeline.in_flight = 0;
+  itti_transaction_set (TASK_S6A, 0);
+  pthread_mutex_unlock (&g_s6a_pipeline.lock);
+}
+
+//------------------------------------------------------------------------------
+int s6a_pipeline_send (struct msg ** msg, const s6a_request_type_t type, const char * const imsi, const mme_ue_s1ap_id_t ue_id)
+{
+  struct msg_hdr                         *hdr = NULL;
+
+  CHECK_FCT (fd_msg_hdr (*msg, &hdr));
+  pthread_mutex_lock (&g_s6a_pipeline.lock);
+  if ((g_s6a_pipeline.in_flight < g_s6a_pipeline.max_in_flight) && (!g_s6a_pipeline.backlog_count)) {
+    // tracked before sending, the answer may be received before fd_msg_send returns
+    s6a_pipeline_track (hdr->msg_eteid, type, imsi, ue_id);
+    g_s6a_pipeline.sent++;
+    pthread_mutex_unlock (&g_s6a_pipeline.lock);
+    s6a_pipeline_send_tracked (msg, hdr->msg_eteid);
+    return RETURNok;
+  }
+  if (g_s6a_pipeline.backlog_count < g_s6a_pipeline.backlog_size) {
+    s6a_backlog_request_t * const pending = &g_s6a_pipeline.backlog[(g_s6a_pipeline.backlog_head + g_s6a_pipeline.backlog_count) % g_s6a_pipeline.backlog_size];
+
+    pending->msg   = *msg;
+    pending->type  = type;
+    pending->ue_id = ue_id;
+    strncpy (pending->imsi, imsi, IMSI_BCD_DIGITS_MAX);
+    pending->imsi[IMSI_BCD_DIGITS_MAX] = '\0';
+    g_s6a_pipeline.backlog_count++;
+    g_s6a_pipeline.backlogged++;
+    *msg = NULL;
+    pthread_mutex_unlock (&g_s6a_pipeline.lock);
+    return RETURNok;
+  }
+  g_s6a_pipeline.rejected++;
+  pthread_mutex_unlock (&g_s6a_pipeline.lock);
+  OAILOG_WARNING (LOG_S6A, "S6a pipeline full, rejecting %s for imsi=%s\n", (S6A_REQUEST_AIR == type) ? "air":"ulr", imsi);
+  fd_msg_free (*msg);
+  *msg = NULL;
+  if (S6A_REQUEST_AIR == type) {
+    s6a_auth_vector_cache_air_failed (imsi);
+  }
+  s6a_pipeline_fail (type, imsi, ue_id, ER_DIAMETER_TOO_BUSY);
+  return RETURNerror;
+}
+
+//------------------------------------------------------------------------------
+bool s6a_pipeline_answer_received (struct msg * const ans)
+{
+  struct msg_hdr                         *hdr = NULL;
+  uint32_t                                pos = 0;
+  int32_t                                 slot = S6A_PIPELINE_NONE;
+
+  if (fd_msg_hdr (ans, &hdr)) {
+    return false;
+  }
+  pthread_mutex_lock (&g_s6a_pipeline.lock);
+  if (S6A_PIPELINE_NONE == (slot = s6a_pipeline_index_find (hdr->msg_eteid, &pos))) {
+    pthread_mutex_unlock (&g_s6a_pipeline.lock);
+    OAILOG_WARNING (LOG_S6A, "Dropping s6a answer for unknown or timed out request (End-to-End id 0x%08x)\n", hdr->msg_eteid);
+    return false;
+  }
+  s6a_pipeline_untrack (slot, pos);
+  g_s6a_pipeline.answered++;
+  pthread_mutex_unlock (&g_s6a_pipeline.lock);
+  s6a_pipeline_pump ();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool s6a_pipeline_handle_timer_expiry (const long timer_id)
+{
+  const uint64_t                          now_tick = s6a_pipeline_now_tick ();
+  int                                     nb_expired = 0;
+
+  if ((!g_s6a_pipeline.timer_id) || (timer_id != g_s6a_pipeline.timer_id)) {
+    return false;
+  }
+  pthread_mutex_lock (&g_s6a_pipeline.lock);
+  // visit each bucket at most once even if the S6A task was late
+  uint64_t tick = g_s6a_pipeline.last_tick + 1;
+  if ((now_tick - g_s6a_pipeline.last_tick) > (g_s6a_pipeline.wheel_mask + 1)) {
+    tick = now_tick - g_s6a_pipeline.wheel_mask;
+  }
+  for (; tick <= now_tick; tick++) {
+    int32_t slot = g_s6a_pipeline.wheel[tick & g_s6a_pipeline.wheel_mask];
+
+    while (S6A_PIPELINE_NONE != slot) {
+      s6a_request_t * const request = &g_s6a_pipeline.requests[slot];
+      const int32_t         next = request->wheel_next;
+      uint32_t              pos = 0;
+
+      if (request->deadline_tick <= now_tick) {
+        g_s6a_pipeline.expired[nb_expired++] = *request;
+        s6a_pipeline_index_find (request->eteid, &pos);
+        s6a_pipeline_untrack (slot, pos);
+      }
+      slot = next;
+    }
+  }
+  g_s6a_pipeline.last_tick = now_tick;
+  g_s6a_pipeline.timed_out += nb_expired;
+  pthread_mutex_unlock (&g_s6a_pipeline.lock);
+
+  for (int i = 0; i < nb_expired; i++) {
+    s6a_request_t * const request = &g_s6a_pipeline.expired[i];
+
+    OAILOG_WARNING (LOG_S6A, "s6a %s timed out for imsi=%s\n", (S6A_REQUEST_AIR == request->type) ? "air":"ulr", request->imsi);
+    s6a_pipeline_fail (request->type, request->imsi, request->ue_id, ER_DIAMETER_UNABLE_TO_DELIVER);
+  }
+  if (nb_expired) {
+    s6a_pipeline_pump ();
+  }
+  s6a_pipeline_flush (TASK_NAS_EMM);
+  s6a_pipeline_flush (TASK_MME_APP);
+  return true;
+}
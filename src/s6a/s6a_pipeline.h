@@ -0,0 +1,76 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s6a_pipeline.h
+  \brief S6a request pipeline.
+  \ AIRs and ULRs are tracked in a preallocated correlation table keyed by the Diameter End-to-End identifier (the
+  \ Hop-by-Hop identifier is only assigned by freeDiameter when the request is routed to a peer and is rewritten by
+  \ agents). At most MAX_IN_FLIGHT requests are sent to the HSS, further ones wait in a bounded backlog and are sent as
+  \ answers come back. Timeouts are driven by a timer wheel ticked by the S6A task, answers are handled entirely in
+  \ the freeDiameter threads and the resulting ITTI messages are posted to NAS/MME_APP in batches.
+  \date 2018
+*/
+
+#ifndef FILE_S6A_PIPELINE_SEEN
+#define FILE_S6A_PIPELINE_SEEN
+
+#include <stdbool.h>
+
+struct mme_config_s;
+struct msg;
+
+/* Period of the timer wheel, pending ITTI batches are also flushed at this period */
+#define S6A_PIPELINE_TICK_MS          10
+/* Maximum number of ITTI messages posted at once to a task */
+#define S6A_PIPELINE_BATCH_MAX        32
+
+typedef enum s6a_request_type_e {
+  S6A_REQUEST_AIR = 0,
+  S6A_REQUEST_ULR,
+  S6A_REQUEST_MAX
+} s6a_request_type_t;
+
+int  s6a_pipeline_init (const struct mme_config_s * mme_config_p);
+void s6a_pipeline_exit (void);
+
+/** \brief Send a request created with MSGFL_ALLOC_ETEID, or queue it if the in-flight window is full.
+ \param msg Request, owned by the pipeline after the call
+ \param type Type of the request, determines the failure answer if it can not be sent or times out
+ \param imsi IMSI of the request
+ \param ue_id UE the request is for (ULR), INVALID_MME_UE_S1AP_ID if unknown
+ @returns RETURNerror if the request was rejected, a failure answer has then been posted
+ **/
+int  s6a_pipeline_send (struct msg ** msg, const s6a_request_type_t type, const char * const imsi, const mme_ue_s1ap_id_t ue_id);
+
+/** \brief Match an answer with its request, the request leaves the window.
+ @returns false if the request is unknown (timed out), the answer has to be dropped
+ **/
+bool s6a_pipeline_answer_received (struct msg * const ans);
+
+/** \brief Post an ITTI message built from an answer (freeDiameter threads). **/
+void s6a_pipeline_post (const task_id_t task_id, MessageDef * const message_p);
+
+/** \brief Timer wheel tick, S6A task only.
+ @returns false if the timer is not the pipeline timer
+ **/
+bool s6a_pipeline_handle_timer_expiry (const long timer_id);
+
+#endif /* FILE_S6A_PIPELINE_SEEN */
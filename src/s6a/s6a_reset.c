@@ -30,6 +30,7 @@
 #include "intertask_interface.h"
 #include "s6a_defs.h"
 #include "s6a_messages.h"
+#include "s6a_auth_vector_cache.h"
 #include "msc.h"
 #include "log.h"
 
@@ -97,6 +98,9 @@ s6a_rr_cb (
  CHECK_FCT (s6a_add_result_code_mme (ans, failed_avp, result_code, experimental));
  CHECK_FCT (fd_msg_send (msg, NULL, NULL));
 
+ /** The HSS restarted, SQNs may have been lost. */
+ s6a_auth_vector_cache_flush ();
+
  /** Just informing the MME_APP. */
  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
  OAILOG_DEBUG (LOG_S6A, "Sending S6A_REQUEST_REQUEST to task MME_APP\n");
@@ -35,6 +35,8 @@
 #include "intertask_interface.h"
 #include "s6a_defs.h"
 #include "s6a_messages.h"
+#include "s6a_auth_vector_cache.h"
+#include "s6a_pipeline.h"
 #include "common_defs.h"
 
 #include "common_types.h"
@@ -57,6 +59,7 @@ static void                             fd_gnutls_debug (
   int level,
   const char *str);
 static void s6a_exit(void);
+static void s6a_handle_auth_info_req (s6a_auth_info_req_t * const air_p);
 
 
 //------------------------------------------------------------------------------
@@ -113,7 +116,13 @@ void *s6a_thread (void *args)
       }
       break;
     case S6A_AUTH_INFO_REQ:{
-        s6a_generate_authentication_info_req (&received_message_p->ittiMsg.s6a_auth_info_req);
+        s6a_handle_auth_info_req (&received_message_p->ittiMsg.s6a_auth_info_req);
+      }
+      break;
+    case S6A_AUTH_INFO_PREFETCH_REQ:{
+        if (s6a_auth_vector_cache_prefetch (&received_message_p->ittiMsg.s6a_auth_info_prefetch_req)) {
+          s6a_generate_authentication_info_req (&received_message_p->ittiMsg.s6a_auth_info_prefetch_req);
+        }
       }
       break;
     case S6A_NOTIFY_REQ:{
@@ -121,6 +130,9 @@ void *s6a_thread (void *args)
       }
       break;
     case TIMER_HAS_EXPIRED:{
+        if (s6a_pipeline_handle_timer_expiry (received_message_p->ittiMsg.timer_has_expired.timer_id)) {
+          break;
+        }
         /*
          * Trying to connect to peers
          */
@@ -157,6 +169,34 @@ void *s6a_thread (void *args)
   return NULL;
 }
 
+//------------------------------------------------------------------------------
+static void s6a_handle_auth_info_req (s6a_auth_info_req_t * const air_p)
+{
+  MessageDef                             *message_p = NULL;
+  s6a_auth_info_ans_t                    *aia_p = NULL;
+  authentication_info_t                   auth_info = {0};
+
+  switch (s6a_auth_vector_cache_lookup (air_p, &auth_info)) {
+  case S6A_AUTH_VECTOR_CACHE_HIT:
+    message_p = itti_alloc_new_message (TASK_S6A, S6A_AUTH_INFO_ANS);
+    aia_p = &message_p->ittiMsg.s6a_auth_info_ans;
+    memcpy (aia_p->imsi, air_p->imsi, sizeof (aia_p->imsi));
+    aia_p->imsi_length = air_p->imsi_length;
+    aia_p->result.present = S6A_RESULT_BASE;
+    aia_p->result.choice.base = DIAMETER_SUCCESS;
+    aia_p->auth_info = auth_info;
+    MSC_LOG_TX_MESSAGE (MSC_S6A_MME, MSC_NAS_MME, NULL, 0, "0 S6A_AUTH_INFO_ANS imsi %s from vector cache", aia_p->imsi);
+    itti_send_msg_to_task (TASK_NAS_EMM, INSTANCE_DEFAULT, message_p);
+    break;
+
+  case S6A_AUTH_VECTOR_CACHE_PENDING:
+    break;
+
+  default:
+    s6a_generate_authentication_info_req (air_p);
+  }
+}
+
 //------------------------------------------------------------------------------
 int s6a_init (
   const mme_config_t * mme_config_p)
@@ -250,10 +290,18 @@ int s6a_init (
     OAILOG_DEBUG (LOG_S6A, "s6a_fd_init_dict_objs done\n");
   }
 
+  if (s6a_auth_vector_cache_init (mme_config_p) != RETURNok) {
+    return RETURNerror;
+  }
+
   if (itti_create_task (TASK_S6A, &s6a_thread, NULL) < 0) {
     OAILOG_ERROR (LOG_S6A, "s6a create task\n");
     return RETURNerror;
   }
+  // the timer wheel is ticked by the S6A task
+  if (s6a_pipeline_init (mme_config_p) != RETURNok) {
+    return RETURNerror;
+  }
   OAILOG_DEBUG (LOG_S6A, "Initializing S6a interface: DONE\n");
 
   /* Add timer here to send message to connect to peer */
@@ -269,6 +317,7 @@ static void s6a_exit(void)
   if (timer_id) {
     timer_remove(timer_id, NULL);
   }
+  s6a_auth_vector_cache_exit ();
   // Release all resources
   free_wrapper((void **) &fd_g_config->cnf_diamid);
   fd_g_config->cnf_diamid_len = 0;
@@ -284,4 +333,6 @@ static void s6a_exit(void)
   if (rv) {
     OAI_FPRINTF_ERR ("An error occurred during fd_core_wait_shutdown_complete().\n");
   }
+  // no more answer callbacks
+  s6a_pipeline_exit ();
 }
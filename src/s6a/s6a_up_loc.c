@@ -30,6 +30,7 @@
 #include "common_defs.h"
 #include "s6a_defs.h"
 #include "s6a_messages.h"
+#include "s6a_pipeline.h"
 #include "msc.h"
 #include "log.h"
 
@@ -51,6 +52,11 @@ s6a_ula_cb (
 
   DevAssert (msg_pP );
   ans_p = *msg_pP;
+  if (!s6a_pipeline_answer_received (ans_p)) {
+    fd_msg_free (*msg_pP);
+    *msg_pP = NULL;
+    return RETURNok;
+  }
   /*
    * Retrieve the original query associated with the asnwer
    */
@@ -165,7 +171,7 @@ s6a_ula_cb (
 
 err:
   ans_p = NULL;
-  itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
+  s6a_pipeline_post (TASK_MME_APP, message_p);
   OAILOG_DEBUG (LOG_S6A, "Sending S6A_UPDATE_LOCATION_ANS to task MME_APP\n");
   return RETURNok;
 }
@@ -183,7 +189,7 @@ s6a_generate_update_location (
   /*
    * Create the new update location request message
    */
-  CHECK_FCT (fd_msg_new (s6a_fd_cnf.dataobj_s6a_ulr, 0, &msg_p));
+  CHECK_FCT (fd_msg_new (s6a_fd_cnf.dataobj_s6a_ulr, MSGFL_ALLOC_ETEID, &msg_p));
   /*
    * Create a new session
    */
@@ -299,7 +305,6 @@ s6a_generate_update_location (
   struct avp                             *avp1_p = NULL;
   CHECK_FCT (fd_msg_search_avp (msg_p, s6a_fd_cnf.dataobj_s6a_ulr_flags, &avp1_p));
 
-  CHECK_FCT (fd_msg_send (&msg_p, NULL, NULL));
   OAILOG_DEBUG (LOG_S6A, "Sending s6a ulr for imsi=%s\n", ulr_pP->imsi);
-  return RETURNok;
+  return s6a_pipeline_send (&msg_p, S6A_REQUEST_ULR, ulr_pP->imsi, ulr_pP->ue_id);
 }
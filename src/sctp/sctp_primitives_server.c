@@ -51,6 +51,7 @@
 #include "itti_free_defined_msg.h"
 #include "sctp_primitives_server.h"
 #include "conversions.h"
+#include "shared_buffer.h"
 #include "sctp_common.h"
 #include "sctp_itti_messaging.h"
 
@@ -252,14 +253,15 @@ static void sctp_dump_list (void)
 }
 
 //------------------------------------------------------------------------------
-static int sctp_send_msg (
+static int sctp_send_buffer (
     sctp_assoc_id_t sctp_assoc_id,
     uint16_t stream,
-    STOLEN_REF bstring *payload)
+    const uint8_t * const buffer,
+    const int length)
 {
   struct sctp_association_s              *assoc_desc = NULL;
 
-  DevAssert (*payload);
+  DevAssert (buffer);
 
   if ((assoc_desc = sctp_is_assoc_in_list (sctp_assoc_id)) == NULL) {
     OAILOG_DEBUG (LOG_SCTP, "This assoc id has not been fount in list (%d)\n", sctp_assoc_id);
@@ -275,23 +277,49 @@ static int sctp_send_msg (
   }
 
   OAILOG_DEBUG (LOG_SCTP, "[%d][%d] Sending buffer %p of %d bytes on stream %d with ppid %d\n",
-      assoc_desc->sd, sctp_assoc_id, bdata(*payload), blength(*payload), stream, assoc_desc->ppid);
+      assoc_desc->sd, sctp_assoc_id, buffer, length, stream, assoc_desc->ppid);
 
   /*
    * Send message_p on specified stream of the sd association
    */
-  if (sctp_sendmsg (assoc_desc->sd, (const void *)bdata(*payload), blength(*payload), NULL, 0, htonl(assoc_desc->ppid), 0, stream, 0, 0) < 0) {
-    bdestroy_wrapper(payload);
+  if (sctp_sendmsg (assoc_desc->sd, (const void *)buffer, length, NULL, 0, htonl(assoc_desc->ppid), 0, stream, 0, 0) < 0) {
     OAILOG_ERROR (LOG_SCTP, "send: %s:%d", strerror (errno), errno);
     return -1;
   }
-  OAILOG_DEBUG (LOG_SCTP, "Successfully sent %d bytes on stream %d\n", blength(*payload), stream);
-  bdestroy_wrapper(payload);
+  OAILOG_DEBUG (LOG_SCTP, "Successfully sent %d bytes on stream %d\n", length, stream);
 
   assoc_desc->messages_sent++;
   return 0;
 }
 
+//------------------------------------------------------------------------------
+static int sctp_send_msg (
+    sctp_assoc_id_t sctp_assoc_id,
+    uint16_t stream,
+    STOLEN_REF bstring *payload)
+{
+  int                                     rc = 0;
+
+  DevAssert (*payload);
+  rc = sctp_send_buffer (sctp_assoc_id, stream, (const uint8_t *)bdata(*payload), blength(*payload));
+  bdestroy_wrapper(payload);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static int sctp_send_shared_msg (
+    sctp_assoc_id_t sctp_assoc_id,
+    uint16_t stream,
+    STOLEN_REF shared_buffer_t **payload)
+{
+  int                                     rc = 0;
+
+  DevAssert (*payload);
+  rc = sctp_send_buffer (sctp_assoc_id, stream, (*payload)->data, (*payload)->length);
+  shared_buffer_unref (payload);
+  return rc;
+}
+
 //------------------------------------------------------------------------------
 static int sctp_create_new_listener (SctpInit * init_p)
 {
@@ -649,9 +677,18 @@ static void * sctp_intertask_interface (void *args_p)
       break;
 
     case SCTP_DATA_REQ:{
-        if (sctp_send_msg (SCTP_DATA_REQ (received_message_p).assoc_id,
-            SCTP_DATA_REQ (received_message_p).stream,
-            &SCTP_DATA_REQ (received_message_p).payload) < 0) {
+        int rc = 0;
+
+        if (SCTP_DATA_REQ (received_message_p).shared_payload) {
+          rc = sctp_send_shared_msg (SCTP_DATA_REQ (received_message_p).assoc_id,
+              SCTP_DATA_REQ (received_message_p).stream,
+              &SCTP_DATA_REQ (received_message_p).shared_payload);
+        } else {
+          rc = sctp_send_msg (SCTP_DATA_REQ (received_message_p).assoc_id,
+              SCTP_DATA_REQ (received_message_p).stream,
+              &SCTP_DATA_REQ (received_message_p).payload);
+        }
+        if (rc < 0) {
 
           sctp_itti_send_lower_layer_conf(received_message_p->ittiMsgHeader.originTaskId,
               SCTP_DATA_REQ (received_message_p).assoc_id,
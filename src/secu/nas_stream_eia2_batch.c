@@ -0,0 +1,261 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file nas_stream_eia2_batch.c
+   \brief EIA2 with cached key schedule, several messages per pass.
+   \date 2018
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <wmmintrin.h>
+#  define NAS_STREAM_EIA2_AESNI 1
+#endif
+
+#include "secu_defs.h"
+#include "assertions.h"
+
+//------------------------------------------------------------------------------
+static bool _eia2_cpu_has_aesni (void)
+{
+#if NAS_STREAM_EIA2_AESNI
+  static int                              has_aesni = -1;
+
+  if (0 > has_aesni) {
+    __builtin_cpu_init ();
+    has_aesni = __builtin_cpu_supports ("aes") ? 1 : 0;
+  }
+  return (1 == has_aesni);
+#else
+  return false;
+#endif
+}
+
+#if NAS_STREAM_EIA2_AESNI
+//------------------------------------------------------------------------------
+__attribute__ ((target ("aes,sse2")))
+static inline __m128i _eia2_aesni_key_expand (__m128i key, __m128i assist)
+{
+  assist = _mm_shuffle_epi32 (assist, 0xff);
+  key = _mm_xor_si128 (key, _mm_slli_si128 (key, 4));
+  key = _mm_xor_si128 (key, _mm_slli_si128 (key, 4));
+  key = _mm_xor_si128 (key, _mm_slli_si128 (key, 4));
+  return _mm_xor_si128 (key, assist);
+}
+
+//------------------------------------------------------------------------------
+__attribute__ ((target ("aes,sse2")))
+static void _eia2_aesni_key_schedule (nas_eia2_key_schedule_t * const schedule)
+{
+  __m128i                                 k = _mm_loadu_si128 ((const __m128i *)schedule->key);
+  __m128i * const                         rk = (__m128i *)schedule->round_keys;
+
+  rk[0] = k;
+  // aeskeygenassist needs an immediate round constant
+  k = _eia2_aesni_key_expand (k, _mm_aeskeygenassist_si128 (k, 0x01)); rk[1] = k;
+  k = _eia2_aesni_key_expand (k, _mm_aeskeygenassist_si128 (k, 0x02)); rk[2] = k;
+  k = _eia2_aesni_key_expand (k, _mm_aeskeygenassist_si128 (k, 0x04)); rk[3] = k;
+  k = _eia2_aesni_key_expand (k, _mm_aeskeygenassist_si128 (k, 0x08)); rk[4] = k;
+  k = _eia2_aesni_key_expand (k, _mm_aeskeygenassist_si128 (k, 0x10)); rk[5] = k;
+  k = _eia2_aesni_key_expand (k, _mm_aeskeygenassist_si128 (k, 0x20)); rk[6] = k;
+  k = _eia2_aesni_key_expand (k, _mm_aeskeygenassist_si128 (k, 0x40)); rk[7] = k;
+  k = _eia2_aesni_key_expand (k, _mm_aeskeygenassist_si128 (k, 0x80)); rk[8] = k;
+  k = _eia2_aesni_key_expand (k, _mm_aeskeygenassist_si128 (k, 0x1b)); rk[9] = k;
+  k = _eia2_aesni_key_expand (k, _mm_aeskeygenassist_si128 (k, 0x36)); rk[10] = k;
+}
+
+//------------------------------------------------------------------------------
+// Encrypt in place one block per lane, the rounds of all lanes are interleaved to hide the aesenc latency.
+__attribute__ ((target ("aes,sse2")))
+static void _eia2_aesni_encrypt_lanes (uint8_t state[][16], const nas_eia2_key_schedule_t * const * const schedules, const int num_lanes)
+{
+  __m128i                                 s[NAS_STREAM_EIA2_MAX_LANES];
+
+  for (int l = 0; l < num_lanes; l++) {
+    s[l] = _mm_xor_si128 (_mm_loadu_si128 ((const __m128i *)state[l]), _mm_load_si128 ((const __m128i *)schedules[l]->round_keys[0]));
+  }
+  for (int r = 1; r < 10; r++) {
+    for (int l = 0; l < num_lanes; l++) {
+      s[l] = _mm_aesenc_si128 (s[l], _mm_load_si128 ((const __m128i *)schedules[l]->round_keys[r]));
+    }
+  }
+  for (int l = 0; l < num_lanes; l++) {
+    _mm_storeu_si128 ((__m128i *)state[l], _mm_aesenclast_si128 (s[l], _mm_load_si128 ((const __m128i *)schedules[l]->round_keys[10])));
+  }
+}
+#endif
+
+//------------------------------------------------------------------------------
+static void _eia2_encrypt_lanes (uint8_t state[][16], const nas_eia2_key_schedule_t * const * const schedules, const int num_lanes)
+{
+  if (!num_lanes) {
+    return;
+  }
+#if NAS_STREAM_EIA2_AESNI
+  if (schedules[0]->aesni) {
+    _eia2_aesni_encrypt_lanes (state, schedules, num_lanes);
+    return;
+  }
+#endif
+  for (int l = 0; l < num_lanes; l++) {
+    AES_encrypt (state[l], state[l], &schedules[l]->aes_key);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Multiplication by x in GF(2^128) (RFC 4493 subkey generation)
+static void _eia2_cmac_shift (const uint8_t in[16], uint8_t out[16])
+{
+  const uint8_t                           msb = in[0] & 0x80;
+
+  for (int i = 0; i < 15; i++) {
+    out[i] = (in[i] << 1) | (in[i + 1] >> 7);
+  }
+  out[15] = (in[15] << 1) ^ (msb ? 0x87 : 0x00);
+}
+
+//------------------------------------------------------------------------------
+void nas_stream_eia2_key_schedule (nas_eia2_key_schedule_t * const schedule, const uint8_t * const key)
+{
+  const nas_eia2_key_schedule_t          *schedules[1] = {schedule};
+  uint8_t                                 l[1][16] = {{0}};
+
+  DevAssert (schedule != NULL);
+  DevAssert (key != NULL);
+  if ((schedule->valid) && (!memcmp (schedule->key, key, sizeof (schedule->key)))) {
+    return;
+  }
+  memcpy (schedule->key, key, sizeof (schedule->key));
+  schedule->aesni = _eia2_cpu_has_aesni ();
+#if NAS_STREAM_EIA2_AESNI
+  if (schedule->aesni) {
+    _eia2_aesni_key_schedule (schedule);
+  } else
+#endif
+  {
+    AES_set_encrypt_key (key, 128, &schedule->aes_key);
+  }
+  _eia2_encrypt_lanes (l, schedules, 1);
+  _eia2_cmac_shift (l[0], schedule->k1);
+  _eia2_cmac_shift (schedule->k1, schedule->k2);
+  schedule->valid = true;
+}
+
+//------------------------------------------------------------------------------
+// Block number b of the CMAC input COUNT | BEARER | DIRECTION | 0 (64 bits) | MESSAGE, last block padded and masked.
+static void _eia2_cmac_block (const nas_eia2_lane_t * const lane, const uint32_t b, const uint32_t num_blocks, uint8_t block[16])
+{
+  const uint32_t                          total = lane->length + 8;
+  uint32_t                                pos = b * 16;
+
+  memset (block, 0, 16);
+  for (int i = 0; (i < 16) && (pos < total); i++, pos++) {
+    if (pos < 4) {
+      block[i] = (uint8_t)(lane->count >> (24 - 8 * pos));
+    } else if (pos == 4) {
+      block[i] = ((lane->bearer & 0x1F) << 3) | ((lane->direction & 0x01) << 2);
+    } else if (pos >= 8) {
+      block[i] = lane->message[pos - 8];
+    }
+    if ((pos + 1 == total) && (i < 15)) {
+      block[i + 1] = 0x80;
+    }
+  }
+  if ((b + 1) == num_blocks) {
+    const uint8_t * const                 k = (total % 16) ? lane->schedule->k2 : lane->schedule->k1;
+
+    for (int i = 0; i < 16; i++) {
+      block[i] ^= k[i];
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void _eia2_batch (nas_eia2_lane_t * const lanes, const int num_lanes)
+{
+  uint8_t                                 x[NAS_STREAM_EIA2_MAX_LANES][16] = {{0}};
+  uint8_t                                 active_state[NAS_STREAM_EIA2_MAX_LANES][16];
+  const nas_eia2_key_schedule_t          *active_schedules[NAS_STREAM_EIA2_MAX_LANES];
+  int                                     active_lanes[NAS_STREAM_EIA2_MAX_LANES];
+  uint32_t                                num_blocks[NAS_STREAM_EIA2_MAX_LANES];
+  uint32_t                                max_blocks = 0;
+  uint8_t                                 block[16];
+
+  for (int l = 0; l < num_lanes; l++) {
+    DevAssert ((lanes[l].schedule) && (lanes[l].schedule->valid));
+    DevAssert (lanes[l].schedule->aesni == lanes[0].schedule->aesni);
+    num_blocks[l] = (lanes[l].length + 8 + 15) / 16;
+    if (num_blocks[l] > max_blocks) max_blocks = num_blocks[l];
+  }
+  for (uint32_t b = 0; b < max_blocks; b++) {
+    int                                   n = 0;
+
+    for (int l = 0; l < num_lanes; l++) {
+      if (b < num_blocks[l]) {
+        _eia2_cmac_block (&lanes[l], b, num_blocks[l], block);
+        for (int i = 0; i < 16; i++) {
+          active_state[n][i] = x[l][i] ^ block[i];
+        }
+        active_schedules[n] = lanes[l].schedule;
+        active_lanes[n++] = l;
+      }
+    }
+    _eia2_encrypt_lanes (active_state, active_schedules, n);
+    for (int i = 0; i < n; i++) {
+      memcpy (x[active_lanes[i]], active_state[i], 16);
+    }
+  }
+  for (int l = 0; l < num_lanes; l++) {
+    lanes[l].mac = ((uint32_t)x[l][0] << 24) | ((uint32_t)x[l][1] << 16) | ((uint32_t)x[l][2] << 8) | x[l][3];
+  }
+}
+
+//------------------------------------------------------------------------------
+void nas_stream_eia2_batch (nas_eia2_lane_t * const lanes, const int num_lanes)
+{
+  for (int l = 0; l < num_lanes; l += NAS_STREAM_EIA2_MAX_LANES) {
+    _eia2_batch (&lanes[l], ((num_lanes - l) < NAS_STREAM_EIA2_MAX_LANES) ? (num_lanes - l) : NAS_STREAM_EIA2_MAX_LANES);
+  }
+}
+
+//------------------------------------------------------------------------------
+int nas_ul_count_window (const uint32_t ul_count, const uint8_t sequence_number_5lsb, const bool replay_protection,
+                         const uint32_t last_verified_count, uint32_t * const candidates, const int max_candidates)
+{
+  uint32_t                                count = (ul_count & ~((uint32_t)0x1F)) | (sequence_number_5lsb & 0x1F);
+  int                                     n = 0;
+
+  if (count < ul_count) {
+    count += 0x20;
+  }
+  for (int i = 0; (i < max_candidates) && (count <= NAS_UL_COUNT_MAX); i++, count += 0x20) {
+    if ((replay_protection) && (count <= last_verified_count)) {
+      continue;
+    }
+    candidates[n++] = count;
+  }
+  return n;
+}
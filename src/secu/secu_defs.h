@@ -22,6 +22,10 @@
 #ifndef FILE_SECU_DEFS_SEEN
 #define FILE_SECU_DEFS_SEEN
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <openssl/aes.h>
+
 #include "security_types.h"
 
 
@@ -82,6 +86,51 @@ int nas_stream_encrypt_eea2(nas_stream_cipher_t * const stream_cipher, uint8_t *
 
 int nas_stream_encrypt_eia2(nas_stream_cipher_t * const stream_cipher, uint8_t const out[4]);
 
+/*
+ * EIA2 (AES-CMAC) with a cached key schedule, for byte aligned messages.
+ * The key schedule (AES round keys and CMAC subkeys) is only expanded again when the key changes,
+ * several MACs (of different UEs or of several candidate counts) are computed in one pass,
+ * the AES rounds of the lanes being interleaved (AES-NI if the CPU supports it).
+ */
+#define NAS_STREAM_EIA2_MAX_LANES 8
+
+typedef struct nas_eia2_key_schedule_s {
+  uint8_t   key[16];                  /* key the schedule has been expanded from */
+  bool      valid;
+  bool      aesni;
+  uint8_t   k1[16];                   /* CMAC subkeys */
+  uint8_t   k2[16];
+  uint8_t   round_keys[11][16] __attribute__ ((aligned (16)));
+  AES_KEY   aes_key;                  /* used if no AES-NI */
+} nas_eia2_key_schedule_t;
+
+typedef struct nas_eia2_lane_s {
+  const nas_eia2_key_schedule_t *schedule;
+  uint32_t        count;
+  uint8_t         bearer;
+  uint8_t         direction;
+  const uint8_t  *message;
+  uint32_t        length;             /* in bytes */
+  uint32_t        mac;                /* output, same value as ntohl() of nas_stream_encrypt_eia2() output */
+} nas_eia2_lane_t;
+
+void nas_stream_eia2_key_schedule(nas_eia2_key_schedule_t * const schedule, const uint8_t * const key);
+
+void nas_stream_eia2_batch(nas_eia2_lane_t * const lanes, const int num_lanes);
+
+/*
+ * Uplink NAS COUNT window for the SERVICE REQUEST (TS 24.301 9.9.3.28, only the 5 LSB of the sequence number are sent).
+ * Candidates are the NAS COUNT values having these 5 LSB, starting from the smallest one >= ul_count,
+ * so that the MAC still verifies if up to max_candidates-1 SERVICE REQUESTs of the UE have been lost.
+ * Counts <= last_verified_count (if replay_protection) are replays, counts above the 24 bits NAS COUNT range are
+ * rejected (the overflow counter never wraps, a new security context is required).
+ * Return the number of candidates, in increasing count order.
+ */
+#define NAS_UL_COUNT_MAX  0x00FFFFFF
+
+int nas_ul_count_window(const uint32_t ul_count, const uint8_t sequence_number_5lsb, const bool replay_protection,
+                        const uint32_t last_verified_count, uint32_t * const candidates, const int max_candidates);
+
 #undef SECU_DEBUG
 
 #endif /* FILE_SECU_DEFS_SEEN */
@@ -452,6 +452,16 @@ int pgw_config_parse_file (pgw_config_t * config_pP)
             }
           }
 
+          if (config_setting_lookup_string (subsetting, PGW_CONFIG_STRING_PCEF_CLASSIFIER, (const char **)&astring)) {
+            if (strcasecmp (astring, PGW_CONFIG_STRING_PCEF_CLASSIFIER_NATIVE) == 0) {
+              config_pP->pcef.native_classifier = true;
+            } else if (strcasecmp (astring, PGW_CONFIG_STRING_PCEF_CLASSIFIER_IPTABLES) == 0) {
+              config_pP->pcef.native_classifier = false;
+            } else {
+              AssertFatal(0, "Bad %s value %s", PGW_CONFIG_STRING_PCEF_CLASSIFIER, astring);
+            }
+          }
+
           libconfig_int sdf_id = 0;
           if (config_setting_lookup_int (subsetting, PGW_CONFIG_STRING_AUTOMATIC_PUSH_DEDICATED_BEARER_PCC_RULE, &sdf_id)) {
             AssertFatal((sdf_id < SDF_ID_MAX) && (sdf_id >= 0), "Bad SDF identifier value %d for dedicated bearer", sdf_id);
@@ -545,6 +555,7 @@ void pgw_config_display (pgw_config_t * config_p)
   OAILOG_INFO (LOG_SPGW_APP, "- PCEF support ...........: %s (in development)\n", config_p->pcef.enabled == 0 ? "false" : "true");
   if (config_p->pcef.enabled) {
     OAILOG_INFO (LOG_SPGW_APP, "    TCP ECN  .............: %s\n", config_p->pcef.tcp_ecn_enabled == 0 ? "false" : "true");
+    OAILOG_INFO (LOG_SPGW_APP, "    SDF classifier .......: %s\n", config_p->pcef.native_classifier ? "native" : "iptables");
     OAILOG_INFO (LOG_SPGW_APP, "    Push dedicated bearer SDF ID: %d (testing dedicated bearer functionality down to OAI UE/COSTS UE)\n",
         config_p->pcef.automatic_push_dedicated_bearer_sdf_identifier);
     OAILOG_INFO (LOG_SPGW_APP, "    Default bearer SDF ID.: %d\n",config_p->pcef.default_bearer_sdf_identifier);
@@ -74,6 +74,9 @@ extern "C" {
 #define PGW_CONFIG_STRING_PUSH_STATIC_PCC_RULES                 "PUSH_STATIC_PCC_RULES"
 #define PGW_CONFIG_STRING_APN_AMBR_UL                           "APN_AMBR_UL"
 #define PGW_CONFIG_STRING_APN_AMBR_DL                           "APN_AMBR_DL"
+#define PGW_CONFIG_STRING_PCEF_CLASSIFIER                       "PCEF_CLASSIFIER"
+#define PGW_CONFIG_STRING_PCEF_CLASSIFIER_IPTABLES              "IPTABLES"
+#define PGW_CONFIG_STRING_PCEF_CLASSIFIER_NATIVE                "NATIVE"
 #define PGW_ABORT_ON_ERROR true
 #define PGW_WARN_ON_ERROR  false
 
@@ -165,6 +168,7 @@ typedef struct pgw_config_s {
   struct {
     bool      enabled;
     bool      tcp_ecn_enabled;           // test for CoDel qdisc
+    bool      native_classifier;         // SDF filters classified in process (pgw_pcef_classifier.h) instead of iptables marking
     sdf_id_t  default_bearer_sdf_identifier;
     sdf_id_t  automatic_push_dedicated_bearer_sdf_identifier;
     sdf_id_t  preload_static_sdf_identifiers[SDF_ID_MAX-1];
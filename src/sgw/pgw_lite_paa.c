@@ -142,6 +142,22 @@ pgw_release_free_ipv4_paa_address (
   return RETURNerror;
 }
 
+int
+pgw_reserve_ipv4_paa_address (
+  const struct in_addr *const addr_pP)
+{
+  struct ipv4_list_elm_s        *ipv4_p = NULL;
+
+  STAILQ_FOREACH (ipv4_p, &pgw_app.ipv4_list_free, ipv4_entries) {
+    if (ipv4_p->addr.s_addr == addr_pP->s_addr) {
+      STAILQ_REMOVE (&pgw_app.ipv4_list_free, ipv4_p, ipv4_list_elm_s, ipv4_entries);
+      STAILQ_INSERT_TAIL (&pgw_app.ipv4_list_allocated, ipv4_p, ipv4_entries);
+      return RETURNok;
+    }
+  }
+  return RETURNerror;
+}
+
 //int get_assigned_ipv4_block(const int block, struct in_addr * const netaddr, uint32_t * const prefix)
 //{
 //  int rc = RETURNok;
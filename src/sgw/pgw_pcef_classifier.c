@@ -0,0 +1,427 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pgw_pcef_classifier.c
+  \brief In-process SDF/TFT packet classifier (tuple space search).
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "common_defs.h"
+#include "log.h"
+#include "pgw_pcef_classifier.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Key layout: ue addr, remote addr, ue port << 16 | remote port, spi, protocol << 8 | tos
+#define PCEF_KEY_WORDS            5
+#define PCEF_KEY_WORD_UE_ADDR     0
+#define PCEF_KEY_WORD_REMOTE_ADDR 1
+#define PCEF_KEY_WORD_PORTS       2
+#define PCEF_KEY_WORD_SPI         3
+#define PCEF_KEY_WORD_PROTO_TOS   4
+
+#define PCEF_RULE_NONE            (-1)
+
+typedef struct pcef_key_words_s {
+  uint32_t          w[PCEF_KEY_WORDS];
+} pcef_key_words_t;
+
+typedef struct pcef_rule_s {
+  pcef_key_words_t  value;     // already masked
+  pcef_key_words_t  mask;
+  uint16_t          ue_port_low;
+  uint16_t          ue_port_high;
+  uint16_t          remote_port_low;
+  uint16_t          remote_port_high;
+  bool              ue_port_range;
+  bool              remote_port_range;
+  uint8_t           direction;
+  uint32_t          priority;  // (evaluation precedence << 24) | insertion order, lowest first
+  uint32_t          result;
+  int32_t           next;      // next rule in the same slot, sorted by priority
+} pcef_rule_t;
+
+typedef struct pcef_slot_s {
+  pcef_key_words_t  key;
+  int32_t           first_rule;
+} pcef_slot_t;
+
+typedef struct pcef_tuple_s {
+  pcef_key_words_t  mask;
+  uint32_t          best_priority;
+  uint32_t          num_rules;
+  uint32_t          slot_mask;  // num slots - 1, num slots is a power of 2
+  pcef_slot_t      *slots;
+} pcef_tuple_t;
+
+struct pcef_classifier_s {
+  bool              compiled;
+  uint32_t          num_rules;
+  uint32_t          max_rules;
+  pcef_rule_t      *rules;
+  uint32_t          num_tuples;
+  pcef_tuple_t     *tuples;
+};
+
+//------------------------------------------------------------------------------
+static inline uint32_t pcef_hash_key (const pcef_key_words_t * const key)
+{
+  // independent multiplies, so that the per tuple hash does not serialize on the multiplier latency
+  uint64_t h = ((uint64_t)key->w[0] * 0x9E3779B97F4A7C15ULL) + ((uint64_t)key->w[1] * 0xC2B2AE3D27D4EB4FULL) +
+               ((uint64_t)key->w[2] * 0x165667B19E3779F9ULL) + ((uint64_t)key->w[3] * 0xD6E8FEB86659FD93ULL) +
+               ((uint64_t)key->w[4] * 0xFF51AFD7ED558CCDULL);
+  return (uint32_t)((h ^ (h >> 29)) >> 16);
+}
+
+//------------------------------------------------------------------------------
+static inline bool pcef_key_equal (const pcef_key_words_t * const a, const pcef_key_words_t * const b)
+{
+  return ((a->w[0] == b->w[0]) && (a->w[1] == b->w[1]) && (a->w[2] == b->w[2]) &&
+          (a->w[3] == b->w[3]) && (a->w[4] == b->w[4]));
+}
+
+//------------------------------------------------------------------------------
+static inline void pcef_key_apply_mask (const pcef_key_words_t * const key, const pcef_key_words_t * const mask, pcef_key_words_t * const masked)
+{
+  for (int i = 0; i < PCEF_KEY_WORDS; i++) {
+    masked->w[i] = key->w[i] & mask->w[i];
+  }
+}
+
+//------------------------------------------------------------------------------
+static inline void pcef_flow_key_2_key_words (const pcef_flow_key_t * const flow_key, pcef_key_words_t * const key)
+{
+  key->w[PCEF_KEY_WORD_UE_ADDR]     = flow_key->ue_ipv4.s_addr;
+  key->w[PCEF_KEY_WORD_REMOTE_ADDR] = flow_key->remote_ipv4.s_addr;
+  key->w[PCEF_KEY_WORD_PORTS]       = ((uint32_t)flow_key->ue_port << 16) | flow_key->remote_port;
+  key->w[PCEF_KEY_WORD_SPI]         = flow_key->spi;
+  key->w[PCEF_KEY_WORD_PROTO_TOS]   = ((uint32_t)flow_key->protocol << 8) | flow_key->tos;
+}
+
+//------------------------------------------------------------------------------
+pcef_classifier_t * pcef_classifier_create (const uint32_t num_rules_hint)
+{
+  pcef_classifier_t * classifier = calloc (1, sizeof (pcef_classifier_t));
+
+  classifier->max_rules = (num_rules_hint) ? num_rules_hint : 16;
+  classifier->rules = calloc (classifier->max_rules, sizeof (pcef_rule_t));
+  return classifier;
+}
+
+//------------------------------------------------------------------------------
+void pcef_classifier_destroy (pcef_classifier_t ** classifier)
+{
+  if ((classifier) && (*classifier)) {
+    for (int i = 0; i < (*classifier)->num_tuples; i++) {
+      free_wrapper ((void**)&(*classifier)->tuples[i].slots);
+    }
+    free_wrapper ((void**)&(*classifier)->tuples);
+    free_wrapper ((void**)&(*classifier)->rules);
+    free_wrapper ((void**)classifier);
+  }
+}
+
+//------------------------------------------------------------------------------
+int pcef_classifier_add_packet_filter (pcef_classifier_t * const classifier, const packet_filter_t * const packet_filter,
+                                       const struct in_addr ue_ipv4, const uint32_t result)
+{
+  const packet_filter_contents_t * const pfc = &packet_filter->packetfiltercontents;
+  pcef_rule_t                             rule = {0};
+  uint8_t                                 bytes[4];
+
+  if ((classifier->compiled) || (PCEF_CLASSIFIER_NO_MATCH == result)) {
+    return RETURNerror;
+  }
+  if ((TRAFFIC_FLOW_TEMPLATE_IPV6_REMOTE_ADDR_FLAG | TRAFFIC_FLOW_TEMPLATE_IPV6_REMOTE_ADDR_PREFIX_FLAG |
+       TRAFFIC_FLOW_TEMPLATE_IPV6_LOCAL_ADDR_PREFIX_FLAG | TRAFFIC_FLOW_TEMPLATE_FLOW_LABEL_FLAG) & pfc->flags) {
+    OAILOG_WARNING (LOG_SPGW_APP, "PCEF classifier: IPv6 packet filter components not supported (flags 0x%04X)\n", pfc->flags);
+    return RETURNerror;
+  }
+
+  if (INADDR_ANY != ue_ipv4.s_addr) {
+    rule.value.w[PCEF_KEY_WORD_UE_ADDR] = ue_ipv4.s_addr;
+    rule.mask.w[PCEF_KEY_WORD_UE_ADDR]  = 0xFFFFFFFF;
+  } else if (TRAFFIC_FLOW_TEMPLATE_IPV4_LOCAL_ADDR_FLAG & pfc->flags) {
+    for (int i = 0; i < TRAFFIC_FLOW_TEMPLATE_IPV4_ADDR_SIZE; i++) bytes[i] = pfc->ipv4localaddr[i].addr;
+    memcpy (&rule.value.w[PCEF_KEY_WORD_UE_ADDR], bytes, sizeof (bytes));
+    for (int i = 0; i < TRAFFIC_FLOW_TEMPLATE_IPV4_ADDR_SIZE; i++) bytes[i] = pfc->ipv4localaddr[i].mask;
+    memcpy (&rule.mask.w[PCEF_KEY_WORD_UE_ADDR], bytes, sizeof (bytes));
+  }
+  if (TRAFFIC_FLOW_TEMPLATE_IPV4_REMOTE_ADDR_FLAG & pfc->flags) {
+    for (int i = 0; i < TRAFFIC_FLOW_TEMPLATE_IPV4_ADDR_SIZE; i++) bytes[i] = pfc->ipv4remoteaddr[i].addr;
+    memcpy (&rule.value.w[PCEF_KEY_WORD_REMOTE_ADDR], bytes, sizeof (bytes));
+    for (int i = 0; i < TRAFFIC_FLOW_TEMPLATE_IPV4_ADDR_SIZE; i++) bytes[i] = pfc->ipv4remoteaddr[i].mask;
+    memcpy (&rule.mask.w[PCEF_KEY_WORD_REMOTE_ADDR], bytes, sizeof (bytes));
+  }
+  if (TRAFFIC_FLOW_TEMPLATE_PROTOCOL_NEXT_HEADER_FLAG & pfc->flags) {
+    rule.value.w[PCEF_KEY_WORD_PROTO_TOS] |= (uint32_t)pfc->protocolidentifier_nextheader << 8;
+    rule.mask.w[PCEF_KEY_WORD_PROTO_TOS]  |= 0xFF00;
+  }
+  if (TRAFFIC_FLOW_TEMPLATE_TYPE_OF_SERVICE_TRAFFIC_CLASS_FLAG & pfc->flags) {
+    rule.value.w[PCEF_KEY_WORD_PROTO_TOS] |= pfc->typdeofservice_trafficclass.value;
+    rule.mask.w[PCEF_KEY_WORD_PROTO_TOS]  |= pfc->typdeofservice_trafficclass.mask;
+  }
+  if (TRAFFIC_FLOW_TEMPLATE_SINGLE_LOCAL_PORT_FLAG & pfc->flags) {
+    rule.value.w[PCEF_KEY_WORD_PORTS] |= (uint32_t)pfc->singlelocalport << 16;
+    rule.mask.w[PCEF_KEY_WORD_PORTS]  |= 0xFFFF0000;
+  } else if (TRAFFIC_FLOW_TEMPLATE_LOCAL_PORT_RANGE_FLAG & pfc->flags) {
+    // ranges do not fit in a tuple mask, they are checked on candidate rules
+    rule.ue_port_range = true;
+    rule.ue_port_low   = pfc->localportrange.lowlimit;
+    rule.ue_port_high  = pfc->localportrange.highlimit;
+  }
+  if (TRAFFIC_FLOW_TEMPLATE_SINGLE_REMOTE_PORT_FLAG & pfc->flags) {
+    rule.value.w[PCEF_KEY_WORD_PORTS] |= pfc->singleremoteport;
+    rule.mask.w[PCEF_KEY_WORD_PORTS]  |= 0x0000FFFF;
+  } else if (TRAFFIC_FLOW_TEMPLATE_REMOTE_PORT_RANGE_FLAG & pfc->flags) {
+    rule.remote_port_range = true;
+    rule.remote_port_low   = pfc->remoteportrange.lowlimit;
+    rule.remote_port_high  = pfc->remoteportrange.highlimit;
+  }
+  if (TRAFFIC_FLOW_TEMPLATE_SECURITY_PARAMETER_INDEX_FLAG & pfc->flags) {
+    rule.value.w[PCEF_KEY_WORD_SPI] = pfc->securityparameterindex;
+    rule.mask.w[PCEF_KEY_WORD_SPI]  = 0xFFFFFFFF;
+  }
+  pcef_key_apply_mask (&rule.value, &rule.mask, &rule.value);
+
+  // pre Rel-7 TFT filters are downlink only filters
+  rule.direction = (TRAFFIC_FLOW_TEMPLATE_PRE_REL7_TFT_FILTER == packet_filter->direction) ?
+                     TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY : packet_filter->direction;
+  rule.priority  = ((uint32_t)packet_filter->eval_precedence << 24) | (classifier->num_rules & 0x00FFFFFF);
+  rule.result    = result;
+  rule.next      = PCEF_RULE_NONE;
+
+  if (classifier->num_rules == classifier->max_rules) {
+    pcef_rule_t * rules = realloc (classifier->rules, 2 * classifier->max_rules * sizeof (pcef_rule_t));
+    if (!rules) {
+      return RETURNerror;
+    }
+    classifier->rules      = rules;
+    classifier->max_rules *= 2;
+  }
+  classifier->rules[classifier->num_rules++] = rule;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int pcef_rule_compare_priority (const void * a, const void * b)
+{
+  const pcef_rule_t * ra = (const pcef_rule_t *)a;
+  const pcef_rule_t * rb = (const pcef_rule_t *)b;
+  return (ra->priority > rb->priority) - (ra->priority < rb->priority);
+}
+
+//------------------------------------------------------------------------------
+static int pcef_tuple_compare_priority (const void * a, const void * b)
+{
+  const pcef_tuple_t * ta = (const pcef_tuple_t *)a;
+  const pcef_tuple_t * tb = (const pcef_tuple_t *)b;
+  return (ta->best_priority > tb->best_priority) - (ta->best_priority < tb->best_priority);
+}
+
+//------------------------------------------------------------------------------
+int pcef_classifier_compile (pcef_classifier_t * const classifier)
+{
+  if (classifier->compiled) {
+    return RETURNerror;
+  }
+  qsort (classifier->rules, classifier->num_rules, sizeof (pcef_rule_t), pcef_rule_compare_priority);
+
+  // Group rules by mask, the number of distinct masks is expected to stay small
+  classifier->tuples = calloc ((classifier->num_rules) ? classifier->num_rules : 1, sizeof (pcef_tuple_t));
+  for (int r = 0; r < classifier->num_rules; r++) {
+    pcef_rule_t * rule = &classifier->rules[r];
+    int t = 0;
+    for (t = 0; t < classifier->num_tuples; t++) {
+      if (pcef_key_equal (&classifier->tuples[t].mask, &rule->mask)) break;
+    }
+    if (t == classifier->num_tuples) {
+      classifier->tuples[t].mask          = rule->mask;
+      classifier->tuples[t].best_priority = rule->priority; // rules are sorted
+      classifier->num_tuples++;
+    }
+    classifier->tuples[t].num_rules++;
+  }
+
+  for (int t = 0; t < classifier->num_tuples; t++) {
+    pcef_tuple_t * tuple = &classifier->tuples[t];
+    uint32_t num_slots = 4;
+    // load factor <= 0.5
+    while (num_slots < (2 * tuple->num_rules)) num_slots <<= 1;
+    tuple->slot_mask = num_slots - 1;
+    tuple->slots = malloc (num_slots * sizeof (pcef_slot_t));
+    for (int s = 0; s < num_slots; s++) {
+      tuple->slots[s].first_rule = PCEF_RULE_NONE;
+    }
+  }
+
+  // Insert rules in priority order, so chains are sorted by priority
+  for (int r = 0; r < classifier->num_rules; r++) {
+    pcef_rule_t  * rule = &classifier->rules[r];
+    pcef_tuple_t * tuple = NULL;
+    for (int t = 0; t < classifier->num_tuples; t++) {
+      if (pcef_key_equal (&classifier->tuples[t].mask, &rule->mask)) {
+        tuple = &classifier->tuples[t];
+        break;
+      }
+    }
+    uint32_t s = pcef_hash_key (&rule->value) & tuple->slot_mask;
+    while (PCEF_RULE_NONE != tuple->slots[s].first_rule) {
+      if (pcef_key_equal (&tuple->slots[s].key, &rule->value)) break;
+      s = (s + 1) & tuple->slot_mask;
+    }
+    if (PCEF_RULE_NONE == tuple->slots[s].first_rule) {
+      tuple->slots[s].key = rule->value;
+      tuple->slots[s].first_rule = r;
+    } else {
+      int32_t last = tuple->slots[s].first_rule;
+      while (PCEF_RULE_NONE != classifier->rules[last].next) last = classifier->rules[last].next;
+      classifier->rules[last].next = r;
+    }
+  }
+
+  qsort (classifier->tuples, classifier->num_tuples, sizeof (pcef_tuple_t), pcef_tuple_compare_priority);
+  classifier->compiled = true;
+  OAILOG_DEBUG (LOG_SPGW_APP, "PCEF classifier compiled %u packet filters in %u tuples\n", classifier->num_rules, classifier->num_tuples);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+uint32_t pcef_classifier_lookup (const pcef_classifier_t * const classifier, const uint8_t direction, const pcef_flow_key_t * const flow_key)
+{
+  pcef_key_words_t    key;
+  pcef_key_words_t    masked;
+  const pcef_rule_t  *best = NULL;
+
+  pcef_flow_key_2_key_words (flow_key, &key);
+
+  for (int t = 0; t < classifier->num_tuples; t++) {
+    const pcef_tuple_t * tuple = &classifier->tuples[t];
+    if ((best) && (tuple->best_priority > best->priority)) {
+      break;
+    }
+    pcef_key_apply_mask (&key, &tuple->mask, &masked);
+    uint32_t s = pcef_hash_key (&masked) & tuple->slot_mask;
+    while (PCEF_RULE_NONE != tuple->slots[s].first_rule) {
+      if (pcef_key_equal (&tuple->slots[s].key, &masked)) {
+        for (int32_t r = tuple->slots[s].first_rule; PCEF_RULE_NONE != r; r = classifier->rules[r].next) {
+          const pcef_rule_t * rule = &classifier->rules[r];
+          if ((best) && (rule->priority > best->priority)) break;
+          if (!(rule->direction & direction)) continue;
+          if ((rule->ue_port_range) &&
+              ((flow_key->ue_port < rule->ue_port_low) || (flow_key->ue_port > rule->ue_port_high))) continue;
+          if ((rule->remote_port_range) &&
+              ((flow_key->remote_port < rule->remote_port_low) || (flow_key->remote_port > rule->remote_port_high))) continue;
+          best = rule;
+          break;
+        }
+        break;
+      }
+      s = (s + 1) & tuple->slot_mask;
+    }
+  }
+  return (best) ? best->result : PCEF_CLASSIFIER_NO_MATCH;
+}
+
+//------------------------------------------------------------------------------
+int pcef_classifier_ipv4_packet_2_flow_key (const uint8_t * const packet, const size_t length, const uint8_t direction, pcef_flow_key_t * const key)
+{
+  const struct ip  *iph = (const struct ip *)packet;
+  uint16_t          src_port = 0;
+  uint16_t          dst_port = 0;
+
+  if ((length < sizeof (struct ip)) || (4 != iph->ip_v)) {
+    return RETURNerror;
+  }
+  size_t ihl = iph->ip_hl << 2;
+  if ((ihl < sizeof (struct ip)) || (length < ihl)) {
+    return RETURNerror;
+  }
+  memset (key, 0, sizeof (*key));
+  key->protocol = iph->ip_p;
+  key->tos      = iph->ip_tos;
+
+  // ports and SPI are only present in the first fragment
+  if (0 == (ntohs (iph->ip_off) & IP_OFFMASK)) {
+    const uint8_t * l4 = &packet[ihl];
+    switch (iph->ip_p) {
+      case IPPROTO_TCP:
+      case IPPROTO_UDP:
+      case IPPROTO_SCTP:
+        if (length >= (ihl + 4)) {
+          src_port = ((uint16_t)l4[0] << 8) | l4[1];
+          dst_port = ((uint16_t)l4[2] << 8) | l4[3];
+        }
+        break;
+      case IPPROTO_ESP:
+        if (length >= (ihl + 4)) {
+          key->spi = ((uint32_t)l4[0] << 24) | ((uint32_t)l4[1] << 16) | ((uint32_t)l4[2] << 8) | l4[3];
+        }
+        break;
+      default:;
+    }
+  }
+
+  if (TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY == direction) {
+    key->ue_ipv4     = iph->ip_src;
+    key->remote_ipv4 = iph->ip_dst;
+    key->ue_port     = src_port;
+    key->remote_port = dst_port;
+  } else {
+    key->ue_ipv4     = iph->ip_dst;
+    key->remote_ipv4 = iph->ip_src;
+    key->ue_port     = dst_port;
+    key->remote_port = src_port;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void pcef_classifier_get_stats (const pcef_classifier_t * const classifier, pcef_classifier_stats_t * const stats)
+{
+  memset (stats, 0, sizeof (*stats));
+  stats->num_rules  = classifier->num_rules;
+  stats->num_tuples = classifier->num_tuples;
+  for (int t = 0; t < classifier->num_tuples; t++) {
+    const pcef_tuple_t * tuple = &classifier->tuples[t];
+    stats->num_slots += tuple->slot_mask + 1;
+    for (int s = 0; s <= tuple->slot_mask; s++) {
+      uint32_t chain_length = 0;
+      for (int32_t r = tuple->slots[s].first_rule; PCEF_RULE_NONE != r; r = classifier->rules[r].next) chain_length++;
+      if (chain_length > stats->max_chain_length) stats->max_chain_length = chain_length;
+    }
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,107 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file pgw_pcef_classifier.h
+* \brief In-process SDF/TFT packet classifier (tuple space search).
+*
+* Packet filters (TS 24.008 10.5.6.12) are compiled into one hash table per
+* distinct mask combination ("tuple"). A lookup masks the packet key with each
+* tuple mask and probes the corresponding table, tuples are visited by
+* increasing best evaluation precedence so that the search stops as soon as no
+* remaining tuple can beat the current match.
+* Once compiled a classifier is read-only and can be shared by several readers.
+*/
+
+#ifndef FILE_PGW_PCEF_CLASSIFIER_SEEN
+#define FILE_PGW_PCEF_CLASSIFIER_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <netinet/in.h>
+
+#include "3gpp_24.008.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PCEF_CLASSIFIER_NO_MATCH  0
+
+/*
+ * Flow key, normalized on the UE point of view so that the same packet filter
+ * can be applied on uplink and downlink traffic.
+ * Addresses are in network byte order, ports and SPI in host byte order.
+ */
+typedef struct pcef_flow_key_s {
+  struct in_addr ue_ipv4;
+  struct in_addr remote_ipv4;
+  uint16_t       ue_port;
+  uint16_t       remote_port;
+  uint32_t       spi;
+  uint8_t        protocol;
+  uint8_t        tos;
+} pcef_flow_key_t;
+
+typedef struct pcef_classifier_stats_s {
+  uint32_t       num_rules;
+  uint32_t       num_tuples;
+  uint32_t       num_slots;
+  uint32_t       max_chain_length;
+} pcef_classifier_stats_t;
+
+typedef struct pcef_classifier_s pcef_classifier_t;
+
+pcef_classifier_t * pcef_classifier_create (const uint32_t num_rules_hint);
+
+void pcef_classifier_destroy (pcef_classifier_t ** classifier);
+
+/*
+ * Add a TFT packet filter, result is the value returned by a lookup matching
+ * this filter (SDF identifier, EPS bearer identity, ...), must not be PCEF_CLASSIFIER_NO_MATCH.
+ * If ue_ipv4 is not INADDR_ANY the filter is restricted to this UE (per bearer classification).
+ * Filters can only be added before pcef_classifier_compile().
+ */
+int pcef_classifier_add_packet_filter (pcef_classifier_t * const classifier, const packet_filter_t * const packet_filter,
+                                       const struct in_addr ue_ipv4, const uint32_t result);
+
+int pcef_classifier_compile (pcef_classifier_t * const classifier);
+
+/*
+ * direction is TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY or TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY.
+ * Return the result of the matching filter having the lowest evaluation precedence,
+ * PCEF_CLASSIFIER_NO_MATCH if none.
+ */
+uint32_t pcef_classifier_lookup (const pcef_classifier_t * const classifier, const uint8_t direction, const pcef_flow_key_t * const key) __attribute__ ((hot));
+
+/*
+ * Fill a flow key from an IPv4 packet (starting at IP header), direction tells which address is the UE one.
+ * Return RETURNerror if the packet is not an IPv4 packet or is truncated.
+ */
+int pcef_classifier_ipv4_packet_2_flow_key (const uint8_t * const packet, const size_t length, const uint8_t direction, pcef_flow_key_t * const key) __attribute__ ((hot));
+
+void pcef_classifier_get_stats (const pcef_classifier_t * const classifier, pcef_classifier_stats_t * const stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FILE_PGW_PCEF_CLASSIFIER_SEEN */
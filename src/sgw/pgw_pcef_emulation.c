@@ -60,6 +60,7 @@ extern "C" {
 extern pgw_app_t                        pgw_app;
 
 static void free_pcc_rule (void ** rule);
+static int pgw_pcef_emulation_compile_classifier (void);
 
 //------------------------------------------------------------------------------
 int pgw_pcef_emulation_init (const pgw_config_t * const pgw_config_p)
@@ -71,6 +72,7 @@ int pgw_pcef_emulation_init (const pgw_config_t * const pgw_config_p)
   // Predefined PCC rules
   //--------------------------
   pgw_app.deactivated_predefined_pcc_rules = hashtable_ts_create (32, NULL, free_pcc_rule, NULL);
+  pthread_rwlock_init (&pgw_app.pcef_classifier_rw_lock, NULL);
 
 
   pcc_rule_t * pcc_rule = calloc (1, sizeof (pcc_rule_t));
@@ -252,6 +254,9 @@ void pgw_pcef_emulation_exit (void)
   if (pgw_app.deactivated_predefined_pcc_rules) {
     hashtable_ts_destroy (pgw_app.deactivated_predefined_pcc_rules);
   }
+  pthread_rwlock_wrlock (&pgw_app.pcef_classifier_rw_lock);
+  pcef_classifier_destroy (&pgw_app.pcef_classifier);
+  pthread_rwlock_unlock (&pgw_app.pcef_classifier_rw_lock);
 }
 
 //------------------------------------------------------------------------------
@@ -265,8 +270,12 @@ void pgw_pcef_emulation_apply_rule(const sdf_id_t sdf_id, const pgw_config_t * c
     if (!pcc_rule->is_activated) {
       OAILOG_INFO (LOG_SPGW_APP, "Loading PCC rule %s\n", bdata(pcc_rule->name));
       pcc_rule->is_activated = true;
-      for (int sdff_i = 0; sdff_i < pcc_rule->sdf_template.number_of_packet_filters; sdff_i++) {
-        pgw_pcef_emulation_apply_sdf_filter(&pcc_rule->sdf_template.sdf_filter[sdff_i], pcc_rule->sdf_id, pgw_config_p);
+      if (pgw_config_p->pcef.native_classifier) {
+        pgw_pcef_emulation_compile_classifier();
+      } else {
+        for (int sdff_i = 0; sdff_i < pcc_rule->sdf_template.number_of_packet_filters; sdff_i++) {
+          pgw_pcef_emulation_apply_sdf_filter(&pcc_rule->sdf_template.sdf_filter[sdff_i], pcc_rule->sdf_id, pgw_config_p);
+        }
       }
     }
   }
@@ -310,6 +319,55 @@ void pgw_pcef_emulation_apply_sdf_filter(sdf_filter_t   * const sdf_f, const sdf
   }
 }
 
+//------------------------------------------------------------------------------
+static bool pgw_pcef_emulation_add_rule_to_classifier (const hash_key_t keyP, void * const dataP, void *parameterP, void **resultP)
+{
+  pcc_rule_t         *pcc_rule   = (pcc_rule_t*)dataP;
+  pcef_classifier_t  *classifier = (pcef_classifier_t*)parameterP;
+  struct in_addr      any_ue     = {.s_addr = INADDR_ANY};
+
+  if (pcc_rule->is_activated) {
+    for (int sdff_i = 0; sdff_i < pcc_rule->sdf_template.number_of_packet_filters; sdff_i++) {
+      if (RETURNok != pcef_classifier_add_packet_filter(classifier, &pcc_rule->sdf_template.sdf_filter[sdff_i], any_ue, pcc_rule->sdf_id)) {
+        OAILOG_WARNING (LOG_SPGW_APP, "PCC rule %s SDF filter %d not loaded in classifier\n", bdata(pcc_rule->name), sdff_i);
+      }
+    }
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Rebuild the classifier from all activated PCC rules, then swap it with the one in use.
+static int pgw_pcef_emulation_compile_classifier (void)
+{
+  pcef_classifier_t  *classifier = pcef_classifier_create (2 * SERVICE_DATA_FLOW_TEMPLATE_NB_PACKET_FILTERS_MAX);
+
+  hashtable_ts_apply_callback_on_elements (pgw_app.deactivated_predefined_pcc_rules, pgw_pcef_emulation_add_rule_to_classifier, classifier, NULL);
+  if (RETURNok != pcef_classifier_compile (classifier)) {
+    pcef_classifier_destroy (&classifier);
+    return RETURNerror;
+  }
+  pthread_rwlock_wrlock (&pgw_app.pcef_classifier_rw_lock);
+  pcef_classifier_t  *previous = pgw_app.pcef_classifier;
+  pgw_app.pcef_classifier = classifier;
+  pthread_rwlock_unlock (&pgw_app.pcef_classifier_rw_lock);
+  pcef_classifier_destroy (&previous);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+sdf_id_t pgw_pcef_emulation_classify (const uint8_t direction, const pcef_flow_key_t * const flow_key)
+{
+  uint32_t result = PCEF_CLASSIFIER_NO_MATCH;
+
+  pthread_rwlock_rdlock (&pgw_app.pcef_classifier_rw_lock);
+  if (pgw_app.pcef_classifier) {
+    result = pcef_classifier_lookup (pgw_app.pcef_classifier, direction, flow_key);
+  }
+  pthread_rwlock_unlock (&pgw_app.pcef_classifier_rw_lock);
+  return (sdf_id_t)result;
+}
+
 //------------------------------------------------------------------------------
 bstring pgw_pcef_emulation_packet_filter_2_iptable_string(packet_filter_contents_t * const packetfiltercontents, uint8_t direction)
 {
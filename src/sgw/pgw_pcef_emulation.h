@@ -100,6 +100,7 @@ typedef struct pcc_rule_s {
 } pcc_rule_t;
 
 struct pgw_config_s;
+struct pcef_flow_key_s;
 
 int pgw_pcef_emulation_init (const struct pgw_config_s * const pgw_config_p);
 void pgw_pcef_emulation_exit (void);
@@ -108,6 +109,8 @@ void pgw_pcef_emulation_apply_sdf_filter(sdf_filter_t   * const sdf_f, const sdf
 bstring pgw_pcef_emulation_packet_filter_2_iptable_string(packet_filter_contents_t * const packetfiltercontents, uint8_t direction);
 int pgw_pcef_get_sdf_parameters (const sdf_id_t sdf_id, bearer_qos_t * const bearer_qos, packet_filter_t * const packet_filter, uint8_t * const num_pf);
 pcc_rule_t*  pgw_pcef_get_rule_by_id(const sdf_id_t sdf_id);
+// Classify a packet against the SDF filters of activated PCC rules (native classifier only), return 0 if no SDF matches
+sdf_id_t pgw_pcef_emulation_classify (const uint8_t direction, const struct pcef_flow_key_s * const flow_key) __attribute__ ((hot));
 
 #ifdef __cplusplus
 }
@@ -47,6 +47,11 @@ int release_ue_ipv4_address(const char *imsi, struct in_addr *addr) {
   return pgw_release_free_ipv4_paa_address (addr); 
 }
 
+int reserve_ue_ipv4_address(const char *imsi, struct in_addr *addr) {
+  // Take back an address allocated before a restart
+  return pgw_reserve_ipv4_paa_address (addr);
+}
+
 void pgw_ip_address_pool_init(void) {
   pgw_load_pool_ip_addresses ();
   return;
@@ -29,6 +29,7 @@
 #ifndef FILE_SGW_SEEN
 #define FILE_SGW_SEEN
 #include <stdint.h>
+#include <pthread.h>
 #include <netinet/in.h>
 
 #include "bstrlib.h"
@@ -41,6 +42,7 @@
 #include "sgw_context_manager.h"
 #include "gtpv1u_sgw_defs.h"
 #include "pgw_pcef_emulation.h"
+#include "pgw_pcef_classifier.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -78,6 +80,9 @@ typedef struct pgw_app_s {
   // TODO clarify deactivated_predefined_pcc_rules versus predefined_pcc_rules
   hash_table_ts_t                                         *deactivated_predefined_pcc_rules;
   hash_table_ts_t                                         *predefined_pcc_rules;
+  // compiled SDF filters of activated PCC rules, rebuilt on each rule activation
+  pthread_rwlock_t                                         pcef_classifier_rw_lock;
+  pcef_classifier_t                                       *pcef_classifier;
 } pgw_app_t;
 
 #ifdef __cplusplus
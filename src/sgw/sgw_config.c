@@ -93,6 +93,7 @@ int sgw_config_parse_file (sgw_config_t * config_pP)
   char                                   *S11 = NULL;
   libconfig_int                           sgw_udp_port_S1u_S12_S4_up = 2152;
   libconfig_int                           sgw_udp_port_S11 = 2123;
+  libconfig_int                           aint = 0;
   config_setting_t                       *subsetting = NULL;
   const char                             *astring = NULL;
   bstring                                 address = NULL;
@@ -265,6 +266,99 @@ int sgw_config_parse_file (sgw_config_t * config_pP)
         config_pP->udp_port_S1u_S12_S4_up = sgw_udp_port_S1u_S12_S4_up;
       }
     }
+
+    // DOWNLINK BUFFERING SETTING
+    config_pP->dl_buffering.enabled                = false;
+    config_pP->dl_buffering.if_name                = bfromcstr ("sgwbuf0");
+    config_pP->dl_buffering.max_packets_per_bearer = 64;
+    config_pP->dl_buffering.max_kbytes             = 16384;
+    config_pP->dl_buffering.packet_ttl_ms          = 10000;
+    subsetting = config_setting_get_member (setting_sgw, SGW_CONFIG_STRING_DOWNLINK_BUFFERING_CONFIG);
+
+    if (subsetting) {
+      if (config_setting_lookup_string (subsetting, SGW_CONFIG_STRING_DL_BUFFERING_ENABLE, (const char **)&astring)) {
+        config_pP->dl_buffering.enabled = (strcasecmp (astring, "yes") == 0);
+      }
+      if (config_setting_lookup_string (subsetting, SGW_CONFIG_STRING_DL_BUFFERING_INTERFACE_NAME, (const char **)&astring)) {
+        bassigncstr (config_pP->dl_buffering.if_name, astring);
+      }
+      if (config_setting_lookup_int (subsetting, SGW_CONFIG_STRING_DL_BUFFERING_MAX_PACKETS_PER_BEARER, &aint)) {
+        AssertFatal (0 < aint, "Bad %s value %d\n", SGW_CONFIG_STRING_DL_BUFFERING_MAX_PACKETS_PER_BEARER, (int)aint);
+        config_pP->dl_buffering.max_packets_per_bearer = (uint32_t)aint;
+      }
+      if (config_setting_lookup_int (subsetting, SGW_CONFIG_STRING_DL_BUFFERING_MAX_MEMORY_KB, &aint)) {
+        AssertFatal (0 < aint, "Bad %s value %d\n", SGW_CONFIG_STRING_DL_BUFFERING_MAX_MEMORY_KB, (int)aint);
+        config_pP->dl_buffering.max_kbytes = (uint32_t)aint;
+      }
+      if (config_setting_lookup_int (subsetting, SGW_CONFIG_STRING_DL_BUFFERING_PACKET_TTL_MS, &aint)) {
+        AssertFatal (0 < aint, "Bad %s value %d\n", SGW_CONFIG_STRING_DL_BUFFERING_PACKET_TTL_MS, (int)aint);
+        config_pP->dl_buffering.packet_ttl_ms = (uint32_t)aint;
+      }
+    }
+
+    // SESSION JOURNAL SETTING
+    config_pP->session_journal.enabled = false;
+    config_pP->session_journal.file    = bfromcstr ("/var/lib/oai/spgw_sessions.journal");
+    subsetting = config_setting_get_member (setting_sgw, SGW_CONFIG_STRING_SESSION_JOURNAL_CONFIG);
+
+    if (subsetting) {
+      if (config_setting_lookup_string (subsetting, SGW_CONFIG_STRING_SESSION_JOURNAL_ENABLE, (const char **)&astring)) {
+        config_pP->session_journal.enabled = (strcasecmp (astring, "yes") == 0);
+      }
+      if (config_setting_lookup_string (subsetting, SGW_CONFIG_STRING_SESSION_JOURNAL_FILE, (const char **)&astring)) {
+        bassigncstr (config_pP->session_journal.file, astring);
+      }
+    }
+
+    // ITTI SETTING
+    subsetting = config_setting_get_member (setting_sgw, SGW_CONFIG_STRING_INTERTASK_INTERFACE_CONFIG);
+
+    if (subsetting) {
+      config_setting_t                       *placements_setting = NULL;
+
+      if (config_setting_lookup_int (subsetting, SGW_CONFIG_STRING_ITTI_THREAD_STATS_PERIOD_SEC, &aint)) {
+        AssertFatal (0 <= aint, "Bad %s value %d\n", SGW_CONFIG_STRING_ITTI_THREAD_STATS_PERIOD_SEC, (int)aint);
+        config_pP->itti_config.thread_stats_period_sec = (uint32_t)aint;
+      }
+      placements_setting = config_setting_get_member (subsetting, SGW_CONFIG_STRING_ITTI_THREAD_PLACEMENT);
+      if (placements_setting) {
+        const int                             num = config_setting_length (placements_setting);
+
+        AssertFatal (num <= SGW_CONFIG_MAX_ITTI_THREAD_PLACEMENTS, "Too many %s (max %d)\n", SGW_CONFIG_STRING_ITTI_THREAD_PLACEMENT, SGW_CONFIG_MAX_ITTI_THREAD_PLACEMENTS);
+        for (int i = 0; i < num; i++) {
+          config_setting_t                     *placement_setting = config_setting_get_elem (placements_setting, i);
+          const int                             p = config_pP->itti_config.nb_thread_placements;
+
+          AssertFatal (config_setting_lookup_string (placement_setting, SGW_CONFIG_STRING_ITTI_PLACEMENT_TASK, (const char **)&astring),
+              "Missing %s in %s\n", SGW_CONFIG_STRING_ITTI_PLACEMENT_TASK, SGW_CONFIG_STRING_ITTI_THREAD_PLACEMENT);
+          config_pP->itti_config.thread_placement[p].task = bfromcstr (astring);
+          config_pP->itti_config.thread_placement[p].cpus = NULL;
+          if ((config_setting_lookup_string (placement_setting, SGW_CONFIG_STRING_ITTI_PLACEMENT_CPUS, (const char **)&astring)) && (astring[0])) {
+            config_pP->itti_config.thread_placement[p].cpus = bfromcstr (astring);
+          }
+          config_pP->itti_config.thread_placement[p].numa_node = -1;
+          if (config_setting_lookup_int (placement_setting, SGW_CONFIG_STRING_ITTI_PLACEMENT_NUMA_NODE, &aint)) {
+            config_pP->itti_config.thread_placement[p].numa_node = (int)aint;
+          }
+          config_pP->itti_config.thread_placement[p].wait_mode = ITTI_WAIT_MODE_BLOCK;
+          if (config_setting_lookup_string (placement_setting, SGW_CONFIG_STRING_ITTI_PLACEMENT_WAIT_MODE, (const char **)&astring)) {
+            if (strcasecmp (astring, "ADAPTIVE_SPIN") == 0) {
+              config_pP->itti_config.thread_placement[p].wait_mode = ITTI_WAIT_MODE_ADAPTIVE_SPIN;
+            } else if (strcasecmp (astring, "BUSY_POLL") == 0) {
+              config_pP->itti_config.thread_placement[p].wait_mode = ITTI_WAIT_MODE_BUSY_POLL;
+            } else {
+              AssertFatal (strcasecmp (astring, "BLOCK") == 0, "Bad %s value %s\n", SGW_CONFIG_STRING_ITTI_PLACEMENT_WAIT_MODE, astring);
+            }
+          }
+          config_pP->itti_config.thread_placement[p].spin_us = 50;
+          if (config_setting_lookup_int (placement_setting, SGW_CONFIG_STRING_ITTI_PLACEMENT_SPIN_US, &aint)) {
+            AssertFatal (0 <= aint, "Bad %s value %d\n", SGW_CONFIG_STRING_ITTI_PLACEMENT_SPIN_US, (int)aint);
+            config_pP->itti_config.thread_placement[p].spin_us = (uint32_t)aint;
+          }
+          config_pP->itti_config.nb_thread_placements++;
+        }
+      }
+    }
   }
 
   config_destroy (&cfg);
@@ -290,9 +384,24 @@ void sgw_config_display (sgw_config_t * config_p)
   OAILOG_INFO (LOG_SPGW_APP, "    S11 iface ............: %s\n", bdata(config_p->ipv4.if_name_S11));
   OAILOG_INFO (LOG_SPGW_APP, "    S11 ip ...............: %s/%u\n", inet_ntoa (config_p->ipv4.S11), config_p->ipv4.netmask_S11);
   OAILOG_INFO (LOG_SPGW_APP, "    S11 port .............: %u\n", config_p->udp_port_S11);
+  OAILOG_INFO (LOG_SPGW_APP, "- Downlink buffering:\n");
+  OAILOG_INFO (LOG_SPGW_APP, "    enabled ..............: %s\n", (config_p->dl_buffering.enabled) ? "true":"false");
+  OAILOG_INFO (LOG_SPGW_APP, "    TUN iface ............: %s\n", bdata(config_p->dl_buffering.if_name));
+  OAILOG_INFO (LOG_SPGW_APP, "    packets per bearer ...: %u\n", config_p->dl_buffering.max_packets_per_bearer);
+  OAILOG_INFO (LOG_SPGW_APP, "    memory ...............: %u (KB)\n", config_p->dl_buffering.max_kbytes);
+  OAILOG_INFO (LOG_SPGW_APP, "    packet TTL ...........: %u (ms)\n", config_p->dl_buffering.packet_ttl_ms);
+  OAILOG_INFO (LOG_SPGW_APP, "- Session journal:\n");
+  OAILOG_INFO (LOG_SPGW_APP, "    enabled ..............: %s\n", (config_p->session_journal.enabled) ? "true":"false");
+  OAILOG_INFO (LOG_SPGW_APP, "    file .................: %s\n", bdata(config_p->session_journal.file));
   OAILOG_INFO (LOG_SPGW_APP, "- ITTI:\n");
   OAILOG_INFO (LOG_SPGW_APP, "    queue size .......: %u (bytes)\n", config_p->itti_config.queue_size);
   OAILOG_INFO (LOG_SPGW_APP, "    log file .........: %s\n", bdata(config_p->itti_config.log_file));
+  OAILOG_INFO (LOG_SPGW_APP, "    thread stats .....: every %u s\n", config_p->itti_config.thread_stats_period_sec);
+  for (int i = 0; i < config_p->itti_config.nb_thread_placements; i++) {
+    OAILOG_INFO (LOG_SPGW_APP, "    %-16s .: CPUs %s, NUMA node %d, wait mode %d, spin %u us\n", bdata(config_p->itti_config.thread_placement[i].task),
+        (config_p->itti_config.thread_placement[i].cpus) ? bdata(config_p->itti_config.thread_placement[i].cpus):"any",
+        config_p->itti_config.thread_placement[i].numa_node, config_p->itti_config.thread_placement[i].wait_mode, config_p->itti_config.thread_placement[i].spin_us);
+  }
 
   OAILOG_INFO (LOG_SPGW_APP, "- Logging:\n");
   OAILOG_INFO (LOG_SPGW_APP, "    Output ..............: %s\n", bdata(config_p->log_config.output));
@@ -48,6 +48,24 @@ extern "C" {
 #define SGW_CONFIG_STRING_SGW_INTERFACE_NAME_FOR_S11            "SGW_INTERFACE_NAME_FOR_S11"
 #define SGW_CONFIG_STRING_SGW_IPV4_ADDRESS_FOR_S11              "SGW_IPV4_ADDRESS_FOR_S11"
 #define SGW_CONFIG_STRING_SGW_UDP_PORT_FOR_S11                  "SGW_UDP_PORT_FOR_S11"
+#define SGW_CONFIG_STRING_DOWNLINK_BUFFERING_CONFIG             "DOWNLINK_BUFFERING"
+#define SGW_CONFIG_STRING_DL_BUFFERING_ENABLE                   "ENABLE"
+#define SGW_CONFIG_STRING_DL_BUFFERING_INTERFACE_NAME           "INTERFACE_NAME"
+#define SGW_CONFIG_STRING_DL_BUFFERING_MAX_PACKETS_PER_BEARER   "MAX_PACKETS_PER_BEARER"
+#define SGW_CONFIG_STRING_DL_BUFFERING_MAX_MEMORY_KB            "MAX_MEMORY_KB"
+#define SGW_CONFIG_STRING_DL_BUFFERING_PACKET_TTL_MS            "PACKET_TTL_MS"
+#define SGW_CONFIG_STRING_SESSION_JOURNAL_CONFIG                "SESSION_JOURNAL"
+#define SGW_CONFIG_STRING_SESSION_JOURNAL_ENABLE                "ENABLE"
+#define SGW_CONFIG_STRING_SESSION_JOURNAL_FILE                  "FILE"
+#define SGW_CONFIG_STRING_INTERTASK_INTERFACE_CONFIG            "INTERTASK_INTERFACE"
+#define SGW_CONFIG_STRING_ITTI_THREAD_PLACEMENT                 "THREAD_PLACEMENT"
+#define SGW_CONFIG_STRING_ITTI_PLACEMENT_TASK                   "TASK"
+#define SGW_CONFIG_STRING_ITTI_PLACEMENT_CPUS                   "CPUS"
+#define SGW_CONFIG_STRING_ITTI_PLACEMENT_NUMA_NODE              "NUMA_NODE"
+#define SGW_CONFIG_STRING_ITTI_PLACEMENT_WAIT_MODE              "WAIT_MODE"
+#define SGW_CONFIG_STRING_ITTI_PLACEMENT_SPIN_US                "SPIN_US"
+#define SGW_CONFIG_STRING_ITTI_THREAD_STATS_PERIOD_SEC          "THREAD_STATS_PERIOD_SEC"
+#define SGW_CONFIG_MAX_ITTI_THREAD_PLACEMENTS                   16
 
 #define SPGW_ABORT_ON_ERROR true
 #define SPGW_WARN_ON_ERROR false
@@ -60,6 +78,15 @@ typedef struct sgw_config_s {
   struct {
     uint32_t  queue_size;
     bstring   log_file;
+    uint32_t  thread_stats_period_sec;  ///< CPU time and run queue delay of the task threads are logged at this period, 0 to disable
+    int       nb_thread_placements;
+    struct {
+      bstring   task;
+      bstring   cpus;                   ///< CPU list, ex: "2-3,8", NULL if the affinity is not set
+      int       numa_node;              ///< node of the task queue, -1 if not set
+      int       wait_mode;              ///< itti_wait_mode_t
+      uint32_t  spin_us;
+    } thread_placement[SGW_CONFIG_MAX_ITTI_THREAD_PLACEMENTS];
   } itti_config;
 
   struct {
@@ -81,6 +108,19 @@ typedef struct sgw_config_s {
   uint16_t     udp_port_S11;
 
   bool         local_to_eNB;
+
+  struct {
+    bool       enabled;
+    bstring    if_name;                 ///< TUN device receiving the downlink packets of idle UEs
+    uint32_t   max_packets_per_bearer;
+    uint32_t   max_kbytes;              ///< memory cap for all the buffered packets
+    uint32_t   packet_ttl_ms;
+  } dl_buffering;
+
+  struct {
+    bool       enabled;
+    bstring    file;                    ///< append-only log of the sessions, replayed at startup
+  } session_journal;
 #if (!EMBEDDED_SGW)
   log_config_t log_config;
 #endif
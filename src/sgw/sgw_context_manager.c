@@ -166,17 +166,29 @@ pgw_lite_cm_free_apn (
   }
 }
 
+// TO DO: RANDOM
+static teid_t                           sgw_s11_tunnel_id = 100;
+
 //-----------------------------------------------------------------------------
 teid_t
 sgw_get_new_S11_tunnel_id (
   void)
 //-----------------------------------------------------------------------------
 {
-  // TO DO: RANDOM
-  static teid_t                           tunnel_id = 100;
+  sgw_s11_tunnel_id += 1;
+  return sgw_s11_tunnel_id;
+}
 
-  tunnel_id += 1;
-  return tunnel_id;
+//-----------------------------------------------------------------------------
+void
+sgw_reserve_S11_tunnel_id (
+  const teid_t teid)
+//-----------------------------------------------------------------------------
+{
+  // restored sessions, next allocated teids start above
+  if (teid > sgw_s11_tunnel_id) {
+    sgw_s11_tunnel_id = teid;
+  }
 }
 
 //-----------------------------------------------------------------------------
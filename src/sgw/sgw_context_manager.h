@@ -66,6 +66,7 @@ void                                   pgw_lite_cm_free_apn(pgw_apn_t **apnP);
 
 
 teid_t                                 sgw_get_new_S11_tunnel_id(void);
+void                                   sgw_reserve_S11_tunnel_id(const teid_t teid);
 mme_sgw_tunnel_t *                     sgw_cm_create_s11_tunnel(teid_t remote_teid, teid_t local_teid);
 int                                    sgw_cm_remove_s11_tunnel(teid_t local_teid);
 sgw_eps_bearer_ctxt_t *                sgw_cm_create_eps_bearer_context(void);
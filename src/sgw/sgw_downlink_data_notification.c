@@ -21,6 +21,9 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
 
 
 
@@ -31,6 +34,8 @@
 #include "intertask_interface.h"
 #include "log.h"
 #include "common_types.h"
+#include "hashtable.h"
+#include "obj_hashtable.h"
 #include "sgw_downlink_data_notification.h"
 #include "sgw_context_manager.h"
 #include "gtpv1_u_messages_types.h"
@@ -44,6 +49,225 @@ extern "C" {
 
 extern sgw_app_t                        sgw_app;
 
+/* Node level state received from an MME in the DL data notification acks */
+typedef struct sgw_ddn_mme_s {
+  struct in_addr   mme_ip;
+  uint64_t         delay_until_ms;        ///< Data Notification Delay
+  uint64_t         throttling_until_ms;   ///< DL low priority traffic throttling
+  uint8_t          throttling_factor;
+  uint32_t         throttling_credit;     ///< spreads the drops evenly, one drop each time it reaches 100
+} sgw_ddn_mme_t;
+
+typedef struct sgw_ddn_s {
+  hash_table_t    *ues;                   ///< sgw_ddn_ue_t, key is UE IPv4 address
+  sgw_ddn_mme_t    mmes[SGW_DDN_MAX_MME];
+  int              nb_mmes;
+  uint64_t         nb_sent;
+  uint64_t         nb_coalesced;
+  uint64_t         nb_throttled;
+} sgw_ddn_t;
+
+/* Only accessed by the SPGW app task */
+static sgw_ddn_t                        sgw_ddn = {0};
+
+//------------------------------------------------------------------------------
+static uint64_t sgw_ddn_now_ms (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+//------------------------------------------------------------------------------
+static uint64_t sgw_ddn_throttling_delay_ms (const throttling_t * const throttling)
+{
+  uint64_t unit_ms = 0;
+
+  switch (throttling->delay_unit) {
+  case THROTTLING_DELAY_UNIT_2_SECONDS:   unit_ms = 2000; break;
+  case THROTTLING_DELAY_UNIT_10_MINUTES:  unit_ms = 600000; break;
+  case THROTTLING_DELAY_UNIT_1_HOUR:      unit_ms = 3600000; break;
+  case THROTTLING_DELAY_UNIT_10_HOURS:    unit_ms = 36000000; break;
+  case THROTTLING_DELAY_UNIT_DEACTIVATED: unit_ms = 0; break;
+  default:                                unit_ms = 60000; // TS 29.274: other values shall be interpreted as 1 minute
+  }
+  return unit_ms * throttling->delay_value;
+}
+
+//------------------------------------------------------------------------------
+static sgw_ddn_mme_t * sgw_ddn_get_mme (const struct in_addr mme_ip)
+{
+  for (int i = 0; i < sgw_ddn.nb_mmes; i++) {
+    if (sgw_ddn.mmes[i].mme_ip.s_addr == mme_ip.s_addr) {
+      return &sgw_ddn.mmes[i];
+    }
+  }
+  if (SGW_DDN_MAX_MME > sgw_ddn.nb_mmes) {
+    sgw_ddn_mme_t *mme = &sgw_ddn.mmes[sgw_ddn.nb_mmes++];
+    memset (mme, 0, sizeof (*mme));
+    mme->mme_ip = mme_ip;
+    return mme;
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void sgw_ddn_set_state (const struct in_addr ue_ip, const sgw_ddn_state_t state, const uint64_t duration_ms)
+{
+  sgw_ddn_ue_t *ddn = NULL;
+
+  if ((sgw_ddn.ues) && (HASH_TABLE_OK == hashtable_get (sgw_ddn.ues, (hash_key_t)ue_ip.s_addr, (void **)&ddn))) {
+    OAILOG_DEBUG (LOG_SPGW_APP, "DDN UE " IN_ADDR_FMT " state %d -> %d, %u triggers coalesced\n",
+        PRI_IN_ADDR (ue_ip), ddn->state, state, ddn->nb_coalesced);
+    ddn->state        = state;
+    ddn->until_ms     = (duration_ms) ? sgw_ddn_now_ms () + duration_ms : 0;
+    ddn->nb_coalesced = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+int sgw_ddn_init (void)
+{
+  bstring b = bfromcstr ("sgw_ddn_ues");
+
+  memset (&sgw_ddn, 0, sizeof (sgw_ddn));
+  sgw_ddn.ues = hashtable_create (512, NULL, NULL, b);
+  bdestroy_wrapper (&b);
+  if (!sgw_ddn.ues) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Failed to create the DL data notification table\n");
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void sgw_ddn_exit (void)
+{
+  if (sgw_ddn.ues) {
+    OAILOG_INFO (LOG_SPGW_APP, "DL data notifications sent %"PRIu64" coalesced %"PRIu64" throttled %"PRIu64"\n",
+        sgw_ddn.nb_sent, sgw_ddn.nb_coalesced, sgw_ddn.nb_throttled);
+    hashtable_destroy (sgw_ddn.ues);
+    sgw_ddn.ues = NULL;
+  }
+}
+
+//------------------------------------------------------------------------------
+int sgw_ddn_get_ue (const struct in_addr ue_ip, sgw_ddn_ue_t ** const ddn, s_plus_p_gw_eps_bearer_context_information_t ** const ctx)
+{
+  sgw_ddn_ue_t *ue = NULL;
+
+  if (!sgw_ddn.ues) {
+    return RETURNerror;
+  }
+  if (HASH_TABLE_OK == hashtable_get (sgw_ddn.ues, (hash_key_t)ue_ip.s_addr, (void **)&ue)) {
+    // cached S11 teid, just check the context is still there
+    if (HASH_TABLE_OK == hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, ue->s11_lteid, (void **)ctx)) {
+      *ddn = ue;
+      return RETURNok;
+    }
+    hashtable_free (sgw_ddn.ues, (hash_key_t)ue_ip.s_addr);
+    ue = NULL;
+  }
+
+  // first trigger for this UE (or stale entry), resolve the context from the PAA
+  char     str[INET_ADDRSTRLEN] = {0};
+  uint64_t teid = 0;
+
+  if (NULL == inet_ntop (AF_INET, &ue_ip, str, INET_ADDRSTRLEN)) {
+    return RETURNerror;
+  }
+  if (HASH_TABLE_OK != obj_hashtable_uint64_ts_get (sgw_app.ip2s11teid, str, strlen (str), &teid)) {
+    return RETURNerror;
+  }
+  if (HASH_TABLE_OK != hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, (hash_key_t)teid, (void **)ctx)) {
+    return RETURNerror;
+  }
+  ue = calloc (1, sizeof (*ue));
+  if (!ue) {
+    return RETURNerror;
+  }
+  ue->ue_ip     = ue_ip;
+  ue->s11_lteid = (teid_t)teid;
+  ue->state     = SGW_DDN_STATE_IDLE;
+  hashtable_insert (sgw_ddn.ues, (hash_key_t)ue_ip.s_addr, ue);
+  *ddn = ue;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+bool sgw_ddn_may_notify (sgw_ddn_ue_t * const ddn, const s_plus_p_gw_eps_bearer_context_information_t * const ctx, const bearer_qos_t * const qos)
+{
+  const uint64_t now_ms = sgw_ddn_now_ms ();
+
+  switch (ddn->state) {
+  case SGW_DDN_STATE_PENDING:
+  case SGW_DDN_STATE_ACKED:
+    if (now_ms < ddn->until_ms) {
+      ddn->nb_coalesced += 1;
+      sgw_ddn.nb_coalesced += 1;
+      return false;
+    }
+    // no ack after the S11 retransmissions, or the paging did not bring the UE back
+    OAILOG_DEBUG (LOG_SPGW_APP, "DDN UE " IN_ADDR_FMT " guard expired in state %d\n", PRI_IN_ADDR (ddn->ue_ip), ddn->state);
+    break;
+  case SGW_DDN_STATE_THROTTLED:
+    if (now_ms < ddn->until_ms) {
+      sgw_ddn.nb_throttled += 1;
+      return false;
+    }
+    break;
+  default:;
+  }
+  ddn->state = SGW_DDN_STATE_IDLE;
+
+  sgw_ddn_mme_t *mme = sgw_ddn_get_mme (ctx->sgw_eps_bearer_context_information.mme_ip_address_S11.address.ipv4_address);
+
+  if (mme) {
+    if (now_ms < mme->delay_until_ms) {
+      // TS 23.401 5.3.4.3: Data Notification Delay, wait for the next trigger after the delay
+      ddn->state    = SGW_DDN_STATE_THROTTLED;
+      ddn->until_ms = mme->delay_until_ms;
+      sgw_ddn.nb_throttled += 1;
+      return false;
+    }
+    if ((now_ms < mme->throttling_until_ms) && (qos) && (SGW_DDN_THROTTLING_PRIORITY_LEVEL_THRESHOLD <= qos->pl)) {
+      // TS 23.401 4.3.7.4.1a: drop this proportion of the notifications of the low priority bearers
+      mme->throttling_credit += mme->throttling_factor;
+      if (100 <= mme->throttling_credit) {
+        mme->throttling_credit -= 100;
+        ddn->state    = SGW_DDN_STATE_THROTTLED;
+        ddn->until_ms = now_ms + SGW_DDN_THROTTLED_HOLD_OFF_MS;
+        sgw_ddn.nb_throttled += 1;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void sgw_ddn_notified (sgw_ddn_ue_t * const ddn)
+{
+  ddn->state        = SGW_DDN_STATE_PENDING;
+  ddn->until_ms     = sgw_ddn_now_ms () + SGW_DDN_PENDING_GUARD_MS;
+  ddn->nb_coalesced = 0;
+  sgw_ddn.nb_sent  += 1;
+}
+
+//------------------------------------------------------------------------------
+void sgw_ddn_reset_ue (const struct in_addr ue_ip)
+{
+  sgw_ddn_set_state (ue_ip, SGW_DDN_STATE_IDLE, 0);
+}
+
+//------------------------------------------------------------------------------
+void sgw_ddn_remove_ue (const struct in_addr ue_ip)
+{
+  if (sgw_ddn.ues) {
+    hashtable_free (sgw_ddn.ues, (hash_key_t)ue_ip.s_addr);
+  }
+}
 
 //------------------------------------------------------------------------------
 int sgw_notify_downlink_data(const struct in_addr ue_ip, const ebi_t ebi)
@@ -57,6 +281,7 @@ int sgw_notify_downlink_data(const struct in_addr ue_ip, const ebi_t ebi)
     gtpv1u_dl_data = GTPV1U_DOWNLINK_DATA_NOTIFICATION(message_p);
     gtpv1u_dl_data->ue_ip = ue_ip;
     gtpv1u_dl_data->eps_bearer_id = ebi;
+    gtpv1u_dl_data->sdf_id = 0;
 
     int rv = itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
     return rv;
@@ -74,10 +299,29 @@ sgw_handle_s11_downlink_data_notification_ack (
   s_plus_p_gw_eps_bearer_context_information_t *bearer_ctxt_info_p = NULL;
   int rc = RETURNerror;
 
-  // TODO procedure for DL DATA NOTIFICATION
   if (RETURNok == (rc = hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, ack->teid, (void **)&bearer_ctxt_info_p))) {
+    sgw_ddn_mme_t *mme = sgw_ddn_get_mme (bearer_ctxt_info_p->sgw_eps_bearer_context_information.mme_ip_address_S11.address.ipv4_address);
+
+    if (mme) {
+      const uint64_t now_ms = sgw_ddn_now_ms ();
+
+      if (ack->ie_presence_mask & DOWNLINK_DATA_NOTIFICATION_ACK_PR_IE_DATA_NOTIFICATION_DELAY) {
+        mme->delay_until_ms = now_ms + ((uint64_t)ack->data_notification_delay * 50);
+      }
+      if (ack->ie_presence_mask & DOWNLINK_DATA_NOTIFICATION_ACK_PR_IE_DL_LOW_PRIORITY_TRAFFIC_THROTTLING) {
+        const uint64_t delay_ms = sgw_ddn_throttling_delay_ms (&ack->dl_low_priority_traffic_throttling);
+
+        // a new throttling IE replaces the previous one, a null delay or factor stops the throttling
+        mme->throttling_factor   = (delay_ms) ? ack->dl_low_priority_traffic_throttling.factor : 0;
+        mme->throttling_until_ms = (mme->throttling_factor) ? now_ms + delay_ms : 0;
+        mme->throttling_credit   = 0;
+        OAILOG_INFO (LOG_SPGW_APP, "DL Data Notification throttling from MME " IN_ADDR_FMT ": factor %u%% for %"PRIu64" ms\n",
+            PRI_IN_ADDR (mme->mme_ip), mme->throttling_factor, delay_ms);
+      }
+    }
+
     int bidx = 0;
-    while ((NULL == bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array[bidx]) && (bidx < BEARERS_PER_UE)) {
+    while ((bidx < BEARERS_PER_UE) && (NULL == bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array[bidx])) {
       bidx++;
     }
     if (bidx< BEARERS_PER_UE) {
@@ -85,20 +329,28 @@ sgw_handle_s11_downlink_data_notification_ack (
       if ((IPv4 == paa.pdn_type) || (IPv4_AND_v6 == paa.pdn_type)) {
         switch (ack->cause.cause_value) {
         case REQUEST_ACCEPTED:
+          sgw_ddn_set_state (paa.ipv4_address, SGW_DDN_STATE_ACKED, PAGING_CONFIRMED_CLAMPING_TIMEOUT_SEC * 1000);
+#if ENABLE_OPENFLOW
           openflow_controller_stop_dl_data_notification_ue(paa.ipv4_address, PAGING_CONFIRMED_CLAMPING_TIMEOUT_SEC);
+#endif
           OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNok);
           break;
         case TEMP_REJECT_HO_IN_PROGRESS:
         case UE_ALREADY_RE_ATTACHED:
+          sgw_ddn_reset_ue (paa.ipv4_address);
           OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNok);
           break;
         case UNABLE_TO_PAGE_UE:
         case CONTEXT_NOT_FOUND:
         case UNABLE_TO_PAGE_UE_DUE_TO_SUSPENSION:
+          sgw_ddn_set_state (paa.ipv4_address, SGW_DDN_STATE_THROTTLED, PAGING_REJECTED_CLAMPING_TIMEOUT_SEC * 1000);
+#if ENABLE_OPENFLOW
           openflow_controller_stop_dl_data_notification_ue(paa.ipv4_address, PAGING_REJECTED_CLAMPING_TIMEOUT_SEC);
+#endif
           OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNok);
           break;
         default:
+          sgw_ddn_reset_ue (paa.ipv4_address);
           OAILOG_NOTICE (LOG_SPGW_APP, "DL Data Notification Ack: Cause value not handled: %d\n", ack->cause.cause_value);
         }
       }
@@ -117,10 +369,9 @@ sgw_handle_s11_downlink_data_notification_failure_ind (
   s_plus_p_gw_eps_bearer_context_information_t *bearer_ctxt_info_p = NULL;
   int rc = RETURNerror;
 
-  // TODO procedure for DL DATA NOTIFICATION
   if (RETURNok == (rc = hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, ind->teid, (void **)&bearer_ctxt_info_p))) {
     int bidx = 0;
-    while ((NULL == bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array[bidx]) && (bidx < BEARERS_PER_UE)) {
+    while ((bidx < BEARERS_PER_UE) && (NULL == bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array[bidx])) {
       bidx++;
     }
     if (bidx< BEARERS_PER_UE) {
@@ -128,17 +379,25 @@ sgw_handle_s11_downlink_data_notification_failure_ind (
       if ((IPv4 == paa.pdn_type) || (IPv4_AND_v6 == paa.pdn_type)) {
         switch (ind->cause.cause_value) {
         case SERVICE_DENIED:
+          sgw_ddn_set_state (paa.ipv4_address, SGW_DDN_STATE_THROTTLED, PAGING_SERVICE_DENIED_CLAMPING_TIMEOUT_SEC * 1000);
+#if ENABLE_OPENFLOW
           openflow_controller_stop_dl_data_notification_ue(paa.ipv4_address, PAGING_SERVICE_DENIED_CLAMPING_TIMEOUT_SEC);
+#endif
           OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNok);
           break;
         case UE_ALREADY_RE_ATTACHED:
+          sgw_ddn_reset_ue (paa.ipv4_address);
           OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNok);
           break;
         case UE_NOT_RESPONDING:
+          sgw_ddn_set_state (paa.ipv4_address, SGW_DDN_STATE_THROTTLED, PAGING_UE_NOT_RESPONDING_CLAMPING_TIMEOUT_SEC * 1000);
+#if ENABLE_OPENFLOW
           openflow_controller_stop_dl_data_notification_ue(paa.ipv4_address, PAGING_UE_NOT_RESPONDING_CLAMPING_TIMEOUT_SEC);
+#endif
           OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNok);
           break;
         default:
+          sgw_ddn_reset_ue (paa.ipv4_address);
           OAILOG_NOTICE (LOG_SPGW_APP, "DL Data Notification Failure Indication: Cause value not handled: %d\n", ind->cause.cause_value);
         }
       }
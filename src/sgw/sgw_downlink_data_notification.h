@@ -31,9 +31,11 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+#include <stdbool.h>
 #include <netinet/in.h>
 #include "3gpp_24.007.h"
 #include "s11_messages_types.h"
+#include "sgw_context_manager.h"
 
 #define PAGING_UNCONFIRMED_CLAMPING_TIMEOUT_SEC        6
 #define PAGING_CONFIRMED_CLAMPING_TIMEOUT_SEC          60
@@ -41,6 +43,38 @@ extern "C" {
 #define PAGING_SERVICE_DENIED_CLAMPING_TIMEOUT_SEC     180
 #define PAGING_REJECTED_CLAMPING_TIMEOUT_SEC           8192
 
+/* Guard of a DL data notification waiting for its ack, covers the S11 retransmissions (T3 2s, N3 2) */
+#define SGW_DDN_PENDING_GUARD_MS                       (PAGING_UNCONFIRMED_CLAMPING_TIMEOUT_SEC * 1000)
+/* Bearers with an ARP priority level below this one are never throttled (TS 29.212 levels 1..8 are operator prioritized) */
+#define SGW_DDN_THROTTLING_PRIORITY_LEVEL_THRESHOLD    9
+/* Hold-off of a UE after one of its notifications was throttled, next trigger draws again */
+#define SGW_DDN_THROTTLED_HOLD_OFF_MS                  1000
+#define SGW_DDN_MAX_MME                                16
+
+typedef enum sgw_ddn_state_e {
+  SGW_DDN_STATE_IDLE = 0,   ///< no notification outstanding
+  SGW_DDN_STATE_PENDING,    ///< notification sent, waiting for the ack
+  SGW_DDN_STATE_ACKED,      ///< MME is paging the UE
+  SGW_DDN_STATE_THROTTLED,  ///< notifications suppressed (reject, failure, delay or throttling from the MME)
+} sgw_ddn_state_t;
+
+/* DL data notification state of a UE, keyed by its IPv4 address, owned by the SPGW app task */
+typedef struct sgw_ddn_ue_s {
+  struct in_addr   ue_ip;
+  teid_t           s11_lteid;      ///< cached local S11 teid of the UE context
+  sgw_ddn_state_t  state;
+  uint64_t         until_ms;       ///< end of the PENDING/ACKED guard or of the THROTTLED period
+  uint32_t         nb_coalesced;   ///< triggers absorbed by the outstanding notification
+} sgw_ddn_ue_t;
+
+int  sgw_ddn_init (void);
+void sgw_ddn_exit (void);
+int  sgw_ddn_get_ue (const struct in_addr ue_ip, sgw_ddn_ue_t ** const ddn, s_plus_p_gw_eps_bearer_context_information_t ** const ctx);
+bool sgw_ddn_may_notify (sgw_ddn_ue_t * const ddn, const s_plus_p_gw_eps_bearer_context_information_t * const ctx, const bearer_qos_t * const qos);
+void sgw_ddn_notified (sgw_ddn_ue_t * const ddn);
+void sgw_ddn_reset_ue (const struct in_addr ue_ip);
+void sgw_ddn_remove_ue (const struct in_addr ue_ip);
+
 int sgw_notify_downlink_data(const struct in_addr ue_ip, const ebi_t ebi);
 
 int sgw_handle_s11_downlink_data_notification_ack (const itti_s11_downlink_data_notification_acknowledge_t * const ack);
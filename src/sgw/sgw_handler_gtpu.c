@@ -55,6 +55,9 @@
 #include "gtpv1_u_messages_types.h"
 #include "s11_messages_types.h"
 #include "sgw_context_manager.h"
+#include "sgw_downlink_data_notification.h"
+#include "gtpv1u_dl_buffer.h"
+#include "pgw_pcef_classifier.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -62,74 +65,111 @@ extern "C" {
 
 extern sgw_app_t                        sgw_app;
 
+//------------------------------------------------------------------------------
+// Bearer of the PDN connection carrying the SDF classified by the PCEF, the default bearer if none does.
+static sgw_eps_bearer_ctxt_t *sgw_handle_gtpu_sdf_bearer (sgw_pdn_connection_t * const pdn_connection, const uint32_t sdf_id)
+{
+  if (PCEF_CLASSIFIER_NO_MATCH != sdf_id) {
+    for (int ebix = 0; ebix < BEARERS_PER_UE; ebix++) {
+      sgw_eps_bearer_ctxt_t *eps_bearer_ctxt_p = pdn_connection->sgw_eps_bearers_array[ebix];
+
+      for (int sdfx = 0; (eps_bearer_ctxt_p) && (sdfx < eps_bearer_ctxt_p->num_sdf); sdfx++) {
+        if (eps_bearer_ctxt_p->sdf_id[sdfx] == sdf_id) {
+          return eps_bearer_ctxt_p;
+        }
+      }
+    }
+  }
+  return sgw_cm_get_eps_bearer_entry (pdn_connection, pdn_connection->default_bearer);
+}
+
 //------------------------------------------------------------------------------
 int
 sgw_handle_gtpu_downlink_data_notification (
   const Gtpv1uDownlinkDataNotification * const gtpu_dl_data_notif)
 {
   OAILOG_FUNC_IN(LOG_SPGW_APP);
-  char *imsi_str = NULL;
-  teid_t  s11lteid = INVALID_TEID;
+  s_plus_p_gw_eps_bearer_context_information_t *s_plus_p_gw_eps_bearer_ctxt_info_p = NULL;
+  sgw_ddn_ue_t                                 *ddn = NULL;
   int rc = RETURNerror;
 
 
   // in SGW split key would be S5/S8 teid instead of ue_ip
-  if (RETURNok == (rc = sgw_get_subscriber_id_from_ipv4(&gtpu_dl_data_notif->ue_ip, &imsi_str, &s11lteid))) {
-
-    s_plus_p_gw_eps_bearer_context_information_t *s_plus_p_gw_eps_bearer_ctxt_info_p = NULL;
-    hashtable_rc_t                          hash_rc = HASH_TABLE_OK;
-
-    hash_rc = hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, s11lteid, (void **)&s_plus_p_gw_eps_bearer_ctxt_info_p);
-
-    if (HASH_TABLE_OK == hash_rc) {
-      MessageDef  *message_p = itti_alloc_new_message_sized (TASK_SPGW_APP, S11_DOWNLINK_DATA_NOTIFICATION,
-          sizeof(itti_s11_downlink_data_notification_t));
-
-      if (message_p) {
-        itti_s11_downlink_data_notification_t *s11_downlink_data_notification = S11_DOWNLINK_DATA_NOTIFICATION(message_p);
-
-        // TODO EBI
-        s11_downlink_data_notification->ie_presence_mask |= DOWNLINK_DATA_NOTIFICATION_PR_IE_EPS_BEARER_ID;
-        //s11_downlink_data_notification->ebi = gtpu_dl_data_notif->eps_bearer_id;
-        s11_downlink_data_notification->ebi = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.default_bearer;
-
-        // ARP
-        s11_downlink_data_notification->ie_presence_mask |= DOWNLINK_DATA_NOTIFICATION_PR_IE_ARP;
-        s11_downlink_data_notification->arp.pre_emp_capability = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array[0]->eps_bearer_qos.pci;
-        s11_downlink_data_notification->arp.pre_emp_vulnerability = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array[0]->eps_bearer_qos.pvi;
-        s11_downlink_data_notification->arp.priority_level = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array[0]->eps_bearer_qos.pl;
-
-        // IMSI
-        s11_downlink_data_notification->ie_presence_mask |= DOWNLINK_DATA_NOTIFICATION_PR_IE_IMSI;
-        s11_downlink_data_notification->imsi = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.imsi;
-
-        s11_downlink_data_notification->teid = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.mme_teid_S11;
-
-        //s11_create_bearer_request->trxn = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.trxn;
-        s11_downlink_data_notification->peer_ip.s_addr = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.mme_ip_address_S11.address.ipv4_address.s_addr;
-        s11_downlink_data_notification->local_teid = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.s_gw_teid_S11_S4;
-        OAILOG_DEBUG (LOG_SPGW_APP,
-            "Tx DOWNLINK_DATA_NOTIFICATION -> TASK_S11, S11 MME teid "TEID_FMT" S11 S-GW teid "TEID_FMT"\n",
-            s11_downlink_data_notification->teid,
-            s11_downlink_data_notification->local_teid);
-        rc = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
-        OAILOG_FUNC_RETURN(LOG_SPGW_APP, rc);
-      }
-      OAILOG_FUNC_RETURN(LOG_SPGW_APP, rc);
+  if (RETURNok == sgw_ddn_get_ue (gtpu_dl_data_notif->ue_ip, &ddn, &s_plus_p_gw_eps_bearer_ctxt_info_p)) {
+    sgw_eps_bearer_ctxt_t *eps_bearer_ctxt_p = sgw_handle_gtpu_sdf_bearer (&s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection,
+        gtpu_dl_data_notif->sdf_id);
+
+    if (NULL == eps_bearer_ctxt_p) {
+      OAILOG_DEBUG (LOG_SPGW_APP, "DL Data Notification: No bearer for UE " IN_ADDR_FMT "\n", PRI_IN_ADDR(gtpu_dl_data_notif->ue_ip));
+      OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
     }
-#if DEBUG_IS_ON
-    else {
-      OAILOG_DEBUG (LOG_SPGW_APP, "DL Data Notification: Failed to get EPC Bearer Context Information for UE" IN_ADDR_FMT " IMSI %s\n",
-          PRI_IN_ADDR(gtpu_dl_data_notif->ue_ip), imsi_str);
+
+    // coalesced with the outstanding notification or throttled
+    if (!sgw_ddn_may_notify (ddn, s_plus_p_gw_eps_bearer_ctxt_info_p, &eps_bearer_ctxt_p->eps_bearer_qos)) {
+      OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNok);
     }
-#endif
+
+    MessageDef  *message_p = itti_alloc_new_message_sized (TASK_SPGW_APP, S11_DOWNLINK_DATA_NOTIFICATION,
+        sizeof(itti_s11_downlink_data_notification_t));
+
+    if (message_p) {
+      itti_s11_downlink_data_notification_t *s11_downlink_data_notification = S11_DOWNLINK_DATA_NOTIFICATION(message_p);
+
+      // bearer of the SDF matched by the PCEF classifier, else the default bearer
+      s11_downlink_data_notification->ie_presence_mask |= DOWNLINK_DATA_NOTIFICATION_PR_IE_EPS_BEARER_ID;
+      s11_downlink_data_notification->ebi = eps_bearer_ctxt_p->eps_bearer_id;
+
+      // ARP
+      s11_downlink_data_notification->ie_presence_mask |= DOWNLINK_DATA_NOTIFICATION_PR_IE_ARP;
+      s11_downlink_data_notification->arp.pre_emp_capability = eps_bearer_ctxt_p->eps_bearer_qos.pci;
+      s11_downlink_data_notification->arp.pre_emp_vulnerability = eps_bearer_ctxt_p->eps_bearer_qos.pvi;
+      s11_downlink_data_notification->arp.priority_level = eps_bearer_ctxt_p->eps_bearer_qos.pl;
+
+      // IMSI
+      s11_downlink_data_notification->ie_presence_mask |= DOWNLINK_DATA_NOTIFICATION_PR_IE_IMSI;
+      s11_downlink_data_notification->imsi = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.imsi;
+
+      s11_downlink_data_notification->teid = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.mme_teid_S11;
+
+      //s11_create_bearer_request->trxn = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.trxn;
+      s11_downlink_data_notification->peer_ip.s_addr = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.mme_ip_address_S11.address.ipv4_address.s_addr;
+      s11_downlink_data_notification->local_teid = s_plus_p_gw_eps_bearer_ctxt_info_p->sgw_eps_bearer_context_information.s_gw_teid_S11_S4;
+      OAILOG_DEBUG (LOG_SPGW_APP,
+          "Tx DOWNLINK_DATA_NOTIFICATION -> TASK_S11, S11 MME teid "TEID_FMT" S11 S-GW teid "TEID_FMT"\n",
+          s11_downlink_data_notification->teid,
+          s11_downlink_data_notification->local_teid);
+      // retransmissions are left to the S11 stack, the state only guards against new triggers
+      sgw_ddn_notified (ddn);
+      rc = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+      OAILOG_FUNC_RETURN(LOG_SPGW_APP, rc);
+    }
+    OAILOG_FUNC_RETURN(LOG_SPGW_APP, rc);
   } else {
-    OAILOG_NOTICE (LOG_SPGW_APP, "DL Data Notification: Failed to get IMSI from UE IP " IN_ADDR_FMT "\n", PRI_IN_ADDR(gtpu_dl_data_notif->ue_ip));
+    OAILOG_NOTICE (LOG_SPGW_APP, "DL Data Notification: Failed to get EPC Bearer Context Information for UE IP " IN_ADDR_FMT "\n", PRI_IN_ADDR(gtpu_dl_data_notif->ue_ip));
   }
   OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
 }
 
+//------------------------------------------------------------------------------
+int
+sgw_handle_gtpu_tunnel_batch_result (
+  const Gtpv1uTunnelBatchResult * const batch_result)
+{
+  OAILOG_FUNC_IN(LOG_SPGW_APP);
+
+  for (int i = 0; i < batch_result->num_results; i++) {
+    const gtpv1u_tunnel_result_t *result = &batch_result->results[i];
 
+    if (result->status) {
+      OAILOG_ERROR (LOG_SPGW_APP, "ERROR in %s TUNNEL " TEID_FMT " (eNB) <-> (SGW) " TEID_FMT " UE " IN_ADDR_FMT " err=%d\n",
+          (result->is_add) ? "setting up" : "deleting", result->enb_S1u_teid, result->sgw_S1u_teid, PRI_IN_ADDR(result->ue_ip), result->status);
+    } else if (result->is_add) {
+      // deliver what was buffered while the UE was idle, now that the kernel path exists
+      gtpv1u_dl_buffer_flush (result->ue_ip, result->enb_ip, result->enb_S1u_teid);
+    }
+  }
+  OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNok);
+}
 
 #ifdef __cplusplus
 }
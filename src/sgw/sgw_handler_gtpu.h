@@ -36,6 +36,7 @@ extern "C" {
 #endif
 
 int sgw_handle_gtpu_downlink_data_notification (const Gtpv1uDownlinkDataNotification * const gtpu_dl_data_notif);
+int sgw_handle_gtpu_tunnel_batch_result (const Gtpv1uTunnelBatchResult * const batch_result);
 
 #ifdef __cplusplus
 }
@@ -57,9 +57,12 @@
 #include "pgw_pco.h"
 #include "spgw_config.h"
 #include "gtpv1u.h"
+#include "gtpv1u_dl_buffer.h"
+#include "sgw_downlink_data_notification.h"
 #include "pgw_ue_ip_address_alloc.h"
 #include "pgw_pcef_emulation.h"
 #include "sgw_context_manager.h"
+#include "sgw_journal.h"
 #include "pgw_procedures.h"
 #include "async_system.h"
 #include "ip_forward_messages_types.h"
@@ -81,6 +84,16 @@ uint32_t sgw_get_new_s1u_teid (void)
   return g_gtpv1u_teid;
 }
 
+//------------------------------------------------------------------------------
+void sgw_reserve_s1u_teid (const teid_t teid)
+{
+  uint32_t current = __atomic_load_n (&g_gtpv1u_teid, __ATOMIC_RELAXED);
+
+  // restored sessions, next allocated teids start above
+  while ((teid > current) &&
+         !__atomic_compare_exchange_n (&g_gtpv1u_teid, &current, teid, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
 
 //------------------------------------------------------------------------------
 int
@@ -295,6 +308,7 @@ sgw_handle_sgi_endpoint_created (
         memcpy (&eps_bearer_ctxt_p->paa, &resp_pP->paa, sizeof (paa_t));
         memcpy (&create_session_response_p->paa, &resp_pP->paa, sizeof (paa_t));
         sgw_register_paging_paa(new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.s_gw_teid_S11_S4, &resp_pP->paa);
+        sgw_journal_update_session (new_bearer_ctxt_info_p);
       }
 
       {
@@ -690,6 +704,16 @@ sgw_handle_sgi_endpoint_updated (
       if (rv < 0) {
         OAILOG_ERROR (LOG_SPGW_APP, "ERROR in setting up TUNNEL err=%d\n", rv);
       }
+      // the kernel tunnels are programmed asynchronously, their buffered packets are delivered on completion
+      // (sgw_handle_gtpu_tunnel_batch_result)
+#if ! ENABLE_LIBGTPNL
+      else {
+        // deliver what was buffered while the UE was idle, before the kernel path takes over
+        gtpv1u_dl_buffer_flush (ue, enb, eps_bearer_ctxt_p->enb_teid_S1u);
+      }
+#endif
+      // UE reachable again, paging (if any) is over
+      sgw_ddn_reset_ue (ue);
 
 #if ENABLE_LIBGTPNL
       bstring marking_command = bformat(
@@ -708,6 +732,7 @@ sgw_handle_sgi_endpoint_updated (
           eps_bearer_ctxt_p->num_sdf += 1;
         }
       }
+      sgw_journal_update_session (new_bearer_ctxt_info_p);
     }
 
     MSC_LOG_TX_MESSAGE (MSC_SP_GWAPP_MME, MSC_S11_MME, NULL, 0, "0 S11_MODIFY_BEARER_RESPONSE ebi %u  trxn %u",
@@ -1026,6 +1051,8 @@ sgw_handle_delete_session_request (
         sgi_delete_end_point_request.pdn_type = ctx_p->sgw_eps_bearer_context_information.saved_message.pdn_type;
         memcpy (&sgi_delete_end_point_request.paa, &eps_bearer_ctxt_p->paa, sizeof (paa_t));
 
+        gtpv1u_dl_buffer_stop (eps_bearer_ctxt_p->paa.ipv4_address);
+        sgw_ddn_remove_ue (eps_bearer_ctxt_p->paa.ipv4_address);
         sgw_handle_sgi_endpoint_deleted (&sgi_delete_end_point_request);
       } else {
         OAILOG_WARNING (LOG_SPGW_APP, "Can't find eps_bearer_entry for MME TEID "TEID_FMT" lbi %u\n", delete_session_req_pP->teid, delete_session_req_pP->lbi);
@@ -1035,6 +1062,7 @@ sgw_handle_delete_session_request (
        * Remove eps bearer context, S11 bearer context and s11 tunnel
        */
 
+      sgw_journal_remove_session (delete_session_req_pP->teid);
       sgw_cm_remove_bearer_context_information(delete_session_req_pP->teid);
       sgw_cm_remove_s11_tunnel(delete_session_req_pP->teid);
     }
@@ -1123,8 +1151,8 @@ sgw_handle_release_access_bearers_request (
       sgw_eps_bearer_ctxt_t * eps_bearer_ctxt = ctx_p->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array[ebx];
       if (eps_bearer_ctxt) {
 #if ENABLE_LIBGTPNL
-        rv = gtp_tunnel_ops->del_tunnel(ue, enb, INVALID_TEID, eps_bearer_ctxt->enb_teid_S1u,
-            eps_bearer_ctxt->eps_bearer_id);
+        rv = gtp_tunnel_ops->del_tunnel(eps_bearer_ctxt->paa.ipv4_address, eps_bearer_ctxt->s_gw_teid_S1u_S12_S4_up,
+            eps_bearer_ctxt->enb_teid_S1u);
 #elif ENABLE_OPENFLOW
         for (int sdfx = 0; sdfx < eps_bearer_ctxt->num_sdf; sdfx++) {
           rv = gtp_tunnel_ops->del_tunnel(eps_bearer_ctxt->paa.ipv4_address, INVALID_TEID,
@@ -1137,8 +1165,14 @@ sgw_handle_release_access_bearers_request (
         sgw_release_all_enb_related_information(eps_bearer_ctxt);
       }
     }
-    // TODO The S-GW starts buffering downlink packets received for the UE
-    // (set target on GTPUSP to order the buffering)
+    // The S-GW starts buffering downlink packets received for the UE
+    sgw_eps_bearer_ctxt_t * default_bearer_ctxt = sgw_cm_get_eps_bearer_entry (&ctx_p->sgw_eps_bearer_context_information.pdn_connection,
+        ctx_p->sgw_eps_bearer_context_information.pdn_connection.default_bearer);
+    if (default_bearer_ctxt) {
+      sgw_ddn_reset_ue (default_bearer_ctxt->paa.ipv4_address);
+      gtpv1u_dl_buffer_start (default_bearer_ctxt->paa.ipv4_address, default_bearer_ctxt->eps_bearer_id, &default_bearer_ctxt->eps_bearer_qos);
+    }
+    sgw_journal_update_session (ctx_p);
     MSC_LOG_TX_MESSAGE (MSC_SP_GWAPP_MME, MSC_S11_MME, NULL, 0, "0 S11_RELEASE_ACCESS_BEARERS_RESPONSE S11 MME teid " TEID_FMT " cause REQUEST_ACCEPTED", release_access_bearers_resp_p->teid);
     rv = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
 
@@ -1330,6 +1364,7 @@ sgw_handle_create_bearer_response (
                 } else {
                   OAILOG_INFO (LOG_SPGW_APP, "Failed to setup EPS bearer id %u\n", eps_bearer_ctxt_p->eps_bearer_id);
                 }
+                sgw_journal_update_session (ctx_p);
                 // Restore
                 sgw_eps_bearer_entry_wrapper = sgw_eps_bearer_entry_wrapper2;
 
@@ -37,6 +37,8 @@
 extern "C" {
 #endif
 
+uint32_t sgw_get_new_s1u_teid (void);
+void sgw_reserve_s1u_teid (const teid_t teid);
 int sgw_handle_create_session_request(const itti_s11_create_session_request_t * const session_req_p);
 int sgw_handle_sgi_endpoint_created  (itti_sgi_create_end_point_response_t   * const resp_p);
 int sgw_handle_sgi_endpoint_updated  (const itti_sgi_update_end_point_response_t   * const resp_p);
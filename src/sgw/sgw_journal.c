@@ -0,0 +1,650 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file sgw_journal.c
+  \brief Session journal of the S/P-GW, replayed at startup to restore the sessions and resynchronize the GTP data plane.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "assertions.h"
+#include "conversions.h"
+#include "hashtable.h"
+#include "common_defs.h"
+#include "log.h"
+#include "sgw_ie_defs.h"
+#include "3gpp_23.401.h"
+#include "sgw_defs.h"
+#include "sgw_handlers.h"
+#include "sgw_context_manager.h"
+#include "sgw.h"
+#include "spgw_config.h"
+#include "gtpv1u.h"
+#include "gtpv1u_dl_buffer.h"
+#include "pgw_ue_ip_address_alloc.h"
+#include "pgw_pcef_emulation.h"
+#include "s11_sgw.h"
+#include "sgw_journal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern sgw_app_t                        sgw_app;
+extern struct gtp_tunnel_ops           *gtp_tunnel_ops;
+
+#define SGW_JOURNAL_MAGIC                 0x4a574753          ///< "SGWJ"
+#define SGW_JOURNAL_VERSION               1
+#define SGW_JOURNAL_COMPACT_MIN_RECORDS   1024                ///< no compaction below this number of records
+
+typedef enum {
+  SGW_JOURNAL_RECORD_SESSION = 1,
+  SGW_JOURNAL_RECORD_TOMBSTONE,
+} sgw_journal_record_type_t;
+
+typedef struct sgw_journal_file_header_s {
+  uint32_t               magic;
+  uint16_t               version;
+  uint16_t               reserved;
+  uint32_t               layout;                 ///< size of sgw_journal_session_t, a file written by another build is discarded
+} sgw_journal_file_header_t;
+
+typedef struct sgw_journal_record_header_s {
+  uint32_t               magic;
+  uint16_t               type;
+  uint16_t               reserved;
+  uint32_t               length;                 ///< payload length
+  uint32_t               checksum;               ///< FNV-1a of the payload
+} sgw_journal_record_header_t;
+
+typedef struct sgw_journal_bearer_s {
+  ebi_t                  ebi;
+  paa_t                  paa;
+  ip_address_t           p_gw_address_in_use_up;
+  teid_t                 p_gw_teid_S5_S8_up;
+  ip_address_t           s_gw_ip_address_S5_S8_up;
+  teid_t                 s_gw_teid_S5_S8_up;
+  ip_address_t           s_gw_ip_address_S1u_S12_S4_up;
+  teid_t                 s_gw_teid_S1u_S12_S4_up;
+  ip_address_t           enb_ip_address_S1u;
+  teid_t                 enb_teid_S1u;
+  bearer_qos_t           eps_bearer_qos;
+  uint8_t                num_sdf;
+  uint32_t               sdf_id[TRAFFIC_FLOW_TEMPLATE_NB_PACKET_FILTERS_MAX];
+} sgw_journal_bearer_t;
+
+/* Payload of a SGW_JOURNAL_RECORD_SESSION record, a tombstone only carries s_gw_teid_S11_S4 */
+typedef struct sgw_journal_session_s {
+  teid_t                 s_gw_teid_S11_S4;
+  teid_t                 mme_teid_S11;
+  ip_address_t           mme_ip_address_S11;
+  imsi_t                 imsi;
+  pdn_type_t             pdn_type;
+  ebi_t                  default_bearer;
+  char                   apn_in_use[ACCESS_POINT_NAME_MAX_LENGTH + 1];
+  uint8_t                nb_bearers;
+  sgw_journal_bearer_t   bearers[BEARERS_PER_UE];
+} sgw_journal_session_t;
+
+static struct {
+  int                    fd;
+  bstring                path;
+  uint32_t               nb_records;             ///< records appended since the last compaction
+  uint32_t               compact_threshold;
+  hash_table_ts_t       *restore_index;          ///< sessions loaded at init, until restored
+} sgw_journal = {.fd = -1};
+
+//------------------------------------------------------------------------------
+static uint32_t sgw_journal_fnv1a (const uint8_t * data, const size_t length)
+{
+  uint32_t hash = 2166136261u;
+
+  for (size_t i = 0; i < length; i++) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+//------------------------------------------------------------------------------
+static int sgw_journal_write (const int fd, const void * const data, const size_t length)
+{
+  const uint8_t *p = (const uint8_t *)data;
+  size_t         remaining = length;
+
+  while (remaining) {
+    ssize_t n = write (fd, p, remaining);
+    if (n < 0) {
+      if (EINTR == errno) continue;
+      return RETURNerror;
+    }
+    p += n;
+    remaining -= n;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int sgw_journal_write_record (const int fd, const sgw_journal_record_type_t type, const void * const payload, const uint32_t length)
+{
+  struct {
+    sgw_journal_record_header_t header;
+    sgw_journal_session_t       session;
+  } record;
+
+  DevAssert (length <= sizeof (record.session));
+  record.header.magic    = SGW_JOURNAL_MAGIC;
+  record.header.type     = type;
+  record.header.reserved = 0;
+  record.header.length   = length;
+  record.header.checksum = sgw_journal_fnv1a ((const uint8_t *)payload, length);
+  memcpy (&record.session, payload, length);
+  // one write per record, a crash leaves at most a torn record at the end of the file
+  return sgw_journal_write (fd, &record, sizeof (record.header) + length);
+}
+
+//------------------------------------------------------------------------------
+// A session is journaled once the create session procedure has allocated its UE address
+static bool sgw_journal_encode_session (const s_plus_p_gw_eps_bearer_context_information_t * const ctx, sgw_journal_session_t * const session)
+{
+  const sgw_eps_bearer_context_information_t *sgw_ctx = &ctx->sgw_eps_bearer_context_information;
+  const sgw_eps_bearer_ctxt_t                *default_bearer = NULL;
+
+  if ((sgw_ctx->pdn_connection.default_bearer >= EPS_BEARER_IDENTITY_FIRST) && (sgw_ctx->pdn_connection.default_bearer <= EPS_BEARER_IDENTITY_LAST)) {
+    default_bearer = sgw_ctx->pdn_connection.sgw_eps_bearers_array[EBI_TO_INDEX(sgw_ctx->pdn_connection.default_bearer)];
+  }
+  if ((!default_bearer) || (!default_bearer->paa.ipv4_address.s_addr)) {
+    return false;
+  }
+
+  memset (session, 0, sizeof (*session));
+  session->s_gw_teid_S11_S4   = sgw_ctx->s_gw_teid_S11_S4;
+  session->mme_teid_S11       = sgw_ctx->mme_teid_S11;
+  session->mme_ip_address_S11 = sgw_ctx->mme_ip_address_S11;
+  session->imsi               = sgw_ctx->imsi;
+  session->pdn_type           = sgw_ctx->saved_message.pdn_type;
+  session->default_bearer     = sgw_ctx->pdn_connection.default_bearer;
+  if (sgw_ctx->pdn_connection.apn_in_use) {
+    strncpy (session->apn_in_use, sgw_ctx->pdn_connection.apn_in_use, ACCESS_POINT_NAME_MAX_LENGTH);
+  }
+  for (int ebix = 0; ebix < BEARERS_PER_UE; ebix++) {
+    const sgw_eps_bearer_ctxt_t *bearer = sgw_ctx->pdn_connection.sgw_eps_bearers_array[ebix];
+    sgw_journal_bearer_t        *out = &session->bearers[session->nb_bearers];
+
+    if (!bearer) {
+      continue;
+    }
+    out->ebi                           = bearer->eps_bearer_id;
+    out->paa                           = bearer->paa;
+    out->p_gw_address_in_use_up        = bearer->p_gw_address_in_use_up;
+    out->p_gw_teid_S5_S8_up            = bearer->p_gw_teid_S5_S8_up;
+    out->s_gw_ip_address_S5_S8_up      = bearer->s_gw_ip_address_S5_S8_up;
+    out->s_gw_teid_S5_S8_up            = bearer->s_gw_teid_S5_S8_up;
+    out->s_gw_ip_address_S1u_S12_S4_up = bearer->s_gw_ip_address_S1u_S12_S4_up;
+    out->s_gw_teid_S1u_S12_S4_up       = bearer->s_gw_teid_S1u_S12_S4_up;
+    out->enb_ip_address_S1u            = bearer->enb_ip_address_S1u;
+    out->enb_teid_S1u                  = bearer->enb_teid_S1u;
+    out->eps_bearer_qos                = bearer->eps_bearer_qos;
+    out->num_sdf                       = bearer->num_sdf;
+    memcpy (out->sdf_id, bearer->sdf_id, sizeof (out->sdf_id));
+    session->nb_bearers += 1;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static bool sgw_journal_write_session_cb (const hash_key_t key, void * const element, void * parameter, void ** result)
+{
+  sgw_journal_session_t  session;
+  int                   *nb_sessions = (int *)result;
+
+  if (sgw_journal_encode_session ((const s_plus_p_gw_eps_bearer_context_information_t *)element, &session)) {
+    if (RETURNok != sgw_journal_write_record (*(int *)parameter, SGW_JOURNAL_RECORD_SESSION, &session, sizeof (session))) {
+      *nb_sessions = -1;
+      return true;
+    }
+    *nb_sessions += 1;
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Rewrite the journal with one record per session, the new file replaces the old one atomically
+static int sgw_journal_compact (void)
+{
+  bstring                   tmp_path = bformat ("%s.tmp", bdata (sgw_journal.path));
+  sgw_journal_file_header_t header = {.magic = SGW_JOURNAL_MAGIC, .version = SGW_JOURNAL_VERSION, .layout = sizeof (sgw_journal_session_t)};
+  int                       nb_sessions = 0;
+  int                       fd = open ((const char *)tmp_path->data, O_CREAT | O_TRUNC | O_WRONLY, S_IRUSR | S_IWUSR);
+
+  if (fd < 0) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Cannot create session journal %s: %s\n", bdata (tmp_path), strerror (errno));
+    bdestroy_wrapper (&tmp_path);
+    return RETURNerror;
+  }
+  if (RETURNok == sgw_journal_write (fd, &header, sizeof (header))) {
+    hashtable_ts_apply_callback_on_elements (sgw_app.s11_bearer_context_information_hashtable, sgw_journal_write_session_cb, &fd, (void **)&nb_sessions);
+  } else {
+    nb_sessions = -1;
+  }
+  if ((0 > nb_sessions) || (fdatasync (fd)) || (close (fd)) || (rename ((const char *)tmp_path->data, (const char *)sgw_journal.path->data))) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Cannot write session journal %s: %s\n", bdata (tmp_path), strerror (errno));
+    unlink ((const char *)tmp_path->data);
+    bdestroy_wrapper (&tmp_path);
+    return RETURNerror;
+  }
+  bdestroy_wrapper (&tmp_path);
+
+  if (0 <= sgw_journal.fd) {
+    close (sgw_journal.fd);
+  }
+  sgw_journal.fd = open ((const char *)sgw_journal.path->data, O_WRONLY | O_APPEND);
+  if (0 > sgw_journal.fd) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Cannot open session journal %s: %s\n", bdata (sgw_journal.path), strerror (errno));
+    return RETURNerror;
+  }
+  sgw_journal.nb_records = nb_sessions;
+  sgw_journal.compact_threshold = 4 * nb_sessions + SGW_JOURNAL_COMPACT_MIN_RECORDS;
+  OAILOG_DEBUG (LOG_SPGW_APP, "Compacted session journal %s: %d session(s)\n", bdata (sgw_journal.path), nb_sessions);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void sgw_journal_append (const sgw_journal_record_type_t type, const void * const payload, const uint32_t length)
+{
+  if (0 > sgw_journal.fd) {
+    return;
+  }
+  if (RETURNok != sgw_journal_write_record (sgw_journal.fd, type, payload, length)) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Cannot append to session journal %s: %s\n", bdata (sgw_journal.path), strerror (errno));
+    return;
+  }
+  sgw_journal.nb_records += 1;
+  if (sgw_journal.nb_records > sgw_journal.compact_threshold) {
+    sgw_journal_compact ();
+  }
+}
+
+//------------------------------------------------------------------------------
+void sgw_journal_update_session (const s_plus_p_gw_eps_bearer_context_information_t * const ctx)
+{
+  sgw_journal_session_t session;
+
+  if ((0 <= sgw_journal.fd) && (ctx) && (sgw_journal_encode_session (ctx, &session))) {
+    sgw_journal_append (SGW_JOURNAL_RECORD_SESSION, &session, sizeof (session));
+  }
+}
+
+//------------------------------------------------------------------------------
+void sgw_journal_remove_session (const teid_t s_gw_teid_s11_s4)
+{
+  sgw_journal_append (SGW_JOURNAL_RECORD_TOMBSTONE, &s_gw_teid_s11_s4, sizeof (s_gw_teid_s11_s4));
+}
+
+//------------------------------------------------------------------------------
+// Latest record of each session, indexed by S-GW S11 teid
+static int sgw_journal_load (hash_table_ts_t * const index)
+{
+  sgw_journal_file_header_t  *header = NULL;
+  uint8_t                    *buffer = NULL;
+  struct stat                 st = {0};
+  size_t                      offset = 0;
+  int                         fd = open ((const char *)sgw_journal.path->data, O_RDONLY);
+
+  if (0 > fd) {
+    if (ENOENT == errno) {
+      return RETURNok;
+    }
+    OAILOG_ERROR (LOG_SPGW_APP, "Cannot open session journal %s: %s\n", bdata (sgw_journal.path), strerror (errno));
+    return RETURNerror;
+  }
+  if ((fstat (fd, &st)) || (!st.st_size)) {
+    close (fd);
+    return RETURNok;
+  }
+  buffer = malloc (st.st_size);
+  AssertFatal (buffer, "Out of memory");
+  while (offset < (size_t)st.st_size) {
+    ssize_t n = read (fd, buffer + offset, st.st_size - offset);
+    if ((0 > n) && (EINTR == errno)) continue;
+    if (0 >= n) break;
+    offset += n;
+  }
+  close (fd);
+
+  header = (sgw_journal_file_header_t *)buffer;
+  if ((offset < sizeof (*header)) || (SGW_JOURNAL_MAGIC != header->magic) || (SGW_JOURNAL_VERSION != header->version) ||
+      (sizeof (sgw_journal_session_t) != header->layout)) {
+    OAILOG_WARNING (LOG_SPGW_APP, "Session journal %s written by another version, discarded\n", bdata (sgw_journal.path));
+    free_wrapper ((void**)&buffer);
+    return RETURNok;
+  }
+
+  size_t size = offset;
+  offset = sizeof (*header);
+  while (offset + sizeof (sgw_journal_record_header_t) <= size) {
+    const sgw_journal_record_header_t *record = (const sgw_journal_record_header_t *)(buffer + offset);
+    const uint8_t                     *payload = buffer + offset + sizeof (*record);
+
+    if ((SGW_JOURNAL_MAGIC != record->magic) || (record->length > size - offset - sizeof (*record)) ||
+        (record->checksum != sgw_journal_fnv1a (payload, record->length))) {
+      break;
+    }
+    if ((SGW_JOURNAL_RECORD_SESSION == record->type) && (sizeof (sgw_journal_session_t) == record->length)) {
+      sgw_journal_session_t *session = malloc (sizeof (*session));
+      AssertFatal (session, "Out of memory");
+      memcpy (session, payload, sizeof (*session));
+      hashtable_ts_insert (index, (hash_key_t)session->s_gw_teid_S11_S4, session);
+    } else if ((SGW_JOURNAL_RECORD_TOMBSTONE == record->type) && (sizeof (teid_t) == record->length)) {
+      teid_t teid = 0;
+      memcpy (&teid, payload, sizeof (teid));
+      hashtable_ts_free (index, (hash_key_t)teid);
+    }
+    offset += sizeof (*record) + record->length;
+  }
+  if (offset < size) {
+    OAILOG_WARNING (LOG_SPGW_APP, "Session journal %s: %zu trailing bytes discarded (torn or corrupted record)\n", bdata (sgw_journal.path), size - offset);
+  }
+  free_wrapper ((void**)&buffer);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static bool sgw_journal_restore_session_cb (const hash_key_t key, void * const element, void * parameter, void ** result)
+{
+  const sgw_journal_session_t                  *session = (const sgw_journal_session_t *)element;
+  s_plus_p_gw_eps_bearer_context_information_t *ctx = NULL;
+  sgw_eps_bearer_context_information_t         *sgw_ctx = NULL;
+  mme_sgw_tunnel_t                             *tunnel = NULL;
+  int                                          *nb_restored = (int *)result;
+  char                                          imsi[IMSI_BCD_DIGITS_MAX + 1] = {0};
+  struct in_addr                                ue = {.s_addr = 0};
+
+  IMSI_TO_STRING (&session->imsi, imsi, IMSI_BCD_DIGITS_MAX + 1);
+  for (int i = 0; i < session->nb_bearers; i++) {
+    if (session->bearers[i].ebi == session->default_bearer) {
+      ue = session->bearers[i].paa.ipv4_address;
+    }
+  }
+  if ((!ue.s_addr) || (RETURNok != reserve_ue_ipv4_address (imsi, &ue))) {
+    OAILOG_WARNING (LOG_SPGW_APP, "Session IMSI %s S11 teid " TEID_FMT " not restored: UE address " IN_ADDR_FMT " not available\n",
+        imsi, session->s_gw_teid_S11_S4, PRI_IN_ADDR (ue));
+    return false;
+  }
+
+  tunnel = sgw_cm_create_s11_tunnel (session->mme_teid_S11, session->s_gw_teid_S11_S4);
+  ctx = sgw_cm_create_bearer_context_information_in_collection (session->s_gw_teid_S11_S4);
+  if ((!tunnel) || (!ctx)) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Session IMSI %s S11 teid " TEID_FMT " not restored\n", imsi, session->s_gw_teid_S11_S4);
+    release_ue_ipv4_address (imsi, &ue);
+    return false;
+  }
+  sgw_ctx = &ctx->sgw_eps_bearer_context_information;
+  sgw_ctx->imsi                                                        = session->imsi;
+  ctx->pgw_eps_bearer_context_information.imsi                         = session->imsi;
+  sgw_ctx->imsi_unauthenticated_indicator                              = 1;
+  ctx->pgw_eps_bearer_context_information.imsi_unauthenticated_indicator = 1;
+  sgw_ctx->mme_teid_S11                                                = session->mme_teid_S11;
+  sgw_ctx->mme_ip_address_S11                                          = session->mme_ip_address_S11;
+  sgw_ctx->s_gw_teid_S11_S4                                            = session->s_gw_teid_S11_S4;
+  sgw_ctx->saved_message.pdn_type                                      = session->pdn_type;
+  sgw_ctx->pdn_connection.apn_in_use                                   = strdup (session->apn_in_use);
+  sgw_ctx->pdn_connection.default_bearer                               = session->default_bearer;
+
+  for (int i = 0; i < session->nb_bearers; i++) {
+    const sgw_journal_bearer_t *in = &session->bearers[i];
+    sgw_eps_bearer_ctxt_t      *bearer = sgw_cm_create_eps_bearer_ctxt_in_collection (&sgw_ctx->pdn_connection, in->ebi);
+
+    if (!bearer) {
+      continue;
+    }
+    bearer->paa                           = in->paa;
+    bearer->p_gw_address_in_use_up        = in->p_gw_address_in_use_up;
+    bearer->p_gw_teid_S5_S8_up            = in->p_gw_teid_S5_S8_up;
+    bearer->s_gw_ip_address_S5_S8_up      = in->s_gw_ip_address_S5_S8_up;
+    bearer->s_gw_teid_S5_S8_up            = in->s_gw_teid_S5_S8_up;
+    bearer->s_gw_ip_address_S1u_S12_S4_up = in->s_gw_ip_address_S1u_S12_S4_up;
+    bearer->s_gw_teid_S1u_S12_S4_up       = in->s_gw_teid_S1u_S12_S4_up;
+    bearer->enb_ip_address_S1u            = in->enb_ip_address_S1u;
+    bearer->enb_teid_S1u                  = in->enb_teid_S1u;
+    bearer->eps_bearer_qos                = in->eps_bearer_qos;
+    bearer->num_sdf                       = in->num_sdf;
+    memcpy (bearer->sdf_id, in->sdf_id, sizeof (bearer->sdf_id));
+    sgw_reserve_s1u_teid (in->s_gw_teid_S1u_S12_S4_up);
+  }
+  sgw_reserve_S11_tunnel_id (session->s_gw_teid_S11_S4);
+  sgw_register_paging_paa (session->s_gw_teid_S11_S4, &sgw_ctx->pdn_connection.sgw_eps_bearers_array[EBI_TO_INDEX(session->default_bearer)]->paa);
+  s11_sgw_restore_tunnel (session->s_gw_teid_S11_S4, session->mme_ip_address_S11.address.ipv4_address);
+  *nb_restored += 1;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Data plane resynchronization: tunnels the restored sessions need, and tunnels found in the data plane
+typedef struct sgw_journal_tunnel_s {
+  const s_plus_p_gw_eps_bearer_context_information_t *ctx;
+  const sgw_eps_bearer_ctxt_t                        *bearer;
+  bool                                                in_data_plane;
+} sgw_journal_tunnel_t;
+
+typedef struct sgw_journal_resync_s {
+  sgw_journal_tunnel_t  *tunnels;                 ///< sorted by S-GW S1-U teid
+  int                    nb_tunnels;
+  int                    size;
+  struct {
+    struct in_addr       ue;
+    uint32_t             i_tei;
+    uint32_t             o_tei;
+  }                     *stale;
+  int                    nb_stale;
+  int                    size_stale;
+} sgw_journal_resync_t;
+
+//------------------------------------------------------------------------------
+static int sgw_journal_tunnel_cmp (const void * a, const void * b)
+{
+  const teid_t teid_a = ((const sgw_journal_tunnel_t *)a)->bearer->s_gw_teid_S1u_S12_S4_up;
+  const teid_t teid_b = ((const sgw_journal_tunnel_t *)b)->bearer->s_gw_teid_S1u_S12_S4_up;
+
+  return (teid_a > teid_b) - (teid_a < teid_b);
+}
+
+//------------------------------------------------------------------------------
+static bool sgw_journal_collect_tunnels_cb (const hash_key_t key, void * const element, void * parameter, void ** result)
+{
+  const s_plus_p_gw_eps_bearer_context_information_t *ctx = (const s_plus_p_gw_eps_bearer_context_information_t *)element;
+  sgw_journal_resync_t                               *resync = (sgw_journal_resync_t *)parameter;
+
+  for (int ebix = 0; ebix < BEARERS_PER_UE; ebix++) {
+    const sgw_eps_bearer_ctxt_t *bearer = ctx->sgw_eps_bearer_context_information.pdn_connection.sgw_eps_bearers_array[ebix];
+
+    if (bearer) {
+      // UEs in ECM-IDLE have no S1-U tunnel
+      if ((INVALID_TEID == bearer->enb_teid_S1u) || (!bearer->enb_teid_S1u) || (!bearer->enb_ip_address_S1u.address.ipv4_address.s_addr)) {
+        if (bearer->eps_bearer_id == ctx->sgw_eps_bearer_context_information.pdn_connection.default_bearer) {
+          gtpv1u_dl_buffer_start (bearer->paa.ipv4_address, bearer->eps_bearer_id, &bearer->eps_bearer_qos);
+        }
+        continue;
+      }
+      if (resync->nb_tunnels == resync->size) {
+        resync->size = (resync->size) ? 2 * resync->size : 1024;
+        resync->tunnels = realloc (resync->tunnels, resync->size * sizeof (sgw_journal_tunnel_t));
+        AssertFatal (resync->tunnels, "Out of memory");
+      }
+      resync->tunnels[resync->nb_tunnels].ctx           = ctx;
+      resync->tunnels[resync->nb_tunnels].bearer        = bearer;
+      resync->tunnels[resync->nb_tunnels].in_data_plane = false;
+      resync->nb_tunnels += 1;
+    }
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static void sgw_journal_data_plane_tunnel_cb (struct in_addr ue, struct in_addr enb, uint32_t i_tei, uint32_t o_tei, void *arg)
+{
+  sgw_journal_resync_t  *resync = (sgw_journal_resync_t *)arg;
+  sgw_eps_bearer_ctxt_t  key_bearer = {.s_gw_teid_S1u_S12_S4_up = i_tei};
+  sgw_journal_tunnel_t   key = {.bearer = &key_bearer};
+  sgw_journal_tunnel_t  *tunnel = bsearch (&key, resync->tunnels, resync->nb_tunnels, sizeof (sgw_journal_tunnel_t), sgw_journal_tunnel_cmp);
+
+  if ((tunnel) && (tunnel->bearer->enb_teid_S1u == o_tei) &&
+      (tunnel->bearer->paa.ipv4_address.s_addr == ue.s_addr) &&
+      (tunnel->bearer->enb_ip_address_S1u.address.ipv4_address.s_addr == enb.s_addr)) {
+    tunnel->in_data_plane = true;
+    return;
+  }
+  // removed once the dump is over, the netlink socket is busy until then
+  if (resync->nb_stale == resync->size_stale) {
+    resync->size_stale = (resync->size_stale) ? 2 * resync->size_stale : 64;
+    resync->stale = realloc (resync->stale, resync->size_stale * sizeof (*resync->stale));
+    AssertFatal (resync->stale, "Out of memory");
+  }
+  resync->stale[resync->nb_stale].ue    = ue;
+  resync->stale[resync->nb_stale].i_tei = i_tei;
+  resync->stale[resync->nb_stale].o_tei = o_tei;
+  resync->nb_stale += 1;
+}
+
+//------------------------------------------------------------------------------
+static void sgw_journal_resync_data_plane (void)
+{
+  sgw_journal_resync_t  resync = {0};
+  int                   nb_added = 0;
+  int                   rv = RETURNok;
+
+  hashtable_ts_apply_callback_on_elements (sgw_app.s11_bearer_context_information_hashtable, sgw_journal_collect_tunnels_cb, &resync, NULL);
+  qsort (resync.tunnels, resync.nb_tunnels, sizeof (sgw_journal_tunnel_t), sgw_journal_tunnel_cmp);
+
+  if ((gtp_tunnel_ops->list_tunnels) && (RETURNok != gtp_tunnel_ops->list_tunnels (sgw_journal_data_plane_tunnel_cb, &resync))) {
+    OAILOG_WARNING (LOG_SPGW_APP, "Cannot dump the GTP data plane, all the tunnels of the restored sessions are added\n");
+  }
+
+  for (int i = 0; i < resync.nb_stale; i++) {
+#if ENABLE_LIBGTPNL
+    rv = gtp_tunnel_ops->del_tunnel (resync.stale[i].ue, resync.stale[i].i_tei, resync.stale[i].o_tei);
+#endif
+    if (rv < 0) {
+      OAILOG_ERROR (LOG_SPGW_APP, "ERROR in deleting stale TUNNEL " TEID_FMT " (eNB) <-> (SGW) " TEID_FMT "\n", resync.stale[i].o_tei, resync.stale[i].i_tei);
+    }
+  }
+
+  for (int i = 0; i < resync.nb_tunnels; i++) {
+    const sgw_eps_bearer_ctxt_t *bearer = resync.tunnels[i].bearer;
+    struct in_addr               enb = bearer->enb_ip_address_S1u.address.ipv4_address;
+
+    if (resync.tunnels[i].in_data_plane) {
+      continue;
+    }
+    // the iptables marking rules of the bearers are not owned by the process, they survived the restart
+#if ENABLE_LIBGTPNL
+    rv = gtp_tunnel_ops->add_tunnel (bearer->paa.ipv4_address, enb, bearer->s_gw_teid_S1u_S12_S4_up, bearer->enb_teid_S1u, bearer->eps_bearer_id);
+#elif ENABLE_OPENFLOW
+    for (int sdfx = 0; sdfx < bearer->num_sdf; sdfx++) {
+      rv = gtp_tunnel_ops->add_tunnel (bearer->paa.ipv4_address, enb, bearer->s_gw_teid_S1u_S12_S4_up, bearer->enb_teid_S1u, bearer->eps_bearer_id,
+          resync.tunnels[i].ctx->sgw_eps_bearer_context_information.imsi, pgw_pcef_get_rule_by_id (bearer->sdf_id[sdfx]));
+    }
+#endif
+    if (rv < 0) {
+      OAILOG_ERROR (LOG_SPGW_APP, "ERROR in setting up TUNNEL " TEID_FMT " (eNB) <-> (SGW) " TEID_FMT " err=%d\n", bearer->enb_teid_S1u, bearer->s_gw_teid_S1u_S12_S4_up, rv);
+    } else {
+      nb_added += 1;
+    }
+  }
+  OAILOG_NOTICE (LOG_SPGW_APP, "GTP data plane resynchronized: %d tunnel(s) kept, %d added, %d stale removed\n",
+      resync.nb_tunnels - nb_added, nb_added, resync.nb_stale);
+  free_wrapper ((void**)&resync.tunnels);
+  free_wrapper ((void**)&resync.stale);
+}
+
+//------------------------------------------------------------------------------
+int sgw_journal_init (const spgw_config_t * const spgw_config)
+{
+  if (!spgw_config->sgw_config.session_journal.enabled) {
+    return RETURNok;
+  }
+  OAILOG_DEBUG (LOG_SPGW_APP, "Initializing session journal\n");
+  sgw_journal.path = bstrcpy (spgw_config->sgw_config.session_journal.file);
+
+  bstring b = bfromcstr ("sgw_journal_index");
+  sgw_journal.restore_index = hashtable_ts_create (512, NULL, NULL, b);
+  bdestroy_wrapper (&b);
+  if (!sgw_journal.restore_index) {
+    OAILOG_ALERT (LOG_SPGW_APP, "Initializing session journal: ERROR\n");
+    return RETURNerror;
+  }
+  if (RETURNok != sgw_journal_load (sgw_journal.restore_index)) {
+    hashtable_ts_destroy (sgw_journal.restore_index);
+    sgw_journal.restore_index = NULL;
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+// The completions of the tunnel programming are sent to the SPGW application task, it must be ready
+void sgw_journal_restore (void)
+{
+  int               nb_restored = 0;
+
+  if (!sgw_journal.restore_index) {
+    return;
+  }
+  hashtable_ts_apply_callback_on_elements (sgw_journal.restore_index, sgw_journal_restore_session_cb, NULL, (void **)&nb_restored);
+  hashtable_ts_destroy (sgw_journal.restore_index);
+  sgw_journal.restore_index = NULL;
+  OAILOG_NOTICE (LOG_SPGW_APP, "Restored %d session(s) from journal %s\n", nb_restored, bdata (sgw_journal.path));
+
+  if (nb_restored) {
+    sgw_journal_resync_data_plane ();
+  }
+  // on failure the sessions are not journaled anymore
+  sgw_journal_compact ();
+}
+
+//------------------------------------------------------------------------------
+void sgw_journal_exit (void)
+{
+  if (sgw_journal.restore_index) {
+    hashtable_ts_destroy (sgw_journal.restore_index);
+    sgw_journal.restore_index = NULL;
+  }
+  if (0 <= sgw_journal.fd) {
+    close (sgw_journal.fd);
+    sgw_journal.fd = -1;
+  }
+  bdestroy_wrapper (&sgw_journal.path);
+}
+
+#ifdef __cplusplus
+}
+#endif
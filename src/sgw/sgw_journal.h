@@ -0,0 +1,54 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file sgw_journal.h
+  \brief Session journal of the S/P-GW, replayed at startup to restore the sessions and resynchronize the GTP data plane.
+  \ Every established session (IMSI, S11 TEIDs, UE address, APN, S1-U and S5/S8 tunnels of its bearers) is appended to
+  \ a file by the SPGW application task each time it changes, a tombstone is appended when it is deleted. At startup
+  \ the latest record of each session is restored into the S-GW collections, the UE addresses and TEIDs are taken back
+  \ from the allocators, and the GTP tunnels of the connected UEs are reconciled with the data plane content: only the
+  \ missing tunnels are added and only the stale ones are removed.
+*/
+#ifndef FILE_SGW_JOURNAL_SEEN
+#define FILE_SGW_JOURNAL_SEEN
+
+#include "common_types.h"
+#include "spgw_config.h"
+#include "sgw_context_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Load the journal; nothing done if the journal is disabled */
+int  sgw_journal_init (const spgw_config_t * const spgw_config);
+/* Restore the loaded sessions and resynchronize the GTP tunnels, run by the SPGW application task once ready */
+void sgw_journal_restore (void);
+void sgw_journal_exit (void);
+
+/* Called by the SPGW application task when a session is established or modified, and when it is deleted */
+void sgw_journal_update_session (const s_plus_p_gw_eps_bearer_context_information_t * const ctx);
+void sgw_journal_remove_session (const teid_t s_gw_teid_s11_s4);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* FILE_SGW_JOURNAL_SEEN */
@@ -48,6 +48,7 @@
 #include "common_defs.h"
 #include "intertask_interface.h"
 #include "itti_free_defined_msg.h"
+#include "timer.h"
 #include "sgw_ie_defs.h"
 #include "3gpp_23.401.h"
 #include "sgw_defs.h"
@@ -58,9 +59,12 @@
 #include "spgw_config.h"
 #include "pgw_ue_ip_address_alloc.h"
 #include "pgw_pcef_emulation.h"
+#include "sgw_journal.h"
 #include "gtpv1_u_messages_types.h"
 #include "s11_messages_types.h"
 #include "async_system.h"
+#include "async_system_messages_types.h"
+#include "sgw_downlink_data_notification.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -78,6 +82,15 @@ static void sgw_exit(void);
 static void *sgw_intertask_interface (void *args_p)
 {
   itti_mark_task_ready (TASK_SPGW_APP);
+  // before any S11 message is processed, the data plane results of the restoration are sent to this task
+  sgw_journal_restore ();
+  if (spgw_config.sgw_config.itti_config.thread_stats_period_sec) {
+    long                                    timer_id = 0;
+
+    if (timer_setup (spgw_config.sgw_config.itti_config.thread_stats_period_sec, 0, TASK_SPGW_APP, INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &timer_id)) {
+      OAILOG_WARNING (LOG_SPGW_APP, "Could not start the ITTI thread statistics timer\n");
+    }
+  }
 
   while (1) {
     MessageDef                             *received_message_p = NULL;
@@ -96,6 +109,11 @@ static void *sgw_intertask_interface (void *args_p)
       }
       break;
 
+    case GTPV1U_TUNNEL_BATCH_RESULT:{
+        sgw_handle_gtpu_tunnel_batch_result (GTPV1U_TUNNEL_BATCH_RESULT(received_message_p));
+      }
+      break;
+
     case S11_DOWNLINK_DATA_NOTIFICATION_ACKNOWLEDGE:{
       sgw_handle_s11_downlink_data_notification_ack (S11_DOWNLINK_DATA_NOTIFICATION_ACKNOWLEDGE(received_message_p));
     }
@@ -183,6 +201,20 @@ static void *sgw_intertask_interface (void *args_p)
       }
       break;
 
+    case ASYNC_SYSTEM_COMMAND_RESULT:{
+        if (ASYNC_SYSTEM_COMMAND_RESULT (received_message_p)->exit_status) {
+          OAILOG_WARNING (LOG_SPGW_APP, "System command %s returned %d\n", bdata(ASYNC_SYSTEM_COMMAND_RESULT (received_message_p)->system_command),
+              ASYNC_SYSTEM_COMMAND_RESULT (received_message_p)->exit_status);
+        }
+      }
+      break;
+
+    case TIMER_HAS_EXPIRED:{
+        // only the thread statistics timer is started by this task
+        itti_print_thread_stats ();
+      }
+      break;
+
     case TERMINATE_MESSAGE:{
         sgw_exit();
         itti_exit_task ();
@@ -215,6 +247,11 @@ int sgw_init (spgw_config_t *spgw_config_pP)
 
   pgw_ip_address_pool_init (); 
 
+  if (RETURNok != sgw_ddn_init ()) {
+    OAILOG_ALERT (LOG_SPGW_APP, "Initializing SPGW-APP task interface: ERROR\n");
+    return RETURNerror;
+  }
+
   bstring b = bfromcstr("sgw_s11teid2mme_hashtable");
   sgw_app.s11teid2mme_hashtable = hashtable_ts_create (512, NULL, NULL, b);
   btrunc(b, 0);
@@ -271,6 +308,12 @@ int sgw_init (spgw_config_t *spgw_config_pP)
   }
 #endif
 
+  // sessions of a previous run, restored by the task
+  if (RETURNerror == sgw_journal_init (spgw_config_pP)) {
+    OAILOG_ALERT (LOG_SPGW_APP, "Initializing session journal: ERROR\n");
+    return RETURNerror;
+  }
+
   if (itti_create_task (TASK_SPGW_APP, &sgw_intertask_interface, NULL) < 0) {
     perror ("pthread_create");
     OAILOG_ALERT (LOG_SPGW_APP, "Initializing SPGW-APP task interface: ERROR\n");
@@ -292,6 +335,8 @@ int sgw_init (spgw_config_t *spgw_config_pP)
 //------------------------------------------------------------------------------
 static void sgw_exit(void)
 {
+  sgw_journal_exit ();
+  sgw_ddn_exit ();
 
   if (sgw_app.s11teid2mme_hashtable) {
     hashtable_ts_destroy (sgw_app.s11teid2mme_hashtable);
@@ -0,0 +1,193 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Benchmark of the GTP tunnel programming on a kernel gtp device.
+ * In a private network namespace (needs CAP_SYS_ADMIN and the gtp module), adds then deletes num_tunnels tunnels
+ * with one synchronous libgtpnl request per tunnel, then with the batched tunnel programmer.
+ *
+ * usage: gtp_tunnel_batch_benchmark [num_tunnels]
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/socket.h>
+
+#include <libgtpnl/gtp.h>
+#include <libgtpnl/gtpnl.h>
+#include <libmnl/libmnl.h>
+
+#include "common_defs.h"
+#include "gtp_tunnel_libgtpnl_batch.h"
+
+#define DEFAULT_NUM_TUNNELS  16384
+#define GTP_DEVNAME          "gtpbench0"
+
+static int                              num_errors = 0;
+
+//------------------------------------------------------------------------------
+static double elapsed_ns (const struct timespec * const start, const struct timespec * const stop)
+{
+  return (stop->tv_sec - start->tv_sec) * 1e9 + (stop->tv_nsec - start->tv_nsec);
+}
+
+//------------------------------------------------------------------------------
+static void tunnel_addresses (const int i, struct in_addr * const ue, struct in_addr * const enb)
+{
+  ue->s_addr  = htonl (0x0A000000 | (i + 1));           // 10.x.x.x
+  enb->s_addr = htonl (0xC0A80000 | ((i % 250) + 1));   // 192.168.0.x
+}
+
+//------------------------------------------------------------------------------
+static int sync_program (struct mnl_socket * const nl, const int genl_id, const uint32_t ifindex, const int i, const bool add)
+{
+  struct gtp_tunnel *t = gtp_tunnel_alloc ();
+  struct in_addr     ue, enb;
+  int                rc = 0;
+
+  tunnel_addresses (i, &ue, &enb);
+  gtp_tunnel_set_ifidx (t, ifindex);
+  gtp_tunnel_set_version (t, 1);
+  gtp_tunnel_set_ms_ip4 (t, &ue);
+  gtp_tunnel_set_sgsn_ip4 (t, &enb);
+  gtp_tunnel_set_i_tei (t, i + 1);
+  gtp_tunnel_set_o_tei (t, i + 1);
+  rc = (add) ? gtp_add_tunnel (genl_id, nl, t) : gtp_del_tunnel (genl_id, nl, t);
+  gtp_tunnel_free (t);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static void batch_done (const gtpnl_batch_job_t * const jobs, const int num_jobs, __attribute__ ((unused)) void *arg)
+{
+  for (int i = 0; i < num_jobs; i++) {
+    if (jobs[i].status) {
+      num_errors++;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  int                                     num_tunnels = (argc > 1) ? atoi (argv[1]) : DEFAULT_NUM_TUNNELS;
+  struct timespec                         start, stop;
+  double                                  ns = 0;
+  struct mnl_socket                      *nl = NULL;
+  int                                     genl_id = 0;
+  uint32_t                                ifindex = 0;
+  int                                     fd0 = -1, fd1u = -1;
+  struct sockaddr_in                      addr = {.sin_family = AF_INET, .sin_addr = {.s_addr = INADDR_ANY}};
+
+  if (num_tunnels <= 0) {
+    fprintf (stderr, "usage: %s [num_tunnels]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  // the tunnels never leave the namespace, it vanishes with the process
+  if (unshare (CLONE_NEWNET)) {
+    fprintf (stderr, "Cannot create a network namespace: %s\n", strerror (errno));
+    return EXIT_FAILURE;
+  }
+  fd0  = socket (AF_INET, SOCK_DGRAM, 0);
+  fd1u = socket (AF_INET, SOCK_DGRAM, 0);
+  addr.sin_port = htons (3386);
+  if (bind (fd0, (struct sockaddr *)&addr, sizeof (addr)) < 0) {
+    fprintf (stderr, "Cannot bind GTPv0 socket: %s\n", strerror (errno));
+    return EXIT_FAILURE;
+  }
+  addr.sin_port = htons (2152);
+  if (bind (fd1u, (struct sockaddr *)&addr, sizeof (addr)) < 0) {
+    fprintf (stderr, "Cannot bind GTPv1-U socket: %s\n", strerror (errno));
+    return EXIT_FAILURE;
+  }
+  if (gtp_dev_create (-1, GTP_DEVNAME, fd0, fd1u) < 0) {
+    fprintf (stderr, "Cannot create GTP device (gtp module loaded?): %s\n", strerror (errno));
+    return EXIT_FAILURE;
+  }
+  ifindex = if_nametoindex (GTP_DEVNAME);
+  nl = genl_socket_open ();
+  if ((!nl) || ((genl_id = genl_lookup_family (nl, "gtp")) < 0)) {
+    fprintf (stderr, "Cannot lookup GTP genetlink family\n");
+    return EXIT_FAILURE;
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < num_tunnels; i++) {
+    if (sync_program (nl, genl_id, ifindex, i, true) < 0) num_errors++;
+  }
+  clock_gettime (CLOCK_MONOTONIC, &stop);
+  ns = elapsed_ns (&start, &stop);
+  printf ("Synchronous: added %d tunnels in %.3f ms: %.0f tunnels/s\n", num_tunnels, ns / 1e6, num_tunnels * 1e9 / ns);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < num_tunnels; i++) {
+    if (sync_program (nl, genl_id, ifindex, i, false) < 0) num_errors++;
+  }
+  clock_gettime (CLOCK_MONOTONIC, &stop);
+  ns = elapsed_ns (&start, &stop);
+  printf ("Synchronous: deleted %d tunnels in %.3f ms: %.0f tunnels/s\n", num_tunnels, ns / 1e6, num_tunnels * 1e9 / ns);
+
+  if (RETURNok != gtpnl_batch_init (genl_id, ifindex, batch_done, NULL)) {
+    fprintf (stderr, "Cannot start the GTP tunnel batch thread\n");
+    return EXIT_FAILURE;
+  }
+
+  // completion time: includes the queuing and the kernel ACKs
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < num_tunnels; i++) {
+    struct in_addr ue, enb;
+    tunnel_addresses (i, &ue, &enb);
+    // a full queue refuses the request: let the batch thread drain it
+    while (RETURNok != gtpnl_batch_add_tunnel (ue, enb, i + 1, i + 1, 5)) gtpnl_batch_wait_idle ();
+  }
+  gtpnl_batch_wait_idle ();
+  clock_gettime (CLOCK_MONOTONIC, &stop);
+  ns = elapsed_ns (&start, &stop);
+  printf ("Batched: added %d tunnels in %.3f ms: %.0f tunnels/s\n", num_tunnels, ns / 1e6, num_tunnels * 1e9 / ns);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < num_tunnels; i++) {
+    struct in_addr ue, enb;
+    tunnel_addresses (i, &ue, &enb);
+    while (RETURNok != gtpnl_batch_del_tunnel (ue, i + 1, i + 1)) gtpnl_batch_wait_idle ();
+  }
+  gtpnl_batch_wait_idle ();
+  clock_gettime (CLOCK_MONOTONIC, &stop);
+  ns = elapsed_ns (&start, &stop);
+  printf ("Batched: deleted %d tunnels in %.3f ms: %.0f tunnels/s\n", num_tunnels, ns / 1e6, num_tunnels * 1e9 / ns);
+
+  gtpnl_batch_exit ();
+  mnl_socket_close (nl);
+  gtp_dev_destroy (GTP_DEVNAME);
+  close (fd0);
+  close (fd1u);
+  printf ("%d errors\n", num_errors);
+  return (num_errors) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
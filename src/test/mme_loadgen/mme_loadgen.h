@@ -0,0 +1,218 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_loadgen.h
+  \brief Attach storm load generator: simulated eNBs and UEs, stub HSS and SGW.
+
+  Each eNB thread owns one SCTP association to the MME and a slice of the UE
+  population, UEs run the attach, service request, paging, TAU and detach
+  procedures with UE side NAS security (src/secu).
+  The stub HSS (S6a over Diameter/TCP) and the stub SGW (S11 over GTPv2-C/UDP)
+  answer every request immediately, so that measured latencies are the MME ones.
+*/
+
+#ifndef FILE_MME_LOADGEN_SEEN
+#define FILE_MME_LOADGEN_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <netinet/in.h>
+
+#include "3gpp_23.003.h"
+
+#define LOADGEN_MAX_ENBS            1024
+#define LOADGEN_KEY_SIZE            16
+#define LOADGEN_KASME_SIZE          32
+#define LOADGEN_NAS_MAX_SIZE        512
+#define LOADGEN_S1AP_MAX_SIZE       2048
+
+typedef enum loadgen_procedure_e {
+  LOADGEN_PROC_ATTACH = 0,
+  LOADGEN_PROC_DETACH,
+  LOADGEN_PROC_TAU,
+  LOADGEN_PROC_SERVICE_REQUEST,
+  LOADGEN_PROC_PAGING,
+  LOADGEN_PROC_RELEASE,
+  LOADGEN_PROC_MAX
+} loadgen_procedure_t;
+
+typedef struct loadgen_config_s {
+  struct in_addr    mme_addr;
+  uint16_t          mme_port;
+  struct in_addr    local_addr;         // eNB S1-MME/S1-U, stub HSS and stub SGW address
+  bool              stub_hss;
+  uint16_t          hss_port;
+  char             *hss_identity;
+  char             *hss_realm;
+  bool              stub_sgw;
+  uint16_t          sgw_port;
+  plmn_t            plmn;
+  uint16_t          tac;
+  uint32_t          num_enbs;
+  uint32_t          num_ues;
+  uint64_t          imsi_base;
+  uint8_t           k[LOADGEN_KEY_SIZE];
+  uint32_t          attach_rate;        // initial attaches per second, all eNBs
+  uint32_t          dwell_ms;           // mean time spent connected or idle between two procedures
+  uint32_t          timeout_ms;         // procedure timeout
+  uint32_t          duration_s;         // 0: run until interrupted
+  uint32_t          report_interval_s;
+  uint32_t          mix[LOADGEN_PROC_MAX]; // weights of the procedures started from idle
+  uint32_t          overload_factor;    // dwell time divided by this factor during the overload window, 0: no overload
+  uint32_t          overload_start_s;   // overload window, from the start of the eNBs
+  uint32_t          overload_length_s;
+  uint32_t          overload_check_ms;  // fail the run if no OVERLOAD START was received or the attach p99 exceeds it, 0: no check
+  uint32_t          backoff_scale;      // % of the T3346 received in NAS rejects the UEs wait before retrying
+} loadgen_config_t;
+
+extern loadgen_config_t      g_loadgen_config;
+extern volatile bool         g_loadgen_running;
+extern uint64_t              g_loadgen_start_us;
+
+/*
+ * Latency histogram, log-linear buckets (32 sub-buckets per power of 2 microseconds, ~3% precision).
+ * Written by one thread, read by the reporting thread with relaxed atomics.
+ */
+#define LOADGEN_HISTO_SUB_BUCKET_BITS  5
+#define LOADGEN_HISTO_SUB_BUCKETS      (1 << LOADGEN_HISTO_SUB_BUCKET_BITS)
+#define LOADGEN_HISTO_MAX_EXPONENT     32
+#define LOADGEN_HISTO_BUCKETS          ((LOADGEN_HISTO_MAX_EXPONENT - LOADGEN_HISTO_SUB_BUCKET_BITS + 1) * LOADGEN_HISTO_SUB_BUCKETS)
+
+typedef struct loadgen_histogram_s {
+  uint64_t          count;
+  uint64_t          sum_us;
+  uint64_t          max_us;
+  uint64_t          buckets[LOADGEN_HISTO_BUCKETS];
+} loadgen_histogram_t;
+
+typedef struct loadgen_stats_s {
+  loadgen_histogram_t latency[LOADGEN_PROC_MAX];
+  uint64_t          failures[LOADGEN_PROC_MAX];
+  uint64_t          timeouts[LOADGEN_PROC_MAX];
+  uint64_t          s1ap_tx;
+  uint64_t          s1ap_rx;
+  uint64_t          rrc_rejects;        // connections refused by the eNB applying the MME overload action
+  uint64_t          nas_backoffs;       // NAS rejects with T3346
+  uint64_t          overload_starts;
+  uint64_t          overload_stops;
+} loadgen_stats_t;
+
+void loadgen_stats_record (loadgen_stats_t * const stats, const loadgen_procedure_t procedure, const uint64_t latency_us);
+void loadgen_stats_failure (loadgen_stats_t * const stats, const loadgen_procedure_t procedure, const bool timeout);
+void loadgen_stats_merge (loadgen_stats_t * const total, const loadgen_stats_t * const stats);
+uint64_t loadgen_stats_percentile (const loadgen_stats_t * const total, const loadgen_procedure_t procedure, const double percentile);
+void loadgen_stats_report (const loadgen_stats_t * const total, const loadgen_stats_t * const previous, const double elapsed_s, const double interval_s, const bool final);
+const char *loadgen_procedure_name (const loadgen_procedure_t procedure);
+
+uint64_t loadgen_now_us (void);
+
+/*
+ * UE NAS (TS 24.301), EPS security context
+ */
+typedef struct loadgen_nas_security_s {
+  bool              valid;
+  uint8_t           ksi;
+  uint8_t           kasme[LOADGEN_KASME_SIZE];
+  uint8_t           knas_int[LOADGEN_KEY_SIZE];
+  uint8_t           knas_enc[LOADGEN_KEY_SIZE];
+  uint8_t           eea;
+  uint8_t           eia;
+  uint32_t          ul_count;
+  uint32_t          dl_count;
+  // context established by the last authentication, taken into use by the security mode command
+  bool              pending_valid;
+  uint8_t           pending_ksi;
+  uint8_t           pending_kasme[LOADGEN_KASME_SIZE];
+} loadgen_nas_security_t;
+
+typedef struct loadgen_guti_s {
+  bool              valid;
+  uint8_t           plmn[3];
+  uint16_t          mme_gid;
+  uint8_t           mme_code;
+  uint32_t          m_tmsi;
+} loadgen_guti_t;
+
+typedef enum loadgen_nas_event_e {
+  LOADGEN_NAS_EVENT_NONE = 0,       // nothing to report (answer may have been built)
+  LOADGEN_NAS_EVENT_ATTACH_ACCEPT,
+  LOADGEN_NAS_EVENT_TAU_ACCEPT,
+  LOADGEN_NAS_EVENT_DETACH_ACCEPT,
+  LOADGEN_NAS_EVENT_NETWORK_DETACH,
+  LOADGEN_NAS_EVENT_REJECT,
+  LOADGEN_NAS_EVENT_ERROR,
+} loadgen_nas_event_t;
+
+typedef struct loadgen_nas_ue_s {
+  uint64_t          imsi;
+  loadgen_nas_security_t security;
+  loadgen_guti_t    guti;
+  uint8_t           ebi;
+  uint8_t           pti;
+  uint8_t           emm_cause;          // of the last reject
+  uint32_t          backoff_s;          // T3346 of the last reject, 0 if absent or deactivated
+} loadgen_nas_ue_t;
+
+typedef struct loadgen_nas_buffer_s {
+  uint32_t          length;
+  uint8_t           data[LOADGEN_NAS_MAX_SIZE];
+} loadgen_nas_buffer_t;
+
+void loadgen_plmn_to_tbcd (const plmn_t * const plmn, uint8_t tbcd[3]);
+
+void loadgen_nas_milenage_lock (void);
+void loadgen_nas_milenage_unlock (void);
+
+int loadgen_nas_attach_request (loadgen_nas_ue_t * const ue, loadgen_nas_buffer_t * const out);
+int loadgen_nas_detach_request (loadgen_nas_ue_t * const ue, loadgen_nas_buffer_t * const out);
+int loadgen_nas_tau_request (loadgen_nas_ue_t * const ue, loadgen_nas_buffer_t * const out);
+int loadgen_nas_service_request (loadgen_nas_ue_t * const ue, loadgen_nas_buffer_t * const out);
+int loadgen_nas_attach_complete (loadgen_nas_ue_t * const ue, loadgen_nas_buffer_t * const out);
+
+/*
+ * Process a downlink NAS PDU, the uplink answer (if any) is built in out (out->length 0 if none).
+ */
+loadgen_nas_event_t loadgen_nas_handle_downlink (loadgen_nas_ue_t * const ue, const uint8_t * const pdu, const uint32_t length,
+                                                 loadgen_nas_buffer_t * const out);
+
+/*
+ * Stub HSS, authentication vectors are generated with the same K and OP as the simulated USIMs.
+ */
+int  loadgen_hss_start (void);
+void loadgen_hss_stop (void);
+void loadgen_hss_generate_vector (const uint64_t imsi, uint8_t rand[16], uint8_t xres[8], uint8_t autn[16], uint8_t kasme[32]);
+
+/*
+ * Stub SGW, a downlink data notification triggers the paging of an idle UE.
+ */
+int  loadgen_sgw_start (void);
+void loadgen_sgw_stop (void);
+int  loadgen_sgw_downlink_data_notification (const uint64_t imsi);
+
+/*
+ * eNBs
+ */
+int  loadgen_enb_start (void);
+void loadgen_enb_stop (void);
+void loadgen_enb_collect_stats (loadgen_stats_t * const total);
+
+#endif /* FILE_MME_LOADGEN_SEEN */
@@ -0,0 +1,1047 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_loadgen_enb.c
+  \brief Simulated eNBs of the load generator, S1AP over SCTP (TS 36.413).
+
+  Each eNB runs in its own thread, owns a partition of the UEs and drives them
+  through attach, connected/idle transitions, service request, TAU, paging and detach.
+  UE timers are kept in a per eNB binary heap, an entry is stale when the UE
+  generation changed since it was armed.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/sctp.h>
+#include <arpa/inet.h>
+
+#include "bstrlib.h"
+
+#include "assertions.h"
+#include "common_defs.h"
+#include "hashtable.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_fast_codec.h"
+#include "mme_loadgen.h"
+
+#define LOADGEN_S1AP_PPID             18
+#define LOADGEN_S1AP_NON_UE_STREAM    0
+#define LOADGEN_S1AP_NUM_STREAMS      32
+
+typedef enum loadgen_ue_state_e {
+  LOADGEN_UE_DEREGISTERED = 0,  // timer: start an attach
+  LOADGEN_UE_ATTACHING,
+  LOADGEN_UE_CONNECTED,         // timer: request the release of the S1 connection
+  LOADGEN_UE_RELEASING,
+  LOADGEN_UE_IDLE,              // timer: start the next procedure
+  LOADGEN_UE_SERVICE_REQUEST,
+  LOADGEN_UE_TAU,
+  LOADGEN_UE_PAGING,
+  LOADGEN_UE_DETACHING,
+} loadgen_ue_state_t;
+
+typedef struct loadgen_ue_s {
+  loadgen_nas_ue_t      nas;
+  loadgen_ue_state_t    state;
+  loadgen_procedure_t   procedure;          // procedure in progress, measured from procedure_start_us
+  uint64_t              procedure_start_us;
+  uint32_t              generation;
+  uint32_t              enb_ue_s1ap_id;
+  uint32_t              mme_ue_s1ap_id;
+  bool                  s1_connected;
+  bool                  paging_registered;
+  uint32_t              paging_m_tmsi;
+} loadgen_ue_t;
+
+typedef struct loadgen_timer_s {
+  uint64_t              deadline_us;
+  uint32_t              ue_index;
+  uint32_t              generation;
+} loadgen_timer_t;
+
+typedef struct loadgen_enb_s {
+  uint32_t              enb_id;
+  pthread_t             thread;
+  int                   fd;
+  uint16_t              num_ostreams;
+  uint8_t               plmn[3];
+  uint8_t               tac[2];
+  uint8_t               cell_id[4];
+  uint32_t              num_ues;
+  loadgen_ue_t         *ues;
+  hash_table_t         *m_tmsi_table;         // M-TMSI -> UE, for paging
+  loadgen_timer_t      *timers;
+  uint32_t              num_timers;
+  uint32_t              max_timers;
+  uint64_t              random;
+  bool                  overload;             // OVERLOAD START received, the action applies to new RRC connections
+  S1ap_OverloadAction_t overload_action;
+  uint32_t              traffic_load_reduction;
+  loadgen_stats_t       stats;
+} loadgen_enb_t;
+
+static loadgen_enb_t   *loadgen_enbs = NULL;
+
+//------------------------------------------------------------------------------
+static uint32_t loadgen_enb_random (loadgen_enb_t * const enb)
+{
+  // xorshift64*
+  enb->random ^= enb->random >> 12;
+  enb->random ^= enb->random << 25;
+  enb->random ^= enb->random >> 27;
+  return (enb->random * 0x2545F4914F6CDD1DULL) >> 32;
+}
+
+//------------------------------------------------------------------------------
+static uint64_t loadgen_enb_dwell_us (loadgen_enb_t * const enb)
+{
+  // uniform in [0.5, 1.5[ dwell time, keeps the UEs from synchronizing
+  uint64_t mean_us = (uint64_t)g_loadgen_config.dwell_ms * 1000;
+
+  if (g_loadgen_config.overload_factor) {
+    const uint64_t elapsed_s = (loadgen_now_us () - g_loadgen_start_us) / 1000000;
+
+    if ((elapsed_s >= g_loadgen_config.overload_start_s) &&
+        (elapsed_s < ((uint64_t)g_loadgen_config.overload_start_s + g_loadgen_config.overload_length_s))) {
+      mean_us /= g_loadgen_config.overload_factor;
+    }
+  }
+  return (mean_us / 2) + ((mean_us * (loadgen_enb_random (enb) & 0xFFFF)) >> 16);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_timer_arm (loadgen_enb_t * const enb, loadgen_ue_t * const ue, const uint64_t deadline_us)
+{
+  loadgen_timer_t timer = {.deadline_us = deadline_us, .ue_index = ue - enb->ues, .generation = ++ue->generation};
+  uint32_t        i;
+
+  if (enb->num_timers == enb->max_timers) {
+    enb->max_timers *= 2;
+    enb->timers = realloc (enb->timers, enb->max_timers * sizeof (loadgen_timer_t));
+    AssertFatal (enb->timers, "Out of memory");
+  }
+  for (i = enb->num_timers++; (i > 0) && (enb->timers[(i - 1) / 2].deadline_us > deadline_us); i = (i - 1) / 2) {
+    enb->timers[i] = enb->timers[(i - 1) / 2];
+  }
+  enb->timers[i] = timer;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_timer_pop (loadgen_enb_t * const enb)
+{
+  const loadgen_timer_t last = enb->timers[--enb->num_timers];
+  uint32_t              i = 0;
+
+  for (;;) {
+    uint32_t child = (2 * i) + 1;
+
+    if (child >= enb->num_timers) break;
+    if (((child + 1) < enb->num_timers) && (enb->timers[child + 1].deadline_us < enb->timers[child].deadline_us)) child++;
+    if (enb->timers[child].deadline_us >= last.deadline_us) break;
+    enb->timers[i] = enb->timers[child];
+    i = child;
+  }
+  if (enb->num_timers) {
+    enb->timers[i] = last;
+  }
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_enb_send (loadgen_enb_t * const enb, const uint8_t * const buffer, const uint32_t length, const bool ue_associated)
+{
+  const uint16_t stream = ((ue_associated) && (enb->num_ostreams > 1)) ? 1 : LOADGEN_S1AP_NON_UE_STREAM;
+
+  if (sctp_sendmsg (enb->fd, buffer, length, NULL, 0, htonl (LOADGEN_S1AP_PPID), 0, stream, 0, 0) < 0) {
+    perror ("eNB sctp_sendmsg");
+    return RETURNerror;
+  }
+  __atomic_store_n (&enb->stats.s1ap_tx, enb->stats.s1ap_tx + 1, __ATOMIC_RELAXED);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_enb_send_fast (loadgen_enb_t * const enb, const s1ap_message * const message)
+{
+  uint8_t  buffer[LOADGEN_S1AP_MAX_SIZE];
+  uint32_t length = 0;
+
+  if (RETURNok != s1ap_fast_codec_encode_pdu (message, buffer, sizeof (buffer), &length)) {
+    return RETURNerror;
+  }
+  return loadgen_enb_send (enb, buffer, length, true);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_set_location (loadgen_enb_t * const enb, S1ap_TAI_t * const tai, S1ap_EUTRAN_CGI_t * const eutran_cgi)
+{
+  tai->pLMNidentity.buf         = enb->plmn;
+  tai->pLMNidentity.size        = 3;
+  tai->tAC.buf                  = enb->tac;
+  tai->tAC.size                 = 2;
+  eutran_cgi->pLMNidentity.buf  = enb->plmn;
+  eutran_cgi->pLMNidentity.size = 3;
+  eutran_cgi->cell_ID.buf       = enb->cell_id;
+  eutran_cgi->cell_ID.size      = 4;
+  eutran_cgi->cell_ID.bits_unused = 4;
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_enb_send_initial_ue_message (loadgen_enb_t * const enb, loadgen_ue_t * const ue, loadgen_nas_buffer_t * const nas,
+                                                const S1ap_RRC_Establishment_Cause_t cause, const bool with_s_tmsi)
+{
+  s1ap_message                message = {0};
+  S1ap_InitialUEMessageIEs_t *ies = &message.msg.s1ap_InitialUEMessageIEs;
+  uint8_t                     mmec;
+  uint8_t                     m_tmsi[4];
+
+  message.direction        = S1AP_PDU_PR_initiatingMessage;
+  message.procedureCode    = S1ap_ProcedureCode_id_initialUEMessage;
+  message.criticality      = S1ap_Criticality_ignore;
+  ies->eNB_UE_S1AP_ID      = ue->enb_ue_s1ap_id;
+  ies->nas_pdu.buf         = nas->data;
+  ies->nas_pdu.size        = nas->length;
+  ies->rrC_Establishment_Cause = cause;
+  loadgen_enb_set_location (enb, &ies->tai, &ies->eutran_cgi);
+  if ((with_s_tmsi) && (ue->nas.guti.valid)) {
+    mmec = ue->nas.guti.mme_code;
+    m_tmsi[0] = ue->nas.guti.m_tmsi >> 24;
+    m_tmsi[1] = (ue->nas.guti.m_tmsi >> 16) & 0xFF;
+    m_tmsi[2] = (ue->nas.guti.m_tmsi >> 8) & 0xFF;
+    m_tmsi[3] = ue->nas.guti.m_tmsi & 0xFF;
+    ies->presenceMask     |= S1AP_INITIALUEMESSAGEIES_S_TMSI_PRESENT;
+    ies->s_tmsi.mMEC.buf   = &mmec;
+    ies->s_tmsi.mMEC.size  = 1;
+    ies->s_tmsi.m_TMSI.buf = m_tmsi;
+    ies->s_tmsi.m_TMSI.size = 4;
+  }
+  ue->s1_connected = false;
+  return loadgen_enb_send_fast (enb, &message);
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_enb_send_uplink_nas (loadgen_enb_t * const enb, loadgen_ue_t * const ue, loadgen_nas_buffer_t * const nas)
+{
+  s1ap_message                  message = {0};
+  S1ap_UplinkNASTransportIEs_t *ies = &message.msg.s1ap_UplinkNASTransportIEs;
+
+  message.direction     = S1AP_PDU_PR_initiatingMessage;
+  message.procedureCode = S1ap_ProcedureCode_id_uplinkNASTransport;
+  message.criticality   = S1ap_Criticality_ignore;
+  ies->mme_ue_s1ap_id   = ue->mme_ue_s1ap_id;
+  ies->eNB_UE_S1AP_ID   = ue->enb_ue_s1ap_id;
+  ies->nas_pdu.buf      = nas->data;
+  ies->nas_pdu.size     = nas->length;
+  loadgen_enb_set_location (enb, &ies->tai, &ies->eutran_cgi);
+  return loadgen_enb_send_fast (enb, &message);
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_enb_send_ue_context_release_request (loadgen_enb_t * const enb, loadgen_ue_t * const ue)
+{
+  s1ap_message                       message = {0};
+  S1ap_UEContextReleaseRequestIEs_t *ies = &message.msg.s1ap_UEContextReleaseRequestIEs;
+
+  message.direction     = S1AP_PDU_PR_initiatingMessage;
+  message.procedureCode = S1ap_ProcedureCode_id_UEContextReleaseRequest;
+  message.criticality   = S1ap_Criticality_ignore;
+  ies->mme_ue_s1ap_id   = ue->mme_ue_s1ap_id;
+  ies->eNB_UE_S1AP_ID   = ue->enb_ue_s1ap_id;
+  ies->cause.present    = S1ap_Cause_PR_radioNetwork;
+  ies->cause.choice.radioNetwork = S1ap_CauseRadioNetwork_user_inactivity;
+  return loadgen_enb_send_fast (enb, &message);
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_enb_send_initial_context_setup_response (loadgen_enb_t * const enb, loadgen_ue_t * const ue, const S1ap_E_RAB_ID_t e_rab_id)
+{
+  S1ap_InitialContextSetupResponse_t     response;
+  S1ap_InitialContextSetupResponseIEs_t  ies = {0};
+  S1ap_E_RABSetupItemCtxtSURes_t         item = {0};
+  S1ap_E_RABSetupItemCtxtSURes_t        *items[1] = {&item};
+  uint8_t                                teid[4];
+  uint8_t                               *buffer = NULL;
+  uint32_t                               length = 0;
+  int                                    rc;
+
+  memset (&response, 0, sizeof (response));
+  // the eNB S1-U TEID is the eNB UE S1AP ID
+  teid[0] = ue->enb_ue_s1ap_id >> 24;
+  teid[1] = (ue->enb_ue_s1ap_id >> 16) & 0xFF;
+  teid[2] = (ue->enb_ue_s1ap_id >> 8) & 0xFF;
+  teid[3] = ue->enb_ue_s1ap_id & 0xFF;
+  item.e_RAB_ID                   = e_rab_id;
+  item.transportLayerAddress.buf  = (uint8_t *)&g_loadgen_config.local_addr.s_addr;
+  item.transportLayerAddress.size = 4;
+  item.gTP_TEID.buf               = teid;
+  item.gTP_TEID.size              = 4;
+  ies.mme_ue_s1ap_id              = ue->mme_ue_s1ap_id;
+  ies.eNB_UE_S1AP_ID              = ue->enb_ue_s1ap_id;
+  ies.e_RABSetupListCtxtSURes.s1ap_E_RABSetupItemCtxtSURes.array = (struct S1ap_E_RABSetupItemCtxtSURes_s **)items;
+  ies.e_RABSetupListCtxtSURes.s1ap_E_RABSetupItemCtxtSURes.count = 1;
+  ies.e_RABSetupListCtxtSURes.s1ap_E_RABSetupItemCtxtSURes.size  = 1;
+  if (s1ap_encode_s1ap_initialcontextsetupresponseies (&response, &ies) < 0) {
+    return RETURNerror;
+  }
+  if (s1ap_generate_successfull_outcome (&buffer, &length, S1ap_ProcedureCode_id_InitialContextSetup, S1ap_Criticality_reject,
+                                         &asn_DEF_S1ap_InitialContextSetupResponse, &response) < 0) {
+    return RETURNerror;
+  }
+  rc = loadgen_enb_send (enb, buffer, length, true);
+  free (buffer);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_enb_send_ue_context_release_complete (loadgen_enb_t * const enb, const uint32_t mme_ue_s1ap_id, const uint32_t enb_ue_s1ap_id)
+{
+  S1ap_UEContextReleaseComplete_t        complete;
+  S1ap_UEContextReleaseCompleteIEs_t     ies = {0};
+  uint8_t                               *buffer = NULL;
+  uint32_t                               length = 0;
+  int                                    rc;
+
+  memset (&complete, 0, sizeof (complete));
+  ies.mme_ue_s1ap_id = mme_ue_s1ap_id;
+  ies.eNB_UE_S1AP_ID = enb_ue_s1ap_id;
+  if (s1ap_encode_s1ap_uecontextreleasecompleteies (&complete, &ies) < 0) {
+    return RETURNerror;
+  }
+  if (s1ap_generate_successfull_outcome (&buffer, &length, S1ap_ProcedureCode_id_UEContextRelease, S1ap_Criticality_reject,
+                                         &asn_DEF_S1ap_UEContextReleaseComplete, &complete) < 0) {
+    return RETURNerror;
+  }
+  rc = loadgen_enb_send (enb, buffer, length, true);
+  free (buffer);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_enb_s1_setup (loadgen_enb_t * const enb)
+{
+  S1ap_S1SetupRequest_t                  request;
+  S1ap_S1SetupRequestIEs_t               ies = {0};
+  S1ap_SupportedTAs_Item_t               ta = {0};
+  S1ap_SupportedTAs_Item_t              *tas[1] = {&ta};
+  S1ap_PLMNidentity_t                    plmn = {.buf = enb->plmn, .size = 3};
+  S1ap_PLMNidentity_t                   *plmns[1] = {&plmn};
+  uint8_t                                macro_enb_id[3];
+  uint8_t                               *buffer = NULL;
+  uint32_t                               length = 0;
+  int                                    rc;
+
+  memset (&request, 0, sizeof (request));
+  macro_enb_id[0] = (enb->enb_id >> 12) & 0xFF;
+  macro_enb_id[1] = (enb->enb_id >> 4) & 0xFF;
+  macro_enb_id[2] = (enb->enb_id << 4) & 0xF0;
+  ies.global_ENB_ID.pLMNidentity.buf  = enb->plmn;
+  ies.global_ENB_ID.pLMNidentity.size = 3;
+  ies.global_ENB_ID.eNB_ID.present    = S1ap_ENB_ID_PR_macroENB_ID;
+  ies.global_ENB_ID.eNB_ID.choice.macroENB_ID.buf  = macro_enb_id;
+  ies.global_ENB_ID.eNB_ID.choice.macroENB_ID.size = 3;
+  ies.global_ENB_ID.eNB_ID.choice.macroENB_ID.bits_unused = 4;
+  ta.tAC.buf  = enb->tac;
+  ta.tAC.size = 2;
+  ta.broadcastPLMNs.list.array = plmns;
+  ta.broadcastPLMNs.list.count = 1;
+  ta.broadcastPLMNs.list.size  = 1;
+  ies.supportedTAs.list.array = tas;
+  ies.supportedTAs.list.count = 1;
+  ies.supportedTAs.list.size  = 1;
+  ies.defaultPagingDRX = S1ap_PagingDRX_v128;
+  if (s1ap_encode_s1ap_s1setuprequesties (&request, &ies) < 0) {
+    return RETURNerror;
+  }
+  if (s1ap_generate_initiating_message (&buffer, &length, S1ap_ProcedureCode_id_S1Setup, S1ap_Criticality_reject,
+                                        &asn_DEF_S1ap_S1SetupRequest, &request) < 0) {
+    return RETURNerror;
+  }
+  rc = loadgen_enb_send (enb, buffer, length, false);
+  free (buffer);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_paging_unregister (loadgen_enb_t * const enb, loadgen_ue_t * const ue)
+{
+  if (ue->paging_registered) {
+    hashtable_free (enb->m_tmsi_table, (hash_key_t)ue->paging_m_tmsi);
+    ue->paging_registered = false;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_paging_register (loadgen_enb_t * const enb, loadgen_ue_t * const ue)
+{
+  if ((ue->paging_registered) && (ue->paging_m_tmsi == ue->nas.guti.m_tmsi)) {
+    return;
+  }
+  loadgen_enb_paging_unregister (enb, ue);
+  if ((ue->nas.guti.valid) && (HASH_TABLE_OK == hashtable_insert (enb->m_tmsi_table, (hash_key_t)ue->nas.guti.m_tmsi, ue))) {
+    ue->paging_m_tmsi = ue->nas.guti.m_tmsi;
+    ue->paging_registered = true;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_procedure_start (loadgen_enb_t * const enb, loadgen_ue_t * const ue, const loadgen_ue_state_t state,
+                                         const loadgen_procedure_t procedure)
+{
+  const uint64_t now_us = loadgen_now_us ();
+
+  ue->state = state;
+  ue->procedure = procedure;
+  ue->procedure_start_us = now_us;
+  loadgen_enb_timer_arm (enb, ue, now_us + ((uint64_t)g_loadgen_config.timeout_ms * 1000));
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_procedure_success (loadgen_enb_t * const enb, loadgen_ue_t * const ue, const loadgen_ue_state_t next_state)
+{
+  const uint64_t now_us = loadgen_now_us ();
+
+  loadgen_stats_record (&enb->stats, ue->procedure, now_us - ue->procedure_start_us);
+  ue->state = next_state;
+  loadgen_enb_timer_arm (enb, ue, now_us + loadgen_enb_dwell_us (enb));
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_procedure_failure (loadgen_enb_t * const enb, loadgen_ue_t * const ue, const bool timeout)
+{
+  // restart from scratch: the next attach resets the NAS security context and the GUTI
+  loadgen_stats_failure (&enb->stats, ue->procedure, timeout);
+  if ((ue->s1_connected) && (!timeout)) {
+    loadgen_enb_send_ue_context_release_request (enb, ue);
+  }
+  loadgen_enb_paging_unregister (enb, ue);
+  ue->s1_connected = false;
+  ue->state = LOADGEN_UE_DEREGISTERED;
+  loadgen_enb_timer_arm (enb, ue, loadgen_now_us () + loadgen_enb_dwell_us (enb));
+}
+
+//------------------------------------------------------------------------------
+/*
+ * NAS reject with T3346: the UE stays registered (or deregistered for an attach) and retries once the back-off timer expired.
+ * The MME releases the S1 connection.
+ */
+static void loadgen_enb_procedure_backoff (loadgen_enb_t * const enb, loadgen_ue_t * const ue)
+{
+  const uint64_t backoff_us = ((uint64_t)ue->nas.backoff_s * 1000000 * g_loadgen_config.backoff_scale) / 100;
+
+  loadgen_stats_failure (&enb->stats, ue->procedure, false);
+  __atomic_store_n (&enb->stats.nas_backoffs, enb->stats.nas_backoffs + 1, __ATOMIC_RELAXED);
+  if (LOADGEN_PROC_ATTACH == ue->procedure) {
+    loadgen_enb_paging_unregister (enb, ue);
+    ue->state = LOADGEN_UE_DEREGISTERED;
+  } else {
+    ue->state = LOADGEN_UE_IDLE;
+  }
+  loadgen_enb_timer_arm (enb, ue, loadgen_now_us () + backoff_us);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * RRC connection establishment checked against the overload action of the MME (TS 36.331 5.3.3.3), a rejected UE
+ * keeps its state and retries after a dwell time.
+ */
+static bool loadgen_enb_rrc_reject (loadgen_enb_t * const enb, loadgen_ue_t * const ue, const S1ap_RRC_Establishment_Cause_t cause)
+{
+  bool reject = false;
+
+  if (!enb->overload) {
+    return false;
+  }
+  switch (enb->overload_action) {
+    case S1ap_OverloadAction_reject_non_emergency_mo_dt:
+      reject = (S1ap_RRC_Establishment_Cause_mo_Data == cause);
+      break;
+    case S1ap_OverloadAction_reject_rrc_cr_signalling:
+      reject = (S1ap_RRC_Establishment_Cause_mo_Data == cause) || (S1ap_RRC_Establishment_Cause_mo_Signalling == cause);
+      break;
+    case S1ap_OverloadAction_permit_emergency_sessions_and_mobile_terminated_services_only:
+      reject = (S1ap_RRC_Establishment_Cause_emergency != cause) && (S1ap_RRC_Establishment_Cause_mt_Access != cause);
+      break;
+    case S1ap_OverloadAction_permit_high_priority_sessions_and_mobile_terminated_services_only:
+      reject = (S1ap_RRC_Establishment_Cause_emergency != cause) && (S1ap_RRC_Establishment_Cause_highPriorityAccess != cause) &&
+               (S1ap_RRC_Establishment_Cause_mt_Access != cause);
+      break;
+    case S1ap_OverloadAction_reject_delay_tolerant_access:
+      reject = (S1ap_RRC_Establishment_Cause_delay_TolerantAccess == cause);
+      break;
+    default:
+      break;
+  }
+  if ((reject) && (enb->traffic_load_reduction)) {
+    reject = ((loadgen_enb_random (enb) % 100) < enb->traffic_load_reduction);
+  }
+  if (reject) {
+    __atomic_store_n (&enb->stats.rrc_rejects, enb->stats.rrc_rejects + 1, __ATOMIC_RELAXED);
+    loadgen_enb_timer_arm (enb, ue, loadgen_now_us () + loadgen_enb_dwell_us (enb));
+  }
+  return reject;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_start_attach (loadgen_enb_t * const enb, loadgen_ue_t * const ue)
+{
+  loadgen_nas_buffer_t nas;
+
+  if (loadgen_enb_rrc_reject (enb, ue, S1ap_RRC_Establishment_Cause_mo_Signalling)) {
+    return;
+  }
+  loadgen_enb_paging_unregister (enb, ue);
+  loadgen_nas_attach_request (&ue->nas, &nas);
+  loadgen_enb_procedure_start (enb, ue, LOADGEN_UE_ATTACHING, LOADGEN_PROC_ATTACH);
+  loadgen_enb_send_initial_ue_message (enb, ue, &nas, S1ap_RRC_Establishment_Cause_mo_Signalling, false);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_start_service_request (loadgen_enb_t * const enb, loadgen_ue_t * const ue, const S1ap_RRC_Establishment_Cause_t cause)
+{
+  loadgen_nas_buffer_t nas;
+
+  if (RETURNok != loadgen_nas_service_request (&ue->nas, &nas)) {
+    loadgen_enb_procedure_failure (enb, ue, false);
+    return;
+  }
+  ue->state = LOADGEN_UE_SERVICE_REQUEST;
+  loadgen_enb_send_initial_ue_message (enb, ue, &nas, cause, true);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_start_idle_procedure (loadgen_enb_t * const enb, loadgen_ue_t * const ue)
+{
+  uint32_t             total = 0;
+  uint32_t             draw;
+  loadgen_procedure_t  procedure = LOADGEN_PROC_SERVICE_REQUEST;
+  loadgen_nas_buffer_t nas;
+
+  for (int p = 0; p < LOADGEN_PROC_MAX; p++) {
+    total += g_loadgen_config.mix[p];
+  }
+  if (total) {
+    draw = loadgen_enb_random (enb) % total;
+    for (int p = 0; p < LOADGEN_PROC_MAX; p++) {
+      if (draw < g_loadgen_config.mix[p]) {
+        procedure = p;
+        break;
+      }
+      draw -= g_loadgen_config.mix[p];
+    }
+  }
+  if ((LOADGEN_PROC_PAGING == procedure) && (!g_loadgen_config.stub_sgw)) {
+    procedure = LOADGEN_PROC_SERVICE_REQUEST;
+  }
+  if ((LOADGEN_PROC_PAGING != procedure) &&
+      (loadgen_enb_rrc_reject (enb, ue, (LOADGEN_PROC_SERVICE_REQUEST == procedure) ?
+                               S1ap_RRC_Establishment_Cause_mo_Data : S1ap_RRC_Establishment_Cause_mo_Signalling))) {
+    return;
+  }
+
+  switch (procedure) {
+    case LOADGEN_PROC_DETACH:
+      loadgen_nas_detach_request (&ue->nas, &nas);
+      loadgen_enb_procedure_start (enb, ue, LOADGEN_UE_DETACHING, procedure);
+      loadgen_enb_send_initial_ue_message (enb, ue, &nas, S1ap_RRC_Establishment_Cause_mo_Signalling, true);
+      break;
+    case LOADGEN_PROC_TAU:
+      loadgen_nas_tau_request (&ue->nas, &nas);
+      loadgen_enb_procedure_start (enb, ue, LOADGEN_UE_TAU, procedure);
+      loadgen_enb_send_initial_ue_message (enb, ue, &nas, S1ap_RRC_Establishment_Cause_mo_Signalling, true);
+      break;
+    case LOADGEN_PROC_PAGING:
+      loadgen_enb_procedure_start (enb, ue, LOADGEN_UE_PAGING, procedure);
+      if (RETURNok != loadgen_sgw_downlink_data_notification (ue->nas.imsi)) {
+        loadgen_enb_procedure_failure (enb, ue, false);
+      }
+      break;
+    default:
+      loadgen_enb_procedure_start (enb, ue, LOADGEN_UE_SERVICE_REQUEST, LOADGEN_PROC_SERVICE_REQUEST);
+      loadgen_enb_start_service_request (enb, ue, S1ap_RRC_Establishment_Cause_mo_Data);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_handle_timer (loadgen_enb_t * const enb, loadgen_ue_t * const ue)
+{
+  switch (ue->state) {
+    case LOADGEN_UE_DEREGISTERED:
+      loadgen_enb_start_attach (enb, ue);
+      break;
+    case LOADGEN_UE_CONNECTED:
+      loadgen_enb_procedure_start (enb, ue, LOADGEN_UE_RELEASING, LOADGEN_PROC_RELEASE);
+      loadgen_enb_send_ue_context_release_request (enb, ue);
+      break;
+    case LOADGEN_UE_IDLE:
+      loadgen_enb_start_idle_procedure (enb, ue);
+      break;
+    default:
+      loadgen_enb_procedure_failure (enb, ue, true);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_handle_nas (loadgen_enb_t * const enb, loadgen_ue_t * const ue, const uint8_t * const pdu, const uint32_t length)
+{
+  loadgen_nas_buffer_t out = {0};
+  loadgen_nas_event_t  event = loadgen_nas_handle_downlink (&ue->nas, pdu, length, &out);
+
+  if (out.length) {
+    loadgen_enb_send_uplink_nas (enb, ue, &out);
+  }
+  switch (event) {
+    case LOADGEN_NAS_EVENT_ATTACH_ACCEPT:
+      // the attach complete is sent once the initial context setup response is sent
+      loadgen_enb_paging_register (enb, ue);
+      break;
+    case LOADGEN_NAS_EVENT_TAU_ACCEPT:
+      loadgen_enb_paging_register (enb, ue);
+      if (LOADGEN_UE_TAU == ue->state) {
+        // no active flag, the MME releases the S1 connection
+        loadgen_enb_procedure_success (enb, ue, LOADGEN_UE_CONNECTED);
+      }
+      break;
+    case LOADGEN_NAS_EVENT_DETACH_ACCEPT:
+      if (LOADGEN_UE_DETACHING == ue->state) {
+        loadgen_enb_paging_unregister (enb, ue);
+        loadgen_enb_procedure_success (enb, ue, LOADGEN_UE_DEREGISTERED);
+      }
+      break;
+    case LOADGEN_NAS_EVENT_NETWORK_DETACH:
+      loadgen_enb_paging_unregister (enb, ue);
+      ue->state = LOADGEN_UE_DEREGISTERED;
+      loadgen_enb_timer_arm (enb, ue, loadgen_now_us () + loadgen_enb_dwell_us (enb));
+      break;
+    case LOADGEN_NAS_EVENT_REJECT:
+      if (ue->nas.backoff_s) {
+        loadgen_enb_procedure_backoff (enb, ue);
+      } else {
+        loadgen_enb_procedure_failure (enb, ue, false);
+      }
+      break;
+    case LOADGEN_NAS_EVENT_ERROR:
+      loadgen_enb_procedure_failure (enb, ue, false);
+      break;
+    default:
+      break;
+  }
+}
+
+//------------------------------------------------------------------------------
+static loadgen_ue_t *loadgen_enb_find_ue (loadgen_enb_t * const enb, const uint32_t enb_ue_s1ap_id)
+{
+  return (enb_ue_s1ap_id < enb->num_ues) ? &enb->ues[enb_ue_s1ap_id] : NULL;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_handle_downlink_nas_transport (loadgen_enb_t * const enb, S1ap_DownlinkNASTransportIEs_t * const ies)
+{
+  loadgen_ue_t * ue = loadgen_enb_find_ue (enb, ies->eNB_UE_S1AP_ID);
+
+  if (ue) {
+    ue->mme_ue_s1ap_id = ies->mme_ue_s1ap_id;
+    ue->s1_connected = true;
+    loadgen_enb_handle_nas (enb, ue, ies->nas_pdu.buf, ies->nas_pdu.size);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_handle_initial_context_setup_request (loadgen_enb_t * const enb, S1ap_InitialContextSetupRequestIEs_t * const ies)
+{
+  loadgen_ue_t            * ue = loadgen_enb_find_ue (enb, ies->eNB_UE_S1AP_ID);
+  S1ap_E_RAB_ID_t           e_rab_id = 5;
+  S1ap_NAS_PDU_t          * nas_pdu = NULL;
+  loadgen_nas_buffer_t      attach_complete;
+  S1ap_E_RABToBeSetupItemCtxtSUReq_t * item = NULL;
+
+  if (!ue) {
+    return;
+  }
+  ue->mme_ue_s1ap_id = ies->mme_ue_s1ap_id;
+  ue->s1_connected = true;
+  if (ies->e_RABToBeSetupListCtxtSUReq.s1ap_E_RABToBeSetupItemCtxtSUReq.count > 0) {
+    item = (S1ap_E_RABToBeSetupItemCtxtSUReq_t *)ies->e_RABToBeSetupListCtxtSUReq.s1ap_E_RABToBeSetupItemCtxtSUReq.array[0];
+    e_rab_id = item->e_RAB_ID;
+    nas_pdu = item->nAS_PDU;
+  }
+  if (nas_pdu) {
+    loadgen_enb_handle_nas (enb, ue, nas_pdu->buf, nas_pdu->size);
+  }
+  loadgen_enb_send_initial_context_setup_response (enb, ue, e_rab_id);
+
+  switch (ue->state) {
+    case LOADGEN_UE_ATTACHING:
+      if ((nas_pdu) && (RETURNok == loadgen_nas_attach_complete (&ue->nas, &attach_complete))) {
+        loadgen_enb_send_uplink_nas (enb, ue, &attach_complete);
+        loadgen_enb_procedure_success (enb, ue, LOADGEN_UE_CONNECTED);
+      }
+      break;
+    case LOADGEN_UE_SERVICE_REQUEST:
+    case LOADGEN_UE_TAU:
+      // a service request triggered by paging completes the paging procedure
+      loadgen_enb_procedure_success (enb, ue, LOADGEN_UE_CONNECTED);
+      break;
+    default:
+      break;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_handle_ue_context_release_command (loadgen_enb_t * const enb, S1ap_UEContextReleaseCommandIEs_t * const ies)
+{
+  uint32_t       mme_ue_s1ap_id;
+  loadgen_ue_t * ue = NULL;
+
+  if (S1ap_UE_S1AP_IDs_PR_uE_S1AP_ID_pair == ies->uE_S1AP_IDs.present) {
+    mme_ue_s1ap_id = ies->uE_S1AP_IDs.choice.uE_S1AP_ID_pair.mME_UE_S1AP_ID;
+    ue = loadgen_enb_find_ue (enb, ies->uE_S1AP_IDs.choice.uE_S1AP_ID_pair.eNB_UE_S1AP_ID);
+  } else {
+    mme_ue_s1ap_id = ies->uE_S1AP_IDs.choice.mME_UE_S1AP_ID;
+    for (uint32_t i = 0; i < enb->num_ues; i++) {
+      if ((enb->ues[i].s1_connected) && (enb->ues[i].mme_ue_s1ap_id == mme_ue_s1ap_id)) {
+        ue = &enb->ues[i];
+        break;
+      }
+    }
+  }
+  loadgen_enb_send_ue_context_release_complete (enb, mme_ue_s1ap_id, (ue) ? ue->enb_ue_s1ap_id : 0);
+  if ((!ue) || (ue->mme_ue_s1ap_id != mme_ue_s1ap_id)) {
+    return;
+  }
+  ue->s1_connected = false;
+  switch (ue->state) {
+    case LOADGEN_UE_RELEASING:
+      loadgen_enb_procedure_success (enb, ue, LOADGEN_UE_IDLE);
+      break;
+    case LOADGEN_UE_CONNECTED:
+      // released by the MME (TAU without active flag, inactivity)
+      ue->state = LOADGEN_UE_IDLE;
+      loadgen_enb_timer_arm (enb, ue, loadgen_now_us () + loadgen_enb_dwell_us (enb));
+      break;
+    case LOADGEN_UE_DEREGISTERED:
+    case LOADGEN_UE_IDLE:
+      // released after a reject
+      break;
+    default:
+      // released in the middle of a procedure
+      loadgen_enb_procedure_failure (enb, ue, false);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_handle_paging (loadgen_enb_t * const enb, S1ap_PagingIEs_t * const ies)
+{
+  loadgen_ue_t           * ue = NULL;
+  const S1ap_M_TMSI_t    * m_tmsi = &ies->uePagingID.choice.s_TMSI.m_TMSI;
+  uint32_t                 key;
+
+  if ((S1ap_UEPagingID_PR_s_TMSI != ies->uePagingID.present) || (4 != m_tmsi->size)) {
+    return;
+  }
+  key = ((uint32_t)m_tmsi->buf[0] << 24) | ((uint32_t)m_tmsi->buf[1] << 16) | ((uint32_t)m_tmsi->buf[2] << 8) | m_tmsi->buf[3];
+  if ((HASH_TABLE_OK != hashtable_get (enb->m_tmsi_table, (hash_key_t)key, (void **)&ue)) || (LOADGEN_UE_PAGING != ue->state)) {
+    return;  // paged in the TAI list of another eNB, or paging repetition
+  }
+  loadgen_enb_start_service_request (enb, ue, S1ap_RRC_Establishment_Cause_mt_Access);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_enb_handle_overload_start (loadgen_enb_t * const enb, S1ap_OverloadStartIEs_t * const ies)
+{
+  if (S1ap_OverloadResponse_PR_overloadAction != ies->overloadResponse.present) {
+    return;
+  }
+  enb->overload = true;
+  enb->overload_action = ies->overloadResponse.choice.overloadAction;
+  enb->traffic_load_reduction = (ies->presenceMask & S1AP_OVERLOADSTARTIES_TRAFFICLOADREDUCTIONINDICATION_PRESENT) ?
+                                ies->trafficLoadReductionIndication : 0;
+  __atomic_store_n (&enb->stats.overload_starts, enb->stats.overload_starts + 1, __ATOMIC_RELAXED);
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_enb_handle_pdu (loadgen_enb_t * const enb, const uint8_t * const buffer, const uint32_t length, bool * const s1_setup_done)
+{
+  s1ap_message            message = {0};
+  S1AP_PDU_t              pdu = {(S1AP_PDU_PR_NOTHING)};
+  S1AP_PDU_t             *pdu_p = &pdu;
+  asn_dec_rval_t          dec_ret = {(RC_OK)};
+  int                     rc = RETURNok;
+
+  __atomic_store_n (&enb->stats.s1ap_rx, enb->stats.s1ap_rx + 1, __ATOMIC_RELAXED);
+  if (RETURNok == s1ap_fast_codec_decode_pdu (&message, buffer, length)) {
+    if (S1ap_ProcedureCode_id_downlinkNASTransport == message.procedureCode) {
+      loadgen_enb_handle_downlink_nas_transport (enb, &message.msg.s1ap_DownlinkNASTransportIEs);
+      free_s1ap_downlinknastransport (&message.msg.s1ap_DownlinkNASTransportIEs);
+    }
+    return RETURNok;
+  }
+
+  dec_ret = aper_decode (NULL, &asn_DEF_S1AP_PDU, (void **)&pdu_p, buffer, length, 0, 0);
+  if (dec_ret.code != RC_OK) {
+    fprintf (stderr, "eNB %u: failed to decode S1AP PDU\n", enb->enb_id);
+    return RETURNok;
+  }
+  switch (pdu.present) {
+    case S1AP_PDU_PR_initiatingMessage:
+      switch (pdu.choice.initiatingMessage.procedureCode) {
+        case S1ap_ProcedureCode_id_InitialContextSetup:
+          if (s1ap_decode_s1ap_initialcontextsetuprequesties (&message.msg.s1ap_InitialContextSetupRequestIEs, &pdu.choice.initiatingMessage.value) >= 0) {
+            loadgen_enb_handle_initial_context_setup_request (enb, &message.msg.s1ap_InitialContextSetupRequestIEs);
+            free_s1ap_initialcontextsetuprequest (&message.msg.s1ap_InitialContextSetupRequestIEs);
+          }
+          break;
+        case S1ap_ProcedureCode_id_UEContextRelease:
+          if (s1ap_decode_s1ap_uecontextreleasecommandies (&message.msg.s1ap_UEContextReleaseCommandIEs, &pdu.choice.initiatingMessage.value) >= 0) {
+            loadgen_enb_handle_ue_context_release_command (enb, &message.msg.s1ap_UEContextReleaseCommandIEs);
+            free_s1ap_uecontextreleasecommand (&message.msg.s1ap_UEContextReleaseCommandIEs);
+          }
+          break;
+        case S1ap_ProcedureCode_id_Paging:
+          if (s1ap_decode_s1ap_pagingies (&message.msg.s1ap_PagingIEs, &pdu.choice.initiatingMessage.value) >= 0) {
+            loadgen_enb_handle_paging (enb, &message.msg.s1ap_PagingIEs);
+            free_s1ap_paging (&message.msg.s1ap_PagingIEs);
+          }
+          break;
+        case S1ap_ProcedureCode_id_OverloadStart:
+          if (s1ap_decode_s1ap_overloadstarties (&message.msg.s1ap_OverloadStartIEs, &pdu.choice.initiatingMessage.value) >= 0) {
+            loadgen_enb_handle_overload_start (enb, &message.msg.s1ap_OverloadStartIEs);
+            free_s1ap_overloadstart (&message.msg.s1ap_OverloadStartIEs);
+          }
+          break;
+        case S1ap_ProcedureCode_id_OverloadStop:
+          enb->overload = false;
+          __atomic_store_n (&enb->stats.overload_stops, enb->stats.overload_stops + 1, __ATOMIC_RELAXED);
+          break;
+        case S1ap_ProcedureCode_id_downlinkNASTransport:
+          // not handled by the fast codec (optional IEs)
+          if (s1ap_decode_s1ap_downlinknastransporties (&message.msg.s1ap_DownlinkNASTransportIEs, &pdu.choice.initiatingMessage.value) >= 0) {
+            loadgen_enb_handle_downlink_nas_transport (enb, &message.msg.s1ap_DownlinkNASTransportIEs);
+            free_s1ap_downlinknastransport (&message.msg.s1ap_DownlinkNASTransportIEs);
+          }
+          break;
+        default:
+          break;
+      }
+      break;
+    case S1AP_PDU_PR_successfulOutcome:
+      if (S1ap_ProcedureCode_id_S1Setup == pdu.choice.successfulOutcome.procedureCode) {
+        *s1_setup_done = true;
+      }
+      break;
+    case S1AP_PDU_PR_unsuccessfulOutcome:
+      if (S1ap_ProcedureCode_id_S1Setup == pdu.choice.unsuccessfulOutcome.procedureCode) {
+        fprintf (stderr, "eNB %u: S1 setup failure\n", enb->enb_id);
+        rc = RETURNerror;
+      }
+      break;
+    default:
+      break;
+  }
+  ASN_STRUCT_FREE_CONTENTS_ONLY (asn_DEF_S1AP_PDU, &pdu);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_enb_connect (loadgen_enb_t * const enb)
+{
+  struct sctp_initmsg       initmsg = {.sinit_num_ostreams = LOADGEN_S1AP_NUM_STREAMS, .sinit_max_instreams = LOADGEN_S1AP_NUM_STREAMS};
+  struct sctp_event_subscribe events = {.sctp_data_io_event = 1};
+  struct sctp_status        status = {0};
+  socklen_t                 status_length = sizeof (status);
+  struct sockaddr_in        local = {.sin_family = AF_INET, .sin_addr = g_loadgen_config.local_addr};
+  struct sockaddr_in        mme = {.sin_family = AF_INET, .sin_port = htons (g_loadgen_config.mme_port), .sin_addr = g_loadgen_config.mme_addr};
+
+  enb->fd = socket (AF_INET, SOCK_STREAM, IPPROTO_SCTP);
+  if (enb->fd < 0) {
+    perror ("eNB socket");
+    return RETURNerror;
+  }
+  setsockopt (enb->fd, IPPROTO_SCTP, SCTP_INITMSG, &initmsg, sizeof (initmsg));
+  setsockopt (enb->fd, IPPROTO_SCTP, SCTP_EVENTS, &events, sizeof (events));
+  if ((bind (enb->fd, (struct sockaddr *)&local, sizeof (local)) < 0) || (connect (enb->fd, (struct sockaddr *)&mme, sizeof (mme)) < 0)) {
+    perror ("eNB connect");
+    close (enb->fd);
+    enb->fd = -1;
+    return RETURNerror;
+  }
+  enb->num_ostreams = 1;
+  if (getsockopt (enb->fd, IPPROTO_SCTP, SCTP_STATUS, &status, &status_length) == 0) {
+    enb->num_ostreams = status.sstat_outstrms;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_enb_receive (loadgen_enb_t * const enb, bool * const s1_setup_done)
+{
+  uint8_t                  buffer[LOADGEN_S1AP_MAX_SIZE * 4];
+  struct sctp_sndrcvinfo   sinfo = {0};
+  int                      flags = 0;
+  ssize_t                  length = sctp_recvmsg (enb->fd, buffer, sizeof (buffer), NULL, NULL, &sinfo, &flags);
+
+  if (length <= 0) {
+    if ((length < 0) && (EINTR == errno)) return RETURNok;
+    fprintf (stderr, "eNB %u: SCTP association lost\n", enb->enb_id);
+    return RETURNerror;
+  }
+  if (flags & MSG_NOTIFICATION) {
+    return RETURNok;
+  }
+  return loadgen_enb_handle_pdu (enb, buffer, length, s1_setup_done);
+}
+
+//------------------------------------------------------------------------------
+static void *loadgen_enb_thread_function (void *args_p)
+{
+  loadgen_enb_t * enb = (loadgen_enb_t *)args_p;
+  bool            s1_setup_done = false;
+  struct pollfd   pfd;
+
+  if ((RETURNok != loadgen_enb_connect (enb)) || (RETURNok != loadgen_enb_s1_setup (enb))) {
+    return NULL;
+  }
+  pfd.fd = enb->fd;
+  pfd.events = POLLIN;
+  while ((g_loadgen_running) && (!s1_setup_done)) {
+    if ((poll (&pfd, 1, 100) > 0) && (RETURNok != loadgen_enb_receive (enb, &s1_setup_done))) {
+      return NULL;
+    }
+  }
+
+  // initial attaches are paced over all eNBs: UE global index g attaches at g / attach_rate
+  const uint64_t start_us = loadgen_now_us ();
+  for (uint32_t i = 0; i < enb->num_ues; i++) {
+    const uint64_t g = ((uint64_t)i * g_loadgen_config.num_enbs) + (enb->enb_id - 1);
+    loadgen_enb_timer_arm (enb, &enb->ues[i], start_us + ((g * 1000000) / g_loadgen_config.attach_rate));
+  }
+
+  while (g_loadgen_running) {
+    uint64_t now_us = loadgen_now_us ();
+    int      timeout_ms = 100;
+
+    while ((enb->num_timers) && (enb->timers[0].deadline_us <= now_us)) {
+      loadgen_timer_t timer = enb->timers[0];
+      loadgen_ue_t  * ue = &enb->ues[timer.ue_index];
+
+      loadgen_enb_timer_pop (enb);
+      if (timer.generation == ue->generation) {
+        loadgen_enb_handle_timer (enb, ue);
+      }
+    }
+    if (enb->num_timers) {
+      uint64_t wait_us = enb->timers[0].deadline_us - now_us;
+      timeout_ms = (wait_us < 100000) ? (int)((wait_us + 999) / 1000) : 100;
+    }
+    if ((poll (&pfd, 1, timeout_ms) > 0) && (RETURNok != loadgen_enb_receive (enb, &s1_setup_done))) {
+      break;
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_enb_start (void)
+{
+  uint8_t plmn[3];
+
+  loadgen_plmn_to_tbcd (&g_loadgen_config.plmn, plmn);
+  loadgen_enbs = calloc (g_loadgen_config.num_enbs, sizeof (loadgen_enb_t));
+  if (!loadgen_enbs) {
+    return RETURNerror;
+  }
+  for (uint32_t e = 0; e < g_loadgen_config.num_enbs; e++) {
+    loadgen_enb_t * enb = &loadgen_enbs[e];
+    const uint32_t  cell_id = ((e + 1) << 8) | 1;
+
+    enb->enb_id  = e + 1;
+    enb->fd      = -1;
+    enb->random  = 0x9E3779B97F4A7C15ULL * (e + 1);
+    memcpy (enb->plmn, plmn, 3);
+    enb->tac[0]  = g_loadgen_config.tac >> 8;
+    enb->tac[1]  = g_loadgen_config.tac & 0xFF;
+    // 28 bits cell identity, left aligned
+    enb->cell_id[0] = (cell_id >> 20) & 0xFF;
+    enb->cell_id[1] = (cell_id >> 12) & 0xFF;
+    enb->cell_id[2] = (cell_id >> 4) & 0xFF;
+    enb->cell_id[3] = (cell_id << 4) & 0xF0;
+    enb->num_ues = (g_loadgen_config.num_ues / g_loadgen_config.num_enbs) + ((e < (g_loadgen_config.num_ues % g_loadgen_config.num_enbs)) ? 1 : 0);
+    enb->ues     = calloc (enb->num_ues ? enb->num_ues : 1, sizeof (loadgen_ue_t));
+    enb->max_timers = 2 * (enb->num_ues + 1);
+    enb->timers  = malloc (enb->max_timers * sizeof (loadgen_timer_t));
+    enb->m_tmsi_table = hashtable_create (enb->num_ues + 1, NULL, hash_free_int_func, bformat ("loadgen_enb_%u_m_tmsi", enb->enb_id));
+    if ((!enb->ues) || (!enb->timers) || (!enb->m_tmsi_table)) {
+      return RETURNerror;
+    }
+    enb->m_tmsi_table->log_enabled = false;
+    for (uint32_t i = 0; i < enb->num_ues; i++) {
+      enb->ues[i].nas.imsi       = g_loadgen_config.imsi_base + ((uint64_t)i * g_loadgen_config.num_enbs) + e;
+      enb->ues[i].enb_ue_s1ap_id = i;
+      enb->ues[i].state          = LOADGEN_UE_DEREGISTERED;
+    }
+  }
+  for (uint32_t e = 0; e < g_loadgen_config.num_enbs; e++) {
+    if (pthread_create (&loadgen_enbs[e].thread, NULL, loadgen_enb_thread_function, &loadgen_enbs[e])) {
+      return RETURNerror;
+    }
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void loadgen_enb_stop (void)
+{
+  if (!loadgen_enbs) {
+    return;
+  }
+  for (uint32_t e = 0; e < g_loadgen_config.num_enbs; e++) {
+    loadgen_enb_t * enb = &loadgen_enbs[e];
+
+    if (enb->thread) {
+      pthread_join (enb->thread, NULL);
+    }
+    if (enb->fd >= 0) {
+      close (enb->fd);
+    }
+    hashtable_destroy (enb->m_tmsi_table);
+    free (enb->timers);
+    free (enb->ues);
+  }
+  free (loadgen_enbs);
+  loadgen_enbs = NULL;
+}
+
+//------------------------------------------------------------------------------
+void loadgen_enb_collect_stats (loadgen_stats_t * const total)
+{
+  memset (total, 0, sizeof (*total));
+  for (uint32_t e = 0; (loadgen_enbs) && (e < g_loadgen_config.num_enbs); e++) {
+    loadgen_stats_merge (total, &loadgen_enbs[e].stats);
+  }
+}
@@ -0,0 +1,576 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_loadgen_hss.c
+  \brief Stub HSS of the load generator, S6a over Diameter/TCP (TS 29.272).
+
+  Answers CER, DWR, DPR, AIR, ULR, PUR (any other request with a plain success),
+  the messages are encoded by hand so that the stub does not compete with the MME
+  for freeDiameter resources on the same host.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "bstrlib.h"
+
+#include "common_defs.h"
+#include "etsi_ts_135_206_V10.0.0_annex3.h"
+#include "usim_authenticate.h"
+#include "mme_loadgen.h"
+
+// Codes of s6a_defs.h, this file does not depend on freeDiameter
+#define LOADGEN_DIAMETER_VENDOR_3GPP            10415
+#define LOADGEN_DIAMETER_APP_S6A                16777251
+
+#define LOADGEN_DIAMETER_CMD_CER                257
+#define LOADGEN_DIAMETER_CMD_DWR                280
+#define LOADGEN_DIAMETER_CMD_DPR                282
+#define LOADGEN_DIAMETER_CMD_ULR                316
+#define LOADGEN_DIAMETER_CMD_AIR                318
+#define LOADGEN_DIAMETER_CMD_PUR                321
+
+#define LOADGEN_AVP_USER_NAME                   1
+#define LOADGEN_AVP_HOST_IP_ADDRESS             257
+#define LOADGEN_AVP_AUTH_APPLICATION_ID         258
+#define LOADGEN_AVP_VENDOR_SPECIFIC_APP_ID      260
+#define LOADGEN_AVP_SESSION_ID                  263
+#define LOADGEN_AVP_ORIGIN_HOST                 264
+#define LOADGEN_AVP_SUPPORTED_VENDOR_ID         265
+#define LOADGEN_AVP_VENDOR_ID                   266
+#define LOADGEN_AVP_RESULT_CODE                 268
+#define LOADGEN_AVP_PRODUCT_NAME                269
+#define LOADGEN_AVP_AUTH_SESSION_STATE          277
+#define LOADGEN_AVP_ORIGIN_REALM                296
+#define LOADGEN_AVP_SERVICE_SELECTION           493
+#define LOADGEN_AVP_BANDWIDTH_DL                515
+#define LOADGEN_AVP_BANDWIDTH_UL                516
+#define LOADGEN_AVP_MSISDN                      701
+#define LOADGEN_AVP_QCI                         1028
+#define LOADGEN_AVP_ALLOCATION_RETENTION_PRIORITY 1034
+#define LOADGEN_AVP_PRIORITY_LEVEL              1046
+#define LOADGEN_AVP_PRE_EMPTION_CAPABILITY      1047
+#define LOADGEN_AVP_PRE_EMPTION_VULNERABILITY   1048
+#define LOADGEN_AVP_SUBSCRIPTION_DATA           1400
+#define LOADGEN_AVP_ULA_FLAGS                   1406
+#define LOADGEN_AVP_REQUESTED_EUTRAN_AUTH_INFO  1408
+#define LOADGEN_AVP_NUMBER_OF_REQUESTED_VECTORS 1410
+#define LOADGEN_AVP_AUTHENTICATION_INFO         1413
+#define LOADGEN_AVP_E_UTRAN_VECTOR              1414
+#define LOADGEN_AVP_NETWORK_ACCESS_MODE         1417
+#define LOADGEN_AVP_CONTEXT_IDENTIFIER          1423
+#define LOADGEN_AVP_SUBSCRIBER_STATUS           1424
+#define LOADGEN_AVP_ALL_APN_CONFIG_INC_IND      1428
+#define LOADGEN_AVP_APN_CONFIGURATION_PROFILE   1429
+#define LOADGEN_AVP_APN_CONFIGURATION           1430
+#define LOADGEN_AVP_EPS_SUBSCRIBED_QOS_PROFILE  1431
+#define LOADGEN_AVP_AMBR                        1435
+#define LOADGEN_AVP_PUA_FLAGS                   1442
+#define LOADGEN_AVP_RAND                        1447
+#define LOADGEN_AVP_XRES                        1448
+#define LOADGEN_AVP_AUTN                        1449
+#define LOADGEN_AVP_KASME                       1450
+#define LOADGEN_AVP_PDN_TYPE                    1456
+
+#define LOADGEN_DIAMETER_FLAG_REQUEST           0x80
+#define LOADGEN_DIAMETER_FLAG_PROXIABLE         0x40
+#define LOADGEN_AVP_FLAG_VENDOR                 0x80
+#define LOADGEN_AVP_FLAG_MANDATORY              0x40
+#define LOADGEN_AVP_FLAGS_3GPP                  (LOADGEN_AVP_FLAG_VENDOR | LOADGEN_AVP_FLAG_MANDATORY)
+
+#define LOADGEN_DIAMETER_SUCCESS                2001
+#define LOADGEN_DIAMETER_HEADER_SIZE            20
+#define LOADGEN_DIAMETER_MAX_SIZE               8192
+#define LOADGEN_HSS_MAX_VECTORS                 4
+#define LOADGEN_HSS_MAX_CONNECTIONS             16
+
+typedef struct loadgen_diameter_msg_s {
+  uint32_t          length;
+  uint8_t           data[LOADGEN_DIAMETER_MAX_SIZE];
+} loadgen_diameter_msg_t;
+
+typedef struct loadgen_hss_connection_s {
+  int               fd;
+  uint32_t          length;
+  uint8_t           buffer[4 * LOADGEN_DIAMETER_MAX_SIZE];
+} loadgen_hss_connection_t;
+
+static pthread_t                        loadgen_hss_thread;
+static int                              loadgen_hss_listen_fd = -1;
+static uint64_t                         loadgen_hss_sqn = 0;
+static loadgen_hss_connection_t         loadgen_hss_connections[LOADGEN_HSS_MAX_CONNECTIONS];
+
+//------------------------------------------------------------------------------
+static inline void loadgen_put_u32 (uint8_t * const p, const uint32_t value)
+{
+  p[0] = value >> 24;
+  p[1] = (value >> 16) & 0xFF;
+  p[2] = (value >> 8) & 0xFF;
+  p[3] = value & 0xFF;
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t loadgen_get_u32 (const uint8_t * const p)
+{
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t loadgen_get_u24 (const uint8_t * const p)
+{
+  return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+}
+
+//------------------------------------------------------------------------------
+static uint32_t loadgen_avp_begin (loadgen_diameter_msg_t * const msg, const uint32_t code, const uint8_t flags)
+{
+  uint32_t start = msg->length;
+
+  loadgen_put_u32 (&msg->data[msg->length], code);
+  msg->data[msg->length + 4] = flags;
+  msg->length += 8;
+  if (flags & LOADGEN_AVP_FLAG_VENDOR) {
+    loadgen_put_u32 (&msg->data[msg->length], LOADGEN_DIAMETER_VENDOR_3GPP);
+    msg->length += 4;
+  }
+  return start;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_avp_end (loadgen_diameter_msg_t * const msg, const uint32_t start)
+{
+  uint32_t length = msg->length - start;
+
+  msg->data[start + 5] = (length >> 16) & 0xFF;
+  msg->data[start + 6] = (length >> 8) & 0xFF;
+  msg->data[start + 7] = length & 0xFF;
+  while (msg->length & 3) {
+    msg->data[msg->length++] = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_avp_octets (loadgen_diameter_msg_t * const msg, const uint32_t code, const uint8_t flags, const void * const data, const uint32_t length)
+{
+  uint32_t start = loadgen_avp_begin (msg, code, flags);
+
+  memcpy (&msg->data[msg->length], data, length);
+  msg->length += length;
+  loadgen_avp_end (msg, start);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_avp_u32 (loadgen_diameter_msg_t * const msg, const uint32_t code, const uint8_t flags, const uint32_t value)
+{
+  uint8_t data[4];
+
+  loadgen_put_u32 (data, value);
+  loadgen_avp_octets (msg, code, flags, data, 4);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_avp_string (loadgen_diameter_msg_t * const msg, const uint32_t code, const uint8_t flags, const char * const string)
+{
+  loadgen_avp_octets (msg, code, flags, string, strlen (string));
+}
+
+//------------------------------------------------------------------------------
+static const uint8_t *loadgen_avp_find (const uint8_t * const avps, const uint32_t length, const uint32_t code, uint32_t * const data_length)
+{
+  uint32_t offset = 0;
+
+  while ((offset + 8) <= length) {
+    uint32_t avp_code   = loadgen_get_u32 (&avps[offset]);
+    uint8_t  avp_flags  = avps[offset + 4];
+    uint32_t avp_length = loadgen_get_u24 (&avps[offset + 5]);
+    uint32_t header     = (avp_flags & LOADGEN_AVP_FLAG_VENDOR) ? 12 : 8;
+
+    if ((avp_length < header) || ((offset + avp_length) > length)) {
+      return NULL;
+    }
+    if (avp_code == code) {
+      *data_length = avp_length - header;
+      return &avps[offset + header];
+    }
+    offset += (avp_length + 3) & ~3;
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_diameter_answer_header (const uint8_t * const request, loadgen_diameter_msg_t * const answer)
+{
+  // version, length (set when sent), flags, command code, application id, hop-by-hop and end-to-end identifiers
+  memcpy (answer->data, request, LOADGEN_DIAMETER_HEADER_SIZE);
+  answer->data[4] &= ~LOADGEN_DIAMETER_FLAG_REQUEST;
+  answer->length = LOADGEN_DIAMETER_HEADER_SIZE;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_diameter_origin (loadgen_diameter_msg_t * const answer)
+{
+  loadgen_avp_u32 (answer, LOADGEN_AVP_RESULT_CODE, LOADGEN_AVP_FLAG_MANDATORY, LOADGEN_DIAMETER_SUCCESS);
+  loadgen_avp_string (answer, LOADGEN_AVP_ORIGIN_HOST, LOADGEN_AVP_FLAG_MANDATORY, g_loadgen_config.hss_identity);
+  loadgen_avp_string (answer, LOADGEN_AVP_ORIGIN_REALM, LOADGEN_AVP_FLAG_MANDATORY, g_loadgen_config.hss_realm);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_diameter_session (const uint8_t * const avps, const uint32_t length, loadgen_diameter_msg_t * const answer)
+{
+  uint32_t        session_id_length = 0;
+  const uint8_t * session_id = loadgen_avp_find (avps, length, LOADGEN_AVP_SESSION_ID, &session_id_length);
+
+  if (session_id) {
+    loadgen_avp_octets (answer, LOADGEN_AVP_SESSION_ID, LOADGEN_AVP_FLAG_MANDATORY, session_id, session_id_length);
+  }
+  loadgen_avp_u32 (answer, LOADGEN_AVP_AUTH_SESSION_STATE, LOADGEN_AVP_FLAG_MANDATORY, 1); // NO_STATE_MAINTAINED
+}
+
+//------------------------------------------------------------------------------
+void loadgen_hss_generate_vector (const uint64_t imsi, uint8_t rand[16], uint8_t xres[8], uint8_t autn[16], uint8_t kasme[32])
+{
+  uint8_t  k[LOADGEN_KEY_SIZE];
+  uint8_t  sqn[USIM_SQN_SIZE];
+  uint8_t  amf[2] = {0x80, 0x00};
+  uint8_t  mac_a[8];
+  uint8_t  ck[16];
+  uint8_t  ik[16];
+  uint8_t  ak[6];
+  uint64_t sqn_value = __atomic_add_fetch (&loadgen_hss_sqn, 32, __ATOMIC_RELAXED);
+
+  // the simulated USIMs do not check the SQN freshness, a global SQN is enough
+  for (int i = 0; i < USIM_SQN_SIZE; i++) {
+    sqn[i] = (sqn_value >> (8 * (USIM_SQN_SIZE - 1 - i))) & 0xFF;
+  }
+  for (int i = 0; i < 16; i++) {
+    rand[i] = (uint8_t)((imsi >> ((i & 7) * 8)) ^ (sqn_value >> ((i % 6) * 8)) ^ (i * 0x3B));
+  }
+  memcpy (k, g_loadgen_config.k, sizeof (k));
+  loadgen_nas_milenage_lock ();
+  f1 (k, rand, sqn, amf, mac_a);
+  f2345 (k, rand, xres, ck, ik, ak);
+  for (int i = 0; i < USIM_SQN_SIZE; i++) {
+    autn[i] = sqn[i] ^ ak[i];
+  }
+  memcpy (&autn[6], amf, 2);
+  memcpy (&autn[8], mac_a, 8);
+  usim_generate_kasme (autn, ck, ik, &g_loadgen_config.plmn, kasme);
+  loadgen_nas_milenage_unlock ();
+}
+
+//------------------------------------------------------------------------------
+static uint64_t loadgen_hss_imsi (const uint8_t * const avps, const uint32_t length)
+{
+  uint32_t        user_name_length = 0;
+  const uint8_t * user_name = loadgen_avp_find (avps, length, LOADGEN_AVP_USER_NAME, &user_name_length);
+  uint64_t        imsi = 0;
+
+  for (uint32_t i = 0; (user_name) && (i < user_name_length); i++) {
+    imsi = (imsi * 10) + (user_name[i] - '0');
+  }
+  return imsi;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_hss_authentication_information_answer (const uint8_t * const avps, const uint32_t length, loadgen_diameter_msg_t * const answer)
+{
+  const uint64_t  imsi = loadgen_hss_imsi (avps, length);
+  uint32_t        num_vectors = 1;
+  uint32_t        requested_length = 0;
+  const uint8_t * requested = loadgen_avp_find (avps, length, LOADGEN_AVP_REQUESTED_EUTRAN_AUTH_INFO, &requested_length);
+
+  if (requested) {
+    uint32_t        number_length = 0;
+    const uint8_t * number = loadgen_avp_find (requested, requested_length, LOADGEN_AVP_NUMBER_OF_REQUESTED_VECTORS, &number_length);
+    if ((number) && (4 == number_length)) {
+      num_vectors = loadgen_get_u32 (number);
+      num_vectors = (num_vectors < 1) ? 1 : ((num_vectors > LOADGEN_HSS_MAX_VECTORS) ? LOADGEN_HSS_MAX_VECTORS : num_vectors);
+    }
+  }
+  loadgen_diameter_session (avps, length, answer);
+  loadgen_diameter_origin (answer);
+
+  uint32_t authentication_info = loadgen_avp_begin (answer, LOADGEN_AVP_AUTHENTICATION_INFO, LOADGEN_AVP_FLAGS_3GPP);
+  for (uint32_t v = 0; v < num_vectors; v++) {
+    uint8_t  rand[16];
+    uint8_t  xres[8];
+    uint8_t  autn[16];
+    uint8_t  kasme[32];
+
+    loadgen_hss_generate_vector (imsi, rand, xres, autn, kasme);
+    uint32_t vector = loadgen_avp_begin (answer, LOADGEN_AVP_E_UTRAN_VECTOR, LOADGEN_AVP_FLAGS_3GPP);
+    loadgen_avp_octets (answer, LOADGEN_AVP_RAND, LOADGEN_AVP_FLAGS_3GPP, rand, sizeof (rand));
+    loadgen_avp_octets (answer, LOADGEN_AVP_XRES, LOADGEN_AVP_FLAGS_3GPP, xres, sizeof (xres));
+    loadgen_avp_octets (answer, LOADGEN_AVP_AUTN, LOADGEN_AVP_FLAGS_3GPP, autn, sizeof (autn));
+    loadgen_avp_octets (answer, LOADGEN_AVP_KASME, LOADGEN_AVP_FLAGS_3GPP, kasme, sizeof (kasme));
+    loadgen_avp_end (answer, vector);
+  }
+  loadgen_avp_end (answer, authentication_info);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_hss_ambr (loadgen_diameter_msg_t * const answer)
+{
+  uint32_t ambr = loadgen_avp_begin (answer, LOADGEN_AVP_AMBR, LOADGEN_AVP_FLAGS_3GPP);
+
+  loadgen_avp_u32 (answer, LOADGEN_AVP_BANDWIDTH_UL, LOADGEN_AVP_FLAGS_3GPP, 50000000);
+  loadgen_avp_u32 (answer, LOADGEN_AVP_BANDWIDTH_DL, LOADGEN_AVP_FLAGS_3GPP, 100000000);
+  loadgen_avp_end (answer, ambr);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_hss_update_location_answer (const uint8_t * const avps, const uint32_t length, loadgen_diameter_msg_t * const answer)
+{
+  char     msisdn[16];
+
+  snprintf (msisdn, sizeof (msisdn), "33%010" PRIu64, (uint64_t)(loadgen_hss_imsi (avps, length) % 10000000000ULL));
+  loadgen_diameter_session (avps, length, answer);
+  loadgen_diameter_origin (answer);
+  loadgen_avp_u32 (answer, LOADGEN_AVP_ULA_FLAGS, LOADGEN_AVP_FLAGS_3GPP, 1);  // separation indication
+
+  uint32_t subscription_data = loadgen_avp_begin (answer, LOADGEN_AVP_SUBSCRIPTION_DATA, LOADGEN_AVP_FLAGS_3GPP);
+  loadgen_avp_string (answer, LOADGEN_AVP_MSISDN, LOADGEN_AVP_FLAGS_3GPP, msisdn);
+  loadgen_avp_u32 (answer, LOADGEN_AVP_SUBSCRIBER_STATUS, LOADGEN_AVP_FLAGS_3GPP, 0);    // SERVICE_GRANTED
+  loadgen_avp_u32 (answer, LOADGEN_AVP_NETWORK_ACCESS_MODE, LOADGEN_AVP_FLAGS_3GPP, 2);  // ONLY_PACKET
+  loadgen_hss_ambr (answer);
+
+  uint32_t profile = loadgen_avp_begin (answer, LOADGEN_AVP_APN_CONFIGURATION_PROFILE, LOADGEN_AVP_FLAGS_3GPP);
+  loadgen_avp_u32 (answer, LOADGEN_AVP_CONTEXT_IDENTIFIER, LOADGEN_AVP_FLAGS_3GPP, 1);
+  loadgen_avp_u32 (answer, LOADGEN_AVP_ALL_APN_CONFIG_INC_IND, LOADGEN_AVP_FLAGS_3GPP, 0);
+
+  uint32_t apn_configuration = loadgen_avp_begin (answer, LOADGEN_AVP_APN_CONFIGURATION, LOADGEN_AVP_FLAGS_3GPP);
+  loadgen_avp_u32 (answer, LOADGEN_AVP_CONTEXT_IDENTIFIER, LOADGEN_AVP_FLAGS_3GPP, 1);
+  loadgen_avp_u32 (answer, LOADGEN_AVP_PDN_TYPE, LOADGEN_AVP_FLAGS_3GPP, 0);            // IPv4
+  loadgen_avp_string (answer, LOADGEN_AVP_SERVICE_SELECTION, LOADGEN_AVP_FLAG_MANDATORY, "oai.ipv4");
+
+  uint32_t qos_profile = loadgen_avp_begin (answer, LOADGEN_AVP_EPS_SUBSCRIBED_QOS_PROFILE, LOADGEN_AVP_FLAGS_3GPP);
+  loadgen_avp_u32 (answer, LOADGEN_AVP_QCI, LOADGEN_AVP_FLAGS_3GPP, 9);
+  uint32_t arp = loadgen_avp_begin (answer, LOADGEN_AVP_ALLOCATION_RETENTION_PRIORITY, LOADGEN_AVP_FLAGS_3GPP);
+  loadgen_avp_u32 (answer, LOADGEN_AVP_PRIORITY_LEVEL, LOADGEN_AVP_FLAGS_3GPP, 15);
+  loadgen_avp_u32 (answer, LOADGEN_AVP_PRE_EMPTION_CAPABILITY, LOADGEN_AVP_FLAGS_3GPP, 1);   // DISABLED
+  loadgen_avp_u32 (answer, LOADGEN_AVP_PRE_EMPTION_VULNERABILITY, LOADGEN_AVP_FLAGS_3GPP, 0); // ENABLED
+  loadgen_avp_end (answer, arp);
+  loadgen_avp_end (answer, qos_profile);
+
+  loadgen_hss_ambr (answer);
+  loadgen_avp_end (answer, apn_configuration);
+  loadgen_avp_end (answer, profile);
+  loadgen_avp_end (answer, subscription_data);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_hss_capabilities_exchange_answer (loadgen_diameter_msg_t * const answer)
+{
+  uint8_t  address[6] = {0x00, 0x01};  // IPv4 address family
+
+  loadgen_diameter_origin (answer);
+  memcpy (&address[2], &g_loadgen_config.local_addr.s_addr, 4);
+  loadgen_avp_octets (answer, LOADGEN_AVP_HOST_IP_ADDRESS, LOADGEN_AVP_FLAG_MANDATORY, address, sizeof (address));
+  loadgen_avp_u32 (answer, LOADGEN_AVP_VENDOR_ID, LOADGEN_AVP_FLAG_MANDATORY, 0);
+  loadgen_avp_string (answer, LOADGEN_AVP_PRODUCT_NAME, 0, "OAI MME load generator HSS");
+  loadgen_avp_u32 (answer, LOADGEN_AVP_SUPPORTED_VENDOR_ID, LOADGEN_AVP_FLAG_MANDATORY, LOADGEN_DIAMETER_VENDOR_3GPP);
+
+  uint32_t application = loadgen_avp_begin (answer, LOADGEN_AVP_VENDOR_SPECIFIC_APP_ID, LOADGEN_AVP_FLAG_MANDATORY);
+  loadgen_avp_u32 (answer, LOADGEN_AVP_VENDOR_ID, LOADGEN_AVP_FLAG_MANDATORY, LOADGEN_DIAMETER_VENDOR_3GPP);
+  loadgen_avp_u32 (answer, LOADGEN_AVP_AUTH_APPLICATION_ID, LOADGEN_AVP_FLAG_MANDATORY, LOADGEN_DIAMETER_APP_S6A);
+  loadgen_avp_end (answer, application);
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_hss_handle_request (const int fd, const uint8_t * const request, const uint32_t length)
+{
+  loadgen_diameter_msg_t  answer;
+  const uint32_t          command_code = loadgen_get_u24 (&request[5]);
+  const uint8_t         * avps = &request[LOADGEN_DIAMETER_HEADER_SIZE];
+  const uint32_t          avps_length = length - LOADGEN_DIAMETER_HEADER_SIZE;
+  bool                    disconnect = false;
+
+  if (!(request[4] & LOADGEN_DIAMETER_FLAG_REQUEST)) {
+    return RETURNok;  // the stub never sends requests
+  }
+  loadgen_diameter_answer_header (request, &answer);
+  switch (command_code) {
+    case LOADGEN_DIAMETER_CMD_CER:
+      loadgen_hss_capabilities_exchange_answer (&answer);
+      break;
+    case LOADGEN_DIAMETER_CMD_DWR:
+      loadgen_diameter_origin (&answer);
+      break;
+    case LOADGEN_DIAMETER_CMD_DPR:
+      loadgen_diameter_origin (&answer);
+      disconnect = true;
+      break;
+    case LOADGEN_DIAMETER_CMD_AIR:
+      loadgen_hss_authentication_information_answer (avps, avps_length, &answer);
+      break;
+    case LOADGEN_DIAMETER_CMD_ULR:
+      loadgen_hss_update_location_answer (avps, avps_length, &answer);
+      break;
+    case LOADGEN_DIAMETER_CMD_PUR:
+      loadgen_diameter_session (avps, avps_length, &answer);
+      loadgen_diameter_origin (&answer);
+      loadgen_avp_u32 (&answer, LOADGEN_AVP_PUA_FLAGS, LOADGEN_AVP_FLAGS_3GPP, 0);
+      break;
+    default:
+      loadgen_diameter_session (avps, avps_length, &answer);
+      loadgen_diameter_origin (&answer);
+  }
+  answer.data[1] = (answer.length >> 16) & 0xFF;
+  answer.data[2] = (answer.length >> 8) & 0xFF;
+  answer.data[3] = answer.length & 0xFF;
+  for (uint32_t sent = 0; sent < answer.length;) {
+    ssize_t rc = send (fd, &answer.data[sent], answer.length - sent, MSG_NOSIGNAL);
+    if (rc < 0) {
+      if (EINTR == errno) continue;
+      return RETURNerror;
+    }
+    sent += rc;
+  }
+  return (disconnect) ? RETURNerror : RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_hss_handle_input (loadgen_hss_connection_t * const connection)
+{
+  ssize_t  received = recv (connection->fd, &connection->buffer[connection->length], sizeof (connection->buffer) - connection->length, 0);
+  uint32_t offset = 0;
+
+  if (received <= 0) {
+    return ((received < 0) && ((EAGAIN == errno) || (EINTR == errno))) ? RETURNok : RETURNerror;
+  }
+  connection->length += received;
+  while ((connection->length - offset) >= LOADGEN_DIAMETER_HEADER_SIZE) {
+    uint32_t message_length = loadgen_get_u24 (&connection->buffer[offset + 1]);
+
+    if ((1 != connection->buffer[offset]) || (message_length < LOADGEN_DIAMETER_HEADER_SIZE) || (message_length > LOADGEN_DIAMETER_MAX_SIZE)) {
+      return RETURNerror;
+    }
+    if ((connection->length - offset) < message_length) {
+      break;
+    }
+    if (RETURNok != loadgen_hss_handle_request (connection->fd, &connection->buffer[offset], message_length)) {
+      return RETURNerror;
+    }
+    offset += message_length;
+  }
+  memmove (connection->buffer, &connection->buffer[offset], connection->length - offset);
+  connection->length -= offset;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void *loadgen_hss_thread_function (void *args_p)
+{
+  struct epoll_event events[LOADGEN_HSS_MAX_CONNECTIONS + 1];
+  int                epoll_fd = epoll_create1 (0);
+  struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL};
+
+  epoll_ctl (epoll_fd, EPOLL_CTL_ADD, loadgen_hss_listen_fd, &event);
+  while (g_loadgen_running) {
+    int num_events = epoll_wait (epoll_fd, events, LOADGEN_HSS_MAX_CONNECTIONS + 1, 100);
+
+    for (int e = 0; e < num_events; e++) {
+      loadgen_hss_connection_t * connection = events[e].data.ptr;
+
+      if (!connection) {
+        int fd = accept (loadgen_hss_listen_fd, NULL, NULL);
+        int one = 1;
+        if (fd < 0) continue;
+        for (int c = 0; c < LOADGEN_HSS_MAX_CONNECTIONS; c++) {
+          if (loadgen_hss_connections[c].fd < 0) {
+            connection = &loadgen_hss_connections[c];
+            break;
+          }
+        }
+        if (!connection) {
+          close (fd);
+          continue;
+        }
+        setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one));
+        connection->fd = fd;
+        connection->length = 0;
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        epoll_ctl (epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        fprintf (stdout, "HSS stub: S6a peer connected\n");
+      } else if (RETURNok != loadgen_hss_handle_input (connection)) {
+        epoll_ctl (epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+        close (connection->fd);
+        connection->fd = -1;
+        fprintf (stdout, "HSS stub: S6a peer disconnected\n");
+      }
+    }
+  }
+  close (epoll_fd);
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_hss_start (void)
+{
+  struct sockaddr_in addr = {0};
+  int                one = 1;
+
+  for (int c = 0; c < LOADGEN_HSS_MAX_CONNECTIONS; c++) {
+    loadgen_hss_connections[c].fd = -1;
+  }
+  loadgen_hss_listen_fd = socket (AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (loadgen_hss_listen_fd < 0) {
+    perror ("HSS stub socket");
+    return RETURNerror;
+  }
+  setsockopt (loadgen_hss_listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof (one));
+  addr.sin_family = AF_INET;
+  addr.sin_port   = htons (g_loadgen_config.hss_port);
+  addr.sin_addr   = g_loadgen_config.local_addr;
+  if ((bind (loadgen_hss_listen_fd, (struct sockaddr *)&addr, sizeof (addr)) < 0) || (listen (loadgen_hss_listen_fd, 4) < 0)) {
+    perror ("HSS stub bind/listen");
+    close (loadgen_hss_listen_fd);
+    return RETURNerror;
+  }
+  if (pthread_create (&loadgen_hss_thread, NULL, loadgen_hss_thread_function, NULL)) {
+    close (loadgen_hss_listen_fd);
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void loadgen_hss_stop (void)
+{
+  pthread_join (loadgen_hss_thread, NULL);
+  for (int c = 0; c < LOADGEN_HSS_MAX_CONNECTIONS; c++) {
+    if (loadgen_hss_connections[c].fd >= 0) close (loadgen_hss_connections[c].fd);
+  }
+  close (loadgen_hss_listen_fd);
+}
@@ -0,0 +1,317 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_loadgen_main.c
+  \brief MME control plane load generator.
+
+  Simulates eNBs and UEs on S1-MME and, optionally, the HSS (S6a) and the SGW (S11)
+  so that the MME can be loaded with attach storms and a mix of idle mode procedures
+  on a single host. Reports per procedure throughput and latency percentiles.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <signal.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include "bstrlib.h"
+
+#include "common_defs.h"
+#include "mme_loadgen.h"
+
+extern uint8_t OP[16];
+
+loadgen_config_t      g_loadgen_config = {
+  .mme_port          = 36412,
+  .stub_hss          = true,
+  .hss_port          = 3868,
+  .hss_identity      = "hss.openair4G.eur",
+  .hss_realm         = "openair4G.eur",
+  .stub_sgw          = true,
+  .sgw_port          = 2123,
+  .tac               = 1,
+  .num_enbs          = 1,
+  .num_ues           = 1000,
+  .imsi_base         = 208930000000001ULL,
+  .k                 = {0x8b, 0xaf, 0x47, 0x3f, 0x2f, 0x8f, 0xd0, 0x94, 0x87, 0xcc, 0xcb, 0xd7, 0x09, 0x7c, 0x68, 0x62},
+  .attach_rate       = 100,
+  .dwell_ms          = 10000,
+  .timeout_ms        = 10000,
+  .duration_s        = 0,
+  .report_interval_s = 5,
+  .mix               = {[LOADGEN_PROC_DETACH] = 5, [LOADGEN_PROC_TAU] = 20, [LOADGEN_PROC_SERVICE_REQUEST] = 50, [LOADGEN_PROC_PAGING] = 25},
+  .backoff_scale     = 100,
+};
+volatile bool         g_loadgen_running = true;
+uint64_t              g_loadgen_start_us = 0;
+
+//------------------------------------------------------------------------------
+static void loadgen_signal_handler (int signal_number)
+{
+  g_loadgen_running = false;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_usage (const char * const name)
+{
+  fprintf (stderr,
+           "Usage: %s -m <MME address> -l <local address> [options]\n"
+           "  -m, --mme <addr>          MME S1-MME address\n"
+           "  -P, --mme-port <port>     MME S1-MME SCTP port (%u)\n"
+           "  -l, --local <addr>        local address of the eNBs, stub HSS and stub SGW\n"
+           "  -e, --enbs <n>            number of eNBs (%u, max %u)\n"
+           "  -u, --ues <n>             number of UEs (%u)\n"
+           "  -I, --imsi <imsi>         IMSI of the first UE (%" PRIu64 ")\n"
+           "  -p, --plmn <mccmnc>       PLMN (20893)\n"
+           "  -a, --tac <tac>           TAC (%u)\n"
+           "  -k, --key <hex>           USIM K, 32 hex digits\n"
+           "  -o, --op <hex>            USIM OP, 32 hex digits\n"
+           "  -r, --rate <n>            initial attaches per second (%u)\n"
+           "  -d, --dwell <ms>          mean time between two procedures of a UE (%u)\n"
+           "  -t, --timeout <ms>        procedure timeout (%u)\n"
+           "  -T, --duration <s>        test duration, 0 until interrupted (%u)\n"
+           "  -i, --interval <s>        report interval (%u)\n"
+           "  -x, --mix <d:t:s:p>       weights of detach, TAU, service request and paging from idle (%u:%u:%u:%u)\n"
+           "  -O, --overload <f:s:l>    divide the dwell time by f during l seconds from s seconds after start,\n"
+           "                            e.g. 3:60:120 for a 3x overload of 2 minutes after 1 minute\n"
+           "  -C, --check-overload <ms> with --overload, exit with failure unless OVERLOAD START was received and\n"
+           "                            the p99 latency of the completed attaches stays under ms\n"
+           "  -B, --backoff-scale <%%>   %% of the T3346 received in NAS rejects the UEs wait before retrying (%u)\n"
+           "      --hss-identity <fqdn> stub HSS Diameter identity (%s)\n"
+           "      --hss-realm <realm>   stub HSS Diameter realm (%s)\n"
+           "      --no-hss              do not run the stub HSS\n"
+           "      --no-sgw              do not run the stub SGW (no paging)\n",
+           name, g_loadgen_config.mme_port, g_loadgen_config.num_enbs, LOADGEN_MAX_ENBS, g_loadgen_config.num_ues, g_loadgen_config.imsi_base,
+           g_loadgen_config.tac, g_loadgen_config.attach_rate, g_loadgen_config.dwell_ms, g_loadgen_config.timeout_ms,
+           g_loadgen_config.duration_s, g_loadgen_config.report_interval_s,
+           g_loadgen_config.mix[LOADGEN_PROC_DETACH], g_loadgen_config.mix[LOADGEN_PROC_TAU],
+           g_loadgen_config.mix[LOADGEN_PROC_SERVICE_REQUEST], g_loadgen_config.mix[LOADGEN_PROC_PAGING],
+           g_loadgen_config.backoff_scale, g_loadgen_config.hss_identity, g_loadgen_config.hss_realm);
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_parse_hex (const char * const string, uint8_t * const out, const int length)
+{
+  if (strlen (string) != (2 * length)) {
+    return RETURNerror;
+  }
+  for (int i = 0; i < length; i++) {
+    unsigned int byte;
+    if (sscanf (&string[2 * i], "%2x", &byte) != 1) {
+      return RETURNerror;
+    }
+    out[i] = byte;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_parse_plmn (const char * const string, plmn_t * const plmn)
+{
+  const size_t length = strlen (string);
+
+  if (((5 != length) && (6 != length)) || (strspn (string, "0123456789") != length)) {
+    return RETURNerror;
+  }
+  plmn->mcc_digit1 = string[0] - '0';
+  plmn->mcc_digit2 = string[1] - '0';
+  plmn->mcc_digit3 = string[2] - '0';
+  plmn->mnc_digit1 = string[3] - '0';
+  plmn->mnc_digit2 = string[4] - '0';
+  plmn->mnc_digit3 = (6 == length) ? (string[5] - '0') : 0x0F;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_parse_arguments (int argc, char *argv[])
+{
+  enum {LOADGEN_OPT_HSS_IDENTITY = 256, LOADGEN_OPT_HSS_REALM, LOADGEN_OPT_NO_HSS, LOADGEN_OPT_NO_SGW};
+  static const struct option long_options[] = {
+    {"mme", required_argument, NULL, 'm'},
+    {"mme-port", required_argument, NULL, 'P'},
+    {"local", required_argument, NULL, 'l'},
+    {"enbs", required_argument, NULL, 'e'},
+    {"ues", required_argument, NULL, 'u'},
+    {"imsi", required_argument, NULL, 'I'},
+    {"plmn", required_argument, NULL, 'p'},
+    {"tac", required_argument, NULL, 'a'},
+    {"key", required_argument, NULL, 'k'},
+    {"op", required_argument, NULL, 'o'},
+    {"rate", required_argument, NULL, 'r'},
+    {"dwell", required_argument, NULL, 'd'},
+    {"timeout", required_argument, NULL, 't'},
+    {"duration", required_argument, NULL, 'T'},
+    {"interval", required_argument, NULL, 'i'},
+    {"mix", required_argument, NULL, 'x'},
+    {"overload", required_argument, NULL, 'O'},
+    {"check-overload", required_argument, NULL, 'C'},
+    {"backoff-scale", required_argument, NULL, 'B'},
+    {"hss-identity", required_argument, NULL, LOADGEN_OPT_HSS_IDENTITY},
+    {"hss-realm", required_argument, NULL, LOADGEN_OPT_HSS_REALM},
+    {"no-hss", no_argument, NULL, LOADGEN_OPT_NO_HSS},
+    {"no-sgw", no_argument, NULL, LOADGEN_OPT_NO_SGW},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+  };
+  bool mme_set = false;
+  bool local_set = false;
+  int  c;
+
+  loadgen_parse_plmn ("20893", &g_loadgen_config.plmn);
+  while ((c = getopt_long (argc, argv, "m:P:l:e:u:I:p:a:k:o:r:d:t:T:i:x:O:C:B:h", long_options, NULL)) != -1) {
+    switch (c) {
+      case 'm': mme_set = (inet_pton (AF_INET, optarg, &g_loadgen_config.mme_addr) == 1); break;
+      case 'P': g_loadgen_config.mme_port = atoi (optarg); break;
+      case 'l': local_set = (inet_pton (AF_INET, optarg, &g_loadgen_config.local_addr) == 1); break;
+      case 'e': g_loadgen_config.num_enbs = atoi (optarg); break;
+      case 'u': g_loadgen_config.num_ues = atoi (optarg); break;
+      case 'I': g_loadgen_config.imsi_base = strtoull (optarg, NULL, 10); break;
+      case 'a': g_loadgen_config.tac = atoi (optarg); break;
+      case 'r': g_loadgen_config.attach_rate = atoi (optarg); break;
+      case 'd': g_loadgen_config.dwell_ms = atoi (optarg); break;
+      case 't': g_loadgen_config.timeout_ms = atoi (optarg); break;
+      case 'T': g_loadgen_config.duration_s = atoi (optarg); break;
+      case 'i': g_loadgen_config.report_interval_s = atoi (optarg); break;
+      case 'B': g_loadgen_config.backoff_scale = atoi (optarg); break;
+      case 'C': g_loadgen_config.overload_check_ms = atoi (optarg); break;
+      case 'O':
+        if ((sscanf (optarg, "%u:%u:%u", &g_loadgen_config.overload_factor, &g_loadgen_config.overload_start_s,
+                     &g_loadgen_config.overload_length_s) != 3) || (0 == g_loadgen_config.overload_factor)) return RETURNerror;
+        break;
+      case 'p':
+        if (RETURNok != loadgen_parse_plmn (optarg, &g_loadgen_config.plmn)) return RETURNerror;
+        break;
+      case 'k':
+        if (RETURNok != loadgen_parse_hex (optarg, g_loadgen_config.k, LOADGEN_KEY_SIZE)) return RETURNerror;
+        break;
+      case 'o':
+        if (RETURNok != loadgen_parse_hex (optarg, OP, 16)) return RETURNerror;
+        break;
+      case 'x':
+        if (sscanf (optarg, "%u:%u:%u:%u", &g_loadgen_config.mix[LOADGEN_PROC_DETACH], &g_loadgen_config.mix[LOADGEN_PROC_TAU],
+                    &g_loadgen_config.mix[LOADGEN_PROC_SERVICE_REQUEST], &g_loadgen_config.mix[LOADGEN_PROC_PAGING]) != 4) return RETURNerror;
+        break;
+      case LOADGEN_OPT_HSS_IDENTITY: g_loadgen_config.hss_identity = optarg; break;
+      case LOADGEN_OPT_HSS_REALM: g_loadgen_config.hss_realm = optarg; break;
+      case LOADGEN_OPT_NO_HSS: g_loadgen_config.stub_hss = false; break;
+      case LOADGEN_OPT_NO_SGW: g_loadgen_config.stub_sgw = false; break;
+      default:
+        return RETURNerror;
+    }
+  }
+  if ((!mme_set) || (!local_set) || (0 == g_loadgen_config.num_enbs) || (g_loadgen_config.num_enbs > LOADGEN_MAX_ENBS) ||
+      (0 == g_loadgen_config.num_ues) || (0 == g_loadgen_config.attach_rate) || (0 == g_loadgen_config.report_interval_s) ||
+      ((g_loadgen_config.overload_check_ms) && (0 == g_loadgen_config.overload_factor))) {
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  loadgen_stats_t   * current = NULL;
+  loadgen_stats_t   * previous = NULL;
+  struct sigaction    action = {.sa_handler = loadgen_signal_handler};
+  uint64_t            start_us;
+  uint64_t            last_report_us;
+  int                 rc = EXIT_SUCCESS;
+
+  if (RETURNok != loadgen_parse_arguments (argc, argv)) {
+    loadgen_usage (argv[0]);
+    return EXIT_FAILURE;
+  }
+  sigaction (SIGINT, &action, NULL);
+  sigaction (SIGTERM, &action, NULL);
+  signal (SIGPIPE, SIG_IGN);
+
+  current = calloc (1, sizeof (loadgen_stats_t));
+  previous = calloc (1, sizeof (loadgen_stats_t));
+  if ((!current) || (!previous)) {
+    return EXIT_FAILURE;
+  }
+  if ((g_loadgen_config.stub_hss) && (RETURNok != loadgen_hss_start ())) {
+    return EXIT_FAILURE;
+  }
+  if ((g_loadgen_config.stub_sgw) && (RETURNok != loadgen_sgw_start ())) {
+    g_loadgen_running = false;
+    rc = EXIT_FAILURE;
+  }
+  if (g_loadgen_running) {
+    fprintf (stdout, "%u eNBs, %u UEs, %u attaches/s, dwell %u ms, mix detach:tau:sr:paging %u:%u:%u:%u\n",
+             g_loadgen_config.num_enbs, g_loadgen_config.num_ues, g_loadgen_config.attach_rate, g_loadgen_config.dwell_ms,
+             g_loadgen_config.mix[LOADGEN_PROC_DETACH], g_loadgen_config.mix[LOADGEN_PROC_TAU],
+             g_loadgen_config.mix[LOADGEN_PROC_SERVICE_REQUEST], g_loadgen_config.mix[LOADGEN_PROC_PAGING]);
+    if (g_loadgen_config.overload_factor) {
+      fprintf (stdout, "overload x%u from %u s to %u s\n", g_loadgen_config.overload_factor, g_loadgen_config.overload_start_s,
+               g_loadgen_config.overload_start_s + g_loadgen_config.overload_length_s);
+    }
+    g_loadgen_start_us = loadgen_now_us ();
+    if (RETURNok != loadgen_enb_start ()) {
+      g_loadgen_running = false;
+      rc = EXIT_FAILURE;
+    }
+  }
+
+  start_us = loadgen_now_us ();
+  last_report_us = start_us;
+  while (g_loadgen_running) {
+    uint64_t now_us;
+
+    usleep (100000);
+    now_us = loadgen_now_us ();
+    if ((g_loadgen_config.duration_s) && ((now_us - start_us) >= ((uint64_t)g_loadgen_config.duration_s * 1000000))) {
+      g_loadgen_running = false;
+    } else if ((now_us - last_report_us) >= ((uint64_t)g_loadgen_config.report_interval_s * 1000000)) {
+      loadgen_stats_t * swap = previous;
+
+      loadgen_enb_collect_stats (current);
+      loadgen_stats_report (current, previous, (now_us - start_us) / 1e6, (now_us - last_report_us) / 1e6, false);
+      previous = current;
+      current = swap;
+      last_report_us = now_us;
+    }
+  }
+
+  loadgen_enb_stop ();
+  loadgen_enb_collect_stats (current);
+  loadgen_stats_report (current, NULL, (loadgen_now_us () - start_us) / 1e6, 0, true);
+  if (g_loadgen_config.overload_check_ms) {
+    const uint64_t attach_p99_us = loadgen_stats_percentile (current, LOADGEN_PROC_ATTACH, 99.0);
+    const bool     passed = (current->overload_starts) && (current->latency[LOADGEN_PROC_ATTACH].count) &&
+                            (attach_p99_us <= ((uint64_t)g_loadgen_config.overload_check_ms * 1000));
+
+    fprintf (stdout, "OVERLOAD CHECK %s: overload start %lu, attach p99 %lu us (max %u ms)\n", (passed) ? "PASSED" : "FAILED",
+             current->overload_starts, attach_p99_us, g_loadgen_config.overload_check_ms);
+    if (!passed) rc = EXIT_FAILURE;
+  }
+  if (g_loadgen_config.stub_sgw) loadgen_sgw_stop ();
+  if (g_loadgen_config.stub_hss) loadgen_hss_stop ();
+  free (current);
+  free (previous);
+  return rc;
+}
@@ -0,0 +1,630 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_loadgen_nas.c
+  \brief UE side EMM procedures and NAS security of the load generator (TS 24.301, TS 33.401).
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <inttypes.h>
+
+#include "bstrlib.h"
+
+#include "common_defs.h"
+#include "secu_defs.h"
+#include "usim_authenticate.h"
+#include "mme_loadgen.h"
+
+#define LOADGEN_NAS_PD_EMM                     0x07
+#define LOADGEN_NAS_PD_ESM                     0x02
+
+#define LOADGEN_NAS_SHT_PLAIN                  0x0
+#define LOADGEN_NAS_SHT_INTEGRITY              0x1
+#define LOADGEN_NAS_SHT_INTEGRITY_CIPHERED     0x2
+#define LOADGEN_NAS_SHT_INTEGRITY_NEW          0x3
+#define LOADGEN_NAS_SHT_INTEGRITY_CIPHERED_NEW 0x4
+#define LOADGEN_NAS_SHT_SERVICE_REQUEST        0xC
+
+#define LOADGEN_NAS_ATTACH_REQUEST             0x41
+#define LOADGEN_NAS_ATTACH_ACCEPT              0x42
+#define LOADGEN_NAS_ATTACH_COMPLETE            0x43
+#define LOADGEN_NAS_ATTACH_REJECT              0x44
+#define LOADGEN_NAS_DETACH_REQUEST             0x45
+#define LOADGEN_NAS_DETACH_ACCEPT              0x46
+#define LOADGEN_NAS_TAU_REQUEST                0x48
+#define LOADGEN_NAS_TAU_ACCEPT                 0x49
+#define LOADGEN_NAS_TAU_COMPLETE               0x4A
+#define LOADGEN_NAS_TAU_REJECT                 0x4B
+#define LOADGEN_NAS_SERVICE_REJECT             0x4E
+#define LOADGEN_NAS_AUTHENTICATION_REQUEST     0x52
+#define LOADGEN_NAS_AUTHENTICATION_RESPONSE    0x53
+#define LOADGEN_NAS_AUTHENTICATION_REJECT      0x54
+#define LOADGEN_NAS_AUTHENTICATION_FAILURE     0x5C
+#define LOADGEN_NAS_IDENTITY_REQUEST           0x55
+#define LOADGEN_NAS_IDENTITY_RESPONSE          0x56
+#define LOADGEN_NAS_SECURITY_MODE_COMMAND      0x5D
+#define LOADGEN_NAS_SECURITY_MODE_COMPLETE     0x5E
+
+#define LOADGEN_NAS_ESM_ACTIVATE_DEFAULT_BEARER_ACCEPT 0xC2
+
+#define LOADGEN_NAS_IEI_GUTI                   0x50
+#define LOADGEN_NAS_IEI_IMEISV                 0x23
+#define LOADGEN_NAS_KSI_NOT_AVAILABLE          0x07
+#define LOADGEN_NAS_EMM_CAUSE_MAC_FAILURE      0x14
+#define LOADGEN_NAS_EMM_CAUSE_CONGESTION       0x16
+#define LOADGEN_NAS_IEI_T3346                  0x5F
+#define LOADGEN_NAS_IEI_ESM_MESSAGE_CONTAINER  0x78
+
+#define LOADGEN_NAS_HEADER_SIZE                6   // security protected header: sht/pd, MAC, SN
+
+// Milenage (etsi_ts_135_206) keeps the AES key schedule in a global
+static pthread_mutex_t                  loadgen_milenage_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+//------------------------------------------------------------------------------
+void loadgen_nas_milenage_lock (void)
+{
+  pthread_mutex_lock (&loadgen_milenage_mutex);
+}
+
+//------------------------------------------------------------------------------
+void loadgen_nas_milenage_unlock (void)
+{
+  pthread_mutex_unlock (&loadgen_milenage_mutex);
+}
+
+//------------------------------------------------------------------------------
+void loadgen_plmn_to_tbcd (const plmn_t * const plmn, uint8_t tbcd[3])
+{
+  // same encoding as the serving network identity used in the KASME derivation
+  tbcd[0] = (plmn->mcc_digit2 << 4) | plmn->mcc_digit1;
+  tbcd[1] = (plmn->mnc_digit3 << 4) | plmn->mcc_digit3;
+  tbcd[2] = (plmn->mnc_digit2 << 4) | plmn->mnc_digit1;
+}
+
+//------------------------------------------------------------------------------
+static uint32_t loadgen_nas_encode_identity (uint8_t * const out, const char * const digits, const uint8_t type)
+{
+  const uint32_t num_digits = strlen (digits);
+  uint32_t       length = 1;
+
+  out[1] = ((digits[0] - '0') << 4) | ((num_digits & 1) << 3) | type;
+  for (int i = 1; i < num_digits; i += 2) {
+    uint8_t high = (i + 1 < num_digits) ? (digits[i + 1] - '0') : 0x0F;
+    out[1 + length++] = (high << 4) | (digits[i] - '0');
+  }
+  out[0] = length;
+  return length + 1;
+}
+
+//------------------------------------------------------------------------------
+static uint32_t loadgen_nas_encode_imsi (uint8_t * const out, const uint64_t imsi)
+{
+  char digits[16];
+
+  snprintf (digits, sizeof (digits), "%015" PRIu64, imsi);
+  return loadgen_nas_encode_identity (out, digits, 1);
+}
+
+//------------------------------------------------------------------------------
+static uint32_t loadgen_nas_encode_imeisv (uint8_t * const out, const uint64_t imsi)
+{
+  char digits[17];
+
+  snprintf (digits, sizeof (digits), "35%012" PRIu64 "01", (uint64_t)(imsi % 1000000000000ULL));
+  return loadgen_nas_encode_identity (out, digits, 3);
+}
+
+//------------------------------------------------------------------------------
+static uint32_t loadgen_nas_encode_guti (uint8_t * const out, const loadgen_guti_t * const guti)
+{
+  out[0]  = 11;
+  out[1]  = 0xF6;
+  memcpy (&out[2], guti->plmn, 3);
+  out[5]  = guti->mme_gid >> 8;
+  out[6]  = guti->mme_gid & 0xFF;
+  out[7]  = guti->mme_code;
+  out[8]  = guti->m_tmsi >> 24;
+  out[9]  = (guti->m_tmsi >> 16) & 0xFF;
+  out[10] = (guti->m_tmsi >> 8) & 0xFF;
+  out[11] = guti->m_tmsi & 0xFF;
+  return 12;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_nas_mac (const loadgen_nas_security_t * const security, const uint8_t * const message, const uint32_t length,
+                             const uint32_t count, const uint8_t direction, uint8_t mac[4])
+{
+  nas_stream_cipher_t stream_cipher = {0};
+
+  stream_cipher.key        = (uint8_t*)security->knas_int;
+  stream_cipher.key_length = LOADGEN_KEY_SIZE;
+  stream_cipher.count      = count;
+  stream_cipher.bearer     = 0x00;  //33.401 section 8.1.1
+  stream_cipher.direction  = direction;
+  stream_cipher.message    = (uint8_t*)message;
+  stream_cipher.blength    = length << 3;
+  switch (security->eia) {
+    case 1:
+      nas_stream_encrypt_eia1 (&stream_cipher, mac);
+      break;
+    case 2:
+      nas_stream_encrypt_eia2 (&stream_cipher, mac);
+      break;
+    default:
+      memset (mac, 0, 4);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_nas_cipher (const loadgen_nas_security_t * const security, const uint8_t * const in, const uint32_t length,
+                                const uint32_t count, const uint8_t direction, uint8_t * const out)
+{
+  nas_stream_cipher_t stream_cipher = {0};
+
+  if ((!security->eea) || (!length)) {
+    memmove (out, in, length);
+    return;
+  }
+  stream_cipher.key        = (uint8_t*)security->knas_enc;
+  stream_cipher.key_length = LOADGEN_KEY_SIZE;
+  stream_cipher.count      = count;
+  stream_cipher.bearer     = 0x00;
+  stream_cipher.direction  = direction;
+  stream_cipher.message    = (uint8_t*)in;
+  stream_cipher.blength    = length << 3;
+  if (1 == security->eea) {
+    nas_stream_encrypt_eea1 (&stream_cipher, out);
+  } else {
+    nas_stream_encrypt_eea2 (&stream_cipher, out);
+  }
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_nas_protect (loadgen_nas_ue_t * const ue, const uint8_t security_header_type, const uint8_t * const plain,
+                                const uint32_t length, loadgen_nas_buffer_t * const out)
+{
+  loadgen_nas_security_t * security = &ue->security;
+
+  if ((LOADGEN_NAS_SHT_PLAIN == security_header_type) || (!security->valid)) {
+    memcpy (out->data, plain, length);
+    out->length = length;
+    return RETURNok;
+  }
+  if ((length + LOADGEN_NAS_HEADER_SIZE) > sizeof (out->data)) {
+    return RETURNerror;
+  }
+  out->data[0] = (security_header_type << 4) | LOADGEN_NAS_PD_EMM;
+  out->data[5] = security->ul_count & 0xFF;
+  if ((LOADGEN_NAS_SHT_INTEGRITY_CIPHERED == security_header_type) || (LOADGEN_NAS_SHT_INTEGRITY_CIPHERED_NEW == security_header_type)) {
+    loadgen_nas_cipher (security, plain, length, security->ul_count, SECU_DIRECTION_UPLINK, &out->data[LOADGEN_NAS_HEADER_SIZE]);
+  } else {
+    memcpy (&out->data[LOADGEN_NAS_HEADER_SIZE], plain, length);
+  }
+  loadgen_nas_mac (security, &out->data[5], length + 1, security->ul_count, SECU_DIRECTION_UPLINK, &out->data[1]);
+  security->ul_count = (security->ul_count + 1) & 0x00FFFFFF;
+  out->length = length + LOADGEN_NAS_HEADER_SIZE;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_attach_request (loadgen_nas_ue_t * const ue, loadgen_nas_buffer_t * const out)
+{
+  uint8_t  plain[64];
+  uint32_t length = 0;
+
+  // a new attach always starts from the IMSI, without security context
+  memset (&ue->security, 0, sizeof (ue->security));
+  ue->guti.valid = false;
+  plain[length++] = LOADGEN_NAS_PD_EMM;
+  plain[length++] = LOADGEN_NAS_ATTACH_REQUEST;
+  plain[length++] = (LOADGEN_NAS_KSI_NOT_AVAILABLE << 4) | 0x01;   // EPS attach
+  length += loadgen_nas_encode_imsi (&plain[length], ue->imsi);
+  // UE network capability: EEA0-2, EIA0-2
+  plain[length++] = 0x02;
+  plain[length++] = 0xE0;
+  plain[length++] = 0xE0;
+  // ESM message container: PDN connectivity request, IPv4, initial request
+  ue->pti = (ue->pti % 254) + 1;
+  plain[length++] = 0x00;
+  plain[length++] = 0x04;
+  plain[length++] = LOADGEN_NAS_PD_ESM;
+  plain[length++] = ue->pti;
+  plain[length++] = 0xD0;
+  plain[length++] = 0x11;
+  return loadgen_nas_protect (ue, LOADGEN_NAS_SHT_PLAIN, plain, length, out);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_detach_request (loadgen_nas_ue_t * const ue, loadgen_nas_buffer_t * const out)
+{
+  uint8_t  plain[32];
+  uint32_t length = 0;
+
+  if ((!ue->security.valid) || (!ue->guti.valid)) {
+    return RETURNerror;
+  }
+  plain[length++] = LOADGEN_NAS_PD_EMM;
+  plain[length++] = LOADGEN_NAS_DETACH_REQUEST;
+  plain[length++] = (ue->security.ksi << 4) | 0x01;                // normal detach, EPS detach
+  length += loadgen_nas_encode_guti (&plain[length], &ue->guti);
+  // initial NAS messages are integrity protected only
+  return loadgen_nas_protect (ue, LOADGEN_NAS_SHT_INTEGRITY, plain, length, out);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_tau_request (loadgen_nas_ue_t * const ue, loadgen_nas_buffer_t * const out)
+{
+  uint8_t  plain[32];
+  uint32_t length = 0;
+
+  if ((!ue->security.valid) || (!ue->guti.valid)) {
+    return RETURNerror;
+  }
+  plain[length++] = LOADGEN_NAS_PD_EMM;
+  plain[length++] = LOADGEN_NAS_TAU_REQUEST;
+  plain[length++] = (ue->security.ksi << 4) | 0x00;                // TA updating
+  length += loadgen_nas_encode_guti (&plain[length], &ue->guti);
+  return loadgen_nas_protect (ue, LOADGEN_NAS_SHT_INTEGRITY, plain, length, out);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_service_request (loadgen_nas_ue_t * const ue, loadgen_nas_buffer_t * const out)
+{
+  loadgen_nas_security_t * security = &ue->security;
+  uint8_t                  mac[4];
+
+  if (!security->valid) {
+    return RETURNerror;
+  }
+  // TS 24.301 9.9.3.28: 5 LSB of the uplink count and the 2 LSB of the MAC of the first 2 octets
+  out->data[0] = (LOADGEN_NAS_SHT_SERVICE_REQUEST << 4) | LOADGEN_NAS_PD_EMM;
+  out->data[1] = ((security->ksi & 0x07) << 5) | (security->ul_count & 0x1F);
+  loadgen_nas_mac (security, out->data, 2, security->ul_count, SECU_DIRECTION_UPLINK, mac);
+  out->data[2] = mac[2];
+  out->data[3] = mac[3];
+  out->length = 4;
+  security->ul_count = (security->ul_count + 1) & 0x00FFFFFF;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_nas_attach_complete (loadgen_nas_ue_t * const ue, loadgen_nas_buffer_t * const out)
+{
+  uint8_t  plain[8];
+  uint32_t length = 0;
+
+  plain[length++] = LOADGEN_NAS_PD_EMM;
+  plain[length++] = LOADGEN_NAS_ATTACH_COMPLETE;
+  // ESM message container: activate default EPS bearer context accept
+  plain[length++] = 0x00;
+  plain[length++] = 0x03;
+  plain[length++] = (ue->ebi << 4) | LOADGEN_NAS_PD_ESM;
+  plain[length++] = ue->pti;
+  plain[length++] = LOADGEN_NAS_ESM_ACTIVATE_DEFAULT_BEARER_ACCEPT;
+  return loadgen_nas_protect (ue, LOADGEN_NAS_SHT_INTEGRITY_CIPHERED, plain, length, out);
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_nas_skip_ie (const uint8_t * const ies, const uint32_t length, uint32_t * const offset)
+{
+  const uint8_t iei = ies[*offset];
+
+  if (iei >= 0x80) {                          // type 1 and type 2 IEs
+    *offset += 1;
+  } else if (0x13 == iei) {                   // location area identification
+    *offset += 6;
+  } else if ((0x53 == iei) || (0x17 == iei) || (0x59 == iei) || (0x5A == iei)) {  // EMM cause, GPRS timers
+    *offset += 2;
+  } else if (LOADGEN_NAS_IEI_ESM_MESSAGE_CONTAINER == iei) {                       // TLV-E
+    if ((*offset + 2) >= length) return RETURNerror;
+    *offset += 3 + (((uint32_t)ies[*offset + 1] << 8) | ies[*offset + 2]);
+  } else {
+    if ((*offset + 1) >= length) return RETURNerror;
+    *offset += 2 + ies[*offset + 1];
+  }
+  return (*offset <= length) ? RETURNok : RETURNerror;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * T3346 value (GPRS timer 2, TS 24.008 10.5.7.4) in seconds in the optional IEs of a reject, 0 if absent or deactivated.
+ */
+static uint32_t loadgen_nas_decode_t3346 (const uint8_t * const ies, const uint32_t length, uint32_t offset)
+{
+  static const uint32_t unit_s[8] = {2, 60, 360, 60, 60, 60, 60, 0};  // other values are interpreted as minutes
+
+  while (offset < length) {
+    if ((LOADGEN_NAS_IEI_T3346 == ies[offset]) && ((offset + 3) <= length) && (1 == ies[offset + 1])) {
+      return unit_s[ies[offset + 2] >> 5] * (ies[offset + 2] & 0x1F);
+    }
+    if (RETURNok != loadgen_nas_skip_ie (ies, length, &offset)) {
+      break;
+    }
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static int loadgen_nas_decode_optional_ies (loadgen_nas_ue_t * const ue, const uint8_t * const ies, const uint32_t length,
+                                            uint32_t offset, bool * const guti_reallocated)
+{
+  *guti_reallocated = false;
+  while (offset < length) {
+    if ((LOADGEN_NAS_IEI_GUTI == ies[offset]) && ((offset + 13) <= length) && (11 == ies[offset + 1])) {
+      const uint8_t * guti = &ies[offset + 2];
+      memcpy (ue->guti.plmn, &guti[1], 3);
+      ue->guti.mme_gid  = ((uint16_t)guti[4] << 8) | guti[5];
+      ue->guti.mme_code = guti[6];
+      ue->guti.m_tmsi   = ((uint32_t)guti[7] << 24) | ((uint32_t)guti[8] << 16) | ((uint32_t)guti[9] << 8) | guti[10];
+      ue->guti.valid    = true;
+      *guti_reallocated = true;
+    }
+    if (RETURNok != loadgen_nas_skip_ie (ies, length, &offset)) {
+      return RETURNerror;
+    }
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static loadgen_nas_event_t loadgen_nas_handle_authentication_request (loadgen_nas_ue_t * const ue, const uint8_t * const plain,
+                                                                      const uint32_t length, loadgen_nas_buffer_t * const out)
+{
+  usim_data_t  usim_data = {0};
+  uint8_t      rand[USIM_RAND_SIZE];
+  uint8_t      autn[USIM_AUTN_SIZE];
+  uint8_t      auts[USIM_AUTS_SIZE];
+  uint8_t      res[USIM_RES_SIZE];
+  uint8_t      ck[USIM_CK_SIZE];
+  uint8_t      ik[USIM_IK_SIZE];
+  uint8_t      answer[16];
+  int          rc = RETURNerror;
+
+  // PD, type, KSI, RAND (16), AUTN LV (17)
+  if ((length < 36) || (USIM_AUTN_SIZE != plain[19])) {
+    return LOADGEN_NAS_EVENT_ERROR;
+  }
+  memcpy (usim_data.lte_k, g_loadgen_config.k, USIM_LTE_K_SIZE);
+  memcpy (rand, &plain[3], USIM_RAND_SIZE);
+  memcpy (autn, &plain[20], USIM_AUTN_SIZE);
+  loadgen_nas_milenage_lock ();
+  rc = usim_authenticate (&usim_data, rand, autn, auts, res, ck, ik);
+  if (RETURNok == rc) {
+    rc = usim_generate_kasme (autn, ck, ik, &g_loadgen_config.plmn, ue->security.pending_kasme);
+  }
+  loadgen_nas_milenage_unlock ();
+
+  answer[0] = LOADGEN_NAS_PD_EMM;
+  if (RETURNok != rc) {
+    answer[1] = LOADGEN_NAS_AUTHENTICATION_FAILURE;
+    answer[2] = LOADGEN_NAS_EMM_CAUSE_MAC_FAILURE;
+    loadgen_nas_protect (ue, LOADGEN_NAS_SHT_INTEGRITY_CIPHERED, answer, 3, out);
+    return LOADGEN_NAS_EVENT_ERROR;
+  }
+  ue->security.pending_valid = true;
+  ue->security.pending_ksi   = plain[2] & 0x07;
+  answer[1] = LOADGEN_NAS_AUTHENTICATION_RESPONSE;
+  answer[2] = 8;
+  memcpy (&answer[3], res, 8);
+  return (RETURNok == loadgen_nas_protect (ue, LOADGEN_NAS_SHT_INTEGRITY_CIPHERED, answer, 11, out)) ?
+         LOADGEN_NAS_EVENT_NONE : LOADGEN_NAS_EVENT_ERROR;
+}
+
+//------------------------------------------------------------------------------
+static loadgen_nas_event_t loadgen_nas_handle_security_mode_command (loadgen_nas_ue_t * const ue, const uint8_t * const pdu,
+                                                                     const uint32_t length, loadgen_nas_buffer_t * const out)
+{
+  loadgen_nas_security_t * security = &ue->security;
+  const uint8_t          * plain = &pdu[LOADGEN_NAS_HEADER_SIZE];
+  const uint32_t           plain_length = length - LOADGEN_NAS_HEADER_SIZE;
+  uint8_t                  mac[4];
+  uint8_t                  answer[16];
+  uint32_t                 answer_length = 0;
+  bool                     imeisv_requested = false;
+  uint8_t                  ksi;
+
+  // PD, type, algorithms, KSI, replayed UE security capabilities LV
+  if ((plain_length < 5) || (LOADGEN_NAS_SECURITY_MODE_COMMAND != plain[1]) || (plain_length < (5 + plain[4]))) {
+    return LOADGEN_NAS_EVENT_ERROR;
+  }
+  for (uint32_t offset = 5 + plain[4]; offset < plain_length;) {
+    if (0xC0 == (plain[offset] & 0xF0)) {
+      imeisv_requested = (plain[offset] & 0x07) != 0;
+      offset++;
+    } else if ((0x55 == plain[offset]) || (0x56 == plain[offset])) { // replayed nonceUE, nonceMME
+      offset += 5;
+    } else if (RETURNok != loadgen_nas_skip_ie (plain, plain_length, &offset)) {
+      return LOADGEN_NAS_EVENT_ERROR;
+    }
+  }
+
+  ksi = plain[3] & 0x07;
+  if ((security->pending_valid) && (security->pending_ksi == ksi)) {
+    memcpy (security->kasme, security->pending_kasme, LOADGEN_KASME_SIZE);
+    security->pending_valid = false;
+  } else if ((!security->valid) || (security->ksi != ksi)) {
+    return LOADGEN_NAS_EVENT_ERROR;
+  }
+  security->ksi = ksi;
+  security->eea = (plain[2] >> 4) & 0x07;
+  security->eia = plain[2] & 0x07;
+  derive_key_nas_enc (security->eea, security->kasme, security->knas_enc);
+  derive_key_nas_int (security->eia, security->kasme, security->knas_int);
+  security->dl_count = pdu[5];
+  security->ul_count = 0;
+  loadgen_nas_mac (security, &pdu[5], length - 5, security->dl_count, SECU_DIRECTION_DOWNLINK, mac);
+  if (memcmp (mac, &pdu[1], 4)) {
+    security->valid = false;
+    return LOADGEN_NAS_EVENT_ERROR;
+  }
+  security->valid = true;
+
+  answer[answer_length++] = LOADGEN_NAS_PD_EMM;
+  answer[answer_length++] = LOADGEN_NAS_SECURITY_MODE_COMPLETE;
+  if (imeisv_requested) {
+    answer[answer_length++] = LOADGEN_NAS_IEI_IMEISV;
+    answer_length += loadgen_nas_encode_imeisv (&answer[answer_length], ue->imsi);
+  }
+  return (RETURNok == loadgen_nas_protect (ue, LOADGEN_NAS_SHT_INTEGRITY_CIPHERED_NEW, answer, answer_length, out)) ?
+         LOADGEN_NAS_EVENT_NONE : LOADGEN_NAS_EVENT_ERROR;
+}
+
+//------------------------------------------------------------------------------
+loadgen_nas_event_t loadgen_nas_handle_downlink (loadgen_nas_ue_t * const ue, const uint8_t * const pdu, const uint32_t length,
+                                                 loadgen_nas_buffer_t * const out)
+{
+  loadgen_nas_security_t * security = &ue->security;
+  uint8_t                  deciphered[LOADGEN_NAS_MAX_SIZE];
+  const uint8_t          * plain = pdu;
+  uint32_t                 plain_length = length;
+  uint8_t                  security_header_type;
+  uint8_t                  answer[4];
+  bool                     guti_reallocated = false;
+
+  out->length = 0;
+  if (length < 2) {
+    return LOADGEN_NAS_EVENT_ERROR;
+  }
+  security_header_type = pdu[0] >> 4;
+  if (LOADGEN_NAS_SHT_PLAIN != security_header_type) {
+    if ((LOADGEN_NAS_PD_EMM != (pdu[0] & 0x0F)) || (length < (LOADGEN_NAS_HEADER_SIZE + 2)) ||
+        ((length - LOADGEN_NAS_HEADER_SIZE) > sizeof (deciphered))) {
+      return LOADGEN_NAS_EVENT_ERROR;
+    }
+    if (LOADGEN_NAS_SHT_INTEGRITY_NEW == security_header_type) {
+      return loadgen_nas_handle_security_mode_command (ue, pdu, length, out);
+    }
+    if (!security->valid) {
+      return LOADGEN_NAS_EVENT_ERROR;
+    }
+    // estimate the downlink count from its 8 LSB
+    uint32_t count = (security->dl_count & 0x00FFFF00) | pdu[5];
+    uint8_t  mac[4];
+    if (count < security->dl_count) {
+      count += 0x100;
+    }
+    loadgen_nas_mac (security, &pdu[5], length - 5, count, SECU_DIRECTION_DOWNLINK, mac);
+    if (memcmp (mac, &pdu[1], 4)) {
+      return LOADGEN_NAS_EVENT_ERROR;
+    }
+    security->dl_count = count;
+    plain_length = length - LOADGEN_NAS_HEADER_SIZE;
+    if ((LOADGEN_NAS_SHT_INTEGRITY_CIPHERED == security_header_type) || (LOADGEN_NAS_SHT_INTEGRITY_CIPHERED_NEW == security_header_type)) {
+      loadgen_nas_cipher (security, &pdu[LOADGEN_NAS_HEADER_SIZE], plain_length, count, SECU_DIRECTION_DOWNLINK, deciphered);
+      plain = deciphered;
+    } else {
+      plain = &pdu[LOADGEN_NAS_HEADER_SIZE];
+    }
+  }
+  if ((plain_length < 2) || (LOADGEN_NAS_PD_EMM != plain[0])) {
+    // ESM messages outside of an EMM container are not used by the simulated procedures
+    return LOADGEN_NAS_EVENT_NONE;
+  }
+
+  switch (plain[1]) {
+    case LOADGEN_NAS_AUTHENTICATION_REQUEST:
+      return loadgen_nas_handle_authentication_request (ue, plain, plain_length, out);
+
+    case LOADGEN_NAS_IDENTITY_REQUEST: {
+        uint8_t  identity[16];
+        uint32_t identity_length = 2;
+
+        identity[0] = LOADGEN_NAS_PD_EMM;
+        identity[1] = LOADGEN_NAS_IDENTITY_RESPONSE;
+        identity_length += loadgen_nas_encode_imsi (&identity[identity_length], ue->imsi);
+        loadgen_nas_protect (ue, LOADGEN_NAS_SHT_INTEGRITY_CIPHERED, identity, identity_length, out);
+        return LOADGEN_NAS_EVENT_NONE;
+      }
+
+    case LOADGEN_NAS_ATTACH_ACCEPT: {
+        // PD, type, result, T3412, TAI list LV, ESM message container LV-E
+        uint32_t offset = 4;
+        uint32_t esm_length;
+
+        if ((plain_length < 5) || ((offset + 1 + plain[offset] + 2) > plain_length)) {
+          return LOADGEN_NAS_EVENT_ERROR;
+        }
+        offset += 1 + plain[offset];
+        esm_length = ((uint32_t)plain[offset] << 8) | plain[offset + 1];
+        offset += 2;
+        if ((esm_length < 3) || ((offset + esm_length) > plain_length)) {
+          return LOADGEN_NAS_EVENT_ERROR;
+        }
+        // activate default EPS bearer context request
+        ue->ebi = plain[offset] >> 4;
+        ue->pti = plain[offset + 1];
+        offset += esm_length;
+        if (RETURNok != loadgen_nas_decode_optional_ies (ue, plain, plain_length, offset, &guti_reallocated)) {
+          return LOADGEN_NAS_EVENT_ERROR;
+        }
+        return (ue->guti.valid) ? LOADGEN_NAS_EVENT_ATTACH_ACCEPT : LOADGEN_NAS_EVENT_ERROR;
+      }
+
+    case LOADGEN_NAS_TAU_ACCEPT:
+      if (RETURNok != loadgen_nas_decode_optional_ies (ue, plain, plain_length, 3, &guti_reallocated)) {
+        return LOADGEN_NAS_EVENT_ERROR;
+      }
+      if (guti_reallocated) {
+        answer[0] = LOADGEN_NAS_PD_EMM;
+        answer[1] = LOADGEN_NAS_TAU_COMPLETE;
+        loadgen_nas_protect (ue, LOADGEN_NAS_SHT_INTEGRITY_CIPHERED, answer, 2, out);
+      }
+      return LOADGEN_NAS_EVENT_TAU_ACCEPT;
+
+    case LOADGEN_NAS_DETACH_ACCEPT:
+      return LOADGEN_NAS_EVENT_DETACH_ACCEPT;
+
+    case LOADGEN_NAS_DETACH_REQUEST:
+      answer[0] = LOADGEN_NAS_PD_EMM;
+      answer[1] = LOADGEN_NAS_DETACH_ACCEPT;
+      loadgen_nas_protect (ue, LOADGEN_NAS_SHT_INTEGRITY_CIPHERED, answer, 2, out);
+      ue->guti.valid = false;
+      return LOADGEN_NAS_EVENT_NETWORK_DETACH;
+
+    case LOADGEN_NAS_AUTHENTICATION_REJECT:
+      memset (security, 0, sizeof (*security));
+      ue->guti.valid = false;
+      ue->emm_cause = 0;
+      ue->backoff_s = 0;
+      return LOADGEN_NAS_EVENT_REJECT;
+
+    case LOADGEN_NAS_ATTACH_REJECT:
+    case LOADGEN_NAS_TAU_REJECT:
+    case LOADGEN_NAS_SERVICE_REJECT:
+      // PD, type, EMM cause, optional IEs
+      ue->emm_cause = (plain_length > 2) ? plain[2] : 0;
+      ue->backoff_s = loadgen_nas_decode_t3346 (plain, plain_length, 3);
+      if ((LOADGEN_NAS_ATTACH_REJECT == plain[1]) && (LOADGEN_NAS_EMM_CAUSE_CONGESTION != ue->emm_cause)) {
+        // the EPS security context and the GUTI are kept on congestion only
+        memset (security, 0, sizeof (*security));
+        ue->guti.valid = false;
+      }
+      return LOADGEN_NAS_EVENT_REJECT;
+
+    default:
+      // EMM information, ...
+      return LOADGEN_NAS_EVENT_NONE;
+  }
+}
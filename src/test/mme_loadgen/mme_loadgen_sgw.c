@@ -0,0 +1,449 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_loadgen_sgw.c
+  \brief Stub SGW of the load generator, S11 GTPv2-C over UDP (TS 29.274).
+
+  Answers the session management requests of the MME with fixed bearer parameters
+  and originates downlink data notifications for the paging scenarios.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "bstrlib.h"
+
+#include "common_defs.h"
+#include "NwGtpv2c.h"
+#include "NwGtpv2cIe.h"
+#include "NwGtpv2cMsg.h"
+#include "3gpp_29.274.h"
+#include "mme_loadgen.h"
+
+#define LOADGEN_GTPV2C_VERSION_T_FLAG     0x48
+#define LOADGEN_GTPV2C_HEADER_SIZE        12
+#define LOADGEN_GTPV2C_IE_HEADER_SIZE     4
+#define LOADGEN_GTPV2C_MAX_SIZE           1024
+#define LOADGEN_SGW_UE_POOL               0x0A000001   // 10.0.0.1, PAA of the first UE
+#define LOADGEN_SGW_DDN_QUEUE_SIZE        4096
+
+typedef struct loadgen_gtpv2c_msg_s {
+  uint32_t          length;
+  uint8_t           data[LOADGEN_GTPV2C_MAX_SIZE];
+} loadgen_gtpv2c_msg_t;
+
+/*
+ * One session per UE, the SGW S11 TEID is the index of the UE + 1
+ */
+typedef struct loadgen_sgw_session_s {
+  bool              active;
+  uint32_t          mme_teid;
+  struct sockaddr_in mme_addr;
+  uint8_t           ebi;
+} loadgen_sgw_session_t;
+
+static pthread_t                        loadgen_sgw_thread;
+static int                              loadgen_sgw_fd = -1;
+static int                              loadgen_sgw_event_fd = -1;
+static loadgen_sgw_session_t           *loadgen_sgw_sessions = NULL;
+static uint32_t                         loadgen_sgw_sequence_number = 0x100000;
+
+static pthread_mutex_t                  loadgen_sgw_ddn_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t                         loadgen_sgw_ddn_queue[LOADGEN_SGW_DDN_QUEUE_SIZE];
+static uint32_t                         loadgen_sgw_ddn_head = 0;
+static uint32_t                         loadgen_sgw_ddn_tail = 0;
+
+//------------------------------------------------------------------------------
+static void loadgen_gtpv2c_header (loadgen_gtpv2c_msg_t * const msg, const uint8_t type, const uint32_t teid, const uint32_t sequence_number)
+{
+  msg->data[0]  = LOADGEN_GTPV2C_VERSION_T_FLAG;
+  msg->data[1]  = type;
+  msg->data[4]  = teid >> 24;
+  msg->data[5]  = (teid >> 16) & 0xFF;
+  msg->data[6]  = (teid >> 8) & 0xFF;
+  msg->data[7]  = teid & 0xFF;
+  msg->data[8]  = (sequence_number >> 16) & 0xFF;
+  msg->data[9]  = (sequence_number >> 8) & 0xFF;
+  msg->data[10] = sequence_number & 0xFF;
+  msg->data[11] = 0;
+  msg->length   = LOADGEN_GTPV2C_HEADER_SIZE;
+}
+
+//------------------------------------------------------------------------------
+static uint32_t loadgen_gtpv2c_ie_begin (loadgen_gtpv2c_msg_t * const msg, const uint8_t type, const uint8_t instance)
+{
+  uint32_t start = msg->length;
+
+  msg->data[msg->length]     = type;
+  msg->data[msg->length + 3] = instance & 0x0F;
+  msg->length += LOADGEN_GTPV2C_IE_HEADER_SIZE;
+  return start;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_gtpv2c_ie_end (loadgen_gtpv2c_msg_t * const msg, const uint32_t start)
+{
+  uint32_t length = msg->length - start - LOADGEN_GTPV2C_IE_HEADER_SIZE;
+
+  msg->data[start + 1] = length >> 8;
+  msg->data[start + 2] = length & 0xFF;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_gtpv2c_ie (loadgen_gtpv2c_msg_t * const msg, const uint8_t type, const uint8_t instance, const void * const value, const uint32_t length)
+{
+  uint32_t start = loadgen_gtpv2c_ie_begin (msg, type, instance);
+
+  memcpy (&msg->data[msg->length], value, length);
+  msg->length += length;
+  loadgen_gtpv2c_ie_end (msg, start);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_gtpv2c_ie_cause (loadgen_gtpv2c_msg_t * const msg, const uint8_t cause)
+{
+  uint8_t value[2] = {cause, 0};
+
+  loadgen_gtpv2c_ie (msg, NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, value, sizeof (value));
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_gtpv2c_ie_fteid (loadgen_gtpv2c_msg_t * const msg, const uint8_t instance, const uint8_t interface_type, const uint32_t teid)
+{
+  uint8_t value[9];
+
+  value[0] = 0x80 | interface_type;  // V4
+  value[1] = teid >> 24;
+  value[2] = (teid >> 16) & 0xFF;
+  value[3] = (teid >> 8) & 0xFF;
+  value[4] = teid & 0xFF;
+  memcpy (&value[5], &g_loadgen_config.local_addr.s_addr, 4);
+  loadgen_gtpv2c_ie (msg, NW_GTPV2C_IE_FTEID, instance, value, sizeof (value));
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_gtpv2c_finish (loadgen_gtpv2c_msg_t * const msg)
+{
+  uint32_t length = msg->length - 4;
+
+  msg->data[2] = length >> 8;
+  msg->data[3] = length & 0xFF;
+}
+
+//------------------------------------------------------------------------------
+static const uint8_t *loadgen_gtpv2c_ie_find (const uint8_t * const ies, const uint32_t length, const uint8_t type, const uint8_t instance,
+                                              uint16_t * const ie_length)
+{
+  uint32_t offset = 0;
+
+  while ((offset + LOADGEN_GTPV2C_IE_HEADER_SIZE) <= length) {
+    uint16_t l = ((uint16_t)ies[offset + 1] << 8) | ies[offset + 2];
+
+    if ((offset + LOADGEN_GTPV2C_IE_HEADER_SIZE + l) > length) {
+      return NULL;
+    }
+    if ((ies[offset] == type) && ((ies[offset + 3] & 0x0F) == instance)) {
+      *ie_length = l;
+      return &ies[offset + LOADGEN_GTPV2C_IE_HEADER_SIZE];
+    }
+    offset += LOADGEN_GTPV2C_IE_HEADER_SIZE + l;
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_sgw_send (const loadgen_gtpv2c_msg_t * const msg, const struct sockaddr_in * const peer)
+{
+  if (sendto (loadgen_sgw_fd, msg->data, msg->length, 0, (const struct sockaddr *)peer, sizeof (*peer)) < 0) {
+    perror ("SGW stub sendto");
+  }
+}
+
+//------------------------------------------------------------------------------
+static loadgen_sgw_session_t *loadgen_sgw_session (const uint32_t sgw_teid)
+{
+  if ((0 == sgw_teid) || (sgw_teid > g_loadgen_config.num_ues)) {
+    return NULL;
+  }
+  return &loadgen_sgw_sessions[sgw_teid - 1];
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_sgw_create_session (const uint8_t * const ies, const uint32_t length, const uint32_t sequence_number,
+                                        const struct sockaddr_in * const peer)
+{
+  loadgen_gtpv2c_msg_t    rsp;
+  uint16_t                imsi_length = 0;
+  uint16_t                fteid_length = 0;
+  uint16_t                bc_length = 0;
+  const uint8_t         * imsi_ie = loadgen_gtpv2c_ie_find (ies, length, NW_GTPV2C_IE_IMSI, NW_GTPV2C_IE_INSTANCE_ZERO, &imsi_length);
+  const uint8_t         * fteid_ie = loadgen_gtpv2c_ie_find (ies, length, NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, &fteid_length);
+  const uint8_t         * bc_ie = loadgen_gtpv2c_ie_find (ies, length, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, &bc_length);
+  uint64_t                imsi = 0;
+  uint32_t                mme_teid = 0;
+  uint8_t                 ebi = 5;
+
+  for (uint16_t i = 0; (imsi_ie) && (i < imsi_length); i++) {
+    if ((imsi_ie[i] & 0x0F) != 0x0F) imsi = (imsi * 10) + (imsi_ie[i] & 0x0F);
+    if ((imsi_ie[i] >> 4) != 0x0F)   imsi = (imsi * 10) + (imsi_ie[i] >> 4);
+  }
+  if ((fteid_ie) && (fteid_length >= 5)) {
+    mme_teid = ((uint32_t)fteid_ie[1] << 24) | ((uint32_t)fteid_ie[2] << 16) | ((uint32_t)fteid_ie[3] << 8) | fteid_ie[4];
+  }
+  if (bc_ie) {
+    uint16_t        ebi_length = 0;
+    const uint8_t * ebi_ie = loadgen_gtpv2c_ie_find (bc_ie, bc_length, NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, &ebi_length);
+    if ((ebi_ie) && (ebi_length)) ebi = ebi_ie[0] & 0x0F;
+  }
+
+  const uint64_t ue_index = imsi - g_loadgen_config.imsi_base;
+  if ((imsi < g_loadgen_config.imsi_base) || (ue_index >= g_loadgen_config.num_ues)) {
+    loadgen_gtpv2c_header (&rsp, NW_GTP_CREATE_SESSION_RSP, mme_teid, sequence_number);
+    loadgen_gtpv2c_ie_cause (&rsp, CONTEXT_NOT_FOUND);
+    loadgen_gtpv2c_finish (&rsp);
+    loadgen_sgw_send (&rsp, peer);
+    return;
+  }
+
+  loadgen_sgw_session_t * session = &loadgen_sgw_sessions[ue_index];
+  const uint32_t          sgw_teid = ue_index + 1;
+  const uint32_t          ue_ipv4 = htonl (LOADGEN_SGW_UE_POOL + ue_index);
+  uint8_t                 paa[5] = {0x01};
+  uint8_t                 apn_restriction = 0;
+  uint8_t                 ambr[8] = {0x00, 0x00, 0xC3, 0x50, 0x00, 0x01, 0x86, 0xA0};   // 50/100 Mbps in kbps
+  uint8_t                 qos[22] = {(15 << 2) | 0x01, 9};
+
+  __atomic_store_n (&session->mme_teid, mme_teid, __ATOMIC_RELAXED);
+  session->mme_addr = *peer;
+  session->ebi      = ebi;
+  __atomic_store_n (&session->active, true, __ATOMIC_RELEASE);
+
+  memcpy (&paa[1], &ue_ipv4, 4);
+  loadgen_gtpv2c_header (&rsp, NW_GTP_CREATE_SESSION_RSP, mme_teid, sequence_number);
+  loadgen_gtpv2c_ie_cause (&rsp, NW_GTPV2C_CAUSE_REQUEST_ACCEPTED);
+  loadgen_gtpv2c_ie_fteid (&rsp, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IFTYPE_S11S4_SGW_GTPC, sgw_teid);
+  loadgen_gtpv2c_ie_fteid (&rsp, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IFTYPE_S5S8_PGW_GTPC, sgw_teid);
+  loadgen_gtpv2c_ie (&rsp, NW_GTPV2C_IE_PAA, NW_GTPV2C_IE_INSTANCE_ZERO, paa, sizeof (paa));
+  loadgen_gtpv2c_ie (&rsp, NW_GTPV2C_IE_APN_RESTRICTION, NW_GTPV2C_IE_INSTANCE_ZERO, &apn_restriction, 1);
+  loadgen_gtpv2c_ie (&rsp, NW_GTPV2C_IE_AMBR, NW_GTPV2C_IE_INSTANCE_ZERO, ambr, sizeof (ambr));
+
+  uint32_t bearer_context = loadgen_gtpv2c_ie_begin (&rsp, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO);
+  loadgen_gtpv2c_ie (&rsp, NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, &ebi, 1);
+  loadgen_gtpv2c_ie_cause (&rsp, NW_GTPV2C_CAUSE_REQUEST_ACCEPTED);
+  loadgen_gtpv2c_ie_fteid (&rsp, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IFTYPE_S1U_SGW_GTPU, sgw_teid);
+  loadgen_gtpv2c_ie_fteid (&rsp, NW_GTPV2C_IE_INSTANCE_TWO, NW_GTPV2C_IFTYPE_S5S8_PGW_GTPU, sgw_teid);
+  loadgen_gtpv2c_ie (&rsp, NW_GTPV2C_IE_BEARER_LEVEL_QOS, NW_GTPV2C_IE_INSTANCE_ZERO, qos, sizeof (qos));
+  loadgen_gtpv2c_ie_end (&rsp, bearer_context);
+
+  loadgen_gtpv2c_finish (&rsp);
+  loadgen_sgw_send (&rsp, peer);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_sgw_session_response (const uint8_t type, const uint32_t sgw_teid, const uint32_t sequence_number,
+                                          const struct sockaddr_in * const peer)
+{
+  loadgen_gtpv2c_msg_t    rsp;
+  loadgen_sgw_session_t * session = loadgen_sgw_session (sgw_teid);
+  const bool              found = (session) && __atomic_load_n (&session->active, __ATOMIC_ACQUIRE);
+
+  loadgen_gtpv2c_header (&rsp, type, (found) ? session->mme_teid : 0, sequence_number);
+  loadgen_gtpv2c_ie_cause (&rsp, (found) ? NW_GTPV2C_CAUSE_REQUEST_ACCEPTED : CONTEXT_NOT_FOUND);
+  if ((found) && (NW_GTP_MODIFY_BEARER_RSP == type)) {
+    uint32_t bearer_context = loadgen_gtpv2c_ie_begin (&rsp, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO);
+    loadgen_gtpv2c_ie (&rsp, NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, &session->ebi, 1);
+    loadgen_gtpv2c_ie_cause (&rsp, NW_GTPV2C_CAUSE_REQUEST_ACCEPTED);
+    loadgen_gtpv2c_ie_end (&rsp, bearer_context);
+  }
+  if ((found) && (NW_GTP_DELETE_SESSION_RSP == type)) {
+    __atomic_store_n (&session->active, false, __ATOMIC_RELEASE);
+  }
+  loadgen_gtpv2c_finish (&rsp);
+  loadgen_sgw_send (&rsp, peer);
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_sgw_handle_message (const uint8_t * const data, const uint32_t length, const struct sockaddr_in * const peer)
+{
+  loadgen_gtpv2c_msg_t  rsp;
+  const bool            has_teid = (data[0] & 0x08);
+  const uint32_t        header_size = (has_teid) ? LOADGEN_GTPV2C_HEADER_SIZE : 8;
+  uint32_t              teid = 0;
+  uint32_t              sequence_number;
+
+  if ((length < header_size) || (2 != (data[0] >> 5))) {
+    return;
+  }
+  if (has_teid) {
+    teid = ((uint32_t)data[4] << 24) | ((uint32_t)data[5] << 16) | ((uint32_t)data[6] << 8) | data[7];
+  }
+  sequence_number = ((uint32_t)data[header_size - 4] << 16) | ((uint32_t)data[header_size - 3] << 8) | data[header_size - 2];
+
+  switch (data[1]) {
+    case NW_GTP_ECHO_REQ: {
+        uint8_t recovery = 1;
+        rsp.length = 8;
+        rsp.data[0] = 0x40;
+        rsp.data[1] = NW_GTP_ECHO_RSP;
+        memcpy (&rsp.data[4], &data[4], 4);
+        loadgen_gtpv2c_ie (&rsp, NW_GTPV2C_IE_RECOVERY, NW_GTPV2C_IE_INSTANCE_ZERO, &recovery, 1);
+        loadgen_gtpv2c_finish (&rsp);
+        loadgen_sgw_send (&rsp, peer);
+      }
+      break;
+    case NW_GTP_CREATE_SESSION_REQ:
+      loadgen_sgw_create_session (&data[header_size], length - header_size, sequence_number, peer);
+      break;
+    case NW_GTP_MODIFY_BEARER_REQ:
+      loadgen_sgw_session_response (NW_GTP_MODIFY_BEARER_RSP, teid, sequence_number, peer);
+      break;
+    case NW_GTP_DELETE_SESSION_REQ:
+      loadgen_sgw_session_response (NW_GTP_DELETE_SESSION_RSP, teid, sequence_number, peer);
+      break;
+    case NW_GTP_RELEASE_ACCESS_BEARERS_REQ:
+      loadgen_sgw_session_response (NW_GTP_RELEASE_ACCESS_BEARERS_RSP, teid, sequence_number, peer);
+      break;
+    default:
+      // responses to our downlink data notifications, nothing to do
+      break;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void loadgen_sgw_send_downlink_data_notifications (void)
+{
+  uint64_t             value;
+
+  if (read (loadgen_sgw_event_fd, &value, sizeof (value)) < 0) {
+    return;
+  }
+  pthread_mutex_lock (&loadgen_sgw_ddn_mutex);
+  while (loadgen_sgw_ddn_head != loadgen_sgw_ddn_tail) {
+    loadgen_sgw_session_t * session = &loadgen_sgw_sessions[loadgen_sgw_ddn_queue[loadgen_sgw_ddn_head]];
+    loadgen_gtpv2c_msg_t    ddn;
+
+    loadgen_sgw_ddn_head = (loadgen_sgw_ddn_head + 1) % LOADGEN_SGW_DDN_QUEUE_SIZE;
+    if (!__atomic_load_n (&session->active, __ATOMIC_ACQUIRE)) {
+      continue;
+    }
+    loadgen_gtpv2c_header (&ddn, NW_GTP_DOWNLINK_DATA_NOTIFICATION, session->mme_teid, loadgen_sgw_sequence_number++ & 0xFFFFFF);
+    loadgen_gtpv2c_ie (&ddn, NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, &session->ebi, 1);
+    loadgen_gtpv2c_finish (&ddn);
+    loadgen_sgw_send (&ddn, &session->mme_addr);
+  }
+  pthread_mutex_unlock (&loadgen_sgw_ddn_mutex);
+}
+
+//------------------------------------------------------------------------------
+int loadgen_sgw_downlink_data_notification (const uint64_t imsi)
+{
+  const uint64_t ue_index = imsi - g_loadgen_config.imsi_base;
+  uint64_t       one = 1;
+  int            rc = RETURNerror;
+
+  if ((!loadgen_sgw_sessions) || (imsi < g_loadgen_config.imsi_base) || (ue_index >= g_loadgen_config.num_ues) ||
+      (!__atomic_load_n (&loadgen_sgw_sessions[ue_index].active, __ATOMIC_ACQUIRE))) {
+    return RETURNerror;
+  }
+  pthread_mutex_lock (&loadgen_sgw_ddn_mutex);
+  if (((loadgen_sgw_ddn_tail + 1) % LOADGEN_SGW_DDN_QUEUE_SIZE) != loadgen_sgw_ddn_head) {
+    loadgen_sgw_ddn_queue[loadgen_sgw_ddn_tail] = ue_index;
+    loadgen_sgw_ddn_tail = (loadgen_sgw_ddn_tail + 1) % LOADGEN_SGW_DDN_QUEUE_SIZE;
+    rc = RETURNok;
+  }
+  pthread_mutex_unlock (&loadgen_sgw_ddn_mutex);
+  if (RETURNok == rc) {
+    rc = (write (loadgen_sgw_event_fd, &one, sizeof (one)) == sizeof (one)) ? RETURNok : RETURNerror;
+  }
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static void *loadgen_sgw_thread_function (void *args_p)
+{
+  struct pollfd      fds[2] = {{.fd = loadgen_sgw_fd, .events = POLLIN}, {.fd = loadgen_sgw_event_fd, .events = POLLIN}};
+  uint8_t            buffer[LOADGEN_GTPV2C_MAX_SIZE];
+
+  while (g_loadgen_running) {
+    if (poll (fds, 2, 100) <= 0) {
+      continue;
+    }
+    if (fds[1].revents & POLLIN) {
+      loadgen_sgw_send_downlink_data_notifications ();
+    }
+    if (fds[0].revents & POLLIN) {
+      struct sockaddr_in peer;
+      socklen_t          peer_length = sizeof (peer);
+      ssize_t            length = recvfrom (loadgen_sgw_fd, buffer, sizeof (buffer), 0, (struct sockaddr *)&peer, &peer_length);
+
+      if (length > 0) {
+        loadgen_sgw_handle_message (buffer, length, &peer);
+      }
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+int loadgen_sgw_start (void)
+{
+  struct sockaddr_in addr = {0};
+
+  loadgen_sgw_sessions = calloc (g_loadgen_config.num_ues, sizeof (loadgen_sgw_session_t));
+  loadgen_sgw_fd = socket (AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  loadgen_sgw_event_fd = eventfd (0, EFD_NONBLOCK);
+  if ((!loadgen_sgw_sessions) || (loadgen_sgw_fd < 0) || (loadgen_sgw_event_fd < 0)) {
+    perror ("SGW stub socket");
+    return RETURNerror;
+  }
+  addr.sin_family = AF_INET;
+  addr.sin_port   = htons (g_loadgen_config.sgw_port);
+  addr.sin_addr   = g_loadgen_config.local_addr;
+  if (bind (loadgen_sgw_fd, (struct sockaddr *)&addr, sizeof (addr)) < 0) {
+    perror ("SGW stub bind");
+    return RETURNerror;
+  }
+  if (pthread_create (&loadgen_sgw_thread, NULL, loadgen_sgw_thread_function, NULL)) {
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void loadgen_sgw_stop (void)
+{
+  pthread_join (loadgen_sgw_thread, NULL);
+  close (loadgen_sgw_fd);
+  close (loadgen_sgw_event_fd);
+  free (loadgen_sgw_sessions);
+  loadgen_sgw_sessions = NULL;
+}
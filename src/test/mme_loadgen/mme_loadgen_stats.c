@@ -0,0 +1,187 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mme_loadgen_stats.c
+  \brief Procedure latency histograms and throughput report of the load generator.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "mme_loadgen.h"
+
+static const char * const loadgen_procedure_names[LOADGEN_PROC_MAX] = {
+  "attach", "detach", "tau", "service_request", "paging", "release"
+};
+
+//------------------------------------------------------------------------------
+const char *loadgen_procedure_name (const loadgen_procedure_t procedure)
+{
+  return (procedure < LOADGEN_PROC_MAX) ? loadgen_procedure_names[procedure] : "unknown";
+}
+
+//------------------------------------------------------------------------------
+uint64_t loadgen_now_us (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t loadgen_histogram_index (const uint64_t value_us)
+{
+  if (value_us < LOADGEN_HISTO_SUB_BUCKETS) {
+    return (uint32_t)value_us;
+  }
+  uint32_t exponent = 63 - __builtin_clzll (value_us);  // >= LOADGEN_HISTO_SUB_BUCKET_BITS
+  uint32_t shift = exponent - LOADGEN_HISTO_SUB_BUCKET_BITS;
+
+  if (exponent >= LOADGEN_HISTO_MAX_EXPONENT) {
+    return LOADGEN_HISTO_BUCKETS - 1;
+  }
+  return ((shift + 1) << LOADGEN_HISTO_SUB_BUCKET_BITS) + ((value_us >> shift) & (LOADGEN_HISTO_SUB_BUCKETS - 1));
+}
+
+//------------------------------------------------------------------------------
+static inline uint64_t loadgen_histogram_bucket_high (const uint32_t index)
+{
+  if (index < (2 * LOADGEN_HISTO_SUB_BUCKETS)) {
+    return index;
+  }
+  uint32_t shift = (index >> LOADGEN_HISTO_SUB_BUCKET_BITS) - 1;
+  uint64_t low = ((uint64_t)(LOADGEN_HISTO_SUB_BUCKETS | (index & (LOADGEN_HISTO_SUB_BUCKETS - 1)))) << shift;
+
+  return low + (1ULL << shift) - 1;
+}
+
+//------------------------------------------------------------------------------
+void loadgen_stats_record (loadgen_stats_t * const stats, const loadgen_procedure_t procedure, const uint64_t latency_us)
+{
+  loadgen_histogram_t * histogram = &stats->latency[procedure];
+  uint32_t              index = loadgen_histogram_index (latency_us);
+
+  // single writer, relaxed atomics only make the concurrent report read consistent words
+  __atomic_store_n (&histogram->buckets[index], histogram->buckets[index] + 1, __ATOMIC_RELAXED);
+  __atomic_store_n (&histogram->sum_us, histogram->sum_us + latency_us, __ATOMIC_RELAXED);
+  if (latency_us > histogram->max_us) {
+    __atomic_store_n (&histogram->max_us, latency_us, __ATOMIC_RELAXED);
+  }
+  __atomic_store_n (&histogram->count, histogram->count + 1, __ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+void loadgen_stats_failure (loadgen_stats_t * const stats, const loadgen_procedure_t procedure, const bool timeout)
+{
+  if (timeout) {
+    __atomic_store_n (&stats->timeouts[procedure], stats->timeouts[procedure] + 1, __ATOMIC_RELAXED);
+  } else {
+    __atomic_store_n (&stats->failures[procedure], stats->failures[procedure] + 1, __ATOMIC_RELAXED);
+  }
+}
+
+//------------------------------------------------------------------------------
+void loadgen_stats_merge (loadgen_stats_t * const total, const loadgen_stats_t * const stats)
+{
+  for (int p = 0; p < LOADGEN_PROC_MAX; p++) {
+    const loadgen_histogram_t * histogram = &stats->latency[p];
+    uint64_t                    max_us = __atomic_load_n (&histogram->max_us, __ATOMIC_RELAXED);
+
+    total->latency[p].count  += __atomic_load_n (&histogram->count, __ATOMIC_ACQUIRE);
+    total->latency[p].sum_us += __atomic_load_n (&histogram->sum_us, __ATOMIC_RELAXED);
+    if (max_us > total->latency[p].max_us) {
+      total->latency[p].max_us = max_us;
+    }
+    for (int b = 0; b < LOADGEN_HISTO_BUCKETS; b++) {
+      total->latency[p].buckets[b] += __atomic_load_n (&histogram->buckets[b], __ATOMIC_RELAXED);
+    }
+    total->failures[p] += __atomic_load_n (&stats->failures[p], __ATOMIC_RELAXED);
+    total->timeouts[p] += __atomic_load_n (&stats->timeouts[p], __ATOMIC_RELAXED);
+  }
+  total->s1ap_tx += __atomic_load_n (&stats->s1ap_tx, __ATOMIC_RELAXED);
+  total->s1ap_rx += __atomic_load_n (&stats->s1ap_rx, __ATOMIC_RELAXED);
+  total->rrc_rejects += __atomic_load_n (&stats->rrc_rejects, __ATOMIC_RELAXED);
+  total->nas_backoffs += __atomic_load_n (&stats->nas_backoffs, __ATOMIC_RELAXED);
+  total->overload_starts += __atomic_load_n (&stats->overload_starts, __ATOMIC_RELAXED);
+  total->overload_stops += __atomic_load_n (&stats->overload_stops, __ATOMIC_RELAXED);
+}
+
+//------------------------------------------------------------------------------
+static uint64_t loadgen_histogram_percentile (const loadgen_histogram_t * const histogram, const uint64_t count, const double percentile)
+{
+  uint64_t rank = (uint64_t)((percentile / 100.0) * count + 0.5);
+  uint64_t seen = 0;
+
+  if (!rank) rank = 1;
+  for (int b = 0; b < LOADGEN_HISTO_BUCKETS; b++) {
+    seen += histogram->buckets[b];
+    if (seen >= rank) {
+      uint64_t high = loadgen_histogram_bucket_high (b);
+      return (high < histogram->max_us) ? high : histogram->max_us;
+    }
+  }
+  return histogram->max_us;
+}
+
+//------------------------------------------------------------------------------
+uint64_t loadgen_stats_percentile (const loadgen_stats_t * const total, const loadgen_procedure_t procedure, const double percentile)
+{
+  const loadgen_histogram_t * histogram = &total->latency[procedure];
+
+  return (histogram->count) ? loadgen_histogram_percentile (histogram, histogram->count, percentile) : 0;
+}
+
+//------------------------------------------------------------------------------
+void loadgen_stats_report (const loadgen_stats_t * const total, const loadgen_stats_t * const previous, const double elapsed_s, const double interval_s, const bool final)
+{
+  fprintf (stdout, "%s at %.1f s: s1ap tx %lu rx %lu\n", (final) ? "FINAL REPORT" : "report", elapsed_s, total->s1ap_tx, total->s1ap_rx);
+  fprintf (stdout, "  %-16s %10s %10s %8s %8s %10s %10s %10s %10s %10s %10s\n",
+           "procedure", "completed", "rate/s", "failed", "timeout", "mean(us)", "p50(us)", "p90(us)", "p99(us)", "p99.9(us)", "max(us)");
+  for (int p = 0; p < LOADGEN_PROC_MAX; p++) {
+    const loadgen_histogram_t * histogram = &total->latency[p];
+    uint64_t                    count = histogram->count;
+    // interval rate in periodic reports, average rate in the final one
+    double                      rate = (final || !previous) ?
+                                         ((elapsed_s > 0) ? count / elapsed_s : 0) :
+                                         ((interval_s > 0) ? (count - previous->latency[p].count) / interval_s : 0);
+
+    if ((!count) && (!total->failures[p]) && (!total->timeouts[p])) {
+      continue;
+    }
+    fprintf (stdout, "  %-16s %10lu %10.1f %8lu %8lu %10lu %10lu %10lu %10lu %10lu %10lu\n",
+             loadgen_procedure_name (p), count, rate, total->failures[p], total->timeouts[p],
+             (count) ? histogram->sum_us / count : 0,
+             (count) ? loadgen_histogram_percentile (histogram, count, 50.0) : 0,
+             (count) ? loadgen_histogram_percentile (histogram, count, 90.0) : 0,
+             (count) ? loadgen_histogram_percentile (histogram, count, 99.0) : 0,
+             (count) ? loadgen_histogram_percentile (histogram, count, 99.9) : 0,
+             histogram->max_us);
+  }
+  if ((total->overload_starts) || (total->rrc_rejects) || (total->nas_backoffs)) {
+    fprintf (stdout, "  overload start %lu stop %lu, rrc rejects %lu, nas back-offs %lu\n",
+             total->overload_starts, total->overload_stops, total->rrc_rejects, total->nas_backoffs);
+  }
+  fflush (stdout);
+}
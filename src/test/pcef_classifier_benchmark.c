@@ -0,0 +1,253 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Offline benchmark of the PCEF SDF classifier.
+ * Compiles a set of synthetic TFT packet filters, classifies synthetic traffic,
+ * and checks every result against a linear scan of the filters.
+ *
+ * usage: pcef_classifier_benchmark [num_filters] [num_packets] [seed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include "common_defs.h"
+#include "3gpp_24.008.h"
+#include "pgw_pcef_classifier.h"
+
+#define DEFAULT_NUM_FILTERS  4096
+#define DEFAULT_NUM_PACKETS  (1024*1024)
+#define NUM_UES              1024
+
+typedef struct bench_filter_s {
+  packet_filter_t   pf;
+  struct in_addr    ue;
+  uint32_t          result;
+  uint32_t          order;
+} bench_filter_t;
+
+static struct in_addr                   ue_addr[NUM_UES];
+static const uint8_t                    protocols[] = {IPPROTO_TCP, IPPROTO_UDP, IPPROTO_ESP, IPPROTO_ICMP};
+static const uint16_t                   ports[] = {53, 80, 443, 5060, 8080, 1935, 554, 4500};
+
+//------------------------------------------------------------------------------
+static void set_remote_ipv4 (packet_filter_contents_t * const pfc, const uint32_t host_order_addr, const int prefix)
+{
+  uint32_t m = (prefix) ? (0xFFFFFFFF << (32 - prefix)) : 0;
+  for (int i = 0; i < TRAFFIC_FLOW_TEMPLATE_IPV4_ADDR_SIZE; i++) {
+    pfc->ipv4remoteaddr[i].addr = ((host_order_addr & m) >> (24 - 8*i)) & 0xFF;
+    pfc->ipv4remoteaddr[i].mask = (m >> (24 - 8*i)) & 0xFF;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void generate_filter (bench_filter_t * const f, const uint32_t order)
+{
+  packet_filter_contents_t * pfc = &f->pf.packetfiltercontents;
+
+  memset (f, 0, sizeof (*f));
+  f->order = order;
+  f->result = 1 + (rand () % 250);
+  f->pf.direction = 1 + (rand () % 3);
+  f->pf.eval_precedence = rand () % 256;
+  // half of the filters are per UE (per bearer TFT), the other half are global SDF filters
+  if (rand () & 1) {
+    f->ue = ue_addr[rand () % NUM_UES];
+  }
+  if (rand () % 4) {
+    static const int prefixes[] = {8, 16, 24, 32};
+    uint32_t remote = 0xC0A80000 | (rand () & 0xFFFF);
+    pfc->flags |= TRAFFIC_FLOW_TEMPLATE_IPV4_REMOTE_ADDR_FLAG;
+    set_remote_ipv4 (pfc, remote, prefixes[rand () % 4]);
+  }
+  if (rand () % 2) {
+    pfc->flags |= TRAFFIC_FLOW_TEMPLATE_PROTOCOL_NEXT_HEADER_FLAG;
+    pfc->protocolidentifier_nextheader = protocols[rand () % sizeof (protocols)];
+  }
+  switch (rand () % 4) {
+    case 0:
+      pfc->flags |= TRAFFIC_FLOW_TEMPLATE_SINGLE_REMOTE_PORT_FLAG;
+      pfc->singleremoteport = ports[rand () % (sizeof (ports)/sizeof (ports[0]))];
+      break;
+    case 1:
+      pfc->flags |= TRAFFIC_FLOW_TEMPLATE_REMOTE_PORT_RANGE_FLAG;
+      pfc->remoteportrange.lowlimit = ports[rand () % (sizeof (ports)/sizeof (ports[0]))];
+      pfc->remoteportrange.highlimit = pfc->remoteportrange.lowlimit + (rand () % 1000);
+      break;
+    case 2:
+      pfc->flags |= TRAFFIC_FLOW_TEMPLATE_LOCAL_PORT_RANGE_FLAG;
+      pfc->localportrange.lowlimit = 1024 + (rand () % 30000);
+      pfc->localportrange.highlimit = pfc->localportrange.lowlimit + (rand () % 30000);
+      break;
+    default:;
+  }
+  if (0 == (rand () % 8)) {
+    pfc->flags |= TRAFFIC_FLOW_TEMPLATE_TYPE_OF_SERVICE_TRAFFIC_CLASS_FLAG;
+    pfc->typdeofservice_trafficclass.value = (rand () % 64) << 2;
+    pfc->typdeofservice_trafficclass.mask  = 0xFC;
+  }
+  if (0 == (rand () % 16)) {
+    pfc->flags |= TRAFFIC_FLOW_TEMPLATE_SECURITY_PARAMETER_INDEX_FLAG;
+    pfc->securityparameterindex = rand () % 64;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void generate_packet (pcef_flow_key_t * const key, uint8_t * const direction)
+{
+  memset (key, 0, sizeof (*key));
+  *direction = (rand () & 1) ? TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY : TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY;
+  key->ue_ipv4 = ue_addr[rand () % NUM_UES];
+  key->remote_ipv4.s_addr = htonl (0xC0A80000 | (rand () & 0xFFFF));
+  key->protocol = protocols[rand () % sizeof (protocols)];
+  key->ue_port = 1024 + (rand () % 60000);
+  key->remote_port = (rand () & 1) ? ports[rand () % (sizeof (ports)/sizeof (ports[0]))] + (rand () % 100) : rand () % 65536;
+  key->tos = (rand () % 64) << 2;
+  if (IPPROTO_ESP == key->protocol) {
+    key->spi = rand () % 64;
+    key->ue_port = 0;
+    key->remote_port = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+static bool reference_match (const bench_filter_t * const f, const uint8_t direction, const pcef_flow_key_t * const key)
+{
+  const packet_filter_contents_t * pfc = &f->pf.packetfiltercontents;
+  const uint8_t * remote = (const uint8_t *)&key->remote_ipv4.s_addr;
+
+  if (!(f->pf.direction & direction)) return false;
+  if ((f->ue.s_addr) && (f->ue.s_addr != key->ue_ipv4.s_addr)) return false;
+  if (TRAFFIC_FLOW_TEMPLATE_IPV4_REMOTE_ADDR_FLAG & pfc->flags) {
+    for (int i = 0; i < 4; i++) {
+      if ((remote[i] & pfc->ipv4remoteaddr[i].mask) != (pfc->ipv4remoteaddr[i].addr & pfc->ipv4remoteaddr[i].mask)) return false;
+    }
+  }
+  if ((TRAFFIC_FLOW_TEMPLATE_PROTOCOL_NEXT_HEADER_FLAG & pfc->flags) && (pfc->protocolidentifier_nextheader != key->protocol)) return false;
+  if ((TRAFFIC_FLOW_TEMPLATE_SINGLE_REMOTE_PORT_FLAG & pfc->flags) && (pfc->singleremoteport != key->remote_port)) return false;
+  if ((TRAFFIC_FLOW_TEMPLATE_REMOTE_PORT_RANGE_FLAG & pfc->flags) &&
+      ((key->remote_port < pfc->remoteportrange.lowlimit) || (key->remote_port > pfc->remoteportrange.highlimit))) return false;
+  if ((TRAFFIC_FLOW_TEMPLATE_LOCAL_PORT_RANGE_FLAG & pfc->flags) &&
+      ((key->ue_port < pfc->localportrange.lowlimit) || (key->ue_port > pfc->localportrange.highlimit))) return false;
+  if ((TRAFFIC_FLOW_TEMPLATE_TYPE_OF_SERVICE_TRAFFIC_CLASS_FLAG & pfc->flags) &&
+      ((key->tos & pfc->typdeofservice_trafficclass.mask) != (pfc->typdeofservice_trafficclass.value & pfc->typdeofservice_trafficclass.mask))) return false;
+  if ((TRAFFIC_FLOW_TEMPLATE_SECURITY_PARAMETER_INDEX_FLAG & pfc->flags) && (pfc->securityparameterindex != key->spi)) return false;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static uint32_t reference_lookup (const bench_filter_t * const filters, const int num_filters, const uint8_t direction, const pcef_flow_key_t * const key)
+{
+  const bench_filter_t * best = NULL;
+
+  for (int i = 0; i < num_filters; i++) {
+    if (reference_match (&filters[i], direction, key)) {
+      if ((!best) || (filters[i].pf.eval_precedence < best->pf.eval_precedence)) {
+        best = &filters[i];
+      }
+    }
+  }
+  return (best) ? best->result : PCEF_CLASSIFIER_NO_MATCH;
+}
+
+//------------------------------------------------------------------------------
+static double elapsed_ns (const struct timespec * const start, const struct timespec * const stop)
+{
+  return (double)(stop->tv_sec - start->tv_sec) * 1e9 + (double)(stop->tv_nsec - start->tv_nsec);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  int                                     num_filters = (argc > 1) ? atoi (argv[1]) : DEFAULT_NUM_FILTERS;
+  int                                     num_packets = (argc > 2) ? atoi (argv[2]) : DEFAULT_NUM_PACKETS;
+  unsigned int                            seed = (argc > 3) ? (unsigned int)atoi (argv[3]) : 1;
+  struct timespec                         start, stop;
+  pcef_classifier_stats_t                 stats;
+  int                                     num_errors = 0;
+  int                                     num_matches = 0;
+
+  srand (seed);
+  for (int i = 0; i < NUM_UES; i++) {
+    ue_addr[i].s_addr = htonl (0x0A000000 | (i + 2));
+  }
+
+  bench_filter_t * filters = calloc (num_filters, sizeof (bench_filter_t));
+  for (int i = 0; i < num_filters; i++) {
+    generate_filter (&filters[i], i);
+  }
+  pcef_flow_key_t * keys = calloc (num_packets, sizeof (pcef_flow_key_t));
+  uint8_t * directions = calloc (num_packets, sizeof (uint8_t));
+  uint32_t * results = calloc (num_packets, sizeof (uint32_t));
+  for (int i = 0; i < num_packets; i++) {
+    generate_packet (&keys[i], &directions[i]);
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  pcef_classifier_t * classifier = pcef_classifier_create (num_filters);
+  for (int i = 0; i < num_filters; i++) {
+    if (RETURNok != pcef_classifier_add_packet_filter (classifier, &filters[i].pf, filters[i].ue, filters[i].result)) {
+      fprintf (stderr, "Failed to add filter %d\n", i);
+      return EXIT_FAILURE;
+    }
+  }
+  pcef_classifier_compile (classifier);
+  clock_gettime (CLOCK_MONOTONIC, &stop);
+  pcef_classifier_get_stats (classifier, &stats);
+  printf ("Compiled %u filters in %.3f ms: %u tuples, %u slots, max chain %u\n",
+          stats.num_rules, elapsed_ns (&start, &stop) / 1e6, stats.num_tuples, stats.num_slots, stats.max_chain_length);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < num_packets; i++) {
+    results[i] = pcef_classifier_lookup (classifier, directions[i], &keys[i]);
+  }
+  clock_gettime (CLOCK_MONOTONIC, &stop);
+  double ns = elapsed_ns (&start, &stop);
+  printf ("Classified %d packets in %.3f ms: %.1f ns/packet, %.2f Mpps\n", num_packets, ns / 1e6, ns / num_packets, num_packets * 1e3 / ns);
+
+  // the linear scan is slow, check a bounded sample, ties on precedence are won by the first inserted filter in both
+  int num_checked = (num_packets < 65536) ? num_packets : 65536;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < num_checked; i++) {
+    uint32_t expected = reference_lookup (filters, num_filters, directions[i], &keys[i]);
+    if (expected != results[i]) {
+      if (num_errors++ < 10) {
+        fprintf (stderr, "Packet %d: classifier %u, linear scan %u\n", i, results[i], expected);
+      }
+    }
+    num_matches += (PCEF_CLASSIFIER_NO_MATCH != expected);
+  }
+  clock_gettime (CLOCK_MONOTONIC, &stop);
+  ns = elapsed_ns (&start, &stop);
+  printf ("Linear scan %d packets: %.1f ns/packet, %d matches, %d mismatches\n", num_checked, ns / num_checked, num_matches, num_errors);
+
+  pcef_classifier_destroy (&classifier);
+  free (filters);
+  free (keys);
+  free (directions);
+  free (results);
+  return (num_errors) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Offline benchmark of the S1AP fast codec.
+ * Decodes an UplinkNASTransport and encodes a DownlinkNASTransport with the
+ * fast codec and with the generic asn1c codec, and checks both produce the same result.
+ *
+ * usage: s1ap_fast_codec_benchmark [num_iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "common_defs.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_fast_codec.h"
+
+#define DEFAULT_NUM_ITERATIONS  (256*1024)
+
+static const uint8_t                    ul_nas_transport[] = {
+  0x00, 0x0D, 0x40, 0x41, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x05, 0xC0, 0x01, 0x10, 0xCE, 0xCC,
+  0x00, 0x08, 0x00, 0x03, 0x40, 0x01, 0xB3, 0x00, 0x1A, 0x00, 0x14, 0x13, 0x27, 0xD3, 0x77, 0xED,
+  0x4C, 0x01, 0x02, 0x01, 0xDA, 0x28, 0x08, 0x03, 0x69, 0x6D, 0x73, 0x03, 0x70, 0x66, 0x74, 0x00,
+  0x64, 0x40, 0x08, 0x00, 0x02, 0xF8, 0x29, 0x00, 0x00, 0x20, 0x40, 0x00, 0x43, 0x40, 0x06, 0x00,
+  0x02, 0xF8, 0x29, 0x00, 0x04};
+
+static const uint8_t                    dl_nas_transport[] = {
+  0x00, 0x0B, 0x40, 0x21, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x05, 0xC0, 0x01, 0x10, 0xCE, 0xCC,
+  0x00, 0x08, 0x00, 0x03, 0x40, 0x01, 0xB3, 0x00, 0x1A, 0x00, 0x0A, 0x09, 0x27, 0xAB, 0x1F, 0x7C,
+  0xEC, 0x01, 0x02, 0x01, 0xD9};
+
+//------------------------------------------------------------------------------
+static double elapsed_ns (const struct timespec * const start, const struct timespec * const stop)
+{
+  return (stop->tv_sec - start->tv_sec) * 1e9 + (stop->tv_nsec - start->tv_nsec);
+}
+
+//------------------------------------------------------------------------------
+static int generic_decode_uplink_nas_transport (s1ap_message * const message, const uint8_t * const buffer, const uint32_t length)
+{
+  S1AP_PDU_t                              pdu = {(S1AP_PDU_PR_NOTHING)};
+  S1AP_PDU_t                             *pdu_p = &pdu;
+  asn_dec_rval_t                          dec_ret = {(RC_OK)};
+  int                                     rc = RETURNerror;
+
+  dec_ret = aper_decode (NULL, &asn_DEF_S1AP_PDU, (void **)&pdu_p, buffer, length, 0, 0);
+  if ((dec_ret.code == RC_OK) && (pdu.present == S1AP_PDU_PR_initiatingMessage)) {
+    message->direction = pdu.present;
+    message->procedureCode = pdu.choice.initiatingMessage.procedureCode;
+    message->criticality = pdu.choice.initiatingMessage.criticality;
+    rc = (s1ap_decode_s1ap_uplinknastransporties (&message->msg.s1ap_UplinkNASTransportIEs, &pdu.choice.initiatingMessage.value) < 0) ? RETURNerror : RETURNok;
+  }
+  ASN_STRUCT_FREE_CONTENTS_ONLY (asn_DEF_S1AP_PDU, &pdu);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static int generic_encode_downlink_nas_transport (s1ap_message * const message, uint8_t ** const buffer, uint32_t * const length)
+{
+  S1ap_DownlinkNASTransport_t             pdu;
+
+  memset (&pdu, 0, sizeof (pdu));
+  if (s1ap_encode_s1ap_downlinknastransporties (&pdu, &message->msg.s1ap_DownlinkNASTransportIEs) < 0) {
+    return RETURNerror;
+  }
+  if (s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_downlinkNASTransport, message->criticality,
+      &asn_DEF_S1ap_DownlinkNASTransport, &pdu) < 0) {
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  int                                     num_iterations = (argc > 1) ? atoi (argv[1]) : DEFAULT_NUM_ITERATIONS;
+  struct timespec                         start, stop;
+  double                                  ns = 0;
+  s1ap_message                            message;
+  s1ap_message                            dl_message;
+  uint8_t                                 buffer[256];
+  uint8_t                                *generic_buffer = NULL;
+  uint32_t                                length = 0;
+  int                                     num_errors = 0;
+
+  if (num_iterations <= 0) {
+    fprintf (stderr, "usage: %s [num_iterations]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < num_iterations; i++) {
+    memset (&message, 0, sizeof (message));
+    if (RETURNok != s1ap_fast_codec_decode_pdu (&message, ul_nas_transport, sizeof (ul_nas_transport))) {
+      num_errors++;
+      continue;
+    }
+    free_s1ap_uplinknastransport (&message.msg.s1ap_UplinkNASTransportIEs);
+  }
+  clock_gettime (CLOCK_MONOTONIC, &stop);
+  ns = elapsed_ns (&start, &stop);
+  printf ("Fast decoded %d UplinkNASTransport in %.3f ms: %.1f ns/PDU\n", num_iterations, ns / 1e6, ns / num_iterations);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < num_iterations; i++) {
+    memset (&message, 0, sizeof (message));
+    if (RETURNok != generic_decode_uplink_nas_transport (&message, ul_nas_transport, sizeof (ul_nas_transport))) {
+      num_errors++;
+      continue;
+    }
+    free_s1ap_uplinknastransport (&message.msg.s1ap_UplinkNASTransportIEs);
+  }
+  clock_gettime (CLOCK_MONOTONIC, &stop);
+  ns = elapsed_ns (&start, &stop);
+  printf ("Generic decoded %d UplinkNASTransport in %.3f ms: %.1f ns/PDU\n", num_iterations, ns / 1e6, ns / num_iterations);
+
+  memset (&dl_message, 0, sizeof (dl_message));
+  if (RETURNok != s1ap_fast_codec_decode_pdu (&dl_message, dl_nas_transport, sizeof (dl_nas_transport))) {
+    fprintf (stderr, "Failed to decode DownlinkNASTransport\n");
+    return EXIT_FAILURE;
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < num_iterations; i++) {
+    if ((RETURNok != s1ap_fast_codec_encode_pdu (&dl_message, buffer, sizeof (buffer), &length)) ||
+        (length != sizeof (dl_nas_transport))) {
+      num_errors++;
+    }
+  }
+  clock_gettime (CLOCK_MONOTONIC, &stop);
+  ns = elapsed_ns (&start, &stop);
+  printf ("Fast encoded %d DownlinkNASTransport in %.3f ms: %.1f ns/PDU\n", num_iterations, ns / 1e6, ns / num_iterations);
+  if (memcmp (buffer, dl_nas_transport, sizeof (dl_nas_transport))) {
+    fprintf (stderr, "Fast encoded DownlinkNASTransport differs from reference\n");
+    num_errors++;
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < num_iterations; i++) {
+    if (RETURNok != generic_encode_downlink_nas_transport (&dl_message, &generic_buffer, &length)) {
+      num_errors++;
+      continue;
+    }
+    if ((length != sizeof (dl_nas_transport)) || (memcmp (generic_buffer, dl_nas_transport, length))) {
+      num_errors++;
+    }
+    free (generic_buffer);
+    generic_buffer = NULL;
+  }
+  clock_gettime (CLOCK_MONOTONIC, &stop);
+  ns = elapsed_ns (&start, &stop);
+  printf ("Generic encoded %d DownlinkNASTransport in %.3f ms: %.1f ns/PDU\n", num_iterations, ns / 1e6, ns / num_iterations);
+
+  free_s1ap_downlinknastransport (&dl_message.msg.s1ap_DownlinkNASTransportIEs);
+  printf ("%d errors\n", num_errors);
+  return (num_errors) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
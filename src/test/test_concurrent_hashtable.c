@@ -0,0 +1,254 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <check.h>
+
+#include "bstrlib.h"
+
+#include "hashtable.h"
+#include "obj_hashtable.h"
+
+#define TEST_HT_NUM_STABLE_KEYS     4096
+#define TEST_HT_NUM_WRITERS         4
+#define TEST_HT_NUM_READERS         4
+#define TEST_HT_KEYS_PER_WRITER     20000
+
+static volatile bool                      test_ht_stop = false;
+static volatile uint64_t                  test_ht_reader_errors = 0;
+
+//------------------------------------------------------------------------------
+static hash_size_t test_ht_bad_hashfunc (const hash_key_t key)
+{
+  // all keys collide modulo 256, the seeded mixing must spread them anyway
+  return (hash_size_t)(key << 8);
+}
+
+//------------------------------------------------------------------------------
+static bool test_ht_count_cb (const hash_key_t key, const uint64_t data, void * parameter, void ** result)
+{
+  (*(uint64_t *)parameter)++;
+  return false;
+}
+
+START_TEST(hashtable_ts_basic)
+{
+  hash_table_ts_t                        *htbl = hashtable_ts_create (16, NULL, hash_free_int_func, NULL);
+  void                                   *data = NULL;
+  hashtable_key_array_t                  *ka = NULL;
+
+  ck_assert (htbl != NULL);
+  for (uintptr_t i = 1; i <= 10000; i++) {
+    ck_assert_int_eq (hashtable_ts_insert (htbl, i, (void *)i), HASH_TABLE_OK);
+  }
+  // grown well beyond the initial size, everything still reachable
+  for (uintptr_t i = 1; i <= 10000; i++) {
+    ck_assert_int_eq (hashtable_ts_get (htbl, i, &data), HASH_TABLE_OK);
+    ck_assert_uint_eq ((uintptr_t)data, i);
+  }
+  ck_assert_int_eq (hashtable_ts_is_key_exists (htbl, 10001), HASH_TABLE_KEY_NOT_EXISTS);
+  ck_assert_int_eq (hashtable_ts_insert (htbl, 5, (void *)6), HASH_TABLE_INSERT_OVERWRITTEN_DATA);
+  ck_assert_int_eq (hashtable_ts_get (htbl, 5, &data), HASH_TABLE_OK);
+  ck_assert_uint_eq ((uintptr_t)data, 6);
+  ck_assert_int_eq (hashtable_ts_remove (htbl, 5, &data), HASH_TABLE_OK);
+  ck_assert_uint_eq ((uintptr_t)data, 6);
+  ck_assert_int_eq (hashtable_ts_remove (htbl, 5, &data), HASH_TABLE_KEY_NOT_EXISTS);
+  ck_assert_int_eq (hashtable_ts_free (htbl, 6), HASH_TABLE_OK);
+  ka = hashtable_ts_get_keys (htbl);
+  ck_assert (ka != NULL);
+  ck_assert_int_eq (ka->num_keys, 9998);
+  free (ka->keys);
+  free (ka);
+  ck_assert_int_eq (hashtable_ts_destroy (htbl), HASH_TABLE_OK);
+}
+END_TEST
+
+START_TEST(hashtable_uint64_ts_user_hash)
+{
+  hash_table_uint64_ts_t                 *htbl = hashtable_uint64_ts_create (64, test_ht_bad_hashfunc, NULL);
+  uint64_t                                data = 0;
+  uint64_t                                count = 0;
+
+  ck_assert (htbl != NULL);
+  for (uint64_t i = 0; i < 5000; i++) {
+    ck_assert_int_eq (hashtable_uint64_ts_insert (htbl, i, i * 3), HASH_TABLE_OK);
+  }
+  ck_assert_int_eq (hashtable_uint64_ts_resize (htbl, 65536), HASH_TABLE_OK);
+  for (uint64_t i = 0; i < 5000; i++) {
+    ck_assert_int_eq (hashtable_uint64_ts_get (htbl, i, &data), HASH_TABLE_OK);
+    ck_assert_uint_eq (data, i * 3);
+  }
+  hashtable_uint64_ts_apply_callback_on_elements (htbl, test_ht_count_cb, &count, NULL);
+  ck_assert_uint_eq (count, 5000);
+  for (uint64_t i = 0; i < 5000; i += 2) {
+    ck_assert_int_eq (hashtable_uint64_ts_remove (htbl, i), HASH_TABLE_OK);
+  }
+  ck_assert_int_eq (hashtable_uint64_ts_get (htbl, 2, &data), HASH_TABLE_KEY_NOT_EXISTS);
+  ck_assert_int_eq (hashtable_uint64_ts_get (htbl, 3, &data), HASH_TABLE_OK);
+  ck_assert_int_eq (hashtable_uint64_ts_destroy (htbl), HASH_TABLE_OK);
+}
+END_TEST
+
+START_TEST(obj_hashtable_ts_key_content)
+{
+  obj_hash_table_uint64_t                *htbl = obj_hashtable_uint64_ts_create (32, NULL, NULL, NULL);
+  char                                    key1[] = "10.0.0.1";
+  char                                    key2[] = "10.0.0.1";
+  uint64_t                                data = 0;
+
+  ck_assert (htbl != NULL);
+  ck_assert_int_eq (obj_hashtable_uint64_ts_insert (htbl, key1, strlen (key1), 1), HASH_TABLE_OK);
+  // same content, different buffer: same entry
+  ck_assert_int_eq (obj_hashtable_uint64_ts_insert (htbl, key2, strlen (key2), 2), HASH_TABLE_INSERT_OVERWRITTEN_DATA);
+  key1[0] = 'x';
+  ck_assert_int_eq (obj_hashtable_uint64_ts_get (htbl, key2, strlen (key2), &data), HASH_TABLE_OK);
+  ck_assert_uint_eq (data, 2);
+  ck_assert_int_eq (obj_hashtable_uint64_ts_get (htbl, key2, strlen (key2) - 1, &data), HASH_TABLE_KEY_NOT_EXISTS);
+  for (int i = 0; i < 3000; i++) {
+    char                                  key[32];
+
+    snprintf (key, sizeof (key), "imsi-%015d", i);
+    ck_assert_int_eq (obj_hashtable_uint64_ts_insert (htbl, key, strlen (key), i), HASH_TABLE_OK);
+  }
+  for (int i = 0; i < 3000; i++) {
+    char                                  key[32];
+
+    snprintf (key, sizeof (key), "imsi-%015d", i);
+    ck_assert_int_eq (obj_hashtable_uint64_ts_get (htbl, key, strlen (key), &data), HASH_TABLE_OK);
+    ck_assert_uint_eq (data, i);
+  }
+  ck_assert_int_eq (obj_hashtable_uint64_ts_remove (htbl, key2, strlen (key2)), HASH_TABLE_OK);
+  ck_assert_int_eq (obj_hashtable_uint64_ts_is_key_exists (htbl, key2, strlen (key2)), HASH_TABLE_KEY_NOT_EXISTS);
+  ck_assert_int_eq (obj_hashtable_uint64_ts_destroy (htbl), HASH_TABLE_OK);
+}
+END_TEST
+
+//------------------------------------------------------------------------------
+static void *test_ht_reader (void * arg)
+{
+  hash_table_uint64_ts_t                 *htbl = (hash_table_uint64_ts_t *)arg;
+  uint64_t                                data = 0;
+  uint64_t                                k = 0;
+
+  while (!__atomic_load_n (&test_ht_stop, __ATOMIC_ACQUIRE)) {
+    // stable keys must always be found, whatever the resize state
+    if ((HASH_TABLE_OK != hashtable_uint64_ts_get (htbl, k, &data)) || (data != k + 1)) {
+      __atomic_add_fetch (&test_ht_reader_errors, 1, __ATOMIC_RELAXED);
+    }
+    k = (k + 1) % TEST_HT_NUM_STABLE_KEYS;
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void *test_ht_writer (void * arg)
+{
+  hash_table_uint64_ts_t                 *htbl = (hash_table_uint64_ts_t *)arg;
+  static volatile int                     writer_id = 0;
+  const uint64_t                          base = (1 + __atomic_fetch_add (&writer_id, 1, __ATOMIC_RELAXED)) * 1000000;
+  uint64_t                                data = 0;
+  int                                     errors = 0;
+
+  for (uint64_t i = 0; i < TEST_HT_KEYS_PER_WRITER; i++) {
+    if (HASH_TABLE_OK != hashtable_uint64_ts_insert (htbl, base + i, i)) errors++;
+  }
+  for (uint64_t i = 0; i < TEST_HT_KEYS_PER_WRITER; i++) {
+    if ((HASH_TABLE_OK != hashtable_uint64_ts_get (htbl, base + i, &data)) || (data != i)) errors++;
+  }
+  for (uint64_t i = 0; i < TEST_HT_KEYS_PER_WRITER; i += 2) {
+    if (HASH_TABLE_OK != hashtable_uint64_ts_remove (htbl, base + i)) errors++;
+  }
+  return (void *)(uintptr_t)errors;
+}
+
+START_TEST(hashtable_ts_concurrent_resize)
+{
+  hash_table_uint64_ts_t                 *htbl = hashtable_uint64_ts_create (64, NULL, NULL);
+  pthread_t                               readers[TEST_HT_NUM_READERS];
+  pthread_t                               writers[TEST_HT_NUM_WRITERS];
+  hashtable_key_array_t                  *ka = NULL;
+  void                                   *errors = NULL;
+
+  ck_assert (htbl != NULL);
+  for (uint64_t k = 0; k < TEST_HT_NUM_STABLE_KEYS; k++) {
+    hashtable_uint64_ts_insert (htbl, k, k + 1);
+  }
+  for (int i = 0; i < TEST_HT_NUM_READERS; i++) {
+    pthread_create (&readers[i], NULL, test_ht_reader, htbl);
+  }
+  for (int i = 0; i < TEST_HT_NUM_WRITERS; i++) {
+    pthread_create (&writers[i], NULL, test_ht_writer, htbl);
+  }
+  for (int i = 0; i < TEST_HT_NUM_WRITERS; i++) {
+    pthread_join (writers[i], &errors);
+    ck_assert_uint_eq ((uintptr_t)errors, 0);
+  }
+  __atomic_store_n (&test_ht_stop, true, __ATOMIC_RELEASE);
+  for (int i = 0; i < TEST_HT_NUM_READERS; i++) {
+    pthread_join (readers[i], NULL);
+  }
+  ck_assert_uint_eq (test_ht_reader_errors, 0);
+  ka = hashtable_uint64_ts_get_keys (htbl);
+  ck_assert (ka != NULL);
+  ck_assert_int_eq (ka->num_keys, TEST_HT_NUM_STABLE_KEYS + TEST_HT_NUM_WRITERS * TEST_HT_KEYS_PER_WRITER / 2);
+  free (ka->keys);
+  free (ka);
+  ck_assert_int_eq (hashtable_uint64_ts_destroy (htbl), HASH_TABLE_OK);
+}
+END_TEST
+
+Suite * concurrent_hashtable_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("Concurrent hashtable tests");
+
+    tc_core = tcase_create("Concurrent hashtable test");
+    tcase_set_timeout(tc_core, 60);
+    tcase_add_test(tc_core, hashtable_ts_basic);
+    tcase_add_test(tc_core, hashtable_uint64_ts_user_hash);
+    tcase_add_test(tc_core, obj_hashtable_ts_key_content);
+    tcase_add_test(tc_core, hashtable_ts_concurrent_resize);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = concurrent_hashtable_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
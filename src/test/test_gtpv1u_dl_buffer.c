@@ -0,0 +1,257 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Downlink buffering of an idle UE: packets routed to the TUN device are
+ * buffered and notified once, then flushed in order in GTP-U to the eNB.
+ * Runs in its own network namespace, a veth pair standing for the GTP
+ * device carrying the UE pool; needs root, skipped (77) otherwise.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <arpa/inet.h>
+#include <check.h>
+
+#include "bstrlib.h"
+#include "log.h"
+#include "shared_ts_log.h"
+#include "common_defs.h"
+#include "intertask_interface.h"
+#include "intertask_interface_init.h"
+#include "gtpv1_u_messages_types.h"
+#include "gtpv1u_sgw_defs.h"
+#include "pgw_pcef_classifier.h"
+#include "pgw_pcef_emulation.h"
+#include "spgw_config.h"
+#include "gtpv1u_dl_buffer.h"
+
+#define TEST_SKIP_RC          77
+#define TEST_S1U_ADDR         "10.200.0.1"
+#define TEST_ENB_ADDR         "10.200.0.2"
+#define TEST_UE_ADDR          "172.16.0.10"
+#define TEST_UE_PORT          9000
+#define TEST_ENB_TEID         0x12345678
+#define TEST_EBI              5
+#define TEST_SDF_ID           7
+#define TEST_NB_PACKETS       16
+
+/* the SDF lookup of the PCEF emulation, the triggering packet is checked to be classified */
+static int test_nb_classified = 0;
+
+//------------------------------------------------------------------------------
+sdf_id_t pgw_pcef_emulation_classify (const uint8_t direction, const struct pcef_flow_key_s * const flow_key)
+{
+  test_nb_classified += 1;
+  if ((TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY == direction) && (flow_key->ue_ipv4.s_addr == inet_addr (TEST_UE_ADDR))) {
+    return TEST_SDF_ID;
+  }
+  return (sdf_id_t)PCEF_CLASSIFIER_NO_MATCH;
+}
+
+//------------------------------------------------------------------------------
+static int udp_socket (const char * const addr, const uint16_t port)
+{
+  struct sockaddr_in  local = {0};
+  struct timeval      tv = {.tv_sec = 1, .tv_usec = 0};
+  int                 fd = socket (AF_INET, SOCK_DGRAM, 0);
+
+  if (0 > fd) {
+    return -1;
+  }
+  local.sin_family      = AF_INET;
+  local.sin_port        = htons (port);
+  local.sin_addr.s_addr = inet_addr (addr);
+  if (bind (fd, (struct sockaddr *)&local, sizeof (local)) < 0) {
+    close (fd);
+    return -1;
+  }
+  setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof (tv));
+  return fd;
+}
+
+//------------------------------------------------------------------------------
+/* send a numbered datagram to the UE, true if it was punted to the TUN device and read by the buffer */
+static bool send_to_ue (const int fd, const uint32_t seq)
+{
+  struct sockaddr_in  ue = {0};
+  uint32_t            payload = htonl (seq);
+  struct pollfd       pfd = {.fd = gtpv1u_dl_buffer_fd (), .events = POLLIN};
+
+  ue.sin_family      = AF_INET;
+  ue.sin_port        = htons (TEST_UE_PORT);
+  ue.sin_addr.s_addr = inet_addr (TEST_UE_ADDR);
+  if (sendto (fd, &payload, sizeof (payload), 0, (struct sockaddr *)&ue, sizeof (ue)) != sizeof (payload)) {
+    return false;
+  }
+  if (1 != poll (&pfd, 1, 200)) {
+    return false;
+  }
+  gtpv1u_dl_buffer_read ();
+  return true;
+}
+
+START_TEST(gtpv1u_dl_buffer_buffer_and_flush_in_order)
+{
+  spgw_config_t       config;
+  struct in_addr      ue  = {.s_addr = inet_addr (TEST_UE_ADDR)};
+  struct in_addr      enb = {.s_addr = inet_addr (TEST_ENB_ADDR)};
+  bearer_qos_t        qos = {0};
+  MessageDef         *message_p = NULL;
+  uint8_t             gpdu[256];
+  int                 fd1u = udp_socket (TEST_S1U_ADDR, GTPV1U_UDP_PORT);
+  int                 enb_fd = udp_socket (TEST_ENB_ADDR, GTPV1U_UDP_PORT);
+  int                 sgi_fd = udp_socket (TEST_S1U_ADDR, 0);
+
+  ck_assert_int_ge (fd1u, 0);
+  ck_assert_int_ge (enb_fd, 0);
+  ck_assert_int_ge (sgi_fd, 0);
+
+  memset (&config, 0, sizeof (config));
+  config.sgw_config.dl_buffering.enabled                = true;
+  config.sgw_config.dl_buffering.if_name                = bfromcstr ("dlbuf0");
+  config.sgw_config.dl_buffering.max_packets_per_bearer = 64;
+  config.sgw_config.dl_buffering.max_kbytes             = 1024;
+  config.sgw_config.dl_buffering.packet_ttl_ms          = 10000;
+  config.pgw_config.ipv4.mtu_SGI                        = 1500;
+  ck_assert_int_eq (gtpv1u_dl_buffer_init (&config, fd1u), RETURNok);
+  ck_assert_int_ge (gtpv1u_dl_buffer_fd (), 0);
+
+  // UE goes idle: its /32 route now points at the TUN device instead of the UE pool device
+  qos.pl  = 9;
+  qos.pvi = 1;
+  ck_assert_int_eq (gtpv1u_dl_buffer_start (ue, TEST_EBI, &qos), RETURNok);
+  for (uint32_t seq = 0; seq < TEST_NB_PACKETS; seq++) {
+    ck_assert_msg (send_to_ue (sgi_fd, seq), "packet %u not punted to the TUN device", seq);
+  }
+
+  // nothing reaches the eNB while buffering
+  ck_assert_int_lt (recv (enb_fd, gpdu, sizeof (gpdu), MSG_DONTWAIT), 0);
+
+  // a single notification, on the SDF of the first packet
+  ck_assert_int_eq (test_nb_classified, 1);
+  itti_poll_msg (TASK_SPGW_APP, &message_p);
+  ck_assert_ptr_ne (message_p, NULL);
+  ck_assert_int_eq (ITTI_MSG_ID (message_p), GTPV1U_DOWNLINK_DATA_NOTIFICATION);
+  ck_assert_uint_eq (GTPV1U_DOWNLINK_DATA_NOTIFICATION (message_p)->ue_ip.s_addr, ue.s_addr);
+  ck_assert_uint_eq (GTPV1U_DOWNLINK_DATA_NOTIFICATION (message_p)->eps_bearer_id, TEST_EBI);
+  ck_assert_uint_eq (GTPV1U_DOWNLINK_DATA_NOTIFICATION (message_p)->sdf_id, TEST_SDF_ID);
+  itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p->itti_msg);
+  itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
+  itti_poll_msg (TASK_SPGW_APP, &message_p);
+  ck_assert_ptr_eq (message_p, NULL);
+
+  // Modify Bearer Request: the queue goes to the eNB F-TEID in arrival order
+  ck_assert_int_eq (gtpv1u_dl_buffer_flush (ue, enb, TEST_ENB_TEID), RETURNok);
+  for (uint32_t seq = 0; seq < TEST_NB_PACKETS; seq++) {
+    ssize_t        length = recv (enb_fd, gpdu, sizeof (gpdu), 0);
+    const uint8_t *ip = &gpdu[8];
+    uint32_t       payload = 0;
+
+    ck_assert_msg (length == 8 + 20 + 8 + sizeof (payload), "G-PDU %u: %zd bytes", seq, length);
+    ck_assert_uint_eq (gpdu[0], 0x30);
+    ck_assert_uint_eq (gpdu[1], 0xFF);
+    ck_assert_uint_eq ((gpdu[2] << 8) | gpdu[3], length - 8);
+    ck_assert_uint_eq (((uint32_t)gpdu[4] << 24) | (gpdu[5] << 16) | (gpdu[6] << 8) | gpdu[7], TEST_ENB_TEID);
+    ck_assert_uint_eq (ip[0] >> 4, 4);
+    ck_assert_int_eq (memcmp (&ip[16], &ue.s_addr, sizeof (ue.s_addr)), 0);
+    memcpy (&payload, &ip[20 + 8], sizeof (payload));
+    ck_assert_uint_eq (ntohl (payload), seq);
+  }
+  ck_assert_int_lt (recv (enb_fd, gpdu, sizeof (gpdu), MSG_DONTWAIT), 0);
+
+  // the /32 route is gone, the UE pool device carries the downlink again
+  ck_assert (!send_to_ue (sgi_fd, TEST_NB_PACKETS));
+
+  gtpv1u_dl_buffer_stop (ue);
+  gtpv1u_dl_buffer_exit ();
+  ck_assert_int_lt (gtpv1u_dl_buffer_fd (), 0);
+  bdestroy (config.sgw_config.dl_buffering.if_name);
+  close (sgi_fd);
+  close (enb_fd);
+  close (fd1u);
+}
+END_TEST
+
+//------------------------------------------------------------------------------
+/* private network namespace: the S1-U and eNB addresses on a veth pair, the UE pool routed on it */
+static bool setup_netns (void)
+{
+  if ((0 != geteuid ()) || (0 != access ("/dev/net/tun", R_OK | W_OK)) || (0 != unshare (CLONE_NEWNET))) {
+    return false;
+  }
+  return (0 == system ("ip link set lo up"
+                       " && ip link add s1u0 type veth peer name enb0"
+                       " && ip addr add " TEST_S1U_ADDR "/24 dev s1u0"
+                       " && ip addr add " TEST_ENB_ADDR "/24 dev enb0"
+                       " && ip link set s1u0 up && ip link set enb0 up"
+                       " && ip route add 172.16.0.0/24 dev s1u0"));
+}
+
+Suite * gtpv1u_dl_buffer_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("GTPV1U downlink buffering tests");
+
+    tc_core = tcase_create("GTPV1U downlink buffering test");
+    tcase_add_test(tc_core, gtpv1u_dl_buffer_buffer_and_flush_in_order);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    if (!setup_netns ()) {
+      fprintf (stderr, "Needs root, /dev/net/tun and iproute2 in a new network namespace, skipped\n");
+      return TEST_SKIP_RC;
+    }
+    // as the SPGW does, the buffer notifies the SPGW application through ITTI
+    if ((RETURNok != shared_log_init (MAX_LOG_PROTOS)) || (RETURNok != OAILOG_INIT (LOG_SPGW_ENV, OAILOG_LEVEL_NOTICE, MAX_LOG_PROTOS))
+        || (RETURNok != itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL))) {
+      return EXIT_FAILURE;
+    }
+
+    s = gtpv1u_dl_buffer_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
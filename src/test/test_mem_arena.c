@@ -0,0 +1,129 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <check.h>
+
+#include "bstrlib.h"
+
+#include "mem_arena.h"
+
+#define TEST_ARENA_NUM_ALLOCS       512
+#define TEST_ARENA_NUM_ROUNDS       64
+
+START_TEST(mem_arena_alloc_zeroed_aligned)
+{
+  for (int round = 0; round < TEST_ARENA_NUM_ROUNDS; round++) {
+    mem_arena_t                            *arena = mem_arena_create ();
+    uint8_t                                *ptr[TEST_ARENA_NUM_ALLOCS] = {NULL};
+    size_t                                  size[TEST_ARENA_NUM_ALLOCS] = {0};
+
+    ck_assert (arena != NULL);
+    for (int i = 0; i < TEST_ARENA_NUM_ALLOCS; i++) {
+      // mix of small requests and requests getting a dedicated chunk
+      size[i] = (i % 17) ? (size_t)((i * 37) % 300) : (size_t)(MEM_ARENA_CHUNK_SIZE + i);
+      ptr[i] = mem_arena_alloc (arena, size[i]);
+      ck_assert (ptr[i] != NULL);
+      ck_assert_uint_eq ((uintptr_t)ptr[i] % 16, 0);
+      // chunks recycled from previous rounds are dirty, allocations must not be
+      for (size_t j = 0; j < size[i]; j++) {
+        ck_assert_uint_eq (ptr[i][j], 0);
+      }
+      memset (ptr[i], i & 0xFF, size[i]);
+    }
+    // no allocation overlaps another one
+    for (int i = 0; i < TEST_ARENA_NUM_ALLOCS; i++) {
+      for (size_t j = 0; j < size[i]; j++) {
+        ck_assert_uint_eq (ptr[i][j], i & 0xFF);
+      }
+    }
+    mem_arena_destroy (&arena);
+    ck_assert (arena == NULL);
+  }
+}
+END_TEST
+
+START_TEST(mem_arena_bstring_write_protected)
+{
+  mem_arena_t                              *arena = mem_arena_create ();
+  bstring                                   apn = NULL;
+  bstring                                   copy = NULL;
+  bstring                                   heap = NULL;
+
+  ck_assert (arena != NULL);
+  apn = mem_arena_blk2bstr (arena, "internet", 8);
+  ck_assert (apn != NULL);
+  ck_assert (biseqcstr (apn, "internet"));
+  ck_assert_int_eq (apn->data[8], '\0');
+  // bstrlib refuses to modify or free it
+  ck_assert_int_eq (bconcat (apn, apn), BSTR_ERR);
+  ck_assert_int_eq (bdestroy (apn), BSTR_ERR);
+  ck_assert (biseqcstr (apn, "internet"));
+
+  copy = mem_arena_bstrcpy (arena, apn);
+  ck_assert (copy != NULL);
+  ck_assert (copy != apn);
+  ck_assert (biseq (copy, apn));
+  ck_assert (mem_arena_bstrcpy (arena, NULL) == NULL);
+
+  // heap copies of arena bstrings are regular bstrings
+  heap = bstrcpy (apn);
+  ck_assert_int_eq (bcatcstr (heap, ".mnc001"), BSTR_OK);
+  ck_assert (biseqcstr (heap, "internet.mnc001"));
+  ck_assert_int_eq (bdestroy (heap), BSTR_OK);
+
+  mem_arena_destroy (&arena);
+}
+END_TEST
+
+Suite * mem_arena_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("Memory arena tests");
+
+    tc_core = tcase_create("Memory arena test");
+    tcase_add_test(tc_core, mem_arena_alloc_zeroed_aligned);
+    tcase_add_test(tc_core, mem_arena_bstring_write_protected);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = mem_arena_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
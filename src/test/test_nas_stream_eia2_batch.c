@@ -0,0 +1,197 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <check.h>
+
+#include "secu_defs.h"
+
+#define TEST_EIA2_BATCH_NUM_LANES   21
+
+/* 3GPP TS 33.401 C.2.2, byte aligned */
+static uint8_t test_set_2_key[16]    = {0xd3, 0xc5, 0xd5, 0x92, 0x32, 0x7f, 0xb1, 0x1c, 0x40, 0x35, 0xc6, 0x68, 0x0a, 0xf8, 0xc6, 0xd1};
+static uint8_t test_set_2_message[8] = {0x48, 0x45, 0x83, 0xd5, 0xaf, 0xe0, 0x82, 0xae};
+
+//------------------------------------------------------------------------------
+static uint32_t reference_eia2 (uint8_t * key, uint32_t count, uint8_t bearer, uint8_t direction, uint8_t * message, uint32_t length)
+{
+  nas_stream_cipher_t                     nas_cipher;
+  uint8_t                                 mac[4];
+
+  nas_cipher.key        = key;
+  nas_cipher.key_length = 16;
+  nas_cipher.count      = count;
+  nas_cipher.bearer     = bearer;
+  nas_cipher.direction  = direction;
+  nas_cipher.message    = message;
+  nas_cipher.blength    = length << 3;
+  nas_stream_encrypt_eia2 (&nas_cipher, mac);
+  return ((uint32_t)mac[0] << 24) | ((uint32_t)mac[1] << 16) | ((uint32_t)mac[2] << 8) | mac[3];
+}
+
+START_TEST(eia2_batch_test_vector)
+{
+  nas_eia2_key_schedule_t                 schedule = {.valid = false};
+  nas_eia2_lane_t                         lane = {0};
+
+  nas_stream_eia2_key_schedule (&schedule, test_set_2_key);
+  lane.schedule  = &schedule;
+  lane.count     = 0x398a59b4;
+  lane.bearer    = 0x1a;
+  lane.direction = 1;
+  lane.message   = test_set_2_message;
+  lane.length    = sizeof (test_set_2_message);
+  nas_stream_eia2_batch (&lane, 1);
+  ck_assert_uint_eq (lane.mac, 0xb93787e6);
+}
+END_TEST
+
+START_TEST(eia2_batch_mixed_lanes)
+{
+  nas_eia2_key_schedule_t                 schedules[4];
+  nas_eia2_lane_t                         lanes[TEST_EIA2_BATCH_NUM_LANES];
+  uint8_t                                 keys[4][16];
+  uint8_t                                 messages[TEST_EIA2_BATCH_NUM_LANES][64];
+
+  memset (schedules, 0, sizeof (schedules));
+  srand (1);
+  for (int k = 0; k < 4; k++) {
+    for (int i = 0; i < 16; i++) keys[k][i] = rand ();
+    nas_stream_eia2_key_schedule (&schedules[k], keys[k]);
+  }
+  // lengths 0..20 cover the complete and incomplete last block cases
+  for (int l = 0; l < TEST_EIA2_BATCH_NUM_LANES; l++) {
+    for (int i = 0; i < 64; i++) messages[l][i] = rand ();
+    lanes[l].schedule  = &schedules[l % 4];
+    lanes[l].count     = rand ();
+    lanes[l].bearer    = 0;
+    lanes[l].direction = l & 1;
+    lanes[l].message   = messages[l];
+    lanes[l].length    = (l < 17) ? l : 24 + l;
+  }
+  nas_stream_eia2_batch (lanes, TEST_EIA2_BATCH_NUM_LANES);
+  for (int l = 0; l < TEST_EIA2_BATCH_NUM_LANES; l++) {
+    ck_assert_uint_eq (lanes[l].mac, reference_eia2 (keys[l % 4], lanes[l].count, 0, l & 1, messages[l], lanes[l].length));
+  }
+}
+END_TEST
+
+START_TEST(eia2_key_schedule_cache)
+{
+  nas_eia2_key_schedule_t                 schedule = {.valid = false};
+  uint8_t                                 key[16] = {0};
+  uint8_t                                 message[2] = {0xC7, 0x01};
+  nas_eia2_lane_t                         lane = {.schedule = &schedule, .count = 5, .message = message, .length = 2};
+
+  nas_stream_eia2_key_schedule (&schedule, key);
+  key[15] = 1;
+  // the key changed: the schedule must be expanded again
+  nas_stream_eia2_key_schedule (&schedule, key);
+  nas_stream_eia2_batch (&lane, 1);
+  ck_assert_uint_eq (lane.mac, reference_eia2 (key, 5, 0, 0, message, 2));
+}
+END_TEST
+
+START_TEST(ul_count_window_sequence_number_wrap)
+{
+  uint32_t                                candidates[4];
+
+  // same 5 LSB: the count itself
+  ck_assert_int_eq (nas_ul_count_window (0x000105, 0x05, false, 0, candidates, 1), 1);
+  ck_assert_uint_eq (candidates[0], 0x000105);
+  // 5 bit sequence number wrap
+  ck_assert_int_eq (nas_ul_count_window (0x00011E, 0x01, false, 0, candidates, 1), 1);
+  ck_assert_uint_eq (candidates[0], 0x000121);
+  // 8 bit sequence number wrap: the overflow counter is incremented
+  ck_assert_int_eq (nas_ul_count_window (0x0000FE, 0x02, false, 0, candidates, 1), 1);
+  ck_assert_uint_eq (candidates[0], 0x000102);
+  // window of lost SERVICE REQUESTs, crossing the 8 bit wrap
+  ck_assert_int_eq (nas_ul_count_window (0x0000C3, 0x03, false, 0, candidates, 4), 4);
+  ck_assert_uint_eq (candidates[0], 0x0000C3);
+  ck_assert_uint_eq (candidates[1], 0x0000E3);
+  ck_assert_uint_eq (candidates[2], 0x000103);
+  ck_assert_uint_eq (candidates[3], 0x000123);
+}
+END_TEST
+
+START_TEST(ul_count_window_exhausted)
+{
+  uint32_t                                candidates[4];
+
+  ck_assert_int_eq (nas_ul_count_window (0xFFFFC0, 0x1F, false, 0, candidates, 4), 2);
+  ck_assert_uint_eq (candidates[0], 0xFFFFDF);
+  ck_assert_uint_eq (candidates[1], 0xFFFFFF);
+  // the 24 bits NAS COUNT never wraps to 0
+  ck_assert_int_eq (nas_ul_count_window (0xFFFFFF, 0x00, false, 0, candidates, 4), 0);
+}
+END_TEST
+
+START_TEST(ul_count_window_replay)
+{
+  uint32_t                                candidates[4];
+
+  // replay of the last verified SERVICE REQUEST
+  ck_assert_int_eq (nas_ul_count_window (0x000105, 0x05, true, 0x000105, candidates, 1), 0);
+  ck_assert_int_eq (nas_ul_count_window (0x000105, 0x05, true, 0x000105, candidates, 2), 1);
+  ck_assert_uint_eq (candidates[0], 0x000125);
+  // not a replay
+  ck_assert_int_eq (nas_ul_count_window (0x000106, 0x06, true, 0x000105, candidates, 1), 1);
+  ck_assert_uint_eq (candidates[0], 0x000106);
+}
+END_TEST
+
+Suite * eia2_batch_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("EIA2 batch tests");
+
+    tc_core = tcase_create("EIA2 batch test");
+    tcase_add_test(tc_core, eia2_batch_test_vector);
+    tcase_add_test(tc_core, eia2_batch_mixed_lanes);
+    tcase_add_test(tc_core, eia2_key_schedule_cache);
+    tcase_add_test(tc_core, ul_count_window_sequence_number_wrap);
+    tcase_add_test(tc_core, ul_count_window_exhausted);
+    tcase_add_test(tc_core, ul_count_window_replay);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = eia2_batch_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,228 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * PCEF SDF classifier: evaluation precedence, direction, per UE filters,
+ * port ranges and flow key extraction.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <check.h>
+
+#include "common_defs.h"
+#include "3gpp_24.008.h"
+#include "pgw_pcef_classifier.h"
+
+//------------------------------------------------------------------------------
+static void set_ipv4 (packet_filter_contents_t * const pfc, const bool remote, const char * const addr, const int prefix)
+{
+  uint32_t a = ntohl (inet_addr (addr));
+  uint32_t m = (prefix) ? (0xFFFFFFFF << (32 - prefix)) : 0;
+
+  for (int i = 0; i < TRAFFIC_FLOW_TEMPLATE_IPV4_ADDR_SIZE; i++) {
+    if (remote) {
+      pfc->ipv4remoteaddr[i].addr = ((a & m) >> (24 - 8*i)) & 0xFF;
+      pfc->ipv4remoteaddr[i].mask = (m >> (24 - 8*i)) & 0xFF;
+    } else {
+      pfc->ipv4localaddr[i].addr = ((a & m) >> (24 - 8*i)) & 0xFF;
+      pfc->ipv4localaddr[i].mask = (m >> (24 - 8*i)) & 0xFF;
+    }
+  }
+  pfc->flags |= (remote) ? TRAFFIC_FLOW_TEMPLATE_IPV4_REMOTE_ADDR_FLAG : TRAFFIC_FLOW_TEMPLATE_IPV4_LOCAL_ADDR_FLAG;
+}
+
+//------------------------------------------------------------------------------
+static pcef_flow_key_t flow_key (const char * const ue, const char * const remote, const uint8_t protocol, const uint16_t ue_port, const uint16_t remote_port)
+{
+  pcef_flow_key_t key = {0};
+
+  key.ue_ipv4.s_addr     = inet_addr (ue);
+  key.remote_ipv4.s_addr = inet_addr (remote);
+  key.protocol           = protocol;
+  key.ue_port            = ue_port;
+  key.remote_port        = remote_port;
+  return key;
+}
+
+START_TEST(pcef_classifier_precedence_and_direction)
+{
+  pcef_classifier_t                      *classifier = pcef_classifier_create (4);
+  packet_filter_t                         pf = {0};
+  struct in_addr                          any_ue = {.s_addr = INADDR_ANY};
+  pcef_flow_key_t                         key;
+
+  // whole 10/8 network, both directions
+  pf.direction = TRAFFIC_FLOW_TEMPLATE_BIDIRECTIONAL;
+  pf.eval_precedence = 10;
+  set_ipv4 (&pf.packetfiltercontents, true, "10.0.0.0", 8);
+  ck_assert_int_eq (pcef_classifier_add_packet_filter (classifier, &pf, any_ue, 1), RETURNok);
+
+  // DNS to one host of this network, uplink only, evaluated first
+  memset (&pf, 0, sizeof (pf));
+  pf.direction = TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY;
+  pf.eval_precedence = 5;
+  set_ipv4 (&pf.packetfiltercontents, true, "10.1.2.3", 32);
+  pf.packetfiltercontents.flags |= TRAFFIC_FLOW_TEMPLATE_PROTOCOL_NEXT_HEADER_FLAG | TRAFFIC_FLOW_TEMPLATE_SINGLE_REMOTE_PORT_FLAG;
+  pf.packetfiltercontents.protocolidentifier_nextheader = IPPROTO_UDP;
+  pf.packetfiltercontents.singleremoteport = 53;
+  ck_assert_int_eq (pcef_classifier_add_packet_filter (classifier, &pf, any_ue, 2), RETURNok);
+
+  // no filter can be added once compiled
+  ck_assert_int_eq (pcef_classifier_compile (classifier), RETURNok);
+  ck_assert_int_eq (pcef_classifier_add_packet_filter (classifier, &pf, any_ue, 3), RETURNerror);
+
+  key = flow_key ("172.16.0.1", "10.1.2.3", IPPROTO_UDP, 4000, 53);
+  ck_assert_uint_eq (pcef_classifier_lookup (classifier, TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY, &key), 2);
+  ck_assert_uint_eq (pcef_classifier_lookup (classifier, TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY, &key), 1);
+  key = flow_key ("172.16.0.1", "10.1.2.3", IPPROTO_TCP, 4000, 53);
+  ck_assert_uint_eq (pcef_classifier_lookup (classifier, TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY, &key), 1);
+  key = flow_key ("172.16.0.1", "10.1.2.4", IPPROTO_UDP, 4000, 53);
+  ck_assert_uint_eq (pcef_classifier_lookup (classifier, TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY, &key), 1);
+  key = flow_key ("172.16.0.1", "192.168.1.1", IPPROTO_UDP, 4000, 53);
+  ck_assert_uint_eq (pcef_classifier_lookup (classifier, TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY, &key), PCEF_CLASSIFIER_NO_MATCH);
+  pcef_classifier_destroy (&classifier);
+  ck_assert (classifier == NULL);
+}
+END_TEST
+
+START_TEST(pcef_classifier_per_ue_port_range)
+{
+  pcef_classifier_t                      *classifier = pcef_classifier_create (1);
+  packet_filter_t                         pf = {0};
+  struct in_addr                          ue = {.s_addr = inet_addr ("172.16.0.5")};
+  pcef_flow_key_t                         key;
+
+  pf.direction = TRAFFIC_FLOW_TEMPLATE_BIDIRECTIONAL;
+  pf.eval_precedence = 1;
+  pf.packetfiltercontents.flags = TRAFFIC_FLOW_TEMPLATE_LOCAL_PORT_RANGE_FLAG;
+  pf.packetfiltercontents.localportrange.lowlimit  = 1000;
+  pf.packetfiltercontents.localportrange.highlimit = 2000;
+  ck_assert_int_eq (pcef_classifier_add_packet_filter (classifier, &pf, ue, 3), RETURNok);
+  ck_assert_int_eq (pcef_classifier_compile (classifier), RETURNok);
+
+  key = flow_key ("172.16.0.5", "8.8.8.8", IPPROTO_TCP, 1000, 80);
+  ck_assert_uint_eq (pcef_classifier_lookup (classifier, TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY, &key), 3);
+  key = flow_key ("172.16.0.5", "8.8.8.8", IPPROTO_TCP, 2000, 80);
+  ck_assert_uint_eq (pcef_classifier_lookup (classifier, TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY, &key), 3);
+  key = flow_key ("172.16.0.5", "8.8.8.8", IPPROTO_TCP, 2001, 80);
+  ck_assert_uint_eq (pcef_classifier_lookup (classifier, TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY, &key), PCEF_CLASSIFIER_NO_MATCH);
+  // filter bound to another UE
+  key = flow_key ("172.16.0.6", "8.8.8.8", IPPROTO_TCP, 1500, 80);
+  ck_assert_uint_eq (pcef_classifier_lookup (classifier, TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY, &key), PCEF_CLASSIFIER_NO_MATCH);
+  pcef_classifier_destroy (&classifier);
+}
+END_TEST
+
+START_TEST(pcef_classifier_default_rule)
+{
+  pcef_classifier_t                      *classifier = pcef_classifier_create (1);
+  packet_filter_t                         pf = {0};
+  struct in_addr                          any_ue = {.s_addr = INADDR_ANY};
+  pcef_flow_key_t                         key;
+
+  // as DEFAULT_PCC_RULE: local address flag without local address, downlink only
+  pf.direction = TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY;
+  pf.eval_precedence = 250;
+  pf.packetfiltercontents.flags = TRAFFIC_FLOW_TEMPLATE_IPV4_LOCAL_ADDR_FLAG;
+  ck_assert_int_eq (pcef_classifier_add_packet_filter (classifier, &pf, any_ue, 9), RETURNok);
+  ck_assert_int_eq (pcef_classifier_compile (classifier), RETURNok);
+
+  key = flow_key ("172.16.0.5", "8.8.8.8", IPPROTO_TCP, 1000, 80);
+  ck_assert_uint_eq (pcef_classifier_lookup (classifier, TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY, &key), 9);
+  key = flow_key ("192.168.10.1", "1.1.1.1", IPPROTO_UDP, 1000, 53);
+  ck_assert_uint_eq (pcef_classifier_lookup (classifier, TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY, &key), 9);
+  ck_assert_uint_eq (pcef_classifier_lookup (classifier, TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY, &key), PCEF_CLASSIFIER_NO_MATCH);
+  pcef_classifier_destroy (&classifier);
+}
+END_TEST
+
+START_TEST(pcef_classifier_flow_key)
+{
+  uint8_t                                 packet[28] = {0};
+  pcef_flow_key_t                         key;
+
+  // IPv4 UDP 172.16.0.5:1234 -> 8.8.8.8:53
+  packet[0] = 0x45;
+  packet[1] = 0x10;
+  packet[3] = sizeof (packet);
+  packet[9] = IPPROTO_UDP;
+  *(in_addr_t *)&packet[12] = inet_addr ("172.16.0.5");
+  *(in_addr_t *)&packet[16] = inet_addr ("8.8.8.8");
+  packet[20] = 1234 >> 8;
+  packet[21] = 1234 & 0xFF;
+  packet[23] = 53;
+
+  ck_assert_int_eq (pcef_classifier_ipv4_packet_2_flow_key (packet, sizeof (packet), TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY, &key), RETURNok);
+  ck_assert_uint_eq (key.ue_ipv4.s_addr, inet_addr ("172.16.0.5"));
+  ck_assert_uint_eq (key.remote_ipv4.s_addr, inet_addr ("8.8.8.8"));
+  ck_assert_uint_eq (key.ue_port, 1234);
+  ck_assert_uint_eq (key.remote_port, 53);
+  ck_assert_uint_eq (key.protocol, IPPROTO_UDP);
+  ck_assert_uint_eq (key.tos, 0x10);
+
+  // same packet seen as downlink
+  ck_assert_int_eq (pcef_classifier_ipv4_packet_2_flow_key (packet, sizeof (packet), TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY, &key), RETURNok);
+  ck_assert_uint_eq (key.ue_ipv4.s_addr, inet_addr ("8.8.8.8"));
+  ck_assert_uint_eq (key.ue_port, 53);
+
+  // truncated or not IPv4
+  ck_assert_int_eq (pcef_classifier_ipv4_packet_2_flow_key (packet, 10, TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY, &key), RETURNerror);
+  packet[0] = 0x65;
+  ck_assert_int_eq (pcef_classifier_ipv4_packet_2_flow_key (packet, sizeof (packet), TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY, &key), RETURNerror);
+}
+END_TEST
+
+Suite * pcef_classifier_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("PCEF classifier tests");
+
+    tc_core = tcase_create("PCEF classifier test");
+    tcase_add_test(tc_core, pcef_classifier_precedence_and_direction);
+    tcase_add_test(tc_core, pcef_classifier_per_ue_port_range);
+    tcase_add_test(tc_core, pcef_classifier_default_rule);
+    tcase_add_test(tc_core, pcef_classifier_flow_key);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = pcef_classifier_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
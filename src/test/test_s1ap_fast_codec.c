@@ -0,0 +1,604 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <check.h>
+
+#include "common_defs.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_fast_codec.h"
+
+// DownlinkNASTransport, UplinkNASTransport from eNB traces
+static const uint8_t                      test_dl_nas_transport[] = {
+  0x00, 0x0B, 0x40, 0x21, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x05, 0xC0, 0x01, 0x10, 0xCE, 0xCC,
+  0x00, 0x08, 0x00, 0x03, 0x40, 0x01, 0xB3, 0x00, 0x1A, 0x00, 0x0A, 0x09, 0x27, 0xAB, 0x1F, 0x7C,
+  0xEC, 0x01, 0x02, 0x01, 0xD9};
+
+static const uint8_t                      test_ul_nas_transport[] = {
+  0x00, 0x0D, 0x40, 0x41, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x05, 0xC0, 0x01, 0x10, 0xCE, 0xCC,
+  0x00, 0x08, 0x00, 0x03, 0x40, 0x01, 0xB3, 0x00, 0x1A, 0x00, 0x14, 0x13, 0x27, 0xD3, 0x77, 0xED,
+  0x4C, 0x01, 0x02, 0x01, 0xDA, 0x28, 0x08, 0x03, 0x69, 0x6D, 0x73, 0x03, 0x70, 0x66, 0x74, 0x00,
+  0x64, 0x40, 0x08, 0x00, 0x02, 0xF8, 0x29, 0x00, 0x00, 0x20, 0x40, 0x00, 0x43, 0x40, 0x06, 0x00,
+  0x02, 0xF8, 0x29, 0x00, 0x04};
+
+// InitialUEMessage (attach request) with S-TMSI and GUMMEI
+static const uint8_t                      test_initial_ue_message[] = {
+  0x00, 0x0C, 0x40, 0x5E, 0x00, 0x00, 0x07,
+  0x00, 0x08, 0x00, 0x02, 0x00, 0x01,
+  0x00, 0x1A, 0x00, 0x21, 0x20,
+  0x17, 0x5A, 0x3C, 0x1E, 0x4B, 0x05, 0x07, 0x41, 0x71, 0x08, 0x29, 0x80, 0x59, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x02, 0x07, 0xF0, 0x70, 0x00, 0x00, 0x10, 0x00, 0x05, 0x02, 0x01, 0xD0, 0x11, 0xD1,
+  0x00, 0x43, 0x00, 0x06, 0x00, 0x02, 0xF8, 0x59, 0x00, 0x01,
+  0x00, 0x64, 0x40, 0x08, 0x00, 0x02, 0xF8, 0x59, 0x00, 0x00, 0x0E, 0x00,
+  0x00, 0x86, 0x40, 0x01, 0x30,
+  0x00, 0x60, 0x00, 0x06, 0x00, 0x40, 0xC0, 0x00, 0x01, 0x23,
+  0x00, 0x4B, 0x00, 0x07, 0x00, 0x02, 0xF8, 0x59, 0x00, 0x04, 0x01};
+
+// UEContextReleaseRequest, cause radioNetwork user-inactivity
+static const uint8_t                      test_ue_context_release_request[] = {
+  0x00, 0x12, 0x40, 0x16, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x02, 0x00, 0x05, 0x00, 0x08, 0x00,
+  0x03, 0x40, 0x01, 0xB3, 0x00, 0x02, 0x40, 0x02, 0x02, 0x80};
+
+typedef struct test_vector_s {
+  const uint8_t                          *buffer;
+  uint32_t                                length;
+} test_vector_t;
+
+static const test_vector_t                test_vectors[] = {
+  {test_dl_nas_transport, sizeof (test_dl_nas_transport)},
+  {test_ul_nas_transport, sizeof (test_ul_nas_transport)},
+  {test_initial_ue_message, sizeof (test_initial_ue_message)},
+  {test_ue_context_release_request, sizeof (test_ue_context_release_request)},
+};
+
+#define TEST_NUM_VECTORS  (sizeof (test_vectors) / sizeof (test_vectors[0]))
+
+/*
+ * NAS payloads encoded from the test/MME/MSGR10 message files, with the scenario
+ * variables of test/MME/all.xml (IMSI 208930000000001, GUTI 208.93.4.1.0x00010000,
+ * null MAC and sequence numbers, null RAND/AUTN/RES).
+ */
+// ITTI_S1AP_INITIAL_UE_MESSAGE.ATTACH_REQUEST.IMSI.xml
+static const uint8_t                      test_msgr10_attach_request_imsi[] = {
+  0x17, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x07, 0x41, 0x02, 0x08, 0x29, 0x80, 0x39, 0x00, 0x00, 0x00, 0x00, 0x10, 0x04, 0xE0, 0x60, 0xC0,
+  0x40, 0x00, 0x21, 0x02, 0x01, 0xD0, 0x11, 0xD1, 0x27, 0x1A, 0x80, 0x80, 0x21, 0x10, 0x01, 0x00,
+  0x00, 0x10, 0x81, 0x06, 0x00, 0x00, 0x00, 0x00, 0x83, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0D,
+  0x00, 0x00, 0x0A, 0x00, 0x52, 0x02, 0xF8, 0x39, 0x00, 0x01, 0x5C, 0x16, 0x00, 0x31, 0x03, 0xE5,
+  0xE0, 0x34, 0x90, 0x11, 0x03, 0x57, 0x58, 0xA6, 0x5D, 0x01, 0x00, 0xE0};
+
+// ITTI_S1AP_INITIAL_UE_MESSAGE.xml
+static const uint8_t                      test_msgr10_attach_request_guti[] = {
+  0x17, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x07, 0x41, 0x02, 0x0B, 0xF6, 0x02, 0xF8, 0x39, 0x00, 0x04, 0x01, 0x00, 0x01, 0x00, 0x00, 0x04,
+  0xE0, 0x60, 0xC0, 0x40, 0x00, 0x21, 0x02, 0x01, 0xD0, 0x11, 0xD1, 0x27, 0x1A, 0x80, 0x80, 0x21,
+  0x10, 0x01, 0x00, 0x00, 0x10, 0x81, 0x06, 0x00, 0x00, 0x00, 0x00, 0x83, 0x06, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x0D, 0x00, 0x00, 0x0A, 0x00, 0x52, 0x02, 0xF8, 0x39, 0x00, 0x01, 0x5C, 0x16, 0x00,
+  0x31, 0x03, 0xE5, 0xE0, 0x34, 0x90, 0x11, 0x03, 0x57, 0x58, 0xA6, 0x5D, 0x01, 0x00, 0xE0};
+
+// ITTI_NAS_UPLINK_DATA_IND.IDENTITY_RESPONSE.xml
+static const uint8_t                      test_msgr10_identity_response[] = {
+  0x17, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x07, 0x56, 0x08, 0x29, 0x80, 0x39, 0x00, 0x00, 0x00, 0x00, 0x10};
+
+// ITTI_NAS_UPLINK_DATA_IND.AUTHENTICATION_RESPONSE.xml
+static const uint8_t                      test_msgr10_authentication_response[] = {
+  0x17, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x07, 0x53, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+// ITTI_NAS_UPLINK_DATA_IND.SECURITY_MODE_COMPLETE.xml
+static const uint8_t                      test_msgr10_security_mode_complete[] = {
+  0x47, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x07, 0x5E, 0x23, 0x09, 0x13, 0x32, 0x54, 0x76, 0x18, 0x32, 0x54, 0x16, 0xF2};
+
+// ITTI_NAS_UPLINK_DATA_IND.DETACH_REQUEST.SWITCH_OFF.xml
+static const uint8_t                      test_msgr10_detach_request_switch_off[] = {
+  0x27, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x07, 0x45, 0x0B, 0x0B, 0xF6, 0x02, 0xF8, 0x39, 0x00, 0x04, 0x01, 0x00, 0x01, 0x00, 0x00};
+
+// ITTI_NAS_DOWNLINK_DATA_REQ.IDENTITY_REQUEST.xml
+static const uint8_t                      test_msgr10_identity_request[] = {
+  0x07, 0x55, 0x01};
+
+// ITTI_NAS_DOWNLINK_DATA_REQ.AUTHENTICATION_REQUEST.xml
+static const uint8_t                      test_msgr10_authentication_request[] = {
+  0x07, 0x52, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+// ITTI_NAS_DOWNLINK_DATA_REQ.SECURITY_MODE_COMMAND.xml
+static const uint8_t                      test_msgr10_security_mode_command[] = {
+  0x37, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x07, 0x5D, 0x02, 0x00, 0x05, 0xE0, 0x60, 0xC0, 0x40, 0x70, 0xC1};
+
+// S1AP IE values of the MSGR10 message files and of test/MME/all.xml
+#define TEST_MSGR10_ENB_UE_S1AP_ID  0xEB15AD
+#define TEST_MSGR10_MME_UE_S1AP_ID  0xFFFFFFFF
+
+static uint8_t                            test_msgr10_plmn[]      = {0x02, 0xF8, 0x39};         // MCC 208, MNC 93
+static uint8_t                            test_msgr10_tac[]       = {0x00, 0x01};
+static uint8_t                            test_msgr10_cell_id[]   = {0x00, 0xE0, 0x00, 0x00};   // ECI 00e0000
+static uint8_t                            test_msgr10_mme_gid[]   = {0x00, 0x04};
+static uint8_t                            test_msgr10_mme_code[]  = {0x01};
+
+typedef struct test_msgr10_pdu_s {
+  const char                             *file;
+  S1ap_ProcedureCode_t                    procedure_code;
+  const uint8_t                          *nas;
+  uint32_t                                nas_length;
+  S1ap_Cause_PR                           cause_group;
+  long                                    cause;
+} test_msgr10_pdu_t;
+
+#define TEST_MSGR10_NAS(nAS)  (nAS), sizeof (nAS)
+
+static const test_msgr10_pdu_t            test_msgr10_pdus[] = {
+  {"ITTI_S1AP_INITIAL_UE_MESSAGE.ATTACH_REQUEST.IMSI.xml",     S1ap_ProcedureCode_id_initialUEMessage,  TEST_MSGR10_NAS (test_msgr10_attach_request_imsi)},
+  {"ITTI_S1AP_INITIAL_UE_MESSAGE.xml",                         S1ap_ProcedureCode_id_initialUEMessage,  TEST_MSGR10_NAS (test_msgr10_attach_request_guti)},
+  {"ITTI_NAS_UPLINK_DATA_IND.IDENTITY_RESPONSE.xml",           S1ap_ProcedureCode_id_uplinkNASTransport, TEST_MSGR10_NAS (test_msgr10_identity_response)},
+  {"ITTI_NAS_UPLINK_DATA_IND.AUTHENTICATION_RESPONSE.xml",     S1ap_ProcedureCode_id_uplinkNASTransport, TEST_MSGR10_NAS (test_msgr10_authentication_response)},
+  {"ITTI_NAS_UPLINK_DATA_IND.SECURITY_MODE_COMPLETE.xml",      S1ap_ProcedureCode_id_uplinkNASTransport, TEST_MSGR10_NAS (test_msgr10_security_mode_complete)},
+  {"ITTI_NAS_UPLINK_DATA_IND.DETACH_REQUEST.SWITCH_OFF.xml",   S1ap_ProcedureCode_id_uplinkNASTransport, TEST_MSGR10_NAS (test_msgr10_detach_request_switch_off)},
+  {"ITTI_NAS_DOWNLINK_DATA_REQ.IDENTITY_REQUEST.xml",          S1ap_ProcedureCode_id_downlinkNASTransport, TEST_MSGR10_NAS (test_msgr10_identity_request)},
+  {"ITTI_NAS_DOWNLINK_DATA_REQ.AUTHENTICATION_REQUEST.xml",    S1ap_ProcedureCode_id_downlinkNASTransport, TEST_MSGR10_NAS (test_msgr10_authentication_request)},
+  {"ITTI_NAS_DOWNLINK_DATA_REQ.SECURITY_MODE_COMMAND.xml",     S1ap_ProcedureCode_id_downlinkNASTransport, TEST_MSGR10_NAS (test_msgr10_security_mode_command)},
+  // S1AP_CAUSE_GROUP/S1AP_CAUSE_GROUP_CAUSE of the 36.413 UE context release scenarios
+  {"ITTI_S1AP_UE_CONTEXT_RELEASE_REQUEST.xml",                 S1ap_ProcedureCode_id_UEContextReleaseRequest, NULL, 0, S1ap_Cause_PR_radioNetwork, S1ap_CauseRadioNetwork_radio_connection_with_ue_lost},
+  {"ITTI_S1AP_UE_CONTEXT_RELEASE_REQUEST.xml",                 S1ap_ProcedureCode_id_UEContextReleaseRequest, NULL, 0, S1ap_Cause_PR_nas, S1ap_CauseNas_detach},
+};
+
+#define TEST_MSGR10_NUM_PDUS  (sizeof (test_msgr10_pdus) / sizeof (test_msgr10_pdus[0]))
+
+//------------------------------------------------------------------------------
+static void test_free_message (s1ap_message * const message)
+{
+  switch (message->procedureCode) {
+    case S1ap_ProcedureCode_id_downlinkNASTransport:
+      free_s1ap_downlinknastransport (&message->msg.s1ap_DownlinkNASTransportIEs);
+      break;
+    case S1ap_ProcedureCode_id_uplinkNASTransport:
+      free_s1ap_uplinknastransport (&message->msg.s1ap_UplinkNASTransportIEs);
+      break;
+    case S1ap_ProcedureCode_id_initialUEMessage:
+      free_s1ap_initialuemessage (&message->msg.s1ap_InitialUEMessageIEs);
+      break;
+    case S1ap_ProcedureCode_id_UEContextReleaseRequest:
+      free_s1ap_uecontextreleaserequest (&message->msg.s1ap_UEContextReleaseRequestIEs);
+      break;
+    default:
+      ck_abort_msg ("Unexpected procedure %d", (int)message->procedureCode);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void test_msgr10_set_location (S1ap_TAI_t * const tai, S1ap_EUTRAN_CGI_t * const eutran_cgi)
+{
+  tai->pLMNidentity.buf         = test_msgr10_plmn;
+  tai->pLMNidentity.size        = sizeof (test_msgr10_plmn);
+  tai->tAC.buf                  = test_msgr10_tac;
+  tai->tAC.size                 = sizeof (test_msgr10_tac);
+  eutran_cgi->pLMNidentity.buf  = test_msgr10_plmn;
+  eutran_cgi->pLMNidentity.size = sizeof (test_msgr10_plmn);
+  eutran_cgi->cell_ID.buf       = test_msgr10_cell_id;
+  eutran_cgi->cell_ID.size      = sizeof (test_msgr10_cell_id);
+  eutran_cgi->cell_ID.bits_unused = 4;
+}
+
+//------------------------------------------------------------------------------
+// IEs point to the static scenario buffers: the message must not be freed
+static void test_msgr10_build (s1ap_message * const message, const test_msgr10_pdu_t * const pdu)
+{
+  memset (message, 0, sizeof (*message));
+  message->direction     = S1AP_PDU_PR_initiatingMessage;
+  message->procedureCode = pdu->procedure_code;
+  message->criticality   = S1ap_Criticality_ignore;
+  switch (pdu->procedure_code) {
+    case S1ap_ProcedureCode_id_initialUEMessage: {
+        S1ap_InitialUEMessageIEs_t *ies = &message->msg.s1ap_InitialUEMessageIEs;
+        ies->eNB_UE_S1AP_ID = TEST_MSGR10_ENB_UE_S1AP_ID;
+        ies->nas_pdu.buf    = (uint8_t *)pdu->nas;
+        ies->nas_pdu.size   = pdu->nas_length;
+        test_msgr10_set_location (&ies->tai, &ies->eutran_cgi);
+        // rrc_establishment_cause 1 (EMERGENCY) of the ITTI message
+        ies->rrC_Establishment_Cause = S1ap_RRC_Establishment_Cause_emergency;
+        ies->presenceMask |= S1AP_INITIALUEMESSAGEIES_GUMMEI_ID_PRESENT;
+        ies->gummei_id.pLMN_Identity.buf  = test_msgr10_plmn;
+        ies->gummei_id.pLMN_Identity.size = sizeof (test_msgr10_plmn);
+        ies->gummei_id.mME_Group_ID.buf   = test_msgr10_mme_gid;
+        ies->gummei_id.mME_Group_ID.size  = sizeof (test_msgr10_mme_gid);
+        ies->gummei_id.mME_Code.buf       = test_msgr10_mme_code;
+        ies->gummei_id.mME_Code.size      = sizeof (test_msgr10_mme_code);
+      }
+      break;
+    case S1ap_ProcedureCode_id_uplinkNASTransport: {
+        S1ap_UplinkNASTransportIEs_t *ies = &message->msg.s1ap_UplinkNASTransportIEs;
+        ies->mme_ue_s1ap_id = TEST_MSGR10_MME_UE_S1AP_ID;
+        ies->eNB_UE_S1AP_ID = TEST_MSGR10_ENB_UE_S1AP_ID;
+        ies->nas_pdu.buf    = (uint8_t *)pdu->nas;
+        ies->nas_pdu.size   = pdu->nas_length;
+        test_msgr10_set_location (&ies->tai, &ies->eutran_cgi);
+      }
+      break;
+    case S1ap_ProcedureCode_id_downlinkNASTransport: {
+        S1ap_DownlinkNASTransportIEs_t *ies = &message->msg.s1ap_DownlinkNASTransportIEs;
+        ies->mme_ue_s1ap_id = TEST_MSGR10_MME_UE_S1AP_ID;
+        ies->eNB_UE_S1AP_ID = TEST_MSGR10_ENB_UE_S1AP_ID;
+        ies->nas_pdu.buf    = (uint8_t *)pdu->nas;
+        ies->nas_pdu.size   = pdu->nas_length;
+      }
+      break;
+    case S1ap_ProcedureCode_id_UEContextReleaseRequest: {
+        S1ap_UEContextReleaseRequestIEs_t *ies = &message->msg.s1ap_UEContextReleaseRequestIEs;
+        ies->mme_ue_s1ap_id = TEST_MSGR10_MME_UE_S1AP_ID;
+        ies->eNB_UE_S1AP_ID = TEST_MSGR10_ENB_UE_S1AP_ID;
+        ies->cause.present  = pdu->cause_group;
+        if (pdu->cause_group == S1ap_Cause_PR_radioNetwork) {
+          ies->cause.choice.radioNetwork = pdu->cause;
+        } else {
+          ies->cause.choice.nas = pdu->cause;
+        }
+      }
+      break;
+    default:
+      ck_abort_msg ("Unexpected procedure %d", (int)pdu->procedure_code);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void test_msgr10_check (const s1ap_message * const message, const test_msgr10_pdu_t * const pdu)
+{
+  const S1ap_NAS_PDU_t *nas_pdu = NULL;
+
+  ck_assert_int_eq (message->procedureCode, pdu->procedure_code);
+  switch (pdu->procedure_code) {
+    case S1ap_ProcedureCode_id_initialUEMessage: {
+        const S1ap_InitialUEMessageIEs_t *ies = &message->msg.s1ap_InitialUEMessageIEs;
+        ck_assert_uint_eq (ies->eNB_UE_S1AP_ID, TEST_MSGR10_ENB_UE_S1AP_ID);
+        ck_assert_int_eq (ies->rrC_Establishment_Cause, S1ap_RRC_Establishment_Cause_emergency);
+        ck_assert_uint_eq (ies->presenceMask, S1AP_INITIALUEMESSAGEIES_GUMMEI_ID_PRESENT);
+        ck_assert (memcmp (ies->tai.tAC.buf, test_msgr10_tac, sizeof (test_msgr10_tac)) == 0);
+        ck_assert (memcmp (ies->eutran_cgi.cell_ID.buf, test_msgr10_cell_id, sizeof (test_msgr10_cell_id)) == 0);
+        ck_assert (memcmp (ies->gummei_id.mME_Group_ID.buf, test_msgr10_mme_gid, sizeof (test_msgr10_mme_gid)) == 0);
+        nas_pdu = &ies->nas_pdu;
+      }
+      break;
+    case S1ap_ProcedureCode_id_uplinkNASTransport: {
+        const S1ap_UplinkNASTransportIEs_t *ies = &message->msg.s1ap_UplinkNASTransportIEs;
+        ck_assert_uint_eq (ies->mme_ue_s1ap_id, TEST_MSGR10_MME_UE_S1AP_ID);
+        ck_assert_uint_eq (ies->eNB_UE_S1AP_ID, TEST_MSGR10_ENB_UE_S1AP_ID);
+        ck_assert (memcmp (ies->eutran_cgi.pLMNidentity.buf, test_msgr10_plmn, sizeof (test_msgr10_plmn)) == 0);
+        nas_pdu = &ies->nas_pdu;
+      }
+      break;
+    case S1ap_ProcedureCode_id_downlinkNASTransport: {
+        const S1ap_DownlinkNASTransportIEs_t *ies = &message->msg.s1ap_DownlinkNASTransportIEs;
+        ck_assert_uint_eq (ies->mme_ue_s1ap_id, TEST_MSGR10_MME_UE_S1AP_ID);
+        ck_assert_uint_eq (ies->eNB_UE_S1AP_ID, TEST_MSGR10_ENB_UE_S1AP_ID);
+        nas_pdu = &ies->nas_pdu;
+      }
+      break;
+    case S1ap_ProcedureCode_id_UEContextReleaseRequest: {
+        const S1ap_UEContextReleaseRequestIEs_t *ies = &message->msg.s1ap_UEContextReleaseRequestIEs;
+        ck_assert_uint_eq (ies->mme_ue_s1ap_id, TEST_MSGR10_MME_UE_S1AP_ID);
+        ck_assert_uint_eq (ies->eNB_UE_S1AP_ID, TEST_MSGR10_ENB_UE_S1AP_ID);
+        ck_assert_int_eq (ies->cause.present, pdu->cause_group);
+        ck_assert_int_eq ((pdu->cause_group == S1ap_Cause_PR_radioNetwork) ? ies->cause.choice.radioNetwork : ies->cause.choice.nas, pdu->cause);
+      }
+      break;
+    default:
+      ck_abort_msg ("Unexpected procedure %d", (int)pdu->procedure_code);
+  }
+  if (nas_pdu) {
+    ck_assert_int_eq (nas_pdu->size, pdu->nas_length);
+    ck_assert_msg (memcmp (nas_pdu->buf, pdu->nas, pdu->nas_length) == 0, "%s", pdu->file);
+  }
+}
+
+//------------------------------------------------------------------------------
+static int test_generic_decode (s1ap_message * const message, const uint8_t * const buffer, const uint32_t length)
+{
+  S1AP_PDU_t                              pdu = {(S1AP_PDU_PR_NOTHING)};
+  S1AP_PDU_t                             *pdu_p = &pdu;
+  S1ap_InitiatingMessage_t               *initiating_p = &pdu.choice.initiatingMessage;
+  asn_dec_rval_t                          dec_ret = {(RC_OK)};
+  int                                     rc = RETURNerror;
+
+  memset (message, 0, sizeof (*message));
+  dec_ret = aper_decode (NULL, &asn_DEF_S1AP_PDU, (void **)&pdu_p, buffer, length, 0, 0);
+  if ((dec_ret.code != RC_OK) || (pdu.present != S1AP_PDU_PR_initiatingMessage)) {
+    return RETURNerror;
+  }
+  message->direction = pdu.present;
+  message->procedureCode = initiating_p->procedureCode;
+  message->criticality = initiating_p->criticality;
+  switch (initiating_p->procedureCode) {
+    case S1ap_ProcedureCode_id_downlinkNASTransport:
+      rc = s1ap_decode_s1ap_downlinknastransporties (&message->msg.s1ap_DownlinkNASTransportIEs, &initiating_p->value);
+      break;
+    case S1ap_ProcedureCode_id_uplinkNASTransport:
+      rc = s1ap_decode_s1ap_uplinknastransporties (&message->msg.s1ap_UplinkNASTransportIEs, &initiating_p->value);
+      break;
+    case S1ap_ProcedureCode_id_initialUEMessage:
+      rc = s1ap_decode_s1ap_initialuemessageies (&message->msg.s1ap_InitialUEMessageIEs, &initiating_p->value);
+      break;
+    case S1ap_ProcedureCode_id_UEContextReleaseRequest:
+      rc = s1ap_decode_s1ap_uecontextreleaserequesties (&message->msg.s1ap_UEContextReleaseRequestIEs, &initiating_p->value);
+      break;
+    default:
+      break;
+  }
+  ASN_STRUCT_FREE_CONTENTS_ONLY (asn_DEF_S1AP_PDU, &pdu);
+  return (rc < 0) ? RETURNerror : RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int test_generic_encode (s1ap_message * const message, uint8_t ** const buffer, uint32_t * const length)
+{
+  switch (message->procedureCode) {
+    case S1ap_ProcedureCode_id_downlinkNASTransport: {
+        S1ap_DownlinkNASTransport_t pdu;
+        memset (&pdu, 0, sizeof (pdu));
+        if (s1ap_encode_s1ap_downlinknastransporties (&pdu, &message->msg.s1ap_DownlinkNASTransportIEs) < 0) return RETURNerror;
+        return (s1ap_generate_initiating_message (buffer, length, message->procedureCode, message->criticality, &asn_DEF_S1ap_DownlinkNASTransport, &pdu) < 0) ? RETURNerror : RETURNok;
+      }
+    case S1ap_ProcedureCode_id_uplinkNASTransport: {
+        S1ap_UplinkNASTransport_t pdu;
+        memset (&pdu, 0, sizeof (pdu));
+        if (s1ap_encode_s1ap_uplinknastransporties (&pdu, &message->msg.s1ap_UplinkNASTransportIEs) < 0) return RETURNerror;
+        return (s1ap_generate_initiating_message (buffer, length, message->procedureCode, message->criticality, &asn_DEF_S1ap_UplinkNASTransport, &pdu) < 0) ? RETURNerror : RETURNok;
+      }
+    case S1ap_ProcedureCode_id_initialUEMessage: {
+        S1ap_InitialUEMessage_t pdu;
+        memset (&pdu, 0, sizeof (pdu));
+        if (s1ap_encode_s1ap_initialuemessageies (&pdu, &message->msg.s1ap_InitialUEMessageIEs) < 0) return RETURNerror;
+        return (s1ap_generate_initiating_message (buffer, length, message->procedureCode, message->criticality, &asn_DEF_S1ap_InitialUEMessage, &pdu) < 0) ? RETURNerror : RETURNok;
+      }
+    case S1ap_ProcedureCode_id_UEContextReleaseRequest: {
+        S1ap_UEContextReleaseRequest_t pdu;
+        memset (&pdu, 0, sizeof (pdu));
+        if (s1ap_encode_s1ap_uecontextreleaserequesties (&pdu, &message->msg.s1ap_UEContextReleaseRequestIEs) < 0) return RETURNerror;
+        return (s1ap_generate_initiating_message (buffer, length, message->procedureCode, message->criticality, &asn_DEF_S1ap_UEContextReleaseRequest, &pdu) < 0) ? RETURNerror : RETURNok;
+      }
+    default:
+      return RETURNerror;
+  }
+}
+
+//------------------------------------------------------------------------------
+START_TEST(s1ap_fast_codec_roundtrip)
+{
+  for (int v = 0; v < TEST_NUM_VECTORS; v++) {
+    s1ap_message message = {0};
+    uint8_t      buffer[256];
+    uint32_t     length = 0;
+
+    ck_assert_msg (s1ap_fast_codec_decode_pdu (&message, test_vectors[v].buffer, test_vectors[v].length) == RETURNok, "vector %d", v);
+    ck_assert (s1ap_fast_codec_is_handled_procedure (message.procedureCode));
+    ck_assert_uint_eq (s1ap_fast_codec_encoded_length (&message), test_vectors[v].length);
+    ck_assert (s1ap_fast_codec_encode_pdu (&message, buffer, sizeof (buffer), &length) == RETURNok);
+    ck_assert_uint_eq (length, test_vectors[v].length);
+    ck_assert_msg (memcmp (buffer, test_vectors[v].buffer, length) == 0, "vector %d", v);
+    // no partial write in a too small buffer
+    ck_assert (s1ap_fast_codec_encode_pdu (&message, buffer, test_vectors[v].length - 1, &length) == RETURNerror);
+    test_free_message (&message);
+  }
+}
+END_TEST
+
+//------------------------------------------------------------------------------
+START_TEST(s1ap_fast_codec_decoded_values)
+{
+  s1ap_message message = {0};
+
+  ck_assert (s1ap_fast_codec_decode_pdu (&message, test_ul_nas_transport, sizeof (test_ul_nas_transport)) == RETURNok);
+  ck_assert_int_eq (message.direction, S1AP_PDU_PR_initiatingMessage);
+  ck_assert_int_eq (message.procedureCode, S1ap_ProcedureCode_id_uplinkNASTransport);
+  ck_assert_int_eq (message.criticality, S1ap_Criticality_ignore);
+  S1ap_UplinkNASTransportIEs_t *ul = &message.msg.s1ap_UplinkNASTransportIEs;
+  ck_assert_uint_eq (ul->mme_ue_s1ap_id, 0x0110CECC);
+  ck_assert_uint_eq (ul->eNB_UE_S1AP_ID, 0x01B3);
+  ck_assert_int_eq (ul->nas_pdu.size, 19);
+  ck_assert (memcmp (ul->nas_pdu.buf, &test_ul_nas_transport[28], 19) == 0);
+  ck_assert_int_eq (ul->eutran_cgi.pLMNidentity.size, 3);
+  ck_assert_int_eq (ul->eutran_cgi.cell_ID.size, 4);
+  ck_assert_int_eq (ul->eutran_cgi.cell_ID.bits_unused, 4);
+  ck_assert_uint_eq (ul->eutran_cgi.cell_ID.buf[2], 0x20);
+  ck_assert_int_eq (ul->tai.tAC.size, 2);
+  ck_assert_uint_eq (ul->tai.tAC.buf[1], 0x04);
+  ck_assert_uint_eq (ul->presenceMask, 0);
+  test_free_message (&message);
+
+  ck_assert (s1ap_fast_codec_decode_pdu (&message, test_initial_ue_message, sizeof (test_initial_ue_message)) == RETURNok);
+  S1ap_InitialUEMessageIEs_t *iue = &message.msg.s1ap_InitialUEMessageIEs;
+  ck_assert_uint_eq (iue->eNB_UE_S1AP_ID, 1);
+  ck_assert_int_eq (iue->nas_pdu.size, 32);
+  ck_assert_int_eq (iue->rrC_Establishment_Cause, S1ap_RRC_Establishment_Cause_mo_Signalling);
+  ck_assert_uint_eq (iue->presenceMask, S1AP_INITIALUEMESSAGEIES_S_TMSI_PRESENT | S1AP_INITIALUEMESSAGEIES_GUMMEI_ID_PRESENT);
+  ck_assert_int_eq (iue->s_tmsi.mMEC.size, 1);
+  ck_assert_uint_eq (iue->s_tmsi.mMEC.buf[0], 0x01);
+  ck_assert_int_eq (iue->s_tmsi.m_TMSI.size, 4);
+  ck_assert_uint_eq (iue->s_tmsi.m_TMSI.buf[0], 0xC0);
+  ck_assert_uint_eq (iue->s_tmsi.m_TMSI.buf[3], 0x23);
+  ck_assert_uint_eq (iue->gummei_id.mME_Group_ID.buf[1], 0x04);
+  ck_assert_uint_eq (iue->gummei_id.mME_Code.buf[0], 0x01);
+  test_free_message (&message);
+
+  ck_assert (s1ap_fast_codec_decode_pdu (&message, test_ue_context_release_request, sizeof (test_ue_context_release_request)) == RETURNok);
+  S1ap_UEContextReleaseRequestIEs_t *rel = &message.msg.s1ap_UEContextReleaseRequestIEs;
+  ck_assert_uint_eq (rel->mme_ue_s1ap_id, 5);
+  ck_assert_uint_eq (rel->eNB_UE_S1AP_ID, 0x01B3);
+  ck_assert_int_eq (rel->cause.present, S1ap_Cause_PR_radioNetwork);
+  ck_assert_int_eq (rel->cause.choice.radioNetwork, S1ap_CauseRadioNetwork_user_inactivity);
+  test_free_message (&message);
+}
+END_TEST
+
+//------------------------------------------------------------------------------
+START_TEST(s1ap_fast_codec_vs_generic_codec)
+{
+  for (int v = 0; v < TEST_NUM_VECTORS; v++) {
+    s1ap_message message = {0};
+    uint8_t      buffer[256];
+    uint8_t     *generic_buffer = NULL;
+    uint32_t     length = 0;
+
+    // generic decoder -> fast encoder
+    ck_assert_msg (test_generic_decode (&message, test_vectors[v].buffer, test_vectors[v].length) == RETURNok, "vector %d", v);
+    ck_assert (s1ap_fast_codec_encode_pdu (&message, buffer, sizeof (buffer), &length) == RETURNok);
+    ck_assert_uint_eq (length, test_vectors[v].length);
+    ck_assert_msg (memcmp (buffer, test_vectors[v].buffer, length) == 0, "vector %d", v);
+    test_free_message (&message);
+
+    // fast decoder -> generic encoder
+    ck_assert (s1ap_fast_codec_decode_pdu (&message, test_vectors[v].buffer, test_vectors[v].length) == RETURNok);
+    ck_assert_msg (test_generic_encode (&message, &generic_buffer, &length) == RETURNok, "vector %d", v);
+    ck_assert_uint_eq (length, test_vectors[v].length);
+    ck_assert_msg (memcmp (generic_buffer, test_vectors[v].buffer, length) == 0, "vector %d", v);
+    free (generic_buffer);
+    test_free_message (&message);
+  }
+}
+END_TEST
+
+//------------------------------------------------------------------------------
+START_TEST(s1ap_fast_codec_msgr10_corpus)
+{
+  for (int p = 0; p < TEST_MSGR10_NUM_PDUS; p++) {
+    const test_msgr10_pdu_t *pdu = &test_msgr10_pdus[p];
+    s1ap_message             message;
+    s1ap_message             decoded = {0};
+    uint8_t                  buffer[256];
+    uint8_t                 *generic_buffer = NULL;
+    uint32_t                 generic_length = 0;
+    uint32_t                 length = 0;
+
+    // reference encoding by asn1c
+    test_msgr10_build (&message, pdu);
+    ck_assert_msg (test_generic_encode (&message, &generic_buffer, &generic_length) == RETURNok, "%s", pdu->file);
+
+    // fast decoder on the asn1c encoding
+    ck_assert_msg (s1ap_fast_codec_decode_pdu (&decoded, generic_buffer, generic_length) == RETURNok, "%s", pdu->file);
+    test_msgr10_check (&decoded, pdu);
+
+    // fast encoder, from the decoded and from the original IEs, gives the asn1c encoding
+    ck_assert_uint_eq (s1ap_fast_codec_encoded_length (&decoded), generic_length);
+    ck_assert (s1ap_fast_codec_encode_pdu (&decoded, buffer, sizeof (buffer), &length) == RETURNok);
+    ck_assert_uint_eq (length, generic_length);
+    ck_assert_msg (memcmp (buffer, generic_buffer, length) == 0, "%s", pdu->file);
+    ck_assert (s1ap_fast_codec_encode_pdu (&message, buffer, sizeof (buffer), &length) == RETURNok);
+    ck_assert_uint_eq (length, generic_length);
+    ck_assert_msg (memcmp (buffer, generic_buffer, length) == 0, "%s", pdu->file);
+
+    free (generic_buffer);
+    test_free_message (&decoded);
+  }
+}
+END_TEST
+
+//------------------------------------------------------------------------------
+START_TEST(s1ap_fast_codec_fallback)
+{
+  s1ap_message message;
+  s1ap_message untouched;
+  uint8_t      pdu[sizeof (test_ul_nas_transport)];
+
+  memset (&message, 0xA5, sizeof (message));
+  memset (&untouched, 0xA5, sizeof (untouched));
+
+  // unknown IE (TAI id replaced)
+  memcpy (pdu, test_ul_nas_transport, sizeof (pdu));
+  pdu[60] = 0xFF;
+  ck_assert (s1ap_fast_codec_decode_pdu (&message, pdu, sizeof (pdu)) == RETURNerror);
+  ck_assert (memcmp (&message, &untouched, sizeof (message)) == 0);
+
+  // iE-Extensions present in EUTRAN-CGI
+  memcpy (pdu, test_ul_nas_transport, sizeof (pdu));
+  pdu[51] = 0x40;
+  ck_assert (s1ap_fast_codec_decode_pdu (&message, pdu, sizeof (pdu)) == RETURNerror);
+  ck_assert (memcmp (&message, &untouched, sizeof (message)) == 0);
+
+  // truncated PDU
+  for (uint32_t length = 0; length < sizeof (test_ul_nas_transport); length++) {
+    ck_assert (s1ap_fast_codec_decode_pdu (&message, test_ul_nas_transport, length) == RETURNerror);
+  }
+  ck_assert (memcmp (&message, &untouched, sizeof (message)) == 0);
+
+  // empty MME-UE-S1AP-ID IE ending the PDU, in a buffer of the exact size
+  static const uint8_t empty_ue_id[] = {0x00, 0x0B, 0x40, 0x07, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00};
+  uint8_t *            exact = malloc (sizeof (empty_ue_id));
+  memcpy (exact, empty_ue_id, sizeof (empty_ue_id));
+  ck_assert (s1ap_fast_codec_decode_pdu (&message, exact, sizeof (empty_ue_id)) == RETURNerror);
+  ck_assert (memcmp (&message, &untouched, sizeof (message)) == 0);
+  free (exact);
+
+  // not handled procedure (successful outcome of the same procedure code)
+  memcpy (pdu, test_ul_nas_transport, sizeof (pdu));
+  pdu[0] = 0x20;
+  ck_assert (s1ap_fast_codec_decode_pdu (&message, pdu, sizeof (pdu)) == RETURNerror);
+  ck_assert (memcmp (&message, &untouched, sizeof (message)) == 0);
+
+  // optional IE not handled by the fast encoder
+  memset (&message, 0, sizeof (message));
+  ck_assert (s1ap_fast_codec_decode_pdu (&message, test_dl_nas_transport, sizeof (test_dl_nas_transport)) == RETURNok);
+  message.msg.s1ap_DownlinkNASTransportIEs.presenceMask |= S1AP_DOWNLINKNASTRANSPORTIES_HANDOVERRESTRICTIONLIST_PRESENT;
+  ck_assert_uint_eq (s1ap_fast_codec_encoded_length (&message), 0);
+  message.msg.s1ap_DownlinkNASTransportIEs.presenceMask = 0;
+  test_free_message (&message);
+}
+END_TEST
+
+Suite * s1ap_fast_codec_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("S1AP fast codec tests");
+
+    tc_core = tcase_create("S1AP fast codec test");
+    tcase_add_test(tc_core, s1ap_fast_codec_roundtrip);
+    tcase_add_test(tc_core, s1ap_fast_codec_decoded_values);
+    tcase_add_test(tc_core, s1ap_fast_codec_vs_generic_codec);
+    tcase_add_test(tc_core, s1ap_fast_codec_msgr10_corpus);
+    tcase_add_test(tc_core, s1ap_fast_codec_fallback);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = s1ap_fast_codec_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -29,6 +29,8 @@
 #ifndef FILE_HASH_TABLE_SEEN
 #define FILE_HASH_TABLE_SEEN
 
+#include "concurrent_hashtable.h"
+
 typedef size_t   hash_size_t;
 typedef uint64_t hash_key_t;
 
@@ -74,11 +76,7 @@ typedef struct hash_table_s {
 } hash_table_t;
 
 typedef struct hash_table_ts_s {
-    pthread_mutex_t     mutex;
-    hash_size_t         size;
-    hash_size_t         num_elements;
-    struct hash_node_s **nodes;
-    pthread_mutex_t     *lock_nodes;
+    concurrent_hashtable_t map;
     hash_size_t       (*hashfunc)(const hash_key_t);
     void              (*freefunc)(void**);
     bstring             name;
@@ -97,11 +95,7 @@ typedef struct hash_table_uint64_s {
 } hash_table_uint64_t;
 
 typedef struct hash_table_uint64_ts_s {
-    pthread_mutex_t     mutex;
-    hash_size_t         size;
-    hash_size_t         num_elements;
-    struct hash_node_uint64_s **nodes;
-    pthread_mutex_t     *lock_nodes;
+    concurrent_hashtable_t map;
     hash_size_t       (*hashfunc)(const hash_key_t);
     bstring             name;
     bool                is_allocated_by_malloc;
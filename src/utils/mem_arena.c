@@ -0,0 +1,179 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mem_arena.c
+  \brief
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "mem_arena.h"
+
+#define MEM_ARENA_ALIGN              16
+#define MEM_ARENA_ROUND_UP(s)        (((s) + (MEM_ARENA_ALIGN - 1)) & ~((size_t)MEM_ARENA_ALIGN - 1))
+#define MEM_ARENA_DEDICATED_MIN      (MEM_ARENA_CHUNK_SIZE / 4)
+
+typedef struct mem_arena_chunk_s {
+  struct mem_arena_chunk_s *next;
+  size_t                    size;   // usable bytes in data
+  size_t                    used;
+  uint8_t                   data[] __attribute__ ((aligned (MEM_ARENA_ALIGN)));
+} mem_arena_chunk_t;
+
+struct mem_arena_s {
+  mem_arena_chunk_t        *current; // chunk being bumped, head of the chunk list
+};
+
+// free standard chunks of this thread
+static __thread mem_arena_chunk_t      *mem_arena_chunk_cache = NULL;
+static __thread unsigned int            mem_arena_chunk_cache_size = 0;
+
+//------------------------------------------------------------------------------
+static mem_arena_chunk_t *mem_arena_chunk_get (const size_t size)
+{
+  mem_arena_chunk_t *chunk = NULL;
+
+  if ((MEM_ARENA_CHUNK_SIZE == size) && (mem_arena_chunk_cache)) {
+    chunk = mem_arena_chunk_cache;
+    mem_arena_chunk_cache = chunk->next;
+    mem_arena_chunk_cache_size--;
+  } else {
+    chunk = malloc (sizeof (mem_arena_chunk_t) + size);
+    if (!chunk) {
+      return NULL;
+    }
+    chunk->size = size;
+  }
+  chunk->next = NULL;
+  chunk->used = 0;
+  return chunk;
+}
+
+//------------------------------------------------------------------------------
+static void mem_arena_chunk_put (mem_arena_chunk_t * chunk)
+{
+  if ((MEM_ARENA_CHUNK_SIZE == chunk->size) && (MEM_ARENA_CACHED_CHUNKS_MAX > mem_arena_chunk_cache_size)) {
+    chunk->next = mem_arena_chunk_cache;
+    mem_arena_chunk_cache = chunk;
+    mem_arena_chunk_cache_size++;
+  } else {
+    free_wrapper ((void**)&chunk);
+  }
+}
+
+//------------------------------------------------------------------------------
+mem_arena_t *mem_arena_create (void)
+{
+  mem_arena_chunk_t *chunk = mem_arena_chunk_get (MEM_ARENA_CHUNK_SIZE);
+
+  if (!chunk) {
+    return NULL;
+  }
+  // the arena lives at the bottom of its first chunk
+  mem_arena_t *arena = (mem_arena_t*)chunk->data;
+  chunk->used = MEM_ARENA_ROUND_UP (sizeof (mem_arena_t));
+  arena->current = chunk;
+  return arena;
+}
+
+//------------------------------------------------------------------------------
+void *mem_arena_alloc (mem_arena_t * const arena, const size_t size)
+{
+  const size_t       rounded_size = MEM_ARENA_ROUND_UP (size ? size : 1);
+  mem_arena_chunk_t *chunk = arena->current;
+  void              *ptr = NULL;
+
+  if ((chunk->size - chunk->used) < rounded_size) {
+    if (MEM_ARENA_DEDICATED_MIN <= rounded_size) {
+      // keep bumping the current chunk, insert the dedicated one behind it
+      mem_arena_chunk_t *dedicated = mem_arena_chunk_get (rounded_size);
+      if (!dedicated) {
+        return NULL;
+      }
+      dedicated->used = rounded_size;
+      dedicated->next = chunk->next;
+      chunk->next = dedicated;
+      memset (dedicated->data, 0, size);
+      return dedicated->data;
+    }
+    mem_arena_chunk_t *fresh = mem_arena_chunk_get (MEM_ARENA_CHUNK_SIZE);
+    if (!fresh) {
+      return NULL;
+    }
+    fresh->next = chunk;
+    arena->current = fresh;
+    chunk = fresh;
+  }
+  ptr = &chunk->data[chunk->used];
+  chunk->used += rounded_size;
+  // recycled chunks are dirty
+  memset (ptr, 0, size);
+  return ptr;
+}
+
+//------------------------------------------------------------------------------
+bstring mem_arena_blk2bstr (mem_arena_t * const arena, const void * const blk, const int len)
+{
+  if ((!blk) || (0 > len)) {
+    return NULL;
+  }
+  bstring b = mem_arena_alloc (arena, sizeof (struct tagbstring) + len + 1);
+  if (b) {
+    b->data = (unsigned char *)(b + 1);
+    b->slen = len;
+    b->mlen = len + 1;
+    if (len) {
+      memcpy (b->data, blk, len);
+    }
+    b->data[len] = '\0';
+    bwriteprotect (*b);
+  }
+  return b;
+}
+
+//------------------------------------------------------------------------------
+bstring mem_arena_bstrcpy (mem_arena_t * const arena, const_bstring b)
+{
+  if ((!b) || (0 > b->slen) || (!b->data)) {
+    return NULL;
+  }
+  return mem_arena_blk2bstr (arena, b->data, b->slen);
+}
+
+//------------------------------------------------------------------------------
+void mem_arena_destroy (mem_arena_t ** const arena)
+{
+  if ((arena) && (*arena)) {
+    // the arena itself is freed with its first chunk, the last of the list
+    mem_arena_chunk_t *chunk = (*arena)->current;
+    *arena = NULL;
+    while (chunk) {
+      mem_arena_chunk_t *next = chunk->next;
+      mem_arena_chunk_put (chunk);
+      chunk = next;
+    }
+  }
+}
@@ -0,0 +1,60 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file mem_arena.h
+  \brief Bump allocator owning all the memory scoped to one object (ex: a NAS
+         procedure), everything is released at once when the arena is destroyed.
+         Chunks are recycled through a per-thread cache so that creating and
+         destroying an arena does not usually reach malloc.
+*/
+
+#ifndef FILE_MEM_ARENA_SEEN
+#define FILE_MEM_ARENA_SEEN
+
+#include <stddef.h>
+
+#include "bstrlib.h"
+
+/* Size of a standard chunk, requests larger than a quarter of it get a dedicated chunk. */
+#define MEM_ARENA_CHUNK_SIZE           4096
+/* Max number of free standard chunks kept by each thread. */
+#define MEM_ARENA_CACHED_CHUNKS_MAX    1024
+
+typedef struct mem_arena_s mem_arena_t;
+
+/* Create an empty arena, return NULL if out of memory. */
+mem_arena_t *mem_arena_create (void);
+
+/* Return size zeroed bytes aligned for any type, owned by the arena, NULL if out of memory. */
+void *mem_arena_alloc (mem_arena_t * const arena, const size_t size);
+
+/* Return a copy of blk as a bstring owned by the arena. The bstring is write
+ * protected: bstrlib refuses to modify it and bdestroy() does not free it, so
+ * it can be handed to code that would bdestroy_wrapper() a heap bstring. */
+bstring mem_arena_blk2bstr (mem_arena_t * const arena, const void * const blk, const int len);
+
+/* Same as mem_arena_blk2bstr() for the content of b, NULL if b is NULL. */
+bstring mem_arena_bstrcpy (mem_arena_t * const arena, const_bstring b);
+
+/* Release every allocation of the arena and the arena itself, *arena is set to NULL. */
+void mem_arena_destroy (mem_arena_t ** const arena);
+
+#endif /* FILE_MEM_ARENA_SEEN */
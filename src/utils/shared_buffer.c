@@ -0,0 +1,69 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file shared_buffer.c
+  \brief
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "assertions.h"
+#include "dynamic_memory_check.h"
+#include "shared_buffer.h"
+
+//------------------------------------------------------------------------------
+shared_buffer_t *shared_buffer_create (const uint8_t * const data, const uint32_t length)
+{
+  shared_buffer_t *buffer = malloc (sizeof (shared_buffer_t) + length);
+
+  if (buffer) {
+    buffer->refcount = 1;
+    buffer->length   = length;
+    if ((data) && (length)) {
+      memcpy (buffer->data, data, length);
+    }
+  }
+  return buffer;
+}
+
+//------------------------------------------------------------------------------
+shared_buffer_t *shared_buffer_ref (shared_buffer_t * const buffer)
+{
+  if (buffer) {
+    __atomic_add_fetch (&buffer->refcount, 1, __ATOMIC_RELAXED);
+  }
+  return buffer;
+}
+
+//------------------------------------------------------------------------------
+void shared_buffer_unref (shared_buffer_t ** const buffer)
+{
+  if ((buffer) && (*buffer)) {
+    uint32_t refcount = __atomic_sub_fetch (&(*buffer)->refcount, 1, __ATOMIC_ACQ_REL);
+    AssertFatal (0xFFFFFFFF != refcount, "Shared buffer reference count underflow");
+    if (0 == refcount) {
+      free_wrapper ((void**)buffer);
+    }
+    *buffer = NULL;
+  }
+}
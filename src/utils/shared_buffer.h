@@ -0,0 +1,47 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file shared_buffer.h
+  \brief Immutable reference counted byte buffer, allows an encoded PDU to be
+         sent to several peers without copying it once per peer.
+*/
+
+#ifndef FILE_SHARED_BUFFER_SEEN
+#define FILE_SHARED_BUFFER_SEEN
+
+#include <stdint.h>
+
+typedef struct shared_buffer_s {
+  volatile uint32_t  refcount;
+  uint32_t           length;
+  uint8_t            data[];
+} shared_buffer_t;
+
+/* Allocate a buffer holding a copy of data, the caller owns the only reference. */
+shared_buffer_t *shared_buffer_create (const uint8_t * const data, const uint32_t length);
+
+/* Take an additional reference, return buffer. */
+shared_buffer_t *shared_buffer_ref (shared_buffer_t * const buffer);
+
+/* Release a reference, the buffer is freed with its last reference, *buffer is set to NULL. */
+void shared_buffer_unref (shared_buffer_t ** const buffer);
+
+#endif /* FILE_SHARED_BUFFER_SEEN */